@@ -0,0 +1,404 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.cpp
+// ============
+// sample the keyframed clips of the animated entities in parallel and
+// write the results into their transforms
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AnimationSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	/***********************************************************
+	 *  KeyframeSlope()
+	 *
+	 *  This function is used for getting the slope of a spline
+	 *  track at one of its keyframes, from the keyframes on
+	 *  either side.  The slope is flat at the first and last
+	 *  keyframes and wherever a value turns back, so a held or
+	 *  reversed value eases in and out, and it is limited so
+	 *  the curve never overshoots the keyframes around it.
+	 ***********************************************************/
+	glm::vec3 KeyframeSlope(const AnimationSystem::KEYFRAME* pKeyframes, int keyframeCount, int index)
+	{
+		glm::vec3 slope(0.0f);
+		if ((index <= 0) || (index >= keyframeCount - 1))
+		{
+			return slope;
+		}
+
+		const AnimationSystem::KEYFRAME& previous = pKeyframes[index - 1];
+		const AnimationSystem::KEYFRAME& current = pKeyframes[index];
+		const AnimationSystem::KEYFRAME& next = pKeyframes[index + 1];
+		glm::vec3 slopeBefore = (current.value - previous.value) / std::max(current.time - previous.time, 1e-6f);
+		glm::vec3 slopeAfter = (next.value - current.value) / std::max(next.time - current.time, 1e-6f);
+		glm::vec3 slopeAcross = (next.value - previous.value) / std::max(next.time - previous.time, 1e-6f);
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (slopeBefore[i] * slopeAfter[i] > 0.0f)
+			{
+				float limit = 3.0f * std::min(fabsf(slopeBefore[i]), fabsf(slopeAfter[i]));
+				slope[i] = glm::clamp(slopeAcross[i], -limit, limit);
+			}
+		}
+
+		return slope;
+	}
+}
+
+/***********************************************************
+ *  AnimationSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AnimationSystem::AnimationSystem()
+{
+	m_pRegistry = NULL;
+	m_time = 0.0;
+	m_bClipsAdvanced = false;
+	m_pWorkerPool = NULL;
+	m_threadCount = 0;
+	m_activeThreads = 1;
+}
+
+/***********************************************************
+ *  ~AnimationSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AnimationSystem::~AnimationSystem()
+{
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for removing the tracks and clips.
+ *  The entities playing them must have their animation
+ *  components removed as well.
+ ***********************************************************/
+void AnimationSystem::Reset()
+{
+	m_keyframes.clear();
+	m_tracks.clear();
+	m_clips.clear();
+}
+
+/***********************************************************
+ *  AddTrack()
+ *
+ *  This method is used for adding a track of keyframes,
+ *  which are copied after the keyframes of the other
+ *  tracks.
+ ***********************************************************/
+int AnimationSystem::AddTrack(INTERPOLATION interpolation, const KEYFRAME* pKeyframes, int keyframeCount)
+{
+	if ((NULL == pKeyframes) || (keyframeCount <= 0))
+	{
+		return -1;
+	}
+
+	ANIMATION_TRACK track;
+	track.firstKeyframe = (int)m_keyframes.size();
+	track.keyframeCount = keyframeCount;
+	track.interpolation = interpolation;
+	m_keyframes.insert(m_keyframes.end(), pKeyframes, pKeyframes + keyframeCount);
+	m_tracks.push_back(track);
+
+	return (int)m_tracks.size() - 1;
+}
+
+/***********************************************************
+ *  AddClip()
+ *
+ *  This method is used for adding a clip that plays up to
+ *  three tracks together.  The clip lasts until the last
+ *  keyframe of its longest track.
+ ***********************************************************/
+int AnimationSystem::AddClip(PLAYBACK playback, int translationTrack, int rotationTrack, int scaleTrack)
+{
+	ANIMATION_CLIP clip;
+	clip.tracks[CHANNEL_TRANSLATION] = translationTrack;
+	clip.tracks[CHANNEL_ROTATION] = rotationTrack;
+	clip.tracks[CHANNEL_SCALE] = scaleTrack;
+	clip.duration = 0.0f;
+	clip.playback = playback;
+	for (int i = 0; i < CHANNEL_COUNT; i++)
+	{
+		if ((clip.tracks[i] < 0) || (clip.tracks[i] >= (int)m_tracks.size()))
+		{
+			clip.tracks[i] = -1;
+			continue;
+		}
+		const ANIMATION_TRACK& track = m_tracks[clip.tracks[i]];
+		clip.duration = std::max(clip.duration, m_keyframes[track.firstKeyframe + track.keyframeCount - 1].time);
+	}
+	m_clips.push_back(clip);
+
+	return (int)m_clips.size() - 1;
+}
+
+/***********************************************************
+ *  SetWorkerPool()
+ *
+ *  This method is used for setting the pool that the
+ *  updates are split over.  The pool is shared with the
+ *  renderers, and only runs one job at a time, all from the
+ *  render thread.
+ ***********************************************************/
+void AnimationSystem::SetWorkerPool(WorkerPool* pWorkerPool)
+{
+	m_pWorkerPool = pWorkerPool;
+}
+
+/***********************************************************
+ *  SetThreadCount()
+ *
+ *  This method is used for limiting the threads of the pool
+ *  that the updates are split over.  The threads past the
+ *  limit wait out the update.
+ ***********************************************************/
+void AnimationSystem::SetThreadCount(int threadCount)
+{
+	m_threadCount = std::max(threadCount, 0);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the most threads that an
+ *  update is split over.
+ ***********************************************************/
+int AnimationSystem::GetThreadCount() const
+{
+	int threadCount = (NULL != m_pWorkerPool) ? m_pWorkerPool->GetThreadCount() : 1;
+	if (m_threadCount > 0)
+	{
+		threadCount = std::min(threadCount, m_threadCount);
+	}
+	return threadCount;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for playing the clips of every
+ *  animated entity at a time.  The animation components
+ *  are split into contiguous ranges of at least
+ *  MIN_ENTITIES_PER_THREAD, one for each thread, and the
+ *  calling thread runs the first range and waits for the
+ *  others, so the components are final when it returns.  A
+ *  clip that has stopped, such as one played once that is
+ *  past its last keyframe, samples the same clip time each
+ *  update, so once every clip has stopped the update tells
+ *  the caller that nothing moved.
+ ***********************************************************/
+bool AnimationSystem::Update(EntityRegistry& registry, double time)
+{
+	int animationCount = registry.GetAnimations().GetCount();
+	if (animationCount <= 0)
+	{
+		return false;
+	}
+
+	m_pRegistry = &registry;
+	m_time = time;
+	m_bClipsAdvanced = false;
+	m_activeThreads = glm::clamp(animationCount / MIN_ENTITIES_PER_THREAD, 1, GetThreadCount());
+	if (m_activeThreads <= 1)
+	{
+		UpdateRange(0, animationCount);
+		return m_bClipsAdvanced;
+	}
+
+	m_pWorkerPool->Run(this, JOB_UPDATE);
+
+	return m_bClipsAdvanced;
+}
+
+/***********************************************************
+ *  GetClipTime()
+ *
+ *  This method is used for mapping a time since a clip was
+ *  started to a time between its first and last keyframes,
+ *  by the playback of the clip.
+ ***********************************************************/
+float AnimationSystem::GetClipTime(const ANIMATION_CLIP& clip, double time) const
+{
+	if (clip.duration <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	double duration = clip.duration;
+	double clipTime = time;
+	switch (clip.playback)
+	{
+	case PLAYBACK_LOOP:
+		clipTime = fmod(time, duration);
+		if (clipTime < 0.0)
+		{
+			clipTime += duration;
+		}
+		break;
+	case PLAYBACK_PING_PONG:
+		clipTime = fmod(time, 2.0 * duration);
+		if (clipTime < 0.0)
+		{
+			clipTime += 2.0 * duration;
+		}
+		if (clipTime > duration)
+		{
+			clipTime = 2.0 * duration - clipTime;
+		}
+		break;
+	default:
+		clipTime = std::min(std::max(time, 0.0), duration);
+		break;
+	}
+
+	return (float)clipTime;
+}
+
+/***********************************************************
+ *  SampleTrack()
+ *
+ *  This method is used for getting the value of a track at
+ *  a time, from the two keyframes around the time, which
+ *  are found with a binary search.  A spline segment is a
+ *  cubic Hermite curve between the keyframes, with the
+ *  slopes of KeyframeSlope() at each end.
+ ***********************************************************/
+glm::vec3 AnimationSystem::SampleTrack(const ANIMATION_TRACK& track, float time) const
+{
+	const KEYFRAME* pKeyframes = m_keyframes.data() + track.firstKeyframe;
+	int keyframeCount = track.keyframeCount;
+	if ((keyframeCount == 1) || (time <= pKeyframes[0].time))
+	{
+		return pKeyframes[0].value;
+	}
+	if (time >= pKeyframes[keyframeCount - 1].time)
+	{
+		return pKeyframes[keyframeCount - 1].value;
+	}
+
+	// the first keyframe after the time, which is never the first
+	const KEYFRAME* pNext = std::upper_bound(pKeyframes, pKeyframes + keyframeCount, time,
+		[](float value, const KEYFRAME& keyframe) { return value < keyframe.time; });
+	int next = (int)(pNext - pKeyframes);
+	const KEYFRAME& start = pKeyframes[next - 1];
+	const KEYFRAME& end = pKeyframes[next];
+
+	float length = end.time - start.time;
+	float t = (length > 0.0f) ? (time - start.time) / length : 1.0f;
+	switch (track.interpolation)
+	{
+	case INTERPOLATE_STEP:
+		return start.value;
+	case INTERPOLATE_LINEAR:
+		return glm::mix(start.value, end.value, t);
+	default:
+		break;
+	}
+
+	float t2 = t * t;
+	float t3 = t2 * t;
+	glm::vec3 startSlope = KeyframeSlope(pKeyframes, keyframeCount, next - 1);
+	glm::vec3 endSlope = KeyframeSlope(pKeyframes, keyframeCount, next);
+
+	return start.value * (2.0f * t3 - 3.0f * t2 + 1.0f) +
+		startSlope * (length * (t3 - 2.0f * t2 + t)) +
+		end.value * (3.0f * t2 - 2.0f * t3) +
+		endSlope * (length * (t3 - t2));
+}
+
+/***********************************************************
+ *  UpdateRange()
+ *
+ *  This method is used for sampling the clips of a range of
+ *  the packed animation components.  The channels without a
+ *  track keep their rest values, and the world transform
+ *  and the world bounds of a drawn entity are worked out
+ *  here as well, while the transform is still in the cache.
+ *  Each entity is written by one thread only, so the ranges
+ *  need no locking.
+ ***********************************************************/
+void AnimationSystem::UpdateRange(int firstAnimation, int lastAnimation)
+{
+	ComponentStore<ANIMATION_COMPONENT>& animations = m_pRegistry->GetAnimations();
+	ComponentStore<TRANSFORM_COMPONENT>& transforms = m_pRegistry->GetTransforms();
+	ComponentStore<RENDERABLE_COMPONENT>& renderables = m_pRegistry->GetRenderables();
+	const glm::vec3 restValues[CHANNEL_COUNT] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f) };
+	bool bAdvanced = false;
+
+	for (int i = firstAnimation; i < lastAnimation; i++)
+	{
+		ANIMATION_COMPONENT& animation = animations.GetAt(i);
+		ENTITY entity = animations.GetEntity(i);
+		int transformIndex = transforms.GetIndex(entity);
+		if ((transformIndex < 0) || (animation.clip < 0) || (animation.clip >= (int)m_clips.size()))
+		{
+			continue;
+		}
+
+		const ANIMATION_CLIP& clip = m_clips[animation.clip];
+		float clipTime = GetClipTime(clip, m_time * animation.speed + animation.timeOffset);
+		if (clipTime != animation.clipTime)
+		{
+			animation.clipTime = clipTime;
+			bAdvanced = true;
+		}
+		glm::vec3 values[CHANNEL_COUNT];
+		for (int channel = 0; channel < CHANNEL_COUNT; channel++)
+		{
+			values[channel] = (clip.tracks[channel] >= 0) ?
+				SampleTrack(m_tracks[clip.tracks[channel]], clipTime) :
+				restValues[channel];
+		}
+
+		TRANSFORM_COMPONENT& transform = transforms.GetAt(transformIndex);
+		transform.translation = values[CHANNEL_TRANSLATION];
+		transform.rotation = values[CHANNEL_ROTATION];
+		transform.scale = values[CHANNEL_SCALE];
+		transform.worldMatrix = EntityRegistry::CalculateWorldMatrix(transform);
+
+		int renderableIndex = renderables.GetIndex(entity);
+		if (renderableIndex >= 0)
+		{
+			RENDERABLE_COMPONENT& renderable = renderables.GetAt(renderableIndex);
+			EntityRegistry::TransformBounds(transform.worldMatrix, renderable.localBoundsMin, renderable.localBoundsMax,
+				renderable.boundsMin, renderable.boundsMax);
+		}
+	}
+
+	// the ranges run at the same time, so only the ones that moved
+	// a clip touch the shared flag
+	if (bAdvanced)
+	{
+		m_bClipsAdvanced = true;
+	}
+}
+
+/***********************************************************
+ *  ExecuteJob()
+ *
+ *  This method is used for running the range of an update
+ *  that belongs to a thread.  The threads past the number
+ *  used by the update have no range.
+ ***********************************************************/
+void AnimationSystem::ExecuteJob(int job, int workerIndex)
+{
+	if ((JOB_UPDATE != job) || (workerIndex >= m_activeThreads))
+	{
+		return;
+	}
+
+	long long animationCount = m_pRegistry->GetAnimations().GetCount();
+	int firstAnimation = (int)(animationCount * workerIndex / m_activeThreads);
+	int lastAnimation = (int)(animationCount * (workerIndex + 1) / m_activeThreads);
+	UpdateRange(firstAnimation, lastAnimation);
+}
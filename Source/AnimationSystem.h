@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.h
+// ============
+// sample the keyframed clips of the animated entities in parallel and
+// write the results into their transforms
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "EntityRegistry.h"
+#include "WorkerPool.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <vector>
+
+/***********************************************************
+ *  AnimationSystem
+ *
+ *  This class holds the animation clips of the scene and
+ *  plays them on the entities with an animation component.
+ *  A clip has up to one track each for the translation,
+ *  rotation and scale of a transform, and each track is a
+ *  run of keyframes in one array shared by all of the
+ *  tracks, sampled as steps, straight lines or a smooth
+ *  spline.  Each update splits the packed animation
+ *  components into one contiguous range per thread, and
+ *  every thread samples the clips of its range and writes
+ *  the values, the world transform and the world bounds
+ *  straight into the component stores, so the cost grows
+ *  with the number of animated entities and nothing else.
+ ***********************************************************/
+class AnimationSystem : private WorkerPool::Jobs
+{
+public:
+	// fewest animated entities given to each thread, below which
+	// waking the threads costs more than it saves
+	static const int MIN_ENTITIES_PER_THREAD = 1024;
+
+	// how the values between two keyframes are found
+	enum INTERPOLATION
+	{
+		// hold the value of the earlier keyframe
+		INTERPOLATE_STEP,
+		// move in a straight line between the keyframes
+		INTERPOLATE_LINEAR,
+		// follow a curve through the keyframes that does not
+		// overshoot them, and eases in and out of held values
+		INTERPOLATE_SPLINE
+	};
+
+	// how a clip continues past its last keyframe
+	enum PLAYBACK
+	{
+		// hold the last keyframe
+		PLAYBACK_ONCE,
+		// start again from the first keyframe
+		PLAYBACK_LOOP,
+		// play backwards to the first keyframe and forwards again
+		PLAYBACK_PING_PONG
+	};
+
+	// a value of a track at a time in seconds from the start of
+	// the clip
+	struct KEYFRAME
+	{
+		float time;
+		glm::vec3 value;
+	};
+
+	// constructor
+	AnimationSystem();
+	// destructor
+	~AnimationSystem();
+
+	// remove the tracks and clips
+	void Reset();
+	// add a track from keyframes in order of time - returns the
+	// track index, or -1 when there are no keyframes
+	int AddTrack(INTERPOLATION interpolation, const KEYFRAME* pKeyframes, int keyframeCount);
+	// add a clip from a translation, rotation in degrees and scale
+	// track, each -1 to leave the value at rest - returns the clip
+	// index
+	int AddClip(PLAYBACK playback, int translationTrack, int rotationTrack, int scaleTrack);
+	int GetClipCount() const { return (int)m_clips.size(); }
+
+	// set the pool that the updates are split over, which
+	// outlives the system, or NULL to update on the calling thread
+	void SetWorkerPool(WorkerPool* pWorkerPool);
+	// set the most threads of the pool that an update uses, or 0
+	// for all of them
+	void SetThreadCount(int threadCount);
+	int GetThreadCount() const;
+
+	// sample the clip of every animation component at a time in
+	// seconds, and write the values and world transforms into the
+	// transform components and the world bounds into the
+	// renderable components of the entities - returns true when
+	// any clip was sampled at a different time than the last update
+	bool Update(EntityRegistry& registry, double time);
+
+private:
+	// the job the worker pool runs
+	enum JOB
+	{
+		JOB_UPDATE = 1
+	};
+
+	// the values a clip can animate
+	enum CHANNEL
+	{
+		CHANNEL_TRANSLATION,
+		CHANNEL_ROTATION,
+		CHANNEL_SCALE,
+		CHANNEL_COUNT
+	};
+
+	// a run of keyframes in the shared keyframe array
+	struct ANIMATION_TRACK
+	{
+		int firstKeyframe;
+		int keyframeCount;
+		INTERPOLATION interpolation;
+	};
+
+	// the tracks of a clip and the time of its last keyframe
+	struct ANIMATION_CLIP
+	{
+		int tracks[CHANNEL_COUNT];
+		float duration;
+		PLAYBACK playback;
+	};
+
+	std::vector<KEYFRAME> m_keyframes;
+	std::vector<ANIMATION_TRACK> m_tracks;
+	std::vector<ANIMATION_CLIP> m_clips;
+
+	// the registry and time of the update being run, and whether
+	// any of its ranges moved a clip on
+	EntityRegistry* m_pRegistry;
+	double m_time;
+	std::atomic<bool> m_bClipsAdvanced;
+
+	// the pool the updates are split over, the most of its threads
+	// an update uses or 0 for all, and how many of them the update
+	// being run uses
+	WorkerPool* m_pWorkerPool;
+	int m_threadCount;
+	int m_activeThreads;
+
+	// get the time into a clip that a time since its start plays
+	float GetClipTime(const ANIMATION_CLIP& clip, double time) const;
+	// get the value of a track at a time into its clip
+	glm::vec3 SampleTrack(const ANIMATION_TRACK& track, float time) const;
+	// sample a range of the packed animation components
+	void UpdateRange(int firstAnimation, int lastAnimation);
+	// run a thread's range of the update
+	void ExecuteJob(int job, int workerIndex) override;
+};
@@ -0,0 +1,796 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// draw the opaque surfaces of the scene into a compact G-buffer and
+// light them afterwards with the lights binned into screen tiles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// texels of the light buffer taken by each light
+	const int LIGHT_TEXELS = 3;
+
+	// vertex shader shared by the geometry pass and the forward
+	// comparison, with the attributes of the scene meshes
+	const char* g_SurfaceVertexShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (location = 1) in vec3 inVertexNormal;\n"
+		"layout (location = 2) in vec2 inTextureCoordinate;\n"
+		"uniform mat4 model;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"out vec3 fragmentPosition;\n"
+		"out vec3 fragmentNormal;\n"
+		"out vec2 fragmentTextureCoordinate;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 worldPosition = model * vec4(inVertexPosition, 1.0f);\n"
+		"	fragmentPosition = worldPosition.xyz;\n"
+		"	fragmentNormal = mat3(transpose(inverse(model))) * inVertexNormal;\n"
+		"	fragmentTextureCoordinate = inTextureCoordinate;\n"
+		"	gl_Position = projection * view * worldPosition;\n"
+		"}\n";
+
+	// the values of a surface - textured surfaces are opaque and
+	// take their color from the texture, like in the scene shader
+	const char* g_SurfaceSource =
+		"in vec3 fragmentPosition;\n"
+		"in vec3 fragmentNormal;\n"
+		"in vec2 fragmentTextureCoordinate;\n"
+		"uniform vec4 objectColor;\n"
+		"uniform bool bUseTexture;\n"
+		"uniform sampler2D objectTexture;\n"
+		"uniform int materialIndex;\n"
+		"vec4 GetBaseColor()\n"
+		"{\n"
+		"	if (bUseTexture)\n"
+		"	{\n"
+		"		return vec4(texture(objectTexture, fragmentTextureCoordinate).rgb, 1.0f);\n"
+		"	}\n"
+		"	return objectColor;\n"
+		"}\n";
+
+	// the lighting of the scene shader for one light from the
+	// light buffer, faded out to its radius when it has one - the
+	// lights are summed and clamped once, so the paths match
+	const char* g_LightingSource =
+		"const int MAX_MATERIALS = 64;\n"
+		"uniform samplerBuffer lightTexels;\n"
+		"uniform vec3 ambientLight;\n"
+		"uniform vec3 materialAmbient[MAX_MATERIALS];\n"
+		"uniform vec3 materialDiffuse[MAX_MATERIALS];\n"
+		"uniform vec3 materialSpecular[MAX_MATERIALS];\n"
+		"vec3 AddLight(int light, vec3 position, vec3 normal, vec3 viewDirection, int material)\n"
+		"{\n"
+		"	vec4 sphere = texelFetch(lightTexels, light * 3);\n"
+		"	vec4 diffuseFocal = texelFetch(lightTexels, light * 3 + 1);\n"
+		"	vec3 specularColor = texelFetch(lightTexels, light * 3 + 2).rgb;\n"
+		"	vec3 toLight = sphere.xyz - position;\n"
+		"	float attenuation = 1.0f;\n"
+		"	if (sphere.w > 0.0f)\n"
+		"	{\n"
+		"		float distanceSquared = dot(toLight, toLight) / (sphere.w * sphere.w);\n"
+		"		if (distanceSquared >= 1.0f)\n"
+		"		{\n"
+		"			return vec3(0.0f);\n"
+		"		}\n"
+		"		attenuation = (1.0f - distanceSquared) * (1.0f - distanceSquared);\n"
+		"	}\n"
+		"	vec3 lightDirection = normalize(toLight);\n"
+		"	float impact = max(dot(normal, lightDirection), 0.0f);\n"
+		"	float highlight = pow(max(dot(viewDirection, reflect(-lightDirection, normal)), 0.0f), diffuseFocal.w);\n"
+		"	return attenuation * (impact * diffuseFocal.rgb * materialDiffuse[material] +\n"
+		"		highlight * specularColor * materialSpecular[material]);\n"
+		"}\n";
+
+	// normals packed onto the faces of an octahedron, which keeps
+	// them evenly precise in two channels - they are stored in an
+	// unsigned format, which every driver can draw into
+	const char* g_NormalPackingSource =
+		"vec2 SignNotZero(vec2 value)\n"
+		"{\n"
+		"	return vec2((value.x >= 0.0f) ? 1.0f : -1.0f, (value.y >= 0.0f) ? 1.0f : -1.0f);\n"
+		"}\n"
+		"vec2 EncodeNormal(vec3 normal)\n"
+		"{\n"
+		"	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);\n"
+		"	return (normal.z >= 0.0f) ? normal.xy : (1.0f - abs(normal.yx)) * SignNotZero(normal.xy);\n"
+		"}\n"
+		"vec3 DecodeNormal(vec2 encoded)\n"
+		"{\n"
+		"	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));\n"
+		"	if (normal.z < 0.0f)\n"
+		"	{\n"
+		"		normal.xy = (1.0f - abs(normal.yx)) * SignNotZero(normal.xy);\n"
+		"	}\n"
+		"	return normalize(normal);\n"
+		"}\n";
+
+	// fragment shader of the geometry pass, which keeps the base
+	// color, material index and normal of the nearest surface
+	const char* g_GeometryFragmentShader =
+		"layout (location = 0) out vec4 albedo;\n"
+		"layout (location = 1) out vec2 packedNormal;\n"
+		"void main()\n"
+		"{\n"
+		"	albedo = vec4(GetBaseColor().rgb, float(materialIndex) / 255.0f);\n"
+		"	packedNormal = EncodeNormal(normalize(fragmentNormal)) * 0.5f + 0.5f;\n"
+		"}\n";
+
+	// vertex shader of a triangle that covers the viewport
+	const char* g_FullScreenVertexShader =
+		"#version 330 core\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 corner = vec2((gl_VertexID == 1) ? 3.0f : -1.0f, (gl_VertexID == 2) ? 3.0f : -1.0f);\n"
+		"	gl_Position = vec4(corner, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader of the lighting pass, which rebuilds the
+	// position of each pixel from its depth and adds the lights
+	// listed for its tile - the depth is written as well, so the
+	// blended objects are tested against the opaque surfaces
+	const char* g_LightingFragmentShader =
+		"const int TILE_SIZE = 16;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"uniform sampler2D albedoTexture;\n"
+		"uniform sampler2D normalTexture;\n"
+		"uniform sampler2D depthTexture;\n"
+		"uniform isamplerBuffer tileTexels;\n"
+		"uniform mat4 inverseViewProjection;\n"
+		"uniform vec4 viewportRect;\n"
+		"uniform int tilesX;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+		"	float depth = texelFetch(depthTexture, pixel, 0).r;\n"
+		"	if (depth >= 1.0f)\n"
+		"	{\n"
+		"		discard;\n"
+		"	}\n"
+		"	vec4 albedo = texelFetch(albedoTexture, pixel, 0);\n"
+		"	vec3 normal = DecodeNormal(texelFetch(normalTexture, pixel, 0).rg * 2.0f - 1.0f);\n"
+		"	int material = int(albedo.a * 255.0f + 0.5f);\n"
+		"	vec2 viewportPosition = (gl_FragCoord.xy - viewportRect.xy) / viewportRect.zw;\n"
+		"	vec4 position = inverseViewProjection * vec4(viewportPosition * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);\n"
+		"	position /= position.w;\n"
+		"	vec3 viewDirection = normalize(viewPosition - position.xyz);\n"
+		"	ivec2 tile = ivec2(gl_FragCoord.xy - viewportRect.xy) / TILE_SIZE;\n"
+		"	int header = (tile.y * tilesX + tile.x) * 2;\n"
+		"	int first = texelFetch(tileTexels, header).r;\n"
+		"	int count = texelFetch(tileTexels, header + 1).r;\n"
+		"	vec3 lighting = ambientLight * materialAmbient[material];\n"
+		"	for (int i = 0; i < count; i++)\n"
+		"	{\n"
+		"		lighting += AddLight(texelFetch(tileTexels, first + i).r, position.xyz, normal, viewDirection, material);\n"
+		"	}\n"
+		"	fragmentColor = vec4(clamp(lighting * albedo.rgb, 0.0f, 1.0f), 1.0f);\n"
+		"	gl_FragDepth = depth;\n"
+		"}\n";
+
+	// fragment shader of the forward comparison, which adds every
+	// light in the buffer for every fragment that is shaded
+	const char* g_ForwardFragmentShader =
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"uniform int lightCount;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 base = GetBaseColor();\n"
+		"	vec3 normal = normalize(fragmentNormal);\n"
+		"	vec3 viewDirection = normalize(viewPosition - fragmentPosition);\n"
+		"	vec3 lighting = ambientLight * materialAmbient[materialIndex];\n"
+		"	for (int i = 0; i < lightCount; i++)\n"
+		"	{\n"
+		"		lighting += AddLight(i, fragmentPosition, normal, viewDirection, materialIndex);\n"
+		"	}\n"
+		"	fragmentColor = vec4(clamp(lighting * base.rgb, 0.0f, 1.0f), clamp(base.a, 0.0f, 1.0f));\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer()
+{
+	m_geometryProgramID = 0;
+	m_lightingProgramID = 0;
+	m_forwardProgramID = 0;
+	m_geometryLocations = SURFACE_LOCATIONS{ -1, -1, -1, -1, -1 };
+	m_forwardLocations = SURFACE_LOCATIONS{ -1, -1, -1, -1, -1 };
+	m_pSurfaceLocations = &m_geometryLocations;
+	m_albedoTextureID = 0;
+	m_normalTextureID = 0;
+	m_depthTextureID = 0;
+	m_framebufferID = 0;
+	m_width = 0;
+	m_height = 0;
+	m_targetFramebufferID = 0;
+	m_lightBufferID = 0;
+	m_lightTextureID = 0;
+	m_tileBufferID = 0;
+	m_tileTextureID = 0;
+	m_tileBufferSize = 0;
+	m_maxTextureBufferSize = 0;
+	m_emptyVertexArrayID = 0;
+	m_ambientLight = glm::vec3(0.0f);
+	m_materialCount = 1;
+	m_materialAmbient[0] = glm::vec3(0.0f);
+	m_materialDiffuse[0] = glm::vec3(0.0f);
+	m_materialSpecular[0] = glm::vec3(0.0f);
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DeleteTextures();
+	DeleteTrackedTexture(m_lightTextureID);
+	DeleteTrackedTexture(m_tileTextureID);
+	DeleteTrackedBuffer(m_lightBufferID);
+	DeleteTrackedBuffer(m_tileBufferID);
+	DeleteTrackedVertexArray(m_emptyVertexArrayID);
+	DeleteTrackedProgram(m_geometryProgramID);
+	DeleteTrackedProgram(m_lightingProgramID);
+	DeleteTrackedProgram(m_forwardProgramID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the geometry, lighting
+ *  and forward programs, and creating the texture buffers
+ *  that the lights and tile lists are read from.
+ ***********************************************************/
+bool DeferredRenderer::Initialize()
+{
+	std::string header = "#version 330 core\n";
+	std::string geometryShader = header + g_SurfaceSource + g_NormalPackingSource + g_GeometryFragmentShader;
+	std::string lightingShader = header + g_LightingSource + g_NormalPackingSource + g_LightingFragmentShader;
+	std::string forwardShader = header + g_SurfaceSource + g_LightingSource + g_ForwardFragmentShader;
+
+	m_geometryProgramID = ShaderCache::CompileProgram(g_SurfaceVertexShader, geometryShader.c_str());
+	m_forwardProgramID = ShaderCache::CompileProgram(g_SurfaceVertexShader, forwardShader.c_str());
+	GLuint lightingProgramID = ShaderCache::CompileProgram(g_FullScreenVertexShader, lightingShader.c_str());
+	if ((0 == m_geometryProgramID) || (0 == m_forwardProgramID) || (0 == lightingProgramID))
+	{
+		DeleteTrackedProgram(m_geometryProgramID);
+		DeleteTrackedProgram(m_forwardProgramID);
+		DeleteTrackedProgram(lightingProgramID);
+		return false;
+	}
+	m_geometryLocations = GetSurfaceLocations(m_geometryProgramID);
+	m_forwardLocations = GetSurfaceLocations(m_forwardProgramID);
+
+	// the samplers read from fixed units
+	glUseProgram(lightingProgramID);
+	glUniform1i(glGetUniformLocation(lightingProgramID, "albedoTexture"), ALBEDO_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(lightingProgramID, "normalTexture"), NORMAL_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(lightingProgramID, "depthTexture"), DEPTH_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(lightingProgramID, "lightTexels"), LIGHT_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(lightingProgramID, "tileTexels"), TILE_TEXTURE_UNIT);
+	glUseProgram(m_forwardProgramID);
+	glUniform1i(glGetUniformLocation(m_forwardProgramID, "lightTexels"), LIGHT_TEXTURE_UNIT);
+	glUseProgram(0);
+
+	// the buffers start with one texel, as an empty buffer cannot
+	// back a texture on every driver
+	const glm::vec4 emptyTexel(0.0f);
+	m_lightBufferID = GenTrackedBuffer("deferred lights");
+	glBindBuffer(GL_TEXTURE_BUFFER, m_lightBufferID);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(emptyTexel), &emptyTexel, GL_DYNAMIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_lightBufferID, sizeof(emptyTexel));
+	m_tileBufferID = GenTrackedBuffer("deferred light tiles");
+	glBindBuffer(GL_TEXTURE_BUFFER, m_tileBufferID);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(emptyTexel), &emptyTexel, GL_STREAM_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_tileBufferID, sizeof(emptyTexel));
+	m_tileBufferSize = sizeof(emptyTexel);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	m_lightTextureID = GenTrackedTexture("deferred lights");
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightBufferID);
+	m_tileTextureID = GenTrackedTexture("deferred light tiles");
+	glBindTexture(GL_TEXTURE_BUFFER, m_tileTextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, m_tileBufferID);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &m_maxTextureBufferSize);
+
+	m_emptyVertexArrayID = GenTrackedVertexArray("deferred full screen");
+	m_lightingProgramID = lightingProgramID;
+
+	return true;
+}
+
+/***********************************************************
+ *  GetSurfaceLocations()
+ *
+ *  This method is used for getting the locations of the
+ *  values of a surface in the geometry or forward program.
+ ***********************************************************/
+DeferredRenderer::SURFACE_LOCATIONS DeferredRenderer::GetSurfaceLocations(GLuint programID)
+{
+	SURFACE_LOCATIONS locations;
+
+	locations.model = glGetUniformLocation(programID, "model");
+	locations.color = glGetUniformLocation(programID, "objectColor");
+	locations.useTexture = glGetUniformLocation(programID, "bUseTexture");
+	locations.texture = glGetUniformLocation(programID, "objectTexture");
+	locations.material = glGetUniformLocation(programID, "materialIndex");
+
+	return locations;
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for setting the lights that the
+ *  surfaces are shaded with, and uploading them into the
+ *  light buffer as a sphere, a diffuse color with the focal
+ *  strength, and a specular color.
+ ***********************************************************/
+void DeferredRenderer::SetLights(const LIGHT* pLights, int lightCount, glm::vec3 ambientLight)
+{
+	m_ambientLight = ambientLight;
+	if (0 == m_lightBufferID)
+	{
+		return;
+	}
+
+	// the buffer keeps its capacity, so the same number of lights
+	// every frame does not allocate
+	int maxLights = std::max(m_maxTextureBufferSize / LIGHT_TEXELS, 1);
+	if (lightCount > maxLights)
+	{
+		std::cout << "ERROR: Only " << maxLights << " of " << lightCount << " lights fit in the light buffer" << std::endl;
+		lightCount = maxLights;
+	}
+	m_lights.assign(pLights, pLights + lightCount);
+	m_lightTexels.resize((size_t)lightCount * LIGHT_TEXELS);
+	for (int i = 0; i < lightCount; i++)
+	{
+		const LIGHT& light = pLights[i];
+		m_lightTexels[i * LIGHT_TEXELS] = glm::vec4(light.position, light.radius);
+		m_lightTexels[i * LIGHT_TEXELS + 1] = glm::vec4(light.diffuseColor, light.focalStrength);
+		m_lightTexels[i * LIGHT_TEXELS + 2] = glm::vec4(light.specularColor, 0.0f);
+	}
+
+	if (lightCount > 0)
+	{
+		GLsizeiptr size = (GLsizeiptr)(m_lightTexels.size() * sizeof(glm::vec4));
+		glBindBuffer(GL_TEXTURE_BUFFER, m_lightBufferID);
+		glBufferData(GL_TEXTURE_BUFFER, size, m_lightTexels.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_lightBufferID, (size_t)size);
+	}
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for setting the material table that
+ *  the G-buffer indexes.  The materials past the size of
+ *  the table are drawn with the first one.
+ ***********************************************************/
+void DeferredRenderer::SetMaterials(const MATERIAL* pMaterials, int materialCount)
+{
+	m_materialCount = std::min(std::max(materialCount, 1), MAX_MATERIALS);
+	for (int i = 0; i < m_materialCount; i++)
+	{
+		const MATERIAL& material = pMaterials[std::min(i, materialCount - 1)];
+		m_materialAmbient[i] = material.ambientColor;
+		m_materialDiffuse[i] = material.diffuseColor;
+		m_materialSpecular[i] = material.specularColor;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for keeping the framebuffer that is
+ *  lit into, and sizing and clearing the G-buffer.  The
+ *  scissor test must be off, since it also limits the
+ *  clear.
+ ***********************************************************/
+bool DeferredRenderer::BeginFrame(int width, int height)
+{
+	GLint framebufferID = 0;
+
+	if ((0 == m_lightingProgramID) || (width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebufferID);
+	m_targetFramebufferID = (GLuint)framebufferID;
+	if ((width != m_width) || (height != m_height))
+	{
+		if (false == CreateTextures(width, height))
+		{
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_targetFramebufferID);
+			return false;
+		}
+	}
+
+	// the clear color of the frame is kept for the target
+	glm::vec4 clearColor;
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, &clearColor.r);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebufferID);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glDepthMask(GL_TRUE);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_targetFramebufferID);
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for drawing the surfaces of the
+ *  viewport being drawn into the G-buffer from now on.
+ ***********************************************************/
+void DeferredRenderer::BeginGeometryPass()
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebufferID);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glUseProgram(m_geometryProgramID);
+	m_pSurfaceLocations = &m_geometryLocations;
+}
+
+/***********************************************************
+ *  BeginForwardPass()
+ *
+ *  This method is used for shading the surfaces drawn from
+ *  now on with every light, straight into the bound
+ *  framebuffer.
+ ***********************************************************/
+void DeferredRenderer::BeginForwardPass()
+{
+	glUseProgram(m_forwardProgramID);
+	m_pSurfaceLocations = &m_forwardLocations;
+	SetLightingValues(m_forwardProgramID);
+	glUniform1i(glGetUniformLocation(m_forwardProgramID, "lightCount"), (GLint)m_lights.size());
+	glActiveTexture(GL_TEXTURE0 + LIGHT_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTextureID);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  SetSurfaceValues()
+ *
+ *  This method is used for setting the transform, color,
+ *  texture and material of a surface into the active
+ *  geometry or forward program.
+ ***********************************************************/
+void DeferredRenderer::SetSurfaceValues(const glm::mat4& model, glm::vec4 color, int textureUnit, int material)
+{
+	if ((material < 0) || (material >= m_materialCount))
+	{
+		material = 0;
+	}
+
+	glUniformMatrix4fv(m_pSurfaceLocations->model, 1, GL_FALSE, glm::value_ptr(model));
+	glUniform4fv(m_pSurfaceLocations->color, 1, glm::value_ptr(color));
+	glUniform1i(m_pSurfaceLocations->useTexture, (textureUnit >= 0) ? GL_TRUE : GL_FALSE);
+	if (textureUnit >= 0)
+	{
+		glUniform1i(m_pSurfaceLocations->texture, textureUnit);
+	}
+	glUniform1i(m_pSurfaceLocations->material, material);
+}
+
+/***********************************************************
+ *  SetLightingValues()
+ *
+ *  This method is used for setting the ambient light and
+ *  the material table into a program that shades surfaces.
+ ***********************************************************/
+void DeferredRenderer::SetLightingValues(GLuint programID)
+{
+	glUniform3fv(glGetUniformLocation(programID, "ambientLight"), 1, glm::value_ptr(m_ambientLight));
+	glUniform3fv(glGetUniformLocation(programID, "materialAmbient"), m_materialCount, glm::value_ptr(m_materialAmbient[0]));
+	glUniform3fv(glGetUniformLocation(programID, "materialDiffuse"), m_materialCount, glm::value_ptr(m_materialDiffuse[0]));
+	glUniform3fv(glGetUniformLocation(programID, "materialSpecular"), m_materialCount, glm::value_ptr(m_materialSpecular[0]));
+}
+
+/***********************************************************
+ *  GetLightTiles()
+ *
+ *  This method is used for finding the tiles of a viewport
+ *  that the sphere of a light covers, from the corners of
+ *  the box around it on screen.  A light without a radius,
+ *  or one whose box crosses the plane of the camera, covers
+ *  every tile.
+ ***********************************************************/
+bool DeferredRenderer::GetLightTiles(const LIGHT& light, const glm::mat4& viewProjection, const SCENE_VIEW& sceneView, int tileRange[4])
+{
+	int tilesX = (sceneView.width + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (sceneView.height + TILE_SIZE - 1) / TILE_SIZE;
+
+	tileRange[0] = 0;
+	tileRange[1] = 0;
+	tileRange[2] = tilesX - 1;
+	tileRange[3] = tilesY - 1;
+	if (light.radius <= 0.0f)
+	{
+		return true;
+	}
+
+	glm::vec3 screenMin(FLT_MAX);
+	glm::vec3 screenMax(-FLT_MAX);
+	int behindCount = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = light.position + light.radius * glm::vec3(
+			(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+		glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+		if (clip.w <= 1.0e-5f)
+		{
+			behindCount++;
+			continue;
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMin = glm::min(screenMin, ndc);
+		screenMax = glm::max(screenMax, ndc);
+	}
+	if (8 == behindCount)
+	{
+		return false;
+	}
+	if (behindCount > 0)
+	{
+		return true;
+	}
+	if ((screenMax.x < -1.0f) || (screenMin.x > 1.0f) || (screenMax.y < -1.0f) || (screenMin.y > 1.0f) ||
+		(screenMax.z < -1.0f) || (screenMin.z > 1.0f))
+	{
+		return false;
+	}
+
+	tileRange[0] = glm::clamp((int)std::floor((screenMin.x * 0.5f + 0.5f) * sceneView.width / TILE_SIZE), 0, tilesX - 1);
+	tileRange[1] = glm::clamp((int)std::floor((screenMin.y * 0.5f + 0.5f) * sceneView.height / TILE_SIZE), 0, tilesY - 1);
+	tileRange[2] = glm::clamp((int)std::floor((screenMax.x * 0.5f + 0.5f) * sceneView.width / TILE_SIZE), 0, tilesX - 1);
+	tileRange[3] = glm::clamp((int)std::floor((screenMax.y * 0.5f + 0.5f) * sceneView.height / TILE_SIZE), 0, tilesY - 1);
+
+	return true;
+}
+
+/***********************************************************
+ *  RenderLighting()
+ *
+ *  This method is used for binning the lights into the
+ *  tiles of the viewport being drawn, and shading the
+ *  G-buffer into the framebuffer that the frame is drawn
+ *  into with a triangle over the viewport.  The lists are
+ *  counted, laid out and filled in the frame arena, with a
+ *  header of the first index and count for every tile.
+ ***********************************************************/
+bool DeferredRenderer::RenderLighting(const SCENE_VIEW& sceneView, FrameArena& frameArena)
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_targetFramebufferID);
+	if ((0 == m_lightingProgramID) || (sceneView.width <= 0) || (sceneView.height <= 0))
+	{
+		return false;
+	}
+
+	int tilesX = (sceneView.width + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (sceneView.height + TILE_SIZE - 1) / TILE_SIZE;
+	int tileCount = tilesX * tilesY;
+	int lightCount = (int)m_lights.size();
+	glm::mat4 viewProjection = sceneView.projection * sceneView.view;
+
+	// count the lights of each tile
+	int* pTileCounts = frameArena.AllocateArray<int>(tileCount);
+	int* pLightTiles = frameArena.AllocateArray<int>((size_t)lightCount * 4);
+	memset(pTileCounts, 0, sizeof(int) * tileCount);
+	size_t indexCount = 0;
+	for (int i = 0; i < lightCount; i++)
+	{
+		int* pRange = &pLightTiles[i * 4];
+		if (false == GetLightTiles(m_lights[i], viewProjection, sceneView, pRange))
+		{
+			pRange[0] = 0;
+			pRange[2] = -1;
+			continue;
+		}
+		for (int y = pRange[1]; y <= pRange[3]; y++)
+		{
+			for (int x = pRange[0]; x <= pRange[2]; x++)
+			{
+				pTileCounts[y * tilesX + x]++;
+			}
+		}
+		indexCount += (size_t)(pRange[2] - pRange[0] + 1) * (pRange[3] - pRange[1] + 1);
+	}
+
+	size_t texelCount = (size_t)tileCount * 2 + indexCount;
+	if (texelCount > (size_t)m_maxTextureBufferSize)
+	{
+		std::cout << "ERROR: The light lists of " << tileCount << " tiles do not fit in the tile buffer" << std::endl;
+		return false;
+	}
+
+	// lay out the lists after the headers, and fill them in the
+	// order of the lights
+	GLint* pTexels = frameArena.AllocateArray<GLint>(texelCount);
+	GLint next = tileCount * 2;
+	for (int i = 0; i < tileCount; i++)
+	{
+		pTexels[i * 2] = next;
+		pTexels[i * 2 + 1] = 0;
+		next += pTileCounts[i];
+	}
+	for (int i = 0; i < lightCount; i++)
+	{
+		const int* pRange = &pLightTiles[i * 4];
+		for (int y = pRange[1]; y <= pRange[3]; y++)
+		{
+			for (int x = pRange[0]; x <= pRange[2]; x++)
+			{
+				GLint* pHeader = &pTexels[(y * tilesX + x) * 2];
+				pTexels[pHeader[0] + pHeader[1]] = i;
+				pHeader[1]++;
+			}
+		}
+	}
+
+	// the buffer is only grown, and orphaned before each update so
+	// the previous viewport's lists can still be read
+	size_t size = texelCount * sizeof(GLint);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_tileBufferID);
+	if (size > m_tileBufferSize)
+	{
+		m_tileBufferSize = size;
+		SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_tileBufferID, m_tileBufferSize);
+	}
+	glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)m_tileBufferSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)size, pTexels);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glUseProgram(m_lightingProgramID);
+	SetLightingValues(m_lightingProgramID);
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glUniformMatrix4fv(glGetUniformLocation(m_lightingProgramID, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniform4f(glGetUniformLocation(m_lightingProgramID, "viewportRect"),
+		(float)sceneView.x, (float)sceneView.y, (float)sceneView.width, (float)sceneView.height);
+	glUniform1i(glGetUniformLocation(m_lightingProgramID, "tilesX"), tilesX);
+
+	glActiveTexture(GL_TEXTURE0 + ALBEDO_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_albedoTextureID);
+	glActiveTexture(GL_TEXTURE0 + NORMAL_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_normalTextureID);
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glActiveTexture(GL_TEXTURE0 + LIGHT_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTextureID);
+	glActiveTexture(GL_TEXTURE0 + TILE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_tileTextureID);
+	glActiveTexture(GL_TEXTURE0);
+
+	// every pixel with a surface passes, and its depth replaces
+	// the one in the target
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_ALWAYS);
+	glBindVertexArray(m_emptyVertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glDepthFunc(GL_LESS);
+
+	return true;
+}
+
+/***********************************************************
+ *  CreateTextures()
+ *
+ *  This method is used for creating the G-buffer textures
+ *  for a size, and the framebuffer they are attached to.
+ ***********************************************************/
+bool DeferredRenderer::CreateTextures(int width, int height)
+{
+	DeleteTextures();
+
+	struct TARGET
+	{
+		GLuint* pTextureID;
+		GLenum format;
+		const char* label;
+	};
+	const TARGET targets[3] =
+	{
+		{ &m_albedoTextureID, GL_RGBA8, "G-buffer albedo" },
+		{ &m_normalTextureID, GL_RG16, "G-buffer normal" },
+		{ &m_depthTextureID, GL_DEPTH_COMPONENT24, "G-buffer depth" }
+	};
+	for (int i = 0; i < 3; i++)
+	{
+		*targets[i].pTextureID = GenTrackedTexture(targets[i].label);
+		glBindTexture(GL_TEXTURE_2D, *targets[i].pTextureID);
+		glTexStorage2D(GL_TEXTURE_2D, 1, targets[i].format, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, *targets[i].pTextureID, GetTextureStorageSize(targets[i].format, width, height));
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedoTextureID, 0);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normalTextureID, 0);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTextureID, 0);
+	glDrawBuffers(2, drawBuffers);
+	GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: G-buffer framebuffer is incomplete (" << status << ")" << std::endl;
+		DeleteTextures();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+
+	return true;
+}
+
+/***********************************************************
+ *  DeleteTextures()
+ *
+ *  This method is used for freeing the G-buffer textures
+ *  and their framebuffer.
+ ***********************************************************/
+void DeferredRenderer::DeleteTextures()
+{
+	DeleteTrackedTexture(m_albedoTextureID);
+	DeleteTrackedTexture(m_normalTextureID);
+	DeleteTrackedTexture(m_depthTextureID);
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// draw the opaque surfaces of the scene into a compact G-buffer and
+// light them afterwards with the lights binned into screen tiles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameAllocator.h"
+#include "SceneView.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class holds the G-buffer of the deferred shading
+ *  path.  The geometry pass writes the base color and the
+ *  material index of each pixel into one RGBA8 texture and
+ *  its normal, packed onto an octahedron, into an RG16
+ *  texture, next to the depth that the position is rebuilt
+ *  from.  The lighting pass then shades each pixel once,
+ *  with only the lights whose spheres reach the 16 by 16
+ *  pixel tile it is in.  The tiles are binned on the CPU
+ *  for each viewport and read by the shader from texture
+ *  buffers.  A forward program that evaluates the whole
+ *  light list for every fragment is kept for comparing the
+ *  two paths.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// texture units the G-buffer, the lights and the tile lists
+	// are read from, which are not used by the scene textures,
+	// the frame graph inputs or the other passes
+	static const int ALBEDO_TEXTURE_UNIT = 22;
+	static const int NORMAL_TEXTURE_UNIT = 23;
+	static const int DEPTH_TEXTURE_UNIT = 24;
+	static const int LIGHT_TEXTURE_UNIT = 25;
+	static const int TILE_TEXTURE_UNIT = 26;
+	// most materials that the G-buffer can index, including the
+	// plain material in the first entry
+	static const int MAX_MATERIALS = 64;
+	// size in pixels of the screen tiles that lights are binned to
+	static const int TILE_SIZE = 16;
+
+	// a light that the surfaces are shaded with - a light with no
+	// radius reaches every pixel, and the others fade out to
+	// nothing at their radius
+	struct LIGHT
+	{
+		glm::vec3 position;
+		float radius;
+		glm::vec3 diffuseColor;
+		// the specular color with its intensity taken in
+		glm::vec3 specularColor;
+		float focalStrength;
+	};
+
+	// the lighting values of a material, with the ambient color
+	// scaled by its strength and the specular color by the
+	// shininess, as the scene shader applies them
+	struct MATERIAL
+	{
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+	};
+
+	// constructor
+	DeferredRenderer();
+	// destructor
+	~DeferredRenderer();
+
+	// compile the programs - returns false when the driver cannot
+	// run them
+	bool Initialize();
+	// check whether the programs are available
+	bool IsAvailable() const { return (0 != m_lightingProgramID); }
+
+	// set the lights, and the ambient light summed over them
+	void SetLights(const LIGHT* pLights, int lightCount, glm::vec3 ambientLight);
+	int GetLightCount() const { return (int)m_lights.size(); }
+	// set the materials, where the first one is used for the
+	// surfaces without a material
+	void SetMaterials(const MATERIAL* pMaterials, int materialCount);
+
+	// size the G-buffer to cover the viewports and clear it - the
+	// draw framebuffer bound now is the one that is lit into
+	bool BeginFrame(int width, int height);
+	// make the G-buffer the draw target and the geometry program
+	// active for the surfaces of a viewport
+	void BeginGeometryPass();
+	// make the forward program that evaluates every light active
+	// for the surfaces drawn into the bound framebuffer
+	void BeginForwardPass();
+	// set the values of a surface into the active program, with a
+	// texture unit or -1 for the color, and a material table index
+	void SetSurfaceValues(const glm::mat4& model, glm::vec4 color, int textureUnit, int material);
+	// bin the lights into the tiles of a viewport, and shade the
+	// G-buffer into the framebuffer that was bound when the frame
+	// began - the depth of the surfaces is written along with it
+	bool RenderLighting(const SCENE_VIEW& sceneView, FrameArena& frameArena);
+
+private:
+	// locations of the values of a surface in a program
+	struct SURFACE_LOCATIONS
+	{
+		GLint model;
+		GLint color;
+		GLint useTexture;
+		GLint texture;
+		GLint material;
+	};
+
+	// the programs for the geometry pass, the lighting pass and
+	// the forward comparison, and the surface value locations of
+	// the active one
+	GLuint m_geometryProgramID;
+	GLuint m_lightingProgramID;
+	GLuint m_forwardProgramID;
+	SURFACE_LOCATIONS m_geometryLocations;
+	SURFACE_LOCATIONS m_forwardLocations;
+	const SURFACE_LOCATIONS* m_pSurfaceLocations;
+
+	// the G-buffer textures and their framebuffer
+	GLuint m_albedoTextureID;
+	GLuint m_normalTextureID;
+	GLuint m_depthTextureID;
+	GLuint m_framebufferID;
+	int m_width;
+	int m_height;
+	// the framebuffer that the lighting pass draws into
+	GLuint m_targetFramebufferID;
+
+	// texture buffers holding the lights and the tile lists
+	GLuint m_lightBufferID;
+	GLuint m_lightTextureID;
+	GLuint m_tileBufferID;
+	GLuint m_tileTextureID;
+	size_t m_tileBufferSize;
+	GLint m_maxTextureBufferSize;
+	// empty vertex array for the full screen triangle
+	GLuint m_emptyVertexArrayID;
+
+	// the lights on the CPU for binning, the texels they are
+	// uploaded from, and the ambient light
+	std::vector<LIGHT> m_lights;
+	std::vector<glm::vec4> m_lightTexels;
+	glm::vec3 m_ambientLight;
+	// the material table, split into the arrays of the shaders
+	glm::vec3 m_materialAmbient[MAX_MATERIALS];
+	glm::vec3 m_materialDiffuse[MAX_MATERIALS];
+	glm::vec3 m_materialSpecular[MAX_MATERIALS];
+	int m_materialCount;
+
+	// create the G-buffer textures for a size
+	bool CreateTextures(int width, int height);
+	// free the G-buffer textures
+	void DeleteTextures();
+	// set the light count, ambient light and materials into a
+	// program that shades surfaces
+	void SetLightingValues(GLuint programID);
+	// get the first and last tile columns and rows of a viewport
+	// that a light reaches - returns false when it is outside of
+	// the viewport
+	static bool GetLightTiles(const LIGHT& light, const glm::mat4& viewProjection, const SCENE_VIEW& sceneView, int tileRange[4]);
+	// get the locations of the values of a surface in a program
+	static SURFACE_LOCATIONS GetSurfaceLocations(GLuint programID);
+};
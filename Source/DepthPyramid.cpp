@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthpyramid.cpp
+// ============
+// reduce the depth buffer of the scene into a chain of levels that
+// each hold the farthest depth of the texels below them, for testing
+// whether objects are hidden
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthPyramid.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texels written by each work group of the reduction program
+	const int REDUCE_GROUP_SIZE = 8;
+
+	// compute shader that writes one level of the pyramid, either
+	// from the depth copy or from the level below it - a texel
+	// on the last row or column of a level with an odd size
+	// also covers the texel past it, so no depth is skipped
+	const char* g_ReduceComputeShader =
+		"#version 460 core\n"
+		"layout (local_size_x = 8, local_size_y = 8) in;\n"
+		"layout (binding = 30) uniform sampler2D depthTexture;\n"
+		"layout (r32f, binding = 0) readonly uniform image2D sourceLevel;\n"
+		"layout (r32f, binding = 1) writeonly uniform image2D destinationLevel;\n"
+		"uniform bool firstLevel;\n"
+		"void main()\n"
+		"{\n"
+		"	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);\n"
+		"	ivec2 destinationSize = imageSize(destinationLevel);\n"
+		"	if (any(greaterThanEqual(texel, destinationSize)))\n"
+		"	{\n"
+		"		return;\n"
+		"	}\n"
+		"	if (firstLevel)\n"
+		"	{\n"
+		"		imageStore(destinationLevel, texel, vec4(texelFetch(depthTexture, texel, 0).r));\n"
+		"		return;\n"
+		"	}\n"
+		"	ivec2 sourceSize = imageSize(sourceLevel);\n"
+		"	ivec2 first = texel * 2;\n"
+		"	ivec2 last = min(first + ivec2(1), sourceSize - ivec2(1));\n"
+		"	if ((texel.x == destinationSize.x - 1) && ((sourceSize.x & 1) != 0))\n"
+		"	{\n"
+		"		last.x = sourceSize.x - 1;\n"
+		"	}\n"
+		"	if ((texel.y == destinationSize.y - 1) && ((sourceSize.y & 1) != 0))\n"
+		"	{\n"
+		"		last.y = sourceSize.y - 1;\n"
+		"	}\n"
+		"	float farthest = 0.0f;\n"
+		"	for (int y = first.y; y <= last.y; y++)\n"
+		"	{\n"
+		"		for (int x = first.x; x <= last.x; x++)\n"
+		"		{\n"
+		"			farthest = max(farthest, imageLoad(sourceLevel, ivec2(x, y)).r);\n"
+		"		}\n"
+		"	}\n"
+		"	imageStore(destinationLevel, texel, vec4(farthest));\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  DepthPyramid()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthPyramid::DepthPyramid()
+{
+	m_reduceProgramID = 0;
+	m_firstLevelLocation = -1;
+	m_depthTextureID = 0;
+	m_copyFramebufferID = 0;
+	m_depthFormat = GL_NONE;
+	m_pyramidTextureID = 0;
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_bBuilt = false;
+}
+
+/***********************************************************
+ *  ~DepthPyramid()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DepthPyramid::~DepthPyramid()
+{
+	DeleteTextures();
+	DeleteTrackedProgram(m_reduceProgramID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the reduction program,
+ *  which writes the levels through image stores.
+ ***********************************************************/
+bool DepthPyramid::Initialize()
+{
+	if (!GLEW_VERSION_4_6)
+	{
+		return false;
+	}
+
+	m_reduceProgramID = ShaderCache::CompileComputeProgram(g_ReduceComputeShader);
+	if (0 == m_reduceProgramID)
+	{
+		return false;
+	}
+	m_firstLevelLocation = glGetUniformLocation(m_reduceProgramID, "firstLevel");
+
+	return true;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for copying the depth buffer of the
+ *  bound draw framebuffer and reducing it into the levels.
+ *  A multisampled depth buffer is resolved by the copy.
+ *  The scissor test must be off, since it also limits the
+ *  copy.
+ ***********************************************************/
+bool DepthPyramid::Build(int width, int height)
+{
+	GLint framebufferID = 0;
+
+	m_bBuilt = false;
+	if ((0 == m_reduceProgramID) || (width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebufferID);
+	GLenum depthFormat = GetFramebufferDepthFormat();
+	if (GL_NONE == depthFormat)
+	{
+		return false;
+	}
+	if ((width != m_width) || (height != m_height) || (depthFormat != m_depthFormat))
+	{
+		if (false == CreateTextures(width, height, depthFormat))
+		{
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)framebufferID);
+			return false;
+		}
+	}
+
+	// the copy needs matching depth formats, which is why the copy
+	// texture follows the format of the framebuffer
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)framebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_copyFramebufferID);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)framebufferID);
+
+	glUseProgram(m_reduceProgramID);
+	glActiveTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+
+		glUniform1i(m_firstLevelLocation, (level == 0) ? GL_TRUE : GL_FALSE);
+		glBindImageTexture(0, m_pyramidTextureID, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, m_pyramidTextureID, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(
+			(GLuint)((levelWidth + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE),
+			(GLuint)((levelHeight + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE),
+			1);
+
+		// each level is read by the reduction of the next one
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	// the levels are read through a sampler by the culling
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_2D, m_pyramidTextureID);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_bBuilt = true;
+
+	return true;
+}
+
+/***********************************************************
+ *  GetFramebufferDepthFormat()
+ *
+ *  This method is used for finding the internal format of
+ *  the depth buffer of the bound draw framebuffer from the
+ *  size and type of its depth and stencil bits.  Returns
+ *  GL_NONE when the framebuffer has no depth buffer.
+ ***********************************************************/
+GLenum DepthPyramid::GetFramebufferDepthFormat()
+{
+	GLint framebufferID = 0;
+	GLint depthBits = 0;
+	GLint stencilBits = 0;
+	GLint componentType = GL_NONE;
+
+	// the default framebuffer names its buffers differently
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebufferID);
+	GLenum attachment = (0 == framebufferID) ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+	glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+	glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+	glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &componentType);
+
+	if (GL_FLOAT == componentType)
+	{
+		return (stencilBits > 0) ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+	}
+	if (depthBits >= 24)
+	{
+		return (stencilBits > 0) ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24;
+	}
+	if (depthBits > 0)
+	{
+		return GL_DEPTH_COMPONENT16;
+	}
+
+	return GL_NONE;
+}
+
+/***********************************************************
+ *  CreateTextures()
+ *
+ *  This method is used for creating the depth copy and the
+ *  levels for a size and depth format.  The levels go down
+ *  to a single texel.
+ ***********************************************************/
+bool DepthPyramid::CreateTextures(int width, int height, GLenum depthFormat)
+{
+	DeleteTextures();
+
+	bool bStencil = (depthFormat == GL_DEPTH24_STENCIL8) || (depthFormat == GL_DEPTH32F_STENCIL8);
+
+	m_depthTextureID = GenTrackedTexture("depth pyramid copy");
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, 1, depthFormat, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_depthTextureID, GetTextureStorageSize(depthFormat, width, height));
+
+	m_levelCount = 1;
+	while ((std::max(width, height) >> m_levelCount) > 0)
+	{
+		m_levelCount++;
+	}
+
+	m_pyramidTextureID = GenTrackedTexture("depth pyramid");
+	glBindTexture(GL_TEXTURE_2D, m_pyramidTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, m_levelCount, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_pyramidTextureID, GetTextureStorageSize(GL_R32F, width, height, 1, true));
+
+	glGenFramebuffers(1, &m_copyFramebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_copyFramebufferID);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, bStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+		GL_TEXTURE_2D, m_depthTextureID, 0);
+	glDrawBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Depth pyramid framebuffer is incomplete (" << status << ")" << std::endl;
+		DeleteTextures();
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_depthFormat = depthFormat;
+
+	return true;
+}
+
+/***********************************************************
+ *  DeleteTextures()
+ *
+ *  This method is used for freeing the depth copy, the
+ *  levels and the framebuffer used for the copy.
+ ***********************************************************/
+void DepthPyramid::DeleteTextures()
+{
+	DeleteTrackedTexture(m_depthTextureID);
+	DeleteTrackedTexture(m_pyramidTextureID);
+	if (0 != m_copyFramebufferID)
+	{
+		glDeleteFramebuffers(1, &m_copyFramebufferID);
+		m_copyFramebufferID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_depthFormat = GL_NONE;
+	m_bBuilt = false;
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthpyramid.h
+// ============
+// reduce the depth buffer of the scene into a chain of levels that
+// each hold the farthest depth of the texels below them, for testing
+// whether objects are hidden
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  DepthPyramid
+ *
+ *  This class copies the depth buffer of the framebuffer
+ *  being drawn and reduces it with a compute shader into
+ *  the mip levels of a floating point texture.  Each texel
+ *  of a level holds the farthest depth of the texels that
+ *  it covers in the level below, so a box whose nearest
+ *  depth is behind the texels under it is hidden.  The
+ *  size of the box on screen picks the level, so only a
+ *  few texels are read for each test.
+ ***********************************************************/
+class DepthPyramid
+{
+public:
+	// texture unit the pyramid is read from, which is not used
+	// by the scene textures or the frame graph inputs
+	static const int PYRAMID_TEXTURE_UNIT = 30;
+
+	// constructor
+	DepthPyramid();
+	// destructor
+	~DepthPyramid();
+
+	// compile the reduction program - returns false when the
+	// driver cannot run it
+	bool Initialize();
+	// check whether the reduction program is available
+	bool IsAvailable() const { return (0 != m_reduceProgramID); }
+
+	// copy an area of the depth buffer of the bound draw
+	// framebuffer from the origin, and reduce it into the levels
+	bool Build(int width, int height);
+	// check whether the levels hold a reduced depth buffer
+	bool IsBuilt() const { return m_bBuilt; }
+
+	// get the texture holding the levels, and its size
+	GLuint GetTextureID() const { return m_pyramidTextureID; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	int GetLevelCount() const { return m_levelCount; }
+
+private:
+	GLuint m_reduceProgramID;
+	GLint m_firstLevelLocation;
+
+	// copy of the depth buffer, and the framebuffer it is
+	// attached to for the copy
+	GLuint m_depthTextureID;
+	GLuint m_copyFramebufferID;
+	GLenum m_depthFormat;
+	// the reduced levels
+	GLuint m_pyramidTextureID;
+	int m_width;
+	int m_height;
+	int m_levelCount;
+	bool m_bBuilt;
+
+	// get the internal format that matches the depth buffer of
+	// the bound draw framebuffer, so that it can be copied
+	static GLenum GetFramebufferDepthFormat();
+	// create the copy and the levels for a size and format
+	bool CreateTextures(int width, int height, GLenum depthFormat);
+	// free the copy and the levels
+	void DeleteTextures();
+};
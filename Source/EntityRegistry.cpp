@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+// entityregistry.cpp
+// ============
+// hand out the entities of the scene and keep their components in packed
+// arrays, one array for each kind of component
+///////////////////////////////////////////////////////////////////////////////
+
+#include "EntityRegistry.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  EntityRegistry()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+EntityRegistry::EntityRegistry()
+{
+	m_nextEntity = 0;
+}
+
+/***********************************************************
+ *  CreateEntity()
+ *
+ *  This method is used for creating an entity, reusing one
+ *  that was destroyed when there is one.
+ ***********************************************************/
+ENTITY EntityRegistry::CreateEntity()
+{
+	if (false == m_freeEntities.empty())
+	{
+		ENTITY entity = m_freeEntities.back();
+		m_freeEntities.pop_back();
+		return entity;
+	}
+
+	return m_nextEntity++;
+}
+
+/***********************************************************
+ *  DestroyEntity()
+ *
+ *  This method is used for removing the components of an
+ *  entity, which can then be handed out again.
+ ***********************************************************/
+void EntityRegistry::DestroyEntity(ENTITY entity)
+{
+	if (entity >= m_nextEntity)
+	{
+		return;
+	}
+
+	m_transforms.Remove(entity);
+	m_renderables.Remove(entity);
+	m_animations.Remove(entity);
+	m_freeEntities.push_back(entity);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for removing every entity and its
+ *  components.
+ ***********************************************************/
+void EntityRegistry::Reset()
+{
+	m_transforms.Clear();
+	m_renderables.Clear();
+	m_animations.Clear();
+	m_freeEntities.clear();
+	m_nextEntity = 0;
+}
+
+/***********************************************************
+ *  RestTransform()
+ *
+ *  This method is used for getting a transform component
+ *  that places an entity at a rest transform, with no
+ *  animated movement around its pivot.
+ ***********************************************************/
+TRANSFORM_COMPONENT EntityRegistry::RestTransform(const glm::mat4& restMatrix, glm::vec3 pivot)
+{
+	TRANSFORM_COMPONENT transform;
+	transform.restMatrix = restMatrix;
+	transform.pivot = pivot;
+	transform.translation = glm::vec3(0.0f);
+	transform.rotation = glm::vec3(0.0f);
+	transform.scale = glm::vec3(1.0f);
+	transform.worldMatrix = restMatrix;
+
+	return transform;
+}
+
+/***********************************************************
+ *  CalculateWorldMatrix()
+ *
+ *  This method is used for applying the animated values of
+ *  a transform to its rest transform.  The rotations are
+ *  applied in the order of the scene's model matrices, X
+ *  then Y then Z outermost first, and the rotation and
+ *  scale are about the pivot, so a lid turns about its
+ *  hinge.  The matrix is built from the sines and cosines
+ *  of the angles rather than from three rotation matrices,
+ *  since it is done for every animated entity each frame.
+ ***********************************************************/
+glm::mat4 EntityRegistry::CalculateWorldMatrix(const TRANSFORM_COMPONENT& transform)
+{
+	glm::vec3 angles = glm::radians(transform.rotation);
+	float sx = sinf(angles.x);
+	float cx = cosf(angles.x);
+	float sy = sinf(angles.y);
+	float cy = cosf(angles.y);
+	float sz = sinf(angles.z);
+	float cz = cosf(angles.z);
+
+	// the columns of rotationX * rotationY * rotationZ, scaled
+	glm::vec3 axisX = glm::vec3(cy * cz, sx * sy * cz + cx * sz, -cx * sy * cz + sx * sz) * transform.scale.x;
+	glm::vec3 axisY = glm::vec3(-cy * sz, -sx * sy * sz + cx * cz, cx * sy * sz + sx * cz) * transform.scale.y;
+	glm::vec3 axisZ = glm::vec3(sy, -sx * cy, cx * cy) * transform.scale.z;
+
+	// the pivot stays where it is, then the whole is moved by
+	// the animated translation
+	glm::vec3 offset = transform.pivot + transform.translation -
+		(axisX * transform.pivot.x + axisY * transform.pivot.y + axisZ * transform.pivot.z);
+
+	glm::mat4 animation(
+		glm::vec4(axisX, 0.0f),
+		glm::vec4(axisY, 0.0f),
+		glm::vec4(axisZ, 0.0f),
+		glm::vec4(offset, 1.0f));
+
+	return animation * transform.restMatrix;
+}
+
+/***********************************************************
+ *  TransformBounds()
+ *
+ *  This method is used for getting the box around the
+ *  transformed corners of a local bounding box.  The box is
+ *  found from the transformed center and the extents along
+ *  the absolute transformed axes, which gives the same box
+ *  as transforming all eight corners for a fraction of the
+ *  work.
+ ***********************************************************/
+void EntityRegistry::TransformBounds(const glm::mat4& matrix, glm::vec3 localBoundsMin, glm::vec3 localBoundsMax,
+	glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+	glm::vec3 localCenter = (localBoundsMin + localBoundsMax) * 0.5f;
+	glm::vec3 localExtent = (localBoundsMax - localBoundsMin) * 0.5f;
+
+	glm::vec3 center = glm::vec3(matrix * glm::vec4(localCenter, 1.0f));
+	glm::vec3 extent =
+		glm::abs(glm::vec3(matrix[0])) * localExtent.x +
+		glm::abs(glm::vec3(matrix[1])) * localExtent.y +
+		glm::abs(glm::vec3(matrix[2])) * localExtent.z;
+
+	boundsMin = center - extent;
+	boundsMax = center + extent;
+}
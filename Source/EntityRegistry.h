@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+// entityregistry.h
+// ============
+// hand out the entities of the scene and keep their components in packed
+// arrays, one array for each kind of component
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// an entity is only an index that its components are found by
+typedef uint32_t ENTITY;
+const ENTITY NO_ENTITY = 0xFFFFFFFFu;
+
+// the placement of an entity, where the animated values move it
+// around a pivot from the transform it was added with
+struct TRANSFORM_COMPONENT
+{
+	glm::mat4 restMatrix;
+	glm::vec3 pivot;
+	glm::vec3 translation;
+	// rotation in degrees about the X, Y and Z axes
+	glm::vec3 rotation;
+	glm::vec3 scale;
+	// the rest transform with the animated values applied
+	glm::mat4 worldMatrix;
+};
+
+// a scene object drawn at the world transform of its entity
+struct RENDERABLE_COMPONENT
+{
+	int objectIndex;
+	glm::vec3 localBoundsMin;
+	glm::vec3 localBoundsMax;
+	// the local bounds around the world transform
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
+
+// a clip of the animation system played on an entity
+struct ANIMATION_COMPONENT
+{
+	int clip;
+	// rate the clip is played at, and the clip time it is started
+	// from, so entities sharing a clip do not move together
+	float speed;
+	float timeOffset;
+	// the clip time it was last sampled at, or -1 before the first
+	// update, to tell whether the clip is still moving
+	float clipTime;
+};
+
+/***********************************************************
+ *  ComponentStore
+ *
+ *  This template keeps the components of one kind packed in
+ *  an array with no gaps, next to the entity that owns each
+ *  one, so a system walks them in order through memory.  A
+ *  second array, indexed by entity, holds where the entity's
+ *  component is in the packed array, so the component of an
+ *  entity is found without a search.  A removed component
+ *  is replaced by the last one, so the packed order changes
+ *  but the array stays without gaps.
+ ***********************************************************/
+template <typename COMPONENT>
+class ComponentStore
+{
+public:
+	// add the component of an entity, or replace the one it has -
+	// returns the stored component
+	COMPONENT& Add(ENTITY entity, const COMPONENT& component)
+	{
+		if (entity >= m_indices.size())
+		{
+			m_indices.resize(entity + 1, -1);
+		}
+		if (m_indices[entity] >= 0)
+		{
+			m_components[m_indices[entity]] = component;
+			return m_components[m_indices[entity]];
+		}
+
+		m_indices[entity] = (int)m_components.size();
+		m_components.push_back(component);
+		m_entities.push_back(entity);
+		return m_components.back();
+	}
+
+	// remove the component of an entity, moving the last component
+	// into its place
+	void Remove(ENTITY entity)
+	{
+		int index = GetIndex(entity);
+		if (index < 0)
+		{
+			return;
+		}
+
+		int lastIndex = (int)m_components.size() - 1;
+		if (index != lastIndex)
+		{
+			m_components[index] = m_components[lastIndex];
+			m_entities[index] = m_entities[lastIndex];
+			m_indices[m_entities[index]] = index;
+		}
+		m_components.pop_back();
+		m_entities.pop_back();
+		m_indices[entity] = -1;
+	}
+
+	// remove every component
+	void Clear()
+	{
+		m_components.clear();
+		m_entities.clear();
+		m_indices.clear();
+	}
+
+	// make room for a number of components, so adding them does
+	// not move the array
+	void Reserve(int count)
+	{
+		m_components.reserve(count);
+		m_entities.reserve(count);
+	}
+
+	// get the packed index of the component of an entity, or -1
+	// when it has none
+	int GetIndex(ENTITY entity) const
+	{
+		return (entity < m_indices.size()) ? m_indices[entity] : -1;
+	}
+	bool Has(ENTITY entity) const { return (GetIndex(entity) >= 0); }
+	// get the component of an entity, which must have one
+	COMPONENT& Get(ENTITY entity) { return m_components[m_indices[entity]]; }
+	const COMPONENT& Get(ENTITY entity) const { return m_components[m_indices[entity]]; }
+
+	// walk the packed components, with the entity of each
+	int GetCount() const { return (int)m_components.size(); }
+	COMPONENT& GetAt(int index) { return m_components[index]; }
+	const COMPONENT& GetAt(int index) const { return m_components[index]; }
+	ENTITY GetEntity(int index) const { return m_entities[index]; }
+
+private:
+	std::vector<COMPONENT> m_components;
+	std::vector<ENTITY> m_entities;
+	std::vector<int> m_indices;
+};
+
+/***********************************************************
+ *  EntityRegistry
+ *
+ *  This class hands out the entities of the scene and holds
+ *  the stores of their transform, renderable and animation
+ *  components.  The entities of removed ones are handed out
+ *  again, so the arrays indexed by entity stay as small as
+ *  the most entities alive at once.
+ ***********************************************************/
+class EntityRegistry
+{
+public:
+	// constructor
+	EntityRegistry();
+
+	// create an entity with no components
+	ENTITY CreateEntity();
+	// remove the components of an entity and hand it out again
+	void DestroyEntity(ENTITY entity);
+	// remove every entity
+	void Reset();
+	// get the number of entities alive
+	int GetEntityCount() const { return (int)(m_nextEntity - m_freeEntities.size()); }
+
+	// the stores of the components
+	ComponentStore<TRANSFORM_COMPONENT>& GetTransforms() { return m_transforms; }
+	ComponentStore<RENDERABLE_COMPONENT>& GetRenderables() { return m_renderables; }
+	ComponentStore<ANIMATION_COMPONENT>& GetAnimations() { return m_animations; }
+	const ComponentStore<TRANSFORM_COMPONENT>& GetTransforms() const { return m_transforms; }
+	const ComponentStore<RENDERABLE_COMPONENT>& GetRenderables() const { return m_renderables; }
+	const ComponentStore<ANIMATION_COMPONENT>& GetAnimations() const { return m_animations; }
+
+	// get the transform that places an entity at rest, so the
+	// animated values start from no change
+	static TRANSFORM_COMPONENT RestTransform(const glm::mat4& restMatrix, glm::vec3 pivot);
+	// get the world transform from the animated values of a
+	// transform component
+	static glm::mat4 CalculateWorldMatrix(const TRANSFORM_COMPONENT& transform);
+	// get the world bounds of a box in local space, from the
+	// extents of its transformed corners
+	static void TransformBounds(const glm::mat4& matrix, glm::vec3 localBoundsMin, glm::vec3 localBoundsMax,
+		glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+private:
+	ENTITY m_nextEntity;
+	std::vector<ENTITY> m_freeEntities;
+
+	ComponentStore<TRANSFORM_COMPONENT> m_transforms;
+	ComponentStore<RENDERABLE_COMPONENT> m_renderables;
+	ComponentStore<ANIMATION_COMPONENT> m_animations;
+};
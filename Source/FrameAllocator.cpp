@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameallocator.cpp
+// ============
+// manage the transient memory that is used while rendering a frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameAllocator.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef TRACK_HEAP_ALLOCATIONS
+// declaration of global variables
+namespace
+{
+	// number of allocations made through operator new by each
+	// thread, so the render thread only counts its own frames
+	thread_local uint64_t g_HeapAllocationCount = 0;
+}
+
+/***********************************************************
+ *  operator new()
+ *
+ *  The global allocation functions are replaced so that
+ *  every heap allocation made through new is counted.
+ ***********************************************************/
+void* operator new(size_t size)
+{
+	g_HeapAllocationCount++;
+
+	void* pMemory = malloc(size > 0 ? size : 1);
+	if (NULL == pMemory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pMemory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+#endif
+
+/***********************************************************
+ *  GetHeapAllocationCount()
+ *
+ *  This function is used for getting the number of heap
+ *  allocations that the calling thread has made through
+ *  operator new.
+ ***********************************************************/
+uint64_t GetHeapAllocationCount()
+{
+#ifdef TRACK_HEAP_ALLOCATIONS
+	return g_HeapAllocationCount;
+#else
+	return 0;
+#endif
+}
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena(size_t capacity)
+{
+	m_pMemory = new unsigned char[capacity];
+	m_capacity = capacity;
+	m_offset = 0;
+	m_usedBytes = 0;
+	m_peakBytes = 0;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	for (size_t i = 0; i < m_overflowBlocks.size(); i++)
+	{
+		delete[] m_overflowBlocks[i];
+	}
+	m_overflowBlocks.clear();
+	delete[] m_pMemory;
+	m_pMemory = NULL;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting memory from the arena
+ *  that stays valid until the next reset.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	size_t alignedOffset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+	m_usedBytes += size;
+	if (alignedOffset + size <= m_capacity)
+	{
+		m_offset = alignedOffset + size;
+		return m_pMemory + alignedOffset;
+	}
+
+	// the block is full, so this frame gets an overflow block -
+	// new returns memory aligned for any fundamental type
+	unsigned char* pOverflow = new unsigned char[size > 0 ? size : 1];
+	m_overflowBlocks.push_back(pOverflow);
+
+	return pOverflow;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for releasing all of the memory that
+ *  was handed out since the last reset.  If the frame did
+ *  not fit in the main block, the block is grown so that
+ *  the next frames do not need any overflow blocks.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	if (m_usedBytes > m_peakBytes)
+	{
+		m_peakBytes = m_usedBytes;
+	}
+
+	if (false == m_overflowBlocks.empty())
+	{
+		for (size_t i = 0; i < m_overflowBlocks.size(); i++)
+		{
+			delete[] m_overflowBlocks[i];
+		}
+		m_overflowBlocks.clear();
+
+		// leave room for the alignment padding of each request
+		size_t capacity = m_capacity * 2;
+		while (capacity < m_peakBytes * 2)
+		{
+			capacity *= 2;
+		}
+		delete[] m_pMemory;
+		m_pMemory = new unsigned char[capacity];
+		m_capacity = capacity;
+	}
+
+	m_offset = 0;
+	m_usedBytes = 0;
+}
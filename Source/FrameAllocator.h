@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameallocator.h
+// ============
+// manage the transient memory that is used while rendering a frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class hands out memory from a single block by
+ *  moving an offset forward, and releases everything at
+ *  once when the frame is reset.  If a frame needs more
+ *  than the block holds, the extra requests are served
+ *  from overflow blocks and the main block is grown at the
+ *  next reset, so later frames stay inside one block.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena(size_t capacity);
+	// destructor
+	~FrameArena();
+
+	// get memory that stays valid until the next reset
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// release all of the memory handed out since the last reset
+	void Reset();
+
+	// get an uninitialized array that stays valid until the next reset
+	template<typename T>
+	T* AllocateArray(size_t count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// get the number of bytes handed out since the last reset
+	size_t GetUsedBytes() const { return m_usedBytes; }
+	// get the most bytes that a single frame has needed
+	size_t GetPeakBytes() const { return m_peakBytes; }
+
+private:
+	// the block of memory that is handed out
+	unsigned char* m_pMemory;
+	size_t m_capacity;
+	// offset of the next free byte in the block
+	size_t m_offset;
+	// bytes handed out this frame, including overflow blocks
+	size_t m_usedBytes;
+	size_t m_peakBytes;
+	// blocks that were needed when the main block was full
+	std::vector<unsigned char*> m_overflowBlocks;
+};
+
+// get the number of heap allocations the calling thread has made
+// through operator new - the count is only tracked when
+// TRACK_HEAP_ALLOCATIONS is defined
+uint64_t GetHeapAllocationCount();
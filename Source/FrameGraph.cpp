@@ -0,0 +1,851 @@
+///////////////////////////////////////////////////////////////////////////////
+// framegraph.cpp
+// ============
+// declare the render passes of a frame with the textures they
+// read and write, and run them with automatically managed
+// render targets
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameGraph.h"
+#include "GPUResources.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	/***********************************************************
+	 *  GetPixelFormat()
+	 *
+	 *  This function is used for getting the pixel format and
+	 *  type that match a render target internal format, which
+	 *  are needed to allocate the texture storage.
+	 ***********************************************************/
+	void GetPixelFormat(GLenum internalFormat, GLenum& format, GLenum& type)
+	{
+		switch (internalFormat)
+		{
+		case GL_DEPTH_COMPONENT24:
+			format = GL_DEPTH_COMPONENT;
+			type = GL_UNSIGNED_INT;
+			break;
+		case GL_DEPTH_COMPONENT32F:
+			format = GL_DEPTH_COMPONENT;
+			type = GL_FLOAT;
+			break;
+		case GL_DEPTH24_STENCIL8:
+			format = GL_DEPTH_STENCIL;
+			type = GL_UNSIGNED_INT_24_8;
+			break;
+		case GL_RGBA16F:
+		case GL_RGBA32F:
+			format = GL_RGBA;
+			type = GL_FLOAT;
+			break;
+		case GL_R11F_G11F_B10F:
+		case GL_RGB16F:
+			format = GL_RGB;
+			type = GL_FLOAT;
+			break;
+		case GL_R32UI:
+			format = GL_RED_INTEGER;
+			type = GL_UNSIGNED_INT;
+			break;
+		default:
+			format = GL_RGBA;
+			type = GL_UNSIGNED_BYTE;
+			break;
+		}
+	}
+
+	/***********************************************************
+	 *  IsDepthFormat()
+	 *
+	 *  This function is used for checking whether a render
+	 *  target internal format holds depth values.
+	 ***********************************************************/
+	bool IsDepthFormat(GLenum internalFormat)
+	{
+		return((internalFormat == GL_DEPTH_COMPONENT24) ||
+			(internalFormat == GL_DEPTH_COMPONENT32F) ||
+			(internalFormat == GL_DEPTH24_STENCIL8));
+	}
+}
+
+/***********************************************************
+ *  FrameGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameGraph::FrameGraph()
+{
+	m_bCompiled = false;
+	m_outputWidth = 0;
+	m_outputHeight = 0;
+}
+
+/***********************************************************
+ *  ~FrameGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameGraph::~FrameGraph()
+{
+	DeleteFramebuffers();
+	for (size_t i = 0; i < m_targets.size(); i++)
+	{
+		DeleteTrackedTexture(m_targets[i].textureID);
+	}
+	m_targets.clear();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for removing the declared passes and
+ *  textures so that a different graph can be declared.  The
+ *  render targets are kept, so recompiling a graph with the
+ *  same textures does not create any new ones.
+ ***********************************************************/
+void FrameGraph::Reset()
+{
+	DeleteFramebuffers();
+	m_passes.clear();
+	m_textures.clear();
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  ImportBackbuffer()
+ *
+ *  This method is used for declaring the default framebuffer
+ *  as a texture of the graph.  The passes that write it are
+ *  the outputs of the graph, and are never dropped.
+ ***********************************************************/
+int FrameGraph::ImportBackbuffer()
+{
+	GRAPH_TEXTURE texture;
+
+	texture.name = "Backbuffer";
+	texture.internalFormat = GL_NONE;
+	texture.scale = 1.0f;
+	texture.samples = 1;
+	texture.bImported = true;
+	texture.bPersistent = false;
+	texture.width = 0;
+	texture.height = 0;
+	texture.firstPass = -1;
+	texture.lastPass = -1;
+	texture.targetIndex = -1;
+	m_textures.push_back(texture);
+	m_bCompiled = false;
+
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for declaring a transient texture.
+ *  Its size is the output size times the scale, and its
+ *  render target is only chosen when the graph is compiled.
+ *  A sample count above 1 makes a multisampled texture,
+ *  which has to be resolved before it can be sampled.
+ ***********************************************************/
+int FrameGraph::CreateTexture(const char* name, GLenum internalFormat, float scale, int samples)
+{
+	GRAPH_TEXTURE texture;
+
+	texture.name = name;
+	texture.internalFormat = internalFormat;
+	texture.scale = scale;
+	texture.samples = std::max(samples, 1);
+	texture.bImported = false;
+	texture.bPersistent = false;
+	texture.width = 0;
+	texture.height = 0;
+	texture.firstPass = -1;
+	texture.lastPass = -1;
+	texture.targetIndex = -1;
+	m_textures.push_back(texture);
+	m_bCompiled = false;
+
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  CreatePersistentTexture()
+ *
+ *  This method is used for declaring a texture that keeps
+ *  its contents until the next frame.  Its render target is
+ *  never shared, and a pass that writes it is never dropped.
+ *  The contents are undefined after the graph is compiled.
+ ***********************************************************/
+int FrameGraph::CreatePersistentTexture(const char* name, GLenum internalFormat, float scale)
+{
+	int texture = CreateTexture(name, internalFormat, scale);
+	m_textures[texture].bPersistent = true;
+
+	return texture;
+}
+
+/***********************************************************
+ *  AddPass()
+ *
+ *  This method is used for declaring a render pass.  The
+ *  passes run in the order they are added, and the function
+ *  is called with the framebuffer, viewport and inputs of
+ *  the pass already bound.
+ ***********************************************************/
+int FrameGraph::AddPass(const char* name, std::function<void()> execute)
+{
+	RENDER_PASS pass;
+
+	pass.name = name;
+	pass.execute = std::move(execute);
+	pass.depthOutput.texture = -1;
+	pass.depthOutput.bClear = false;
+	pass.depthOutput.clearColor = glm::vec4(0.0f);
+	pass.bResolve = false;
+	pass.bLive = false;
+	pass.framebufferID = 0;
+	pass.readFramebufferID = 0;
+	pass.width = 0;
+	pass.height = 0;
+	m_passes.push_back(std::move(pass));
+	m_bCompiled = false;
+
+	return((int)m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  ReadTexture()
+ *
+ *  This method is used for declaring a texture that a pass
+ *  samples.  The inputs are bound to consecutive texture
+ *  units starting at INPUT_TEXTURE_UNIT.
+ ***********************************************************/
+void FrameGraph::ReadTexture(int pass, int texture)
+{
+	if ((pass < 0) || (pass >= (int)m_passes.size()) ||
+		(texture < 0) || (texture >= (int)m_textures.size()) ||
+		IsBackbuffer(texture))
+	{
+		std::cout << "ERROR: Frame graph pass " << pass << " cannot read texture " << texture << std::endl;
+		return;
+	}
+
+	m_passes[pass].inputs.push_back(texture);
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  WriteColor()
+ *
+ *  This method is used for declaring a color attachment of
+ *  a pass, which is cleared before the pass if requested.
+ ***********************************************************/
+void FrameGraph::WriteColor(int pass, int texture, bool bClear, glm::vec4 clearColor)
+{
+	if ((pass < 0) || (pass >= (int)m_passes.size()) ||
+		(texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		std::cout << "ERROR: Frame graph pass " << pass << " cannot write texture " << texture << std::endl;
+		return;
+	}
+
+	PASS_ATTACHMENT attachment;
+	attachment.texture = texture;
+	attachment.bClear = bClear;
+	attachment.clearColor = clearColor;
+	m_passes[pass].colorOutputs.push_back(attachment);
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  WriteDepth()
+ *
+ *  This method is used for declaring the depth attachment
+ *  of a pass, which is cleared before the pass if requested.
+ ***********************************************************/
+void FrameGraph::WriteDepth(int pass, int texture, bool bClear)
+{
+	if ((pass < 0) || (pass >= (int)m_passes.size()) ||
+		(texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		std::cout << "ERROR: Frame graph pass " << pass << " cannot write texture " << texture << std::endl;
+		return;
+	}
+
+	m_passes[pass].depthOutput.texture = texture;
+	m_passes[pass].depthOutput.bClear = bClear;
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  AddResolvePass()
+ *
+ *  This method is used for declaring a pass that copies a
+ *  color texture into another texture or the backbuffer.
+ *  A multisampled source is resolved to one sample per pixel
+ *  and needs a destination of the same size, while other
+ *  sources are scaled to the destination with filtering.
+ ***********************************************************/
+int FrameGraph::AddResolvePass(const char* name, int source, int destination)
+{
+	int pass = AddPass(name, nullptr);
+	m_passes[pass].bResolve = true;
+	ReadTexture(pass, source);
+	WriteColor(pass, destination);
+
+	return pass;
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for preparing the declared passes to
+ *  render at an output size.  This creates OpenGL objects,
+ *  so it is only done when the graph or the size changes,
+ *  and never while drawing a steady stream of frames.
+ ***********************************************************/
+bool FrameGraph::Compile(int width, int height)
+{
+	DeleteFramebuffers();
+	m_bCompiled = false;
+	m_outputWidth = width;
+	m_outputHeight = height;
+
+	CullPasses();
+	if (false == AssignRenderTargets(width, height))
+	{
+		return false;
+	}
+	if (false == CreateFramebuffers())
+	{
+		DeleteFramebuffers();
+		return false;
+	}
+
+	m_bCompiled = true;
+	return true;
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for running the live passes of the
+ *  compiled graph in order.  OpenGL orders the sampling of
+ *  a texture after the rendering into it by earlier passes,
+ *  so the passes only need their own targets bound.
+ ***********************************************************/
+void FrameGraph::Execute()
+{
+	if (false == m_bCompiled)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		RENDER_PASS& pass = m_passes[i];
+		if (false == pass.bLive)
+		{
+			continue;
+		}
+
+		if (pass.bResolve)
+		{
+			const GRAPH_TEXTURE& source = m_textures[pass.inputs[0]];
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, pass.readFramebufferID);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pass.framebufferID);
+			GLenum filter = ((source.width == pass.width) && (source.height == pass.height)) ? GL_NEAREST : GL_LINEAR;
+			glBlitFramebuffer(0, 0, source.width, source.height, 0, 0, pass.width, pass.height, GL_COLOR_BUFFER_BIT, filter);
+
+			// the multisampled source is not needed after it is resolved
+			if ((source.lastPass == (int)i) && GLEW_VERSION_4_3)
+			{
+				GLenum attachment = GL_COLOR_ATTACHMENT0;
+				glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 1, &attachment);
+			}
+			continue;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, pass.framebufferID);
+		glViewport(0, 0, pass.width, pass.height);
+
+		// clear the attachments that the pass asked for
+		for (size_t j = 0; j < pass.colorOutputs.size(); j++)
+		{
+			if (pass.colorOutputs[j].bClear)
+			{
+				glClearBufferfv(GL_COLOR, (GLint)j, glm::value_ptr(pass.colorOutputs[j].clearColor));
+			}
+		}
+		if ((pass.depthOutput.texture >= 0) && pass.depthOutput.bClear)
+		{
+			GLfloat clearDepth = 1.0f;
+			glDepthMask(GL_TRUE);
+			glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+		}
+
+		// bind the inputs above the texture units of the scene
+		for (size_t j = 0; j < pass.inputs.size(); j++)
+		{
+			glActiveTexture(GL_TEXTURE0 + INPUT_TEXTURE_UNIT + (GLenum)j);
+			glBindTexture(GetTextureTarget(pass.inputs[j]), GetTextureID(pass.inputs[j]));
+		}
+		glActiveTexture(GL_TEXTURE0);
+
+		pass.execute();
+
+		// attachments that are not read again do not need to be
+		// kept, such as the depth of the scene after it is drawn
+		if ((false == pass.discardAttachments.empty()) && GLEW_VERSION_4_3)
+		{
+			glInvalidateFramebuffer(GL_FRAMEBUFFER, (GLsizei)pass.discardAttachments.size(), pass.discardAttachments.data());
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  GetTextureWidth()
+ *
+ *  This method is used for getting the width in pixels of
+ *  a texture in the compiled graph.
+ ***********************************************************/
+int FrameGraph::GetTextureWidth(int texture) const
+{
+	return m_textures[texture].width;
+}
+
+/***********************************************************
+ *  GetTextureHeight()
+ *
+ *  This method is used for getting the height in pixels of
+ *  a texture in the compiled graph.
+ ***********************************************************/
+int FrameGraph::GetTextureHeight(int texture) const
+{
+	return m_textures[texture].height;
+}
+
+/***********************************************************
+ *  CullPasses()
+ *
+ *  This method is used for finding the passes whose results
+ *  are needed.  Walking back from the last pass, a pass is
+ *  live if it writes the default framebuffer, a persistent
+ *  texture, or a texture that a later live pass reads.
+ ***********************************************************/
+void FrameGraph::CullPasses()
+{
+	std::vector<bool> bTextureNeeded(m_textures.size(), false);
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		bTextureNeeded[i] = m_textures[i].bImported || m_textures[i].bPersistent;
+	}
+
+	for (int i = (int)m_passes.size() - 1; i >= 0; i--)
+	{
+		RENDER_PASS& pass = m_passes[i];
+		pass.bLive = false;
+
+		for (size_t j = 0; j < pass.colorOutputs.size(); j++)
+		{
+			int texture = pass.colorOutputs[j].texture;
+			if (bTextureNeeded[texture])
+			{
+				pass.bLive = true;
+			}
+		}
+		int depthTexture = pass.depthOutput.texture;
+		if ((depthTexture >= 0) && bTextureNeeded[depthTexture])
+		{
+			pass.bLive = true;
+		}
+
+		if (pass.bLive)
+		{
+			for (size_t j = 0; j < pass.inputs.size(); j++)
+			{
+				bTextureNeeded[pass.inputs[j]] = true;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  AssignRenderTargets()
+ *
+ *  This method is used for giving each transient texture a
+ *  render target.  A target is shared by textures with the
+ *  same format and size when the first texture is no longer
+ *  used by the time the next one is first written, and the
+ *  targets from the previous compile are reused before any
+ *  new ones are created.
+ ***********************************************************/
+bool FrameGraph::AssignRenderTargets(int width, int height)
+{
+	// find the first and last live pass that uses each texture
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		GRAPH_TEXTURE& texture = m_textures[i];
+		texture.firstPass = -1;
+		texture.lastPass = -1;
+		texture.targetIndex = -1;
+		texture.width = texture.bImported ? width : std::max(1, (int)(width * texture.scale + 0.5f));
+		texture.height = texture.bImported ? height : std::max(1, (int)(height * texture.scale + 0.5f));
+	}
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		const RENDER_PASS& pass = m_passes[i];
+		if (false == pass.bLive)
+		{
+			continue;
+		}
+
+		auto markUse = [this, i](int textureIndex)
+		{
+			GRAPH_TEXTURE& texture = m_textures[textureIndex];
+			if (texture.firstPass < 0)
+			{
+				texture.firstPass = i;
+			}
+			texture.lastPass = i;
+		};
+		for (size_t j = 0; j < pass.inputs.size(); j++)
+		{
+			markUse(pass.inputs[j]);
+		}
+		for (size_t j = 0; j < pass.colorOutputs.size(); j++)
+		{
+			markUse(pass.colorOutputs[j].texture);
+		}
+		if (pass.depthOutput.texture >= 0)
+		{
+			markUse(pass.depthOutput.texture);
+		}
+	}
+
+	// persistent textures hold their contents from the first pass
+	// of one frame to the last pass of the next
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].bPersistent && (m_textures[i].firstPass >= 0))
+		{
+			m_textures[i].firstPass = 0;
+			m_textures[i].lastPass = INT_MAX;
+		}
+	}
+
+	// the textures are placed in the order they are first used
+	std::vector<int> textureOrder;
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if ((false == m_textures[i].bImported) && (m_textures[i].firstPass >= 0))
+		{
+			textureOrder.push_back((int)i);
+		}
+	}
+	std::sort(textureOrder.begin(), textureOrder.end(),
+		[this](int a, int b) { return m_textures[a].firstPass < m_textures[b].firstPass; });
+
+	for (size_t i = 0; i < m_targets.size(); i++)
+	{
+		m_targets[i].bUsed = false;
+		m_targets[i].lastPass = -1;
+	}
+
+	for (size_t i = 0; i < textureOrder.size(); i++)
+	{
+		GRAPH_TEXTURE& texture = m_textures[textureOrder[i]];
+
+		int targetIndex = -1;
+		for (size_t j = 0; j < m_targets.size(); j++)
+		{
+			const RENDER_TARGET& target = m_targets[j];
+			if ((target.internalFormat == texture.internalFormat) &&
+				(target.width == texture.width) &&
+				(target.height == texture.height) &&
+				(target.samples == texture.samples) &&
+				((false == target.bUsed) || (target.lastPass < texture.firstPass)))
+			{
+				targetIndex = (int)j;
+				break;
+			}
+		}
+
+		if (targetIndex < 0)
+		{
+			RENDER_TARGET target;
+			GLenum format;
+			GLenum type;
+			GLint filter = IsDepthFormat(texture.internalFormat) ? GL_NEAREST : GL_LINEAR;
+
+			GetPixelFormat(texture.internalFormat, format, type);
+			target.internalFormat = texture.internalFormat;
+			target.width = texture.width;
+			target.height = texture.height;
+			target.samples = texture.samples;
+			target.lastPass = -1;
+			target.bUsed = false;
+
+			target.textureID = GenTrackedTexture("frame graph target");
+			SetTrackedResourceSize(
+				GPU_RESOURCE_TEXTURE,
+				target.textureID,
+				GetTextureStorageSize(texture.internalFormat, texture.width, texture.height, texture.samples));
+			if (texture.samples > 1)
+			{
+				glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, target.textureID);
+				glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, texture.samples, texture.internalFormat, texture.width, texture.height, GL_TRUE);
+				glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+			}
+			else
+			{
+				glBindTexture(GL_TEXTURE_2D, target.textureID);
+				glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat, texture.width, texture.height, 0, format, type, NULL);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+
+			m_targets.push_back(target);
+			targetIndex = (int)m_targets.size() - 1;
+		}
+
+		m_targets[targetIndex].bUsed = true;
+		m_targets[targetIndex].lastPass = texture.lastPass;
+		texture.targetIndex = targetIndex;
+	}
+
+	// free the targets that this graph does not need, and move
+	// the remaining ones down over them
+	std::vector<int> targetRemap(m_targets.size(), -1);
+	size_t keptCount = 0;
+	for (size_t i = 0; i < m_targets.size(); i++)
+	{
+		if (m_targets[i].bUsed)
+		{
+			targetRemap[i] = (int)keptCount;
+			m_targets[keptCount++] = m_targets[i];
+		}
+		else
+		{
+			DeleteTrackedTexture(m_targets[i].textureID);
+		}
+	}
+	m_targets.resize(keptCount);
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].targetIndex >= 0)
+		{
+			m_textures[i].targetIndex = targetRemap[m_textures[i].targetIndex];
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  CreateFramebuffers()
+ *
+ *  This method is used for creating the framebuffer of each
+ *  live pass with its attachments, and for finding the
+ *  attachments that can be discarded after the pass.
+ ***********************************************************/
+bool FrameGraph::CreateFramebuffers()
+{
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		RENDER_PASS& pass = m_passes[i];
+		pass.discardAttachments.clear();
+		if (false == pass.bLive)
+		{
+			continue;
+		}
+
+		// a pass either writes the default framebuffer or textures
+		bool bBackbuffer = false;
+		bool bTextures = false;
+		for (size_t j = 0; j < pass.colorOutputs.size(); j++)
+		{
+			(IsBackbuffer(pass.colorOutputs[j].texture) ? bBackbuffer : bTextures) = true;
+		}
+		if (pass.depthOutput.texture >= 0)
+		{
+			(IsBackbuffer(pass.depthOutput.texture) ? bBackbuffer : bTextures) = true;
+		}
+		if (bBackbuffer && bTextures)
+		{
+			std::cout << "ERROR: Frame graph pass " << pass.name << " mixes the backbuffer with textures" << std::endl;
+			return false;
+		}
+
+		// a resolve pass reads its source through a second framebuffer
+		if (pass.bResolve)
+		{
+			int source = pass.inputs[0];
+			glGenFramebuffers(1, &pass.readFramebufferID);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, pass.readFramebufferID);
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GetTextureTarget(source), GetTextureID(source), 0);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			GLenum status = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			if (status != GL_FRAMEBUFFER_COMPLETE)
+			{
+				std::cout << "ERROR: Frame graph pass " << pass.name << " source framebuffer is incomplete (" << status << ")" << std::endl;
+				return false;
+			}
+		}
+
+		if (bBackbuffer || (false == bTextures))
+		{
+			pass.framebufferID = 0;
+			pass.width = m_outputWidth;
+			pass.height = m_outputHeight;
+			continue;
+		}
+
+		glGenFramebuffers(1, &pass.framebufferID);
+		glBindFramebuffer(GL_FRAMEBUFFER, pass.framebufferID);
+
+		GLenum drawBuffers[8];
+		GLsizei drawBufferCount = 0;
+		for (size_t j = 0; (j < pass.colorOutputs.size()) && (j < 8); j++)
+		{
+			const GRAPH_TEXTURE& texture = m_textures[pass.colorOutputs[j].texture];
+			GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)j;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GetTextureTarget(pass.colorOutputs[j].texture), GetTextureID(pass.colorOutputs[j].texture), 0);
+			drawBuffers[drawBufferCount++] = attachment;
+			pass.width = texture.width;
+			pass.height = texture.height;
+			if (texture.lastPass == i)
+			{
+				pass.discardAttachments.push_back(attachment);
+			}
+		}
+		if (pass.depthOutput.texture >= 0)
+		{
+			const GRAPH_TEXTURE& texture = m_textures[pass.depthOutput.texture];
+			GLenum attachment = (texture.internalFormat == GL_DEPTH24_STENCIL8) ?
+				GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GetTextureTarget(pass.depthOutput.texture), GetTextureID(pass.depthOutput.texture), 0);
+			if (0 == drawBufferCount)
+			{
+				pass.width = texture.width;
+				pass.height = texture.height;
+			}
+			if (texture.lastPass == i)
+			{
+				pass.discardAttachments.push_back(attachment);
+			}
+		}
+
+		if (drawBufferCount > 0)
+		{
+			glDrawBuffers(drawBufferCount, drawBuffers);
+		}
+		else
+		{
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR: Frame graph pass " << pass.name << " framebuffer is incomplete (" << status << ")" << std::endl;
+			return false;
+		}
+
+		// sampling a texture that the pass is drawing into is
+		// undefined, which can only happen if it is declared
+		for (size_t j = 0; j < pass.inputs.size(); j++)
+		{
+			int targetIndex = m_textures[pass.inputs[j]].targetIndex;
+			for (size_t k = 0; k < pass.colorOutputs.size(); k++)
+			{
+				if (targetIndex == m_textures[pass.colorOutputs[k].texture].targetIndex)
+				{
+					std::cout << "ERROR: Frame graph pass " << pass.name << " reads and writes " << m_textures[pass.inputs[j]].name << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  DeleteFramebuffers()
+ *
+ *  This method is used for freeing the framebuffers that
+ *  were created for the passes.
+ ***********************************************************/
+void FrameGraph::DeleteFramebuffers()
+{
+	for (size_t i = 0; i < m_passes.size(); i++)
+	{
+		if (0 != m_passes[i].framebufferID)
+		{
+			glDeleteFramebuffers(1, &m_passes[i].framebufferID);
+			m_passes[i].framebufferID = 0;
+		}
+		if (0 != m_passes[i].readFramebufferID)
+		{
+			glDeleteFramebuffers(1, &m_passes[i].readFramebufferID);
+			m_passes[i].readFramebufferID = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the OpenGL texture that
+ *  holds a graph texture in the compiled graph.
+ ***********************************************************/
+GLuint FrameGraph::GetTextureID(int texture) const
+{
+	int targetIndex = m_textures[texture].targetIndex;
+	if (targetIndex < 0)
+	{
+		return 0;
+	}
+
+	return m_targets[targetIndex].textureID;
+}
+
+/***********************************************************
+ *  GetTextureTarget()
+ *
+ *  This method is used for getting the texture target that
+ *  the render target of a graph texture is bound to.
+ ***********************************************************/
+GLenum FrameGraph::GetTextureTarget(int texture) const
+{
+	return (m_textures[texture].samples > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+}
+
+/***********************************************************
+ *  IsBackbuffer()
+ *
+ *  This method is used for checking whether a texture handle
+ *  names the imported default framebuffer.
+ ***********************************************************/
+bool FrameGraph::IsBackbuffer(int texture) const
+{
+	return m_textures[texture].bImported;
+}
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// framegraph.h
+// ============
+// declare the render passes of a frame with the textures they
+// read and write, and run them with automatically managed
+// render targets
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameGraph
+ *
+ *  This class runs a list of render passes that declare the
+ *  textures they read and the attachments they write.  When
+ *  the graph is compiled, passes whose results are never
+ *  used are dropped, the transient textures are given
+ *  render targets that are shared between textures whose
+ *  lifetimes do not overlap, and a framebuffer is created
+ *  for each pass.  Running the compiled graph only binds
+ *  what was prepared, clears the declared attachments and
+ *  discards attachments that are not read again.
+ ***********************************************************/
+class FrameGraph
+{
+public:
+	// the texture unit of the first input of a pass - the
+	// units below it are left to the scene textures
+	static const int INPUT_TEXTURE_UNIT = 16;
+
+	// constructor
+	FrameGraph();
+	// destructor
+	~FrameGraph();
+
+	// remove the declared passes and textures, keeping the
+	// render targets for reuse by the next compile
+	void Reset();
+
+	// declare the default framebuffer, which is both the color
+	// and the depth attachment of the passes that write it
+	int ImportBackbuffer();
+	// declare a transient texture with a size relative to the
+	// output size - returns the texture handle
+	int CreateTexture(const char* name, GLenum internalFormat, float scale = 1.0f, int samples = 1);
+	// declare a texture whose contents are kept from one frame
+	// to the next, such as a history for temporal effects
+	int CreatePersistentTexture(const char* name, GLenum internalFormat, float scale = 1.0f);
+
+	// declare a pass that runs the function with its attachments
+	// bound - returns the pass handle
+	int AddPass(const char* name, std::function<void()> execute);
+	// declare a texture that a pass samples, which is bound to
+	// the next input texture unit of the pass
+	void ReadTexture(int pass, int texture);
+	// declare a color attachment of a pass, optionally cleared
+	void WriteColor(int pass, int texture, bool bClear = false, glm::vec4 clearColor = glm::vec4(0.0f));
+	// declare the depth attachment of a pass, optionally cleared
+	void WriteDepth(int pass, int texture, bool bClear = false);
+	// declare a pass that copies one color texture into another,
+	// resolving multisampled textures and scaling the others
+	int AddResolvePass(const char* name, int source, int destination);
+
+	// prepare the declared passes for an output size
+	bool Compile(int width, int height);
+	// run the compiled passes
+	void Execute();
+
+	// get the size of a texture in the compiled graph
+	int GetTextureWidth(int texture) const;
+	int GetTextureHeight(int texture) const;
+
+private:
+	// a texture declared by the passes
+	struct GRAPH_TEXTURE
+	{
+		std::string name;
+		GLenum internalFormat;
+		float scale;
+		int samples;
+		// true for the default framebuffer
+		bool bImported;
+		// true when the contents are kept between frames
+		bool bPersistent;
+		// size of the texture in the compiled graph
+		int width;
+		int height;
+		// first and last live pass that uses the texture
+		int firstPass;
+		int lastPass;
+		// render target that holds the texture
+		int targetIndex;
+	};
+
+	// an attachment written by a pass
+	struct PASS_ATTACHMENT
+	{
+		int texture;
+		bool bClear;
+		glm::vec4 clearColor;
+	};
+
+	// a declared render pass
+	struct RENDER_PASS
+	{
+		std::string name;
+		std::function<void()> execute;
+		std::vector<int> inputs;
+		std::vector<PASS_ATTACHMENT> colorOutputs;
+		PASS_ATTACHMENT depthOutput;
+		// true for a pass that copies its input into its output
+		bool bResolve;
+		// true when the results of the pass are used
+		bool bLive;
+		// framebuffer and size of the attachments, and the
+		// framebuffer that a resolve pass reads from
+		GLuint framebufferID;
+		GLuint readFramebufferID;
+		int width;
+		int height;
+		// attachments that are not read after the pass
+		std::vector<GLenum> discardAttachments;
+	};
+
+	// an OpenGL texture that holds one or more graph textures
+	struct RENDER_TARGET
+	{
+		GLenum internalFormat;
+		int width;
+		int height;
+		int samples;
+		GLuint textureID;
+		// last pass of the textures held so far this compile
+		int lastPass;
+		bool bUsed;
+	};
+
+	std::vector<GRAPH_TEXTURE> m_textures;
+	std::vector<RENDER_PASS> m_passes;
+	std::vector<RENDER_TARGET> m_targets;
+	// size of the default framebuffer
+	int m_outputWidth;
+	int m_outputHeight;
+	// true once the declared passes have been compiled
+	bool m_bCompiled;
+
+	// mark the passes whose results reach the default framebuffer
+	void CullPasses();
+	// give each transient texture a render target
+	bool AssignRenderTargets(int width, int height);
+	// create the framebuffer of each live pass
+	bool CreateFramebuffers();
+	// free the framebuffers of the passes
+	void DeleteFramebuffers();
+	// get the OpenGL texture holding a graph texture, and the
+	// texture target it is bound to
+	GLuint GetTextureID(int texture) const;
+	GLenum GetTextureTarget(int texture) const;
+	// check whether a texture handle names the default framebuffer
+	bool IsBackbuffer(int texture) const;
+};
@@ -0,0 +1,837 @@
+///////////////////////////////////////////////////////////////////////////////
+// glcapture.cpp
+// ============
+// record the OpenGL commands of a frame, with their uniform, buffer
+// and texture data, to a binary file that can be replayed offline
+///////////////////////////////////////////////////////////////////////////////
+
+#define GL_CAPTURE_IMPLEMENTATION
+#include "GLCapture.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// names of the commands for reports, in the order of the
+	// command values
+	const char* const g_CommandNames[GL_CAPTURE_COMMAND_COUNT] =
+	{
+		"FrameBegin", "End",
+		"glGenBuffers", "glDeleteBuffers", "glGenVertexArrays", "glDeleteVertexArrays",
+		"glGenTextures", "glDeleteTextures", "glGenFramebuffers", "glDeleteFramebuffers",
+		"glGenRenderbuffers", "glDeleteRenderbuffers", "glCreateShader", "glDeleteShader",
+		"glShaderSource", "glCompileShader", "glCreateProgram", "glDeleteProgram",
+		"glAttachShader", "glLinkProgram", "glProgramParameteri", "glProgramBinary",
+		"glGetUniformLocation", "glGetUniformBlockIndex", "glUniformBlockBinding",
+		"glUseProgram", "glBindVertexArray", "glBindBuffer", "glBindBufferBase",
+		"glBindBufferRange", "glActiveTexture", "glBindTexture", "glBindImageTexture",
+		"glBindFramebuffer", "glBindRenderbuffer", "glEnable", "glDisable", "glDepthMask",
+		"glDepthFunc", "glBlendFunc", "glColorMask", "glViewport", "glScissor",
+		"glClearColor", "glPixelStorei", "glDrawBuffer", "glDrawBuffers", "glReadBuffer",
+		"glBufferData", "glBufferSubData", "glCopyBufferSubData", "glTexImage2D",
+		"glTexSubImage2D", "glTexStorage2D", "glTexImage2DMultisample", "glTexParameteri",
+		"glRenderbufferStorage", "glFramebufferTexture2D", "glFramebufferRenderbuffer",
+		"glVertexAttribPointer", "glEnableVertexAttribArray",
+		"glUniform1i", "glUniform1ui", "glUniform1f", "glUniform2f", "glUniform3f",
+		"glUniform4f", "glUniform1fv", "glUniform2fv", "glUniform3fv", "glUniform4fv",
+		"glUniformMatrix2fv", "glUniformMatrix3fv", "glUniformMatrix4fv",
+		"glClear", "glClearBufferfv", "glClearBufferuiv", "glDrawArrays", "glDrawElements",
+		"glDrawElementsIndirect", "glMultiDrawElementsIndirect", "glDispatchCompute",
+		"glMemoryBarrier", "glBlitFramebuffer", "glInvalidateFramebuffer"
+	};
+
+	// byte in the file header where the size of the window is
+	// written once the frame has been captured
+	const long FRAMEBUFFER_SIZE_OFFSET = 8;
+
+	// the file being recorded to, or NULL when not capturing
+	FILE* g_pCaptureFile = NULL;
+	// the frame that the draws are recorded for, and the frame
+	// being drawn
+	int g_CaptureFrame = 0;
+	int g_CurrentFrame = 0;
+	// the unpack state that sets the size of texture uploads
+	GLint g_UnpackAlignment = 4;
+	GLint g_UnpackRowLength = 0;
+
+	// data that follows a command, or NULL for none
+	struct CAPTURE_DATA
+	{
+		const void* pData;
+		size_t size;
+	};
+
+	/***********************************************************
+	 *  BeginCommand()
+	 *
+	 *  This function is used for writing the value of a command
+	 *  when it is recorded.  The commands that do work are
+	 *  left out of the frames before the captured one, since
+	 *  only the objects they leave behind are replayed.
+	 ***********************************************************/
+	bool BeginCommand(GL_CAPTURE_COMMAND command)
+	{
+		if (NULL == g_pCaptureFile)
+		{
+			return false;
+		}
+		if ((command >= GL_CAPTURE_CLEAR) && (g_CurrentFrame != g_CaptureFrame))
+		{
+			return false;
+		}
+
+		uint8_t value = (uint8_t)command;
+		fwrite(&value, sizeof(value), 1, g_pCaptureFile);
+		return true;
+	}
+
+	// write a value of a command
+	template <typename T>
+	void WriteValue(T value)
+	{
+		fwrite(&value, sizeof(T), 1, g_pCaptureFile);
+	}
+
+	// write the data of a command with its size in front, where a
+	// size of all ones stands for no data
+	void WriteValue(CAPTURE_DATA data)
+	{
+		uint32_t size = (NULL != data.pData) ? (uint32_t)data.size : 0xFFFFFFFF;
+		fwrite(&size, sizeof(size), 1, g_pCaptureFile);
+		if (NULL != data.pData)
+		{
+			fwrite(data.pData, 1, data.size, g_pCaptureFile);
+		}
+	}
+
+	/***********************************************************
+	 *  RecordCommand()
+	 *
+	 *  This function is used for recording a command and its
+	 *  values while capturing.  Sizes and offsets are stored
+	 *  as 64 bit values so the files do not depend on the
+	 *  pointer size.
+	 ***********************************************************/
+	template <typename... VALUES>
+	void RecordCommand(GL_CAPTURE_COMMAND command, VALUES... values)
+	{
+		if (BeginCommand(command))
+		{
+			(WriteValue(values), ...);
+		}
+	}
+
+	// get a pointer or size as a 64 bit value for recording
+	int64_t ToInt64(const void* pointer)
+	{
+		return (int64_t)(intptr_t)pointer;
+	}
+
+	/***********************************************************
+	 *  GetPixelSize()
+	 *
+	 *  This function is used for getting the bytes of one pixel
+	 *  of client image data in a format and type.
+	 ***********************************************************/
+	size_t GetPixelSize(GLenum format, GLenum type)
+	{
+		if (type == GL_UNSIGNED_INT_24_8)
+		{
+			return 4;
+		}
+
+		size_t components = 4;
+		switch (format)
+		{
+		case GL_RED:
+		case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT:
+		case GL_STENCIL_INDEX:
+			components = 1;
+			break;
+		case GL_RG:
+		case GL_RG_INTEGER:
+			components = 2;
+			break;
+		case GL_RGB:
+		case GL_BGR:
+		case GL_RGB_INTEGER:
+			components = 3;
+			break;
+		}
+
+		size_t componentSize = 1;
+		switch (type)
+		{
+		case GL_UNSIGNED_SHORT:
+		case GL_SHORT:
+		case GL_HALF_FLOAT:
+			componentSize = 2;
+			break;
+		case GL_UNSIGNED_INT:
+		case GL_INT:
+		case GL_FLOAT:
+			componentSize = 4;
+			break;
+		}
+
+		return components * componentSize;
+	}
+
+	/***********************************************************
+	 *  GetImageData()
+	 *
+	 *  This function is used for getting the client data of a
+	 *  texture upload, following the unpack row length and
+	 *  alignment so the rows are replayed with the same state.
+	 ***********************************************************/
+	CAPTURE_DATA GetImageData(GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		CAPTURE_DATA data = { pixels, 0 };
+		if ((NULL == pixels) || (width <= 0) || (height <= 0))
+		{
+			return data;
+		}
+
+		size_t pixelSize = GetPixelSize(format, type);
+		size_t rowPixels = (g_UnpackRowLength > 0) ? (size_t)g_UnpackRowLength : (size_t)width;
+		size_t alignment = (size_t)g_UnpackAlignment;
+		size_t rowSize = (rowPixels * pixelSize + alignment - 1) / alignment * alignment;
+		data.size = rowSize * (size_t)(height - 1) + (size_t)width * pixelSize;
+
+		return data;
+	}
+}
+
+/***********************************************************
+ *  StartGLCapture()
+ *
+ *  This function is used for opening the capture file and
+ *  recording from now on.  The first frame is always drawn
+ *  before the captured one, so the draws find the objects
+ *  and texture levels that they use.
+ ***********************************************************/
+bool StartGLCapture(const char* filename, int frameIndex)
+{
+	if ((NULL != g_pCaptureFile) || (NULL == filename))
+	{
+		return false;
+	}
+
+	g_pCaptureFile = fopen(filename, "wb");
+	if (NULL == g_pCaptureFile)
+	{
+		std::cout << "ERROR: Could not write GL capture:" << filename << std::endl;
+		return false;
+	}
+
+	// the size of the window is filled in after the frame
+	WriteValue(GL_CAPTURE_MAGIC);
+	WriteValue(GL_CAPTURE_VERSION);
+	WriteValue((int32_t)0);
+	WriteValue((int32_t)0);
+
+	g_CaptureFrame = (frameIndex > 1) ? frameIndex : 1;
+	g_CurrentFrame = 0;
+	std::cout << "INFO: Capturing the GL commands of frame " << g_CaptureFrame << " to " << filename << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  EndGLCaptureFrame()
+ *
+ *  This function is used for marking the end of a frame.
+ *  The start of the captured frame is marked in the file,
+ *  and the file is finished after it.
+ ***********************************************************/
+void EndGLCaptureFrame(int framebufferWidth, int framebufferHeight)
+{
+	if (NULL == g_pCaptureFile)
+	{
+		return;
+	}
+
+	if (g_CurrentFrame != g_CaptureFrame)
+	{
+		g_CurrentFrame++;
+		if (g_CurrentFrame == g_CaptureFrame)
+		{
+			RecordCommand(GL_CAPTURE_FRAME_BEGIN);
+		}
+		return;
+	}
+
+	RecordCommand(GL_CAPTURE_END);
+	long fileSize = ftell(g_pCaptureFile);
+	fseek(g_pCaptureFile, FRAMEBUFFER_SIZE_OFFSET, SEEK_SET);
+	WriteValue((int32_t)framebufferWidth);
+	WriteValue((int32_t)framebufferHeight);
+	fclose(g_pCaptureFile);
+	g_pCaptureFile = NULL;
+
+	std::cout << "INFO: Captured the GL commands of frame " << g_CaptureFrame << " in " << fileSize << " bytes" << std::endl;
+}
+
+/***********************************************************
+ *  IsGLCaptureActive()
+ *
+ *  This function is used for checking whether commands are
+ *  being recorded.
+ ***********************************************************/
+bool IsGLCaptureActive()
+{
+	return (NULL != g_pCaptureFile);
+}
+
+/***********************************************************
+ *  GetGLCaptureCommandName()
+ *
+ *  This function is used for getting the name of a command
+ *  for reports.
+ ***********************************************************/
+const char* GetGLCaptureCommandName(int command)
+{
+	if ((command < 0) || (command >= GL_CAPTURE_COMMAND_COUNT))
+	{
+		return "Unknown";
+	}
+	return g_CommandNames[command];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// the recording versions of the OpenGL functions - object names are
+// recorded as they were created so the replay can map them to its
+// own, and uniform locations are recorded with the lookups
+///////////////////////////////////////////////////////////////////////////////
+
+void CaptureGenBuffers(GLsizei n, GLuint* buffers)
+{
+	glGenBuffers(n, buffers);
+	RecordCommand(GL_CAPTURE_GEN_BUFFERS, CAPTURE_DATA{ buffers, n * sizeof(GLuint) });
+}
+
+void CaptureDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	glDeleteBuffers(n, buffers);
+	RecordCommand(GL_CAPTURE_DELETE_BUFFERS, CAPTURE_DATA{ buffers, n * sizeof(GLuint) });
+}
+
+void CaptureGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	glGenVertexArrays(n, arrays);
+	RecordCommand(GL_CAPTURE_GEN_VERTEX_ARRAYS, CAPTURE_DATA{ arrays, n * sizeof(GLuint) });
+}
+
+void CaptureDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+	glDeleteVertexArrays(n, arrays);
+	RecordCommand(GL_CAPTURE_DELETE_VERTEX_ARRAYS, CAPTURE_DATA{ arrays, n * sizeof(GLuint) });
+}
+
+void CaptureGenTextures(GLsizei n, GLuint* textures)
+{
+	glGenTextures(n, textures);
+	RecordCommand(GL_CAPTURE_GEN_TEXTURES, CAPTURE_DATA{ textures, n * sizeof(GLuint) });
+}
+
+void CaptureDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	glDeleteTextures(n, textures);
+	RecordCommand(GL_CAPTURE_DELETE_TEXTURES, CAPTURE_DATA{ textures, n * sizeof(GLuint) });
+}
+
+void CaptureGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+	glGenFramebuffers(n, framebuffers);
+	RecordCommand(GL_CAPTURE_GEN_FRAMEBUFFERS, CAPTURE_DATA{ framebuffers, n * sizeof(GLuint) });
+}
+
+void CaptureDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+	glDeleteFramebuffers(n, framebuffers);
+	RecordCommand(GL_CAPTURE_DELETE_FRAMEBUFFERS, CAPTURE_DATA{ framebuffers, n * sizeof(GLuint) });
+}
+
+void CaptureGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+	glGenRenderbuffers(n, renderbuffers);
+	RecordCommand(GL_CAPTURE_GEN_RENDERBUFFERS, CAPTURE_DATA{ renderbuffers, n * sizeof(GLuint) });
+}
+
+void CaptureDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+	glDeleteRenderbuffers(n, renderbuffers);
+	RecordCommand(GL_CAPTURE_DELETE_RENDERBUFFERS, CAPTURE_DATA{ renderbuffers, n * sizeof(GLuint) });
+}
+
+GLuint CaptureCreateShader(GLenum type)
+{
+	GLuint shader = glCreateShader(type);
+	RecordCommand(GL_CAPTURE_CREATE_SHADER, type, shader);
+	return shader;
+}
+
+void CaptureDeleteShader(GLuint shader)
+{
+	glDeleteShader(shader);
+	RecordCommand(GL_CAPTURE_DELETE_SHADER, shader);
+}
+
+void CaptureShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+{
+	glShaderSource(shader, count, strings, lengths);
+	if (IsGLCaptureActive())
+	{
+		// the strings are joined so the replay passes one string
+		std::string source;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if ((NULL != lengths) && (lengths[i] >= 0))
+			{
+				source.append(strings[i], (size_t)lengths[i]);
+			}
+			else
+			{
+				source.append(strings[i]);
+			}
+		}
+		RecordCommand(GL_CAPTURE_SHADER_SOURCE, shader, CAPTURE_DATA{ source.c_str(), source.size() + 1 });
+	}
+}
+
+void CaptureCompileShader(GLuint shader)
+{
+	glCompileShader(shader);
+	RecordCommand(GL_CAPTURE_COMPILE_SHADER, shader);
+}
+
+GLuint CaptureCreateProgram()
+{
+	GLuint program = glCreateProgram();
+	RecordCommand(GL_CAPTURE_CREATE_PROGRAM, program);
+	return program;
+}
+
+void CaptureDeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+	RecordCommand(GL_CAPTURE_DELETE_PROGRAM, program);
+}
+
+void CaptureAttachShader(GLuint program, GLuint shader)
+{
+	glAttachShader(program, shader);
+	RecordCommand(GL_CAPTURE_ATTACH_SHADER, program, shader);
+}
+
+void CaptureLinkProgram(GLuint program)
+{
+	glLinkProgram(program);
+	RecordCommand(GL_CAPTURE_LINK_PROGRAM, program);
+}
+
+void CaptureProgramParameteri(GLuint program, GLenum pname, GLint value)
+{
+	glProgramParameteri(program, pname, value);
+	RecordCommand(GL_CAPTURE_PROGRAM_PARAMETER_I, program, pname, value);
+}
+
+void CaptureProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+{
+	glProgramBinary(program, binaryFormat, binary, length);
+	RecordCommand(GL_CAPTURE_PROGRAM_BINARY, program, binaryFormat, CAPTURE_DATA{ binary, (size_t)length });
+}
+
+GLint CaptureGetUniformLocation(GLuint program, const GLchar* name)
+{
+	GLint location = glGetUniformLocation(program, name);
+	RecordCommand(GL_CAPTURE_GET_UNIFORM_LOCATION, program, CAPTURE_DATA{ name, strlen(name) + 1 }, location);
+	return location;
+}
+
+GLuint CaptureGetUniformBlockIndex(GLuint program, const GLchar* name)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(program, name);
+	RecordCommand(GL_CAPTURE_GET_UNIFORM_BLOCK_INDEX, program, CAPTURE_DATA{ name, strlen(name) + 1 }, blockIndex);
+	return blockIndex;
+}
+
+void CaptureUniformBlockBinding(GLuint program, GLuint blockIndex, GLuint blockBinding)
+{
+	glUniformBlockBinding(program, blockIndex, blockBinding);
+	RecordCommand(GL_CAPTURE_UNIFORM_BLOCK_BINDING, program, blockIndex, blockBinding);
+}
+
+void CaptureUseProgram(GLuint program)
+{
+	glUseProgram(program);
+	RecordCommand(GL_CAPTURE_USE_PROGRAM, program);
+}
+
+void CaptureBindVertexArray(GLuint array)
+{
+	glBindVertexArray(array);
+	RecordCommand(GL_CAPTURE_BIND_VERTEX_ARRAY, array);
+}
+
+void CaptureBindBuffer(GLenum target, GLuint buffer)
+{
+	glBindBuffer(target, buffer);
+	RecordCommand(GL_CAPTURE_BIND_BUFFER, target, buffer);
+}
+
+void CaptureBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	glBindBufferBase(target, index, buffer);
+	RecordCommand(GL_CAPTURE_BIND_BUFFER_BASE, target, index, buffer);
+}
+
+void CaptureBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+	RecordCommand(GL_CAPTURE_BIND_BUFFER_RANGE, target, index, buffer, (int64_t)offset, (int64_t)size);
+}
+
+void CaptureActiveTexture(GLenum texture)
+{
+	glActiveTexture(texture);
+	RecordCommand(GL_CAPTURE_ACTIVE_TEXTURE, texture);
+}
+
+void CaptureBindTexture(GLenum target, GLuint texture)
+{
+	glBindTexture(target, texture);
+	RecordCommand(GL_CAPTURE_BIND_TEXTURE, target, texture);
+}
+
+void CaptureBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format)
+{
+	glBindImageTexture(unit, texture, level, layered, layer, access, format);
+	RecordCommand(GL_CAPTURE_BIND_IMAGE_TEXTURE, unit, texture, level, layered, layer, access, format);
+}
+
+void CaptureBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	glBindFramebuffer(target, framebuffer);
+	RecordCommand(GL_CAPTURE_BIND_FRAMEBUFFER, target, framebuffer);
+}
+
+void CaptureBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+	glBindRenderbuffer(target, renderbuffer);
+	RecordCommand(GL_CAPTURE_BIND_RENDERBUFFER, target, renderbuffer);
+}
+
+void CaptureEnable(GLenum cap)
+{
+	glEnable(cap);
+	RecordCommand(GL_CAPTURE_ENABLE, cap);
+}
+
+void CaptureDisable(GLenum cap)
+{
+	glDisable(cap);
+	RecordCommand(GL_CAPTURE_DISABLE, cap);
+}
+
+void CaptureDepthMask(GLboolean flag)
+{
+	glDepthMask(flag);
+	RecordCommand(GL_CAPTURE_DEPTH_MASK, flag);
+}
+
+void CaptureDepthFunc(GLenum func)
+{
+	glDepthFunc(func);
+	RecordCommand(GL_CAPTURE_DEPTH_FUNC, func);
+}
+
+void CaptureBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	glBlendFunc(sfactor, dfactor);
+	RecordCommand(GL_CAPTURE_BLEND_FUNC, sfactor, dfactor);
+}
+
+void CaptureColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+	glColorMask(red, green, blue, alpha);
+	RecordCommand(GL_CAPTURE_COLOR_MASK, red, green, blue, alpha);
+}
+
+void CaptureViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	glViewport(x, y, width, height);
+	RecordCommand(GL_CAPTURE_VIEWPORT, x, y, width, height);
+}
+
+void CaptureScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	glScissor(x, y, width, height);
+	RecordCommand(GL_CAPTURE_SCISSOR, x, y, width, height);
+}
+
+void CaptureClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	glClearColor(red, green, blue, alpha);
+	RecordCommand(GL_CAPTURE_CLEAR_COLOR, red, green, blue, alpha);
+}
+
+void CapturePixelStorei(GLenum pname, GLint param)
+{
+	glPixelStorei(pname, param);
+	if (pname == GL_UNPACK_ALIGNMENT)
+	{
+		g_UnpackAlignment = param;
+	}
+	else if (pname == GL_UNPACK_ROW_LENGTH)
+	{
+		g_UnpackRowLength = param;
+	}
+	RecordCommand(GL_CAPTURE_PIXEL_STORE_I, pname, param);
+}
+
+void CaptureDrawBuffer(GLenum buffer)
+{
+	glDrawBuffer(buffer);
+	RecordCommand(GL_CAPTURE_DRAW_BUFFER, buffer);
+}
+
+void CaptureDrawBuffers(GLsizei n, const GLenum* buffers)
+{
+	glDrawBuffers(n, buffers);
+	RecordCommand(GL_CAPTURE_DRAW_BUFFERS, CAPTURE_DATA{ buffers, n * sizeof(GLenum) });
+}
+
+void CaptureReadBuffer(GLenum source)
+{
+	glReadBuffer(source);
+	RecordCommand(GL_CAPTURE_READ_BUFFER, source);
+}
+
+void CaptureBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	glBufferData(target, size, data, usage);
+	RecordCommand(GL_CAPTURE_BUFFER_DATA, target, (int64_t)size, CAPTURE_DATA{ data, (size_t)size }, usage);
+}
+
+void CaptureBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	glBufferSubData(target, offset, size, data);
+	RecordCommand(GL_CAPTURE_BUFFER_SUB_DATA, target, (int64_t)offset, CAPTURE_DATA{ data, (size_t)size });
+}
+
+void CaptureCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+{
+	glCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+	RecordCommand(GL_CAPTURE_COPY_BUFFER_SUB_DATA, readTarget, writeTarget, (int64_t)readOffset, (int64_t)writeOffset, (int64_t)size);
+}
+
+void CaptureTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+	RecordCommand(GL_CAPTURE_TEX_IMAGE_2D, target, level, internalFormat, width, height, border, format, type,
+		GetImageData(width, height, format, type, pixels));
+}
+
+void CaptureTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+	RecordCommand(GL_CAPTURE_TEX_SUB_IMAGE_2D, target, level, xoffset, yoffset, width, height, format, type,
+		GetImageData(width, height, format, type, pixels));
+}
+
+void CaptureTexStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height)
+{
+	glTexStorage2D(target, levels, internalFormat, width, height);
+	RecordCommand(GL_CAPTURE_TEX_STORAGE_2D, target, levels, internalFormat, width, height);
+}
+
+void CaptureTexImage2DMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height, GLboolean fixedSampleLocations)
+{
+	glTexImage2DMultisample(target, samples, internalFormat, width, height, fixedSampleLocations);
+	RecordCommand(GL_CAPTURE_TEX_IMAGE_2D_MULTISAMPLE, target, samples, internalFormat, width, height, fixedSampleLocations);
+}
+
+void CaptureTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	glTexParameteri(target, pname, param);
+	RecordCommand(GL_CAPTURE_TEX_PARAMETER_I, target, pname, param);
+}
+
+void CaptureRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height)
+{
+	glRenderbufferStorage(target, internalFormat, width, height);
+	RecordCommand(GL_CAPTURE_RENDERBUFFER_STORAGE, target, internalFormat, width, height);
+}
+
+void CaptureFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level)
+{
+	glFramebufferTexture2D(target, attachment, textureTarget, texture, level);
+	RecordCommand(GL_CAPTURE_FRAMEBUFFER_TEXTURE_2D, target, attachment, textureTarget, texture, level);
+}
+
+void CaptureFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer)
+{
+	glFramebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer);
+	RecordCommand(GL_CAPTURE_FRAMEBUFFER_RENDERBUFFER, target, attachment, renderbufferTarget, renderbuffer);
+}
+
+void CaptureVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	RecordCommand(GL_CAPTURE_VERTEX_ATTRIB_POINTER, index, size, type, normalized, stride, ToInt64(pointer));
+}
+
+void CaptureEnableVertexAttribArray(GLuint index)
+{
+	glEnableVertexAttribArray(index);
+	RecordCommand(GL_CAPTURE_ENABLE_VERTEX_ATTRIB_ARRAY, index);
+}
+
+void CaptureUniform1i(GLint location, GLint v0)
+{
+	glUniform1i(location, v0);
+	RecordCommand(GL_CAPTURE_UNIFORM_1I, location, v0);
+}
+
+void CaptureUniform1ui(GLint location, GLuint v0)
+{
+	glUniform1ui(location, v0);
+	RecordCommand(GL_CAPTURE_UNIFORM_1UI, location, v0);
+}
+
+void CaptureUniform1f(GLint location, GLfloat v0)
+{
+	glUniform1f(location, v0);
+	RecordCommand(GL_CAPTURE_UNIFORM_1F, location, v0);
+}
+
+void CaptureUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+	glUniform2f(location, v0, v1);
+	RecordCommand(GL_CAPTURE_UNIFORM_2F, location, v0, v1);
+}
+
+void CaptureUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	glUniform3f(location, v0, v1, v2);
+	RecordCommand(GL_CAPTURE_UNIFORM_3F, location, v0, v1, v2);
+}
+
+void CaptureUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+	glUniform4f(location, v0, v1, v2, v3);
+	RecordCommand(GL_CAPTURE_UNIFORM_4F, location, v0, v1, v2, v3);
+}
+
+void CaptureUniform1fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	glUniform1fv(location, count, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_1FV, location, CAPTURE_DATA{ value, count * sizeof(GLfloat) });
+}
+
+void CaptureUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	glUniform2fv(location, count, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_2FV, location, CAPTURE_DATA{ value, count * 2 * sizeof(GLfloat) });
+}
+
+void CaptureUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	glUniform3fv(location, count, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_3FV, location, CAPTURE_DATA{ value, count * 3 * sizeof(GLfloat) });
+}
+
+void CaptureUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	glUniform4fv(location, count, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_4FV, location, CAPTURE_DATA{ value, count * 4 * sizeof(GLfloat) });
+}
+
+void CaptureUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	glUniformMatrix2fv(location, count, transpose, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_MATRIX_2FV, location, transpose, CAPTURE_DATA{ value, count * 4 * sizeof(GLfloat) });
+}
+
+void CaptureUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	glUniformMatrix3fv(location, count, transpose, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_MATRIX_3FV, location, transpose, CAPTURE_DATA{ value, count * 9 * sizeof(GLfloat) });
+}
+
+void CaptureUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	glUniformMatrix4fv(location, count, transpose, value);
+	RecordCommand(GL_CAPTURE_UNIFORM_MATRIX_4FV, location, transpose, CAPTURE_DATA{ value, count * 16 * sizeof(GLfloat) });
+}
+
+void CaptureClear(GLbitfield mask)
+{
+	glClear(mask);
+	RecordCommand(GL_CAPTURE_CLEAR, mask);
+}
+
+void CaptureClearBufferfv(GLenum buffer, GLint drawBuffer, const GLfloat* value)
+{
+	glClearBufferfv(buffer, drawBuffer, value);
+	RecordCommand(GL_CAPTURE_CLEAR_BUFFER_FV, buffer, drawBuffer, CAPTURE_DATA{ value, ((buffer == GL_COLOR) ? 4 : 1) * sizeof(GLfloat) });
+}
+
+void CaptureClearBufferuiv(GLenum buffer, GLint drawBuffer, const GLuint* value)
+{
+	glClearBufferuiv(buffer, drawBuffer, value);
+	RecordCommand(GL_CAPTURE_CLEAR_BUFFER_UIV, buffer, drawBuffer, CAPTURE_DATA{ value, ((buffer == GL_COLOR) ? 4 : 1) * sizeof(GLuint) });
+}
+
+void CaptureDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	glDrawArrays(mode, first, count);
+	RecordCommand(GL_CAPTURE_DRAW_ARRAYS, mode, first, count);
+}
+
+void CaptureDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	glDrawElements(mode, count, type, indices);
+	RecordCommand(GL_CAPTURE_DRAW_ELEMENTS, mode, count, type, ToInt64(indices));
+}
+
+void CaptureDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect)
+{
+	glDrawElementsIndirect(mode, type, indirect);
+	RecordCommand(GL_CAPTURE_DRAW_ELEMENTS_INDIRECT, mode, type, ToInt64(indirect));
+}
+
+void CaptureMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride)
+{
+	glMultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+	RecordCommand(GL_CAPTURE_MULTI_DRAW_ELEMENTS_INDIRECT, mode, type, ToInt64(indirect), drawCount, stride);
+}
+
+void CaptureDispatchCompute(GLuint groupsX, GLuint groupsY, GLuint groupsZ)
+{
+	glDispatchCompute(groupsX, groupsY, groupsZ);
+	RecordCommand(GL_CAPTURE_DISPATCH_COMPUTE, groupsX, groupsY, groupsZ);
+}
+
+void CaptureMemoryBarrier(GLbitfield barriers)
+{
+	glMemoryBarrier(barriers);
+	RecordCommand(GL_CAPTURE_MEMORY_BARRIER, barriers);
+}
+
+void CaptureBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+{
+	glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+	RecordCommand(GL_CAPTURE_BLIT_FRAMEBUFFER, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+void CaptureInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum* attachments)
+{
+	glInvalidateFramebuffer(target, numAttachments, attachments);
+	RecordCommand(GL_CAPTURE_INVALIDATE_FRAMEBUFFER, target, CAPTURE_DATA{ attachments, numAttachments * sizeof(GLenum) });
+}
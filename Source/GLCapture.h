@@ -0,0 +1,397 @@
+///////////////////////////////////////////////////////////////////////////////
+// glcapture.h
+// ============
+// record the OpenGL commands of a frame, with their uniform, buffer
+// and texture data, to a binary file that can be replayed offline
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+// the commands that are recorded - the values are stored in the
+// capture files, so new commands are only added at the end
+enum GL_CAPTURE_COMMAND
+{
+	// markers of the frame being captured and the end of the file
+	GL_CAPTURE_FRAME_BEGIN,
+	GL_CAPTURE_END,
+
+	// objects
+	GL_CAPTURE_GEN_BUFFERS,
+	GL_CAPTURE_DELETE_BUFFERS,
+	GL_CAPTURE_GEN_VERTEX_ARRAYS,
+	GL_CAPTURE_DELETE_VERTEX_ARRAYS,
+	GL_CAPTURE_GEN_TEXTURES,
+	GL_CAPTURE_DELETE_TEXTURES,
+	GL_CAPTURE_GEN_FRAMEBUFFERS,
+	GL_CAPTURE_DELETE_FRAMEBUFFERS,
+	GL_CAPTURE_GEN_RENDERBUFFERS,
+	GL_CAPTURE_DELETE_RENDERBUFFERS,
+	GL_CAPTURE_CREATE_SHADER,
+	GL_CAPTURE_DELETE_SHADER,
+	GL_CAPTURE_SHADER_SOURCE,
+	GL_CAPTURE_COMPILE_SHADER,
+	GL_CAPTURE_CREATE_PROGRAM,
+	GL_CAPTURE_DELETE_PROGRAM,
+	GL_CAPTURE_ATTACH_SHADER,
+	GL_CAPTURE_LINK_PROGRAM,
+	GL_CAPTURE_PROGRAM_PARAMETER_I,
+	GL_CAPTURE_PROGRAM_BINARY,
+	GL_CAPTURE_GET_UNIFORM_LOCATION,
+	GL_CAPTURE_GET_UNIFORM_BLOCK_INDEX,
+	GL_CAPTURE_UNIFORM_BLOCK_BINDING,
+
+	// bindings and fixed function state
+	GL_CAPTURE_USE_PROGRAM,
+	GL_CAPTURE_BIND_VERTEX_ARRAY,
+	GL_CAPTURE_BIND_BUFFER,
+	GL_CAPTURE_BIND_BUFFER_BASE,
+	GL_CAPTURE_BIND_BUFFER_RANGE,
+	GL_CAPTURE_ACTIVE_TEXTURE,
+	GL_CAPTURE_BIND_TEXTURE,
+	GL_CAPTURE_BIND_IMAGE_TEXTURE,
+	GL_CAPTURE_BIND_FRAMEBUFFER,
+	GL_CAPTURE_BIND_RENDERBUFFER,
+	GL_CAPTURE_ENABLE,
+	GL_CAPTURE_DISABLE,
+	GL_CAPTURE_DEPTH_MASK,
+	GL_CAPTURE_DEPTH_FUNC,
+	GL_CAPTURE_BLEND_FUNC,
+	GL_CAPTURE_COLOR_MASK,
+	GL_CAPTURE_VIEWPORT,
+	GL_CAPTURE_SCISSOR,
+	GL_CAPTURE_CLEAR_COLOR,
+	GL_CAPTURE_PIXEL_STORE_I,
+	GL_CAPTURE_DRAW_BUFFER,
+	GL_CAPTURE_DRAW_BUFFERS,
+	GL_CAPTURE_READ_BUFFER,
+
+	// data and storage
+	GL_CAPTURE_BUFFER_DATA,
+	GL_CAPTURE_BUFFER_SUB_DATA,
+	GL_CAPTURE_COPY_BUFFER_SUB_DATA,
+	GL_CAPTURE_TEX_IMAGE_2D,
+	GL_CAPTURE_TEX_SUB_IMAGE_2D,
+	GL_CAPTURE_TEX_STORAGE_2D,
+	GL_CAPTURE_TEX_IMAGE_2D_MULTISAMPLE,
+	GL_CAPTURE_TEX_PARAMETER_I,
+	GL_CAPTURE_RENDERBUFFER_STORAGE,
+	GL_CAPTURE_FRAMEBUFFER_TEXTURE_2D,
+	GL_CAPTURE_FRAMEBUFFER_RENDERBUFFER,
+	GL_CAPTURE_VERTEX_ATTRIB_POINTER,
+	GL_CAPTURE_ENABLE_VERTEX_ATTRIB_ARRAY,
+
+	// uniforms
+	GL_CAPTURE_UNIFORM_1I,
+	GL_CAPTURE_UNIFORM_1UI,
+	GL_CAPTURE_UNIFORM_1F,
+	GL_CAPTURE_UNIFORM_2F,
+	GL_CAPTURE_UNIFORM_3F,
+	GL_CAPTURE_UNIFORM_4F,
+	GL_CAPTURE_UNIFORM_1FV,
+	GL_CAPTURE_UNIFORM_2FV,
+	GL_CAPTURE_UNIFORM_3FV,
+	GL_CAPTURE_UNIFORM_4FV,
+	GL_CAPTURE_UNIFORM_MATRIX_2FV,
+	GL_CAPTURE_UNIFORM_MATRIX_3FV,
+	GL_CAPTURE_UNIFORM_MATRIX_4FV,
+
+	// work - only recorded in the frame being captured
+	GL_CAPTURE_CLEAR,
+	GL_CAPTURE_CLEAR_BUFFER_FV,
+	GL_CAPTURE_CLEAR_BUFFER_UIV,
+	GL_CAPTURE_DRAW_ARRAYS,
+	GL_CAPTURE_DRAW_ELEMENTS,
+	GL_CAPTURE_DRAW_ELEMENTS_INDIRECT,
+	GL_CAPTURE_MULTI_DRAW_ELEMENTS_INDIRECT,
+	GL_CAPTURE_DISPATCH_COMPUTE,
+	GL_CAPTURE_MEMORY_BARRIER,
+	GL_CAPTURE_BLIT_FRAMEBUFFER,
+	GL_CAPTURE_INVALIDATE_FRAMEBUFFER,
+
+	GL_CAPTURE_COMMAND_COUNT
+};
+
+// first four bytes and version of a capture file
+const uint32_t GL_CAPTURE_MAGIC = 0x50434C47;
+const uint32_t GL_CAPTURE_VERSION = 1;
+
+// start recording to a file - the commands that create and fill
+// objects are recorded from now on so the frame can be replayed,
+// and the draws are only recorded in the frame with the index
+bool StartGLCapture(const char* filename, int frameIndex);
+// mark the end of a frame, which finishes the capture file after
+// the frame being captured - the size is that of the window
+void EndGLCaptureFrame(int framebufferWidth, int framebufferHeight);
+// check whether commands are being recorded
+bool IsGLCaptureActive();
+// get the name of a command for reports
+const char* GetGLCaptureCommandName(int command);
+
+// the recording versions of the captured OpenGL functions, which
+// forward to OpenGL and then record the call while capturing
+void CaptureGenBuffers(GLsizei n, GLuint* buffers);
+void CaptureDeleteBuffers(GLsizei n, const GLuint* buffers);
+void CaptureGenVertexArrays(GLsizei n, GLuint* arrays);
+void CaptureDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void CaptureGenTextures(GLsizei n, GLuint* textures);
+void CaptureDeleteTextures(GLsizei n, const GLuint* textures);
+void CaptureGenFramebuffers(GLsizei n, GLuint* framebuffers);
+void CaptureDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+void CaptureGenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+void CaptureDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+GLuint CaptureCreateShader(GLenum type);
+void CaptureDeleteShader(GLuint shader);
+void CaptureShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths);
+void CaptureCompileShader(GLuint shader);
+GLuint CaptureCreateProgram();
+void CaptureDeleteProgram(GLuint program);
+void CaptureAttachShader(GLuint program, GLuint shader);
+void CaptureLinkProgram(GLuint program);
+void CaptureProgramParameteri(GLuint program, GLenum pname, GLint value);
+void CaptureProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+GLint CaptureGetUniformLocation(GLuint program, const GLchar* name);
+GLuint CaptureGetUniformBlockIndex(GLuint program, const GLchar* name);
+void CaptureUniformBlockBinding(GLuint program, GLuint blockIndex, GLuint blockBinding);
+
+void CaptureUseProgram(GLuint program);
+void CaptureBindVertexArray(GLuint array);
+void CaptureBindBuffer(GLenum target, GLuint buffer);
+void CaptureBindBufferBase(GLenum target, GLuint index, GLuint buffer);
+void CaptureBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+void CaptureActiveTexture(GLenum texture);
+void CaptureBindTexture(GLenum target, GLuint texture);
+void CaptureBindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+void CaptureBindFramebuffer(GLenum target, GLuint framebuffer);
+void CaptureBindRenderbuffer(GLenum target, GLuint renderbuffer);
+void CaptureEnable(GLenum cap);
+void CaptureDisable(GLenum cap);
+void CaptureDepthMask(GLboolean flag);
+void CaptureDepthFunc(GLenum func);
+void CaptureBlendFunc(GLenum sfactor, GLenum dfactor);
+void CaptureColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+void CaptureViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void CaptureScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void CaptureClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void CapturePixelStorei(GLenum pname, GLint param);
+void CaptureDrawBuffer(GLenum buffer);
+void CaptureDrawBuffers(GLsizei n, const GLenum* buffers);
+void CaptureReadBuffer(GLenum source);
+
+void CaptureBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void CaptureBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+void CaptureCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+void CaptureTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+void CaptureTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+void CaptureTexStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+void CaptureTexImage2DMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height, GLboolean fixedSampleLocations);
+void CaptureTexParameteri(GLenum target, GLenum pname, GLint param);
+void CaptureRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height);
+void CaptureFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level);
+void CaptureFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer);
+void CaptureVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+void CaptureEnableVertexAttribArray(GLuint index);
+
+void CaptureUniform1i(GLint location, GLint v0);
+void CaptureUniform1ui(GLint location, GLuint v0);
+void CaptureUniform1f(GLint location, GLfloat v0);
+void CaptureUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void CaptureUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void CaptureUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void CaptureUniform1fv(GLint location, GLsizei count, const GLfloat* value);
+void CaptureUniform2fv(GLint location, GLsizei count, const GLfloat* value);
+void CaptureUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+void CaptureUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+void CaptureUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+void CaptureUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+void CaptureUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+
+void CaptureClear(GLbitfield mask);
+void CaptureClearBufferfv(GLenum buffer, GLint drawBuffer, const GLfloat* value);
+void CaptureClearBufferuiv(GLenum buffer, GLint drawBuffer, const GLuint* value);
+void CaptureDrawArrays(GLenum mode, GLint first, GLsizei count);
+void CaptureDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+void CaptureDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect);
+void CaptureMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+void CaptureDispatchCompute(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+void CaptureMemoryBarrier(GLbitfield barriers);
+void CaptureBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+void CaptureInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum* attachments);
+
+// every file that includes this header, after GLEW, calls the
+// recording versions - the capture code itself calls OpenGL
+#ifndef GL_CAPTURE_IMPLEMENTATION
+#undef glGenBuffers
+#define glGenBuffers CaptureGenBuffers
+#undef glDeleteBuffers
+#define glDeleteBuffers CaptureDeleteBuffers
+#undef glGenVertexArrays
+#define glGenVertexArrays CaptureGenVertexArrays
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays CaptureDeleteVertexArrays
+#undef glGenTextures
+#define glGenTextures CaptureGenTextures
+#undef glDeleteTextures
+#define glDeleteTextures CaptureDeleteTextures
+#undef glGenFramebuffers
+#define glGenFramebuffers CaptureGenFramebuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers CaptureDeleteFramebuffers
+#undef glGenRenderbuffers
+#define glGenRenderbuffers CaptureGenRenderbuffers
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers CaptureDeleteRenderbuffers
+#undef glCreateShader
+#define glCreateShader CaptureCreateShader
+#undef glDeleteShader
+#define glDeleteShader CaptureDeleteShader
+#undef glShaderSource
+#define glShaderSource CaptureShaderSource
+#undef glCompileShader
+#define glCompileShader CaptureCompileShader
+#undef glCreateProgram
+#define glCreateProgram CaptureCreateProgram
+#undef glDeleteProgram
+#define glDeleteProgram CaptureDeleteProgram
+#undef glAttachShader
+#define glAttachShader CaptureAttachShader
+#undef glLinkProgram
+#define glLinkProgram CaptureLinkProgram
+#undef glProgramParameteri
+#define glProgramParameteri CaptureProgramParameteri
+#undef glProgramBinary
+#define glProgramBinary CaptureProgramBinary
+#undef glGetUniformLocation
+#define glGetUniformLocation CaptureGetUniformLocation
+#undef glGetUniformBlockIndex
+#define glGetUniformBlockIndex CaptureGetUniformBlockIndex
+#undef glUniformBlockBinding
+#define glUniformBlockBinding CaptureUniformBlockBinding
+
+#undef glUseProgram
+#define glUseProgram CaptureUseProgram
+#undef glBindVertexArray
+#define glBindVertexArray CaptureBindVertexArray
+#undef glBindBuffer
+#define glBindBuffer CaptureBindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase CaptureBindBufferBase
+#undef glBindBufferRange
+#define glBindBufferRange CaptureBindBufferRange
+#undef glActiveTexture
+#define glActiveTexture CaptureActiveTexture
+#undef glBindTexture
+#define glBindTexture CaptureBindTexture
+#undef glBindImageTexture
+#define glBindImageTexture CaptureBindImageTexture
+#undef glBindFramebuffer
+#define glBindFramebuffer CaptureBindFramebuffer
+#undef glBindRenderbuffer
+#define glBindRenderbuffer CaptureBindRenderbuffer
+#undef glEnable
+#define glEnable CaptureEnable
+#undef glDisable
+#define glDisable CaptureDisable
+#undef glDepthMask
+#define glDepthMask CaptureDepthMask
+#undef glDepthFunc
+#define glDepthFunc CaptureDepthFunc
+#undef glBlendFunc
+#define glBlendFunc CaptureBlendFunc
+#undef glColorMask
+#define glColorMask CaptureColorMask
+#undef glViewport
+#define glViewport CaptureViewport
+#undef glScissor
+#define glScissor CaptureScissor
+#undef glClearColor
+#define glClearColor CaptureClearColor
+#undef glPixelStorei
+#define glPixelStorei CapturePixelStorei
+#undef glDrawBuffer
+#define glDrawBuffer CaptureDrawBuffer
+#undef glDrawBuffers
+#define glDrawBuffers CaptureDrawBuffers
+#undef glReadBuffer
+#define glReadBuffer CaptureReadBuffer
+
+#undef glBufferData
+#define glBufferData CaptureBufferData
+#undef glBufferSubData
+#define glBufferSubData CaptureBufferSubData
+#undef glCopyBufferSubData
+#define glCopyBufferSubData CaptureCopyBufferSubData
+#undef glTexImage2D
+#define glTexImage2D CaptureTexImage2D
+#undef glTexSubImage2D
+#define glTexSubImage2D CaptureTexSubImage2D
+#undef glTexStorage2D
+#define glTexStorage2D CaptureTexStorage2D
+#undef glTexImage2DMultisample
+#define glTexImage2DMultisample CaptureTexImage2DMultisample
+#undef glTexParameteri
+#define glTexParameteri CaptureTexParameteri
+#undef glRenderbufferStorage
+#define glRenderbufferStorage CaptureRenderbufferStorage
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D CaptureFramebufferTexture2D
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer CaptureFramebufferRenderbuffer
+#undef glVertexAttribPointer
+#define glVertexAttribPointer CaptureVertexAttribPointer
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray CaptureEnableVertexAttribArray
+
+#undef glUniform1i
+#define glUniform1i CaptureUniform1i
+#undef glUniform1ui
+#define glUniform1ui CaptureUniform1ui
+#undef glUniform1f
+#define glUniform1f CaptureUniform1f
+#undef glUniform2f
+#define glUniform2f CaptureUniform2f
+#undef glUniform3f
+#define glUniform3f CaptureUniform3f
+#undef glUniform4f
+#define glUniform4f CaptureUniform4f
+#undef glUniform1fv
+#define glUniform1fv CaptureUniform1fv
+#undef glUniform2fv
+#define glUniform2fv CaptureUniform2fv
+#undef glUniform3fv
+#define glUniform3fv CaptureUniform3fv
+#undef glUniform4fv
+#define glUniform4fv CaptureUniform4fv
+#undef glUniformMatrix2fv
+#define glUniformMatrix2fv CaptureUniformMatrix2fv
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv CaptureUniformMatrix3fv
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv CaptureUniformMatrix4fv
+
+#undef glClear
+#define glClear CaptureClear
+#undef glClearBufferfv
+#define glClearBufferfv CaptureClearBufferfv
+#undef glClearBufferuiv
+#define glClearBufferuiv CaptureClearBufferuiv
+#undef glDrawArrays
+#define glDrawArrays CaptureDrawArrays
+#undef glDrawElements
+#define glDrawElements CaptureDrawElements
+#undef glDrawElementsIndirect
+#define glDrawElementsIndirect CaptureDrawElementsIndirect
+#undef glMultiDrawElementsIndirect
+#define glMultiDrawElementsIndirect CaptureMultiDrawElementsIndirect
+#undef glDispatchCompute
+#define glDispatchCompute CaptureDispatchCompute
+#undef glMemoryBarrier
+#define glMemoryBarrier CaptureMemoryBarrier
+#undef glBlitFramebuffer
+#define glBlitFramebuffer CaptureBlitFramebuffer
+#undef glInvalidateFramebuffer
+#define glInvalidateFramebuffer CaptureInvalidateFramebuffer
+#endif
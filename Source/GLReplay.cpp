@@ -0,0 +1,1356 @@
+///////////////////////////////////////////////////////////////////////////////
+// glreplay.cpp
+// ============
+// replay a captured frame of OpenGL commands, time every call and
+// report the redundant state changes and duplicate uploads
+///////////////////////////////////////////////////////////////////////////////
+
+// the replay calls OpenGL directly instead of recording itself
+#define GL_CAPTURE_IMPLEMENTATION
+#include "GLReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// bytes of the file header in front of the first command
+	const size_t HEADER_SIZE = 16;
+	// the number of slowest calls that are listed in the report
+	const size_t SLOWEST_CALL_COUNT = 10;
+	// the size value of a command's data that stands for NULL
+	const uint32_t NULL_DATA_SIZE = 0xFFFFFFFF;
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used for getting the FNV-1a hash of
+	 *  the values of a state or the data of an upload.
+	 ***********************************************************/
+	uint64_t HashBytes(const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pBytes[i]) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// get the key of a uniform location or block index of a program
+	uint64_t GetProgramKey(GLuint program, GLuint value)
+	{
+		return ((uint64_t)program << 32) | value;
+	}
+
+	// get the texture target that a face of a cube map is bound to
+	GLenum GetBindingTarget(GLenum target)
+	{
+		if ((target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X) && (target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z))
+		{
+			return GL_TEXTURE_CUBE_MAP;
+		}
+		return target;
+	}
+}
+
+/***********************************************************
+ *  GLReplay::Reader
+ *
+ *  This class reads the values of a command from the file,
+ *  in the order they were recorded, and notes when the file
+ *  ends in the middle of one.
+ ***********************************************************/
+class GLReplay::Reader
+{
+public:
+	Reader(const std::vector<unsigned char>& data, size_t offset) :
+		m_pData(data.data()),
+		m_size(data.size()),
+		m_offset(offset),
+		m_bBroken(false)
+	{
+	}
+
+	// read a value
+	template <typename T>
+	T Get()
+	{
+		T value = T();
+		if (m_offset + sizeof(T) > m_size)
+		{
+			m_bBroken = true;
+			return value;
+		}
+		memcpy(&value, m_pData + m_offset, sizeof(T));
+		m_offset += sizeof(T);
+		return value;
+	}
+
+	// read data with its size - returns NULL when none was recorded
+	const void* GetData(size_t& size)
+	{
+		uint32_t dataSize = Get<uint32_t>();
+		size = 0;
+		if ((NULL_DATA_SIZE == dataSize) || m_bBroken)
+		{
+			return NULL;
+		}
+		if (m_offset + dataSize > m_size)
+		{
+			m_bBroken = true;
+			return NULL;
+		}
+		const void* pData = m_pData + m_offset;
+		m_offset += dataSize;
+		size = dataSize;
+		return pData;
+	}
+
+	size_t GetOffset() const { return m_offset; }
+	bool IsBroken() const { return m_bBroken; }
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+	size_t m_offset;
+	bool m_bBroken;
+};
+
+/***********************************************************
+ *  GLReplay()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLReplay::GLReplay() :
+	m_width(0),
+	m_height(0),
+	m_repeatCount(0),
+	m_program(0),
+	m_activeTextureUnit(0),
+	m_vertexArray(0),
+	m_drawFramebuffer(0)
+{
+}
+
+/***********************************************************
+ *  ~GLReplay()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLReplay::~GLReplay()
+{
+	if (false == m_queries.empty())
+	{
+		glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading a capture file and the
+ *  size of the window in its header.
+ ***********************************************************/
+bool GLReplay::Load(const char* filename)
+{
+	FILE* pFile = fopen(filename, "rb");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not read GL capture:" << filename << std::endl;
+		return false;
+	}
+
+	fseek(pFile, 0, SEEK_END);
+	long fileSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	m_data.resize((fileSize > 0) ? (size_t)fileSize : 0);
+	bool bLoaded = (fread(m_data.data(), 1, m_data.size(), pFile) == m_data.size());
+	fclose(pFile);
+
+	Reader header(m_data, 0);
+	uint32_t magic = header.Get<uint32_t>();
+	uint32_t version = header.Get<uint32_t>();
+	m_width = header.Get<int32_t>();
+	m_height = header.Get<int32_t>();
+	if ((false == bLoaded) || header.IsBroken() || (magic != GL_CAPTURE_MAGIC) || (version != GL_CAPTURE_VERSION))
+	{
+		std::cout << "ERROR: Not a GL capture of this version:" << filename << std::endl;
+		return false;
+	}
+	if ((m_width <= 0) || (m_height <= 0))
+	{
+		std::cout << "ERROR: GL capture ends before its frame:" << filename << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: Loaded GL capture of " << m_data.size() << " bytes at " << m_width << "x" << m_height << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for replaying the capture.  The
+ *  commands before the frame are replayed once while the
+ *  state shadow is kept, then the frame is replayed once to
+ *  analyse its calls and warm the driver up, and then once
+ *  per pass with every call timed.
+ ***********************************************************/
+bool GLReplay::Run(int repeatCount)
+{
+	m_repeatCount = std::max(1, repeatCount);
+	m_calls.clear();
+
+	// replay the commands that set the frame up
+	CALL_ANALYSIS analysis;
+	size_t offset = HEADER_SIZE;
+	int command = GL_CAPTURE_END;
+	while (ExecuteCommand(offset, command, &analysis) && (command != GL_CAPTURE_FRAME_BEGIN))
+	{
+	}
+	if (command != GL_CAPTURE_FRAME_BEGIN)
+	{
+		std::cout << "ERROR: GL capture has no frame to replay" << std::endl;
+		return false;
+	}
+
+	// the first replay of the frame finds its calls
+	while (true)
+	{
+		FRAME_CALL call = { offset, GL_CAPTURE_END, 0.0, 0.0, false, false, 0 };
+		if (false == ExecuteCommand(offset, command, &analysis))
+		{
+			break;
+		}
+		call.command = command;
+		call.bRedundant = analysis.bRedundant;
+		call.bDuplicateUpload = analysis.bDuplicateUpload;
+		call.uploadBytes = analysis.uploadBytes;
+		m_calls.push_back(call);
+	}
+	if (command != GL_CAPTURE_END)
+	{
+		return false;
+	}
+	glFinish();
+
+	if (false == m_queries.empty())
+	{
+		glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+	}
+	m_queries.resize(m_calls.size() + 1);
+	glGenQueries((GLsizei)m_queries.size(), m_queries.data());
+
+	for (int i = 0; i < m_repeatCount; i++)
+	{
+		if (false == TimeFrame())
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < m_calls.size(); i++)
+	{
+		m_calls[i].cpuMicroseconds /= m_repeatCount;
+		m_calls[i].gpuMicroseconds /= m_repeatCount;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  TimeFrame()
+ *
+ *  This method is used for replaying the calls of the frame
+ *  once with a timestamp written in front of each, and
+ *  adding the time of each call to its total.  The time of
+ *  a call on the GPU is the time between its timestamp and
+ *  the next one.
+ ***********************************************************/
+bool GLReplay::TimeFrame()
+{
+	for (size_t i = 0; i < m_calls.size(); i++)
+	{
+		size_t offset = m_calls[i].offset;
+		int command = GL_CAPTURE_END;
+
+		auto startTime = std::chrono::steady_clock::now();
+		glQueryCounter(m_queries[i], GL_TIMESTAMP);
+		ExecuteCommand(offset, command, NULL);
+		auto endTime = std::chrono::steady_clock::now();
+
+		m_calls[i].cpuMicroseconds += std::chrono::duration<double, std::micro>(endTime - startTime).count();
+	}
+	glQueryCounter(m_queries[m_calls.size()], GL_TIMESTAMP);
+	glFinish();
+
+	GLuint64 previousTime = 0;
+	glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &previousTime);
+	for (size_t i = 0; i < m_calls.size(); i++)
+	{
+		GLuint64 time = 0;
+		glGetQueryObjectui64v(m_queries[i + 1], GL_QUERY_RESULT, &time);
+		if (time > previousTime)
+		{
+			m_calls[i].gpuMicroseconds += (double)(time - previousTime) / 1000.0;
+		}
+		previousTime = time;
+	}
+
+	return (glGetError() != GL_OUT_OF_MEMORY);
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used for printing the cost of the frame
+ *  by command, the slowest calls on the GPU and the totals
+ *  of the redundant calls and duplicate uploads.  Every
+ *  call can also be written to a CSV file.
+ ***********************************************************/
+bool GLReplay::Report(const char* csvFilename) const
+{
+	struct COMMAND_COST
+	{
+		int command;
+		int calls;
+		int redundantCalls;
+		double cpuMicroseconds;
+		double gpuMicroseconds;
+	};
+
+	std::vector<COMMAND_COST> costs(GL_CAPTURE_COMMAND_COUNT);
+	for (int i = 0; i < GL_CAPTURE_COMMAND_COUNT; i++)
+	{
+		costs[i] = { i, 0, 0, 0.0, 0.0 };
+	}
+
+	double frameCPU = 0.0;
+	double frameGPU = 0.0;
+	int redundantCount = 0;
+	int duplicateCount = 0;
+	size_t duplicateBytes = 0;
+	for (size_t i = 0; i < m_calls.size(); i++)
+	{
+		const FRAME_CALL& call = m_calls[i];
+		COMMAND_COST& cost = costs[call.command];
+		cost.calls++;
+		cost.cpuMicroseconds += call.cpuMicroseconds;
+		cost.gpuMicroseconds += call.gpuMicroseconds;
+		frameCPU += call.cpuMicroseconds;
+		frameGPU += call.gpuMicroseconds;
+		if (call.bRedundant)
+		{
+			cost.redundantCalls++;
+			redundantCount++;
+		}
+		if (call.bDuplicateUpload)
+		{
+			duplicateCount++;
+			duplicateBytes += call.uploadBytes;
+		}
+	}
+
+	std::sort(costs.begin(), costs.end(), [](const COMMAND_COST& a, const COMMAND_COST& b)
+	{
+		return a.gpuMicroseconds + a.cpuMicroseconds > b.gpuMicroseconds + b.cpuMicroseconds;
+	});
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "INFO: Replayed " << m_calls.size() << " calls of the frame over " << m_repeatCount << " passes - "
+		<< (frameCPU / 1000.0) << " ms CPU, " << (frameGPU / 1000.0) << " ms GPU" << std::endl;
+	std::cout << std::setprecision(1);
+	std::cout << std::left << std::setw(32) << "command" << std::right << std::setw(9) << "calls"
+		<< std::setw(13) << "cpu us" << std::setw(13) << "gpu us" << std::setw(11) << "redundant" << std::endl;
+	for (size_t i = 0; i < costs.size(); i++)
+	{
+		if (costs[i].calls > 0)
+		{
+			std::cout << std::left << std::setw(32) << GetGLCaptureCommandName(costs[i].command) << std::right
+				<< std::setw(9) << costs[i].calls << std::setw(13) << costs[i].cpuMicroseconds
+				<< std::setw(13) << costs[i].gpuMicroseconds << std::setw(11) << costs[i].redundantCalls << std::endl;
+		}
+	}
+
+	std::vector<size_t> slowest(m_calls.size());
+	for (size_t i = 0; i < slowest.size(); i++)
+	{
+		slowest[i] = i;
+	}
+	size_t slowestCount = std::min(SLOWEST_CALL_COUNT, slowest.size());
+	std::partial_sort(slowest.begin(), slowest.begin() + slowestCount, slowest.end(), [this](size_t a, size_t b)
+	{
+		return m_calls[a].gpuMicroseconds > m_calls[b].gpuMicroseconds;
+	});
+	std::cout << "INFO: Slowest calls on the GPU" << std::endl;
+	for (size_t i = 0; i < slowestCount; i++)
+	{
+		const FRAME_CALL& call = m_calls[slowest[i]];
+		std::cout << std::setw(8) << slowest[i] << " " << std::left << std::setw(32) << GetGLCaptureCommandName(call.command)
+			<< std::right << std::setw(13) << call.gpuMicroseconds << " us" << std::endl;
+	}
+
+	std::cout << "INFO: " << redundantCount << " redundant state changes, " << duplicateCount
+		<< " duplicate uploads of " << duplicateBytes << " bytes" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	if (NULL == csvFilename)
+	{
+		return true;
+	}
+
+	FILE* pFile = fopen(csvFilename, "w");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not write replay report:" << csvFilename << std::endl;
+		return false;
+	}
+	fprintf(pFile, "index,command,cpu_us,gpu_us,redundant,duplicate_upload,upload_bytes\n");
+	for (size_t i = 0; i < m_calls.size(); i++)
+	{
+		const FRAME_CALL& call = m_calls[i];
+		fprintf(pFile, "%d,%s,%.3f,%.3f,%d,%d,%d\n", (int)i, GetGLCaptureCommandName(call.command),
+			call.cpuMicroseconds, call.gpuMicroseconds, call.bRedundant ? 1 : 0,
+			call.bDuplicateUpload ? 1 : 0, (int)call.uploadBytes);
+	}
+	fclose(pFile);
+
+	std::cout << "INFO: Wrote the calls of the frame to " << csvFilename << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  ExecuteCommand()
+ *
+ *  This method is used for replaying the command at an
+ *  offset in the file and moving the offset past it.  The
+ *  names that the command uses are mapped to the replay's
+ *  own.  With an analysis, the shadow state and the hashes
+ *  of the uploads are updated to tell whether the command
+ *  changed anything.
+ ***********************************************************/
+bool GLReplay::ExecuteCommand(size_t& offset, int& command, CALL_ANALYSIS* pAnalysis)
+{
+	Reader in(m_data, offset);
+	command = in.Get<uint8_t>();
+	const size_t valuesOffset = in.GetOffset();
+	const bool bAnalyze = (NULL != pAnalysis);
+
+	bool bRedundant = false;
+	bool bDuplicateUpload = false;
+	size_t uploadBytes = 0;
+	size_t size = 0;
+
+	switch (command)
+	{
+	case GL_CAPTURE_FRAME_BEGIN:
+	case GL_CAPTURE_END:
+		break;
+
+	case GL_CAPTURE_GEN_BUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		GenNames(m_buffers, pNames, (GLsizei)(size / sizeof(GLuint)), glGenBuffers);
+		break;
+	}
+	case GL_CAPTURE_DELETE_BUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		DeleteNames(m_buffers, pNames, (GLsizei)(size / sizeof(GLuint)), glDeleteBuffers);
+		break;
+	}
+	case GL_CAPTURE_GEN_VERTEX_ARRAYS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		GenNames(m_vertexArrays, pNames, (GLsizei)(size / sizeof(GLuint)), glGenVertexArrays);
+		break;
+	}
+	case GL_CAPTURE_DELETE_VERTEX_ARRAYS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		DeleteNames(m_vertexArrays, pNames, (GLsizei)(size / sizeof(GLuint)), glDeleteVertexArrays);
+		break;
+	}
+	case GL_CAPTURE_GEN_TEXTURES:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		GenNames(m_textures, pNames, (GLsizei)(size / sizeof(GLuint)), glGenTextures);
+		break;
+	}
+	case GL_CAPTURE_DELETE_TEXTURES:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		DeleteNames(m_textures, pNames, (GLsizei)(size / sizeof(GLuint)), glDeleteTextures);
+		break;
+	}
+	case GL_CAPTURE_GEN_FRAMEBUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		GenNames(m_framebuffers, pNames, (GLsizei)(size / sizeof(GLuint)), glGenFramebuffers);
+		break;
+	}
+	case GL_CAPTURE_DELETE_FRAMEBUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		DeleteNames(m_framebuffers, pNames, (GLsizei)(size / sizeof(GLuint)), glDeleteFramebuffers);
+		break;
+	}
+	case GL_CAPTURE_GEN_RENDERBUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		GenNames(m_renderbuffers, pNames, (GLsizei)(size / sizeof(GLuint)), glGenRenderbuffers);
+		break;
+	}
+	case GL_CAPTURE_DELETE_RENDERBUFFERS:
+	{
+		const GLuint* pNames = (const GLuint*)in.GetData(size);
+		DeleteNames(m_renderbuffers, pNames, (GLsizei)(size / sizeof(GLuint)), glDeleteRenderbuffers);
+		break;
+	}
+	case GL_CAPTURE_CREATE_SHADER:
+	{
+		GLenum type = in.Get<GLenum>();
+		GLuint shader = in.Get<GLuint>();
+		m_shaderObjects[shader] = glCreateShader(type);
+		break;
+	}
+	case GL_CAPTURE_DELETE_SHADER:
+	case GL_CAPTURE_DELETE_PROGRAM:
+	{
+		GLuint name = in.Get<GLuint>();
+		if (command == GL_CAPTURE_DELETE_SHADER)
+		{
+			glDeleteShader(MapName(m_shaderObjects, name));
+		}
+		else
+		{
+			glDeleteProgram(MapName(m_shaderObjects, name));
+		}
+		m_shaderObjects.erase(name);
+		break;
+	}
+	case GL_CAPTURE_SHADER_SOURCE:
+	{
+		GLuint shader = in.Get<GLuint>();
+		const GLchar* pSource = (const GLchar*)in.GetData(size);
+		if (NULL != pSource)
+		{
+			glShaderSource(MapName(m_shaderObjects, shader), 1, &pSource, NULL);
+		}
+		break;
+	}
+	case GL_CAPTURE_COMPILE_SHADER:
+		glCompileShader(MapName(m_shaderObjects, in.Get<GLuint>()));
+		break;
+	case GL_CAPTURE_CREATE_PROGRAM:
+		m_shaderObjects[in.Get<GLuint>()] = glCreateProgram();
+		break;
+	case GL_CAPTURE_ATTACH_SHADER:
+	{
+		GLuint program = in.Get<GLuint>();
+		GLuint shader = in.Get<GLuint>();
+		glAttachShader(MapName(m_shaderObjects, program), MapName(m_shaderObjects, shader));
+		break;
+	}
+	case GL_CAPTURE_LINK_PROGRAM:
+		glLinkProgram(MapName(m_shaderObjects, in.Get<GLuint>()));
+		break;
+	case GL_CAPTURE_PROGRAM_PARAMETER_I:
+	{
+		GLuint program = in.Get<GLuint>();
+		GLenum pname = in.Get<GLenum>();
+		GLint value = in.Get<GLint>();
+		glProgramParameteri(MapName(m_shaderObjects, program), pname, value);
+		break;
+	}
+	case GL_CAPTURE_PROGRAM_BINARY:
+	{
+		GLuint program = in.Get<GLuint>();
+		GLenum binaryFormat = in.Get<GLenum>();
+		const void* pBinary = in.GetData(size);
+		glProgramBinary(MapName(m_shaderObjects, program), binaryFormat, pBinary, (GLsizei)size);
+		break;
+	}
+	case GL_CAPTURE_GET_UNIFORM_LOCATION:
+	{
+		GLuint program = in.Get<GLuint>();
+		const GLchar* pName = (const GLchar*)in.GetData(size);
+		GLint location = in.Get<GLint>();
+		if (NULL == pName)
+		{
+			break;
+		}
+		GLint replayLocation = glGetUniformLocation(MapName(m_shaderObjects, program), pName);
+		if (location >= 0)
+		{
+			m_uniformLocations[GetProgramKey(program, (GLuint)location)] = replayLocation;
+		}
+		// looking the same name up again is redundant work
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, HashBytes(pName, size) ^ program, 1);
+		}
+		break;
+	}
+	case GL_CAPTURE_GET_UNIFORM_BLOCK_INDEX:
+	{
+		GLuint program = in.Get<GLuint>();
+		const GLchar* pName = (const GLchar*)in.GetData(size);
+		GLuint blockIndex = in.Get<GLuint>();
+		if (NULL == pName)
+		{
+			break;
+		}
+		GLuint replayIndex = glGetUniformBlockIndex(MapName(m_shaderObjects, program), pName);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			m_blockIndices[GetProgramKey(program, blockIndex)] = replayIndex;
+		}
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, HashBytes(pName, size) ^ program, 1);
+		}
+		break;
+	}
+	case GL_CAPTURE_UNIFORM_BLOCK_BINDING:
+	{
+		GLuint program = in.Get<GLuint>();
+		GLuint blockIndex = in.Get<GLuint>();
+		GLuint blockBinding = in.Get<GLuint>();
+		auto replayIndex = m_blockIndices.find(GetProgramKey(program, blockIndex));
+		glUniformBlockBinding(MapName(m_shaderObjects, program),
+			(replayIndex != m_blockIndices.end()) ? replayIndex->second : blockIndex, blockBinding);
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, GetProgramKey(program, blockIndex), blockBinding);
+		}
+		break;
+	}
+
+	case GL_CAPTURE_USE_PROGRAM:
+		m_program = in.Get<GLuint>();
+		glUseProgram(MapName(m_shaderObjects, m_program));
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, 0, m_program);
+		}
+		break;
+	case GL_CAPTURE_BIND_VERTEX_ARRAY:
+	{
+		GLuint vertexArray = in.Get<GLuint>();
+		glBindVertexArray(MapName(m_vertexArrays, vertexArray));
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, 0, vertexArray);
+			if (false == bRedundant)
+			{
+				// the index buffer binding belongs to the vertex array
+				m_vertexArray = vertexArray;
+				m_shadowState.erase(((uint64_t)GL_CAPTURE_BIND_BUFFER << 56) ^ GL_ELEMENT_ARRAY_BUFFER);
+				m_boundBuffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+			}
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_BUFFER:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLuint buffer = in.Get<GLuint>();
+		glBindBuffer(target, MapName(m_buffers, buffer));
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, target, buffer);
+			m_boundBuffers[target] = buffer;
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_BUFFER_BASE:
+	case GL_CAPTURE_BIND_BUFFER_RANGE:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLuint index = in.Get<GLuint>();
+		GLuint buffer = in.Get<GLuint>();
+		if (command == GL_CAPTURE_BIND_BUFFER_BASE)
+		{
+			glBindBufferBase(target, index, MapName(m_buffers, buffer));
+		}
+		else
+		{
+			int64_t rangeOffset = in.Get<int64_t>();
+			int64_t rangeSize = in.Get<int64_t>();
+			glBindBufferRange(target, index, MapName(m_buffers, buffer), (GLintptr)rangeOffset, (GLsizeiptr)rangeSize);
+		}
+		if (bAnalyze)
+		{
+			// both also bind the buffer to the target itself
+			bRedundant = SetShadowState(GL_CAPTURE_BIND_BUFFER_BASE, ((uint64_t)target << 16) | index,
+				HashBytes(&m_data[valuesOffset], in.GetOffset() - valuesOffset));
+			SetShadowState(GL_CAPTURE_BIND_BUFFER, target, buffer);
+			m_boundBuffers[target] = buffer;
+		}
+		break;
+	}
+	case GL_CAPTURE_ACTIVE_TEXTURE:
+	{
+		GLenum texture = in.Get<GLenum>();
+		glActiveTexture(texture);
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, 0, texture);
+			m_activeTextureUnit = texture - GL_TEXTURE0;
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_TEXTURE:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLuint texture = in.Get<GLuint>();
+		glBindTexture(target, MapName(m_textures, texture));
+		if (bAnalyze)
+		{
+			uint64_t binding = ((uint64_t)m_activeTextureUnit << 32) | target;
+			bRedundant = SetShadowState(command, binding, texture);
+			m_boundTextures[binding] = texture;
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_IMAGE_TEXTURE:
+	{
+		GLuint unit = in.Get<GLuint>();
+		GLuint texture = in.Get<GLuint>();
+		GLint level = in.Get<GLint>();
+		GLboolean layered = in.Get<GLboolean>();
+		GLint layer = in.Get<GLint>();
+		GLenum access = in.Get<GLenum>();
+		GLenum format = in.Get<GLenum>();
+		glBindImageTexture(unit, MapName(m_textures, texture), level, layered, layer, access, format);
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, unit, HashBytes(&m_data[valuesOffset], in.GetOffset() - valuesOffset));
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_FRAMEBUFFER:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLuint framebuffer = in.Get<GLuint>();
+		glBindFramebuffer(target, MapName(m_framebuffers, framebuffer));
+		if (bAnalyze)
+		{
+			// binding both targets is only redundant when both had it
+			bool bDrawRedundant = true;
+			bool bReadRedundant = true;
+			if (target != GL_READ_FRAMEBUFFER)
+			{
+				bDrawRedundant = SetShadowState(command, GL_DRAW_FRAMEBUFFER, framebuffer);
+				m_drawFramebuffer = framebuffer;
+			}
+			if (target != GL_DRAW_FRAMEBUFFER)
+			{
+				bReadRedundant = SetShadowState(command, GL_READ_FRAMEBUFFER, framebuffer);
+			}
+			bRedundant = bDrawRedundant && bReadRedundant;
+		}
+		break;
+	}
+	case GL_CAPTURE_BIND_RENDERBUFFER:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLuint renderbuffer = in.Get<GLuint>();
+		glBindRenderbuffer(target, MapName(m_renderbuffers, renderbuffer));
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, target, renderbuffer);
+		}
+		break;
+	}
+	case GL_CAPTURE_ENABLE:
+	case GL_CAPTURE_DISABLE:
+	{
+		GLenum cap = in.Get<GLenum>();
+		if (command == GL_CAPTURE_ENABLE)
+		{
+			glEnable(cap);
+		}
+		else
+		{
+			glDisable(cap);
+		}
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(GL_CAPTURE_ENABLE, cap, (command == GL_CAPTURE_ENABLE) ? 1 : 0);
+		}
+		break;
+	}
+	case GL_CAPTURE_DEPTH_MASK:
+		glDepthMask(in.Get<GLboolean>());
+		break;
+	case GL_CAPTURE_DEPTH_FUNC:
+		glDepthFunc(in.Get<GLenum>());
+		break;
+	case GL_CAPTURE_BLEND_FUNC:
+	{
+		GLenum sfactor = in.Get<GLenum>();
+		GLenum dfactor = in.Get<GLenum>();
+		glBlendFunc(sfactor, dfactor);
+		break;
+	}
+	case GL_CAPTURE_COLOR_MASK:
+	{
+		GLboolean red = in.Get<GLboolean>();
+		GLboolean green = in.Get<GLboolean>();
+		GLboolean blue = in.Get<GLboolean>();
+		GLboolean alpha = in.Get<GLboolean>();
+		glColorMask(red, green, blue, alpha);
+		break;
+	}
+	case GL_CAPTURE_VIEWPORT:
+	case GL_CAPTURE_SCISSOR:
+	{
+		GLint x = in.Get<GLint>();
+		GLint y = in.Get<GLint>();
+		GLsizei width = in.Get<GLsizei>();
+		GLsizei height = in.Get<GLsizei>();
+		if (command == GL_CAPTURE_VIEWPORT)
+		{
+			glViewport(x, y, width, height);
+		}
+		else
+		{
+			glScissor(x, y, width, height);
+		}
+		break;
+	}
+	case GL_CAPTURE_CLEAR_COLOR:
+	{
+		GLfloat red = in.Get<GLfloat>();
+		GLfloat green = in.Get<GLfloat>();
+		GLfloat blue = in.Get<GLfloat>();
+		GLfloat alpha = in.Get<GLfloat>();
+		glClearColor(red, green, blue, alpha);
+		break;
+	}
+	case GL_CAPTURE_PIXEL_STORE_I:
+	{
+		GLenum pname = in.Get<GLenum>();
+		GLint param = in.Get<GLint>();
+		glPixelStorei(pname, param);
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, pname, (uint32_t)param);
+		}
+		break;
+	}
+	case GL_CAPTURE_DRAW_BUFFER:
+	case GL_CAPTURE_DRAW_BUFFERS:
+	{
+		if (command == GL_CAPTURE_DRAW_BUFFER)
+		{
+			glDrawBuffer(in.Get<GLenum>());
+		}
+		else
+		{
+			const GLenum* pBuffers = (const GLenum*)in.GetData(size);
+			glDrawBuffers((GLsizei)(size / sizeof(GLenum)), pBuffers);
+		}
+		// the draw buffers belong to the framebuffer
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, m_drawFramebuffer, HashBytes(&m_data[valuesOffset], in.GetOffset() - valuesOffset));
+		}
+		break;
+	}
+	case GL_CAPTURE_READ_BUFFER:
+		glReadBuffer(in.Get<GLenum>());
+		break;
+
+	case GL_CAPTURE_BUFFER_DATA:
+	case GL_CAPTURE_BUFFER_SUB_DATA:
+	{
+		GLenum target = in.Get<GLenum>();
+		int64_t value = in.Get<int64_t>();
+		const void* pData = in.GetData(size);
+		if (command == GL_CAPTURE_BUFFER_DATA)
+		{
+			GLenum usage = in.Get<GLenum>();
+			glBufferData(target, (GLsizeiptr)value, pData, usage);
+			size = (size_t)value;
+			value = 0;
+		}
+		else
+		{
+			glBufferSubData(target, (GLintptr)value, (GLsizeiptr)size, pData);
+		}
+		if (bAnalyze && (NULL != pData))
+		{
+			uint64_t place = (1ULL << 62) ^ ((uint64_t)m_boundBuffers[target] << 32) ^ (uint64_t)value;
+			bDuplicateUpload = SetUploadHash(place, pData, size);
+			uploadBytes = size;
+		}
+		break;
+	}
+	case GL_CAPTURE_COPY_BUFFER_SUB_DATA:
+	{
+		GLenum readTarget = in.Get<GLenum>();
+		GLenum writeTarget = in.Get<GLenum>();
+		int64_t readOffset = in.Get<int64_t>();
+		int64_t writeOffset = in.Get<int64_t>();
+		int64_t copySize = in.Get<int64_t>();
+		glCopyBufferSubData(readTarget, writeTarget, (GLintptr)readOffset, (GLintptr)writeOffset, (GLsizeiptr)copySize);
+		break;
+	}
+	case GL_CAPTURE_TEX_IMAGE_2D:
+	case GL_CAPTURE_TEX_SUB_IMAGE_2D:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLint level = in.Get<GLint>();
+		GLint internalFormat = 0;
+		GLint xoffset = 0;
+		GLint yoffset = 0;
+		if (command == GL_CAPTURE_TEX_IMAGE_2D)
+		{
+			internalFormat = in.Get<GLint>();
+		}
+		else
+		{
+			xoffset = in.Get<GLint>();
+			yoffset = in.Get<GLint>();
+		}
+		GLsizei width = in.Get<GLsizei>();
+		GLsizei height = in.Get<GLsizei>();
+		GLint border = (command == GL_CAPTURE_TEX_IMAGE_2D) ? in.Get<GLint>() : 0;
+		GLenum format = in.Get<GLenum>();
+		GLenum type = in.Get<GLenum>();
+		const void* pPixels = in.GetData(size);
+		if (command == GL_CAPTURE_TEX_IMAGE_2D)
+		{
+			glTexImage2D(target, level, internalFormat, width, height, border, format, type, pPixels);
+		}
+		else
+		{
+			glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pPixels);
+		}
+		if (bAnalyze && (NULL != pPixels))
+		{
+			GLuint texture = m_boundTextures[((uint64_t)m_activeTextureUnit << 32) | GetBindingTarget(target)];
+			uint64_t place = (2ULL << 62) ^ ((uint64_t)texture << 32) ^ ((uint64_t)(target - GetBindingTarget(target)) << 28) ^
+				((uint64_t)level << 24) ^ ((uint64_t)xoffset << 12) ^ (uint64_t)yoffset;
+			bDuplicateUpload = SetUploadHash(place, pPixels, size);
+			uploadBytes = size;
+		}
+		break;
+	}
+	case GL_CAPTURE_TEX_STORAGE_2D:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLsizei levels = in.Get<GLsizei>();
+		GLenum internalFormat = in.Get<GLenum>();
+		GLsizei width = in.Get<GLsizei>();
+		GLsizei height = in.Get<GLsizei>();
+		glTexStorage2D(target, levels, internalFormat, width, height);
+		break;
+	}
+	case GL_CAPTURE_TEX_IMAGE_2D_MULTISAMPLE:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLsizei samples = in.Get<GLsizei>();
+		GLenum internalFormat = in.Get<GLenum>();
+		GLsizei width = in.Get<GLsizei>();
+		GLsizei height = in.Get<GLsizei>();
+		GLboolean fixedSampleLocations = in.Get<GLboolean>();
+		glTexImage2DMultisample(target, samples, internalFormat, width, height, fixedSampleLocations);
+		break;
+	}
+	case GL_CAPTURE_TEX_PARAMETER_I:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLenum pname = in.Get<GLenum>();
+		GLint param = in.Get<GLint>();
+		glTexParameteri(target, pname, param);
+		// the parameters belong to the bound texture
+		if (bAnalyze)
+		{
+			GLuint texture = m_boundTextures[((uint64_t)m_activeTextureUnit << 32) | target];
+			bRedundant = SetShadowState(command, ((uint64_t)texture << 32) | pname, (uint32_t)param);
+		}
+		break;
+	}
+	case GL_CAPTURE_RENDERBUFFER_STORAGE:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLenum internalFormat = in.Get<GLenum>();
+		GLsizei width = in.Get<GLsizei>();
+		GLsizei height = in.Get<GLsizei>();
+		glRenderbufferStorage(target, internalFormat, width, height);
+		break;
+	}
+	case GL_CAPTURE_FRAMEBUFFER_TEXTURE_2D:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLenum attachment = in.Get<GLenum>();
+		GLenum textureTarget = in.Get<GLenum>();
+		GLuint texture = in.Get<GLuint>();
+		GLint level = in.Get<GLint>();
+		glFramebufferTexture2D(target, attachment, textureTarget, MapName(m_textures, texture), level);
+		break;
+	}
+	case GL_CAPTURE_FRAMEBUFFER_RENDERBUFFER:
+	{
+		GLenum target = in.Get<GLenum>();
+		GLenum attachment = in.Get<GLenum>();
+		GLenum renderbufferTarget = in.Get<GLenum>();
+		GLuint renderbuffer = in.Get<GLuint>();
+		glFramebufferRenderbuffer(target, attachment, renderbufferTarget, MapName(m_renderbuffers, renderbuffer));
+		break;
+	}
+	case GL_CAPTURE_VERTEX_ATTRIB_POINTER:
+	{
+		GLuint index = in.Get<GLuint>();
+		GLint components = in.Get<GLint>();
+		GLenum type = in.Get<GLenum>();
+		GLboolean normalized = in.Get<GLboolean>();
+		GLsizei stride = in.Get<GLsizei>();
+		int64_t pointer = in.Get<int64_t>();
+		glVertexAttribPointer(index, components, type, normalized, stride, (const void*)(intptr_t)pointer);
+		// the attribute also takes the array buffer that is bound
+		if (bAnalyze)
+		{
+			uint64_t value = HashBytes(&m_data[valuesOffset], in.GetOffset() - valuesOffset) ^ m_boundBuffers[GL_ARRAY_BUFFER];
+			bRedundant = SetShadowState(command, ((uint64_t)m_vertexArray << 32) | index, value);
+		}
+		break;
+	}
+	case GL_CAPTURE_ENABLE_VERTEX_ATTRIB_ARRAY:
+	{
+		GLuint index = in.Get<GLuint>();
+		glEnableVertexAttribArray(index);
+		if (bAnalyze)
+		{
+			bRedundant = SetShadowState(command, ((uint64_t)m_vertexArray << 32) | index, 1);
+		}
+		break;
+	}
+
+	case GL_CAPTURE_UNIFORM_1I:
+	{
+		GLint location = in.Get<GLint>();
+		GLint v0 = in.Get<GLint>();
+		glUniform1i(MapUniformLocation(location), v0);
+		break;
+	}
+	case GL_CAPTURE_UNIFORM_1UI:
+	{
+		GLint location = in.Get<GLint>();
+		GLuint v0 = in.Get<GLuint>();
+		glUniform1ui(MapUniformLocation(location), v0);
+		break;
+	}
+	case GL_CAPTURE_UNIFORM_1F:
+	case GL_CAPTURE_UNIFORM_2F:
+	case GL_CAPTURE_UNIFORM_3F:
+	case GL_CAPTURE_UNIFORM_4F:
+	{
+		GLint location = in.Get<GLint>();
+		GLfloat v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		int componentCount = command - GL_CAPTURE_UNIFORM_1F + 1;
+		for (int i = 0; i < componentCount; i++)
+		{
+			v[i] = in.Get<GLfloat>();
+		}
+		GLint replayLocation = MapUniformLocation(location);
+		switch (componentCount)
+		{
+		case 1: glUniform1f(replayLocation, v[0]); break;
+		case 2: glUniform2f(replayLocation, v[0], v[1]); break;
+		case 3: glUniform3f(replayLocation, v[0], v[1], v[2]); break;
+		default: glUniform4f(replayLocation, v[0], v[1], v[2], v[3]); break;
+		}
+		break;
+	}
+	case GL_CAPTURE_UNIFORM_1FV:
+	case GL_CAPTURE_UNIFORM_2FV:
+	case GL_CAPTURE_UNIFORM_3FV:
+	case GL_CAPTURE_UNIFORM_4FV:
+	{
+		GLint location = in.Get<GLint>();
+		const GLfloat* pValues = (const GLfloat*)in.GetData(size);
+		int componentCount = command - GL_CAPTURE_UNIFORM_1FV + 1;
+		GLsizei count = (GLsizei)(size / (componentCount * sizeof(GLfloat)));
+		GLint replayLocation = MapUniformLocation(location);
+		switch (componentCount)
+		{
+		case 1: glUniform1fv(replayLocation, count, pValues); break;
+		case 2: glUniform2fv(replayLocation, count, pValues); break;
+		case 3: glUniform3fv(replayLocation, count, pValues); break;
+		default: glUniform4fv(replayLocation, count, pValues); break;
+		}
+		break;
+	}
+	case GL_CAPTURE_UNIFORM_MATRIX_2FV:
+	case GL_CAPTURE_UNIFORM_MATRIX_3FV:
+	case GL_CAPTURE_UNIFORM_MATRIX_4FV:
+	{
+		GLint location = in.Get<GLint>();
+		GLboolean transpose = in.Get<GLboolean>();
+		const GLfloat* pValues = (const GLfloat*)in.GetData(size);
+		int columnCount = command - GL_CAPTURE_UNIFORM_MATRIX_2FV + 2;
+		GLsizei count = (GLsizei)(size / (columnCount * columnCount * sizeof(GLfloat)));
+		GLint replayLocation = MapUniformLocation(location);
+		switch (columnCount)
+		{
+		case 2: glUniformMatrix2fv(replayLocation, count, transpose, pValues); break;
+		case 3: glUniformMatrix3fv(replayLocation, count, transpose, pValues); break;
+		default: glUniformMatrix4fv(replayLocation, count, transpose, pValues); break;
+		}
+		break;
+	}
+
+	case GL_CAPTURE_CLEAR:
+		glClear(in.Get<GLbitfield>());
+		break;
+	case GL_CAPTURE_CLEAR_BUFFER_FV:
+	case GL_CAPTURE_CLEAR_BUFFER_UIV:
+	{
+		GLenum buffer = in.Get<GLenum>();
+		GLint drawBuffer = in.Get<GLint>();
+		const void* pValue = in.GetData(size);
+		if (command == GL_CAPTURE_CLEAR_BUFFER_FV)
+		{
+			glClearBufferfv(buffer, drawBuffer, (const GLfloat*)pValue);
+		}
+		else
+		{
+			glClearBufferuiv(buffer, drawBuffer, (const GLuint*)pValue);
+		}
+		break;
+	}
+	case GL_CAPTURE_DRAW_ARRAYS:
+	{
+		GLenum mode = in.Get<GLenum>();
+		GLint first = in.Get<GLint>();
+		GLsizei count = in.Get<GLsizei>();
+		glDrawArrays(mode, first, count);
+		break;
+	}
+	case GL_CAPTURE_DRAW_ELEMENTS:
+	{
+		GLenum mode = in.Get<GLenum>();
+		GLsizei count = in.Get<GLsizei>();
+		GLenum type = in.Get<GLenum>();
+		int64_t indices = in.Get<int64_t>();
+		glDrawElements(mode, count, type, (const void*)(intptr_t)indices);
+		break;
+	}
+	case GL_CAPTURE_DRAW_ELEMENTS_INDIRECT:
+	{
+		GLenum mode = in.Get<GLenum>();
+		GLenum type = in.Get<GLenum>();
+		int64_t indirect = in.Get<int64_t>();
+		glDrawElementsIndirect(mode, type, (const void*)(intptr_t)indirect);
+		break;
+	}
+	case GL_CAPTURE_MULTI_DRAW_ELEMENTS_INDIRECT:
+	{
+		GLenum mode = in.Get<GLenum>();
+		GLenum type = in.Get<GLenum>();
+		int64_t indirect = in.Get<int64_t>();
+		GLsizei drawCount = in.Get<GLsizei>();
+		GLsizei stride = in.Get<GLsizei>();
+		glMultiDrawElementsIndirect(mode, type, (const void*)(intptr_t)indirect, drawCount, stride);
+		break;
+	}
+	case GL_CAPTURE_DISPATCH_COMPUTE:
+	{
+		GLuint groupsX = in.Get<GLuint>();
+		GLuint groupsY = in.Get<GLuint>();
+		GLuint groupsZ = in.Get<GLuint>();
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+		break;
+	}
+	case GL_CAPTURE_MEMORY_BARRIER:
+		glMemoryBarrier(in.Get<GLbitfield>());
+		break;
+	case GL_CAPTURE_BLIT_FRAMEBUFFER:
+	{
+		GLint rect[8];
+		for (int i = 0; i < 8; i++)
+		{
+			rect[i] = in.Get<GLint>();
+		}
+		GLbitfield mask = in.Get<GLbitfield>();
+		GLenum filter = in.Get<GLenum>();
+		glBlitFramebuffer(rect[0], rect[1], rect[2], rect[3], rect[4], rect[5], rect[6], rect[7], mask, filter);
+		break;
+	}
+	case GL_CAPTURE_INVALIDATE_FRAMEBUFFER:
+	{
+		GLenum target = in.Get<GLenum>();
+		const GLenum* pAttachments = (const GLenum*)in.GetData(size);
+		glInvalidateFramebuffer(target, (GLsizei)(size / sizeof(GLenum)), pAttachments);
+		break;
+	}
+
+	default:
+		std::cout << "ERROR: Unknown command " << command << " in GL capture at byte " << offset << std::endl;
+		return false;
+	}
+
+	if (in.IsBroken())
+	{
+		std::cout << "ERROR: GL capture ends in the middle of " << GetGLCaptureCommandName(command) << std::endl;
+		return false;
+	}
+
+	// the fixed function states are redundant when all of their
+	// values are the same as before
+	if (bAnalyze)
+	{
+		switch (command)
+		{
+		case GL_CAPTURE_DEPTH_MASK:
+		case GL_CAPTURE_DEPTH_FUNC:
+		case GL_CAPTURE_BLEND_FUNC:
+		case GL_CAPTURE_COLOR_MASK:
+		case GL_CAPTURE_VIEWPORT:
+		case GL_CAPTURE_SCISSOR:
+		case GL_CAPTURE_CLEAR_COLOR:
+			bRedundant = SetShadowState(command, 0, HashBytes(&m_data[valuesOffset], in.GetOffset() - valuesOffset));
+			break;
+		}
+
+		// a uniform is redundant when the program already has its value
+		if ((command >= GL_CAPTURE_UNIFORM_1I) && (command <= GL_CAPTURE_UNIFORM_MATRIX_4FV))
+		{
+			uint32_t location = 0;
+			memcpy(&location, &m_data[valuesOffset], sizeof(location));
+			size_t valueOffset = valuesOffset + sizeof(location);
+			bRedundant = SetShadowState(GL_CAPTURE_UNIFORM_1I, GetProgramKey(m_program, location),
+				HashBytes(&m_data[valueOffset], in.GetOffset() - valueOffset));
+		}
+
+		pAnalysis->bRedundant = bRedundant;
+		pAnalysis->bDuplicateUpload = bDuplicateUpload;
+		pAnalysis->uploadBytes = uploadBytes;
+	}
+
+	offset = in.GetOffset();
+	return (command != GL_CAPTURE_END);
+}
+
+/***********************************************************
+ *  SetShadowState()
+ *
+ *  This method is used for setting a state in the shadow of
+ *  the GL state.  The family is the command that sets the
+ *  state and the subkey tells apart its targets, units or
+ *  objects.
+ ***********************************************************/
+bool GLReplay::SetShadowState(int family, uint64_t subkey, uint64_t value)
+{
+	uint64_t key = ((uint64_t)family << 56) ^ subkey;
+	auto state = m_shadowState.find(key);
+	if ((state != m_shadowState.end()) && (state->second == value))
+	{
+		return true;
+	}
+	m_shadowState[key] = value;
+	return false;
+}
+
+/***********************************************************
+ *  SetUploadHash()
+ *
+ *  This method is used for remembering the hash of the data
+ *  uploaded to a place in a buffer or texture.
+ ***********************************************************/
+bool GLReplay::SetUploadHash(uint64_t place, const void* pData, size_t size)
+{
+	uint64_t hash = HashBytes(pData, size) ^ size;
+	auto upload = m_uploadHashes.find(place);
+	if ((upload != m_uploadHashes.end()) && (upload->second == hash))
+	{
+		return true;
+	}
+	m_uploadHashes[place] = hash;
+	return false;
+}
+
+/***********************************************************
+ *  MapName()
+ *
+ *  This method is used for getting the replay's name of a
+ *  captured object.  Names that were not created in the
+ *  capture, like the window framebuffer, stay the same.
+ ***********************************************************/
+GLuint GLReplay::MapName(const std::unordered_map<GLuint, GLuint>& names, GLuint name)
+{
+	auto replayName = names.find(name);
+	return (replayName != names.end()) ? replayName->second : name;
+}
+
+/***********************************************************
+ *  GenNames()
+ *
+ *  This method is used for creating the replay's objects
+ *  for the captured names.
+ ***********************************************************/
+void GLReplay::GenNames(std::unordered_map<GLuint, GLuint>& names, const GLuint* pNames, GLsizei count, PFNGLGENBUFFERSPROC pGen)
+{
+	if ((NULL == pNames) || (count <= 0))
+	{
+		return;
+	}
+
+	std::vector<GLuint> replayNames(count);
+	pGen(count, replayNames.data());
+	for (GLsizei i = 0; i < count; i++)
+	{
+		names[pNames[i]] = replayNames[i];
+	}
+}
+
+/***********************************************************
+ *  DeleteNames()
+ *
+ *  This method is used for deleting the replay's objects
+ *  of the captured names.
+ ***********************************************************/
+void GLReplay::DeleteNames(std::unordered_map<GLuint, GLuint>& names, const GLuint* pNames, GLsizei count, PFNGLDELETEBUFFERSPROC pDelete)
+{
+	if ((NULL == pNames) || (count <= 0))
+	{
+		return;
+	}
+
+	std::vector<GLuint> replayNames(count);
+	for (GLsizei i = 0; i < count; i++)
+	{
+		replayNames[i] = MapName(names, pNames[i]);
+		names.erase(pNames[i]);
+	}
+	pDelete(count, replayNames.data());
+}
+
+/***********************************************************
+ *  MapUniformLocation()
+ *
+ *  This method is used for getting the replay's location of
+ *  a uniform of the program in use.  Locations that were
+ *  never looked up, like the ones set in the shaders, stay
+ *  the same.
+ ***********************************************************/
+GLint GLReplay::MapUniformLocation(GLint location) const
+{
+	if (location < 0)
+	{
+		return location;
+	}
+	auto replayLocation = m_uniformLocations.find(GetProgramKey(m_program, (GLuint)location));
+	return (replayLocation != m_uniformLocations.end()) ? replayLocation->second : location;
+}
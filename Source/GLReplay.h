@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+// glreplay.h
+// ============
+// replay a captured frame of OpenGL commands, time every call and
+// report the redundant state changes and duplicate uploads
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLCapture.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  GLReplay
+ *
+ *  This class replays a file written by the GL capture.
+ *  The commands before the captured frame are replayed once
+ *  to create the objects, then the frame is replayed a
+ *  number of times with a timestamp query and a CPU time
+ *  around every call.  The object names, uniform locations
+ *  and block indices are mapped from the captured ones to
+ *  the replay's own.  While the commands are first replayed,
+ *  a shadow of the GL state is kept to find the calls that
+ *  set a state to the value it already had, and the uploads
+ *  that send the same data to the same place again.
+ ***********************************************************/
+class GLReplay
+{
+public:
+	// constructor
+	GLReplay();
+	// destructor
+	~GLReplay();
+
+	// read a capture file - returns false when it is not one
+	bool Load(const char* filename);
+	// the size of the window that the frame was captured in
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	// replay the file and time the frame over the passes - needs
+	// a current OpenGL context
+	bool Run(int repeatCount);
+	// print the cost per command and the slowest calls, and write
+	// every call to a CSV file when it is not NULL
+	bool Report(const char* csvFilename) const;
+
+private:
+	// a call in the captured frame with its average times
+	struct FRAME_CALL
+	{
+		size_t offset;
+		int command;
+		double cpuMicroseconds;
+		double gpuMicroseconds;
+		bool bRedundant;
+		bool bDuplicateUpload;
+		size_t uploadBytes;
+	};
+
+	// the analysis of one replayed command
+	struct CALL_ANALYSIS
+	{
+		bool bRedundant;
+		bool bDuplicateUpload;
+		size_t uploadBytes;
+	};
+
+	// reads the values of a command from the file
+	class Reader;
+
+	std::vector<unsigned char> m_data;
+	int m_width;
+	int m_height;
+	int m_repeatCount;
+	std::vector<FRAME_CALL> m_calls;
+	std::vector<GLuint> m_queries;
+
+	// the replay's names of the captured objects - shaders and
+	// programs share their names like they do in OpenGL
+	std::unordered_map<GLuint, GLuint> m_buffers;
+	std::unordered_map<GLuint, GLuint> m_vertexArrays;
+	std::unordered_map<GLuint, GLuint> m_textures;
+	std::unordered_map<GLuint, GLuint> m_framebuffers;
+	std::unordered_map<GLuint, GLuint> m_renderbuffers;
+	std::unordered_map<GLuint, GLuint> m_shaderObjects;
+	// the replay's uniform locations and block indices, by the
+	// captured program and location or index
+	std::unordered_map<uint64_t, GLint> m_uniformLocations;
+	std::unordered_map<uint64_t, GLuint> m_blockIndices;
+	// the captured program in use, for mapping the uniforms
+	GLuint m_program;
+
+	// the shadow of the GL state by state key, and the bound
+	// objects by captured name that the uploads go to
+	std::unordered_map<uint64_t, uint64_t> m_shadowState;
+	std::unordered_map<uint64_t, uint64_t> m_uploadHashes;
+	std::unordered_map<GLenum, GLuint> m_boundBuffers;
+	std::unordered_map<uint64_t, GLuint> m_boundTextures;
+	GLuint m_activeTextureUnit;
+	GLuint m_vertexArray;
+	GLuint m_drawFramebuffer;
+
+	// replay one command - returns false at the end of the file or
+	// when the file is broken, and analyses the command when the
+	// analysis is not NULL
+	bool ExecuteCommand(size_t& offset, int& command, CALL_ANALYSIS* pAnalysis);
+	// replay the commands of the captured frame once and time them
+	bool TimeFrame();
+
+	// set a state in the shadow - returns true when it already had
+	// the value
+	bool SetShadowState(int family, uint64_t subkey, uint64_t value);
+	// remember the data uploaded to a place - returns true when the
+	// same data was uploaded there before
+	bool SetUploadHash(uint64_t place, const void* pData, size_t size);
+
+	// get the replay's name of a captured object
+	static GLuint MapName(const std::unordered_map<GLuint, GLuint>& names, GLuint name);
+	// create and delete the replay's objects for captured names
+	static void GenNames(std::unordered_map<GLuint, GLuint>& names, const GLuint* pNames, GLsizei count, PFNGLGENBUFFERSPROC pGen);
+	static void DeleteNames(std::unordered_map<GLuint, GLuint>& names, const GLuint* pNames, GLsizei count, PFNGLDELETEBUFFERSPROC pDelete);
+	// get the replay's location of a uniform of the program in use
+	GLint MapUniformLocation(GLint location) const;
+};
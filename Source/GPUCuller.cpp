@@ -0,0 +1,747 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.cpp
+// ============
+// cull objects and choose their level of detail in a compute shader,
+// which writes the indirect draw commands that the objects are
+// drawn with
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GPUCuller.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <string>
+
+// GLSL declaration of the objects, shared by the culling program
+// and the vertex shaders that draw with the written commands
+const char* const GPUCuller::OBJECT_BUFFER_SOURCE =
+	"struct CullObject\n"
+	"{\n"
+	"	mat4 model;\n"
+	"	vec4 boundsMin;\n"
+	"	vec4 boundsMax;\n"
+	"	uvec4 levels;\n"
+	"};\n"
+	"layout (std430, binding = 0) readonly buffer ObjectBuffer\n"
+	"{\n"
+	"	CullObject objects[];\n"
+	"};\n";
+
+// declaration of global variables
+namespace
+{
+	// objects smaller on screen than these sizes in pixels are
+	// drawn with the second and third level of detail
+	const float LOD_SCREEN_SIZE_1 = 160.0f;
+	const float LOD_SCREEN_SIZE_2 = 48.0f;
+
+	// objects tested by each work group of the culling program
+	const int CULL_GROUP_SIZE = 64;
+
+	// compute shader that writes the draw command of one object
+	// for one viewport - the first pass tests the frustum and the
+	// depth pyramid of the previous frame, and the second pass
+	// tests the objects that the first one hid again against the
+	// pyramid of the current frame
+	const char* g_CullComputeShader =
+		"layout (local_size_x = 64) in;\n"
+		"struct MeshLevel\n"
+		"{\n"
+		"	uint indexCount;\n"
+		"	uint firstIndex;\n"
+		"	int baseVertex;\n"
+		"	uint padding;\n"
+		"};\n"
+		"struct CullView\n"
+		"{\n"
+		"	mat4 viewProjection;\n"
+		"	mat4 occlusionViewProjection;\n"
+		"	vec4 viewPosition;\n"
+		"	vec4 viewport;\n"
+		"	vec4 parameters;\n"
+		"};\n"
+		"struct DrawCommand\n"
+		"{\n"
+		"	uint count;\n"
+		"	uint instanceCount;\n"
+		"	uint firstIndex;\n"
+		"	int baseVertex;\n"
+		"	uint baseInstance;\n"
+		"};\n"
+		"layout (std430, binding = 1) readonly buffer LevelBuffer\n"
+		"{\n"
+		"	MeshLevel levels[];\n"
+		"};\n"
+		"layout (std430, binding = 2) readonly buffer ViewBuffer\n"
+		"{\n"
+		"	CullView views[];\n"
+		"};\n"
+		"layout (std430, binding = 3) writeonly buffer CommandBuffer\n"
+		"{\n"
+		"	DrawCommand commands[];\n"
+		"};\n"
+		"layout (std430, binding = 4) buffer OccludedBuffer\n"
+		"{\n"
+		"	uint occluded[];\n"
+		"};\n"
+		"layout (std430, binding = 5) buffer StatisticsBuffer\n"
+		"{\n"
+		"	uint frustumVisible;\n"
+		"	uint occludedCount;\n"
+		"	uint retestedVisible;\n"
+		"};\n"
+		// the pyramid is bound to DepthPyramid::PYRAMID_TEXTURE_UNIT
+		"layout (binding = 30) uniform sampler2D depthPyramid;\n"
+		"uniform uint objectCount;\n"
+		"uniform uint viewCount;\n"
+		"uniform vec2 lodSizes;\n"
+		"uniform uint cullPass;\n"
+		"uniform int pyramidLevels;\n"
+		// a box is hidden when its nearest depth is behind the
+		// farthest depth of the pyramid texels under it, read from
+		// the level where it covers at most two texels each way
+		"bool IsOccluded(CullObject object, mat4 m, vec4 viewport)\n"
+		"{\n"
+		"	vec3 ndcMin = vec3(1.0f);\n"
+		"	vec3 ndcMax = vec3(-1.0f);\n"
+		"	for (int corner = 0; corner < 8; corner++)\n"
+		"	{\n"
+		"		vec3 position = mix(object.boundsMin.xyz, object.boundsMax.xyz, bvec3((corner & 1) != 0, (corner & 2) != 0, (corner & 4) != 0));\n"
+		"		vec4 clip = m * vec4(position, 1.0f);\n"
+		"		if (clip.w <= 0.0f)\n"
+		"		{\n"
+		"			return false;\n"
+		"		}\n"
+		"		ndcMin = min(ndcMin, clip.xyz / clip.w);\n"
+		"		ndcMax = max(ndcMax, clip.xyz / clip.w);\n"
+		"	}\n"
+		"	if (any(lessThan(ndcMax.xy, vec2(-1.0f))) || any(greaterThan(ndcMin.xy, vec2(1.0f))) || (ndcMin.z < -1.0f))\n"
+		"	{\n"
+		"		return false;\n"
+		"	}\n"
+		"	vec2 pixelMin = viewport.xy + (clamp(ndcMin.xy, -1.0f, 1.0f) * 0.5f + 0.5f) * viewport.zw;\n"
+		"	vec2 pixelMax = viewport.xy + (clamp(ndcMax.xy, -1.0f, 1.0f) * 0.5f + 0.5f) * viewport.zw;\n"
+		"	float nearestDepth = ndcMin.z * 0.5f + 0.5f;\n"
+		"	vec2 size = pixelMax - pixelMin;\n"
+		"	int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0f)))), 0, pyramidLevels - 1);\n"
+		"	ivec2 levelSize = textureSize(depthPyramid, level);\n"
+		"	ivec2 texelMin = clamp(ivec2(pixelMin) >> level, ivec2(0), levelSize - ivec2(1));\n"
+		"	ivec2 texelMax = clamp(ivec2(pixelMax) >> level, ivec2(0), levelSize - ivec2(1));\n"
+		"	float farthest = 0.0f;\n"
+		"	for (int y = texelMin.y; y <= texelMax.y; y++)\n"
+		"	{\n"
+		"		for (int x = texelMin.x; x <= texelMax.x; x++)\n"
+		"		{\n"
+		"			farthest = max(farthest, texelFetch(depthPyramid, ivec2(x, y), level).r);\n"
+		"		}\n"
+		"	}\n"
+		"	return (nearestDepth > farthest);\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	uint objectIndex = gl_GlobalInvocationID.x;\n"
+		"	uint viewIndex = gl_GlobalInvocationID.y;\n"
+		"	if ((objectIndex >= objectCount) || (viewIndex >= viewCount))\n"
+		"	{\n"
+		"		return;\n"
+		"	}\n"
+		"	CullObject object = objects[objectIndex];\n"
+		"	CullView view = views[viewIndex];\n"
+		"	uint flagIndex = viewIndex * objectCount + objectIndex;\n"
+		"	bool bVisible = true;\n"
+		"	if (cullPass == 0u)\n"
+		"	{\n"
+		"		mat4 m = view.viewProjection;\n"
+		// the corner furthest along each clipping plane normal is
+		// tested, so a box is only culled when it is fully outside
+		"		for (int axis = 0; axis < 3; axis++)\n"
+		"		{\n"
+		"			for (int side = 0; side < 2; side++)\n"
+		"			{\n"
+		"				float sign = (side == 0) ? 1.0f : -1.0f;\n"
+		"				vec4 plane = vec4(m[0][3], m[1][3], m[2][3], m[3][3]) + sign * vec4(m[0][axis], m[1][axis], m[2][axis], m[3][axis]);\n"
+		"				vec3 corner = mix(object.boundsMin.xyz, object.boundsMax.xyz, greaterThanEqual(plane.xyz, vec3(0.0f)));\n"
+		"				if (dot(plane.xyz, corner) + plane.w < 0.0f)\n"
+		"				{\n"
+		"					bVisible = false;\n"
+		"				}\n"
+		"			}\n"
+		"		}\n"
+		"		bool bOccluded = false;\n"
+		"		if (bVisible)\n"
+		"		{\n"
+		"			atomicAdd(frustumVisible, 1u);\n"
+		"			if (view.parameters.z != 0.0f)\n"
+		"			{\n"
+		"				bOccluded = IsOccluded(object, view.occlusionViewProjection, view.viewport);\n"
+		"			}\n"
+		"		}\n"
+		"		if (bOccluded)\n"
+		"		{\n"
+		"			atomicAdd(occludedCount, 1u);\n"
+		"			bVisible = false;\n"
+		"		}\n"
+		"		occluded[flagIndex] = bOccluded ? 1u : 0u;\n"
+		"	}\n"
+		"	else\n"
+		"	{\n"
+		"		bVisible = (occluded[flagIndex] != 0u) && !IsOccluded(object, view.viewProjection, view.viewport);\n"
+		"		if (bVisible)\n"
+		"		{\n"
+		"			atomicAdd(retestedVisible, 1u);\n"
+		"		}\n"
+		"	}\n"
+		// the level of detail follows the size of the bounding
+		// sphere on screen
+		"	vec3 center = (object.boundsMin.xyz + object.boundsMax.xyz) * 0.5f;\n"
+		"	float radius = length(object.boundsMax.xyz - object.boundsMin.xyz) * 0.5f;\n"
+		"	float screenSize = 2.0f * radius * view.parameters.x;\n"
+		"	if (view.parameters.y == 0.0f)\n"
+		"	{\n"
+		"		float distance = length(center - view.viewPosition.xyz);\n"
+		"		screenSize = (distance > radius) ? screenSize / distance : 1.0e30f;\n"
+		"	}\n"
+		"	uint level = (screenSize >= lodSizes.x) ? 0u : ((screenSize >= lodSizes.y) ? 1u : 2u);\n"
+		"	level = min(level, object.levels.y - 1u);\n"
+		"	MeshLevel meshLevel = levels[object.levels.x + level];\n"
+		"	DrawCommand command;\n"
+		"	command.count = meshLevel.indexCount;\n"
+		"	command.instanceCount = bVisible ? 1u : 0u;\n"
+		"	command.firstIndex = meshLevel.firstIndex;\n"
+		"	command.baseVertex = meshLevel.baseVertex;\n"
+		"	command.baseInstance = objectIndex;\n"
+		"	commands[(cullPass * viewCount + viewIndex) * objectCount + objectIndex] = command;\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  GPUCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GPUCuller::GPUCuller()
+{
+	m_cullProgramID = 0;
+	m_objectCountLocation = -1;
+	m_viewCountLocation = -1;
+	m_lodSizesLocation = -1;
+	m_cullPassLocation = -1;
+	m_pyramidLevelsLocation = -1;
+	m_bBuilt = false;
+	m_firstMovedObject = INT_MAX;
+	m_lastMovedObject = -1;
+	m_vertexArrayID = 0;
+	m_vertexBufferID = 0;
+	m_indexBufferID = 0;
+	m_objectBufferID = 0;
+	m_levelBufferID = 0;
+	m_viewBufferID = 0;
+	m_commandBufferID = 0;
+	m_occludedBufferID = 0;
+	m_statisticsBufferID = 0;
+	m_viewCount = 0;
+	m_occlusionViewCount = 0;
+	m_readbackBufferID = 0;
+	m_readbackFence = NULL;
+}
+
+/***********************************************************
+ *  ~GPUCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GPUCuller::~GPUCuller()
+{
+	DeleteBuffers();
+	DeleteTrackedProgram(m_cullProgramID);
+	if (NULL != m_readbackFence)
+	{
+		glDeleteSync(m_readbackFence);
+		m_readbackFence = NULL;
+	}
+	DeleteTrackedBuffer(m_readbackBufferID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the culling program.
+ *  The vertex shaders that draw with the written commands
+ *  read gl_BaseInstance, which needs OpenGL 4.6.
+ ***********************************************************/
+bool GPUCuller::Initialize()
+{
+	if (!GLEW_VERSION_4_6)
+	{
+		std::cout << "INFO: GPU culling needs OpenGL 4.6, objects are culled on the CPU" << std::endl;
+		return false;
+	}
+
+	std::string source = std::string("#version 460 core\n") + OBJECT_BUFFER_SOURCE + g_CullComputeShader;
+	m_cullProgramID = ShaderCache::CompileComputeProgram(source.c_str());
+	if (0 == m_cullProgramID)
+	{
+		return false;
+	}
+
+	m_objectCountLocation = glGetUniformLocation(m_cullProgramID, "objectCount");
+	m_viewCountLocation = glGetUniformLocation(m_cullProgramID, "viewCount");
+	m_lodSizesLocation = glGetUniformLocation(m_cullProgramID, "lodSizes");
+	m_cullPassLocation = glGetUniformLocation(m_cullProgramID, "cullPass");
+	m_pyramidLevelsLocation = glGetUniformLocation(m_cullProgramID, "pyramidLevels");
+
+	m_readbackBufferID = GenTrackedBuffer("cull statistics readback");
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, sizeof(CULL_STATISTICS), NULL, GL_STREAM_READ);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_readbackBufferID, sizeof(CULL_STATISTICS));
+
+	return true;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for removing the added meshes and
+ *  objects, before adding the ones of a changed scene.
+ ***********************************************************/
+void GPUCuller::Reset()
+{
+	DeleteBuffers();
+	m_objects.clear();
+	m_meshes.clear();
+	m_levels.clear();
+	m_levelSources.clear();
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for adding a mesh with up to three
+ *  levels of detail, ordered from the finest.  The levels
+ *  are copied into the shared buffers when the objects are
+ *  built, so the passed in buffers must stay loaded until
+ *  then.
+ ***********************************************************/
+int GPUCuller::AddMesh(const MeshGenerator::MESH_BUFFERS* pLevels, int levelCount)
+{
+	CULL_MESH mesh;
+	mesh.firstLevel = (int)m_levels.size();
+	mesh.levelCount = std::min(levelCount, MAX_MESH_LEVELS);
+	for (int i = 0; i < mesh.levelCount; i++)
+	{
+		MESH_LEVEL level = {};
+		level.indexCount = (GLuint)pLevels[i].indexCount;
+		m_levels.push_back(level);
+		m_levelSources.push_back(pLevels[i]);
+	}
+	m_meshes.push_back(mesh);
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding an object that is drawn
+ *  with a mesh, at a world transform with world bounds.
+ ***********************************************************/
+int GPUCuller::AddObject(int mesh, const glm::mat4& modelMatrix, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	CULL_OBJECT object = {};
+	object.modelMatrix = modelMatrix;
+	object.boundsMin = glm::vec4(boundsMin, 1.0f);
+	object.boundsMax = glm::vec4(boundsMax, 1.0f);
+	object.firstLevel = (GLuint)m_meshes[mesh].firstLevel;
+	object.levelCount = (GLuint)m_meshes[mesh].levelCount;
+	m_objects.push_back(object);
+	m_bBuilt = false;
+
+	return (int)m_objects.size() - 1;
+}
+
+/***********************************************************
+ *  SetObjectTransform()
+ *
+ *  This method is used for moving an object that was added
+ *  before.  The range of moved objects is kept, and copied
+ *  into the object buffer with one call by the next cull,
+ *  so moving many objects in a frame costs one upload.
+ ***********************************************************/
+void GPUCuller::SetObjectTransform(int objectIndex, const glm::mat4& modelMatrix, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objects.size()))
+	{
+		return;
+	}
+
+	CULL_OBJECT& object = m_objects[objectIndex];
+	object.modelMatrix = modelMatrix;
+	object.boundsMin = glm::vec4(boundsMin, 1.0f);
+	object.boundsMax = glm::vec4(boundsMax, 1.0f);
+	m_firstMovedObject = std::min(m_firstMovedObject, objectIndex);
+	m_lastMovedObject = std::max(m_lastMovedObject, objectIndex);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for copying the levels of the added
+ *  meshes into the shared vertex and index buffers, with
+ *  GPU side copies from their own buffers, and for creating
+ *  the object, view and command buffers.
+ ***********************************************************/
+bool GPUCuller::Build()
+{
+	const GLsizei stride = MeshGenerator::FLOATS_PER_VERTEX * sizeof(GLfloat);
+
+	DeleteBuffers();
+	if (m_objects.empty() || (0 == m_cullProgramID))
+	{
+		return false;
+	}
+
+	// place each level after the previous one in the shared buffers
+	std::vector<GLint64> vertexBytes(m_levels.size(), 0);
+	GLint64 totalVertexBytes = 0;
+	GLint64 totalIndexCount = 0;
+	for (size_t i = 0; i < m_levels.size(); i++)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_levelSources[i].vbo);
+		glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes[i]);
+
+		m_levels[i].firstIndex = (GLuint)totalIndexCount;
+		m_levels[i].baseVertex = (GLint)(totalVertexBytes / stride);
+		totalVertexBytes += vertexBytes[i];
+		totalIndexCount += m_levels[i].indexCount;
+	}
+
+	m_vertexBufferID = GenTrackedBuffer("culled mesh vertices");
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, totalVertexBytes, NULL, GL_STATIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_vertexBufferID, (size_t)totalVertexBytes);
+	for (size_t i = 0; i < m_levels.size(); i++)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_levelSources[i].vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)m_levels[i].baseVertex * stride, vertexBytes[i]);
+	}
+
+	m_indexBufferID = GenTrackedBuffer("culled mesh indices");
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBufferID);
+	glBufferData(GL_COPY_WRITE_BUFFER, totalIndexCount * sizeof(GLuint), NULL, GL_STATIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_indexBufferID, (size_t)totalIndexCount * sizeof(GLuint));
+	for (size_t i = 0; i < m_levels.size(); i++)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_levelSources[i].ebo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+			(GLintptr)m_levels[i].firstIndex * sizeof(GLuint), (GLsizeiptr)m_levels[i].indexCount * sizeof(GLuint));
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// vertex positions, normals and texture coordinates, in the
+	// layout of the generated meshes
+	m_vertexArrayID = GenTrackedVertexArray("culled meshes");
+	glBindVertexArray(m_vertexArrayID);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferID);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	size_t objectBytes = m_objects.size() * sizeof(CULL_OBJECT);
+	size_t levelBytes = m_levels.size() * sizeof(MESH_LEVEL);
+	size_t viewBytes = MAX_SCENE_VIEWS * sizeof(CULL_VIEW);
+	size_t commandBytes = m_objects.size() * MAX_SCENE_VIEWS * COMMAND_SET_COUNT * sizeof(DRAW_COMMAND);
+	size_t occludedBytes = m_objects.size() * MAX_SCENE_VIEWS * sizeof(GLuint);
+
+	m_objectBufferID = GenTrackedBuffer("culled objects");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, objectBytes, m_objects.data(), GL_DYNAMIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_objectBufferID, objectBytes);
+
+	m_levelBufferID = GenTrackedBuffer("culled mesh levels");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_levelBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, levelBytes, m_levels.data(), GL_STATIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_levelBufferID, levelBytes);
+
+	m_viewBufferID = GenTrackedBuffer("cull views");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_viewBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, viewBytes, NULL, GL_DYNAMIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_viewBufferID, viewBytes);
+
+	// the commands are only written and read by the GPU
+	m_commandBufferID = GenTrackedBuffer("draw commands");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, NULL, GL_DYNAMIC_COPY);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_commandBufferID, commandBytes);
+
+	m_occludedBufferID = GenTrackedBuffer("occluded objects");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_occludedBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, occludedBytes, NULL, GL_DYNAMIC_COPY);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_occludedBufferID, occludedBytes);
+
+	m_statisticsBufferID = GenTrackedBuffer("cull statistics");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statisticsBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(CULL_STATISTICS), NULL, GL_DYNAMIC_COPY);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_statisticsBufferID, sizeof(CULL_STATISTICS));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// a depth pyramid from before the objects changed is not used
+	m_viewCount = 0;
+	m_occlusionViewCount = 0;
+	m_bBuilt = true;
+
+	return true;
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for running the culling program for
+ *  every object in every viewport, with one dispatch.  A
+ *  viewport is only tested against the depth pyramid when
+ *  the pyramid was built for the same viewport in the
+ *  previous frame.  The commands can be drawn with once the
+ *  barrier has passed.
+ ***********************************************************/
+void GPUCuller::Cull(const SCENE_VIEW* pSceneViews, int sceneViewCount, const DepthPyramid* pDepthPyramid)
+{
+	if ((false == m_bBuilt) || (sceneViewCount <= 0))
+	{
+		return;
+	}
+
+	bool bOcclusion = (NULL != pDepthPyramid) && pDepthPyramid->IsBuilt();
+	m_viewCount = std::min(sceneViewCount, MAX_SCENE_VIEWS);
+	for (int i = 0; i < m_viewCount; i++)
+	{
+		const SCENE_VIEW& sceneView = pSceneViews[i];
+		bool bOrthographic = (sceneView.projection[3][3] == 1.0f);
+		bool bOcclusionView = bOcclusion && (i < m_occlusionViewCount) &&
+			(m_occlusionViewports[i] == glm::vec4((float)sceneView.x, (float)sceneView.y, (float)sceneView.width, (float)sceneView.height));
+		m_views[i].viewProjection = sceneView.projection * sceneView.view;
+		m_views[i].occlusionViewProjection = bOcclusionView ? m_occlusionViewProjections[i] : m_views[i].viewProjection;
+		m_views[i].viewPosition = glm::vec4(sceneView.viewPosition, 1.0f);
+		m_views[i].viewport = glm::vec4((float)sceneView.x, (float)sceneView.y, (float)sceneView.width, (float)sceneView.height);
+		m_views[i].parameters = glm::vec4(
+			sceneView.projection[1][1] * (float)sceneView.height * 0.5f,
+			bOrthographic ? 1.0f : 0.0f,
+			bOcclusionView ? 1.0f : 0.0f,
+			0.0f);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_viewBufferID);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_viewCount * sizeof(CULL_VIEW), m_views);
+
+	// the objects moved since the last cull
+	if (m_firstMovedObject <= m_lastMovedObject)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBufferID);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_firstMovedObject * sizeof(CULL_OBJECT),
+			(m_lastMovedObject - m_firstMovedObject + 1) * sizeof(CULL_OBJECT), &m_objects[m_firstMovedObject]);
+		m_firstMovedObject = INT_MAX;
+		m_lastMovedObject = -1;
+	}
+
+	// the counts start again for each frame
+	const CULL_STATISTICS noStatistics = {};
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statisticsBufferID);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(CULL_STATISTICS), &noStatistics);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	Dispatch(COMMANDS_VISIBLE, bOcclusion ? pDepthPyramid : NULL);
+}
+
+/***********************************************************
+ *  RetestOccluded()
+ *
+ *  This method is used for testing the objects hidden by
+ *  the first test of the frame again, against a depth
+ *  pyramid built from the objects drawn so far.  The
+ *  objects that are not hidden by it get commands in the
+ *  retested set.  The pyramid is then kept, with the views
+ *  it was built for, for the first test of the next frame.
+ ***********************************************************/
+void GPUCuller::RetestOccluded(const DepthPyramid& depthPyramid)
+{
+	if ((false == m_bBuilt) || (0 == m_viewCount) || (false == depthPyramid.IsBuilt()))
+	{
+		m_occlusionViewCount = 0;
+		return;
+	}
+
+	Dispatch(COMMANDS_RETESTED, &depthPyramid);
+
+	m_occlusionViewCount = m_viewCount;
+	for (int i = 0; i < m_viewCount; i++)
+	{
+		m_occlusionViewProjections[i] = m_views[i].viewProjection;
+		m_occlusionViewports[i] = m_views[i].viewport;
+	}
+
+	// copy the counts of the frame for reading back, unless the
+	// copy of an earlier frame has not been read yet
+	if (NULL == m_readbackFence)
+	{
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_statisticsBufferID);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(CULL_STATISTICS));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+/***********************************************************
+ *  Dispatch()
+ *
+ *  This method is used for running one pass of the culling
+ *  program over every object and viewport.
+ ***********************************************************/
+void GPUCuller::Dispatch(int cullPass, const DepthPyramid* pDepthPyramid)
+{
+	glUseProgram(m_cullProgramID);
+	glUniform1ui(m_objectCountLocation, (GLuint)m_objects.size());
+	glUniform1ui(m_viewCountLocation, (GLuint)m_viewCount);
+	glUniform2f(m_lodSizesLocation, LOD_SCREEN_SIZE_1, LOD_SCREEN_SIZE_2);
+	glUniform1ui(m_cullPassLocation, (GLuint)cullPass);
+	glUniform1i(m_pyramidLevelsLocation, (NULL != pDepthPyramid) ? pDepthPyramid->GetLevelCount() : 1);
+	if (NULL != pDepthPyramid)
+	{
+		glActiveTexture(GL_TEXTURE0 + DepthPyramid::PYRAMID_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, pDepthPyramid->GetTextureID());
+		glActiveTexture(GL_TEXTURE0);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_levelBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_viewBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_commandBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_occludedBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_statisticsBufferID);
+
+	GLuint groupCount = ((GLuint)m_objects.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+	glDispatchCompute(groupCount, (GLuint)m_viewCount, 1);
+
+	// the draws read the commands as indirect arguments, and the
+	// second pass reads the flags written by the first
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************
+ *  DrawObjects()
+ *
+ *  This method is used for drawing a range of objects in a
+ *  viewport with a set of the commands written for it,
+ *  using the active program.  The culled objects have no
+ *  instances, so the GPU skips them.
+ ***********************************************************/
+void GPUCuller::DrawObjects(int viewIndex, int firstObject, int objectCount, COMMAND_SET commandSet) const
+{
+	if ((false == m_bBuilt) || (objectCount <= 0) || (viewIndex >= m_viewCount))
+	{
+		return;
+	}
+
+	size_t offset = (((size_t)commandSet * m_viewCount + viewIndex) * m_objects.size() + firstObject) * sizeof(DRAW_COMMAND);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, m_objectBufferID);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBufferID);
+	glBindVertexArray(m_vertexArrayID);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, objectCount, 0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawObject()
+ *
+ *  This method is used for drawing one object in a viewport
+ *  with the level of detail chosen for it, for programs that
+ *  take the object values as uniforms.
+ ***********************************************************/
+void GPUCuller::DrawObject(int viewIndex, int objectIndex, COMMAND_SET commandSet) const
+{
+	if ((false == m_bBuilt) || (viewIndex >= m_viewCount))
+	{
+		return;
+	}
+
+	size_t offset = (((size_t)commandSet * m_viewCount + viewIndex) * m_objects.size() + objectIndex) * sizeof(DRAW_COMMAND);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBufferID);
+	glBindVertexArray(m_vertexArrayID);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset);
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  ReadStatistics()
+ *
+ *  This method is used for reading the copied counts if the
+ *  GPU has finished the copy.  The fence is checked without
+ *  waiting, so the counts are a frame or two old.
+ ***********************************************************/
+bool GPUCuller::ReadStatistics(CULL_STATISTICS& statistics)
+{
+	if (NULL == m_readbackFence)
+	{
+		return false;
+	}
+
+	GLenum status = glClientWaitSync(m_readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+	glDeleteSync(m_readbackFence);
+	m_readbackFence = NULL;
+	if (status == GL_WAIT_FAILED)
+	{
+		return false;
+	}
+
+	bool bRead = false;
+	glBindBuffer(GL_COPY_READ_BUFFER, m_readbackBufferID);
+	const CULL_STATISTICS* pStatistics = (const CULL_STATISTICS*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, sizeof(CULL_STATISTICS), GL_MAP_READ_BIT);
+	if (NULL != pStatistics)
+	{
+		statistics = *pStatistics;
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		bRead = true;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	return bRead;
+}
+
+/***********************************************************
+ *  DeleteBuffers()
+ *
+ *  This method is used for freeing the buffers of the built
+ *  objects and meshes.
+ ***********************************************************/
+void GPUCuller::DeleteBuffers()
+{
+	// a new object buffer is written from all of the objects
+	m_firstMovedObject = INT_MAX;
+	m_lastMovedObject = -1;
+
+	DeleteTrackedVertexArray(m_vertexArrayID);
+	DeleteTrackedBuffer(m_vertexBufferID);
+	DeleteTrackedBuffer(m_indexBufferID);
+	DeleteTrackedBuffer(m_objectBufferID);
+	DeleteTrackedBuffer(m_levelBufferID);
+	DeleteTrackedBuffer(m_viewBufferID);
+	DeleteTrackedBuffer(m_commandBufferID);
+	DeleteTrackedBuffer(m_occludedBufferID);
+	DeleteTrackedBuffer(m_statisticsBufferID);
+	m_bBuilt = false;
+}
@@ -0,0 +1,229 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.h
+// ============
+// cull objects and choose their level of detail in a compute shader,
+// which writes the indirect draw commands that the objects are
+// drawn with
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+#include "SceneView.h"
+#include "DepthPyramid.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  GPUCuller
+ *
+ *  This class keeps the transforms and bounds of a set of
+ *  objects in shader storage buffers, and the levels of
+ *  detail of their meshes together in one vertex and index
+ *  buffer.  Each frame, a compute shader tests every object
+ *  against the frustum of every viewport, picks the level
+ *  of detail for its size on screen, and writes one draw
+ *  command per object and viewport, with no instances when
+ *  the object is culled.  A whole range of objects is then
+ *  drawn with a single multi-draw call, so the CPU work of
+ *  the frame does not grow with the number of objects.
+ *
+ *  Objects in the frustum can also be tested against the
+ *  depth pyramid of the previous frame, seen from where the
+ *  viewports were then.  The objects it hides are tested
+ *  again against the pyramid of the current frame once the
+ *  visible objects are drawn, and the ones that have come
+ *  into view are drawn with a second set of commands, so
+ *  they do not appear a frame late.
+ ***********************************************************/
+class GPUCuller
+{
+public:
+	// the most levels of detail of a mesh
+	static const int MAX_MESH_LEVELS = 3;
+	// shader storage binding of the object transforms, which
+	// the vertex shaders index with gl_BaseInstance
+	static const int OBJECT_BUFFER_BINDING = 0;
+
+	// GLSL declaration of the object buffer, for the vertex
+	// shaders of the passes drawn with the commands
+	static const char* const OBJECT_BUFFER_SOURCE;
+
+	// the sets of draw commands written for each viewport
+	enum COMMAND_SET
+	{
+		// the objects that pass the first test of the frame
+		COMMANDS_VISIBLE,
+		// the objects hidden in the previous frame that are
+		// visible in the current one
+		COMMANDS_RETESTED,
+		COMMAND_SET_COUNT
+	};
+
+	// the objects counted by the culling of a frame, summed over
+	// the viewports
+	struct CULL_STATISTICS
+	{
+		// objects inside the frustum, which is what frustum culling
+		// alone would draw
+		GLuint frustumVisible;
+		// objects in the frustum hidden by the previous frame
+		GLuint occluded;
+		// hidden objects that were visible when tested again
+		GLuint retestedVisible;
+		GLuint padding;
+	};
+
+	// constructor
+	GPUCuller();
+	// destructor
+	~GPUCuller();
+
+	// compile the culling program - returns false when the
+	// driver cannot run it
+	bool Initialize();
+	// check whether the culling program is available
+	bool IsAvailable() const { return (0 != m_cullProgramID); }
+
+	// remove the meshes and objects
+	void Reset();
+	// add a mesh with its levels of detail, finest first - returns
+	// the mesh handle
+	int AddMesh(const MeshGenerator::MESH_BUFFERS* pLevels, int levelCount);
+	// add an object drawn with a mesh - returns the object index
+	int AddObject(int mesh, const glm::mat4& modelMatrix, glm::vec3 boundsMin, glm::vec3 boundsMax);
+	// move an added object, which is copied into the object buffer
+	// by the next cull
+	void SetObjectTransform(int objectIndex, const glm::mat4& modelMatrix, glm::vec3 boundsMin, glm::vec3 boundsMax);
+	// copy the meshes and objects into the buffers
+	bool Build();
+	// check whether the buffers hold the added objects
+	bool IsBuilt() const { return m_bBuilt; }
+	// get the number of added objects
+	int GetObjectCount() const { return (int)m_objects.size(); }
+
+	// write the draw commands of every object for the viewports,
+	// hiding the objects behind the depth pyramid of the previous
+	// frame when one is passed in
+	void Cull(const SCENE_VIEW* pSceneViews, int sceneViewCount, const DepthPyramid* pDepthPyramid);
+	// test the hidden objects again against the depth pyramid of
+	// the current frame, which is kept for the next frame
+	void RetestOccluded(const DepthPyramid& depthPyramid);
+	// draw a range of objects in a viewport with one call
+	void DrawObjects(int viewIndex, int firstObject, int objectCount, COMMAND_SET commandSet = COMMANDS_VISIBLE) const;
+	// draw one object in a viewport
+	void DrawObject(int viewIndex, int objectIndex, COMMAND_SET commandSet = COMMANDS_VISIBLE) const;
+	// read the counts of an earlier frame once the GPU has written
+	// them - returns false while they are not ready
+	bool ReadStatistics(CULL_STATISTICS& statistics);
+
+private:
+	// an object in the object buffer, laid out for std430
+	struct CULL_OBJECT
+	{
+		glm::mat4 modelMatrix;
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		// first level in the level buffer and number of levels
+		GLuint firstLevel;
+		GLuint levelCount;
+		GLuint padding[2];
+	};
+
+	// the indices of one level of detail in the shared buffers
+	struct MESH_LEVEL
+	{
+		GLuint indexCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint padding;
+	};
+
+	// the levels of detail of an added mesh
+	struct CULL_MESH
+	{
+		int firstLevel;
+		int levelCount;
+	};
+
+	// the view values of a viewport, laid out for std430
+	struct CULL_VIEW
+	{
+		glm::mat4 viewProjection;
+		// the view and projection that the depth pyramid of the
+		// previous frame was drawn with
+		glm::mat4 occlusionViewProjection;
+		glm::vec4 viewPosition;
+		// area of the viewport in the depth pyramid
+		glm::vec4 viewport;
+		// pixels covered by one unit at a distance of one, 1 for
+		// an orthographic projection, and 1 when the objects are
+		// tested against the depth pyramid
+		glm::vec4 parameters;
+	};
+
+	// an indirect draw command as read by glMultiDrawElementsIndirect
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	GLuint m_cullProgramID;
+	GLint m_objectCountLocation;
+	GLint m_viewCountLocation;
+	GLint m_lodSizesLocation;
+	GLint m_cullPassLocation;
+	GLint m_pyramidLevelsLocation;
+
+	// the added objects, meshes and levels, and the mesh buffers
+	// that each level is copied from
+	std::vector<CULL_OBJECT> m_objects;
+	std::vector<CULL_MESH> m_meshes;
+	std::vector<MESH_LEVEL> m_levels;
+	std::vector<MeshGenerator::MESH_BUFFERS> m_levelSources;
+	bool m_bBuilt;
+	// the range of objects moved since the object buffer was
+	// last written, empty when the first is past the last
+	int m_firstMovedObject;
+	int m_lastMovedObject;
+
+	// shared vertex and index buffers of all of the levels
+	GLuint m_vertexArrayID;
+	GLuint m_vertexBufferID;
+	GLuint m_indexBufferID;
+	// objects, levels, viewports and the draw commands written
+	// for each viewport
+	GLuint m_objectBufferID;
+	GLuint m_levelBufferID;
+	GLuint m_viewBufferID;
+	GLuint m_commandBufferID;
+	// one flag per object and viewport for the objects hidden by
+	// the first test, and the counts of the frame
+	GLuint m_occludedBufferID;
+	GLuint m_statisticsBufferID;
+
+	// the viewports of the last cull, and the number of them that
+	// the depth pyramid kept from the previous frame was built for
+	CULL_VIEW m_views[MAX_SCENE_VIEWS];
+	int m_viewCount;
+	int m_occlusionViewCount;
+	glm::mat4 m_occlusionViewProjections[MAX_SCENE_VIEWS];
+	glm::vec4 m_occlusionViewports[MAX_SCENE_VIEWS];
+
+	// buffer that the counts are copied into, with a fence that
+	// tells when the copy is done
+	GLuint m_readbackBufferID;
+	GLsync m_readbackFence;
+
+	// run the culling program for one of the tests
+	void Dispatch(int cullPass, const DepthPyramid* pDepthPyramid);
+	// free the buffers of the built objects
+	void DeleteBuffers();
+};
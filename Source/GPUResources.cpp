@@ -0,0 +1,358 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.cpp
+// ============
+// create and delete OpenGL objects through a tracker that counts
+// the memory they hold and reports the ones that are never freed
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GPUResources.h"
+
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// a tracked object, with the bytes it holds and its owner
+	struct TRACKED_RESOURCE
+	{
+		size_t bytes;
+		const char* label;
+	};
+
+	// names of the kinds of objects, for the reports
+	const char* const g_ResourceTypeNames[GPU_RESOURCE_TYPE_COUNT] =
+	{
+		"textures",
+		"buffers",
+		"vertex arrays",
+		"programs"
+	};
+
+	// the objects of each kind that are alive, and their total
+	// bytes - the objects are created on the render thread, but
+	// the usage can be read from any thread
+	std::mutex g_ResourceMutex;
+	std::unordered_map<GLuint, TRACKED_RESOURCE> g_Resources[GPU_RESOURCE_TYPE_COUNT];
+	size_t g_ResourceBytes[GPU_RESOURCE_TYPE_COUNT] = {};
+
+	/***********************************************************
+	 *  TrackResource()
+	 *
+	 *  This function is used for starting to track a newly
+	 *  created object, which holds no memory until its size
+	 *  is set.
+	 ***********************************************************/
+	void TrackResource(GPU_RESOURCE_TYPE type, GLuint id, const char* label)
+	{
+		if (0 == id)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(g_ResourceMutex);
+		TRACKED_RESOURCE resource;
+		resource.bytes = 0;
+		resource.label = label;
+		g_Resources[type][id] = resource;
+	}
+
+	/***********************************************************
+	 *  UntrackResource()
+	 *
+	 *  This function is used for stopping the tracking of an
+	 *  object that is being deleted.
+	 ***********************************************************/
+	void UntrackResource(GPU_RESOURCE_TYPE type, GLuint id)
+	{
+		std::lock_guard<std::mutex> lock(g_ResourceMutex);
+		auto found = g_Resources[type].find(id);
+		if (found != g_Resources[type].end())
+		{
+			g_ResourceBytes[type] -= found->second.bytes;
+			g_Resources[type].erase(found);
+		}
+	}
+
+	/***********************************************************
+	 *  GetBytesPerPixel()
+	 *
+	 *  This function is used for getting the bytes that one
+	 *  pixel of an internal format takes.  Three channel
+	 *  formats are counted as four, as drivers pad them.
+	 ***********************************************************/
+	size_t GetBytesPerPixel(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_R8:
+			return 1;
+		case GL_R16F:
+		case GL_RG8:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_RGBA16F:
+		case GL_RG32F:
+		case GL_RGB16F:
+			return 8;
+		case GL_RGBA32F:
+		case GL_RGB32F:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+}
+
+/***********************************************************
+ *  GenTrackedTexture()
+ *
+ *  This function is used for creating a texture object that
+ *  is tracked until it is deleted.
+ ***********************************************************/
+GLuint GenTrackedTexture(const char* label)
+{
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	TrackResource(GPU_RESOURCE_TEXTURE, textureID, label);
+
+	return textureID;
+}
+
+/***********************************************************
+ *  DeleteTrackedTexture()
+ *
+ *  This function is used for deleting a tracked texture and
+ *  clearing the passed in ID.
+ ***********************************************************/
+void DeleteTrackedTexture(GLuint& textureID)
+{
+	if (0 != textureID)
+	{
+		UntrackResource(GPU_RESOURCE_TEXTURE, textureID);
+		glDeleteTextures(1, &textureID);
+		textureID = 0;
+	}
+}
+
+/***********************************************************
+ *  GenTrackedBuffer()
+ *
+ *  This function is used for creating a buffer object that
+ *  is tracked until it is deleted.
+ ***********************************************************/
+GLuint GenTrackedBuffer(const char* label)
+{
+	GLuint bufferID = 0;
+	glGenBuffers(1, &bufferID);
+	TrackResource(GPU_RESOURCE_BUFFER, bufferID, label);
+
+	return bufferID;
+}
+
+/***********************************************************
+ *  DeleteTrackedBuffer()
+ *
+ *  This function is used for deleting a tracked buffer and
+ *  clearing the passed in ID.
+ ***********************************************************/
+void DeleteTrackedBuffer(GLuint& bufferID)
+{
+	if (0 != bufferID)
+	{
+		UntrackResource(GPU_RESOURCE_BUFFER, bufferID);
+		glDeleteBuffers(1, &bufferID);
+		bufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  GenTrackedVertexArray()
+ *
+ *  This function is used for creating a vertex array object
+ *  that is tracked until it is deleted.
+ ***********************************************************/
+GLuint GenTrackedVertexArray(const char* label)
+{
+	GLuint vertexArrayID = 0;
+	glGenVertexArrays(1, &vertexArrayID);
+	TrackResource(GPU_RESOURCE_VERTEX_ARRAY, vertexArrayID, label);
+
+	return vertexArrayID;
+}
+
+/***********************************************************
+ *  DeleteTrackedVertexArray()
+ *
+ *  This function is used for deleting a tracked vertex array
+ *  and clearing the passed in ID.
+ ***********************************************************/
+void DeleteTrackedVertexArray(GLuint& vertexArrayID)
+{
+	if (0 != vertexArrayID)
+	{
+		UntrackResource(GPU_RESOURCE_VERTEX_ARRAY, vertexArrayID);
+		glDeleteVertexArrays(1, &vertexArrayID);
+		vertexArrayID = 0;
+	}
+}
+
+/***********************************************************
+ *  CreateTrackedProgram()
+ *
+ *  This function is used for creating a program object that
+ *  is tracked until it is deleted.
+ ***********************************************************/
+GLuint CreateTrackedProgram(const char* label)
+{
+	GLuint programID = glCreateProgram();
+	TrackResource(GPU_RESOURCE_PROGRAM, programID, label);
+
+	return programID;
+}
+
+/***********************************************************
+ *  DeleteTrackedProgram()
+ *
+ *  This function is used for deleting a tracked program and
+ *  clearing the passed in ID.
+ ***********************************************************/
+void DeleteTrackedProgram(GLuint& programID)
+{
+	if (0 != programID)
+	{
+		UntrackResource(GPU_RESOURCE_PROGRAM, programID);
+		glDeleteProgram(programID);
+		programID = 0;
+	}
+}
+
+/***********************************************************
+ *  SetTrackedResourceSize()
+ *
+ *  This function is used for recording the bytes held by a
+ *  tracked object, such as after its storage is allocated
+ *  again at a new size.
+ ***********************************************************/
+void SetTrackedResourceSize(GPU_RESOURCE_TYPE type, GLuint id, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	auto found = g_Resources[type].find(id);
+	if (found != g_Resources[type].end())
+	{
+		g_ResourceBytes[type] -= found->second.bytes;
+		g_ResourceBytes[type] += bytes;
+		found->second.bytes = bytes;
+	}
+}
+
+/***********************************************************
+ *  GetTextureStorageSize()
+ *
+ *  This function is used for estimating the bytes held by a
+ *  texture.  A full mipmap chain adds a third of the base
+ *  level.
+ ***********************************************************/
+size_t GetTextureStorageSize(GLenum internalFormat, int width, int height, int samples, bool bMipmapped)
+{
+	size_t bytes = GetBytesPerPixel(internalFormat) * (size_t)width * (size_t)height * (size_t)((samples > 1) ? samples : 1);
+	if (bMipmapped)
+	{
+		bytes += bytes / 3;
+	}
+
+	return bytes;
+}
+
+/***********************************************************
+ *  GetGPUMemoryUsage()
+ *
+ *  This function is used for getting the bytes held by all
+ *  of the tracked objects.
+ ***********************************************************/
+size_t GetGPUMemoryUsage()
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	size_t bytes = 0;
+	for (int i = 0; i < GPU_RESOURCE_TYPE_COUNT; i++)
+	{
+		bytes += g_ResourceBytes[i];
+	}
+
+	return bytes;
+}
+
+/***********************************************************
+ *  GetGPUMemoryUsage()
+ *
+ *  This function is used for getting the bytes held by the
+ *  tracked objects of one kind.
+ ***********************************************************/
+size_t GetGPUMemoryUsage(GPU_RESOURCE_TYPE type)
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	return g_ResourceBytes[type];
+}
+
+/***********************************************************
+ *  GetGPUResourceCount()
+ *
+ *  This function is used for getting the number of tracked
+ *  objects of one kind.
+ ***********************************************************/
+int GetGPUResourceCount(GPU_RESOURCE_TYPE type)
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	return (int)g_Resources[type].size();
+}
+
+/***********************************************************
+ *  ReportGPUMemoryUsage()
+ *
+ *  This function is used for printing the number of objects
+ *  and the bytes of each kind that are in use.
+ ***********************************************************/
+void ReportGPUMemoryUsage()
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	size_t totalBytes = 0;
+	for (int i = 0; i < GPU_RESOURCE_TYPE_COUNT; i++)
+	{
+		std::cout << "INFO: " << g_Resources[i].size() << " " << g_ResourceTypeNames[i]
+			<< " hold " << (g_ResourceBytes[i] / 1024) << " KB" << std::endl;
+		totalBytes += g_ResourceBytes[i];
+	}
+	std::cout << "INFO: Tracked GPU memory is " << (totalBytes / 1024) << " KB" << std::endl;
+}
+
+/***********************************************************
+ *  ReportGPUResourceLeaks()
+ *
+ *  This function is used for printing the tracked objects
+ *  that are still alive, which should be none once the
+ *  objects that own them have been destroyed.
+ ***********************************************************/
+bool ReportGPUResourceLeaks()
+{
+	std::lock_guard<std::mutex> lock(g_ResourceMutex);
+	bool bLeakFree = true;
+	for (int i = 0; i < GPU_RESOURCE_TYPE_COUNT; i++)
+	{
+		if (g_Resources[i].empty())
+		{
+			continue;
+		}
+
+		std::cout << "ERROR: " << g_Resources[i].size() << " " << g_ResourceTypeNames[i]
+			<< " holding " << (g_ResourceBytes[i] / 1024) << " KB were never deleted" << std::endl;
+		for (const auto& resource : g_Resources[i])
+		{
+			std::cout << "    " << resource.first << " (" << resource.second.label << ", "
+				<< resource.second.bytes << " bytes)" << std::endl;
+		}
+		bLeakFree = false;
+	}
+
+	return bLeakFree;
+}
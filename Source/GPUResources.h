@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.h
+// ============
+// create and delete OpenGL objects through a tracker that counts
+// the memory they hold and reports the ones that are never freed
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+// routes the OpenGL calls of every module through the GL capture
+#include "GLCapture.h"
+
+#include <cstddef>
+
+// the kinds of OpenGL objects that are tracked
+enum GPU_RESOURCE_TYPE
+{
+	GPU_RESOURCE_TEXTURE,
+	GPU_RESOURCE_BUFFER,
+	GPU_RESOURCE_VERTEX_ARRAY,
+	GPU_RESOURCE_PROGRAM,
+	GPU_RESOURCE_TYPE_COUNT
+};
+
+// create and delete tracked objects - the label names the owner
+// of an object in the leak report, and must be a string literal
+GLuint GenTrackedTexture(const char* label);
+void DeleteTrackedTexture(GLuint& textureID);
+GLuint GenTrackedBuffer(const char* label);
+void DeleteTrackedBuffer(GLuint& bufferID);
+GLuint GenTrackedVertexArray(const char* label);
+void DeleteTrackedVertexArray(GLuint& vertexArrayID);
+GLuint CreateTrackedProgram(const char* label);
+void DeleteTrackedProgram(GLuint& programID);
+
+// record the bytes held by a tracked object after its storage
+// has been allocated, replacing any size recorded before
+void SetTrackedResourceSize(GPU_RESOURCE_TYPE type, GLuint id, size_t bytes);
+// estimate the bytes held by a texture of an internal format
+size_t GetTextureStorageSize(GLenum internalFormat, int width, int height, int samples = 1, bool bMipmapped = false);
+
+// get the bytes held by the tracked objects, in total or of a kind
+size_t GetGPUMemoryUsage();
+size_t GetGPUMemoryUsage(GPU_RESOURCE_TYPE type);
+// get the number of tracked objects of a kind
+int GetGPUResourceCount(GPU_RESOURCE_TYPE type);
+
+// print the objects and bytes of each kind that are in use
+void ReportGPUMemoryUsage();
+// print every tracked object that has not been deleted - returns
+// true when there are none
+bool ReportGPUResourceLeaks();
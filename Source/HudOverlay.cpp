@@ -0,0 +1,729 @@
+///////////////////////////////////////////////////////////////////////////////
+// hudoverlay.cpp
+// ============
+// draw lines of text and panels over the finished frame, batched into
+// a single draw from a glyph atlas that is cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HudOverlay.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// directory where the glyph atlas is stored
+	const char* g_CacheDirectory = "HudCache";
+	// identifies a glyph atlas file written by this class
+	const uint32_t CACHE_FILE_MAGIC = 0x44554841;
+	// bumped whenever the way the atlas is built changes
+	const uint32_t CACHE_FILE_VERSION = 1;
+
+	// the printable characters of the font, from the space on
+	const int FIRST_GLYPH = 32;
+	const int GLYPH_COUNT = 95;
+	// pixels along each side of a glyph of the font
+	const int GLYPH_PIXELS = 8;
+	// texels of the atlas for each pixel of the font, the texels
+	// around a glyph that its distances spread into, and the
+	// distance in texels that the values cover on either side of
+	// the edge
+	const int GLYPH_SCALE = 3;
+	const int GLYPH_PADDING = 4;
+	const float DISTANCE_SPREAD = 4.0f;
+	// texels along each side of a cell of the atlas, and the
+	// cells across and down it - the cell after the glyphs is
+	// filled, for the panels
+	const int CELL_SIZE = GLYPH_PIXELS * GLYPH_SCALE + GLYPH_PADDING * 2;
+	const int ATLAS_COLUMNS = 16;
+	const int ATLAS_ROWS = 6;
+	const int ATLAS_WIDTH = CELL_SIZE * ATLAS_COLUMNS;
+	const int ATLAS_HEIGHT = CELL_SIZE * ATLAS_ROWS;
+	const int PANEL_CELL = GLYPH_COUNT;
+	// distance between the lines of text, as a part of the size
+	const float LINE_SPACING = 1.25f;
+	// weight of each new timing in the smoothed times
+	const double TIME_SMOOTHING = 0.1;
+
+	// the public domain 8x8 bitmap font of the basic Latin
+	// characters, one byte for each row from the top, with the
+	// lowest bit as the leftmost pixel
+	const unsigned char g_FontGlyphs[GLYPH_COUNT][GLYPH_PIXELS] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// space
+		{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },	// !
+		{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// "
+		{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },	// #
+		{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },	// $
+		{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },	// %
+		{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },	// &
+		{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '
+		{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },	// (
+		{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },	// )
+		{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },	// *
+		{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },	// +
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ,
+		{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },	// -
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// .
+		{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },	// /
+		{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },	// 0
+		{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },	// 1
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },	// 2
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },	// 3
+		{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },	// 4
+		{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },	// 5
+		{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },	// 6
+		{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },	// 7
+		{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },	// 8
+		{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },	// 9
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// :
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ;
+		{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },	// <
+		{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },	// =
+		{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },	// >
+		{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },	// ?
+		{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },	// @
+		{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },	// A
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },	// B
+		{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },	// C
+		{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },	// D
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },	// E
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },	// F
+		{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },	// G
+		{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },	// H
+		{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// I
+		{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },	// J
+		{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },	// K
+		{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },	// L
+		{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },	// M
+		{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },	// N
+		{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },	// O
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },	// P
+		{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },	// Q
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },	// R
+		{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },	// S
+		{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// T
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },	// U
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// V
+		{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },	// W
+		{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },	// X
+		{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },	// Y
+		{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },	// Z
+		{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },	// [
+		{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },	// backslash
+		{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },	// ]
+		{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },	// ^
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },	// _
+		{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },	// `
+		{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },	// a
+		{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },	// b
+		{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },	// c
+		{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },	// d
+		{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },	// e
+		{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },	// f
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// g
+		{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },	// h
+		{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// i
+		{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },	// j
+		{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },	// k
+		{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// l
+		{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },	// m
+		{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },	// n
+		{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },	// o
+		{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },	// p
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },	// q
+		{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },	// r
+		{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },	// s
+		{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },	// t
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },	// u
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// v
+		{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },	// w
+		{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },	// x
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// y
+		{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },	// z
+		{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },	// {
+		{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },	// |
+		{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },	// }
+		{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }	// ~
+	};
+
+	// header at the start of each glyph atlas file
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// vertex shader of the quads, placed in pixels from the top
+	// left of the window
+	const char* g_HudVertexShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec2 inPosition;\n"
+		"layout (location = 1) in vec2 inTexCoord;\n"
+		"layout (location = 2) in vec4 inColor;\n"
+		"uniform vec2 viewportSize;\n"
+		"out vec2 texCoord;\n"
+		"out vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 position = inPosition / viewportSize * 2.0f - 1.0f;\n"
+		"	gl_Position = vec4(position.x, -position.y, 0.0f, 1.0f);\n"
+		"	texCoord = inTexCoord;\n"
+		"	color = inColor;\n"
+		"}\n";
+
+	// fragment shader of the quads, which keeps the edges of the
+	// glyphs sharp at any size by cutting the signed distances at
+	// the edge, smoothed over about a pixel, and draws a dark
+	// outline around them so the text reads over any part of the
+	// scene - the panels read a cell that is inside everywhere
+	const char* g_HudFragmentShader =
+		"#version 330 core\n"
+		"const float OUTLINE_EDGE = 0.3f;\n"
+		"uniform sampler2D atlasTexture;\n"
+		"in vec2 texCoord;\n"
+		"in vec4 color;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	float distance = texture(atlasTexture, texCoord).r;\n"
+		"	float edgeWidth = max(fwidth(distance) * 0.75f, 0.001f);\n"
+		"	float fill = smoothstep(0.5f - edgeWidth, 0.5f + edgeWidth, distance);\n"
+		"	float outline = smoothstep(OUTLINE_EDGE - edgeWidth, OUTLINE_EDGE + edgeWidth, distance);\n"
+		"	fragmentColor = vec4(color.rgb * fill, color.a * outline);\n"
+		"}\n";
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used for folding a block of memory
+	 *  into a 64-bit FNV-1a hash value.
+	 ***********************************************************/
+	uint64_t HashBytes(const void* pData, size_t size, uint64_t hash)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	/***********************************************************
+	 *  IsGlyphTexel()
+	 *
+	 *  This function is used for checking whether a texel of a
+	 *  cell of the atlas is inside the pixels of its glyph.
+	 ***********************************************************/
+	bool IsGlyphTexel(int cell, int x, int y)
+	{
+		if (cell == PANEL_CELL)
+		{
+			return true;
+		}
+		if ((x < GLYPH_PADDING) || (y < GLYPH_PADDING))
+		{
+			return false;
+		}
+
+		int pixelX = (x - GLYPH_PADDING) / GLYPH_SCALE;
+		int pixelY = (y - GLYPH_PADDING) / GLYPH_SCALE;
+		if ((pixelX >= GLYPH_PIXELS) || (pixelY >= GLYPH_PIXELS))
+		{
+			return false;
+		}
+
+		return (0 != ((g_FontGlyphs[cell][pixelY] >> pixelX) & 1));
+	}
+
+	/***********************************************************
+	 *  PackColor()
+	 *
+	 *  This function is used for packing a color into the
+	 *  bytes of a vertex, red first.
+	 ***********************************************************/
+	uint32_t PackColor(glm::vec4 color)
+	{
+		uint32_t packed = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			uint32_t channel = (uint32_t)std::lround(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f);
+			packed |= channel << (i * 8);
+		}
+
+		return packed;
+	}
+}
+
+/***********************************************************
+ *  HudOverlay()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HudOverlay::HudOverlay()
+{
+	m_quadCount = 0;
+	m_width = 0;
+	m_height = 0;
+	m_programID = 0;
+	m_viewportSizeLocation = -1;
+	m_atlasTextureID = 0;
+	m_vertexBufferID = 0;
+	m_vertexArrayID = 0;
+	for (int i = 0; i < TIMER_QUERY_COUNT; i++)
+	{
+		m_timerQueries[i] = 0;
+		m_bTimerPending[i] = false;
+	}
+	m_timerIndex = 0;
+	m_cpuTime = 0.0;
+	m_gpuTime = 0.0;
+}
+
+/***********************************************************
+ *  ~HudOverlay()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HudOverlay::~HudOverlay()
+{
+	if (0 != m_timerQueries[0])
+	{
+		glDeleteQueries(TIMER_QUERY_COUNT, m_timerQueries);
+		m_timerQueries[0] = 0;
+	}
+	DeleteTrackedVertexArray(m_vertexArrayID);
+	DeleteTrackedBuffer(m_vertexBufferID);
+	DeleteTrackedTexture(m_atlasTextureID);
+	DeleteTrackedProgram(m_programID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the glyph atlas from the
+ *  cache directory, or building and saving it when no file
+ *  for the same inputs is there, and for creating the
+ *  program and the vertex buffer of the quads.
+ ***********************************************************/
+bool HudOverlay::Initialize()
+{
+	m_programID = ShaderCache::CompileProgram(g_HudVertexShader, g_HudFragmentShader);
+	if (0 == m_programID)
+	{
+		std::cout << "ERROR: The heads-up display cannot be drawn" << std::endl;
+		return false;
+	}
+	m_viewportSizeLocation = glGetUniformLocation(m_programID, "viewportSize");
+	glUseProgram(m_programID);
+	glUniform1i(glGetUniformLocation(m_programID, "atlasTexture"), ATLAS_TEXTURE_UNIT);
+	glUseProgram(0);
+
+	// the atlas depends only on the font and the way it is built
+	const int atlasValues[6] = { (int)CACHE_FILE_VERSION, GLYPH_SCALE, GLYPH_PADDING, ATLAS_COLUMNS, ATLAS_ROWS, (int)(DISTANCE_SPREAD * 256.0f) };
+	uint64_t key = HashBytes(atlasValues, sizeof(atlasValues), 14695981039346656037ULL);
+	key = HashBytes(g_FontGlyphs, sizeof(g_FontGlyphs), key);
+
+	std::error_code error;
+	std::filesystem::create_directories(g_CacheDirectory, error);
+	std::stringstream path;
+	path << g_CacheDirectory << "/" << std::hex << key << ".atlas";
+	std::string cachePath = path.str();
+
+	std::vector<unsigned char> texels;
+	if (LoadAtlas(cachePath, key, texels))
+	{
+		std::cout << "INFO: Loaded the glyph atlas from " << cachePath << std::endl;
+	}
+	else
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BuildAtlas(texels);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "INFO: Built the glyph atlas of " << GLYPH_COUNT << " glyphs in " << milliseconds << " ms" << std::endl;
+		SaveAtlas(cachePath, key, texels);
+	}
+
+	m_atlasTextureID = GenTrackedTexture("hud glyph atlas");
+	glBindTexture(GL_TEXTURE_2D, m_atlasTextureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_atlasTextureID, GetTextureStorageSize(GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT));
+
+	// the quads are written into an array that is kept at its
+	// full size, so adding them never allocates
+	m_vertices.resize((size_t)MAX_QUADS * 6);
+	size_t bufferSize = m_vertices.size() * sizeof(HUD_VERTEX);
+
+	m_vertexArrayID = GenTrackedVertexArray("hud quads");
+	m_vertexBufferID = GenTrackedBuffer("hud quads");
+	glBindVertexArray(m_vertexArrayID);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bufferSize, NULL, GL_STREAM_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_vertexBufferID, bufferSize);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HUD_VERTEX), (void*)offsetof(HUD_VERTEX, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HUD_VERTEX), (void*)offsetof(HUD_VERTEX, texCoord));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HUD_VERTEX), (void*)offsetof(HUD_VERTEX, color));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenQueries(TIMER_QUERY_COUNT, m_timerQueries);
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the quads of a frame,
+ *  which is also where the CPU time of the overlay is
+ *  measured from.
+ ***********************************************************/
+void HudOverlay::BeginFrame(int width, int height)
+{
+	m_frameStartTime = std::chrono::steady_clock::now();
+	m_quadCount = 0;
+	m_width = width;
+	m_height = height;
+}
+
+/***********************************************************
+ *  AddText()
+ *
+ *  This method is used for adding a quad for each glyph of
+ *  lines of text.  The quads cover most of the padding
+ *  around the glyphs as well, so the outlines are not cut.
+ *  Characters outside of the font are drawn as a question
+ *  mark, and the glyphs past the most quads are dropped.
+ ***********************************************************/
+void HudOverlay::AddText(float x, float y, float size, glm::vec4 color, const char* text)
+{
+	if (NULL == text)
+	{
+		return;
+	}
+
+	// the quads leave out the outer texels of the cells, so the
+	// filtering never reads the cell next to them
+	uint32_t packedColor = PackColor(color);
+	float texelSize = size / (float)(GLYPH_PIXELS * GLYPH_SCALE);
+	glm::vec2 quadSize((float)(CELL_SIZE - 2) * texelSize);
+	glm::vec2 atlasSize((float)ATLAS_WIDTH, (float)ATLAS_HEIGHT);
+	glm::vec2 pen(x, y);
+	for (const char* pCharacter = text; *pCharacter != '\0'; pCharacter++)
+	{
+		if (*pCharacter == '\n')
+		{
+			pen.x = x;
+			pen.y += size * LINE_SPACING;
+			continue;
+		}
+
+		int glyph = (unsigned char)*pCharacter - FIRST_GLYPH;
+		if ((glyph < 0) || (glyph >= GLYPH_COUNT))
+		{
+			glyph = '?' - FIRST_GLYPH;
+		}
+		if (glyph > 0)
+		{
+			glm::vec2 topLeft = pen - glm::vec2((float)(GLYPH_PADDING - 1) * texelSize);
+			glm::vec2 cellCorner((float)((glyph % ATLAS_COLUMNS) * CELL_SIZE), (float)((glyph / ATLAS_COLUMNS) * CELL_SIZE));
+			AddQuad(
+				topLeft,
+				topLeft + quadSize,
+				(cellCorner + glm::vec2(1.0f)) / atlasSize,
+				(cellCorner + glm::vec2((float)(CELL_SIZE - 1))) / atlasSize,
+				packedColor);
+		}
+		pen.x += size;
+	}
+}
+
+/***********************************************************
+ *  AddPanel()
+ *
+ *  This method is used for adding a filled rectangle, which
+ *  reads the middle of the filled cell of the atlas.
+ ***********************************************************/
+void HudOverlay::AddPanel(float x, float y, float width, float height, glm::vec4 color)
+{
+	glm::vec2 cellCenter(
+		((float)((PANEL_CELL % ATLAS_COLUMNS) * CELL_SIZE) + 0.5f * (float)CELL_SIZE) / (float)ATLAS_WIDTH,
+		((float)((PANEL_CELL / ATLAS_COLUMNS) * CELL_SIZE) + 0.5f * (float)CELL_SIZE) / (float)ATLAS_HEIGHT);
+	AddQuad(glm::vec2(x, y), glm::vec2(x + width, y + height), cellCenter, cellCenter, PackColor(color));
+}
+
+/***********************************************************
+ *  GetTextSize()
+ *
+ *  This method is used for getting the size in pixels of
+ *  lines of text, as they would be added with AddText().
+ ***********************************************************/
+glm::vec2 HudOverlay::GetTextSize(float size, const char* text)
+{
+	if (NULL == text)
+	{
+		return glm::vec2(0.0f);
+	}
+
+	int longestLine = 0;
+	int lineLength = 0;
+	int lineCount = 1;
+	for (const char* pCharacter = text; *pCharacter != '\0'; pCharacter++)
+	{
+		if (*pCharacter == '\n')
+		{
+			lineLength = 0;
+			lineCount++;
+			continue;
+		}
+		lineLength++;
+		longestLine = std::max(longestLine, lineLength);
+	}
+
+	return glm::vec2((float)longestLine * size, ((float)(lineCount - 1) * LINE_SPACING + 1.0f) * size);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the quads of the frame
+ *  with a single draw.  The vertex buffer is orphaned before
+ *  the quads are written into it, so the driver hands out
+ *  new storage rather than waiting for the GPU to finish
+ *  reading the previous frame's quads.  The depth test and
+ *  face culling are turned off for the draw, and restored
+ *  along with the blending afterwards.
+ ***********************************************************/
+void HudOverlay::Draw()
+{
+	if ((0 == m_programID) || (0 == m_quadCount) || (m_width <= 0) || (m_height <= 0))
+	{
+		return;
+	}
+
+	ReadTimerQuery();
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m_vertices.size() * sizeof(HUD_VERTEX)), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)((size_t)m_quadCount * 6 * sizeof(HUD_VERTEX)), m_vertices.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean bCullFace = glIsEnabled(GL_CULL_FACE);
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glViewport(0, 0, m_width, m_height);
+
+	glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[m_timerIndex]);
+	glUseProgram(m_programID);
+	glUniform2f(m_viewportSizeLocation, (GLfloat)m_width, (GLfloat)m_height);
+	glActiveTexture(GL_TEXTURE0 + ATLAS_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_atlasTextureID);
+	glActiveTexture(GL_TEXTURE0);
+	glBindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, m_quadCount * 6);
+	glBindVertexArray(0);
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bTimerPending[m_timerIndex] = true;
+	m_timerIndex = (m_timerIndex + 1) % TIMER_QUERY_COUNT;
+
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (bCullFace)
+	{
+		glEnable(GL_CULL_FACE);
+	}
+	if (!bBlend)
+	{
+		glDisable(GL_BLEND);
+	}
+
+	double frameTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_frameStartTime).count();
+	m_cpuTime = (m_cpuTime > 0.0) ? m_cpuTime + (frameTime - m_cpuTime) * TIME_SMOOTHING : frameTime;
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used for writing the two triangles of a
+ *  quad into the vertices of the frame.
+ ***********************************************************/
+void HudOverlay::AddQuad(glm::vec2 topLeft, glm::vec2 bottomRight, glm::vec2 texCoordMin, glm::vec2 texCoordMax, uint32_t color)
+{
+	if (m_quadCount >= MAX_QUADS)
+	{
+		return;
+	}
+
+	HUD_VERTEX* pVertex = &m_vertices[(size_t)m_quadCount * 6];
+	const HUD_VERTEX corners[4] =
+	{
+		{ topLeft, texCoordMin, color },
+		{ glm::vec2(bottomRight.x, topLeft.y), glm::vec2(texCoordMax.x, texCoordMin.y), color },
+		{ glm::vec2(topLeft.x, bottomRight.y), glm::vec2(texCoordMin.x, texCoordMax.y), color },
+		{ bottomRight, texCoordMax, color }
+	};
+	pVertex[0] = corners[0];
+	pVertex[1] = corners[2];
+	pVertex[2] = corners[1];
+	pVertex[3] = corners[1];
+	pVertex[4] = corners[2];
+	pVertex[5] = corners[3];
+	m_quadCount++;
+}
+
+/***********************************************************
+ *  ReadTimerQuery()
+ *
+ *  This method is used for reading the GPU time of the draw
+ *  whose query slot comes around again, by which time it
+ *  has usually finished, so the CPU never waits for it.
+ ***********************************************************/
+void HudOverlay::ReadTimerQuery()
+{
+	if (false == m_bTimerPending[m_timerIndex])
+	{
+		return;
+	}
+
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(m_timerQueries[m_timerIndex], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (bAvailable)
+	{
+		GLuint64 elapsedTime = 0;
+		glGetQueryObjectui64v(m_timerQueries[m_timerIndex], GL_QUERY_RESULT, &elapsedTime);
+		double drawTime = (double)elapsedTime * 1.0e-9;
+		m_gpuTime = (m_gpuTime > 0.0) ? m_gpuTime + (drawTime - m_gpuTime) * TIME_SMOOTHING : drawTime;
+	}
+	// an unfinished query is dropped when its slot is reused
+	m_bTimerPending[m_timerIndex] = false;
+}
+
+/***********************************************************
+ *  BuildAtlas()
+ *
+ *  This method is used for building the signed distances of
+ *  every glyph into its cell of the atlas.  Each texel finds
+ *  the nearest texel on the other side of the edge within
+ *  the spread, and stores the distance to the edge halfway
+ *  to it, with 0.5 on the edge and higher values inside.
+ ***********************************************************/
+void HudOverlay::BuildAtlas(std::vector<unsigned char>& texels)
+{
+	texels.assign((size_t)ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+
+	const int searchRadius = (int)std::ceil(DISTANCE_SPREAD) + 1;
+	for (int cell = 0; cell <= PANEL_CELL; cell++)
+	{
+		int cellX = (cell % ATLAS_COLUMNS) * CELL_SIZE;
+		int cellY = (cell / ATLAS_COLUMNS) * CELL_SIZE;
+		for (int y = 0; y < CELL_SIZE; y++)
+		{
+			for (int x = 0; x < CELL_SIZE; x++)
+			{
+				bool bInside = IsGlyphTexel(cell, x, y);
+				int nearest = searchRadius * searchRadius * 2;
+				for (int offsetY = -searchRadius; offsetY <= searchRadius; offsetY++)
+				{
+					for (int offsetX = -searchRadius; offsetX <= searchRadius; offsetX++)
+					{
+						int squaredDistance = offsetX * offsetX + offsetY * offsetY;
+						if ((squaredDistance < nearest) && (IsGlyphTexel(cell, x + offsetX, y + offsetY) != bInside))
+						{
+							nearest = squaredDistance;
+						}
+					}
+				}
+
+				float distance = std::min(std::sqrt((float)nearest) - 0.5f, DISTANCE_SPREAD);
+				float value = 0.5f + (bInside ? distance : -distance) / (2.0f * DISTANCE_SPREAD);
+				texels[(size_t)(cellY + y) * ATLAS_WIDTH + (cellX + x)] = (unsigned char)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadAtlas()
+ *
+ *  This method is used for loading the atlas from a file
+ *  saved for the same inputs.
+ ***********************************************************/
+bool HudOverlay::LoadAtlas(const std::string& path, uint64_t key, std::vector<unsigned char>& texels)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	CACHE_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.key != key) ||
+		(header.width != (uint32_t)ATLAS_WIDTH) ||
+		(header.height != (uint32_t)ATLAS_HEIGHT))
+	{
+		return false;
+	}
+
+	texels.resize((size_t)ATLAS_WIDTH * ATLAS_HEIGHT);
+	file.read((char*)texels.data(), (std::streamsize)texels.size());
+
+	return (bool)file;
+}
+
+/***********************************************************
+ *  SaveAtlas()
+ *
+ *  This method is used for saving the atlas into a file
+ *  named by the hash of its inputs.
+ ***********************************************************/
+void HudOverlay::SaveAtlas(const std::string& path, uint64_t key, const std::vector<unsigned char>& texels)
+{
+	CACHE_FILE_HEADER header;
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.key = key;
+	header.width = (uint32_t)ATLAS_WIDTH;
+	header.height = (uint32_t)ATLAS_HEIGHT;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write glyph atlas file:" << path << std::endl;
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)texels.data(), (std::streamsize)texels.size());
+}
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// hudoverlay.h
+// ============
+// draw lines of text and panels over the finished frame, batched into
+// a single draw from a glyph atlas that is cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  HudOverlay
+ *
+ *  This class draws the heads-up display over the window
+ *  after the frame graph has finished the frame.  The
+ *  glyphs are read from an atlas of signed distances, which
+ *  is built from a bitmap font when the overlay starts and
+ *  saved on disk, so later runs only load it.  The text and
+ *  panels added during a frame are written as quads into an
+ *  array that is kept between frames, which is streamed
+ *  into one vertex buffer and drawn with a single draw, so
+ *  the cost of the overlay does not grow with the number
+ *  of glyphs.  The time the overlay takes on the CPU and
+ *  on the GPU is measured so that it can be shown as well.
+ ***********************************************************/
+class HudOverlay
+{
+public:
+	// texture unit the atlas is read from, which is not used by
+	// the scene textures, the frame graph inputs or the other
+	// passes
+	static const int ATLAS_TEXTURE_UNIT = 20;
+	// most glyphs and panels that can be drawn in a frame
+	static const int MAX_QUADS = 2048;
+
+	// constructor
+	HudOverlay();
+	// destructor
+	~HudOverlay();
+
+	// build or load the atlas and create the program and the
+	// vertex buffer - returns false when the overlay cannot be
+	// drawn
+	bool Initialize();
+	// check whether the overlay can be drawn
+	bool IsAvailable() const { return (0 != m_programID); }
+
+	// start the quads of a frame drawn at a size in pixels
+	void BeginFrame(int width, int height);
+	// add lines of text, split at each newline, with the top left
+	// of the first glyph at a point in pixels from the top left
+	// of the window and the glyphs a number of pixels high
+	void AddText(float x, float y, float size, glm::vec4 color, const char* text);
+	// add a filled rectangle, in pixels from the top left of the
+	// window, drawn in the order it was added
+	void AddPanel(float x, float y, float width, float height, glm::vec4 color);
+	// get the size in pixels of lines of text, from the longest
+	// line and the number of lines
+	static glm::vec2 GetTextSize(float size, const char* text);
+	// stream the quads of the frame into the vertex buffer and
+	// draw them over the bound draw framebuffer
+	void Draw();
+
+	// get the smoothed time in seconds that the overlay takes on
+	// the CPU, from the start of a frame to its draw, and on the
+	// GPU to draw it
+	double GetCPUTime() const { return m_cpuTime; }
+	double GetGPUTime() const { return m_gpuTime; }
+
+private:
+	// the number of timer queries in flight, so the results are
+	// read without waiting for the GPU
+	static const int TIMER_QUERY_COUNT = 4;
+
+	// a corner of a quad, with its color packed into bytes
+	struct HUD_VERTEX
+	{
+		glm::vec2 position;
+		glm::vec2 texCoord;
+		uint32_t color;
+	};
+
+	// the quads of the frame, six vertices each
+	std::vector<HUD_VERTEX> m_vertices;
+	int m_quadCount;
+	int m_width;
+	int m_height;
+
+	// the program, the atlas and the streamed vertex buffer
+	GLuint m_programID;
+	GLint m_viewportSizeLocation;
+	GLuint m_atlasTextureID;
+	GLuint m_vertexBufferID;
+	GLuint m_vertexArrayID;
+
+	// the timer queries of the draws and the measured times
+	GLuint m_timerQueries[TIMER_QUERY_COUNT];
+	bool m_bTimerPending[TIMER_QUERY_COUNT];
+	int m_timerIndex;
+	std::chrono::steady_clock::time_point m_frameStartTime;
+	double m_cpuTime;
+	double m_gpuTime;
+
+	// add a quad from its corners in pixels and in the atlas
+	void AddQuad(glm::vec2 topLeft, glm::vec2 bottomRight, glm::vec2 texCoordMin, glm::vec2 texCoordMax, uint32_t color);
+	// read the GPU time of the oldest timer query
+	void ReadTimerQuery();
+
+	// build the signed distances of the glyphs into the atlas
+	static void BuildAtlas(std::vector<unsigned char>& texels);
+	// load the atlas from a file saved for the same inputs
+	static bool LoadAtlas(const std::string& path, uint64_t key, std::vector<unsigned char>& texels);
+	// save the atlas into a file named by the hash of its inputs
+	static void SaveAtlas(const std::string& path, uint64_t key, const std::vector<unsigned char>& texels);
+};
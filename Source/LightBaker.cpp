@@ -0,0 +1,639 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.cpp
+// ============
+// bake the ambient occlusion and diffuse lighting of the objects
+// that never move into their vertices, cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightBaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// identifies a baked lighting file written by this class
+	const uint32_t CACHE_FILE_MAGIC = 0x4B42474C;
+	// bumped whenever the way the lighting is baked changes
+	const uint32_t CACHE_FILE_VERSION = 1;
+
+	// rays over the hemisphere of each vertex, and the distance
+	// within which anything they hit occludes the vertex
+	const int OCCLUSION_RAY_COUNT = 64;
+	const float OCCLUSION_DISTANCE = 2.0f;
+	// distance the rays start above the surface, so they do not
+	// hit the triangles of their own vertex
+	const float RAY_OFFSET = 0.002f;
+	// most triangles in a leaf of the hierarchy, and the most
+	// nodes waiting to be visited while tracing a ray
+	const int LEAF_TRIANGLES = 4;
+	const int MAX_TRAVERSAL_DEPTH = 64;
+	// vertices that a thread takes at a time
+	const size_t VERTICES_PER_TASK = 64;
+
+	// header at the start of each baked lighting file
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t valueCount;
+	};
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used for folding a block of memory
+	 *  into a 64-bit FNV-1a hash value.
+	 ***********************************************************/
+	uint64_t HashBytes(const void* pData, size_t size, uint64_t hash)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	/***********************************************************
+	 *  RadicalInverse()
+	 *
+	 *  This function is used for mirroring the bits of a
+	 *  number about the binary point, which spreads the
+	 *  numbers evenly over the range from 0 to 1.
+	 ***********************************************************/
+	float RadicalInverse(uint32_t bits)
+	{
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+
+		return (float)bits * 2.3283064365386963e-10f;
+	}
+
+	/***********************************************************
+	 *  IsBoxHit()
+	 *
+	 *  This function is used for checking whether a ray passes
+	 *  through a bounding box before a distance.
+	 ***********************************************************/
+	bool IsBoxHit(
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance)
+	{
+		float nearDistance = 0.0f;
+		float farDistance = maxDistance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float first = (boundsMin[axis] - origin[axis]) * inverseDirection[axis];
+			float second = (boundsMax[axis] - origin[axis]) * inverseDirection[axis];
+			nearDistance = std::max(nearDistance, std::min(first, second));
+			farDistance = std::min(farDistance, std::max(first, second));
+		}
+
+		return (nearDistance <= farDistance);
+	}
+}
+
+/***********************************************************
+ *  LightBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightBaker::LightBaker()
+{
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		m_lights[i].position = glm::vec3(0.0f);
+		m_lights[i].ambientColor = glm::vec3(0.0f);
+		m_lights[i].diffuseColor = glm::vec3(0.0f);
+	}
+}
+
+/***********************************************************
+ *  SetLight()
+ *
+ *  This method is used for setting the values of one of the
+ *  light sources.
+ ***********************************************************/
+void LightBaker::SetLight(int light, const BAKE_LIGHT& values)
+{
+	if ((light < 0) || (light >= MAX_LIGHTS))
+	{
+		return;
+	}
+
+	m_lights[light] = values;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for keeping the positions, normals
+ *  and triangles of a mesh in world space, with the
+ *  material that its baked colors are scaled by.
+ ***********************************************************/
+int LightBaker::AddMesh(const MeshGenerator::MESH_DATA& meshData, const BAKE_MATERIAL& material)
+{
+	const int stride = MeshGenerator::FLOATS_PER_VERTEX;
+	size_t vertexCount = meshData.vertices.size() / stride;
+
+	BAKE_MESH mesh;
+	mesh.positions.resize(vertexCount);
+	mesh.normals.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const GLfloat* pVertex = &meshData.vertices[i * stride];
+		mesh.positions[i] = glm::vec3(pVertex[0], pVertex[1], pVertex[2]);
+		mesh.normals[i] = glm::vec3(pVertex[3], pVertex[4], pVertex[5]);
+	}
+	mesh.indices = meshData.indices;
+	mesh.material = material;
+	m_meshes.push_back(std::move(mesh));
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for working out the baked color of
+ *  every vertex of every mesh.  The colors are loaded from
+ *  the cache directory when a file for the same inputs is
+ *  there, and are saved into it once they are baked.
+ ***********************************************************/
+bool LightBaker::Bake(int threadCount, const char* cacheDirectory)
+{
+	std::vector<size_t> meshStarts;
+	size_t vertexCount = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		meshStarts.push_back(vertexCount);
+		vertexCount += m_meshes[i].positions.size();
+		m_meshes[i].lighting.assign(m_meshes[i].positions.size() * 3, 0.0f);
+	}
+	if (vertexCount == 0)
+	{
+		return false;
+	}
+
+	uint64_t key = HashInputs();
+	std::string cachePath;
+	if (NULL != cacheDirectory)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+
+		std::stringstream path;
+		path << cacheDirectory << "/" << std::hex << key << ".bake";
+		cachePath = path.str();
+		if (LoadCache(cachePath, key))
+		{
+			std::cout << "INFO: Loaded baked lighting for " << vertexCount << " vertices from " << cachePath << std::endl;
+			return true;
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BuildHierarchy();
+
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	std::atomic<size_t> nextVertex(0);
+	auto bakeVertices = [&]()
+	{
+		for (;;)
+		{
+			size_t first = nextVertex.fetch_add(VERTICES_PER_TASK);
+			if (first >= vertexCount)
+			{
+				break;
+			}
+
+			size_t last = std::min(first + VERTICES_PER_TASK, vertexCount);
+			for (size_t vertex = first; vertex < last; vertex++)
+			{
+				size_t meshIndex = (size_t)(std::upper_bound(meshStarts.begin(), meshStarts.end(), vertex) - meshStarts.begin()) - 1;
+				BAKE_MESH& mesh = m_meshes[meshIndex];
+				size_t meshVertex = vertex - meshStarts[meshIndex];
+				glm::vec3 color = BakeVertex(mesh, meshVertex);
+				mesh.lighting[meshVertex * 3] = color.r;
+				mesh.lighting[meshVertex * 3 + 1] = color.g;
+				mesh.lighting[meshVertex * 3 + 2] = color.b;
+			}
+		}
+	};
+
+	// the calling thread bakes alongside the others
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(bakeVertices);
+	}
+	bakeVertices();
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Baked lighting for " << vertexCount << " vertices and " << m_triangles.size()
+		<< " triangles in " << milliseconds << " ms on " << threadCount << " threads" << std::endl;
+
+	m_triangles.clear();
+	m_nodes.clear();
+	if (false == cachePath.empty())
+	{
+		SaveCache(cachePath, key);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  HashInputs()
+ *
+ *  This method is used for hashing everything that the baked
+ *  colors depend on, which names the cache file.
+ ***********************************************************/
+uint64_t LightBaker::HashInputs() const
+{
+	const int bakeValues[3] = { (int)CACHE_FILE_VERSION, OCCLUSION_RAY_COUNT, LEAF_TRIANGLES };
+	const float bakeDistances[2] = { OCCLUSION_DISTANCE, RAY_OFFSET };
+
+	uint64_t hash = 14695981039346656037ULL;
+	hash = HashBytes(bakeValues, sizeof(bakeValues), hash);
+	hash = HashBytes(bakeDistances, sizeof(bakeDistances), hash);
+	hash = HashBytes(m_lights, sizeof(m_lights), hash);
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		const BAKE_MESH& mesh = m_meshes[i];
+		hash = HashBytes(mesh.positions.data(), mesh.positions.size() * sizeof(glm::vec3), hash);
+		hash = HashBytes(mesh.normals.data(), mesh.normals.size() * sizeof(glm::vec3), hash);
+		hash = HashBytes(mesh.indices.data(), mesh.indices.size() * sizeof(GLuint), hash);
+		hash = HashBytes(&mesh.material, sizeof(mesh.material), hash);
+	}
+
+	return hash;
+}
+
+/***********************************************************
+ *  LoadCache()
+ *
+ *  This method is used for loading the baked colors of every
+ *  mesh from a file saved for the same inputs.
+ ***********************************************************/
+bool LightBaker::LoadCache(const std::string& path, uint64_t key)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	uint64_t valueCount = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		valueCount += m_meshes[i].lighting.size();
+	}
+
+	CACHE_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.key != key) ||
+		(header.valueCount != valueCount))
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		std::vector<GLfloat>& lighting = m_meshes[i].lighting;
+		file.read((char*)lighting.data(), (std::streamsize)(lighting.size() * sizeof(GLfloat)));
+	}
+
+	return (bool)file;
+}
+
+/***********************************************************
+ *  SaveCache()
+ *
+ *  This method is used for saving the baked colors of every
+ *  mesh into a file named by the hash of their inputs.
+ ***********************************************************/
+void LightBaker::SaveCache(const std::string& path, uint64_t key) const
+{
+	CACHE_FILE_HEADER header;
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.key = key;
+	header.valueCount = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		header.valueCount += m_meshes[i].lighting.size();
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write baked lighting file:" << path << std::endl;
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		const std::vector<GLfloat>& lighting = m_meshes[i].lighting;
+		file.write((const char*)lighting.data(), (std::streamsize)(lighting.size() * sizeof(GLfloat)));
+	}
+}
+
+/***********************************************************
+ *  BuildHierarchy()
+ *
+ *  This method is used for collecting the triangles of every
+ *  mesh and building the hierarchy over them.  The
+ *  triangles are stored in the order of the leaves, so each
+ *  leaf reads one run of them.
+ ***********************************************************/
+void LightBaker::BuildHierarchy()
+{
+	std::vector<RAY_TRIANGLE> triangles;
+	std::vector<glm::vec3> centers;
+
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		const BAKE_MESH& mesh = m_meshes[i];
+		for (size_t index = 0; index + 2 < mesh.indices.size(); index += 3)
+		{
+			const glm::vec3& a = mesh.positions[mesh.indices[index]];
+			const glm::vec3& b = mesh.positions[mesh.indices[index + 1]];
+			const glm::vec3& c = mesh.positions[mesh.indices[index + 2]];
+
+			RAY_TRIANGLE triangle;
+			triangle.origin = a;
+			triangle.edgeA = b - a;
+			triangle.edgeB = c - a;
+			triangles.push_back(triangle);
+			centers.push_back((a + b + c) / 3.0f);
+		}
+	}
+
+	m_nodes.clear();
+	m_triangles.clear();
+	if (triangles.empty())
+	{
+		return;
+	}
+
+	std::vector<int> triangleOrder(triangles.size());
+	std::iota(triangleOrder.begin(), triangleOrder.end(), 0);
+	m_triangles.swap(triangles);
+	m_nodes.reserve(m_triangles.size() / LEAF_TRIANGLES * 2 + 1);
+	BuildNode(triangleOrder, centers, 0, (int)triangleOrder.size());
+
+	triangles.resize(triangleOrder.size());
+	for (size_t i = 0; i < triangleOrder.size(); i++)
+	{
+		triangles[i] = m_triangles[triangleOrder[i]];
+	}
+	m_triangles.swap(triangles);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for adding a node over a run of the
+ *  triangles, splitting the run at the median of the
+ *  triangle centers along the longest axis of their bounds
+ *  until the runs are small enough for leaves.
+ ***********************************************************/
+int LightBaker::BuildNode(
+	std::vector<int>& triangleOrder,
+	const std::vector<glm::vec3>& centers,
+	int first,
+	int count)
+{
+	int nodeIndex = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+
+	glm::vec3 boundsMin(FLT_MAX);
+	glm::vec3 boundsMax(-FLT_MAX);
+	glm::vec3 centerMin(FLT_MAX);
+	glm::vec3 centerMax(-FLT_MAX);
+	for (int i = first; i < first + count; i++)
+	{
+		const RAY_TRIANGLE& triangle = m_triangles[triangleOrder[i]];
+		glm::vec3 b = triangle.origin + triangle.edgeA;
+		glm::vec3 c = triangle.origin + triangle.edgeB;
+		boundsMin = glm::min(boundsMin, glm::min(triangle.origin, glm::min(b, c)));
+		boundsMax = glm::max(boundsMax, glm::max(triangle.origin, glm::max(b, c)));
+		centerMin = glm::min(centerMin, centers[triangleOrder[i]]);
+		centerMax = glm::max(centerMax, centers[triangleOrder[i]]);
+	}
+	m_nodes[nodeIndex].boundsMin = boundsMin;
+	m_nodes[nodeIndex].boundsMax = boundsMax;
+	m_nodes[nodeIndex].firstTriangle = first;
+	m_nodes[nodeIndex].triangleCount = count;
+	m_nodes[nodeIndex].secondChild = -1;
+	if (count <= LEAF_TRIANGLES)
+	{
+		return nodeIndex;
+	}
+
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2) : ((extent.y > extent.z) ? 1 : 2);
+	int half = count / 2;
+	std::nth_element(
+		triangleOrder.begin() + first,
+		triangleOrder.begin() + first + half,
+		triangleOrder.begin() + first + count,
+		[&centers, axis](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+	// the first child is the next node, so only the second one
+	// is stored
+	BuildNode(triangleOrder, centers, first, half);
+	int secondChild = BuildNode(triangleOrder, centers, first + half, count - half);
+	m_nodes[nodeIndex].secondChild = secondChild;
+	m_nodes[nodeIndex].triangleCount = 0;
+
+	return nodeIndex;
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether a ray hits any
+ *  triangle before a distance.  The hierarchy is walked
+ *  depth first, and the walk stops at the first hit, since
+ *  the nearest one is not needed.  Triangles are hit from
+ *  either side.
+ ***********************************************************/
+bool LightBaker::IsOccluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const
+{
+	if (m_nodes.empty() || (maxDistance <= 0.0f))
+	{
+		return false;
+	}
+
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	int nodeIndex = 0;
+	for (;;)
+	{
+		const BVH_NODE& node = m_nodes[nodeIndex];
+		if (IsBoxHit(node.boundsMin, node.boundsMax, origin, inverseDirection, maxDistance))
+		{
+			if (node.triangleCount == 0)
+			{
+				if (stackSize < MAX_TRAVERSAL_DEPTH)
+				{
+					stack[stackSize++] = node.secondChild;
+				}
+				nodeIndex++;
+				continue;
+			}
+
+			for (int i = node.firstTriangle; i < node.firstTriangle + node.triangleCount; i++)
+			{
+				const RAY_TRIANGLE& triangle = m_triangles[i];
+				glm::vec3 p = glm::cross(direction, triangle.edgeB);
+				float determinant = glm::dot(triangle.edgeA, p);
+				if (std::fabs(determinant) < 1e-12f)
+				{
+					continue;
+				}
+
+				float inverseDeterminant = 1.0f / determinant;
+				glm::vec3 offset = origin - triangle.origin;
+				float u = glm::dot(offset, p) * inverseDeterminant;
+				if ((u < 0.0f) || (u > 1.0f))
+				{
+					continue;
+				}
+				glm::vec3 q = glm::cross(offset, triangle.edgeA);
+				float v = glm::dot(direction, q) * inverseDeterminant;
+				if ((v < 0.0f) || (u + v > 1.0f))
+				{
+					continue;
+				}
+				float distance = glm::dot(triangle.edgeB, q) * inverseDeterminant;
+				if ((distance > 0.0f) && (distance < maxDistance))
+				{
+					return true;
+				}
+			}
+		}
+
+		if (stackSize == 0)
+		{
+			return false;
+		}
+		nodeIndex = stack[--stackSize];
+	}
+}
+
+/***********************************************************
+ *  BakeVertex()
+ *
+ *  This method is used for baking the color of one vertex.
+ *  The ambient light is scaled by the share of the cosine
+ *  weighted hemisphere rays that escape, where a channel of
+ *  the summed ambient that is below zero is left unscaled,
+ *  so occlusion never brightens a corner, and the diffuse
+ *  light of each light source counts only when nothing is
+ *  in the way.  The same rays are traced from vertices at
+ *  the same position, so the seams between faces match.
+ ***********************************************************/
+glm::vec3 LightBaker::BakeVertex(const BAKE_MESH& mesh, size_t vertex) const
+{
+	glm::vec3 position = mesh.positions[vertex];
+	glm::vec3 normal = mesh.normals[vertex];
+	float normalLength = glm::length(normal);
+	normal = (normalLength > 0.0f) ? normal / normalLength : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 origin = position + normal * RAY_OFFSET;
+
+	glm::vec3 tangent = glm::normalize(glm::cross(normal, (std::fabs(normal.x) > 0.5f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f)));
+	glm::vec3 bitangent = glm::cross(normal, tangent);
+
+	// turn the sample pattern by an amount picked from the
+	// position, which trades banding between vertices for noise
+	uint32_t positionBits[3];
+	std::memcpy(positionBits, &position.x, sizeof(positionBits));
+	uint64_t seed = HashBytes(positionBits, sizeof(positionBits), 14695981039346656037ULL);
+	float turnU = (float)(seed & 0xFFFF) / 65536.0f;
+	float turnV = (float)((seed >> 16) & 0xFFFF) / 65536.0f;
+
+	int openRays = 0;
+	for (int i = 0; i < OCCLUSION_RAY_COUNT; i++)
+	{
+		float u = ((float)i + 0.5f) / (float)OCCLUSION_RAY_COUNT + turnU;
+		float v = RadicalInverse((uint32_t)i) + turnV;
+		u -= std::floor(u);
+		v -= std::floor(v);
+
+		float radius = std::sqrt(u);
+		float angle = 6.28318530718f * v;
+		glm::vec3 direction = tangent * (radius * std::cos(angle)) +
+			bitangent * (radius * std::sin(angle)) +
+			normal * std::sqrt(std::max(0.0f, 1.0f - u));
+		if (false == IsOccluded(origin, direction, OCCLUSION_DISTANCE))
+		{
+			openRays++;
+		}
+	}
+	float occlusion = (float)openRays / (float)OCCLUSION_RAY_COUNT;
+
+	glm::vec3 ambient(0.0f);
+	glm::vec3 diffuse(0.0f);
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		const BAKE_LIGHT& light = m_lights[i];
+		ambient += light.ambientColor;
+		if (light.diffuseColor == glm::vec3(0.0f))
+		{
+			continue;
+		}
+
+		glm::vec3 toLight = light.position - position;
+		float distance = glm::length(toLight);
+		if (distance <= RAY_OFFSET)
+		{
+			continue;
+		}
+		glm::vec3 lightDirection = toLight / distance;
+		float impact = glm::dot(normal, lightDirection);
+		if ((impact > 0.0f) && (false == IsOccluded(origin, lightDirection, distance - RAY_OFFSET)))
+		{
+			diffuse += impact * light.diffuseColor;
+		}
+	}
+
+	ambient = glm::min(ambient, ambient * occlusion);
+	return ambient * mesh.material.ambientStrength * mesh.material.ambientColor +
+		diffuse * mesh.material.diffuseColor;
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.h
+// ============
+// bake the ambient occlusion and diffuse lighting of the objects
+// that never move into their vertices, cached on disk
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  LightBaker
+ *
+ *  This class traces rays through meshes that are already
+ *  in world space to work out the lighting that does not
+ *  depend on the view.  Rays over the hemisphere of each
+ *  vertex give the ambient occlusion, and a ray to each
+ *  light gives its shadow, so the ambient and diffuse
+ *  terms of the scene shader can be stored with the vertex.
+ *  The triangles are kept in a bounding volume hierarchy,
+ *  and the vertices are shared out between threads.  The
+ *  results are saved keyed by the hash of everything that
+ *  goes into them, so an unchanged scene is only baked once.
+ ***********************************************************/
+class LightBaker
+{
+public:
+	// the most light sources of the scene shader
+	static const int MAX_LIGHTS = 4;
+
+	// the values of a light source that the baked terms use
+	struct BAKE_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+	};
+
+	// the values of a material that the baked terms use
+	struct BAKE_MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+	};
+
+	// constructor
+	LightBaker();
+
+	// set the values of a light source
+	void SetLight(int light, const BAKE_LIGHT& values);
+	// add a mesh in world space that is lit and casts shadows -
+	// returns the mesh index
+	int AddMesh(const MeshGenerator::MESH_DATA& meshData, const BAKE_MATERIAL& material);
+
+	// bake the lighting of every vertex on a number of threads, or
+	// one for each hardware thread for a count of 0 or less, or
+	// load it from the cache directory
+	bool Bake(int threadCount, const char* cacheDirectory);
+	// get the baked color of each vertex of a mesh, with three
+	// values per vertex
+	const std::vector<GLfloat>& GetVertexLighting(int mesh) const { return m_meshes[mesh].lighting; }
+
+private:
+	// a mesh with its positions, normals and baked colors
+	struct BAKE_MESH
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<GLuint> indices;
+		BAKE_MATERIAL material;
+		std::vector<GLfloat> lighting;
+	};
+
+	// a triangle with the first vertex and the two edges from it
+	struct RAY_TRIANGLE
+	{
+		glm::vec3 origin;
+		glm::vec3 edgeA;
+		glm::vec3 edgeB;
+	};
+
+	// a node of the hierarchy - inner nodes hold the index of
+	// their second child, as the first one follows them, and
+	// leaves hold a run of triangles
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int secondChild;
+		int firstTriangle;
+		int triangleCount;
+	};
+
+	std::vector<BAKE_MESH> m_meshes;
+	BAKE_LIGHT m_lights[MAX_LIGHTS];
+	std::vector<RAY_TRIANGLE> m_triangles;
+	std::vector<BVH_NODE> m_nodes;
+
+	// get the hash of the meshes, lights and bake values
+	uint64_t HashInputs() const;
+	// load or save the baked colors of every mesh
+	bool LoadCache(const std::string& path, uint64_t key);
+	void SaveCache(const std::string& path, uint64_t key) const;
+
+	// build the hierarchy over the triangles of every mesh
+	void BuildHierarchy();
+	// split the triangles of a node between two children
+	int BuildNode(
+		std::vector<int>& triangleOrder,
+		const std::vector<glm::vec3>& centers,
+		int first,
+		int count);
+	// check whether anything is hit along a ray before a distance
+	bool IsOccluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const;
+	// bake the color of one vertex
+	glm::vec3 BakeVertex(const BAKE_MESH& mesh, size_t vertex) const;
+};
@@ -1,5 +1,10 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <cstdio>           // heads-up display text
+#include <chrono>           // frame rate limit
+#include <atomic>           // shared exit code
+#include <thread>           // render thread
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +18,14 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderCache.h"
+#include "RenderSettings.h"
+#include "FrameAllocator.h"
+#include "GPUResources.h"
+#include "PostProcessor.h"
+#include "HudOverlay.h"
+#include "RegressionHarness.h"
+#include "GLReplay.h"
 
 // Namespace for declaring global variables
 namespace
@@ -20,6 +33,10 @@ namespace
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
 
+	// paths of the external GLSL shader files
+	const char* const VERTEX_SHADER_PATH = "../../Utilities/shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_PATH = "../../Utilities/shaders/fragmentShader.glsl";
+
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
@@ -27,90 +44,605 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// shader cache object for the specialized shader programs
+	ShaderCache* g_ShaderCache = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// post processor object for the passes drawn after the scene
+	PostProcessor* g_PostProcessor = nullptr;
+	// heads-up display object for the text drawn over each frame
+	HudOverlay* g_HudOverlay = nullptr;
+	// rendering options shared by the view manager and scene manager
+	RENDER_SETTINGS g_RenderSettings;
+
+	// frames rendered before the scene is expected to stop allocating,
+	// and the number of frames checked with --check-allocations
+	const int ALLOCATION_WARMUP_FRAMES = 10;
+	const int ALLOCATION_CHECK_FRAMES = 300;
+	// set by --check-allocations
+	bool g_bCheckAllocations = false;
+	// directory of the golden images set by --regression, or NULL
+	// to open the window as usual, and whether they are recorded
+	// again with --regression-update
+	const char* g_RegressionDirectory = NULL;
+	bool g_bUpdateGoldenImages = false;
+	// file that --capture records the GL commands of a frame to, or
+	// NULL, and the frame that is captured
+	const char* g_CaptureFilename = NULL;
+	int g_CaptureFrame = 10;
+	// file that --replay replays instead of opening the window, or
+	// NULL, and the number of timed passes over its frame
+	const char* g_ReplayFilename = NULL;
+	int g_ReplayRepeatCount = 20;
+
+	// longest time the render thread sleeps while nothing changes,
+	// so that edited shader files are still picked up
+	const double RENDER_IDLE_WAIT_TIME = 0.5;
+	// time between reports of the drawn and skipped frames
+	const double FRAME_REPORT_INTERVAL = 5.0;
+	// refresh rate of the display, for counting skipped frames
+	double g_DisplayRefreshRate = 60.0;
+
+	// height in pixels of the heads-up display text, and its
+	// distance from the corner of the window and from the edges
+	// of its panel
+	const float HUD_TEXT_SIZE = 16.0f;
+	const float HUD_MARGIN = 12.0f;
+	const float HUD_PANEL_PADDING = 8.0f;
+	// weight of each new frame in the frame time shown on the
+	// heads-up display, and the longest time between frames that
+	// is still counted, as a longer one follows an idle period
+	const double FRAME_TIME_SMOOTHING = 0.1;
+	const double MAX_COUNTED_FRAME_TIME = 0.25;
+
+	// exit code of the application, set by the render thread
+	std::atomic<int> g_RenderExitCode(EXIT_SUCCESS);
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void RenderThreadMain();
+void RenderScenePass();
+void DrawHud(int width, int height, double frameTime);
+int ReplayCapture(const char* filename, int repeatCount);
 
 
 /***********************************************************
  *  main(int, char*)
  *
  *  This function gets called after the application has been
- *  launched.
+ *  launched.  The main thread handles the window events and
+ *  steps the camera simulation, while the frames are drawn
+ *  on a separate render thread, so that input is never held
+ *  up by a slow frame.
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// --check-allocations renders a fixed number of frames and fails
+	// if any frame after the warmup allocates from the heap, if the
+	// tracked GPU memory grows after the warmup, or if any tracked
+	// GPU resource is still alive at shutdown - the heap is only
+	// counted on the render thread, in builds that define
+	// TRACK_HEAP_ALLOCATIONS, which the project does for Debug
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--check-allocations") == 0)
+		{
+			g_bCheckAllocations = true;
+		}
+		// --regression DIR draws the scene from fixed camera poses in
+		// a hidden window and fails if the frames differ visibly from
+		// the golden images in DIR, or take longer than their budgets
+		else if ((strcmp(argv[i], "--regression") == 0) && (i + 1 < argc))
+		{
+			g_RegressionDirectory = argv[++i];
+		}
+		// --regression-update DIR records the golden images and frame
+		// time budgets in DIR from this run
+		else if ((strcmp(argv[i], "--regression-update") == 0) && (i + 1 < argc))
+		{
+			g_RegressionDirectory = argv[++i];
+			g_bUpdateGoldenImages = true;
+		}
+		// --capture FILE records the GL commands of a frame, with the
+		// commands that set up its objects, for replaying offline
+		else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc))
+		{
+			g_CaptureFilename = argv[++i];
+		}
+		// --capture-frame N picks the frame that is captured
+		else if ((strcmp(argv[i], "--capture-frame") == 0) && (i + 1 < argc))
+		{
+			g_CaptureFrame = atoi(argv[++i]);
+		}
+		// --replay FILE replays a capture in a hidden window, times
+		// each call and reports the cost of the frame
+		else if ((strcmp(argv[i], "--replay") == 0) && (i + 1 < argc))
+		{
+			g_ReplayFilename = argv[++i];
+		}
+		// --replay-repeat N times the replayed frame over N passes
+		else if ((strcmp(argv[i], "--replay-repeat") == 0) && (i + 1 < argc))
+		{
+			g_ReplayRepeatCount = atoi(argv[++i]);
+		}
+		// --continuous draws every frame even when nothing changed
+		else if (strcmp(argv[i], "--continuous") == 0)
+		{
+			g_RenderSettings.bRenderOnChange = false;
+		}
+		// --swap-interval N waits for N vertical blanks at each swap
+		else if ((strcmp(argv[i], "--swap-interval") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.swapInterval = atoi(argv[++i]);
+		}
+		// --max-fps N limits the number of frames drawn per second
+		else if ((strcmp(argv[i], "--max-fps") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.maxFrameRate = atof(argv[++i]);
+		}
+		// --render-scale N draws the scene at N percent of the window size
+		else if ((strcmp(argv[i], "--render-scale") == 0) && (i + 1 < argc))
+		{
+			float renderScale = (float)atof(argv[++i]) / 100.0f;
+			g_RenderSettings.renderScale = glm::clamp(renderScale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+		}
+		// --aa off|msaa2|msaa4|msaa8|taa selects the anti-aliasing mode
+		else if ((strcmp(argv[i], "--aa") == 0) && (i + 1 < argc))
+		{
+			static const char* const modeNames[AA_MODE_COUNT] = { "off", "msaa2", "msaa4", "msaa8", "taa" };
+			const char* modeName = argv[++i];
+			for (int mode = 0; mode < AA_MODE_COUNT; mode++)
+			{
+				if (strcmp(modeName, modeNames[mode]) == 0)
+				{
+					g_RenderSettings.antiAliasingMode = mode;
+				}
+			}
+		}
+		// --target-fps N lowers the render scale when the GPU cannot
+		// draw N frames per second
+		else if ((strcmp(argv[i], "--target-fps") == 0) && (i + 1 < argc))
+		{
+			double targetFrameRate = atof(argv[++i]);
+			g_RenderSettings.targetFrameTime = (targetFrameRate > 0.0) ? 1.0 / targetFrameRate : 0.0;
+		}
+		// --texture-budget N keeps at most N megabytes of texture
+		// levels on the GPU, or any amount for 0 or less
+		else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.textureBudgetMB = atoi(argv[++i]);
+		}
+		// --gpu-culling culls the objects in a compute shader
+		else if (strcmp(argv[i], "--gpu-culling") == 0)
+		{
+			g_RenderSettings.bGPUCulling = true;
+		}
+		// --occlusion-culling also culls the objects hidden behind
+		// the depth of the previous frame
+		else if (strcmp(argv[i], "--occlusion-culling") == 0)
+		{
+			g_RenderSettings.bGPUCulling = true;
+			g_RenderSettings.bOcclusionCulling = true;
+		}
+		// --no-static-batching draws each static object on its own
+		else if (strcmp(argv[i], "--no-static-batching") == 0)
+		{
+			g_RenderSettings.bStaticBatching = false;
+		}
+		// --no-baked-lighting shades the static batches per pixel
+		// instead of with their baked lighting
+		else if (strcmp(argv[i], "--no-baked-lighting") == 0)
+		{
+			g_RenderSettings.bBakedLighting = false;
+		}
+		// --no-reflections draws the glossy objects without the
+		// reflections of the reflection probes
+		else if (strcmp(argv[i], "--no-reflections") == 0)
+		{
+			g_RenderSettings.bReflectionProbes = false;
+		}
+		// --no-hud starts with the heads-up display hidden
+		else if (strcmp(argv[i], "--no-hud") == 0)
+		{
+			g_RenderSettings.bShowHud = false;
+		}
+		// --no-animation starts with the animations paused
+		else if (strcmp(argv[i], "--no-animation") == 0)
+		{
+			g_RenderSettings.bAnimation = false;
+		}
+		// --animation-benchmark N times N animation updates on one
+		// thread and on all of them as animated entities are added
+		else if ((strcmp(argv[i], "--animation-benchmark") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.animationBenchmarkUpdates = atoi(argv[++i]);
+		}
+		// --software draws the scene with the software rasterizer
+		else if (strcmp(argv[i], "--software") == 0)
+		{
+			g_RenderSettings.bSoftwareRasterizer = true;
+		}
+		// --vulkan draws the scene with the Vulkan renderer, which
+		// also runs on the lavapipe CPU driver
+		else if (strcmp(argv[i], "--vulkan") == 0)
+		{
+			g_RenderSettings.bVulkanBackend = true;
+		}
+		// --software-threads N draws software frames, and splits the
+		// animation updates, on N threads, or one for each hardware
+		// thread for 0
+		else if ((strcmp(argv[i], "--software-threads") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.softwareThreadCount = atoi(argv[++i]);
+		}
+		// --software-frame FILE saves the first software frame as a
+		// PPM image
+		else if ((strcmp(argv[i], "--software-frame") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.bSoftwareRasterizer = true;
+			g_RenderSettings.softwareImagePath = argv[++i];
+		}
+		// --software-benchmark N times N frames with the software
+		// rasterizer and with OpenGL
+		else if ((strcmp(argv[i], "--software-benchmark") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.softwareBenchmarkFrames = atoi(argv[++i]);
+		}
+		// --deferred draws the opaque objects into a G-buffer and
+		// lights them afterwards
+		else if (strcmp(argv[i], "--deferred") == 0)
+		{
+			g_RenderSettings.bDeferredShading = true;
+		}
+		// --deferred-benchmark N times N frames with forward and
+		// deferred shading as lights are added
+		else if ((strcmp(argv[i], "--deferred-benchmark") == 0) && (i + 1 < argc))
+		{
+			g_RenderSettings.deferredBenchmarkFrames = atoi(argv[++i]);
+		}
+	}
+
+	if (NULL != g_ReplayFilename)
+	{
+		return(ReplayCapture(g_ReplayFilename, g_ReplayRepeatCount));
+	}
+
+	// the allocation check and the capture need a steady stream
+	// of frames
+	if (g_bCheckAllocations || (NULL != g_CaptureFilename))
+	{
+		g_RenderSettings.bRenderOnChange = false;
+	}
+	// the regression frames are drawn at the window size without
+	// waiting for the display, with the animated objects at rest,
+	// so they only depend on the scene
+	if (NULL != g_RegressionDirectory)
+	{
+		g_RenderSettings.swapInterval = 0;
+		g_RenderSettings.maxFrameRate = 0.0;
+		g_RenderSettings.targetFrameTime = 0.0;
+		g_RenderSettings.renderScale = 1.0f;
+		g_RenderSettings.bAnimation = false;
+	}
+#ifndef TRACK_HEAP_ALLOCATIONS
+	if (g_bCheckAllocations)
+	{
+		std::cout << "WARNING: Heap allocations are only counted in builds with TRACK_HEAP_ALLOCATIONS" << std::endl;
+	}
+#endif
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
+	// the regression run draws offscreen into a hidden window
+	if (NULL != g_RegressionDirectory)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
+	// the capture starts before the window is created, so it also
+	// records the state that the window sets up
+	if ((NULL != g_CaptureFilename) && (false == StartGLCapture(g_CaptureFilename, g_CaptureFrame)))
+	{
+		return(EXIT_FAILURE);
+	}
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
+	g_ViewManager->SetRenderSettings(&g_RenderSettings);
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (NULL == g_Window)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the video mode can only be queried from the main thread
+	const GLFWvidmode* pVideoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	if ((NULL != pVideoMode) && (pVideoMode->refreshRate > 0))
+	{
+		g_DisplayRefreshRate = pVideoMode->refreshRate;
+	}
+
+	// the OpenGL context is handed over to the render thread
+	glfwMakeContextCurrent(NULL);
+	std::thread renderThread(RenderThreadMain);
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		// wait for input events, or until the next simulation step
+		// is due while the camera is moving
+		glfwWaitEventsTimeout(g_ViewManager->GetSimulationWaitTime());
+
+		// apply the queued input and step the camera simulation
+		g_ViewManager->UpdateSimulation();
+	}
+
+	// the render thread may be waiting for the view to change, and
+	// it frees the objects that own OpenGL resources before exiting
+	g_ViewManager->WakeRenderThread();
+	renderThread.join();
+
+	// clear the allocated manager objects from memory
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+
+	// Terminates the program, which fails if the allocation check
+	// or the render thread setup failed
+	exit(g_RenderExitCode); 
+}
+
+/***********************************************************
+ *	RenderThreadMain()
+ *
+ *  This function owns the OpenGL context and draws frames
+ *  until the window is closed.  The camera values are taken
+ *  from the latest simulation steps of the main thread.
+ *  When drawing on change, a frame is only drawn after the
+ *  view or the scene changed, and the last presented frame
+ *  stays on the display in the meantime.
+ ***********************************************************/
+void RenderThreadMain()
+{
+	glfwMakeContextCurrent(g_Window);
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
 	{
-		return(EXIT_FAILURE);
+		g_RenderExitCode = EXIT_FAILURE;
+		glfwSetWindowShouldClose(g_Window, true);
+		glfwPostEmptyEvent();
+		glfwMakeContextCurrent(NULL);
+		return;
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// build the specialized shader programs from the external GLSL
+	// files, using the cached program binaries when possible
+	g_ShaderCache = new ShaderCache(g_ShaderManager);
+	if (false == g_ShaderCache->LoadShaders(
+		VERTEX_SHADER_PATH,
+		FRAGMENT_SHADER_PATH))
+	{
+		// fall back to the single program with the runtime switches
+		g_ShaderManager->LoadShaders(
+			VERTEX_SHADER_PATH,
+			FRAGMENT_SHADER_PATH);
+		g_ShaderManager->use();
+	}
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetRenderSettings(&g_RenderSettings);
+	g_SceneManager->SetShaderCache(g_ShaderCache);
 	g_SceneManager->PrepareScene();
 
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
+	// the scene is drawn as the first pass of the frame graph, at
+	// the size of the window framebuffer
+	GLint windowViewport[4];
+	glGetIntegerv(GL_VIEWPORT, windowViewport);
+	g_PostProcessor = new PostProcessor();
+	g_PostProcessor->Initialize(windowViewport[2], windowViewport[3]);
+	g_PostProcessor->SetRenderSettings(&g_RenderSettings);
+	g_PostProcessor->SetScenePass(
+		RenderScenePass,
+		glm::vec4(0.85f, 0.85f, 0.85f, 1.0f)); // Change wall color to a slighlty darker white -MK
+
+	// the heads-up display is drawn over the finished frames
+	g_HudOverlay = new HudOverlay();
+	g_HudOverlay->Initialize();
+
+	// wait for the vertical blank when swapping, if requested
+	glfwSwapInterval(g_RenderSettings.swapInterval);
+
+	// the regression run checks the fixed camera poses and then
+	// closes the window, failing the application on a regression
+	if (NULL != g_RegressionDirectory)
+	{
+		RegressionHarness harness(g_RegressionDirectory, g_bUpdateGoldenImages);
+		if (false == harness.Run(g_ViewManager, g_PostProcessor))
+		{
+			g_RenderExitCode = EXIT_FAILURE;
+		}
+		// with --vulkan the poses check the Vulkan frames against the
+		// golden images, so drawing them in software instead fails
+		if (g_RenderSettings.bVulkanBackend && g_SceneManager->HasVulkanFailed())
+		{
+			std::cout << "ERROR: Regression run asked for Vulkan, but the frames were drawn in software" << std::endl;
+			g_RenderExitCode = EXIT_FAILURE;
+		}
+		glfwSetWindowShouldClose(g_Window, true);
+		glfwPostEmptyEvent();
+	}
+
+	int frameCount = 0;
+	int allocatingFrameCount = 0;
+	// tracked GPU memory once the scene is warmed up, which should
+	// stay the same while nothing is rebuilt
+	size_t warmupGPUMemory = 0;
+
+	// the shortest time between the start of two frames
+	std::chrono::duration<double> minFramePeriod(0.0);
+	if (g_RenderSettings.maxFrameRate > 0.0)
+	{
+		minFramePeriod = std::chrono::duration<double>(1.0 / g_RenderSettings.maxFrameRate);
+	}
+	std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+	// smoothed time between drawn frames, for the heads-up display
+	double smoothedFrameTime = 0.0;
+
+	// frames drawn and display refreshes that showed an unchanged
+	// frame again since the last report
+	int drawnFrameCount = 0;
+	double idleTime = 0.0;
+	double lastFrameReportTime = glfwGetTime();
+
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// rebuild the shader programs if the shader files were edited
+		g_ShaderCache->ReloadIfChanged();
+
+		// report how many frames were not drawn because nothing changed
+		double currentTime = glfwGetTime();
+		if (currentTime - lastFrameReportTime >= FRAME_REPORT_INTERVAL)
+		{
+			if (idleTime > 0.0)
+			{
+				int skippedFrameCount = (int)(idleTime * g_DisplayRefreshRate);
+				std::cout << "INFO: Drew " << drawnFrameCount << " frames, skipped " << skippedFrameCount
+					<< " unchanged frames in " << (currentTime - lastFrameReportTime) << " s" << std::endl;
+			}
+			drawnFrameCount = 0;
+			idleTime = 0.0;
+			lastFrameReportTime = currentTime;
+		}
+
+		// the frame is drawn at the current size of the window, and
+		// nothing is drawn while the window is minimized
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		g_ViewManager->GetFramebufferSize(framebufferWidth, framebufferHeight);
+		g_PostProcessor->SetOutputSize(framebufferWidth, framebufferHeight);
+		if ((framebufferWidth <= 0) || (framebufferHeight <= 0))
+		{
+			g_ViewManager->WaitForViewChange(RENDER_IDLE_WAIT_TIME);
+			continue;
+		}
+
+		// leave the last frame on the display until something changes,
+		// unless TAA is still refining it
+		if (g_RenderSettings.bRenderOnChange &&
+			(false == g_ViewManager->HasViewChanged()) &&
+			(false == g_SceneManager->HasSceneChanged()) &&
+			(false == g_PostProcessor->IsAccumulating()))
+		{
+			g_ViewManager->WaitForViewChange(RENDER_IDLE_WAIT_TIME);
+			idleTime += glfwGetTime() - currentTime;
+			continue;
+		}
 
-		// Clear the frame and z buffers
-		glClearColor(0.85f, 0.85f, 0.85f, 1.0f); // Change wall color to a slighlty darker white -MK
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// hold the frame back until the frame rate limit allows it
+		if (minFramePeriod.count() > 0.0)
+		{
+			std::this_thread::sleep_until(frameStartTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(minFramePeriod));
+		}
+		std::chrono::steady_clock::time_point previousFrameStartTime = frameStartTime;
+		frameStartTime = std::chrono::steady_clock::now();
+		double frameTime = std::chrono::duration<double>(frameStartTime - previousFrameStartTime).count();
+		if (frameTime < MAX_COUNTED_FRAME_TIME)
+		{
+			smoothedFrameTime = (smoothedFrameTime > 0.0) ?
+				smoothedFrameTime + (frameTime - smoothedFrameTime) * FRAME_TIME_SMOOTHING : frameTime;
+		}
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		// count the heap allocations made while rendering the frame
+		uint64_t frameStartAllocations = GetHeapAllocationCount();
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		// draw the scene and the screen effects that are turned on
+		g_PostProcessor->RenderFrame();
+		if (g_RenderSettings.bShowHud && g_HudOverlay->IsAvailable())
+		{
+			DrawHud(framebufferWidth, framebufferHeight, smoothedFrameTime);
+		}
+		EndGLCaptureFrame(framebufferWidth, framebufferHeight);
 
+		// once the scene is warmed up, rendering should not allocate
+		uint64_t frameAllocations = GetHeapAllocationCount() - frameStartAllocations;
+		frameCount++;
+		if (frameCount == ALLOCATION_WARMUP_FRAMES)
+		{
+			warmupGPUMemory = GetGPUMemoryUsage();
+		}
+		if ((frameCount > ALLOCATION_WARMUP_FRAMES) && (frameAllocations > 0))
+		{
+			if (allocatingFrameCount == 0)
+			{
+				std::cout << "WARNING: Frame " << frameCount << " made " << frameAllocations << " heap allocations" << std::endl;
+			}
+			allocatingFrameCount++;
+		}
+		if (g_bCheckAllocations && (frameCount >= ALLOCATION_WARMUP_FRAMES + ALLOCATION_CHECK_FRAMES))
+		{
+			std::cout << "INFO: " << allocatingFrameCount << " of " << ALLOCATION_CHECK_FRAMES << " frames made heap allocations" << std::endl;
+			if (allocatingFrameCount > 0)
+			{
+				g_RenderExitCode = EXIT_FAILURE;
+			}
+
+			ReportGPUMemoryUsage();
+			size_t checkGPUMemory = GetGPUMemoryUsage();
+			if (checkGPUMemory != warmupGPUMemory)
+			{
+				std::cout << "ERROR: Tracked GPU memory changed from " << warmupGPUMemory << " to "
+					<< checkGPUMemory << " bytes over " << ALLOCATION_CHECK_FRAMES << " frames" << std::endl;
+				g_RenderExitCode = EXIT_FAILURE;
+			}
+			glfwSetWindowShouldClose(g_Window, true);
+			glfwPostEmptyEvent();
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		// the frame is now presented, so the input it shows is measured
+		g_ViewManager->OnFramePresented();
+		drawnFrameCount++;
 	}
 
-	// clear the allocated manager objects from memory
+	// the OpenGL resources are freed while the context is current
+	if (NULL != g_HudOverlay)
+	{
+		delete g_HudOverlay;
+		g_HudOverlay = NULL;
+	}
+	if (NULL != g_PostProcessor)
+	{
+		delete g_PostProcessor;
+		g_PostProcessor = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
-	if (NULL != g_ViewManager)
+	if (NULL != g_ShaderCache)
 	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
+		delete g_ShaderCache;
+		g_ShaderCache = NULL;
 	}
 	if (NULL != g_ShaderManager)
 	{
@@ -118,8 +650,95 @@ int main(int argc, char* argv[])
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// every tracked resource should have been freed by its owner
+	if ((false == ReportGPUResourceLeaks()) && g_bCheckAllocations)
+	{
+		g_RenderExitCode = EXIT_FAILURE;
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+/***********************************************************
+ *	RenderScenePass()
+ *
+ *  This function draws the 3D scene into the targets of the
+ *  scene pass, which are bound and cleared by the frame
+ *  graph before it is called.
+ ***********************************************************/
+void RenderScenePass()
+{
+	// Enable z-depth
+	glEnable(GL_DEPTH_TEST);
+
+	// convert from 3D object space to 2D view, laid out in the
+	// target of the scene pass
+	g_ViewManager->PrepareSceneView(
+		g_PostProcessor->GetSceneWidth(),
+		g_PostProcessor->GetSceneHeight(),
+		g_PostProcessor->GetJitter());
+	g_PostProcessor->SetMainView(g_ViewManager->GetSceneViews()[0]);
+
+	// pass the viewports to the scene for sorting the objects
+	g_SceneManager->SetSceneViews(
+		g_ViewManager->GetSceneViews(),
+		g_ViewManager->GetSceneViewCount());
+
+	// pick the object under the last click, at the same point
+	// of the scene target
+	glm::vec2 pickPoint;
+	if (g_ViewManager->TakePickRequest(pickPoint))
+	{
+		g_SceneManager->PickObject(pickPoint * glm::vec2(
+			(float)g_PostProcessor->GetSceneWidth(),
+			(float)g_PostProcessor->GetSceneHeight()));
+	}
+
+	// refresh the 3D scene
+	g_SceneManager->RenderScene();
+}
+
+/***********************************************************
+ *  DrawHud()
+ *
+ *  This function draws the frame rate, the camera values
+ *  and the cost of the heads-up display itself over the
+ *  top left of the window.  The text is written into a
+ *  buffer on the stack, so the display does not allocate
+ *  while the frames are drawn.
+ ***********************************************************/
+void DrawHud(int width, int height, double frameTime)
+{
+	const ViewManager::CAMERA_STATE& camera = g_ViewManager->GetRenderState();
+	double framesPerSecond = (frameTime > 0.0) ? 1.0 / frameTime : 0.0;
+
+	char text[512];
+	snprintf(text, sizeof(text),
+		"FPS %.1f (%.2f ms)\n"
+		"Camera %.2f, %.2f, %.2f\n"
+		"Speed %.2f\n"
+		"Projection %s\n"
+		"HUD %.3f ms CPU, %.3f ms GPU",
+		framesPerSecond, frameTime * 1000.0,
+		camera.position.x, camera.position.y, camera.position.z,
+		camera.movementSpeed,
+		camera.bOrthographic ? "orthographic" : "perspective",
+		g_HudOverlay->GetCPUTime() * 1000.0, g_HudOverlay->GetGPUTime() * 1000.0);
+
+	// the text sits on a dark panel so it reads over the light walls
+	g_HudOverlay->BeginFrame(width, height);
+	glm::vec2 textSize = HudOverlay::GetTextSize(HUD_TEXT_SIZE, text);
+	g_HudOverlay->AddPanel(
+		HUD_MARGIN - HUD_PANEL_PADDING,
+		HUD_MARGIN - HUD_PANEL_PADDING,
+		textSize.x + HUD_PANEL_PADDING * 2.0f,
+		textSize.y + HUD_PANEL_PADDING * 2.0f,
+		glm::vec4(0.0f, 0.0f, 0.0f, 0.45f));
+	g_HudOverlay->AddText(HUD_MARGIN, HUD_MARGIN, HUD_TEXT_SIZE, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), text);
+
+	// the display is drawn into the window, over the last pass
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	g_HudOverlay->Draw();
 }
 
 /***********************************************************
@@ -174,4 +793,53 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	ReplayCapture()
+ *
+ *  This function is used to replay a GL capture in a hidden
+ *  window of the size it was captured at, and to report
+ *  the cost of each call of its frame.  The calls are also
+ *  written to a CSV file next to the capture.
+ ***********************************************************/
+int ReplayCapture(const char* filename, int repeatCount)
+{
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	int exitCode = EXIT_FAILURE;
+	GLReplay* pReplay = new GLReplay();
+	if (pReplay->Load(filename))
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* pWindow = glfwCreateWindow(pReplay->GetWidth(), pReplay->GetHeight(), WINDOW_TITLE, NULL, NULL);
+		if (NULL == pWindow)
+		{
+			std::cout << "ERROR: Failed to create the replay window" << std::endl;
+		}
+		else
+		{
+			glfwMakeContextCurrent(pWindow);
+			if (InitializeGLEW() && pReplay->Run(repeatCount))
+			{
+				std::string reportFilename = std::string(filename) + ".csv";
+				if (pReplay->Report(reportFilename.c_str()))
+				{
+					exitCode = EXIT_SUCCESS;
+				}
+			}
+
+			// the replay's queries are deleted with the context current
+			delete pReplay;
+			pReplay = NULL;
+			glfwDestroyWindow(pWindow);
+		}
+	}
+	delete pReplay;
+
+	glfwTerminate();
+	return(exitCode);
+}
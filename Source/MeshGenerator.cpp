@@ -0,0 +1,981 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.cpp
+// ============
+// generate parameterized shape meshes and keep each generated
+// variant in a cache, so that it is only built once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshGenerator.h"
+#include "GPUResources.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+// declaration of global variables and helper functions
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	// divisions are limited so that a mistyped value cannot
+	// create an enormous mesh
+	const int MIN_SEGMENTS = 3;
+	const int MAX_SEGMENTS = 512;
+
+	/***********************************************************
+	 *  BuildAngleTable()
+	 *
+	 *  This function is used for calculating the cosine and
+	 *  sine of evenly spaced angles once, so that the vertex
+	 *  loops only multiply and add.  The last angle repeats
+	 *  the first for a full turn, since the texture seam
+	 *  needs its own vertices.
+	 ***********************************************************/
+	void BuildAngleTable(
+		int count,
+		float startAngle,
+		float sweepAngle,
+		std::vector<float>& cosTable,
+		std::vector<float>& sinTable)
+	{
+		cosTable.resize(count + 1);
+		sinTable.resize(count + 1);
+
+		float step = sweepAngle / count;
+		for (int i = 0; i <= count; i++)
+		{
+			float angle = startAngle + step * i;
+			cosTable[i] = cosf(angle);
+			sinTable[i] = sinf(angle);
+		}
+	}
+
+	/***********************************************************
+	 *  AddVertex()
+	 *
+	 *  This function is used for appending a vertex with the
+	 *  layout used by the basic shape meshes.
+	 ***********************************************************/
+	inline void AddVertex(
+		MeshGenerator::MESH_DATA& meshData,
+		glm::vec3 position,
+		glm::vec3 normal,
+		float u,
+		float v)
+	{
+		GLfloat vertex[MeshGenerator::FLOATS_PER_VERTEX] =
+		{
+			position.x, position.y, position.z,
+			normal.x, normal.y, normal.z,
+			u, v
+		};
+		meshData.vertices.insert(meshData.vertices.end(), vertex, vertex + MeshGenerator::FLOATS_PER_VERTEX);
+	}
+
+	/***********************************************************
+	 *  GetVertexCount()
+	 *
+	 *  This function is used for getting the number of
+	 *  vertices that have been added to the mesh data.
+	 ***********************************************************/
+	inline GLuint GetVertexCount(const MeshGenerator::MESH_DATA& meshData)
+	{
+		return (GLuint)(meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX);
+	}
+
+	/***********************************************************
+	 *  AddGridIndices()
+	 *
+	 *  This function is used for adding the triangles of a
+	 *  grid of vertices that were added row by row.  The
+	 *  flip reverses the winding so the grid faces the other
+	 *  way.
+	 ***********************************************************/
+	void AddGridIndices(
+		MeshGenerator::MESH_DATA& meshData,
+		GLuint firstVertex,
+		int columns,
+		int rows,
+		bool bFlip)
+	{
+		GLuint rowLength = columns + 1;
+
+		for (int row = 0; row < rows; row++)
+		{
+			for (int column = 0; column < columns; column++)
+			{
+				GLuint v00 = firstVertex + row * rowLength + column;
+				GLuint v01 = v00 + 1;
+				GLuint v10 = v00 + rowLength;
+				GLuint v11 = v10 + 1;
+
+				if (bFlip)
+				{
+					GLuint quad[6] = { v00, v01, v10, v01, v11, v10 };
+					meshData.indices.insert(meshData.indices.end(), quad, quad + 6);
+				}
+				else
+				{
+					GLuint quad[6] = { v00, v10, v01, v01, v10, v11 };
+					meshData.indices.insert(meshData.indices.end(), quad, quad + 6);
+				}
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  AddCylinderWall()
+	 *
+	 *  This function is used for adding the side of a cone
+	 *  section between two heights, facing out or in.
+	 ***********************************************************/
+	void AddCylinderWall(
+		MeshGenerator::MESH_DATA& meshData,
+		const std::vector<float>& cosTable,
+		const std::vector<float>& sinTable,
+		float bottomY,
+		float topY,
+		float bottomRadius,
+		float topRadius,
+		bool bFacingOut)
+	{
+		int segments = (int)cosTable.size() - 1;
+		GLuint firstVertex = GetVertexCount(meshData);
+
+		// the normal leans up or down by the taper of the wall
+		float wallHeight = topY - bottomY;
+		float slope = bottomRadius - topRadius;
+		float normalScale = bFacingOut ? 1.0f : -1.0f;
+		float normalLength = sqrtf(wallHeight * wallHeight + slope * slope);
+		if (normalLength > 0.0f)
+		{
+			normalScale /= normalLength;
+		}
+
+		float rowY[2] = { bottomY, topY };
+		float rowRadius[2] = { bottomRadius, topRadius };
+		for (int row = 0; row < 2; row++)
+		{
+			for (int i = 0; i <= segments; i++)
+			{
+				glm::vec3 position(cosTable[i] * rowRadius[row], rowY[row], sinTable[i] * rowRadius[row]);
+				glm::vec3 normal(cosTable[i] * wallHeight, slope, sinTable[i] * wallHeight);
+				AddVertex(meshData, position, normal * normalScale, (float)i / segments, (float)row);
+			}
+		}
+
+		AddGridIndices(meshData, firstVertex, segments, 1, !bFacingOut);
+	}
+
+	/***********************************************************
+	 *  AddDisk()
+	 *
+	 *  This function is used for adding a flat disk, or a ring
+	 *  when the inner radius is above zero, facing up or down.
+	 ***********************************************************/
+	void AddDisk(
+		MeshGenerator::MESH_DATA& meshData,
+		const std::vector<float>& cosTable,
+		const std::vector<float>& sinTable,
+		float y,
+		float outerRadius,
+		float innerRadius,
+		bool bFacingUp)
+	{
+		int segments = (int)cosTable.size() - 1;
+		GLuint firstVertex = GetVertexCount(meshData);
+		glm::vec3 normal(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+
+		// the texture is mapped straight down onto the disk
+		float rowRadius[2] = { outerRadius, innerRadius };
+		int rowCount = (innerRadius > 0.0f) ? 2 : 1;
+		for (int row = 0; row < rowCount; row++)
+		{
+			float uvScale = 0.5f * rowRadius[row] / outerRadius;
+			for (int i = 0; i <= segments; i++)
+			{
+				glm::vec3 position(cosTable[i] * rowRadius[row], y, sinTable[i] * rowRadius[row]);
+				AddVertex(meshData, position, normal, 0.5f + cosTable[i] * uvScale, 0.5f + sinTable[i] * uvScale);
+			}
+		}
+
+		if (rowCount == 2)
+		{
+			AddGridIndices(meshData, firstVertex, segments, 1, !bFacingUp);
+			return;
+		}
+
+		// a solid disk is a fan around a center vertex
+		GLuint centerVertex = GetVertexCount(meshData);
+		AddVertex(meshData, glm::vec3(0.0f, y, 0.0f), normal, 0.5f, 0.5f);
+		for (int i = 0; i < segments; i++)
+		{
+			GLuint edge0 = firstVertex + i;
+			GLuint edge1 = firstVertex + i + 1;
+			if (bFacingUp)
+			{
+				GLuint triangle[3] = { centerVertex, edge1, edge0 };
+				meshData.indices.insert(meshData.indices.end(), triangle, triangle + 3);
+			}
+			else
+			{
+				GLuint triangle[3] = { centerVertex, edge0, edge1 };
+				meshData.indices.insert(meshData.indices.end(), triangle, triangle + 3);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildRoundedAxisTable()
+	 *
+	 *  This function is used for calculating the positions
+	 *  along one axis of a rounded box, with the samples
+	 *  spread around the rounded edge at each end and a
+	 *  single span across the flat middle.
+	 ***********************************************************/
+	void BuildRoundedAxisTable(
+		float halfExtent,
+		float radius,
+		int cornerSegments,
+		std::vector<float>& table)
+	{
+		table.clear();
+		if ((radius <= 0.0f) || (cornerSegments <= 0))
+		{
+			table.push_back(-halfExtent);
+			table.push_back(halfExtent);
+			return;
+		}
+
+		float flatExtent = halfExtent - radius;
+		for (int k = 0; k <= cornerSegments; k++)
+		{
+			float angle = 0.5f * PI * k / cornerSegments;
+			table.push_back(-flatExtent - radius * cosf(angle));
+		}
+		for (int k = cornerSegments; k >= 0; k--)
+		{
+			float angle = 0.5f * PI * k / cornerSegments;
+			table.push_back(flatExtent + radius * cosf(angle));
+		}
+	}
+
+	/***********************************************************
+	 *  HashValue()
+	 *
+	 *  This function is used for adding the bytes of a value
+	 *  to an FNV-1a hash.
+	 ***********************************************************/
+	template<typename T>
+	void HashValue(uint64_t& hash, const T& value)
+	{
+		unsigned char bytes[sizeof(T)];
+		memcpy(bytes, &value, sizeof(T));
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  MeshGenerator()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshGenerator::MeshGenerator()
+{
+}
+
+/***********************************************************
+ *  ~MeshGenerator()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshGenerator::~MeshGenerator()
+{
+	// free the OpenGL buffers of the generated meshes
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		DeleteMeshBuffers(m_meshes[i].buffers);
+	}
+	m_meshes.clear();
+	m_meshIndices.clear();
+}
+
+/***********************************************************
+ *  Cylinder()
+ *
+ *  This method is used for getting the parameters of a
+ *  cylinder along the Y axis.  Different radii give a
+ *  tapered cylinder, and an inner radius scale above zero
+ *  gives a hollow cylinder with a rim at the top.
+ ***********************************************************/
+MeshGenerator::SHAPE_PARAMETERS MeshGenerator::Cylinder(
+	int segments,
+	float bottomRadius,
+	float topRadius,
+	float height,
+	float innerRadiusScale,
+	bool bCapTop,
+	bool bCapBottom)
+{
+	SHAPE_PARAMETERS parameters = {};
+
+	parameters.shape = SHAPE_CYLINDER;
+	parameters.segments = segments;
+	parameters.bottomRadius = bottomRadius;
+	parameters.topRadius = topRadius;
+	parameters.height = height;
+	parameters.innerRadiusScale = innerRadiusScale;
+	parameters.bCapTop = bCapTop;
+	parameters.bCapBottom = bCapBottom;
+
+	return parameters;
+}
+
+/***********************************************************
+ *  Torus()
+ *
+ *  This method is used for getting the parameters of a
+ *  torus around the Z axis.  A sweep below 360 degrees
+ *  gives an open arc centered on the positive X axis, such
+ *  as the handle of a mug.
+ ***********************************************************/
+MeshGenerator::SHAPE_PARAMETERS MeshGenerator::Torus(
+	int segments,
+	int sides,
+	float majorRadius,
+	float minorRadius,
+	float sweepDegrees)
+{
+	SHAPE_PARAMETERS parameters = {};
+
+	parameters.shape = SHAPE_TORUS;
+	parameters.segments = segments;
+	parameters.sides = sides;
+	parameters.majorRadius = majorRadius;
+	parameters.minorRadius = minorRadius;
+	parameters.sweepDegrees = sweepDegrees;
+
+	return parameters;
+}
+
+/***********************************************************
+ *  RoundedBox()
+ *
+ *  This method is used for getting the parameters of a box
+ *  centered on the origin, with its edges and corners
+ *  rounded by the passed in radius.
+ ***********************************************************/
+MeshGenerator::SHAPE_PARAMETERS MeshGenerator::RoundedBox(
+	glm::vec3 size,
+	float cornerRadius,
+	int cornerSegments)
+{
+	SHAPE_PARAMETERS parameters = {};
+
+	parameters.shape = SHAPE_ROUNDED_BOX;
+	parameters.segments = cornerSegments;
+	parameters.size = size;
+	parameters.cornerRadius = cornerRadius;
+
+	return parameters;
+}
+
+/***********************************************************
+ *  ReduceDetail()
+ *
+ *  This method is used for getting the parameters of the
+ *  same shape with fewer divisions, for drawing it when it
+ *  is small on screen.  The divisions are halved for each
+ *  level, but not below the fewest the shape is built with.
+ ***********************************************************/
+MeshGenerator::SHAPE_PARAMETERS MeshGenerator::ReduceDetail(const SHAPE_PARAMETERS& parameters, int level)
+{
+	SHAPE_PARAMETERS reduced = parameters;
+
+	// rounded boxes can drop their rounded edges altogether
+	int minSegments = (parameters.shape == SHAPE_ROUNDED_BOX) ? 1 : MIN_SEGMENTS;
+	reduced.segments = std::max(parameters.segments >> level, std::min(parameters.segments, minSegments));
+	if (parameters.shape == SHAPE_TORUS)
+	{
+		reduced.sides = std::max(parameters.sides >> level, std::min(parameters.sides, MIN_SEGMENTS));
+	}
+
+	return reduced;
+}
+
+/***********************************************************
+ *  FindOrCreateMesh()
+ *
+ *  This method is used for getting the cached mesh for a
+ *  set of shape parameters.  The mesh is generated and
+ *  loaded into OpenGL the first time it is asked for, and
+ *  -1 is returned if it could not be generated.
+ ***********************************************************/
+int MeshGenerator::FindOrCreateMesh(const SHAPE_PARAMETERS& parameters)
+{
+	// the hash is only a lookup key, so a match is confirmed by
+	// comparing the parameters, and a collision is probed past
+	uint64_t hash = HashParameters(parameters);
+	std::unordered_map<uint64_t, int>::const_iterator found = m_meshIndices.find(hash);
+	while (found != m_meshIndices.end())
+	{
+		if (IsSameParameters(m_meshes[found->second].parameters, parameters))
+		{
+			return found->second;
+		}
+		hash++;
+		found = m_meshIndices.find(hash);
+	}
+
+	MESH_DATA meshData;
+	if (false == GenerateMeshData(parameters, meshData))
+	{
+		std::cout << "Could not generate mesh for shape type " << parameters.shape << std::endl;
+		return -1;
+	}
+
+	GENERATED_MESH mesh;
+	mesh.parameters = parameters;
+	if (false == UploadMeshBuffers(
+		meshData.vertices.data(),
+		meshData.vertices.size() / FLOATS_PER_VERTEX,
+		meshData.indices.data(),
+		meshData.indices.size(),
+		meshData.boundsMin,
+		meshData.boundsMax,
+		mesh.buffers))
+	{
+		return -1;
+	}
+
+	int index = (int)m_meshes.size();
+	m_meshes.push_back(mesh);
+	m_meshIndices[hash] = index;
+
+	return index;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing a generated mesh with
+ *  the currently active shader program.
+ ***********************************************************/
+void MeshGenerator::DrawMesh(int index) const
+{
+	if ((index < 0) || (index >= (int)m_meshes.size()))
+	{
+		return;
+	}
+
+	DrawMeshBuffers(m_meshes[index].buffers);
+}
+
+/***********************************************************
+ *  GenerateMeshData()
+ *
+ *  This method is used for building the vertex and index
+ *  data of a shape, along with its bounding box.
+ ***********************************************************/
+bool MeshGenerator::GenerateMeshData(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData)
+{
+	meshData.vertices.clear();
+	meshData.indices.clear();
+
+	switch (parameters.shape)
+	{
+	case SHAPE_CYLINDER:
+		GenerateCylinder(parameters, meshData);
+		break;
+	case SHAPE_TORUS:
+		GenerateTorus(parameters, meshData);
+		break;
+	case SHAPE_ROUNDED_BOX:
+		GenerateRoundedBox(parameters, meshData);
+		break;
+	default:
+		return false;
+	}
+
+	if (meshData.indices.empty())
+	{
+		return false;
+	}
+
+	// the bounding box is taken from the generated positions
+	meshData.boundsMin = glm::vec3(FLT_MAX);
+	meshData.boundsMax = glm::vec3(-FLT_MAX);
+	for (size_t i = 0; i < meshData.vertices.size(); i += FLOATS_PER_VERTEX)
+	{
+		glm::vec3 position(meshData.vertices[i], meshData.vertices[i + 1], meshData.vertices[i + 2]);
+		meshData.boundsMin = glm::min(meshData.boundsMin, position);
+		meshData.boundsMax = glm::max(meshData.boundsMax, position);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  HashParameters()
+ *
+ *  This method is used for calculating the cache key of a
+ *  set of shape parameters.  The fields are hashed one by
+ *  one, so padding bytes never change the key.
+ ***********************************************************/
+uint64_t MeshGenerator::HashParameters(const SHAPE_PARAMETERS& parameters)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	HashValue(hash, parameters.shape);
+	HashValue(hash, parameters.segments);
+	HashValue(hash, parameters.sides);
+	HashValue(hash, parameters.bottomRadius);
+	HashValue(hash, parameters.topRadius);
+	HashValue(hash, parameters.innerRadiusScale);
+	HashValue(hash, parameters.height);
+	HashValue(hash, parameters.bCapTop);
+	HashValue(hash, parameters.bCapBottom);
+	HashValue(hash, parameters.majorRadius);
+	HashValue(hash, parameters.minorRadius);
+	HashValue(hash, parameters.sweepDegrees);
+	HashValue(hash, parameters.size.x);
+	HashValue(hash, parameters.size.y);
+	HashValue(hash, parameters.size.z);
+	HashValue(hash, parameters.cornerRadius);
+
+	return hash;
+}
+
+/***********************************************************
+ *  IsSameParameters()
+ *
+ *  This method is used for checking whether two sets of
+ *  shape parameters describe the same mesh.
+ ***********************************************************/
+bool MeshGenerator::IsSameParameters(const SHAPE_PARAMETERS& a, const SHAPE_PARAMETERS& b)
+{
+	return (a.shape == b.shape) &&
+		(a.segments == b.segments) &&
+		(a.sides == b.sides) &&
+		(a.bottomRadius == b.bottomRadius) &&
+		(a.topRadius == b.topRadius) &&
+		(a.innerRadiusScale == b.innerRadiusScale) &&
+		(a.height == b.height) &&
+		(a.bCapTop == b.bCapTop) &&
+		(a.bCapBottom == b.bCapBottom) &&
+		(a.majorRadius == b.majorRadius) &&
+		(a.minorRadius == b.minorRadius) &&
+		(a.sweepDegrees == b.sweepDegrees) &&
+		(a.size == b.size) &&
+		(a.cornerRadius == b.cornerRadius);
+}
+
+/***********************************************************
+ *  UploadMeshBuffers()
+ *
+ *  This method is used for loading vertex and index data
+ *  into OpenGL buffers, with the vertex attributes at the
+ *  locations used by the scene shaders.  The data is only
+ *  read during the call, so it can come from any memory.
+ ***********************************************************/
+bool MeshGenerator::UploadMeshBuffers(
+	const GLfloat* vertices,
+	size_t vertexCount,
+	const GLuint* indices,
+	size_t indexCount,
+	glm::vec3 boundsMin,
+	glm::vec3 boundsMax,
+	MESH_BUFFERS& buffers)
+{
+	const GLsizei stride = FLOATS_PER_VERTEX * sizeof(GLfloat);
+
+	if ((NULL == vertices) || (NULL == indices) || (vertexCount == 0) || (indexCount == 0))
+	{
+		return false;
+	}
+
+	buffers.vao = GenTrackedVertexArray("mesh");
+	glBindVertexArray(buffers.vao);
+
+	buffers.vbo = GenTrackedBuffer("mesh vertices");
+	glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, vertices, GL_STATIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, buffers.vbo, vertexCount * stride);
+
+	buffers.ebo = GenTrackedBuffer("mesh indices");
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, buffers.ebo, indexCount * sizeof(GLuint));
+
+	// vertex positions, normals and texture coordinates
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat)));
+	glEnableVertexAttribArray(2);
+
+	glBindVertexArray(0);
+
+	buffers.indexCount = (GLsizei)indexCount;
+	buffers.boundsMin = boundsMin;
+	buffers.boundsMax = boundsMax;
+
+	return true;
+}
+
+/***********************************************************
+ *  ReadMeshData()
+ *
+ *  This method is used for copying the vertex and index data
+ *  of loaded mesh buffers back into system memory, for
+ *  meshes whose data was not kept after loading.  It waits
+ *  for the GPU, so it is only used while preparing a scene.
+ ***********************************************************/
+bool MeshGenerator::ReadMeshData(const MESH_BUFFERS& buffers, MESH_DATA& meshData)
+{
+	GLint64 vertexBytes = 0;
+
+	if ((0 == buffers.vbo) || (0 == buffers.ebo) || (buffers.indexCount <= 0))
+	{
+		return false;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffers.vbo);
+	glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+	meshData.vertices.resize((size_t)vertexBytes / sizeof(GLfloat));
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)(meshData.vertices.size() * sizeof(GLfloat)), meshData.vertices.data());
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffers.ebo);
+	meshData.indices.resize((size_t)buffers.indexCount);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)(meshData.indices.size() * sizeof(GLuint)), meshData.indices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	meshData.boundsMin = buffers.boundsMin;
+	meshData.boundsMax = buffers.boundsMax;
+
+	return true;
+}
+
+/***********************************************************
+ *  SubdivideMeshData()
+ *
+ *  This method is used for splitting long triangles into
+ *  smaller ones, for data that is stored at each vertex.
+ *  Each pass splits every edge that is too long at its
+ *  midpoint, once for each pair of vertices, and replaces
+ *  each triangle with the pieces for its split edges, so
+ *  neighbouring triangles stay joined.  Edges between
+ *  separate vertices at the same positions are split at
+ *  the same points, since only the length decides.
+ ***********************************************************/
+void MeshGenerator::SubdivideMeshData(MESH_DATA& meshData, float maxEdgeLength, size_t maxVertices)
+{
+	const int stride = FLOATS_PER_VERTEX;
+	const float maxLengthSquared = maxEdgeLength * maxEdgeLength;
+
+	if (maxEdgeLength <= 0.0f)
+	{
+		return;
+	}
+
+	std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+	std::vector<GLuint> indices;
+	bool bSplit = true;
+	while (bSplit)
+	{
+		bSplit = false;
+		midpoints.clear();
+		indices.clear();
+		indices.reserve(meshData.indices.size() * 2);
+
+		for (size_t triangle = 0; triangle + 2 < meshData.indices.size(); triangle += 3)
+		{
+			GLuint corners[3] = { meshData.indices[triangle], meshData.indices[triangle + 1], meshData.indices[triangle + 2] };
+			GLuint edgeMidpoints[3];
+			bool bEdgeSplit[3];
+			int splitCount = 0;
+
+			// edge i runs from corner i to the next corner
+			for (int edge = 0; edge < 3; edge++)
+			{
+				GLuint a = corners[edge];
+				GLuint b = corners[(edge + 1) % 3];
+				const GLfloat* pA = &meshData.vertices[(size_t)a * stride];
+				const GLfloat* pB = &meshData.vertices[(size_t)b * stride];
+				glm::vec3 offset(pB[0] - pA[0], pB[1] - pA[1], pB[2] - pA[2]);
+				size_t vertexCount = meshData.vertices.size() / stride;
+
+				bEdgeSplit[edge] = (glm::dot(offset, offset) > maxLengthSquared) && (vertexCount < maxVertices);
+				if (false == bEdgeSplit[edge])
+				{
+					continue;
+				}
+
+				std::pair<GLuint, GLuint> key(std::min(a, b), std::max(a, b));
+				auto found = midpoints.find(key);
+				if (found == midpoints.end())
+				{
+					GLfloat midpoint[FLOATS_PER_VERTEX];
+					for (int i = 0; i < stride; i++)
+					{
+						midpoint[i] = (pA[i] + pB[i]) * 0.5f;
+					}
+					glm::vec3 normal(midpoint[3], midpoint[4], midpoint[5]);
+					float normalLength = glm::length(normal);
+					if (normalLength > 0.0f)
+					{
+						midpoint[3] /= normalLength;
+						midpoint[4] /= normalLength;
+						midpoint[5] /= normalLength;
+					}
+					meshData.vertices.insert(meshData.vertices.end(), midpoint, midpoint + stride);
+					found = midpoints.emplace(key, (GLuint)vertexCount).first;
+				}
+				edgeMidpoints[edge] = found->second;
+				splitCount++;
+			}
+
+			if (splitCount == 0)
+			{
+				indices.insert(indices.end(), { corners[0], corners[1], corners[2] });
+			}
+			else if (splitCount == 3)
+			{
+				indices.insert(indices.end(), {
+					corners[0], edgeMidpoints[0], edgeMidpoints[2],
+					edgeMidpoints[0], corners[1], edgeMidpoints[1],
+					edgeMidpoints[2], edgeMidpoints[1], corners[2],
+					edgeMidpoints[0], edgeMidpoints[1], edgeMidpoints[2] });
+			}
+			else if (splitCount == 1)
+			{
+				// turn the split edge to the first edge
+				int edge = bEdgeSplit[0] ? 0 : (bEdgeSplit[1] ? 1 : 2);
+				GLuint a = corners[edge];
+				GLuint b = corners[(edge + 1) % 3];
+				GLuint c = corners[(edge + 2) % 3];
+				GLuint ab = edgeMidpoints[edge];
+				indices.insert(indices.end(), { a, ab, c, ab, b, c });
+			}
+			else
+			{
+				// turn the edge that is not split to the last edge
+				int edge = (false == bEdgeSplit[2]) ? 0 : ((false == bEdgeSplit[0]) ? 1 : 2);
+				GLuint a = corners[edge];
+				GLuint b = corners[(edge + 1) % 3];
+				GLuint c = corners[(edge + 2) % 3];
+				GLuint ab = edgeMidpoints[edge];
+				GLuint bc = edgeMidpoints[(edge + 1) % 3];
+				indices.insert(indices.end(), { ab, b, bc, a, ab, bc, a, bc, c });
+			}
+			bSplit = bSplit || (splitCount > 0);
+		}
+
+		meshData.indices.swap(indices);
+	}
+}
+
+/***********************************************************
+ *  DrawMeshBuffers()
+ *
+ *  This method is used for drawing the triangles of loaded
+ *  mesh buffers with the currently active shader program.
+ ***********************************************************/
+void MeshGenerator::DrawMeshBuffers(const MESH_BUFFERS& buffers)
+{
+	glBindVertexArray(buffers.vao);
+	glDrawElements(GL_TRIANGLES, buffers.indexCount, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DeleteMeshBuffers()
+ *
+ *  This method is used for freeing loaded mesh buffers.
+ ***********************************************************/
+void MeshGenerator::DeleteMeshBuffers(MESH_BUFFERS& buffers)
+{
+	DeleteTrackedVertexArray(buffers.vao);
+	DeleteTrackedBuffer(buffers.vbo);
+	DeleteTrackedBuffer(buffers.ebo);
+	buffers.indexCount = 0;
+}
+
+/***********************************************************
+ *  GenerateCylinder()
+ *
+ *  This method is used for building a cylinder along the Y
+ *  axis.  A hollow cylinder gets an inner wall and a rim
+ *  at the top, and a closed bottom gets a floor raised by
+ *  the wall thickness so it does not overlap the base.
+ ***********************************************************/
+void MeshGenerator::GenerateCylinder(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData)
+{
+	int segments = std::clamp(parameters.segments, MIN_SEGMENTS, MAX_SEGMENTS);
+	float height = parameters.height;
+	float bottomRadius = parameters.bottomRadius;
+	float topRadius = parameters.topRadius;
+	float innerScale = std::clamp(parameters.innerRadiusScale, 0.0f, 0.99f);
+	bool bHollow = (innerScale > 0.0f);
+
+	if (height <= 0.0f)
+	{
+		return;
+	}
+
+	std::vector<float> cosTable;
+	std::vector<float> sinTable;
+	BuildAngleTable(segments, 0.0f, 2.0f * PI, cosTable, sinTable);
+
+	meshData.vertices.reserve((size_t)(segments + 1) * 12 * FLOATS_PER_VERTEX);
+	meshData.indices.reserve((size_t)segments * 36);
+
+	AddCylinderWall(meshData, cosTable, sinTable, 0.0f, height, bottomRadius, topRadius, true);
+
+	if (false == bHollow)
+	{
+		if (parameters.bCapTop)
+		{
+			AddDisk(meshData, cosTable, sinTable, height, topRadius, 0.0f, true);
+		}
+		if (parameters.bCapBottom)
+		{
+			AddDisk(meshData, cosTable, sinTable, 0.0f, bottomRadius, 0.0f, false);
+		}
+		return;
+	}
+
+	// the inner wall starts at the floor when the bottom is closed
+	float floorY = 0.0f;
+	if (parameters.bCapBottom)
+	{
+		floorY = std::min(bottomRadius * (1.0f - innerScale), height * 0.5f);
+	}
+	float floorRadius = bottomRadius + (topRadius - bottomRadius) * (floorY / height);
+
+	AddCylinderWall(meshData, cosTable, sinTable, floorY, height, floorRadius * innerScale, topRadius * innerScale, false);
+	AddDisk(meshData, cosTable, sinTable, height, topRadius, topRadius * innerScale, true);
+
+	if (parameters.bCapBottom)
+	{
+		AddDisk(meshData, cosTable, sinTable, 0.0f, bottomRadius, 0.0f, false);
+		AddDisk(meshData, cosTable, sinTable, floorY, floorRadius * innerScale, 0.0f, true);
+	}
+	else
+	{
+		AddDisk(meshData, cosTable, sinTable, 0.0f, bottomRadius, bottomRadius * innerScale, false);
+	}
+}
+
+/***********************************************************
+ *  GenerateTorus()
+ *
+ *  This method is used for building a torus around the Z
+ *  axis.  The angles around the ring and around the tube
+ *  are each calculated once, and every vertex is built
+ *  from the two tables.
+ ***********************************************************/
+void MeshGenerator::GenerateTorus(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData)
+{
+	int segments = std::clamp(parameters.segments, MIN_SEGMENTS, MAX_SEGMENTS);
+	int sides = std::clamp(parameters.sides, MIN_SEGMENTS, MAX_SEGMENTS);
+	float sweep = std::clamp(parameters.sweepDegrees, 1.0f, 360.0f) * PI / 180.0f;
+
+	std::vector<float> ringCos;
+	std::vector<float> ringSin;
+	std::vector<float> tubeCos;
+	std::vector<float> tubeSin;
+	BuildAngleTable(segments, -0.5f * sweep, sweep, ringCos, ringSin);
+	BuildAngleTable(sides, 0.0f, 2.0f * PI, tubeCos, tubeSin);
+
+	meshData.vertices.reserve((size_t)(segments + 1) * (sides + 1) * FLOATS_PER_VERTEX);
+	meshData.indices.reserve((size_t)segments * sides * 6);
+
+	GLuint firstVertex = GetVertexCount(meshData);
+	for (int ring = 0; ring <= segments; ring++)
+	{
+		for (int side = 0; side <= sides; side++)
+		{
+			glm::vec3 normal(tubeCos[side] * ringCos[ring], tubeCos[side] * ringSin[ring], tubeSin[side]);
+			glm::vec3 center(ringCos[ring] * parameters.majorRadius, ringSin[ring] * parameters.majorRadius, 0.0f);
+			AddVertex(meshData, center + normal * parameters.minorRadius, normal, (float)side / sides, (float)ring / segments);
+		}
+	}
+
+	AddGridIndices(meshData, firstVertex, sides, segments, false);
+}
+
+/***********************************************************
+ *  GenerateRoundedBox()
+ *
+ *  This method is used for building a box with rounded
+ *  edges.  Each face is a grid over the axis tables, and
+ *  every grid point is pushed out from the inner box by
+ *  the corner radius, so the faces meet on the rounding.
+ ***********************************************************/
+void MeshGenerator::GenerateRoundedBox(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData)
+{
+	glm::vec3 halfSize = parameters.size * 0.5f;
+	float radius = std::clamp(parameters.cornerRadius, 0.0f, std::min(halfSize.x, std::min(halfSize.y, halfSize.z)));
+	int cornerSegments = std::clamp(parameters.segments, 0, MAX_SEGMENTS);
+	glm::vec3 innerHalfSize = halfSize - glm::vec3(radius);
+
+	std::vector<float> axisTables[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		BuildRoundedAxisTable(halfSize[axis], radius, cornerSegments, axisTables[axis]);
+	}
+
+	// the normal axis of each face, and the two axes across it,
+	// ordered so the cross product of the two points outward
+	const int faceAxes[6][3] =
+	{
+		{ 0, 1, 2 }, { 0, 2, 1 },
+		{ 1, 2, 0 }, { 1, 0, 2 },
+		{ 2, 0, 1 }, { 2, 1, 0 }
+	};
+	const float faceSigns[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+
+	for (int face = 0; face < 6; face++)
+	{
+		int normalAxis = faceAxes[face][0];
+		int uAxis = faceAxes[face][1];
+		int vAxis = faceAxes[face][2];
+		const std::vector<float>& uTable = axisTables[uAxis];
+		const std::vector<float>& vTable = axisTables[vAxis];
+		int columns = (int)uTable.size() - 1;
+		int rows = (int)vTable.size() - 1;
+
+		glm::vec3 faceNormal(0.0f);
+		faceNormal[normalAxis] = faceSigns[face];
+
+		GLuint firstVertex = GetVertexCount(meshData);
+		for (int row = 0; row <= rows; row++)
+		{
+			for (int column = 0; column <= columns; column++)
+			{
+				glm::vec3 point;
+				point[normalAxis] = faceSigns[face] * halfSize[normalAxis];
+				point[uAxis] = uTable[column];
+				point[vAxis] = vTable[row];
+
+				glm::vec3 inner = glm::min(glm::max(point, -innerHalfSize), innerHalfSize);
+				glm::vec3 offset = point - inner;
+				float offsetLength = glm::length(offset);
+				glm::vec3 normal = (offsetLength > 0.0f) ? (offset / offsetLength) : faceNormal;
+
+				AddVertex(meshData, inner + normal * radius, normal, (float)column / columns, (float)row / rows);
+			}
+		}
+
+		AddGridIndices(meshData, firstVertex, columns, rows, true);
+	}
+}
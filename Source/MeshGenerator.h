@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.h
+// ============
+// generate parameterized shape meshes and keep each generated
+// variant in a cache, so that it is only built once
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  MeshGenerator
+ *
+ *  This class builds shape meshes from a set of parameters,
+ *  such as tapered or hollow cylinders, partial tori and
+ *  boxes with rounded edges.  The vertices use the same
+ *  layout as the basic shape meshes, so the scene shaders
+ *  can draw them unchanged.  Each variant is cached by the
+ *  hash of its parameters, so asking for the same shape
+ *  again only costs a lookup.
+ ***********************************************************/
+class MeshGenerator
+{
+public:
+	// the kinds of shapes that can be generated
+	enum SHAPE_TYPE
+	{
+		SHAPE_CYLINDER,
+		SHAPE_TORUS,
+		SHAPE_ROUNDED_BOX
+	};
+
+	// the parameters that describe a generated shape - the
+	// fields that are not used by a shape are left at zero
+	struct SHAPE_PARAMETERS
+	{
+		SHAPE_TYPE shape;
+		// divisions around the shape, and along the tube of a
+		// torus or the rounded edges of a box
+		int segments;
+		int sides;
+		// cylinder radii at the bottom and top, and the inner
+		// radius as a fraction of the outer radius - a value
+		// of 0 gives a solid cylinder
+		float bottomRadius;
+		float topRadius;
+		float innerRadiusScale;
+		float height;
+		// closed ends of a cylinder
+		bool bCapTop;
+		bool bCapBottom;
+		// torus ring and tube radii, and the part of the ring
+		// that is generated in degrees
+		float majorRadius;
+		float minorRadius;
+		float sweepDegrees;
+		// rounded box size and edge radius
+		glm::vec3 size;
+		float cornerRadius;
+	};
+
+	// vertex and index data of a generated shape
+	struct MESH_DATA
+	{
+		// position, normal and texture coordinate of each vertex
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// the OpenGL buffers of a mesh and its bounding box
+	struct MESH_BUFFERS
+	{
+		GLuint vao;
+		GLuint vbo;
+		GLuint ebo;
+		GLsizei indexCount;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// a generated shape that has been loaded into OpenGL
+	struct GENERATED_MESH
+	{
+		SHAPE_PARAMETERS parameters;
+		MESH_BUFFERS buffers;
+	};
+
+	// number of floats in each vertex
+	static const int FLOATS_PER_VERTEX = 8;
+
+	// constructor
+	MeshGenerator();
+	// destructor
+	~MeshGenerator();
+
+	// get the parameters for a cylinder along the Y axis from 0
+	// to the height, which can be tapered, hollow and capped
+	static SHAPE_PARAMETERS Cylinder(
+		int segments,
+		float bottomRadius,
+		float topRadius,
+		float height,
+		float innerRadiusScale = 0.0f,
+		bool bCapTop = true,
+		bool bCapBottom = true);
+	// get the parameters for a torus around the Z axis, which is
+	// centered on the X axis when only part of it is swept
+	static SHAPE_PARAMETERS Torus(
+		int segments,
+		int sides,
+		float majorRadius,
+		float minorRadius,
+		float sweepDegrees = 360.0f);
+	// get the parameters for a box centered on the origin with
+	// rounded edges and corners
+	static SHAPE_PARAMETERS RoundedBox(
+		glm::vec3 size,
+		float cornerRadius,
+		int cornerSegments);
+	// get the parameters of a coarser version of a shape, with
+	// the divisions halved for each level of detail
+	static SHAPE_PARAMETERS ReduceDetail(const SHAPE_PARAMETERS& parameters, int level);
+
+	// get the index of the cached mesh for the parameters,
+	// generating and loading it the first time it is asked for
+	int FindOrCreateMesh(const SHAPE_PARAMETERS& parameters);
+	// get a generated mesh by index
+	const GENERATED_MESH& GetMesh(int index) const { return m_meshes[index]; }
+	// draw a generated mesh by index
+	void DrawMesh(int index) const;
+
+	// build the vertex and index data of a shape
+	static bool GenerateMeshData(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData);
+
+	// load vertex and index data with the shape vertex layout
+	// into OpenGL buffers
+	static bool UploadMeshBuffers(
+		const GLfloat* vertices,
+		size_t vertexCount,
+		const GLuint* indices,
+		size_t indexCount,
+		glm::vec3 boundsMin,
+		glm::vec3 boundsMax,
+		MESH_BUFFERS& buffers);
+	// copy the vertex and index data of loaded mesh buffers back
+	// from OpenGL
+	static bool ReadMeshData(const MESH_BUFFERS& buffers, MESH_DATA& meshData);
+	// split the triangles of vertex and index data until no edge
+	// is longer than a length, or the vertices reach a limit
+	static void SubdivideMeshData(MESH_DATA& meshData, float maxEdgeLength, size_t maxVertices);
+	// draw the triangles of loaded mesh buffers
+	static void DrawMeshBuffers(const MESH_BUFFERS& buffers);
+	// free loaded mesh buffers
+	static void DeleteMeshBuffers(MESH_BUFFERS& buffers);
+
+private:
+	// the generated meshes, and their indices by parameter hash
+	std::vector<GENERATED_MESH> m_meshes;
+	std::unordered_map<uint64_t, int> m_meshIndices;
+
+	// calculate the hash of a set of shape parameters
+	static uint64_t HashParameters(const SHAPE_PARAMETERS& parameters);
+	// check whether two sets of shape parameters are the same
+	static bool IsSameParameters(const SHAPE_PARAMETERS& a, const SHAPE_PARAMETERS& b);
+
+	// build the data of each kind of shape
+	static void GenerateCylinder(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData);
+	static void GenerateTorus(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData);
+	static void GenerateRoundedBox(const SHAPE_PARAMETERS& parameters, MESH_DATA& meshData);
+};
@@ -0,0 +1,1574 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import external OBJ and glTF models, and keep them on disk as
+// binary mesh files that are memory-mapped on later launches
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables and helper types
+namespace
+{
+	// directory that the binary mesh files are kept in
+	const char* const g_MeshCacheDirectory = "MeshCache";
+
+	// identifies a binary mesh file, and the version of its layout
+	const uint32_t MESH_BLOB_MAGIC = 0x4853454D;	// "MESH"
+	const uint32_t MESH_BLOB_VERSION = 1;
+
+	// header at the start of a binary mesh file - it is followed
+	// by the interleaved vertices and then the 32-bit indices
+	struct MESH_BLOB_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceKey;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// glTF binary container values
+	const uint32_t GLB_MAGIC = 0x46546C67;		// "glTF"
+	const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+	const uint32_t GLB_CHUNK_BIN = 0x004E4942;	// "BIN"
+
+	// most positions, texture coordinates or normals in an OBJ
+	// file, so each index fits in 21 bits of the vertex key
+	const size_t MAX_OBJ_LIST_SIZE = 0x1FFFFE;
+
+	// glTF accessor component types and primitive mode
+	const int GLTF_UNSIGNED_BYTE = 5121;
+	const int GLTF_UNSIGNED_SHORT = 5123;
+	const int GLTF_UNSIGNED_INT = 5125;
+	const int GLTF_FLOAT = 5126;
+	const int GLTF_TRIANGLES = 4;
+
+	/***********************************************************
+	 *  MappedFile
+	 *
+	 *  This class maps a whole file into memory for reading,
+	 *  so its contents can be used without being copied.
+	 ***********************************************************/
+	class MappedFile
+	{
+	public:
+		MappedFile()
+		{
+			m_pData = NULL;
+			m_size = 0;
+#ifdef _WIN32
+			m_file = INVALID_HANDLE_VALUE;
+			m_mapping = NULL;
+#endif
+		}
+
+		~MappedFile()
+		{
+			Close();
+		}
+
+		bool Open(const std::string& filePath)
+		{
+			Close();
+#ifdef _WIN32
+			m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (m_file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER fileSize;
+			if ((FALSE == GetFileSizeEx(m_file, &fileSize)) || (fileSize.QuadPart == 0))
+			{
+				Close();
+				return false;
+			}
+			m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (NULL == m_mapping)
+			{
+				Close();
+				return false;
+			}
+			m_pData = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+			m_size = (size_t)fileSize.QuadPart;
+#else
+			int file = open(filePath.c_str(), O_RDONLY);
+			if (file < 0)
+			{
+				return false;
+			}
+			struct stat fileStatus;
+			if ((fstat(file, &fileStatus) != 0) || (fileStatus.st_size == 0))
+			{
+				close(file);
+				return false;
+			}
+			void* pMapping = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			close(file);
+			if (pMapping == MAP_FAILED)
+			{
+				return false;
+			}
+			m_pData = (const unsigned char*)pMapping;
+			m_size = (size_t)fileStatus.st_size;
+#endif
+			if (NULL == m_pData)
+			{
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		void Close()
+		{
+#ifdef _WIN32
+			if (NULL != m_pData)
+			{
+				UnmapViewOfFile(m_pData);
+			}
+			if (NULL != m_mapping)
+			{
+				CloseHandle(m_mapping);
+				m_mapping = NULL;
+			}
+			if (m_file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(m_file);
+				m_file = INVALID_HANDLE_VALUE;
+			}
+#else
+			if (NULL != m_pData)
+			{
+				munmap((void*)m_pData, m_size);
+			}
+#endif
+			m_pData = NULL;
+			m_size = 0;
+		}
+
+		const unsigned char* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		const unsigned char* m_pData;
+		size_t m_size;
+#ifdef _WIN32
+		HANDLE m_file;
+		HANDLE m_mapping;
+#endif
+	};
+
+	/***********************************************************
+	 *  JSON_VALUE
+	 *
+	 *  This structure holds a parsed JSON value.  Arrays and
+	 *  objects keep their values in the items, and objects
+	 *  also keep the member names in the same order.
+	 ***********************************************************/
+	struct JSON_VALUE
+	{
+		enum JSON_TYPE
+		{
+			JSON_NULL,
+			JSON_BOOL,
+			JSON_NUMBER,
+			JSON_STRING,
+			JSON_ARRAY,
+			JSON_OBJECT
+		};
+
+		JSON_TYPE type = JSON_NULL;
+		bool boolValue = false;
+		double number = 0.0;
+		std::string text;
+		std::vector<std::string> names;
+		std::vector<JSON_VALUE> items;
+
+		// find an object member by name
+		const JSON_VALUE* Find(const char* name) const
+		{
+			for (size_t i = 0; i < names.size(); i++)
+			{
+				if (names[i] == name)
+				{
+					return &items[i];
+				}
+			}
+			return NULL;
+		}
+
+		// get a number member, or the default if it is missing
+		double GetNumber(const char* name, double defaultValue) const
+		{
+			const JSON_VALUE* pValue = Find(name);
+			if ((NULL == pValue) || (pValue->type != JSON_NUMBER))
+			{
+				return defaultValue;
+			}
+			return pValue->number;
+		}
+
+		// get an array item, or NULL when it is out of range
+		const JSON_VALUE* GetItem(const char* name, int index) const
+		{
+			const JSON_VALUE* pArray = Find(name);
+			if ((NULL == pArray) || (pArray->type != JSON_ARRAY) || (index < 0) || (index >= (int)pArray->items.size()))
+			{
+				return NULL;
+			}
+			return &pArray->items[index];
+		}
+	};
+
+	/***********************************************************
+	 *  JsonParser
+	 *
+	 *  This class parses the JSON text of a glTF file.
+	 ***********************************************************/
+	class JsonParser
+	{
+	public:
+		JsonParser(const char* pText, size_t length)
+		{
+			m_pText = pText;
+			m_pEnd = pText + length;
+		}
+
+		bool Parse(JSON_VALUE& value)
+		{
+			return ParseValue(value, 0);
+		}
+
+	private:
+		// nesting limit so that a broken file cannot overflow the stack
+		static const int MAX_DEPTH = 128;
+
+		const char* m_pText;
+		const char* m_pEnd;
+
+		void SkipWhitespace()
+		{
+			while ((m_pText < m_pEnd) && ((*m_pText == ' ') || (*m_pText == '\t') || (*m_pText == '\n') || (*m_pText == '\r')))
+			{
+				m_pText++;
+			}
+		}
+
+		bool Match(const char* pWord)
+		{
+			size_t length = strlen(pWord);
+			if (((size_t)(m_pEnd - m_pText) < length) || (strncmp(m_pText, pWord, length) != 0))
+			{
+				return false;
+			}
+			m_pText += length;
+			return true;
+		}
+
+		bool ParseValue(JSON_VALUE& value, int depth)
+		{
+			SkipWhitespace();
+			if ((m_pText >= m_pEnd) || (depth > MAX_DEPTH))
+			{
+				return false;
+			}
+
+			switch (*m_pText)
+			{
+			case '{':
+				return ParseObject(value, depth);
+			case '[':
+				return ParseArray(value, depth);
+			case '"':
+				value.type = JSON_VALUE::JSON_STRING;
+				return ParseString(value.text);
+			case 't':
+				value.type = JSON_VALUE::JSON_BOOL;
+				value.boolValue = true;
+				return Match("true");
+			case 'f':
+				value.type = JSON_VALUE::JSON_BOOL;
+				value.boolValue = false;
+				return Match("false");
+			case 'n':
+				value.type = JSON_VALUE::JSON_NULL;
+				return Match("null");
+			default:
+				return ParseNumber(value);
+			}
+		}
+
+		bool ParseNumber(JSON_VALUE& value)
+		{
+			// the number is copied so strtod cannot read past the text
+			char buffer[64];
+			size_t length = 0;
+			while ((m_pText + length < m_pEnd) && (length < sizeof(buffer) - 1) &&
+				(strchr("+-0123456789.eE", m_pText[length]) != NULL))
+			{
+				buffer[length] = m_pText[length];
+				length++;
+			}
+			buffer[length] = '\0';
+
+			char* pNumberEnd = NULL;
+			value.type = JSON_VALUE::JSON_NUMBER;
+			value.number = strtod(buffer, &pNumberEnd);
+			if ((length == 0) || (pNumberEnd != buffer + length))
+			{
+				return false;
+			}
+			m_pText += length;
+			return true;
+		}
+
+		bool ParseString(std::string& text)
+		{
+			m_pText++;
+			text.clear();
+			while (m_pText < m_pEnd)
+			{
+				char c = *m_pText++;
+				if (c == '"')
+				{
+					return true;
+				}
+				if (c != '\\')
+				{
+					text.push_back(c);
+					continue;
+				}
+				if (m_pText >= m_pEnd)
+				{
+					return false;
+				}
+				c = *m_pText++;
+				switch (c)
+				{
+				case 'b': text.push_back('\b'); break;
+				case 'f': text.push_back('\f'); break;
+				case 'n': text.push_back('\n'); break;
+				case 'r': text.push_back('\r'); break;
+				case 't': text.push_back('\t'); break;
+				case 'u':
+				{
+					if (m_pEnd - m_pText < 4)
+					{
+						return false;
+					}
+					char hex[5] = { m_pText[0], m_pText[1], m_pText[2], m_pText[3], '\0' };
+					unsigned long codePoint = strtoul(hex, NULL, 16);
+					m_pText += 4;
+					// names in glTF files are only compared, so the
+					// character is stored as UTF-8 without pairing
+					if (codePoint < 0x80)
+					{
+						text.push_back((char)codePoint);
+					}
+					else if (codePoint < 0x800)
+					{
+						text.push_back((char)(0xC0 | (codePoint >> 6)));
+						text.push_back((char)(0x80 | (codePoint & 0x3F)));
+					}
+					else
+					{
+						text.push_back((char)(0xE0 | (codePoint >> 12)));
+						text.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+						text.push_back((char)(0x80 | (codePoint & 0x3F)));
+					}
+					break;
+				}
+				default:
+					text.push_back(c);
+					break;
+				}
+			}
+			return false;
+		}
+
+		bool ParseArray(JSON_VALUE& value, int depth)
+		{
+			value.type = JSON_VALUE::JSON_ARRAY;
+			m_pText++;
+			SkipWhitespace();
+			if ((m_pText < m_pEnd) && (*m_pText == ']'))
+			{
+				m_pText++;
+				return true;
+			}
+			while (m_pText < m_pEnd)
+			{
+				value.items.emplace_back();
+				if (false == ParseValue(value.items.back(), depth + 1))
+				{
+					return false;
+				}
+				SkipWhitespace();
+				if (m_pText >= m_pEnd)
+				{
+					return false;
+				}
+				char c = *m_pText++;
+				if (c == ']')
+				{
+					return true;
+				}
+				if (c != ',')
+				{
+					return false;
+				}
+			}
+			return false;
+		}
+
+		bool ParseObject(JSON_VALUE& value, int depth)
+		{
+			value.type = JSON_VALUE::JSON_OBJECT;
+			m_pText++;
+			SkipWhitespace();
+			if ((m_pText < m_pEnd) && (*m_pText == '}'))
+			{
+				m_pText++;
+				return true;
+			}
+			while (m_pText < m_pEnd)
+			{
+				SkipWhitespace();
+				if ((m_pText >= m_pEnd) || (*m_pText != '"'))
+				{
+					return false;
+				}
+				value.names.emplace_back();
+				if (false == ParseString(value.names.back()))
+				{
+					return false;
+				}
+				SkipWhitespace();
+				if ((m_pText >= m_pEnd) || (*m_pText++ != ':'))
+				{
+					return false;
+				}
+				value.items.emplace_back();
+				if (false == ParseValue(value.items.back(), depth + 1))
+				{
+					return false;
+				}
+				SkipWhitespace();
+				if (m_pText >= m_pEnd)
+				{
+					return false;
+				}
+				char c = *m_pText++;
+				if (c == '}')
+				{
+					return true;
+				}
+				if (c != ',')
+				{
+					return false;
+				}
+			}
+			return false;
+		}
+	};
+
+	/***********************************************************
+	 *  ReadFileBytes()
+	 *
+	 *  This function is used for reading a whole file.
+	 ***********************************************************/
+	bool ReadFileBytes(const std::string& filePath, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+		bytes.resize((size_t)size);
+		if ((size > 0) && !file.read((char*)bytes.data(), size))
+		{
+			return false;
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  DecodeBase64()
+	 *
+	 *  This function is used for decoding the base64 data of
+	 *  a glTF buffer that is embedded in a data URI.
+	 ***********************************************************/
+	bool DecodeBase64(const std::string& text, size_t start, std::vector<unsigned char>& bytes)
+	{
+		unsigned int bits = 0;
+		int bitCount = 0;
+
+		bytes.clear();
+		for (size_t i = start; i < text.size(); i++)
+		{
+			char c = text[i];
+			int value;
+			if ((c >= 'A') && (c <= 'Z')) value = c - 'A';
+			else if ((c >= 'a') && (c <= 'z')) value = c - 'a' + 26;
+			else if ((c >= '0') && (c <= '9')) value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else if (c == '=') break;
+			else return false;
+
+			bits = (bits << 6) | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back((unsigned char)((bits >> bitCount) & 0xFF));
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  GetNodeMatrix()
+	 *
+	 *  This function is used for getting the local transform
+	 *  of a glTF node from its matrix or its translation,
+	 *  rotation and scale.
+	 ***********************************************************/
+	glm::mat4 GetNodeMatrix(const JSON_VALUE& node)
+	{
+		glm::mat4 matrix(1.0f);
+
+		const JSON_VALUE* pMatrix = node.Find("matrix");
+		if ((NULL != pMatrix) && (pMatrix->items.size() == 16))
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					matrix[column][row] = (float)pMatrix->items[column * 4 + row].number;
+				}
+			}
+			return matrix;
+		}
+
+		const JSON_VALUE* pTranslation = node.Find("translation");
+		const JSON_VALUE* pRotation = node.Find("rotation");
+		const JSON_VALUE* pScale = node.Find("scale");
+		if ((NULL != pScale) && (pScale->items.size() == 3))
+		{
+			matrix = glm::scale(glm::vec3(
+				(float)pScale->items[0].number,
+				(float)pScale->items[1].number,
+				(float)pScale->items[2].number));
+		}
+		if ((NULL != pRotation) && (pRotation->items.size() == 4))
+		{
+			// glTF stores the rotation as x, y, z, w
+			glm::quat rotation(
+				(float)pRotation->items[3].number,
+				(float)pRotation->items[0].number,
+				(float)pRotation->items[1].number,
+				(float)pRotation->items[2].number);
+			matrix = glm::mat4_cast(rotation) * matrix;
+		}
+		if ((NULL != pTranslation) && (pTranslation->items.size() == 3))
+		{
+			matrix = glm::translate(glm::vec3(
+				(float)pTranslation->items[0].number,
+				(float)pTranslation->items[1].number,
+				(float)pTranslation->items[2].number)) * matrix;
+		}
+
+		return matrix;
+	}
+
+	/***********************************************************
+	 *  GLTF_DOCUMENT
+	 *
+	 *  This structure holds a parsed glTF file and the data of
+	 *  its buffers while the meshes are read from it.
+	 ***********************************************************/
+	struct GLTF_DOCUMENT
+	{
+		JSON_VALUE root;
+		std::vector<std::vector<unsigned char>> buffers;
+	};
+
+	/***********************************************************
+	 *  GetAccessorData()
+	 *
+	 *  This function is used for finding the bytes of a glTF
+	 *  accessor, checking that every element is in range.
+	 ***********************************************************/
+	bool GetAccessorData(
+		const GLTF_DOCUMENT& document,
+		int accessorIndex,
+		const unsigned char*& pData,
+		size_t& count,
+		size_t& stride,
+		int& componentType,
+		int& componentCount,
+		bool& bNormalized)
+	{
+		const JSON_VALUE* pAccessor = document.root.GetItem("accessors", accessorIndex);
+		if ((NULL == pAccessor) || (NULL != pAccessor->Find("sparse")))
+		{
+			return false;
+		}
+		const JSON_VALUE* pView = document.root.GetItem("bufferViews", (int)pAccessor->GetNumber("bufferView", -1));
+		if (NULL == pView)
+		{
+			return false;
+		}
+		int bufferIndex = (int)pView->GetNumber("buffer", -1);
+		if ((bufferIndex < 0) || (bufferIndex >= (int)document.buffers.size()))
+		{
+			return false;
+		}
+
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		if (NULL == pType)
+		{
+			return false;
+		}
+		if (pType->text == "SCALAR") componentCount = 1;
+		else if (pType->text == "VEC2") componentCount = 2;
+		else if (pType->text == "VEC3") componentCount = 3;
+		else if (pType->text == "VEC4") componentCount = 4;
+		else return false;
+
+		componentType = (int)pAccessor->GetNumber("componentType", 0);
+		size_t componentSize;
+		if ((componentType == GLTF_FLOAT) || (componentType == GLTF_UNSIGNED_INT)) componentSize = 4;
+		else if (componentType == GLTF_UNSIGNED_SHORT) componentSize = 2;
+		else if (componentType == GLTF_UNSIGNED_BYTE) componentSize = 1;
+		else return false;
+
+		const JSON_VALUE* pNormalized = pAccessor->Find("normalized");
+		bNormalized = (NULL != pNormalized) && pNormalized->boolValue;
+
+		size_t elementSize = componentSize * componentCount;
+		count = (size_t)pAccessor->GetNumber("count", 0);
+		stride = (size_t)pView->GetNumber("byteStride", (double)elementSize);
+		size_t offset = (size_t)pView->GetNumber("byteOffset", 0) + (size_t)pAccessor->GetNumber("byteOffset", 0);
+		size_t viewEnd = (size_t)pView->GetNumber("byteOffset", 0) + (size_t)pView->GetNumber("byteLength", 0);
+
+		const std::vector<unsigned char>& buffer = document.buffers[bufferIndex];
+		if ((count == 0) || (stride < elementSize) || (viewEnd > buffer.size()) ||
+			(offset + (count - 1) * stride + elementSize > viewEnd))
+		{
+			return false;
+		}
+
+		pData = buffer.data() + offset;
+		return true;
+	}
+
+	/***********************************************************
+	 *  ReadAccessorFloats()
+	 *
+	 *  This function is used for reading a glTF accessor as
+	 *  floats, converting normalized integers to 0 to 1.
+	 ***********************************************************/
+	bool ReadAccessorFloats(
+		const GLTF_DOCUMENT& document,
+		int accessorIndex,
+		int expectedComponents,
+		std::vector<float>& values)
+	{
+		const unsigned char* pData = NULL;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int componentCount = 0;
+		bool bNormalized = false;
+
+		if ((false == GetAccessorData(document, accessorIndex, pData, count, stride, componentType, componentCount, bNormalized)) ||
+			(componentCount != expectedComponents) ||
+			((componentType != GLTF_FLOAT) && (false == bNormalized)))
+		{
+			return false;
+		}
+
+		values.resize(count * componentCount);
+		for (size_t i = 0; i < count; i++)
+		{
+			const unsigned char* pElement = pData + i * stride;
+			for (int c = 0; c < componentCount; c++)
+			{
+				float value;
+				if (componentType == GLTF_FLOAT)
+				{
+					memcpy(&value, pElement + c * 4, 4);
+				}
+				else if (componentType == GLTF_UNSIGNED_SHORT)
+				{
+					uint16_t integer;
+					memcpy(&integer, pElement + c * 2, 2);
+					value = integer / 65535.0f;
+				}
+				else if (componentType == GLTF_UNSIGNED_BYTE)
+				{
+					value = pElement[c] / 255.0f;
+				}
+				else
+				{
+					return false;
+				}
+				values[i * componentCount + c] = value;
+			}
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  ReadAccessorIndices()
+	 *
+	 *  This function is used for reading a glTF index accessor
+	 *  as 32-bit indices.
+	 ***********************************************************/
+	bool ReadAccessorIndices(
+		const GLTF_DOCUMENT& document,
+		int accessorIndex,
+		std::vector<GLuint>& indices)
+	{
+		const unsigned char* pData = NULL;
+		size_t count = 0;
+		size_t stride = 0;
+		int componentType = 0;
+		int componentCount = 0;
+		bool bNormalized = false;
+
+		if ((false == GetAccessorData(document, accessorIndex, pData, count, stride, componentType, componentCount, bNormalized)) ||
+			(componentCount != 1) || (componentType == GLTF_FLOAT))
+		{
+			return false;
+		}
+
+		indices.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const unsigned char* pElement = pData + i * stride;
+			if (componentType == GLTF_UNSIGNED_INT)
+			{
+				uint32_t index;
+				memcpy(&index, pElement, 4);
+				indices[i] = index;
+			}
+			else if (componentType == GLTF_UNSIGNED_SHORT)
+			{
+				uint16_t index;
+				memcpy(&index, pElement, 2);
+				indices[i] = index;
+			}
+			else
+			{
+				indices[i] = pElement[0];
+			}
+		}
+		return true;
+	}
+}
+
+/***********************************************************
+ *  MeshImporter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshImporter::MeshImporter()
+{
+}
+
+/***********************************************************
+ *  ~MeshImporter()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshImporter::~MeshImporter()
+{
+	// free the OpenGL buffers of the loaded models
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		MeshGenerator::DeleteMeshBuffers(m_meshes[i].buffers);
+	}
+	m_meshes.clear();
+}
+
+/***********************************************************
+ *  LoadModel()
+ *
+ *  This method is used for loading a model file into an
+ *  OpenGL mesh.  A model that was loaded before is shared,
+ *  an up to date binary mesh file is mapped and uploaded
+ *  directly, and otherwise the model file is imported and
+ *  the binary mesh file is written for the next launch.
+ ***********************************************************/
+int MeshImporter::LoadModel(const char* filePath)
+{
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		if (m_meshes[i].filePath == filePath)
+		{
+			return (int)i;
+		}
+	}
+
+	uint64_t sourceKey = GetSourceKey(filePath);
+	if (sourceKey == 0)
+	{
+		std::cout << "Could not find model file:" << filePath << std::endl;
+		return -1;
+	}
+
+	IMPORTED_MESH mesh;
+	mesh.filePath = filePath;
+
+	std::string blobPath = GetBlobPath(filePath);
+	if (false == LoadMeshBlob(blobPath, sourceKey, mesh.buffers))
+	{
+		MeshGenerator::MESH_DATA meshData;
+		if (false == ImportModel(filePath, meshData))
+		{
+			std::cout << "Could not import model file:" << filePath << std::endl;
+			return -1;
+		}
+		if (false == MeshGenerator::UploadMeshBuffers(
+			meshData.vertices.data(),
+			meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX,
+			meshData.indices.data(),
+			meshData.indices.size(),
+			meshData.boundsMin,
+			meshData.boundsMax,
+			mesh.buffers))
+		{
+			return -1;
+		}
+		SaveMeshBlob(blobPath, sourceKey, meshData);
+		std::cout << "INFO: Imported model " << filePath << " with " << meshData.indices.size() / 3 << " triangles" << std::endl;
+	}
+
+	m_meshes.push_back(mesh);
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing a loaded model with the
+ *  currently active shader program.
+ ***********************************************************/
+void MeshImporter::DrawMesh(int index) const
+{
+	if ((index < 0) || (index >= (int)m_meshes.size()))
+	{
+		return;
+	}
+
+	MeshGenerator::DrawMeshBuffers(m_meshes[index].buffers);
+}
+
+/***********************************************************
+ *  ImportModel()
+ *
+ *  This method is used for parsing a model file into mesh
+ *  data, choosing the format by the file extension.
+ ***********************************************************/
+bool MeshImporter::ImportModel(const char* filePath, MeshGenerator::MESH_DATA& meshData)
+{
+	std::string extension = std::filesystem::path(filePath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return (char)tolower(c); });
+
+	meshData.vertices.clear();
+	meshData.indices.clear();
+
+	bool bImported = false;
+	if (extension == ".obj")
+	{
+		bImported = ImportOBJ(filePath, meshData);
+	}
+	else if ((extension == ".gltf") || (extension == ".glb"))
+	{
+		bImported = ImportGLTF(filePath, meshData);
+	}
+	else
+	{
+		std::cout << "Unsupported model format:" << extension << std::endl;
+	}
+
+	if ((false == bImported) || meshData.indices.empty())
+	{
+		return false;
+	}
+
+	OptimizeMesh(meshData);
+
+	return true;
+}
+
+/***********************************************************
+ *  ImportOBJ()
+ *
+ *  This method is used for parsing a Wavefront OBJ file.
+ *  Each unique position, texture coordinate and normal
+ *  combination becomes one vertex, and polygons are split
+ *  into triangle fans.
+ ***********************************************************/
+bool MeshImporter::ImportOBJ(const std::string& filePath, MeshGenerator::MESH_DATA& meshData)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	std::vector<glm::vec3> normals;
+	// vertex index for each combination of OBJ indices
+	std::unordered_map<uint64_t, GLuint> vertexIndices;
+	bool bMissingNormals = false;
+
+	std::string line;
+	std::vector<GLuint> polygon;
+	while (std::getline(file, line))
+	{
+		const char* p = line.c_str();
+		while ((*p == ' ') || (*p == '\t'))
+		{
+			p++;
+		}
+
+		if ((p[0] == 'v') && ((p[1] == ' ') || (p[1] == '\t')))
+		{
+			char* pNext = NULL;
+			glm::vec3 position;
+			position.x = strtof(p + 1, &pNext);
+			position.y = strtof(pNext, &pNext);
+			position.z = strtof(pNext, &pNext);
+			positions.push_back(position);
+		}
+		else if ((p[0] == 'v') && (p[1] == 't'))
+		{
+			char* pNext = NULL;
+			glm::vec2 texCoord;
+			texCoord.x = strtof(p + 2, &pNext);
+			texCoord.y = strtof(pNext, &pNext);
+			texCoords.push_back(texCoord);
+		}
+		else if ((p[0] == 'v') && (p[1] == 'n'))
+		{
+			char* pNext = NULL;
+			glm::vec3 normal;
+			normal.x = strtof(p + 2, &pNext);
+			normal.y = strtof(pNext, &pNext);
+			normal.z = strtof(pNext, &pNext);
+			normals.push_back(normal);
+		}
+		else if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+		{
+			if ((positions.size() > MAX_OBJ_LIST_SIZE) || (texCoords.size() > MAX_OBJ_LIST_SIZE) || (normals.size() > MAX_OBJ_LIST_SIZE))
+			{
+				std::cout << "OBJ file is too large to import:" << filePath << std::endl;
+				return false;
+			}
+			polygon.clear();
+			p++;
+			while (*p != '\0')
+			{
+				while ((*p == ' ') || (*p == '\t') || (*p == '\r'))
+				{
+					p++;
+				}
+				if (*p == '\0')
+				{
+					break;
+				}
+
+				// each corner is v, v/vt, v//vn or v/vt/vn, and
+				// negative indices count back from the end
+				long cornerIndices[3] = { 0, 0, 0 };
+				for (int k = 0; k < 3; k++)
+				{
+					char* pNext = NULL;
+					if ((*p != '/') && (*p != ' ') && (*p != '\0'))
+					{
+						cornerIndices[k] = strtol(p, &pNext, 10);
+						p = pNext;
+					}
+					if (*p != '/')
+					{
+						break;
+					}
+					p++;
+				}
+				while ((*p != ' ') && (*p != '\t') && (*p != '\0'))
+				{
+					p++;
+				}
+
+				long listSizes[3] = { (long)positions.size(), (long)texCoords.size(), (long)normals.size() };
+				for (int k = 0; k < 3; k++)
+				{
+					if (cornerIndices[k] < 0)
+					{
+						cornerIndices[k] += listSizes[k];
+					}
+					else
+					{
+						cornerIndices[k] -= 1;
+					}
+					if (cornerIndices[k] >= listSizes[k])
+					{
+						return false;
+					}
+				}
+				if (cornerIndices[0] < 0)
+				{
+					return false;
+				}
+
+				// 21 bits per index, with -1 stored as all ones
+				uint64_t key = ((uint64_t)(cornerIndices[0] & 0x1FFFFF)) |
+					((uint64_t)(cornerIndices[1] & 0x1FFFFF) << 21) |
+					((uint64_t)(cornerIndices[2] & 0x1FFFFF) << 42);
+				std::unordered_map<uint64_t, GLuint>::const_iterator found = vertexIndices.find(key);
+				if (found != vertexIndices.end())
+				{
+					polygon.push_back(found->second);
+					continue;
+				}
+
+				glm::vec3 position = positions[cornerIndices[0]];
+				glm::vec2 texCoord = (cornerIndices[1] >= 0) ? texCoords[cornerIndices[1]] : glm::vec2(0.0f);
+				glm::vec3 normal = (cornerIndices[2] >= 0) ? normals[cornerIndices[2]] : glm::vec3(0.0f);
+				bMissingNormals = bMissingNormals || (cornerIndices[2] < 0);
+
+				GLuint vertexIndex = (GLuint)(meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX);
+				GLfloat vertex[MeshGenerator::FLOATS_PER_VERTEX] =
+				{
+					position.x, position.y, position.z,
+					normal.x, normal.y, normal.z,
+					texCoord.x, texCoord.y
+				};
+				meshData.vertices.insert(meshData.vertices.end(), vertex, vertex + MeshGenerator::FLOATS_PER_VERTEX);
+				vertexIndices[key] = vertexIndex;
+				polygon.push_back(vertexIndex);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				meshData.indices.push_back(polygon[0]);
+				meshData.indices.push_back(polygon[i - 1]);
+				meshData.indices.push_back(polygon[i]);
+			}
+		}
+	}
+
+	if (bMissingNormals)
+	{
+		CalculateNormals(meshData, 0, 0);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ImportGLTF()
+ *
+ *  This method is used for parsing a glTF 2.0 file, either
+ *  as JSON with external or embedded buffers, or as a
+ *  binary .glb file.  The triangle primitives of every mesh
+ *  in the default scene are combined into one mesh, with
+ *  the node transforms applied.
+ ***********************************************************/
+bool MeshImporter::ImportGLTF(const std::string& filePath, MeshGenerator::MESH_DATA& meshData)
+{
+	std::vector<unsigned char> fileBytes;
+	if (false == ReadFileBytes(filePath, fileBytes))
+	{
+		return false;
+	}
+
+	GLTF_DOCUMENT document;
+	const char* pJson = (const char*)fileBytes.data();
+	size_t jsonLength = fileBytes.size();
+	std::vector<unsigned char> binaryChunk;
+
+	// a binary file holds a JSON chunk and an optional buffer chunk
+	uint32_t magic = 0;
+	if (fileBytes.size() >= 12)
+	{
+		memcpy(&magic, fileBytes.data(), 4);
+	}
+	if (magic == GLB_MAGIC)
+	{
+		size_t offset = 12;
+		jsonLength = 0;
+		while (offset + 8 <= fileBytes.size())
+		{
+			uint32_t chunkLength;
+			uint32_t chunkType;
+			memcpy(&chunkLength, fileBytes.data() + offset, 4);
+			memcpy(&chunkType, fileBytes.data() + offset + 4, 4);
+			offset += 8;
+			if (offset + chunkLength > fileBytes.size())
+			{
+				return false;
+			}
+			if (chunkType == GLB_CHUNK_JSON)
+			{
+				pJson = (const char*)fileBytes.data() + offset;
+				jsonLength = chunkLength;
+			}
+			else if (chunkType == GLB_CHUNK_BIN)
+			{
+				binaryChunk.assign(fileBytes.begin() + offset, fileBytes.begin() + offset + chunkLength);
+			}
+			offset += chunkLength;
+		}
+	}
+
+	JsonParser parser(pJson, jsonLength);
+	if ((false == parser.Parse(document.root)) || (document.root.type != JSON_VALUE::JSON_OBJECT))
+	{
+		std::cout << "Could not parse glTF file:" << filePath << std::endl;
+		return false;
+	}
+
+	// load the buffers from the binary chunk, data URIs or files
+	std::filesystem::path directory = std::filesystem::path(filePath).parent_path();
+	const JSON_VALUE* pBuffers = document.root.Find("buffers");
+	if (NULL != pBuffers)
+	{
+		for (size_t i = 0; i < pBuffers->items.size(); i++)
+		{
+			std::vector<unsigned char> buffer;
+			const JSON_VALUE* pUri = pBuffers->items[i].Find("uri");
+			if (NULL == pUri)
+			{
+				buffer = binaryChunk;
+			}
+			else if (pUri->text.compare(0, 5, "data:") == 0)
+			{
+				size_t dataStart = pUri->text.find(";base64,");
+				if ((dataStart == std::string::npos) || (false == DecodeBase64(pUri->text, dataStart + 8, buffer)))
+				{
+					return false;
+				}
+			}
+			else if (false == ReadFileBytes((directory / pUri->text).string(), buffer))
+			{
+				std::cout << "Could not read glTF buffer:" << pUri->text << std::endl;
+				return false;
+			}
+			document.buffers.push_back(buffer);
+		}
+	}
+
+	// collect the meshes of the default scene with their transforms
+	std::vector<std::pair<int, glm::mat4>> meshInstances;
+	const JSON_VALUE* pScene = document.root.GetItem("scenes", (int)document.root.GetNumber("scene", 0));
+	const JSON_VALUE* pSceneNodes = (NULL != pScene) ? pScene->Find("nodes") : NULL;
+	if (NULL != pSceneNodes)
+	{
+		std::vector<std::pair<int, glm::mat4>> nodeStack;
+		for (size_t i = 0; i < pSceneNodes->items.size(); i++)
+		{
+			nodeStack.push_back(std::make_pair((int)pSceneNodes->items[i].number, glm::mat4(1.0f)));
+		}
+		// a node count limit stops cycles in a broken file
+		size_t visitLimit = 65536;
+		while ((false == nodeStack.empty()) && (visitLimit-- > 0))
+		{
+			std::pair<int, glm::mat4> entry = nodeStack.back();
+			nodeStack.pop_back();
+
+			const JSON_VALUE* pNode = document.root.GetItem("nodes", entry.first);
+			if (NULL == pNode)
+			{
+				continue;
+			}
+			glm::mat4 worldMatrix = entry.second * GetNodeMatrix(*pNode);
+			if (NULL != pNode->Find("mesh"))
+			{
+				meshInstances.push_back(std::make_pair((int)pNode->GetNumber("mesh", -1), worldMatrix));
+			}
+			const JSON_VALUE* pChildren = pNode->Find("children");
+			if (NULL != pChildren)
+			{
+				for (size_t i = 0; i < pChildren->items.size(); i++)
+				{
+					nodeStack.push_back(std::make_pair((int)pChildren->items[i].number, worldMatrix));
+				}
+			}
+		}
+	}
+	else
+	{
+		const JSON_VALUE* pMeshes = document.root.Find("meshes");
+		for (size_t i = 0; (NULL != pMeshes) && (i < pMeshes->items.size()); i++)
+		{
+			meshInstances.push_back(std::make_pair((int)i, glm::mat4(1.0f)));
+		}
+	}
+
+	std::vector<float> positions;
+	std::vector<float> normals;
+	std::vector<float> texCoords;
+	std::vector<GLuint> indices;
+	for (size_t instance = 0; instance < meshInstances.size(); instance++)
+	{
+		const JSON_VALUE* pMesh = document.root.GetItem("meshes", meshInstances[instance].first);
+		const JSON_VALUE* pPrimitives = (NULL != pMesh) ? pMesh->Find("primitives") : NULL;
+		if (NULL == pPrimitives)
+		{
+			continue;
+		}
+
+		glm::mat4 worldMatrix = meshInstances[instance].second;
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldMatrix)));
+
+		for (size_t p = 0; p < pPrimitives->items.size(); p++)
+		{
+			const JSON_VALUE& primitive = pPrimitives->items[p];
+			const JSON_VALUE* pAttributes = primitive.Find("attributes");
+			if ((NULL == pAttributes) || ((int)primitive.GetNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES))
+			{
+				continue;
+			}
+
+			if (false == ReadAccessorFloats(document, (int)pAttributes->GetNumber("POSITION", -1), 3, positions))
+			{
+				continue;
+			}
+			size_t vertexCount = positions.size() / 3;
+			bool bHasNormals = ReadAccessorFloats(document, (int)pAttributes->GetNumber("NORMAL", -1), 3, normals) &&
+				(normals.size() == positions.size());
+			bool bHasTexCoords = ReadAccessorFloats(document, (int)pAttributes->GetNumber("TEXCOORD_0", -1), 2, texCoords) &&
+				(texCoords.size() / 2 == vertexCount);
+
+			if (NULL != primitive.Find("indices"))
+			{
+				if (false == ReadAccessorIndices(document, (int)primitive.GetNumber("indices", -1), indices))
+				{
+					continue;
+				}
+			}
+			else
+			{
+				indices.resize(vertexCount);
+				for (size_t i = 0; i < vertexCount; i++)
+				{
+					indices[i] = (GLuint)i;
+				}
+			}
+
+			size_t firstVertex = meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX;
+			size_t firstIndex = meshData.indices.size();
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				glm::vec3 position = glm::vec3(worldMatrix * glm::vec4(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], 1.0f));
+				glm::vec3 normal(0.0f);
+				if (bHasNormals)
+				{
+					normal = glm::normalize(normalMatrix * glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]));
+				}
+				// glTF texture coordinates start at the top of the image
+				float u = bHasTexCoords ? texCoords[i * 2] : 0.0f;
+				float v = bHasTexCoords ? 1.0f - texCoords[i * 2 + 1] : 0.0f;
+
+				GLfloat vertex[MeshGenerator::FLOATS_PER_VERTEX] =
+				{
+					position.x, position.y, position.z,
+					normal.x, normal.y, normal.z,
+					u, v
+				};
+				meshData.vertices.insert(meshData.vertices.end(), vertex, vertex + MeshGenerator::FLOATS_PER_VERTEX);
+			}
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				if ((indices[i] >= vertexCount) || (indices[i + 1] >= vertexCount) || (indices[i + 2] >= vertexCount))
+				{
+					return false;
+				}
+				meshData.indices.push_back((GLuint)firstVertex + indices[i]);
+				meshData.indices.push_back((GLuint)firstVertex + indices[i + 1]);
+				meshData.indices.push_back((GLuint)firstVertex + indices[i + 2]);
+			}
+
+			if (false == bHasNormals)
+			{
+				CalculateNormals(meshData, firstVertex, firstIndex);
+			}
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  CalculateNormals()
+ *
+ *  This method is used for calculating smooth normals for
+ *  the vertices from the first vertex onward that have no
+ *  normal, by adding up the normals of the triangles from
+ *  the first index onward that use them.
+ ***********************************************************/
+void MeshImporter::CalculateNormals(MeshGenerator::MESH_DATA& meshData, size_t firstVertex, size_t firstIndex)
+{
+	const size_t stride = MeshGenerator::FLOATS_PER_VERTEX;
+	size_t vertexCount = meshData.vertices.size() / stride;
+
+	// only the vertices that were read without a normal are changed
+	std::vector<bool> bNeedsNormal(vertexCount, false);
+	for (size_t i = firstVertex; i < vertexCount; i++)
+	{
+		GLfloat* pNormal = &meshData.vertices[i * stride + 3];
+		bNeedsNormal[i] = (pNormal[0] == 0.0f) && (pNormal[1] == 0.0f) && (pNormal[2] == 0.0f);
+	}
+
+	for (size_t i = firstIndex; i + 2 < meshData.indices.size(); i += 3)
+	{
+		GLuint corners[3] = { meshData.indices[i], meshData.indices[i + 1], meshData.indices[i + 2] };
+		glm::vec3 p0(meshData.vertices[corners[0] * stride], meshData.vertices[corners[0] * stride + 1], meshData.vertices[corners[0] * stride + 2]);
+		glm::vec3 p1(meshData.vertices[corners[1] * stride], meshData.vertices[corners[1] * stride + 1], meshData.vertices[corners[1] * stride + 2]);
+		glm::vec3 p2(meshData.vertices[corners[2] * stride], meshData.vertices[corners[2] * stride + 1], meshData.vertices[corners[2] * stride + 2]);
+		// the cross product is weighted by the triangle area
+		glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (bNeedsNormal[corners[k]])
+			{
+				meshData.vertices[corners[k] * stride + 3] += faceNormal.x;
+				meshData.vertices[corners[k] * stride + 4] += faceNormal.y;
+				meshData.vertices[corners[k] * stride + 5] += faceNormal.z;
+			}
+		}
+	}
+
+	for (size_t i = firstVertex; i < vertexCount; i++)
+	{
+		if (false == bNeedsNormal[i])
+		{
+			continue;
+		}
+		GLfloat* pNormal = &meshData.vertices[i * stride + 3];
+		glm::vec3 normal(pNormal[0], pNormal[1], pNormal[2]);
+		float length = glm::length(normal);
+		normal = (length > 0.0f) ? (normal / length) : glm::vec3(0.0f, 1.0f, 0.0f);
+		pNormal[0] = normal.x;
+		pNormal[1] = normal.y;
+		pNormal[2] = normal.z;
+	}
+}
+
+/***********************************************************
+ *  OptimizeMesh()
+ *
+ *  This method is used for storing the vertices in the
+ *  order the triangles first use them, so the vertex
+ *  fetches while drawing read memory mostly in order, and
+ *  vertices that no triangle uses are dropped.  The
+ *  bounding box is calculated from the remaining vertices.
+ ***********************************************************/
+void MeshImporter::OptimizeMesh(MeshGenerator::MESH_DATA& meshData)
+{
+	const size_t stride = MeshGenerator::FLOATS_PER_VERTEX;
+	size_t vertexCount = meshData.vertices.size() / stride;
+	const GLuint UNUSED = 0xFFFFFFFF;
+
+	std::vector<GLuint> remap(vertexCount, UNUSED);
+	std::vector<GLfloat> vertices;
+	vertices.reserve(meshData.vertices.size());
+
+	meshData.boundsMin = glm::vec3(FLT_MAX);
+	meshData.boundsMax = glm::vec3(-FLT_MAX);
+	for (size_t i = 0; i < meshData.indices.size(); i++)
+	{
+		GLuint oldIndex = meshData.indices[i];
+		if (remap[oldIndex] == UNUSED)
+		{
+			remap[oldIndex] = (GLuint)(vertices.size() / stride);
+			const GLfloat* pVertex = &meshData.vertices[oldIndex * stride];
+			vertices.insert(vertices.end(), pVertex, pVertex + stride);
+
+			glm::vec3 position(pVertex[0], pVertex[1], pVertex[2]);
+			meshData.boundsMin = glm::min(meshData.boundsMin, position);
+			meshData.boundsMax = glm::max(meshData.boundsMax, position);
+		}
+		meshData.indices[i] = remap[oldIndex];
+	}
+
+	meshData.vertices.swap(vertices);
+}
+
+/***********************************************************
+ *  GetSourceKey()
+ *
+ *  This method is used for identifying the current version
+ *  of a model file from its path, size and last modified
+ *  time.  Zero is returned if the file does not exist.
+ ***********************************************************/
+uint64_t MeshImporter::GetSourceKey(const std::string& filePath)
+{
+	std::error_code error;
+	uintmax_t fileSize = std::filesystem::file_size(filePath, error);
+	if (error)
+	{
+		return 0;
+	}
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, error);
+	if (error)
+	{
+		return 0;
+	}
+
+	uint64_t hash = 14695981039346656037ULL;
+	uint64_t values[2] = { (uint64_t)fileSize, (uint64_t)writeTime.time_since_epoch().count() };
+	const unsigned char* pBytes = (const unsigned char*)values;
+	for (size_t i = 0; i < sizeof(values); i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 1099511628211ULL;
+	}
+	for (size_t i = 0; i < filePath.size(); i++)
+	{
+		hash ^= (unsigned char)filePath[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return (hash != 0) ? hash : 1;
+}
+
+/***********************************************************
+ *  GetBlobPath()
+ *
+ *  This method is used for getting the path of the binary
+ *  mesh file for a model file, named by the hash of the
+ *  model path.
+ ***********************************************************/
+std::string MeshImporter::GetBlobPath(const std::string& filePath)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < filePath.size(); i++)
+	{
+		hash ^= (unsigned char)filePath[i];
+		hash *= 1099511628211ULL;
+	}
+
+	std::ostringstream path;
+	path << g_MeshCacheDirectory << "/" << std::hex << hash << ".mesh";
+
+	return path.str();
+}
+
+/***********************************************************
+ *  LoadMeshBlob()
+ *
+ *  This method is used for mapping a binary mesh file into
+ *  memory and uploading its vertices and indices straight
+ *  from the mapping.  The file is only used if it was made
+ *  from the current version of the model file.
+ ***********************************************************/
+bool MeshImporter::LoadMeshBlob(const std::string& blobPath, uint64_t sourceKey, MeshGenerator::MESH_BUFFERS& buffers)
+{
+	MappedFile file;
+	if ((false == file.Open(blobPath)) || (file.GetSize() < sizeof(MESH_BLOB_HEADER)))
+	{
+		return false;
+	}
+
+	MESH_BLOB_HEADER header;
+	memcpy(&header, file.GetData(), sizeof(header));
+	size_t vertexBytes = (size_t)header.vertexCount * MeshGenerator::FLOATS_PER_VERTEX * sizeof(GLfloat);
+	size_t indexBytes = (size_t)header.indexCount * sizeof(GLuint);
+	if ((header.magic != MESH_BLOB_MAGIC) ||
+		(header.version != MESH_BLOB_VERSION) ||
+		(header.sourceKey != sourceKey) ||
+		(file.GetSize() != sizeof(header) + vertexBytes + indexBytes))
+	{
+		return false;
+	}
+
+	const unsigned char* pVertices = file.GetData() + sizeof(header);
+	const unsigned char* pIndices = pVertices + vertexBytes;
+
+	return MeshGenerator::UploadMeshBuffers(
+		(const GLfloat*)pVertices,
+		header.vertexCount,
+		(const GLuint*)pIndices,
+		header.indexCount,
+		glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+		glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]),
+		buffers);
+}
+
+/***********************************************************
+ *  SaveMeshBlob()
+ *
+ *  This method is used for writing imported mesh data as a
+ *  binary mesh file, in the layout that is uploaded to
+ *  OpenGL, so that loading it needs no parsing.
+ ***********************************************************/
+bool MeshImporter::SaveMeshBlob(const std::string& blobPath, uint64_t sourceKey, const MeshGenerator::MESH_DATA& meshData)
+{
+	std::error_code error;
+	std::filesystem::create_directories(g_MeshCacheDirectory, error);
+
+	MESH_BLOB_HEADER header;
+	header.magic = MESH_BLOB_MAGIC;
+	header.version = MESH_BLOB_VERSION;
+	header.sourceKey = sourceKey;
+	header.vertexCount = (uint32_t)(meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX);
+	header.indexCount = (uint32_t)meshData.indices.size();
+	for (int i = 0; i < 3; i++)
+	{
+		header.boundsMin[i] = meshData.boundsMin[i];
+		header.boundsMax[i] = meshData.boundsMax[i];
+	}
+
+	std::ofstream file(blobPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write mesh cache file:" << blobPath << std::endl;
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)meshData.vertices.data(), meshData.vertices.size() * sizeof(GLfloat));
+	file.write((const char*)meshData.indices.data(), meshData.indices.size() * sizeof(GLuint));
+
+	return file.good();
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import external OBJ and glTF models, and keep them on disk as
+// binary mesh files that are memory-mapped on later launches
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshImporter
+ *
+ *  This class loads model files into meshes that can be
+ *  drawn like the basic shape meshes.  The first time a
+ *  model is loaded it is parsed, indexed and saved as a
+ *  binary mesh file with its bounding box, and later
+ *  launches map that file into memory and hand it straight
+ *  to OpenGL without parsing anything.
+ ***********************************************************/
+class MeshImporter
+{
+public:
+	// constructor
+	MeshImporter();
+	// destructor
+	~MeshImporter();
+
+	// load a model file, using the binary mesh file when it is
+	// up to date - returns the mesh index, or -1 on failure
+	int LoadModel(const char* filePath);
+	// get a loaded mesh by index
+	const MeshGenerator::MESH_BUFFERS& GetMesh(int index) const { return m_meshes[index].buffers; }
+	// draw a loaded mesh by index
+	void DrawMesh(int index) const;
+
+	// parse a model file into indexed mesh data
+	static bool ImportModel(const char* filePath, MeshGenerator::MESH_DATA& meshData);
+
+private:
+	// a model that has been loaded into OpenGL
+	struct IMPORTED_MESH
+	{
+		std::string filePath;
+		MeshGenerator::MESH_BUFFERS buffers;
+	};
+
+	// the loaded models
+	std::vector<IMPORTED_MESH> m_meshes;
+
+	// parse each of the supported model formats
+	static bool ImportOBJ(const std::string& filePath, MeshGenerator::MESH_DATA& meshData);
+	static bool ImportGLTF(const std::string& filePath, MeshGenerator::MESH_DATA& meshData);
+	// order the vertices by first use and calculate the bounds
+	static void OptimizeMesh(MeshGenerator::MESH_DATA& meshData);
+	// calculate smooth normals for vertices that have none
+	static void CalculateNormals(MeshGenerator::MESH_DATA& meshData, size_t firstVertex, size_t firstIndex);
+
+	// identify the version of a model file by its size and time
+	static uint64_t GetSourceKey(const std::string& filePath);
+	// get the path of the binary mesh file for a model file
+	static std::string GetBlobPath(const std::string& filePath);
+	// load a binary mesh file that matches the source key
+	bool LoadMeshBlob(const std::string& blobPath, uint64_t sourceKey, MeshGenerator::MESH_BUFFERS& buffers);
+	// save mesh data as a binary mesh file
+	bool SaveMeshBlob(const std::string& blobPath, uint64_t sourceKey, const MeshGenerator::MESH_DATA& meshData);
+};
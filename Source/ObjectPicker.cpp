@@ -0,0 +1,401 @@
+///////////////////////////////////////////////////////////////////////////////
+// objectpicker.cpp
+// ============
+// find the scene object under the cursor, either from object IDs
+// drawn on the GPU and read back without stalling, or by casting
+// a ray through a bounding volume hierarchy on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ObjectPicker.h"
+#include "GPUResources.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// most objects kept in a leaf of the hierarchy
+	const int BVH_LEAF_SIZE = 2;
+	// depth of the node stack when casting a ray, which is far
+	// more than a hierarchy split at the median can reach
+	const int BVH_STACK_SIZE = 64;
+
+	/***********************************************************
+	 *  IntersectRayBox()
+	 *
+	 *  This function is used for finding the distance along a
+	 *  ray at which it enters a bounding box, using the inverse
+	 *  of the ray direction.  Returns false if the ray misses
+	 *  the box or only meets it behind the origin.
+	 ***********************************************************/
+	bool IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		float& entryDistance)
+	{
+		glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+		glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+		if (entry > exit)
+		{
+			return false;
+		}
+
+		entryDistance = entry;
+		return true;
+	}
+}
+
+/***********************************************************
+ *  ObjectPicker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ObjectPicker::ObjectPicker()
+{
+	m_framebufferID = 0;
+	m_idRenderbufferID = 0;
+	m_depthRenderbufferID = 0;
+	m_pixelBufferID = 0;
+	m_readbackFence = NULL;
+	m_previousFramebufferID = 0;
+}
+
+/***********************************************************
+ *  ~ObjectPicker()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ObjectPicker::~ObjectPicker()
+{
+	if (NULL != m_readbackFence)
+	{
+		glDeleteSync(m_readbackFence);
+		m_readbackFence = NULL;
+	}
+	DeleteTrackedBuffer(m_pixelBufferID);
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_idRenderbufferID)
+	{
+		glDeleteRenderbuffers(1, &m_idRenderbufferID);
+		m_idRenderbufferID = 0;
+	}
+	if (0 != m_depthRenderbufferID)
+	{
+		glDeleteRenderbuffers(1, &m_depthRenderbufferID);
+		m_depthRenderbufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the one pixel target
+ *  that the object IDs are drawn into, and the pixel buffer
+ *  that the drawn ID is copied into.
+ ***********************************************************/
+bool ObjectPicker::Initialize()
+{
+	glGenRenderbuffers(1, &m_idRenderbufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_idRenderbufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, 1, 1);
+	glGenRenderbuffers(1, &m_depthRenderbufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1, 1);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_idRenderbufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbufferID);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Object ID framebuffer is incomplete (" << status << "), GPU picking is disabled" << std::endl;
+		return false;
+	}
+
+	m_pixelBufferID = GenTrackedBuffer("pick readback");
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBufferID);
+	glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_pixelBufferID, sizeof(GLuint));
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginGPUPick()
+ *
+ *  This method is used for binding the one pixel target and
+ *  clearing it, so that the object IDs can be drawn with
+ *  depth testing and no blending.
+ ***********************************************************/
+void ObjectPicker::BeginGPUPick()
+{
+	const GLuint clearID[4] = { 0, 0, 0, 0 };
+	const GLfloat clearDepth = 1.0f;
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, 1, 1);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+
+	glClearBufferuiv(GL_COLOR, 0, clearID);
+	glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+}
+
+/***********************************************************
+ *  EndGPUPick()
+ *
+ *  This method is used for copying the drawn object ID into
+ *  the pixel buffer.  The copy is queued with the rest of
+ *  the frame, and a fence after it tells when it is done.
+ *  A pick that has not been read yet is replaced, since
+ *  only the newest one is wanted.
+ ***********************************************************/
+void ObjectPicker::EndGPUPick()
+{
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBufferID);
+	glReadPixels(0, 0, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (NULL != m_readbackFence)
+	{
+		glDeleteSync(m_readbackFence);
+	}
+	m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_previousFramebufferID);
+	glEnable(GL_BLEND);
+}
+
+/***********************************************************
+ *  ReadGPUPick()
+ *
+ *  This method is used for reading the copied object ID if
+ *  the GPU has finished the copy.  The fence is checked
+ *  without waiting, so nothing is read until it has
+ *  signaled, which is usually by the next frame.
+ ***********************************************************/
+bool ObjectPicker::ReadGPUPick(int& objectIndex)
+{
+	if (NULL == m_readbackFence)
+	{
+		return false;
+	}
+
+	GLenum status = glClientWaitSync(m_readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+	glDeleteSync(m_readbackFence);
+	m_readbackFence = NULL;
+	if (status == GL_WAIT_FAILED)
+	{
+		std::cout << "ERROR: Object ID readback failed" << std::endl;
+		return false;
+	}
+
+	GLuint objectID = 0;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBufferID);
+	const GLuint* pObjectID = (const GLuint*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLuint), GL_MAP_READ_BIT);
+	if (NULL != pObjectID)
+	{
+		objectID = *pObjectID;
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	objectIndex = (int)objectID - 1;
+	return true;
+}
+
+/***********************************************************
+ *  BuildHierarchy()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy over the bounding boxes of the objects.  It is
+ *  only rebuilt when the objects change, not for each ray.
+ ***********************************************************/
+void ObjectPicker::BuildHierarchy(const std::vector<PICK_BOUNDS>& bounds)
+{
+	m_bounds = bounds;
+	m_nodes.clear();
+	m_items.resize(bounds.size());
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		m_items[i] = (int)i;
+	}
+
+	if (bounds.empty())
+	{
+		return;
+	}
+
+	// a binary tree over n leaves never needs more than 2n nodes
+	m_nodes.reserve(bounds.size() * 2);
+	m_nodes.push_back(BVH_NODE());
+	BuildNode(0, 0, (int)bounds.size());
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for filling in the bounds of a node,
+ *  and splitting its items at the median of their centers
+ *  along the longest axis when there are too many for a
+ *  leaf.  The two children are added next to each other.
+ ***********************************************************/
+void ObjectPicker::BuildNode(int nodeIndex, int firstItem, int itemCount)
+{
+	glm::vec3 boundsMin(FLT_MAX);
+	glm::vec3 boundsMax(-FLT_MAX);
+	glm::vec3 centerMin(FLT_MAX);
+	glm::vec3 centerMax(-FLT_MAX);
+	for (int i = firstItem; i < firstItem + itemCount; i++)
+	{
+		const PICK_BOUNDS& bounds = m_bounds[m_items[i]];
+		glm::vec3 center = (bounds.boundsMin + bounds.boundsMax) * 0.5f;
+		boundsMin = glm::min(boundsMin, bounds.boundsMin);
+		boundsMax = glm::max(boundsMax, bounds.boundsMax);
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+
+	m_nodes[nodeIndex].boundsMin = boundsMin;
+	m_nodes[nodeIndex].boundsMax = boundsMax;
+	m_nodes[nodeIndex].firstChild = -1;
+	m_nodes[nodeIndex].firstItem = firstItem;
+	m_nodes[nodeIndex].itemCount = itemCount;
+	if (itemCount <= BVH_LEAF_SIZE)
+	{
+		return;
+	}
+
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	int leftCount = itemCount / 2;
+	std::nth_element(
+		m_items.begin() + firstItem,
+		m_items.begin() + firstItem + leftCount,
+		m_items.begin() + firstItem + itemCount,
+		[this, axis](int a, int b)
+		{
+			return (m_bounds[a].boundsMin[axis] + m_bounds[a].boundsMax[axis]) <
+				(m_bounds[b].boundsMin[axis] + m_bounds[b].boundsMax[axis]);
+		});
+
+	int firstChild = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+	m_nodes.push_back(BVH_NODE());
+	m_nodes[nodeIndex].firstChild = firstChild;
+	m_nodes[nodeIndex].itemCount = 0;
+
+	BuildNode(firstChild, firstItem, leftCount);
+	BuildNode(firstChild + 1, firstItem + leftCount, itemCount - leftCount);
+}
+
+/***********************************************************
+ *  CastRay()
+ *
+ *  This method is used for finding the object whose bounding
+ *  box a ray enters first.  Nodes are visited nearest first,
+ *  and nodes that start beyond the closest hit found so far
+ *  are skipped.  The distance is along the ray direction.
+ ***********************************************************/
+int ObjectPicker::CastRay(glm::vec3 origin, glm::vec3 direction, float* pDistance) const
+{
+	if (m_nodes.empty())
+	{
+		return -1;
+	}
+
+	// a zero component gives an infinite inverse, which the slab
+	// test handles as a ray parallel to those faces
+	glm::vec3 inverseDirection = 1.0f / direction;
+	int nearestItem = -1;
+	float nearestDistance = FLT_MAX;
+
+	int stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	float entryDistance = 0.0f;
+	if (IntersectRayBox(origin, inverseDirection, m_nodes[0].boundsMin, m_nodes[0].boundsMax, entryDistance))
+	{
+		stack[stackSize++] = 0;
+	}
+
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+
+		if (node.firstChild < 0)
+		{
+			for (int i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			{
+				const PICK_BOUNDS& bounds = m_bounds[m_items[i]];
+				if (IntersectRayBox(origin, inverseDirection, bounds.boundsMin, bounds.boundsMax, entryDistance) &&
+					(entryDistance < nearestDistance))
+				{
+					nearestDistance = entryDistance;
+					nearestItem = m_items[i];
+				}
+			}
+			continue;
+		}
+
+		// push the farther child first, so the nearer one is
+		// visited first and can rule the other one out
+		float childDistance[2];
+		bool bChildHit[2];
+		for (int i = 0; i < 2; i++)
+		{
+			const BVH_NODE& child = m_nodes[node.firstChild + i];
+			bChildHit[i] = IntersectRayBox(origin, inverseDirection, child.boundsMin, child.boundsMax, childDistance[i]) &&
+				(childDistance[i] < nearestDistance);
+		}
+		int nearChild = (bChildHit[0] && bChildHit[1] && (childDistance[1] < childDistance[0])) ? 1 : 0;
+		int order[2] = { 1 - nearChild, nearChild };
+		for (int i = 0; i < 2; i++)
+		{
+			if (bChildHit[order[i]] && (stackSize < BVH_STACK_SIZE))
+			{
+				stack[stackSize++] = node.firstChild + order[i];
+			}
+		}
+	}
+
+	if (NULL != pDistance)
+	{
+		*pDistance = nearestDistance;
+	}
+	return nearestItem;
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// objectpicker.h
+// ============
+// find the scene object under the cursor, either from object IDs
+// drawn on the GPU and read back without stalling, or by casting
+// a ray through a bounding volume hierarchy on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ObjectPicker
+ *
+ *  This class answers which object is under a point of the
+ *  window in one of two ways.  The GPU way draws the object
+ *  IDs into a one pixel integer target, through a pick
+ *  projection that covers just the pixel under the cursor,
+ *  and copies the pixel into a pixel buffer with a fence.
+ *  The buffer is only read once the fence has signaled, so
+ *  the answer arrives a frame later without the GPU being
+ *  waited on.  The CPU way casts a ray through a bounding
+ *  volume hierarchy of the object bounds and answers at
+ *  once, at the precision of the bounding boxes.
+ ***********************************************************/
+class ObjectPicker
+{
+public:
+	// the bounding box of an object in the hierarchy
+	struct PICK_BOUNDS
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// constructor
+	ObjectPicker();
+	// destructor
+	~ObjectPicker();
+
+	// create the target and pixel buffer of the GPU picking
+	bool Initialize();
+
+	// bind the one pixel target and clear it for drawing the
+	// object IDs, where an ID of 0 means no object
+	void BeginGPUPick();
+	// copy the drawn ID into the pixel buffer, and restore the
+	// framebuffer that was bound before
+	void EndGPUPick();
+	// check whether a copied ID has not been read yet
+	bool IsReadbackPending() const { return (NULL != m_readbackFence); }
+	// read the copied ID once the GPU has finished it - returns
+	// true with the object index, or -1 for no object
+	bool ReadGPUPick(int& objectIndex);
+
+	// build the hierarchy over the bounding boxes of the objects
+	void BuildHierarchy(const std::vector<PICK_BOUNDS>& bounds);
+	// find the nearest object whose bounding box the ray enters -
+	// returns the object index, or -1 if the ray misses them all
+	int CastRay(glm::vec3 origin, glm::vec3 direction, float* pDistance = NULL) const;
+
+private:
+	// a node of the hierarchy, which is a leaf when it holds
+	// objects, and otherwise has two children next to each other
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int firstChild;
+		int firstItem;
+		int itemCount;
+	};
+
+	// framebuffer with the object ID and depth of one pixel
+	GLuint m_framebufferID;
+	GLuint m_idRenderbufferID;
+	GLuint m_depthRenderbufferID;
+	// pixel buffer that the ID is copied into, and the fence
+	// that signals when the copy has finished
+	GLuint m_pixelBufferID;
+	GLsync m_readbackFence;
+	// framebuffer that was bound when the pick began
+	GLint m_previousFramebufferID;
+
+	// the nodes of the hierarchy, with the root first
+	std::vector<BVH_NODE> m_nodes;
+	// object indices of the leaves, ordered by node
+	std::vector<int> m_items;
+	// bounds of the objects the hierarchy was built over
+	std::vector<PICK_BOUNDS> m_bounds;
+
+	// fill in a node for a range of items, splitting it into
+	// two children when it holds too many
+	void BuildNode(int nodeIndex, int firstItem, int itemCount);
+};
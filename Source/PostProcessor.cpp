@@ -0,0 +1,909 @@
+///////////////////////////////////////////////////////////////////////////////
+// postprocessor.cpp
+// ============
+// build the frame graph for the scene and the enabled screen
+// effects, and draw the effects as full screen passes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PostProcessor.h"
+#include "ShaderCache.h"
+#include "GPUResources.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// brightness above which the scene colors spill into the bloom
+	const float BLOOM_THRESHOLD = 1.0f;
+	// amount of the blurred bright colors added to the scene
+	const float BLOOM_STRENGTH = 0.6f;
+	// size of the bloom targets relative to the scene
+	const float BLOOM_SCALE = 0.5f;
+
+	// share of the history kept in each TAA frame
+	const float TAA_HISTORY_WEIGHT = 0.9f;
+	// frames TAA keeps drawing after the view stops changing,
+	// which is enough for the history to converge
+	const int TAA_SETTLE_FRAMES = 16;
+	// number of different jitter offsets before they repeat
+	const int TAA_JITTER_COUNT = 8;
+
+	// frames measured between adjustments of the dynamic scale,
+	// the step it moves by, and its lowest value
+	const int DYNAMIC_SCALE_INTERVAL = 30;
+	const float DYNAMIC_SCALE_STEP = 0.1f;
+	const float MIN_DYNAMIC_SCALE = 0.5f;
+	// GPU time as a share of the target frame time above which
+	// the scale is lowered, and below which it is raised
+	const double DYNAMIC_SCALE_HIGH = 0.95;
+	const double DYNAMIC_SCALE_LOW = 0.75;
+	// weight of each new measurement in the smoothed GPU time
+	const double GPU_TIME_SMOOTHING = 0.1;
+
+	/***********************************************************
+	 *  Halton()
+	 *
+	 *  This function is used for getting an element of the
+	 *  Halton sequence in a base, which spreads the TAA
+	 *  jitter offsets evenly over the pixel.
+	 ***********************************************************/
+	float Halton(int index, int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f;
+
+		while (index > 0)
+		{
+			fraction /= (float)base;
+			result += fraction * (float)(index % base);
+			index /= base;
+		}
+
+		return result;
+	}
+
+	// vertex shader for the effect passes - a single triangle
+	// covers the whole target without any vertex buffer
+	const char* g_FullscreenVertexShader =
+		"#version 330 core\n"
+		"out vec2 fragmentUV;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"	fragmentUV = position;\n"
+		"	gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that keeps the part of each color that
+	// is brighter than the bloom threshold
+	const char* g_BrightFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D sourceTexture;\n"
+		"uniform float threshold;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 color = texture(sourceTexture, fragmentUV).rgb;\n"
+		"	float brightness = max(color.r, max(color.g, color.b));\n"
+		"	float weight = max(brightness - threshold, 0.0f) / max(brightness, 0.0001f);\n"
+		"	fragmentColor = vec4(color * weight, 1.0f);\n"
+		"}\n";
+
+	// fragment shader for one direction of a 9 tap gaussian blur
+	const char* g_BlurFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D sourceTexture;\n"
+		"uniform vec2 texelStep;\n"
+		"const float weights[5] = float[](0.227027f, 0.1945946f, 0.1216216f, 0.054054f, 0.016216f);\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 color = texture(sourceTexture, fragmentUV).rgb * weights[0];\n"
+		"	for (int i = 1; i < 5; i++)\n"
+		"	{\n"
+		"		color += texture(sourceTexture, fragmentUV + texelStep * i).rgb * weights[i];\n"
+		"		color += texture(sourceTexture, fragmentUV - texelStep * i).rgb * weights[i];\n"
+		"	}\n"
+		"	fragmentColor = vec4(color, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that adds the bloom to the scene and maps
+	// the bright colors back into the displayable range
+	const char* g_CompositeFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D sceneTexture;\n"
+		"uniform sampler2D bloomTexture;\n"
+		"uniform bool bBloom;\n"
+		"uniform bool bToneMapping;\n"
+		"uniform float bloomStrength;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 color = texture(sceneTexture, fragmentUV).rgb;\n"
+		"	if (bBloom)\n"
+		"	{\n"
+		"		color += texture(bloomTexture, fragmentUV).rgb * bloomStrength;\n"
+		"	}\n"
+		"	if (bToneMapping)\n"
+		"	{\n"
+		"		color = clamp((color * (2.51f * color + 0.03f)) / (color * (2.43f * color + 0.59f) + 0.14f), 0.0f, 1.0f);\n"
+		"	}\n"
+		"	fragmentColor = vec4(color, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that smooths the stair steps along edges,
+	// using the contrast of the neighboring pixels (FXAA)
+	const char* g_FXAAFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D sourceTexture;\n"
+		"uniform vec2 texelSize;\n"
+		"const float REDUCE_MIN = 1.0f / 128.0f;\n"
+		"const float REDUCE_MUL = 1.0f / 8.0f;\n"
+		"const float SPAN_MAX = 8.0f;\n"
+		"float Luma(vec3 color)\n"
+		"{\n"
+		"	return dot(color, vec3(0.299f, 0.587f, 0.114f));\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	float lumaNW = Luma(texture(sourceTexture, fragmentUV + vec2(-1.0f, -1.0f) * texelSize).rgb);\n"
+		"	float lumaNE = Luma(texture(sourceTexture, fragmentUV + vec2(1.0f, -1.0f) * texelSize).rgb);\n"
+		"	float lumaSW = Luma(texture(sourceTexture, fragmentUV + vec2(-1.0f, 1.0f) * texelSize).rgb);\n"
+		"	float lumaSE = Luma(texture(sourceTexture, fragmentUV + vec2(1.0f, 1.0f) * texelSize).rgb);\n"
+		"	vec3 colorM = texture(sourceTexture, fragmentUV).rgb;\n"
+		"	float lumaM = Luma(colorM);\n"
+		"	float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));\n"
+		"	float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));\n"
+		"	vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));\n"
+		"	float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25f * REDUCE_MUL, REDUCE_MIN);\n"
+		"	float inverseDirectionMin = 1.0f / (min(abs(direction.x), abs(direction.y)) + directionReduce);\n"
+		"	direction = clamp(direction * inverseDirectionMin, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * texelSize;\n"
+		"	vec3 colorA = 0.5f * (texture(sourceTexture, fragmentUV + direction * (1.0f / 3.0f - 0.5f)).rgb +\n"
+		"		texture(sourceTexture, fragmentUV + direction * (2.0f / 3.0f - 0.5f)).rgb);\n"
+		"	vec3 colorB = colorA * 0.5f + 0.25f * (texture(sourceTexture, fragmentUV - direction * 0.5f).rgb +\n"
+		"		texture(sourceTexture, fragmentUV + direction * 0.5f).rgb);\n"
+		"	float lumaB = Luma(colorB);\n"
+		"	fragmentColor = vec4(((lumaB < lumaMin) || (lumaB > lumaMax)) ? colorA : colorB, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that blends the jittered scene with the
+	// history of the previous frames (TAA).  The history is
+	// reprojected with the depth inside the camera view, and
+	// clamped to the colors around the pixel so that moving
+	// objects do not leave trails
+	const char* g_TAAFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D currentTexture;\n"
+		"uniform sampler2D historyTexture;\n"
+		"uniform sampler2D depthTexture;\n"
+		"uniform vec2 texelSize;\n"
+		"uniform mat4 currentToPrevious;\n"
+		"uniform vec4 viewRect;\n"
+		"uniform float historyWeight;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 current = texture(currentTexture, fragmentUV).rgb;\n"
+		"	vec3 minColor = current;\n"
+		"	vec3 maxColor = current;\n"
+		"	for (int y = -1; y <= 1; y++)\n"
+		"	{\n"
+		"		for (int x = -1; x <= 1; x++)\n"
+		"		{\n"
+		"			vec3 color = texture(currentTexture, fragmentUV + vec2(x, y) * texelSize).rgb;\n"
+		"			minColor = min(minColor, color);\n"
+		"			maxColor = max(maxColor, color);\n"
+		"		}\n"
+		"	}\n"
+		"	vec2 previousUV = fragmentUV;\n"
+		"	vec2 viewUV = (fragmentUV - viewRect.xy) / viewRect.zw;\n"
+		"	if (all(greaterThanEqual(viewUV, vec2(0.0f))) && all(lessThanEqual(viewUV, vec2(1.0f))))\n"
+		"	{\n"
+		"		float depth = texture(depthTexture, fragmentUV).r;\n"
+		"		vec4 previous = currentToPrevious * vec4(vec3(viewUV, depth) * 2.0f - 1.0f, 1.0f);\n"
+		"		previousUV = viewRect.xy + (previous.xy / previous.w * 0.5f + 0.5f) * viewRect.zw;\n"
+		"	}\n"
+		"	float weight = historyWeight;\n"
+		"	if (any(lessThan(previousUV, vec2(0.0f))) || any(greaterThan(previousUV, vec2(1.0f))))\n"
+		"	{\n"
+		"		weight = 0.0f;\n"
+		"	}\n"
+		"	vec3 history = clamp(texture(historyTexture, previousUV).rgb, minColor, maxColor);\n"
+		"	fragmentColor = vec4(mix(current, history, weight), 1.0f);\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  PostProcessor()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PostProcessor::PostProcessor()
+{
+	m_pRenderSettings = NULL;
+	m_clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	m_width = 0;
+	m_height = 0;
+	m_builtEffects = -1;
+	m_builtAntiAliasing = AA_OFF;
+	m_builtScale = 1.0f;
+	m_builtWidth = 0;
+	m_builtHeight = 0;
+	m_sceneColor = -1;
+	m_maxSamples = 1;
+	m_jitter = glm::vec2(0.0f);
+	m_jitterIndex = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_unjitteredViewProjection = glm::mat4(1.0f);
+	m_viewRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	m_bHistoryValid = false;
+	m_stillFrames = 0;
+	for (int i = 0; i < TIMER_QUERY_COUNT; i++)
+	{
+		m_timerQueries[i] = 0;
+		m_bTimerPending[i] = false;
+	}
+	m_timerIndex = 0;
+	m_gpuFrameTime = 0.0;
+	m_timedFrames = 0;
+	m_dynamicScale = 1.0f;
+	m_fullscreenVAO = 0;
+	m_brightProgramID = 0;
+	m_blurProgramID = 0;
+	m_compositeProgramID = 0;
+	m_fxaaProgramID = 0;
+	m_taaProgramID = 0;
+	m_blurTexelStepLocation = -1;
+	m_compositeBloomLocation = -1;
+	m_compositeToneMappingLocation = -1;
+	m_fxaaTexelSizeLocation = -1;
+	m_taaTexelSizeLocation = -1;
+	m_taaCurrentToPreviousLocation = -1;
+	m_taaViewRectLocation = -1;
+	m_taaHistoryWeightLocation = -1;
+}
+
+/***********************************************************
+ *  ~PostProcessor()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PostProcessor::~PostProcessor()
+{
+	m_pRenderSettings = NULL;
+	DeletePrograms();
+	DeleteTrackedVertexArray(m_fullscreenVAO);
+	if (0 != m_timerQueries[0])
+	{
+		glDeleteQueries(TIMER_QUERY_COUNT, m_timerQueries);
+		m_timerQueries[0] = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the programs of the
+ *  effect passes.  The samplers of each program are set to
+ *  the texture units that the frame graph binds the pass
+ *  inputs to, in the order the inputs are declared.
+ ***********************************************************/
+bool PostProcessor::Initialize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_builtEffects = -1;
+
+	// core profiles need a vertex array bound to draw anything
+	m_fullscreenVAO = GenTrackedVertexArray("fullscreen triangle");
+	glGenQueries(TIMER_QUERY_COUNT, m_timerQueries);
+
+	// the scene color and depth are both multisampled with MSAA
+	GLint maxColorSamples = 1;
+	GLint maxDepthSamples = 1;
+	glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxColorSamples);
+	glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &maxDepthSamples);
+	m_maxSamples = std::max(1, std::min(maxColorSamples, maxDepthSamples));
+
+	m_brightProgramID = ShaderCache::CompileProgram(g_FullscreenVertexShader, g_BrightFragmentShader);
+	m_blurProgramID = ShaderCache::CompileProgram(g_FullscreenVertexShader, g_BlurFragmentShader);
+	m_compositeProgramID = ShaderCache::CompileProgram(g_FullscreenVertexShader, g_CompositeFragmentShader);
+	m_fxaaProgramID = ShaderCache::CompileProgram(g_FullscreenVertexShader, g_FXAAFragmentShader);
+	m_taaProgramID = ShaderCache::CompileProgram(g_FullscreenVertexShader, g_TAAFragmentShader);
+	if ((0 == m_brightProgramID) || (0 == m_blurProgramID) ||
+		(0 == m_compositeProgramID) || (0 == m_fxaaProgramID) || (0 == m_taaProgramID))
+	{
+		std::cout << "ERROR: Screen effect programs failed to build, effects are disabled" << std::endl;
+		DeletePrograms();
+		return false;
+	}
+
+	glUseProgram(m_brightProgramID);
+	glUniform1i(glGetUniformLocation(m_brightProgramID, "sourceTexture"), FrameGraph::INPUT_TEXTURE_UNIT);
+	glUniform1f(glGetUniformLocation(m_brightProgramID, "threshold"), BLOOM_THRESHOLD);
+
+	glUseProgram(m_blurProgramID);
+	glUniform1i(glGetUniformLocation(m_blurProgramID, "sourceTexture"), FrameGraph::INPUT_TEXTURE_UNIT);
+	m_blurTexelStepLocation = glGetUniformLocation(m_blurProgramID, "texelStep");
+
+	glUseProgram(m_compositeProgramID);
+	glUniform1i(glGetUniformLocation(m_compositeProgramID, "sceneTexture"), FrameGraph::INPUT_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_compositeProgramID, "bloomTexture"), FrameGraph::INPUT_TEXTURE_UNIT + 1);
+	glUniform1f(glGetUniformLocation(m_compositeProgramID, "bloomStrength"), BLOOM_STRENGTH);
+	m_compositeBloomLocation = glGetUniformLocation(m_compositeProgramID, "bBloom");
+	m_compositeToneMappingLocation = glGetUniformLocation(m_compositeProgramID, "bToneMapping");
+
+	glUseProgram(m_fxaaProgramID);
+	glUniform1i(glGetUniformLocation(m_fxaaProgramID, "sourceTexture"), FrameGraph::INPUT_TEXTURE_UNIT);
+	m_fxaaTexelSizeLocation = glGetUniformLocation(m_fxaaProgramID, "texelSize");
+
+	glUseProgram(m_taaProgramID);
+	glUniform1i(glGetUniformLocation(m_taaProgramID, "currentTexture"), FrameGraph::INPUT_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_taaProgramID, "historyTexture"), FrameGraph::INPUT_TEXTURE_UNIT + 1);
+	glUniform1i(glGetUniformLocation(m_taaProgramID, "depthTexture"), FrameGraph::INPUT_TEXTURE_UNIT + 2);
+	m_taaTexelSizeLocation = glGetUniformLocation(m_taaProgramID, "texelSize");
+	m_taaCurrentToPreviousLocation = glGetUniformLocation(m_taaProgramID, "currentToPrevious");
+	m_taaViewRectLocation = glGetUniformLocation(m_taaProgramID, "viewRect");
+	m_taaHistoryWeightLocation = glGetUniformLocation(m_taaProgramID, "historyWeight");
+
+	glUseProgram(0);
+
+	return true;
+}
+
+/***********************************************************
+ *  SetRenderSettings()
+ *
+ *  This method is used for setting the options that turn
+ *  the screen effects on and off.
+ ***********************************************************/
+void PostProcessor::SetRenderSettings(RENDER_SETTINGS* pRenderSettings)
+{
+	m_pRenderSettings = pRenderSettings;
+}
+
+/***********************************************************
+ *  SetScenePass()
+ *
+ *  This method is used for setting the function that draws
+ *  the scene into the first pass of the frame, and the
+ *  color that the scene target is cleared to.
+ ***********************************************************/
+void PostProcessor::SetScenePass(std::function<void()> renderScene, glm::vec4 clearColor)
+{
+	m_renderScene = std::move(renderScene);
+	m_clearColor = clearColor;
+	m_builtEffects = -1;
+}
+
+/***********************************************************
+ *  SetOutputSize()
+ *
+ *  This method is used for setting the size of the window
+ *  framebuffer that the frame is drawn into.  The graph is
+ *  rebuilt for the new size before the next frame.
+ ***********************************************************/
+void PostProcessor::SetOutputSize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+/***********************************************************
+ *  SetMainView()
+ *
+ *  This method is used for keeping the camera view of the
+ *  frame, which TAA uses for finding where each pixel was
+ *  in the history.  The jitter is taken back out of the
+ *  projection, so that the history is reprojected with the
+ *  view as it would be without it.
+ ***********************************************************/
+void PostProcessor::SetMainView(const SCENE_VIEW& sceneView)
+{
+	glm::mat4 unjitter(1.0f);
+	unjitter[3][0] = -m_jitter.x * 2.0f / (float)std::max(sceneView.width, 1);
+	unjitter[3][1] = -m_jitter.y * 2.0f / (float)std::max(sceneView.height, 1);
+
+	glm::mat4 viewProjection = sceneView.projection * sceneView.view;
+	glm::mat4 unjitteredViewProjection = unjitter * viewProjection;
+
+	// the history keeps converging while the view holds still
+	if (unjitteredViewProjection == m_unjitteredViewProjection)
+	{
+		m_stillFrames++;
+	}
+	else
+	{
+		m_stillFrames = 0;
+	}
+
+	m_previousViewProjection = m_unjitteredViewProjection;
+	m_unjitteredViewProjection = unjitteredViewProjection;
+	m_viewProjection = viewProjection;
+
+	float sceneWidth = (float)std::max(GetSceneWidth(), 1);
+	float sceneHeight = (float)std::max(GetSceneHeight(), 1);
+	m_viewRect = glm::vec4(
+		sceneView.x / sceneWidth,
+		sceneView.y / sceneHeight,
+		sceneView.width / sceneWidth,
+		sceneView.height / sceneHeight);
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used for drawing the scene and the enabled
+ *  effects.  The graph is rebuilt the first time a new set
+ *  of effects, anti-aliasing mode, scale or output size is
+ *  used, and otherwise only run.
+ ***********************************************************/
+void PostProcessor::RenderFrame()
+{
+	// a minimized window has nothing to draw into
+	if ((m_width <= 0) || (m_height <= 0))
+	{
+		return;
+	}
+
+	int effects = GetEnabledEffects();
+	int antiAliasingMode = GetAntiAliasingMode();
+	float scale = GetSceneScale();
+	if ((effects != m_builtEffects) || (antiAliasingMode != m_builtAntiAliasing) || (scale != m_builtScale) ||
+		(m_width != m_builtWidth) || (m_height != m_builtHeight))
+	{
+		BuildFrameGraph(effects, antiAliasingMode, scale);
+	}
+
+	// each TAA frame samples the scene at a different point in
+	// the pixels, which the history averages together
+	if (AA_TAA == m_builtAntiAliasing)
+	{
+		m_jitterIndex = (m_jitterIndex % TAA_JITTER_COUNT) + 1;
+		m_jitter = glm::vec2(Halton(m_jitterIndex, 2) - 0.5f, Halton(m_jitterIndex, 3) - 0.5f);
+	}
+	else
+	{
+		m_jitter = glm::vec2(0.0f);
+	}
+
+	bool bTimed = (NULL != m_pRenderSettings) && (m_pRenderSettings->targetFrameTime > 0.0) && (0 != m_timerQueries[0]);
+	if (bTimed)
+	{
+		UpdateDynamicResolution();
+		glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[m_timerIndex]);
+	}
+
+	m_frameGraph.Execute();
+
+	if (bTimed)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_bTimerPending[m_timerIndex] = true;
+		m_timerIndex = (m_timerIndex + 1) % TIMER_QUERY_COUNT;
+	}
+
+	m_bHistoryValid = true;
+}
+
+/***********************************************************
+ *  GetSceneWidth()
+ *
+ *  This method is used for getting the width in pixels of
+ *  the target that the scene is drawn into.
+ ***********************************************************/
+int PostProcessor::GetSceneWidth() const
+{
+	return (m_sceneColor >= 0) ? m_frameGraph.GetTextureWidth(m_sceneColor) : m_width;
+}
+
+/***********************************************************
+ *  GetSceneHeight()
+ *
+ *  This method is used for getting the height in pixels of
+ *  the target that the scene is drawn into.
+ ***********************************************************/
+int PostProcessor::GetSceneHeight() const
+{
+	return (m_sceneColor >= 0) ? m_frameGraph.GetTextureHeight(m_sceneColor) : m_height;
+}
+
+/***********************************************************
+ *  GetJitter()
+ *
+ *  This method is used for getting the offset in pixels that
+ *  the projections of this frame are moved by, which is
+ *  zero unless TAA is used.
+ ***********************************************************/
+glm::vec2 PostProcessor::GetJitter() const
+{
+	return m_jitter;
+}
+
+/***********************************************************
+ *  IsAccumulating()
+ *
+ *  This method is used for checking whether TAA needs more
+ *  frames of an unchanged view for the history to settle.
+ ***********************************************************/
+bool PostProcessor::IsAccumulating() const
+{
+	return (AA_TAA == m_builtAntiAliasing) && (m_stillFrames < TAA_SETTLE_FRAMES);
+}
+
+/***********************************************************
+ *  GetEnabledEffects()
+ *
+ *  This method is used for getting the effect flags that
+ *  are turned on in the render settings.
+ ***********************************************************/
+int PostProcessor::GetEnabledEffects() const
+{
+	int effects = 0;
+
+	if ((NULL == m_pRenderSettings) || (0 == m_compositeProgramID))
+	{
+		return effects;
+	}
+
+	if (m_pRenderSettings->bToneMapping)
+	{
+		effects |= EFFECT_TONE_MAPPING;
+	}
+	if (m_pRenderSettings->bBloom)
+	{
+		effects |= EFFECT_BLOOM;
+	}
+	if (m_pRenderSettings->bFXAA)
+	{
+		effects |= EFFECT_FXAA;
+	}
+
+	return effects;
+}
+
+/***********************************************************
+ *  GetAntiAliasingMode()
+ *
+ *  This method is used for getting the anti-aliasing mode
+ *  in the render settings, or no anti-aliasing when the
+ *  mode is not supported.
+ ***********************************************************/
+int PostProcessor::GetAntiAliasingMode() const
+{
+	if (NULL == m_pRenderSettings)
+	{
+		return AA_OFF;
+	}
+
+	int antiAliasingMode = m_pRenderSettings->antiAliasingMode;
+	if ((AA_TAA == antiAliasingMode) && (0 == m_taaProgramID))
+	{
+		return AA_OFF;
+	}
+	if ((antiAliasingMode >= AA_MSAA_2X) && (antiAliasingMode <= AA_MSAA_8X) && (m_maxSamples < 2))
+	{
+		return AA_OFF;
+	}
+
+	return antiAliasingMode;
+}
+
+/***********************************************************
+ *  GetSceneScale()
+ *
+ *  This method is used for getting the size of the scene
+ *  relative to the output, which is the render scale in
+ *  the settings lowered by the dynamic resolution.
+ ***********************************************************/
+float PostProcessor::GetSceneScale() const
+{
+	if (NULL == m_pRenderSettings)
+	{
+		return 1.0f;
+	}
+
+	float scale = glm::clamp((float)m_pRenderSettings->renderScale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+	if (m_pRenderSettings->targetFrameTime > 0.0)
+	{
+		scale *= m_dynamicScale;
+	}
+
+	return scale;
+}
+
+/***********************************************************
+ *  BuildFrameGraph()
+ *
+ *  This method is used for declaring the passes for a set
+ *  of effects.  Each effect reads the result of the one
+ *  before it, and the last pass writes the default
+ *  framebuffer.  Bloom and tone mapping need the scene in
+ *  a floating point target, so that colors brighter than
+ *  white are kept until they are mapped.  A scene drawn at
+ *  another scale is copied to the default framebuffer with
+ *  filtering after the effects, which run at its size.
+ ***********************************************************/
+void PostProcessor::BuildFrameGraph(int effects, int antiAliasingMode, float scale)
+{
+	bool bToneMapping = (0 != (effects & EFFECT_TONE_MAPPING));
+	bool bBloom = (0 != (effects & EFFECT_BLOOM));
+	bool bFXAA = (0 != (effects & EFFECT_FXAA));
+	bool bComposite = bToneMapping || bBloom;
+	bool bTAA = (AA_TAA == antiAliasingMode);
+	bool bScaled = (scale != 1.0f);
+	int samples = 1;
+	if ((antiAliasingMode >= AA_MSAA_2X) && (antiAliasingMode <= AA_MSAA_8X))
+	{
+		samples = std::min(2 << (antiAliasingMode - AA_MSAA_2X), m_maxSamples);
+	}
+
+	m_frameGraph.Reset();
+	m_builtEffects = effects;
+	m_builtAntiAliasing = antiAliasingMode;
+	m_builtScale = scale;
+	m_builtWidth = m_width;
+	m_builtHeight = m_height;
+	m_bHistoryValid = false;
+	m_stillFrames = 0;
+
+	GLenum colorFormat = bComposite ? GL_RGBA16F : GL_RGBA8;
+	int backbuffer = m_frameGraph.ImportBackbuffer();
+
+	// the last step writes the default framebuffer directly,
+	// unless it still has to be scaled to the output size
+	auto createOutput = [this, backbuffer, bScaled, scale](bool bLast, const char* name, GLenum internalFormat)
+	{
+		return (bLast && (false == bScaled)) ? backbuffer : m_frameGraph.CreateTexture(name, internalFormat, scale);
+	};
+
+	int sceneColor = backbuffer;
+	int sceneDepth = backbuffer;
+	if ((0 != effects) || (samples > 1) || bTAA || bScaled)
+	{
+		sceneColor = m_frameGraph.CreateTexture("SceneColor", colorFormat, scale, samples);
+		sceneDepth = m_frameGraph.CreateTexture("SceneDepth", GL_DEPTH_COMPONENT24, scale, samples);
+	}
+	m_sceneColor = sceneColor;
+
+	int pass = m_frameGraph.AddPass("Scene", [this]() { m_renderScene(); });
+	m_frameGraph.WriteColor(pass, sceneColor, true, m_clearColor);
+	m_frameGraph.WriteDepth(pass, sceneDepth, true);
+
+	// the samples of each pixel are averaged before any effect
+	// reads the scene
+	int color = sceneColor;
+	if (samples > 1)
+	{
+		color = createOutput(0 == effects, "SceneResolved", colorFormat);
+		m_frameGraph.AddResolvePass("MSAAResolve", sceneColor, color);
+	}
+
+	// the jittered scene is blended into the history, which is
+	// then replaced by the result for the next frame
+	if (bTAA)
+	{
+		int history = m_frameGraph.CreatePersistentTexture("TAAHistory", colorFormat, scale);
+		int accumulated = m_frameGraph.CreateTexture("TAAOutput", colorFormat, scale);
+
+		pass = m_frameGraph.AddPass("TAA", [this, color]()
+		{
+			glm::mat4 currentToPrevious = m_previousViewProjection * glm::inverse(m_viewProjection);
+
+			glUseProgram(m_taaProgramID);
+			glUniform2f(m_taaTexelSizeLocation,
+				1.0f / m_frameGraph.GetTextureWidth(color),
+				1.0f / m_frameGraph.GetTextureHeight(color));
+			glUniformMatrix4fv(m_taaCurrentToPreviousLocation, 1, GL_FALSE, glm::value_ptr(currentToPrevious));
+			glUniform4fv(m_taaViewRectLocation, 1, glm::value_ptr(m_viewRect));
+			glUniform1f(m_taaHistoryWeightLocation, m_bHistoryValid ? TAA_HISTORY_WEIGHT : 0.0f);
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, color);
+		m_frameGraph.ReadTexture(pass, history);
+		m_frameGraph.ReadTexture(pass, sceneDepth);
+		m_frameGraph.WriteColor(pass, accumulated);
+
+		m_frameGraph.AddResolvePass("TAAHistory", accumulated, history);
+		color = accumulated;
+	}
+
+	// the bright parts of the scene are blurred at a lower
+	// resolution, where the first and last targets can share
+	// the same texture
+	int bloom = -1;
+	if (bBloom)
+	{
+		int bright = m_frameGraph.CreateTexture("BloomBright", GL_RGBA16F, BLOOM_SCALE * scale);
+		int blurX = m_frameGraph.CreateTexture("BloomBlurX", GL_RGBA16F, BLOOM_SCALE * scale);
+		int blurY = m_frameGraph.CreateTexture("BloomBlurY", GL_RGBA16F, BLOOM_SCALE * scale);
+
+		pass = m_frameGraph.AddPass("BloomBright", [this]()
+		{
+			glUseProgram(m_brightProgramID);
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, color);
+		m_frameGraph.WriteColor(pass, bright);
+
+		pass = m_frameGraph.AddPass("BloomBlurX", [this, bright]()
+		{
+			glUseProgram(m_blurProgramID);
+			glUniform2f(m_blurTexelStepLocation, 1.0f / m_frameGraph.GetTextureWidth(bright), 0.0f);
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, bright);
+		m_frameGraph.WriteColor(pass, blurX);
+
+		pass = m_frameGraph.AddPass("BloomBlurY", [this, blurX]()
+		{
+			glUseProgram(m_blurProgramID);
+			glUniform2f(m_blurTexelStepLocation, 0.0f, 1.0f / m_frameGraph.GetTextureHeight(blurX));
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, blurX);
+		m_frameGraph.WriteColor(pass, blurY);
+
+		bloom = blurY;
+	}
+
+	if (bComposite)
+	{
+		int composite = createOutput(false == bFXAA, "Composite", GL_RGBA8);
+
+		pass = m_frameGraph.AddPass("Composite", [this, bBloom, bToneMapping]()
+		{
+			glUseProgram(m_compositeProgramID);
+			glUniform1i(m_compositeBloomLocation, bBloom ? 1 : 0);
+			glUniform1i(m_compositeToneMappingLocation, bToneMapping ? 1 : 0);
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, color);
+		if (bloom >= 0)
+		{
+			m_frameGraph.ReadTexture(pass, bloom);
+		}
+		m_frameGraph.WriteColor(pass, composite);
+		color = composite;
+	}
+
+	if (bFXAA)
+	{
+		int antiAliased = createOutput(true, "FXAAOutput", GL_RGBA8);
+
+		pass = m_frameGraph.AddPass("FXAA", [this, color]()
+		{
+			glUseProgram(m_fxaaProgramID);
+			glUniform2f(m_fxaaTexelSizeLocation,
+				1.0f / m_frameGraph.GetTextureWidth(color),
+				1.0f / m_frameGraph.GetTextureHeight(color));
+			DrawFullscreenTriangle();
+		});
+		m_frameGraph.ReadTexture(pass, color);
+		m_frameGraph.WriteColor(pass, antiAliased);
+		color = antiAliased;
+	}
+
+	// a scaled frame, or the TAA result that is also kept as the
+	// history, is copied to the default framebuffer at the end
+	if (color != backbuffer)
+	{
+		m_frameGraph.AddResolvePass("Present", color, backbuffer);
+	}
+
+	if (false == m_frameGraph.Compile(m_width, m_height))
+	{
+		std::cout << "ERROR: Frame graph for effects " << effects << ", anti-aliasing " << antiAliasingMode
+			<< " and scale " << scale << " failed to compile" << std::endl;
+		if ((0 != effects) || (AA_OFF != antiAliasingMode) || bScaled)
+		{
+			BuildFrameGraph(0, AA_OFF, 1.0f);
+			// keep the failed graph from being rebuilt every frame
+			m_builtEffects = effects;
+			m_builtAntiAliasing = antiAliasingMode;
+			m_builtScale = scale;
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateDynamicResolution()
+ *
+ *  This method is used for keeping the GPU time of the
+ *  frames under the target frame time.  The timer query of
+ *  a frame is read when its slot in the ring comes around
+ *  again, by which time it has usually finished, so that
+ *  the CPU never waits for the GPU.  Every few frames, the
+ *  scale is lowered one step when the smoothed time is close
+ *  to the target, or raised one step when it is well under.
+ ***********************************************************/
+void PostProcessor::UpdateDynamicResolution()
+{
+	if (m_bTimerPending[m_timerIndex])
+	{
+		GLint bAvailable = 0;
+		glGetQueryObjectiv(m_timerQueries[m_timerIndex], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable)
+		{
+			GLuint64 elapsedTime = 0;
+			glGetQueryObjectui64v(m_timerQueries[m_timerIndex], GL_QUERY_RESULT, &elapsedTime);
+			double frameTime = (double)elapsedTime * 1.0e-9;
+			m_gpuFrameTime = (m_gpuFrameTime > 0.0) ?
+				m_gpuFrameTime + (frameTime - m_gpuFrameTime) * GPU_TIME_SMOOTHING : frameTime;
+			m_timedFrames++;
+		}
+		// an unfinished query is dropped when its slot is reused
+		m_bTimerPending[m_timerIndex] = false;
+	}
+
+	if (m_timedFrames < DYNAMIC_SCALE_INTERVAL)
+	{
+		return;
+	}
+	m_timedFrames = 0;
+
+	double targetFrameTime = m_pRenderSettings->targetFrameTime;
+	float dynamicScale = m_dynamicScale;
+	if (m_gpuFrameTime > targetFrameTime * DYNAMIC_SCALE_HIGH)
+	{
+		dynamicScale = std::max(dynamicScale - DYNAMIC_SCALE_STEP, MIN_DYNAMIC_SCALE);
+	}
+	else if (m_gpuFrameTime < targetFrameTime * DYNAMIC_SCALE_LOW)
+	{
+		dynamicScale = std::min(dynamicScale + DYNAMIC_SCALE_STEP, 1.0f);
+	}
+	// stay on the steps, so that the scale can return to exactly 1
+	dynamicScale = std::round(dynamicScale / DYNAMIC_SCALE_STEP) * DYNAMIC_SCALE_STEP;
+
+	if (dynamicScale != m_dynamicScale)
+	{
+		std::cout << "INFO: Dynamic resolution " << (int)(dynamicScale * 100.0f + 0.5f) << "% for a GPU frame time of "
+			<< (m_gpuFrameTime * 1000.0) << " ms" << std::endl;
+		m_dynamicScale = dynamicScale;
+		// the frames at the new scale are measured from the start
+		m_gpuFrameTime = 0.0;
+	}
+}
+
+/***********************************************************
+ *  DrawFullscreenTriangle()
+ *
+ *  This method is used for drawing a triangle that covers
+ *  the whole target with the active effect program.  The
+ *  effect passes do not use depth or blending.
+ ***********************************************************/
+void PostProcessor::DrawFullscreenTriangle()
+{
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glBindVertexArray(m_fullscreenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DeletePrograms()
+ *
+ *  This method is used for freeing the effect programs.
+ ***********************************************************/
+void PostProcessor::DeletePrograms()
+{
+	GLuint* programIDs[5] = { &m_brightProgramID, &m_blurProgramID, &m_compositeProgramID, &m_fxaaProgramID, &m_taaProgramID };
+
+	for (int i = 0; i < 5; i++)
+	{
+		DeleteTrackedProgram(*programIDs[i]);
+	}
+}
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// postprocessor.h
+// ============
+// build the frame graph for the scene and the enabled screen
+// effects, and draw the effects as full screen passes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameGraph.h"
+#include "RenderSettings.h"
+#include "SceneView.h"
+
+#include <functional>
+
+/***********************************************************
+ *  PostProcessor
+ *
+ *  This class declares the passes of each frame: the scene
+ *  pass at the render scale, the MSAA resolve or the TAA
+ *  accumulation, bloom, tone mapping and FXAA when they are
+ *  turned on, and a copy that scales the result to the
+ *  window.  The frame graph is only rebuilt when the
+ *  effects, the anti-aliasing mode, the scale or the output
+ *  size changes.  With all of them at their defaults, the
+ *  scene pass draws straight into the default framebuffer,
+ *  so no extra targets are used.
+ *
+ *  When a target frame time is set, the GPU time of the
+ *  frames is measured with timer queries, and the scale is
+ *  lowered or raised in steps to keep the frames under it.
+ ***********************************************************/
+class PostProcessor
+{
+public:
+	// constructor
+	PostProcessor();
+	// destructor
+	~PostProcessor();
+
+	// compile the effect programs for an output size
+	bool Initialize(int width, int height);
+	// set the options that turn the effects on and off
+	void SetRenderSettings(RENDER_SETTINGS* pRenderSettings);
+	// set the function that draws the scene, and the color that
+	// the scene is cleared to
+	void SetScenePass(std::function<void()> renderScene, glm::vec4 clearColor);
+
+	// set the size of the window framebuffer
+	void SetOutputSize(int width, int height);
+	// set the camera view that was drawn this frame, which is
+	// used for reprojecting the TAA history
+	void SetMainView(const SCENE_VIEW& sceneView);
+
+	// draw the scene and the enabled effects
+	void RenderFrame();
+
+	// get the size of the target that the scene is drawn into
+	int GetSceneWidth() const;
+	int GetSceneHeight() const;
+	// get the offset in pixels for the projections of this frame
+	glm::vec2 GetJitter() const;
+	// check whether TAA is still refining a view that stopped
+	// changing, so that more frames need to be drawn
+	bool IsAccumulating() const;
+
+private:
+	// the screen effects that can be turned on
+	enum EFFECT_FLAGS
+	{
+		EFFECT_TONE_MAPPING = 1,
+		EFFECT_BLOOM = 2,
+		EFFECT_FXAA = 4
+	};
+
+	// graph of the passes for the enabled effects
+	FrameGraph m_frameGraph;
+	// options that turn the effects on and off
+	RENDER_SETTINGS* m_pRenderSettings;
+	// draws the scene, and the color it is cleared to
+	std::function<void()> m_renderScene;
+	glm::vec4 m_clearColor;
+	// output size of the graph
+	int m_width;
+	int m_height;
+	// effects, anti-aliasing mode, scale and size the graph was
+	// built for - effects are -1 if it needs building
+	int m_builtEffects;
+	int m_builtAntiAliasing;
+	float m_builtScale;
+	int m_builtWidth;
+	int m_builtHeight;
+	// texture that the scene is drawn into
+	int m_sceneColor;
+	// most samples of the multisampled scene targets
+	int m_maxSamples;
+
+	// jitter of this frame, and the frame in the jitter sequence
+	glm::vec2 m_jitter;
+	int m_jitterIndex;
+	// jittered view projection of this frame, and the unjittered
+	// one of the frame before, for reprojecting the history
+	glm::mat4 m_viewProjection;
+	glm::mat4 m_previousViewProjection;
+	glm::mat4 m_unjitteredViewProjection;
+	// area of the camera view in the scene target, in texture
+	// coordinates
+	glm::vec4 m_viewRect;
+	// false until the history holds a frame of the current graph
+	bool m_bHistoryValid;
+	// frames drawn since the camera view last changed
+	int m_stillFrames;
+
+	// ring of timer queries for the GPU time of the frames
+	static const int TIMER_QUERY_COUNT = 4;
+	GLuint m_timerQueries[TIMER_QUERY_COUNT];
+	bool m_bTimerPending[TIMER_QUERY_COUNT];
+	int m_timerIndex;
+	// smoothed GPU time of a frame in seconds
+	double m_gpuFrameTime;
+	// frames measured since the scale was last adjusted
+	int m_timedFrames;
+	// fraction of the render scale that the dynamic resolution
+	// controller keeps
+	float m_dynamicScale;
+	// empty vertex array for drawing the full screen triangle
+	GLuint m_fullscreenVAO;
+	// programs of the effect passes
+	GLuint m_brightProgramID;
+	GLuint m_blurProgramID;
+	GLuint m_compositeProgramID;
+	GLuint m_fxaaProgramID;
+	GLuint m_taaProgramID;
+	// uniform locations that change with the graph
+	GLint m_blurTexelStepLocation;
+	GLint m_compositeBloomLocation;
+	GLint m_compositeToneMappingLocation;
+	GLint m_fxaaTexelSizeLocation;
+	GLint m_taaTexelSizeLocation;
+	GLint m_taaCurrentToPreviousLocation;
+	GLint m_taaViewRectLocation;
+	GLint m_taaHistoryWeightLocation;
+
+	// get the effects that are currently turned on
+	int GetEnabledEffects() const;
+	// get the anti-aliasing mode that can be used, and the scale
+	// of the scene with the dynamic resolution applied
+	int GetAntiAliasingMode() const;
+	float GetSceneScale() const;
+	// declare and compile the passes for a set of effects, an
+	// anti-aliasing mode and a scene scale
+	void BuildFrameGraph(int effects, int antiAliasingMode, float scale);
+	// read the finished timer queries, and adjust the scale to
+	// keep the frames under the target frame time
+	void UpdateDynamicResolution();
+	// draw a triangle that covers the whole target
+	void DrawFullscreenTriangle();
+	// free the effect programs
+	void DeletePrograms();
+};
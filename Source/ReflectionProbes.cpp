@@ -0,0 +1,630 @@
+///////////////////////////////////////////////////////////////////////////////
+// reflectionprobes.cpp
+// ============
+// capture the scene around fixed points into cubemaps, prefiltered by
+// roughness, that glossy surfaces read their reflections from
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ReflectionProbes.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// near and far planes of the faces of a capture
+	const float CAPTURE_NEAR_PLANE = 0.05f;
+	const float CAPTURE_FAR_PLANE = 100.0f;
+
+	// directions and up vectors of the cubemap faces, in the
+	// order of the face targets
+	const glm::vec3 g_FaceDirections[6] =
+	{
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+	};
+	const glm::vec3 g_FaceUps[6] =
+	{
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+	};
+
+	// vertex shader of a triangle that covers the viewport
+	const char* g_FullScreenVertexShader =
+		"#version 330 core\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 corner = vec2((gl_VertexID == 1) ? 3.0f : -1.0f, (gl_VertexID == 2) ? 3.0f : -1.0f);\n"
+		"	gl_Position = vec4(corner, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that prefilters a level of a probe, by
+	// sampling the captured faces around the direction of each
+	// texel with the GGX distribution of its roughness - the
+	// view is taken to look along the direction, and the samples
+	// that cover more of the sphere read coarser capture levels,
+	// so few samples are needed for a smooth result
+	const char* g_PrefilterFragmentShader =
+		"#version 330 core\n"
+		"const int SAMPLE_COUNT = 64;\n"
+		"const float PI = 3.14159265f;\n"
+		"uniform samplerCube captureTexture;\n"
+		"uniform int face;\n"
+		"uniform float roughness;\n"
+		"uniform float levelSize;\n"
+		"uniform float captureSize;\n"
+		"out vec4 fragmentColor;\n"
+		"vec3 GetFaceDirection(vec2 position)\n"
+		"{\n"
+		"	if (face == 0) return vec3(1.0f, -position.y, -position.x);\n"
+		"	if (face == 1) return vec3(-1.0f, -position.y, position.x);\n"
+		"	if (face == 2) return vec3(position.x, 1.0f, position.y);\n"
+		"	if (face == 3) return vec3(position.x, -1.0f, -position.y);\n"
+		"	if (face == 4) return vec3(position.x, -position.y, 1.0f);\n"
+		"	return vec3(-position.x, -position.y, -1.0f);\n"
+		"}\n"
+		"float RadicalInverse(uint bits)\n"
+		"{\n"
+		"	bits = (bits << 16u) | (bits >> 16u);\n"
+		"	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);\n"
+		"	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);\n"
+		"	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);\n"
+		"	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);\n"
+		"	return float(bits) * 2.3283064365386963e-10f;\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 normal = normalize(GetFaceDirection(gl_FragCoord.xy / levelSize * 2.0f - 1.0f));\n"
+		"	if (roughness <= 0.0f)\n"
+		"	{\n"
+		"		fragmentColor = vec4(textureLod(captureTexture, normal, 0.0f).rgb, 1.0f);\n"
+		"		return;\n"
+		"	}\n"
+		"	vec3 up = (abs(normal.z) < 0.999f) ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);\n"
+		"	vec3 tangent = normalize(cross(up, normal));\n"
+		"	vec3 bitangent = cross(normal, tangent);\n"
+		"	float alphaSquared = roughness * roughness * roughness * roughness;\n"
+		"	float texelAngle = 4.0f * PI / (6.0f * captureSize * captureSize);\n"
+		"	vec3 color = vec3(0.0f);\n"
+		"	float weight = 0.0f;\n"
+		"	for (int i = 0; i < SAMPLE_COUNT; i++)\n"
+		"	{\n"
+		"		float phi = 2.0f * PI * (float(i) + 0.5f) / float(SAMPLE_COUNT);\n"
+		"		float random = RadicalInverse(uint(i));\n"
+		"		float cosTheta = sqrt((1.0f - random) / (1.0f + (alphaSquared - 1.0f) * random));\n"
+		"		float sinTheta = sqrt(1.0f - cosTheta * cosTheta);\n"
+		"		vec3 halfway = normalize(tangent * (cos(phi) * sinTheta) + bitangent * (sin(phi) * sinTheta) + normal * cosTheta);\n"
+		"		vec3 direction = reflect(-normal, halfway);\n"
+		"		float cosine = dot(normal, direction);\n"
+		"		if (cosine > 0.0f)\n"
+		"		{\n"
+		"			float denominator = cosTheta * cosTheta * (alphaSquared - 1.0f) + 1.0f;\n"
+		"			float density = alphaSquared / (PI * denominator * denominator) * 0.25f;\n"
+		"			float sampleAngle = 1.0f / (float(SAMPLE_COUNT) * density + 0.0001f);\n"
+		"			float level = max(0.5f * log2(sampleAngle / texelAngle), 0.0f);\n"
+		"			color += textureLod(captureTexture, direction, level).rgb * cosine;\n"
+		"			weight += cosine;\n"
+		"		}\n"
+		"	}\n"
+		"	fragmentColor = vec4(color / max(weight, 0.0001f), 1.0f);\n"
+		"}\n";
+
+	// vertex shader of the reflections, with the attributes of
+	// the scene meshes
+	const char* g_ReflectionVertexShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (location = 1) in vec3 inVertexNormal;\n"
+		"uniform mat4 model;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"out vec3 fragmentPosition;\n"
+		"out vec3 fragmentNormal;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 worldPosition = model * vec4(inVertexPosition, 1.0f);\n"
+		"	fragmentPosition = worldPosition.xyz;\n"
+		"	fragmentNormal = mat3(transpose(inverse(model))) * inVertexNormal;\n"
+		"	gl_Position = projection * view * worldPosition;\n"
+		"}\n";
+
+	// fragment shader of the reflections, which follows the
+	// reflected view ray to the box of the probe, so that the
+	// reflection is of the surface it hits rather than of the
+	// direction seen from the probe, and reads the probe level
+	// of the roughness once - the Fresnel term is the coverage
+	// that the reflection is blended over the surface with
+	const char* g_ReflectionFragmentShader =
+		"#version 330 core\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"uniform samplerCube probeTexture;\n"
+		"uniform vec3 probePosition;\n"
+		"uniform vec3 probeBoundsMin;\n"
+		"uniform vec3 probeBoundsMax;\n"
+		"uniform float reflectivity;\n"
+		"uniform float roughness;\n"
+		"uniform float maxLevel;\n"
+		"in vec3 fragmentPosition;\n"
+		"in vec3 fragmentNormal;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 normal = normalize(fragmentNormal);\n"
+		"	vec3 viewDirection = normalize(fragmentPosition - viewPosition);\n"
+		"	vec3 direction = reflect(viewDirection, normal);\n"
+		"	vec3 farPlanes = max((probeBoundsMax - fragmentPosition) / direction, (probeBoundsMin - fragmentPosition) / direction);\n"
+		"	float hitDistance = min(min(farPlanes.x, farPlanes.y), farPlanes.z);\n"
+		"	if (hitDistance > 0.0f)\n"
+		"	{\n"
+		"		direction = fragmentPosition + direction * hitDistance - probePosition;\n"
+		"	}\n"
+		"	vec3 color = textureLod(probeTexture, direction, roughness * maxLevel).rgb;\n"
+		"	float facing = 1.0f - max(dot(normal, -viewDirection), 0.0f);\n"
+		"	float grazing = max(1.0f - roughness, reflectivity);\n"
+		"	float fresnel = reflectivity + (grazing - reflectivity) * pow(facing, 5.0f);\n"
+		"	fragmentColor = vec4(color, clamp(fresnel, 0.0f, 1.0f));\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  ReflectionProbes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ReflectionProbes::ReflectionProbes()
+{
+	m_prefilterProgramID = 0;
+	m_reflectionProgramID = 0;
+	m_prefilterFaceLocation = -1;
+	m_prefilterRoughnessLocation = -1;
+	m_prefilterSizeLocation = -1;
+	m_modelLocation = -1;
+	m_probePositionLocation = -1;
+	m_probeBoundsMinLocation = -1;
+	m_probeBoundsMaxLocation = -1;
+	m_reflectivityLocation = -1;
+	m_roughnessLocation = -1;
+	m_captureTextureID = 0;
+	m_captureDepthID = 0;
+	m_captureFramebufferID = 0;
+	m_prefilterFramebufferID = 0;
+	m_emptyVertexArrayID = 0;
+	m_savedFramebufferID = 0;
+	m_savedViewport[0] = 0;
+	m_savedViewport[1] = 0;
+	m_savedViewport[2] = 0;
+	m_savedViewport[3] = 0;
+	m_boundProbe = -1;
+}
+
+/***********************************************************
+ *  ~ReflectionProbes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ReflectionProbes::~ReflectionProbes()
+{
+	Reset();
+	DeleteTrackedTexture(m_captureTextureID);
+	DeleteTrackedTexture(m_captureDepthID);
+	if (0 != m_captureFramebufferID)
+	{
+		glDeleteFramebuffers(1, &m_captureFramebufferID);
+	}
+	if (0 != m_prefilterFramebufferID)
+	{
+		glDeleteFramebuffers(1, &m_prefilterFramebufferID);
+	}
+	DeleteTrackedVertexArray(m_emptyVertexArrayID);
+	DeleteTrackedProgram(m_prefilterProgramID);
+	DeleteTrackedProgram(m_reflectionProgramID);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the prefilter and
+ *  reflection programs, and creating the cubemap that the
+ *  faces of a probe are captured into.
+ ***********************************************************/
+bool ReflectionProbes::Initialize()
+{
+	m_prefilterProgramID = ShaderCache::CompileProgram(g_FullScreenVertexShader, g_PrefilterFragmentShader);
+	GLuint reflectionProgramID = ShaderCache::CompileProgram(g_ReflectionVertexShader, g_ReflectionFragmentShader);
+	if ((0 == m_prefilterProgramID) || (0 == reflectionProgramID))
+	{
+		DeleteTrackedProgram(m_prefilterProgramID);
+		DeleteTrackedProgram(reflectionProgramID);
+		return false;
+	}
+
+	m_prefilterFaceLocation = glGetUniformLocation(m_prefilterProgramID, "face");
+	m_prefilterRoughnessLocation = glGetUniformLocation(m_prefilterProgramID, "roughness");
+	m_prefilterSizeLocation = glGetUniformLocation(m_prefilterProgramID, "levelSize");
+	m_modelLocation = glGetUniformLocation(reflectionProgramID, "model");
+	m_probePositionLocation = glGetUniformLocation(reflectionProgramID, "probePosition");
+	m_probeBoundsMinLocation = glGetUniformLocation(reflectionProgramID, "probeBoundsMin");
+	m_probeBoundsMaxLocation = glGetUniformLocation(reflectionProgramID, "probeBoundsMax");
+	m_reflectivityLocation = glGetUniformLocation(reflectionProgramID, "reflectivity");
+	m_roughnessLocation = glGetUniformLocation(reflectionProgramID, "roughness");
+
+	// the samplers read from the probe unit, where the capture
+	// is bound while a probe is prefiltered
+	glUseProgram(m_prefilterProgramID);
+	glUniform1i(glGetUniformLocation(m_prefilterProgramID, "captureTexture"), PROBE_TEXTURE_UNIT);
+	glUniform1f(glGetUniformLocation(m_prefilterProgramID, "captureSize"), (GLfloat)PROBE_SIZE);
+	glUseProgram(reflectionProgramID);
+	glUniform1i(glGetUniformLocation(reflectionProgramID, "probeTexture"), PROBE_TEXTURE_UNIT);
+	glUniform1f(glGetUniformLocation(reflectionProgramID, "maxLevel"), (GLfloat)(PROBE_LEVELS - 1));
+	glUseProgram(0);
+
+	// the capture keeps every level, so the prefilter can read
+	// the wider samples from the coarser ones
+	int captureLevels = 1;
+	while ((PROBE_SIZE >> captureLevels) > 0)
+	{
+		captureLevels++;
+	}
+	m_captureTextureID = GenTrackedTexture("reflection probe capture");
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_captureTextureID);
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, captureLevels, GL_RGBA8, PROBE_SIZE, PROBE_SIZE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_captureTextureID,
+		6 * GetTextureStorageSize(GL_RGBA8, PROBE_SIZE, PROBE_SIZE, 1, true));
+
+	m_captureDepthID = GenTrackedTexture("reflection probe capture depth");
+	glBindTexture(GL_TEXTURE_2D, m_captureDepthID);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, PROBE_SIZE, PROBE_SIZE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_captureDepthID,
+		GetTextureStorageSize(GL_DEPTH_COMPONENT24, PROBE_SIZE, PROBE_SIZE));
+
+	GLint framebufferID = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebufferID);
+	glGenFramebuffers(1, &m_captureFramebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_captureFramebufferID);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X, m_captureTextureID, 0);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_captureDepthID, 0);
+	GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+	glGenFramebuffers(1, &m_prefilterFramebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)framebufferID);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Reflection probe framebuffer is incomplete (" << status << ")" << std::endl;
+		DeleteTrackedProgram(m_prefilterProgramID);
+		DeleteTrackedProgram(reflectionProgramID);
+		return false;
+	}
+
+	// the prefilter samples across the edges of the faces
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	m_emptyVertexArrayID = GenTrackedVertexArray("reflection probe prefilter");
+	m_reflectionProgramID = reflectionProgramID;
+
+	return true;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for freeing the cubemaps of all of
+ *  the probes.
+ ***********************************************************/
+void ReflectionProbes::Reset()
+{
+	for (size_t i = 0; i < m_probes.size(); i++)
+	{
+		DeleteTrackedTexture(m_probes[i].textureID);
+	}
+	m_probes.clear();
+	m_boundProbe = -1;
+}
+
+/***********************************************************
+ *  AddProbe()
+ *
+ *  This method is used for placing a probe and creating the
+ *  levels of its cubemap.  The probe is captured the next
+ *  time an out of date probe is asked for.
+ ***********************************************************/
+int ReflectionProbes::AddProbe(glm::vec3 position, float radius, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	if ((false == IsAvailable()) || ((int)m_probes.size() >= MAX_PROBES))
+	{
+		return -1;
+	}
+
+	PROBE probe;
+	probe.position = position;
+	probe.radius = radius;
+	probe.boundsMin = boundsMin;
+	probe.boundsMax = boundsMax;
+	probe.bDirty = true;
+
+	probe.textureID = GenTrackedTexture("reflection probe");
+	glBindTexture(GL_TEXTURE_CUBE_MAP, probe.textureID);
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, PROBE_LEVELS, GL_RGBA8, PROBE_SIZE, PROBE_SIZE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, PROBE_LEVELS - 1);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, probe.textureID,
+		6 * GetTextureStorageSize(GL_RGBA8, PROBE_SIZE, PROBE_SIZE, 1, true));
+
+	m_probes.push_back(probe);
+
+	return (int)m_probes.size() - 1;
+}
+
+/***********************************************************
+ *  FindNearestProbe()
+ *
+ *  This method is used for getting the probe whose position
+ *  is nearest to a point.
+ ***********************************************************/
+int ReflectionProbes::FindNearestProbe(glm::vec3 point) const
+{
+	int nearest = -1;
+	float nearestDistance = FLT_MAX;
+
+	for (size_t i = 0; i < m_probes.size(); i++)
+	{
+		glm::vec3 offset = m_probes[i].position - point;
+		float distance = glm::dot(offset, offset);
+		if (distance < nearestDistance)
+		{
+			nearest = (int)i;
+			nearestDistance = distance;
+		}
+	}
+
+	return nearest;
+}
+
+/***********************************************************
+ *  InvalidateBounds()
+ *
+ *  This method is used for putting the probes whose radius
+ *  reaches a box out of date, so that they are captured
+ *  again with what changed inside the box.
+ ***********************************************************/
+void ReflectionProbes::InvalidateBounds(glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	for (size_t i = 0; i < m_probes.size(); i++)
+	{
+		PROBE& probe = m_probes[i];
+		glm::vec3 offset = glm::clamp(probe.position, boundsMin, boundsMax) - probe.position;
+		if (glm::dot(offset, offset) <= probe.radius * probe.radius)
+		{
+			probe.bDirty = true;
+		}
+	}
+}
+
+/***********************************************************
+ *  InvalidateAll()
+ *
+ *  This method is used for putting every probe out of date,
+ *  when something that lights all of them changes.
+ ***********************************************************/
+void ReflectionProbes::InvalidateAll()
+{
+	for (size_t i = 0; i < m_probes.size(); i++)
+	{
+		m_probes[i].bDirty = true;
+	}
+}
+
+/***********************************************************
+ *  FindDirtyProbe()
+ *
+ *  This method is used for getting the first probe that is
+ *  out of date.
+ ***********************************************************/
+int ReflectionProbes::FindDirtyProbe() const
+{
+	for (size_t i = 0; i < m_probes.size(); i++)
+	{
+		if (m_probes[i].bDirty)
+		{
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/***********************************************************
+ *  GetFaceView()
+ *
+ *  This method is used for getting the view and projection
+ *  that a face of a probe is captured with.  Each face sees
+ *  a quarter turn around its axis, turned to the layout of
+ *  the cubemap faces.
+ ***********************************************************/
+void ReflectionProbes::GetFaceView(int probe, int face, glm::mat4& view, glm::mat4& projection) const
+{
+	glm::vec3 position = m_probes[probe].position;
+
+	view = glm::lookAt(position, position + g_FaceDirections[face], g_FaceUps[face]);
+	projection = glm::perspective(glm::radians(90.0f), 1.0f, CAPTURE_NEAR_PLANE, CAPTURE_FAR_PLANE);
+}
+
+/***********************************************************
+ *  BeginCapture()
+ *
+ *  This method is used for keeping the draw framebuffer and
+ *  viewport of the frame, and making the capture target the
+ *  draw target for the faces of a probe.
+ ***********************************************************/
+void ReflectionProbes::BeginCapture()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebufferID);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_captureFramebufferID);
+	glViewport(0, 0, PROBE_SIZE, PROBE_SIZE);
+}
+
+/***********************************************************
+ *  BeginFace()
+ *
+ *  This method is used for attaching a face of the capture
+ *  cubemap and clearing it to the clear color of the frame.
+ ***********************************************************/
+void ReflectionProbes::BeginFace(int face)
+{
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_captureTextureID, 0);
+	glDepthMask(GL_TRUE);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  EndCapture()
+ *
+ *  This method is used for building the levels of the
+ *  capture, and prefiltering each face of each level of
+ *  the probe from it with the roughness of that level.  The
+ *  draw target of the frame is then restored.
+ ***********************************************************/
+void ReflectionProbes::EndCapture(int probe)
+{
+	glActiveTexture(GL_TEXTURE0 + PROBE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_captureTextureID);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_prefilterFramebufferID);
+	glUseProgram(m_prefilterProgramID);
+	glBindVertexArray(m_emptyVertexArrayID);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	for (int level = 0; level < PROBE_LEVELS; level++)
+	{
+		int levelSize = PROBE_SIZE >> level;
+		glViewport(0, 0, levelSize, levelSize);
+		glUniform1f(m_prefilterSizeLocation, (GLfloat)levelSize);
+		glUniform1f(m_prefilterRoughnessLocation, (GLfloat)level / (GLfloat)(PROBE_LEVELS - 1));
+		for (int face = 0; face < 6; face++)
+		{
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_probes[probe].textureID, level);
+			glUniform1i(m_prefilterFaceLocation, face);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+	}
+	glEnable(GL_DEPTH_TEST);
+	glBindVertexArray(0);
+
+	// the probe unit is bound again for the reflections
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glActiveTexture(GL_TEXTURE0);
+	m_boundProbe = -1;
+	m_probes[probe].bDirty = false;
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)m_savedFramebufferID);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  BeginReflectionPass()
+ *
+ *  This method is used for making the reflection program
+ *  active.  The reflections are blended over the surfaces
+ *  that were drawn with the same geometry, so they only
+ *  pass the depth test where those surfaces are nearest,
+ *  and are pulled slightly forward so that the difference
+ *  between the programs does not make them flicker.
+ ***********************************************************/
+void ReflectionProbes::BeginReflectionPass()
+{
+	glUseProgram(m_reflectionProgramID);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(-1.0f, -1.0f);
+	m_boundProbe = -1;
+}
+
+/***********************************************************
+ *  SetSurfaceValues()
+ *
+ *  This method is used for setting the transform and the
+ *  material of a reflective surface into the reflection
+ *  program, and binding the probe that it reads from.
+ ***********************************************************/
+void ReflectionProbes::SetSurfaceValues(const glm::mat4& model, int probe, float reflectivity, float roughness)
+{
+	if (probe != m_boundProbe)
+	{
+		const PROBE& values = m_probes[probe];
+		glActiveTexture(GL_TEXTURE0 + PROBE_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, values.textureID);
+		glActiveTexture(GL_TEXTURE0);
+		glUniform3fv(m_probePositionLocation, 1, glm::value_ptr(values.position));
+		glUniform3fv(m_probeBoundsMinLocation, 1, glm::value_ptr(values.boundsMin));
+		glUniform3fv(m_probeBoundsMaxLocation, 1, glm::value_ptr(values.boundsMax));
+		m_boundProbe = probe;
+	}
+
+	glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+	glUniform1f(m_reflectivityLocation, reflectivity);
+	glUniform1f(m_roughnessLocation, roughness);
+}
+
+/***********************************************************
+ *  EndReflectionPass()
+ *
+ *  This method is used for turning off the depth offset of
+ *  the reflections.  The blending and depth state are left
+ *  as the passes after them set their own.
+ ***********************************************************/
+void ReflectionProbes::EndReflectionPass()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDepthFunc(GL_LESS);
+}
+
+/***********************************************************
+ *  GetRoughness()
+ *
+ *  This method is used for getting the roughness of a
+ *  surface from its shininess, taken as the power of a
+ *  Phong highlight.  A GGX distribution with a width of
+ *  sqrt(2 / (power + 2)) has about the same highlight, and
+ *  the roughness is the square root of that width, so the
+ *  probe levels step evenly in how blurred they look.
+ ***********************************************************/
+float ReflectionProbes::GetRoughness(float shininess)
+{
+	return std::sqrt(std::sqrt(2.0f / (std::max(shininess, 0.0f) + 2.0f)));
+}
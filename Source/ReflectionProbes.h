@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+// reflectionprobes.h
+// ============
+// capture the scene around fixed points into cubemaps, prefiltered by
+// roughness, that glossy surfaces read their reflections from
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ReflectionProbes
+ *
+ *  This class holds the reflection probes of the scene.
+ *  Each probe keeps a cubemap of the static objects around
+ *  its position, whose mip levels are prefiltered for a
+ *  growing roughness, so that a glossy surface reads a
+ *  blurred reflection with a single lookup.  A probe is
+ *  only captured again when it is marked out of date, by a
+ *  static object changing near it or by a light changing.
+ *  The reflections are drawn over the lit surfaces with a
+ *  pass of their own, blended by a Fresnel term, and are
+ *  projected onto a box around the scene so that they line
+ *  up with the surfaces away from the probe.
+ ***********************************************************/
+class ReflectionProbes
+{
+public:
+	// texture unit the probe of a surface is read from, which is
+	// not used by the scene textures, the frame graph inputs or
+	// the other passes
+	static const int PROBE_TEXTURE_UNIT = 21;
+	// size in texels of a face of the probe cubemaps
+	static const int PROBE_SIZE = 128;
+	// mip levels of a probe, from a mirror at the first level to
+	// the roughest surface at the last
+	static const int PROBE_LEVELS = 6;
+	// most probes that can be placed in the scene
+	static const int MAX_PROBES = 8;
+
+	// a probe, with the box its reflections are projected onto
+	struct PROBE
+	{
+		glm::vec3 position;
+		// static objects whose bounds come within this distance of
+		// the position put the probe out of date
+		float radius;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		GLuint textureID;
+		bool bDirty;
+	};
+
+	// constructor
+	ReflectionProbes();
+	// destructor
+	~ReflectionProbes();
+
+	// compile the programs and create the capture target - returns
+	// false when the driver cannot run them
+	bool Initialize();
+	// check whether the programs are available
+	bool IsAvailable() const { return (0 != m_reflectionProgramID); }
+
+	// free the probes
+	void Reset();
+	// place a probe, which starts out of date - returns the probe
+	// index, or -1 when no more probes can be placed
+	int AddProbe(glm::vec3 position, float radius, glm::vec3 boundsMin, glm::vec3 boundsMax);
+	int GetProbeCount() const { return (int)m_probes.size(); }
+	const PROBE& GetProbe(int probe) const { return m_probes[probe]; }
+	// get the probe nearest to a point, or -1 when there are none
+	int FindNearestProbe(glm::vec3 point) const;
+
+	// put the probes that a changed static object is near out of
+	// date
+	void InvalidateBounds(glm::vec3 boundsMin, glm::vec3 boundsMax);
+	// put every probe out of date
+	void InvalidateAll();
+	// get an out of date probe, or -1 when all are current
+	int FindDirtyProbe() const;
+
+	// get the view values that a face of a probe is captured with
+	void GetFaceView(int probe, int face, glm::mat4& view, glm::mat4& projection) const;
+	// make the capture target the draw target - the draw
+	// framebuffer and viewport bound now are restored afterwards
+	void BeginCapture();
+	// select and clear the face of the capture target that the
+	// scene is drawn into next
+	void BeginFace(int face);
+	// prefilter the captured faces into the levels of a probe,
+	// which is then current, and restore the draw target
+	void EndCapture(int probe);
+
+	// make the reflection program active and set the blending of
+	// the reflections over the drawn surfaces
+	void BeginReflectionPass();
+	// set the values of a reflective surface into the reflection
+	// program, with the probe it reads from
+	void SetSurfaceValues(const glm::mat4& model, int probe, float reflectivity, float roughness);
+	// restore the blending and depth state after the reflections
+	void EndReflectionPass();
+
+	// get the roughness of a material from its shininess, taken
+	// as the power of a specular highlight
+	static float GetRoughness(float shininess);
+
+private:
+	std::vector<PROBE> m_probes;
+
+	// the programs that prefilter a probe and draw the reflections
+	GLuint m_prefilterProgramID;
+	GLuint m_reflectionProgramID;
+	GLint m_prefilterFaceLocation;
+	GLint m_prefilterRoughnessLocation;
+	GLint m_prefilterSizeLocation;
+	GLint m_modelLocation;
+	GLint m_probePositionLocation;
+	GLint m_probeBoundsMinLocation;
+	GLint m_probeBoundsMaxLocation;
+	GLint m_reflectivityLocation;
+	GLint m_roughnessLocation;
+
+	// the cubemap that the faces are captured into, with all of
+	// its levels for the prefilter to sample, its depth and the
+	// framebuffers that draw into it and into the probes
+	GLuint m_captureTextureID;
+	GLuint m_captureDepthID;
+	GLuint m_captureFramebufferID;
+	GLuint m_prefilterFramebufferID;
+	// empty vertex array for the full screen triangle
+	GLuint m_emptyVertexArrayID;
+
+	// the draw target and viewport saved while a probe is captured
+	GLint m_savedFramebufferID;
+	GLint m_savedViewport[4];
+	// the probe bound for the reflections
+	int m_boundProbe;
+};
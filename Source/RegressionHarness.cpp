@@ -0,0 +1,605 @@
+///////////////////////////////////////////////////////////////////////////////
+// regressionharness.cpp
+// ============
+// draw the scene from fixed camera poses and compare the frames and
+// their times against stored golden images and frame time budgets
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RegressionHarness.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// the poses the scene is checked from - the first one is the
+	// starting camera of the view manager
+	const RegressionHarness::CAMERA_POSE g_CameraPoses[] =
+	{
+		{ "perspective_default", glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, false },
+		{ "perspective_close", glm::vec3(0.0f, 4.0f, 6.0f), glm::vec3(0.0f, -0.6f, -1.0f), 60.0f, false },
+		{ "perspective_side", glm::vec3(11.0f, 5.0f, 4.0f), glm::vec3(-1.0f, -0.35f, -0.45f), 70.0f, false },
+		{ "orthographic_default", glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, true },
+		{ "orthographic_above", glm::vec3(0.0f, 20.0f, 4.0f), glm::vec3(0.0f, -1.0f, -0.2f), 80.0f, true }
+	};
+
+	// frames drawn before each pose is timed, so that the texture
+	// levels are streamed in and TAA has settled, and the frames
+	// that the median time is taken over
+	const int WARMUP_FRAMES = 30;
+	const int TIMED_FRAMES = 30;
+
+	// difference in CIE Lab units above which a pixel is seen as
+	// changed, and the share of the pixels that may change before
+	// the frame fails
+	const float PIXEL_DELTA_E = 6.0f;
+	const double MAX_CHANGED_PIXEL_FRACTION = 0.001;
+
+	// share by which a frame time may go over its budget, and the
+	// time in milliseconds that is always allowed for timer noise
+	const double FRAME_TIME_TOLERANCE = 0.25;
+	const double FRAME_TIME_SLACK = 1.0;
+
+	// file in the golden image directory with the frame time budgets
+	const char* g_BudgetFileName = "budgets.txt";
+
+	// work of the calibration frame - points transformed on the CPU,
+	// and triangles covering the frame with a fixed amount of
+	// shading each
+	const int CALIBRATION_POINTS = 200000;
+	const int CALIBRATION_DRAWS = 4;
+	// written each calibration frame, so the point transforms are
+	// not left out by the compiler
+	volatile float g_CalibrationSink = 0.0f;
+
+	// vertex shader of a triangle that covers the frame
+	const char* g_CalibrationVertexShader =
+		"#version 330 core\n"
+		"out vec2 fragmentUV;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"	fragmentUV = position;\n"
+		"	gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader with a fixed run of arithmetic per pixel, in
+	// the range of the scene shader's lighting
+	const char* g_CalibrationFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 outColor;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 value = vec3(fragmentUV, 0.5f);\n"
+		"	for (int i = 0; i < 8; i++)\n"
+		"	{\n"
+		"		value = fract(normalize(value + 0.1f) * 1.7f + vec3(pow(max(value.x, 0.01f), 8.0f)));\n"
+		"	}\n"
+		"	outColor = vec4(value, 1.0f);\n"
+		"}\n";
+
+	/***********************************************************
+	 *  ConvertToLab()
+	 *
+	 *  This function is used for converting RGB pixels to the
+	 *  CIE Lab color space, where the distance between two
+	 *  colors follows how different they look.
+	 ***********************************************************/
+	void ConvertToLab(const std::vector<unsigned char>& pixels, std::vector<glm::vec3>& lab)
+	{
+		float linear[256];
+		for (int i = 0; i < 256; i++)
+		{
+			float value = i / 255.0f;
+			linear[i] = (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		auto labCurve = [](float t)
+		{
+			return (t > 0.008856f) ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+		};
+
+		lab.resize(pixels.size() / 3);
+		for (size_t i = 0; i < lab.size(); i++)
+		{
+			float r = linear[pixels[i * 3]];
+			float g = linear[pixels[i * 3 + 1]];
+			float b = linear[pixels[i * 3 + 2]];
+
+			// XYZ relative to the D65 white point
+			float x = labCurve((0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f);
+			float y = labCurve(0.2126f * r + 0.7152f * g + 0.0722f * b);
+			float z = labCurve((0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f);
+			lab[i] = glm::vec3(116.0f * y - 16.0f, 500.0f * (x - y), 200.0f * (y - z));
+		}
+	}
+
+	/***********************************************************
+	 *  GetNearestDifference()
+	 *
+	 *  This function is used for getting the smallest color
+	 *  difference between a pixel and the pixels around the
+	 *  same point of another image.
+	 ***********************************************************/
+	float GetNearestDifference(const glm::vec3& color, const std::vector<glm::vec3>& other, int width, int height, int x, int y)
+	{
+		float nearest = 1.0e30f;
+		for (int offsetY = -1; offsetY <= 1; offsetY++)
+		{
+			int otherY = glm::clamp(y + offsetY, 0, height - 1);
+			for (int offsetX = -1; offsetX <= 1; offsetX++)
+			{
+				int otherX = glm::clamp(x + offsetX, 0, width - 1);
+				nearest = std::min(nearest, glm::distance(color, other[(size_t)otherY * width + otherX]));
+			}
+		}
+
+		return nearest;
+	}
+}
+
+/***********************************************************
+ *  RegressionHarness()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RegressionHarness::RegressionHarness(const char* directory, bool bUpdate)
+{
+	m_directory = (NULL != directory) ? directory : ".";
+	m_bUpdate = bUpdate;
+	m_calibrationMilliseconds = 0.0;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for drawing the scene from each of
+ *  the camera poses and checking the frames and their
+ *  times.  Every pose is checked even after one fails, so
+ *  one run reports all of the regressions.  The camera is
+ *  handed back to the simulation afterwards.
+ ***********************************************************/
+bool RegressionHarness::Run(ViewManager* pViewManager, PostProcessor* pPostProcessor)
+{
+	if ((NULL == pViewManager) || (NULL == pPostProcessor))
+	{
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	LoadBudgets();
+
+	int width = 0;
+	int height = 0;
+	pViewManager->GetFramebufferSize(width, height);
+	if (false == Calibrate(std::max(width, 1), std::max(height, 1)))
+	{
+		return false;
+	}
+
+	int failedCount = 0;
+	const int poseCount = (int)(sizeof(g_CameraPoses) / sizeof(g_CameraPoses[0]));
+	for (int i = 0; i < poseCount; i++)
+	{
+		const CAMERA_POSE& pose = g_CameraPoses[i];
+		IMAGE image;
+		double frameMilliseconds = 0.0;
+		RenderPose(pose, pViewManager, pPostProcessor, image, frameMilliseconds);
+
+		bool bImagePassed = CheckImage(pose, image);
+		bool bTimePassed = CheckFrameTime(pose, frameMilliseconds);
+		if ((false == bImagePassed) || (false == bTimePassed))
+		{
+			failedCount++;
+		}
+	}
+	pViewManager->SetFixedCamera(NULL);
+
+	if (m_bUpdate)
+	{
+		SaveBudgets();
+		std::cout << "INFO: Recorded golden images and frame time budgets for " << poseCount
+			<< " poses in " << m_directory << std::endl;
+		return true;
+	}
+
+	std::cout << "INFO: Regression run " << ((failedCount == 0) ? "passed" : "failed") << ", "
+		<< (poseCount - failedCount) << " of " << poseCount << " poses passed" << std::endl;
+	return (failedCount == 0);
+}
+
+/***********************************************************
+ *  Calibrate()
+ *
+ *  This method is used for timing a frame of fixed work on
+ *  this machine, which the frame times of the poses are
+ *  measured in.  The frame transforms a set of points on
+ *  the CPU and draws triangles covering the window with a
+ *  fixed amount of shading, so it slows down with both the
+ *  processor and the GPU, or the processor alone on Mesa.
+ *  The median of the timed frames is kept, as for a pose.
+ ***********************************************************/
+bool RegressionHarness::Calibrate(int width, int height)
+{
+	GLuint programID = ShaderCache::CompileProgram(g_CalibrationVertexShader, g_CalibrationFragmentShader);
+	if (0 == programID)
+	{
+		std::cout << "ERROR: Calibration frame cannot be drawn" << std::endl;
+		return false;
+	}
+	GLuint vertexArrayID = GenTrackedVertexArray("calibration triangle");
+
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+	glUseProgram(programID);
+	glBindVertexArray(vertexArrayID);
+
+	std::vector<glm::vec4> points(CALIBRATION_POINTS);
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		points[i] = glm::vec4((float)(i % 512), (float)(i / 512), 1.0f, 1.0f);
+	}
+	glm::mat4 transform(1.0f);
+	transform[3] = glm::vec4(0.5f, -0.25f, 0.125f, 1.0f);
+
+	std::vector<double> frameTimes;
+	for (int frame = 0; frame < WARMUP_FRAMES + TIMED_FRAMES; frame++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			points[i] = transform * points[i];
+			points[i].w = 1.0f;
+		}
+		g_CalibrationSink = points[frame % points.size()].x;
+		for (int draw = 0; draw < CALIBRATION_DRAWS; draw++)
+		{
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+		glFinish();
+		if (frame >= WARMUP_FRAMES)
+		{
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	m_calibrationMilliseconds = std::max(frameTimes[frameTimes.size() / 2], 1.0e-3);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+	DeleteTrackedVertexArray(vertexArrayID);
+	DeleteTrackedProgram(programID);
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (bBlend)
+	{
+		glEnable(GL_BLEND);
+	}
+
+	std::cout << "INFO: Calibration frame took " << m_calibrationMilliseconds << " ms" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  RenderPose()
+ *
+ *  This method is used for drawing the scene from a camera
+ *  pose and reading the last frame back from the window.
+ *  Each frame is waited on, so its time covers the work of
+ *  both the CPU and the GPU, and the median time is kept so
+ *  one slow frame does not count.
+ ***********************************************************/
+void RegressionHarness::RenderPose(
+	const CAMERA_POSE& pose,
+	ViewManager* pViewManager,
+	PostProcessor* pPostProcessor,
+	IMAGE& image,
+	double& frameMilliseconds)
+{
+	ViewManager::CAMERA_STATE state;
+	state.position = pose.position;
+	state.front = pose.front;
+	state.up = glm::vec3(0.0f, 1.0f, 0.0f);
+	state.zoom = pose.zoom;
+	state.movementSpeed = 0.0f;
+	state.bOrthographic = pose.bOrthographic;
+	state.tickTime = 0.0;
+	pViewManager->SetFixedCamera(&state);
+
+	int width = 0;
+	int height = 0;
+	pViewManager->GetFramebufferSize(width, height);
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	pPostProcessor->SetOutputSize(width, height);
+
+	for (int i = 0; i < WARMUP_FRAMES; i++)
+	{
+		pPostProcessor->RenderFrame();
+		glFinish();
+	}
+
+	std::vector<double> frameTimes;
+	for (int i = 0; i < TIMED_FRAMES; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		pPostProcessor->RenderFrame();
+		glFinish();
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	frameMilliseconds = frameTimes[frameTimes.size() / 2];
+
+	// the rows are read from the bottom up, and stored from the top
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 3);
+	std::vector<unsigned char> rows(image.pixels.size());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+	size_t rowSize = (size_t)width * 3;
+	for (int y = 0; y < height; y++)
+	{
+		std::copy(
+			rows.begin() + (size_t)(height - 1 - y) * rowSize,
+			rows.begin() + (size_t)(height - y) * rowSize,
+			image.pixels.begin() + (size_t)y * rowSize);
+	}
+}
+
+/***********************************************************
+ *  CheckImage()
+ *
+ *  This method is used for comparing a frame with the
+ *  golden image of its pose.  A pixel has changed when its
+ *  color differs visibly from every pixel around the same
+ *  point of the other image, checked both ways so that
+ *  thin details that appear or go missing are both found.
+ *  A failed frame is saved next to a difference image with
+ *  the changed pixels in red.
+ ***********************************************************/
+bool RegressionHarness::CheckImage(const CAMERA_POSE& pose, const IMAGE& image)
+{
+	std::string goldenPath = GetPath(pose.name, ".ppm");
+	if (m_bUpdate)
+	{
+		return WriteImage(goldenPath, image);
+	}
+
+	IMAGE golden;
+	if (false == ReadImage(goldenPath, golden))
+	{
+		std::cout << "ERROR: No golden image for " << pose.name << " - record one with --regression-update" << std::endl;
+		return false;
+	}
+	if ((golden.width != image.width) || (golden.height != image.height))
+	{
+		std::cout << "ERROR: Frame of " << pose.name << " is " << image.width << "x" << image.height
+			<< " but its golden image is " << golden.width << "x" << golden.height << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> frameLab;
+	std::vector<glm::vec3> goldenLab;
+	ConvertToLab(image.pixels, frameLab);
+	ConvertToLab(golden.pixels, goldenLab);
+
+	IMAGE difference = golden;
+	size_t changedCount = 0;
+	double totalDifference = 0.0;
+	for (int y = 0; y < image.height; y++)
+	{
+		for (int x = 0; x < image.width; x++)
+		{
+			size_t pixel = (size_t)y * image.width + x;
+			float frameDifference = GetNearestDifference(frameLab[pixel], goldenLab, image.width, image.height, x, y);
+			float goldenDifference = GetNearestDifference(goldenLab[pixel], frameLab, image.width, image.height, x, y);
+			float pixelDifference = std::max(frameDifference, goldenDifference);
+			totalDifference += pixelDifference;
+
+			// the difference image shows the golden image faded to
+			// gray, with the changed pixels in red
+			unsigned char* pDifference = &difference.pixels[pixel * 3];
+			unsigned char gray = (unsigned char)((pDifference[0] + pDifference[1] + pDifference[2]) / 6);
+			pDifference[0] = gray;
+			pDifference[1] = gray;
+			pDifference[2] = gray;
+			if (pixelDifference > PIXEL_DELTA_E)
+			{
+				pDifference[0] = 255;
+				changedCount++;
+			}
+		}
+	}
+
+	size_t pixelCount = (size_t)image.width * image.height;
+	double changedFraction = (double)changedCount / (double)pixelCount;
+	bool bPassed = (changedFraction <= MAX_CHANGED_PIXEL_FRACTION);
+	std::cout << (bPassed ? "INFO: " : "ERROR: ") << pose.name << " image " << (bPassed ? "matches" : "changed")
+		<< ", " << changedCount << " pixels changed, average difference " << (totalDifference / pixelCount) << std::endl;
+
+	if (false == bPassed)
+	{
+		WriteImage(GetPath(pose.name, ".frame.ppm"), image);
+		WriteImage(GetPath(pose.name, ".diff.ppm"), difference);
+	}
+	return bPassed;
+}
+
+/***********************************************************
+ *  CheckFrameTime()
+ *
+ *  This method is used for comparing the frame time of a
+ *  pose with its budget, or recording it as the budget in
+ *  update runs.  The budget is a number of calibration
+ *  frames, which is turned into milliseconds with the
+ *  calibration frame of this run.
+ ***********************************************************/
+bool RegressionHarness::CheckFrameTime(const CAMERA_POSE& pose, double frameMilliseconds)
+{
+	double calibrationFrames = frameMilliseconds / m_calibrationMilliseconds;
+	for (size_t i = 0; i < m_budgets.size(); i++)
+	{
+		if (m_budgets[i].name != pose.name)
+		{
+			continue;
+		}
+
+		if (m_bUpdate)
+		{
+			m_budgets[i].calibrationFrames = calibrationFrames;
+			return true;
+		}
+
+		double budget = m_budgets[i].calibrationFrames * m_calibrationMilliseconds;
+		double limit = budget * (1.0 + FRAME_TIME_TOLERANCE) + FRAME_TIME_SLACK;
+		bool bPassed = (frameMilliseconds <= limit);
+		std::cout << (bPassed ? "INFO: " : "ERROR: ") << pose.name << " frame time " << frameMilliseconds
+			<< " ms (" << calibrationFrames << " calibration frames), budget " << budget << " ms ("
+			<< m_budgets[i].calibrationFrames << " calibration frames), limit " << limit << " ms" << std::endl;
+		return bPassed;
+	}
+
+	if (m_bUpdate)
+	{
+		BUDGET budget;
+		budget.name = pose.name;
+		budget.calibrationFrames = calibrationFrames;
+		m_budgets.push_back(budget);
+		return true;
+	}
+
+	std::cout << "ERROR: No frame time budget for " << pose.name << " - record one with --regression-update" << std::endl;
+	return false;
+}
+
+/***********************************************************
+ *  LoadBudgets()
+ *
+ *  This method is used for reading the frame time budgets,
+ *  with a pose name and a time in calibration frames on
+ *  each line.
+ ***********************************************************/
+void RegressionHarness::LoadBudgets()
+{
+	m_budgets.clear();
+
+	std::ifstream file(m_directory + "/" + g_BudgetFileName);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream values(line);
+		BUDGET budget;
+		if ((values >> budget.name >> budget.calibrationFrames) && (budget.name[0] != '#'))
+		{
+			m_budgets.push_back(budget);
+		}
+	}
+}
+
+/***********************************************************
+ *  SaveBudgets()
+ *
+ *  This method is used for writing the frame time budgets.
+ ***********************************************************/
+bool RegressionHarness::SaveBudgets() const
+{
+	std::string path = m_directory + "/" + g_BudgetFileName;
+	std::ofstream file(path);
+	if (false == file.is_open())
+	{
+		std::cout << "ERROR: Could not write frame time budgets:" << path << std::endl;
+		return false;
+	}
+
+	file << "# median frame time of each pose, as a multiple of the calibration frame" << std::endl;
+	file << "# recorded on a machine where the calibration frame took " << m_calibrationMilliseconds << " ms" << std::endl;
+	for (size_t i = 0; i < m_budgets.size(); i++)
+	{
+		file << m_budgets[i].name << " " << m_budgets[i].calibrationFrames << std::endl;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  GetPath()
+ *
+ *  This method is used for getting the path of a file in
+ *  the golden image directory.
+ ***********************************************************/
+std::string RegressionHarness::GetPath(const char* name, const char* extension) const
+{
+	return m_directory + "/" + name + extension;
+}
+
+/***********************************************************
+ *  ReadImage()
+ *
+ *  This method is used for reading a binary PPM image with
+ *  8 bits per channel.
+ ***********************************************************/
+bool RegressionHarness::ReadImage(const std::string& path, IMAGE& image)
+{
+	FILE* pFile = fopen(path.c_str(), "rb");
+	if (NULL == pFile)
+	{
+		return false;
+	}
+
+	int maxValue = 0;
+	bool bLoaded = (fscanf(pFile, "P6 %d %d %d", &image.width, &image.height, &maxValue) == 3) &&
+		(image.width > 0) && (image.height > 0) && (maxValue == 255) && (fgetc(pFile) != EOF);
+	if (bLoaded)
+	{
+		image.pixels.resize((size_t)image.width * image.height * 3);
+		bLoaded = (fread(image.pixels.data(), 1, image.pixels.size(), pFile) == image.pixels.size());
+	}
+	fclose(pFile);
+
+	if (false == bLoaded)
+	{
+		std::cout << "ERROR: Could not read image:" << path << std::endl;
+	}
+	return bLoaded;
+}
+
+/***********************************************************
+ *  WriteImage()
+ *
+ *  This method is used for writing a binary PPM image.
+ ***********************************************************/
+bool RegressionHarness::WriteImage(const std::string& path, const IMAGE& image)
+{
+	FILE* pFile = fopen(path.c_str(), "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not write image:" << path << std::endl;
+		return false;
+	}
+
+	fprintf(pFile, "P6\n%d %d\n255\n", image.width, image.height);
+	fwrite(image.pixels.data(), 1, image.pixels.size(), pFile);
+	fclose(pFile);
+	return true;
+}
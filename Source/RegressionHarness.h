@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// regressionharness.h
+// ============
+// draw the scene from fixed camera poses and compare the frames and
+// their times against stored golden images and frame time budgets
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ViewManager.h"
+#include "PostProcessor.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  RegressionHarness
+ *
+ *  This class draws the scene from a fixed list of camera
+ *  poses, in perspective and orthographic projection, and
+ *  reads each frame back from the window framebuffer.  The
+ *  frames are compared against golden images with a
+ *  perceptual difference in CIE Lab space that forgives a
+ *  pixel of offset, so driver differences in rasterization
+ *  do not fail the run.  The median frame time of each pose
+ *  is checked against the budget recorded alongside the
+ *  golden images.  The budgets are kept as multiples of a
+ *  calibration frame with fixed work, timed at the start of
+ *  every run, so the budgets recorded on one machine scale
+ *  to the speed of another.  The window can stay hidden, so
+ *  the run works on a machine without a GPU through Mesa.
+ ***********************************************************/
+class RegressionHarness
+{
+public:
+	// a camera pose that the scene is drawn from
+	struct CAMERA_POSE
+	{
+		const char* name;
+		glm::vec3 position;
+		glm::vec3 front;
+		float zoom;
+		bool bOrthographic;
+	};
+
+	// constructor - with update on, the golden images and budgets
+	// are written from this run instead of being checked
+	RegressionHarness(const char* directory, bool bUpdate);
+
+	// draw every pose and check it - returns false when any pose
+	// changed visibly or took longer than its budget allows
+	bool Run(ViewManager* pViewManager, PostProcessor* pPostProcessor);
+
+private:
+	// an RGB image with the rows from top to bottom
+	struct IMAGE
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	// a pose that has a frame time budget, in calibration frames
+	struct BUDGET
+	{
+		std::string name;
+		double calibrationFrames;
+	};
+
+	std::string m_directory;
+	bool m_bUpdate;
+	std::vector<BUDGET> m_budgets;
+	// median time in milliseconds of the calibration frame on this
+	// machine
+	double m_calibrationMilliseconds;
+
+	// time the calibration frame on this machine - returns false
+	// when it cannot be drawn
+	bool Calibrate(int width, int height);
+	// draw a pose and get its frame and median frame time
+	void RenderPose(
+		const CAMERA_POSE& pose,
+		ViewManager* pViewManager,
+		PostProcessor* pPostProcessor,
+		IMAGE& image,
+		double& frameMilliseconds);
+	// check a frame against its golden image - returns false when
+	// it differs visibly
+	bool CheckImage(const CAMERA_POSE& pose, const IMAGE& image);
+	// check a frame time against its budget - returns false when
+	// it is over by more than the tolerance
+	bool CheckFrameTime(const CAMERA_POSE& pose, double frameMilliseconds);
+
+	// read and write the frame time budgets of the poses
+	void LoadBudgets();
+	bool SaveBudgets() const;
+
+	// get the path of a file in the golden image directory
+	std::string GetPath(const char* name, const char* extension) const;
+	// read and write binary PPM images
+	static bool ReadImage(const std::string& path, IMAGE& image);
+	static bool WriteImage(const std::string& path, const IMAGE& image);
+};
@@ -0,0 +1,279 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderbackend.cpp
+// ============
+// the interface of the renderers that draw the scene outside of the
+// OpenGL context, into a frame that is then copied into OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderBackend.h"
+#include "GPUResources.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	// vertex shader that covers the viewport with one triangle
+	const char* g_PresentVertexShader =
+		"#version 330 core\n"
+		"out vec2 fragmentUV;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"	fragmentUV = position;\n"
+		"	gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader that copies the color and depth of the frame
+	const char* g_PresentFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D colorTexture;\n"
+		"uniform sampler2D depthTexture;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentColor = texture(colorTexture, fragmentUV);\n"
+		"	gl_FragDepth = texture(depthTexture, fragmentUV).r;\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  RenderBackend()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderBackend::RenderBackend()
+{
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		m_lights[i] = LIGHT();
+	}
+	m_width = 0;
+	m_height = 0;
+	m_stride = 0;
+	m_triangleCount = 0;
+	m_pWorkerPool = NULL;
+	m_presentProgramID = 0;
+	m_presentVAO = 0;
+	m_colorTextureID = 0;
+	m_depthTextureID = 0;
+	m_presentWidth = 0;
+	m_presentHeight = 0;
+}
+
+/***********************************************************
+ *  ~RenderBackend()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderBackend::~RenderBackend()
+{
+	DeletePresentObjects();
+}
+
+/***********************************************************
+ *  SetLight()
+ *
+ *  This method is used for setting the values of one of the
+ *  light sources.
+ ***********************************************************/
+void RenderBackend::SetLight(int light, const LIGHT& values)
+{
+	if ((light < 0) || (light >= MAX_LIGHTS))
+	{
+		return;
+	}
+
+	m_lights[light] = values;
+}
+
+/***********************************************************
+ *  SetWorkerPool()
+ *
+ *  This method is used for setting the pool that runs the
+ *  jobs of the renderer.  The pool is shared with the other
+ *  systems that split their work over threads, and only
+ *  runs one job at a time, all from the render thread.
+ ***********************************************************/
+void RenderBackend::SetWorkerPool(WorkerPool* pWorkerPool)
+{
+	m_pWorkerPool = pWorkerPool;
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running a job on every thread,
+ *  including the calling thread, and waiting until all of
+ *  them have finished it.  Without a pool, the calling
+ *  thread runs it alone.
+ ***********************************************************/
+void RenderBackend::RunJob(int job)
+{
+	if (NULL == m_pWorkerPool)
+	{
+		ExecuteJob(job, 0);
+		return;
+	}
+	m_pWorkerPool->Run(this, job);
+}
+
+/***********************************************************
+ *  Present()
+ *
+ *  This method is used for copying the frame into the bound
+ *  draw framebuffer, with its lower left corner at a pixel.
+ *  The color and depth are uploaded into textures and drawn
+ *  with a triangle that covers the frame, which also works
+ *  for multisampled framebuffers, and leaves the depth for
+ *  the screen effects that read it.
+ ***********************************************************/
+bool RenderBackend::Present(int x, int y)
+{
+	if ((m_width <= 0) || (m_height <= 0) || (m_colorBuffer.size() < (size_t)m_stride * m_height))
+	{
+		return false;
+	}
+	if ((0 == m_presentProgramID) && (false == CreatePresentObjects()))
+	{
+		return false;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + COLOR_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_colorTextureID);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, m_stride);
+	if ((m_presentWidth != m_width) || (m_presentHeight != m_height))
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_colorBuffer.data());
+		SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_colorTextureID, GetTextureStorageSize(GL_RGBA8, m_width, m_height));
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_colorBuffer.data());
+	}
+
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	if ((m_presentWidth != m_width) || (m_presentHeight != m_height))
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_width, m_height, 0, GL_RED, GL_FLOAT, m_depthBuffer.data());
+		SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_depthTextureID, GetTextureStorageSize(GL_R32F, m_width, m_height));
+		m_presentWidth = m_width;
+		m_presentHeight = m_height;
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RED, GL_FLOAT, m_depthBuffer.data());
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	// the copy replaces whatever the framebuffer holds in the area
+	glViewport(x, y, m_width, m_height);
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_ALWAYS);
+	glDepthMask(GL_TRUE);
+	glUseProgram(m_presentProgramID);
+	glBindVertexArray(m_presentVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glDepthFunc(GL_LESS);
+
+	return true;
+}
+
+/***********************************************************
+ *  CreatePresentObjects()
+ *
+ *  This method is used for creating the program, vertex
+ *  array and textures for copying the frame into OpenGL.
+ ***********************************************************/
+bool RenderBackend::CreatePresentObjects()
+{
+	m_presentProgramID = ShaderCache::CompileProgram(g_PresentVertexShader, g_PresentFragmentShader);
+	if (0 == m_presentProgramID)
+	{
+		std::cout << "ERROR: " << GetName() << " frames cannot be presented" << std::endl;
+		return false;
+	}
+	glUseProgram(m_presentProgramID);
+	glUniform1i(glGetUniformLocation(m_presentProgramID, "colorTexture"), COLOR_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_presentProgramID, "depthTexture"), DEPTH_TEXTURE_UNIT);
+
+	m_presentVAO = GenTrackedVertexArray("backend frame triangle");
+
+	GLuint* pTextureIDs[2] = { &m_colorTextureID, &m_depthTextureID };
+	for (int i = 0; i < 2; i++)
+	{
+		*pTextureIDs[i] = GenTrackedTexture("backend frame");
+		glBindTexture(GL_TEXTURE_2D, *pTextureIDs[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	m_presentWidth = 0;
+	m_presentHeight = 0;
+
+	return true;
+}
+
+/***********************************************************
+ *  DeletePresentObjects()
+ *
+ *  This method is used for freeing the OpenGL objects for
+ *  copying the frame.
+ ***********************************************************/
+void RenderBackend::DeletePresentObjects()
+{
+	DeleteTrackedProgram(m_presentProgramID);
+	DeleteTrackedVertexArray(m_presentVAO);
+	DeleteTrackedTexture(m_colorTextureID);
+	DeleteTrackedTexture(m_depthTextureID);
+	m_presentWidth = 0;
+	m_presentHeight = 0;
+}
+
+/***********************************************************
+ *  SaveImage()
+ *
+ *  This method is used for saving the frame as a binary PPM
+ *  image, with the top row first.
+ ***********************************************************/
+bool RenderBackend::SaveImage(const char* filename) const
+{
+	if ((NULL == filename) || (m_width <= 0) || (m_height <= 0) || (m_colorBuffer.size() < (size_t)m_stride * m_height))
+	{
+		return false;
+	}
+
+	FILE* pFile = fopen(filename, "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not write image:" << filename << std::endl;
+		return false;
+	}
+
+	fprintf(pFile, "P6\n%d %d\n255\n", m_width, m_height);
+	std::vector<unsigned char> row((size_t)m_width * 3);
+	for (int y = m_height - 1; y >= 0; y--)
+	{
+		const uint32_t* pRow = &m_colorBuffer[(size_t)y * m_stride];
+		for (int x = 0; x < m_width; x++)
+		{
+			row[x * 3 + 0] = (unsigned char)(pRow[x] & 0xFF);
+			row[x * 3 + 1] = (unsigned char)((pRow[x] >> 8) & 0xFF);
+			row[x * 3 + 2] = (unsigned char)((pRow[x] >> 16) & 0xFF);
+		}
+		fwrite(row.data(), 1, row.size(), pFile);
+	}
+	fclose(pFile);
+
+	std::cout << "INFO: " << GetName() << " saved a frame:" << filename << std::endl;
+	return true;
+}
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderbackend.h
+// ============
+// the interface of the renderers that draw the scene outside of the
+// OpenGL context, into a frame that is then copied into OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+#include "WorkerPool.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderBackend
+ *
+ *  This class is the base of the renderers that draw the
+ *  scene into a color and depth buffer in system memory,
+ *  rather than into the OpenGL framebuffer.  The scene is
+ *  handed over once as meshes and texture levels, and each
+ *  frame submits the meshes to draw with their transforms
+ *  and materials, shaded with the light and material model
+ *  of the scene shader.  The finished frame is held with
+ *  its rows bottom first, as OpenGL reads them, and can be
+ *  copied into the bound framebuffer or saved to an image.
+ *  The base also runs the jobs that the renderers split the
+ *  work of a frame into on the worker pool they are given.
+ ***********************************************************/
+class RenderBackend : private WorkerPool::Jobs
+{
+public:
+	// the most light sources of the scene shader
+	static const int MAX_LIGHTS = 4;
+	// texture units the frame is read from when it is copied into
+	// OpenGL, which are not used by the scene or the frame graph
+	static const int COLOR_TEXTURE_UNIT = 27;
+	static const int DEPTH_TEXTURE_UNIT = 28;
+
+	// the values of a light source, as set in the scene shader
+	struct LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// the values of an object material, as set in the scene shader
+	struct MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	// constructor
+	RenderBackend();
+	// destructor
+	virtual ~RenderBackend();
+
+	// get the name of the renderer for messages
+	virtual const char* GetName() const = 0;
+	// get ready to draw, with the frames split over the threads of
+	// a pool that outlives the renderer, or drawn on the calling
+	// thread for NULL - returns false when the renderer cannot run
+	// on this machine
+	virtual bool Initialize(WorkerPool* pWorkerPool) = 0;
+	// get the number of threads that draw the frames
+	int GetThreadCount() const { return (NULL != m_pWorkerPool) ? m_pWorkerPool->GetThreadCount() : 1; }
+
+	// free the meshes and textures
+	virtual void Reset() = 0;
+	// keep a copy of the vertex and index data of a mesh - returns
+	// the mesh index
+	virtual int AddMesh(const MeshGenerator::MESH_DATA& meshData) = 0;
+	// add the next finer-to-coarser level of a texture slot from
+	// RGB or RGBA pixels
+	virtual bool AddTextureLevel(int textureSlot, int width, int height, int colorChannels, const unsigned char* pPixels) = 0;
+	// set the values of a light source
+	void SetLight(int light, const LIGHT& values);
+
+	// start a frame at a size, with the view values of the camera
+	virtual void BeginFrame(
+		int width,
+		int height,
+		glm::vec4 clearColor,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec3 viewPosition) = 0;
+	// submit a mesh to draw - blended meshes are drawn over the
+	// frame without writing depth, in the order they are submitted
+	virtual void DrawMesh(
+		int mesh,
+		const glm::mat4& modelMatrix,
+		glm::vec4 color,
+		int textureSlot,
+		const MATERIAL& material,
+		bool bBlended) = 0;
+	// draw the submitted meshes into the frame
+	virtual void EndFrame() = 0;
+
+	// get the size of the frame and the triangles submitted to it
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	size_t GetTriangleCount() const { return m_triangleCount; }
+
+	// copy the frame into the bound draw framebuffer at a corner,
+	// with its depth
+	bool Present(int x, int y);
+	// save the frame as a binary PPM image
+	bool SaveImage(const char* filename) const;
+
+protected:
+	LIGHT m_lights[MAX_LIGHTS];
+
+	// the frame, with a packed RGBA color and a window depth for
+	// each pixel, in rows of a stride that can be wider than the
+	// frame
+	int m_width;
+	int m_height;
+	int m_stride;
+	std::vector<uint32_t> m_colorBuffer;
+	std::vector<float> m_depthBuffer;
+	size_t m_triangleCount;
+
+	// set the pool that the jobs run on
+	void SetWorkerPool(WorkerPool* pWorkerPool);
+	// run a job on every thread and wait for it to finish
+	void RunJob(int job);
+	// run a thread's part of a job, where the jobs are numbered by
+	// the renderer from 1
+	virtual void ExecuteJob(int job, int workerIndex) = 0;
+
+private:
+	// the threads the jobs run on, which belong to the caller
+	WorkerPool* m_pWorkerPool;
+
+	// OpenGL objects for copying the frame into a framebuffer
+	GLuint m_presentProgramID;
+	GLuint m_presentVAO;
+	GLuint m_colorTextureID;
+	GLuint m_depthTextureID;
+	int m_presentWidth;
+	int m_presentHeight;
+
+	// create the OpenGL objects for copying the frame
+	bool CreatePresentObjects();
+	// free the OpenGL objects for copying the frame
+	void DeletePresentObjects();
+};
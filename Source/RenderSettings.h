@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendersettings.h
+// ============
+// rendering options that are toggled from the view manager and
+// read by the scene manager when drawing each frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// range of the render scale, and the step of the scale keys
+const float MIN_RENDER_SCALE = 0.5f;
+const float MAX_RENDER_SCALE = 2.0f;
+const float RENDER_SCALE_STEP = 0.25f;
+
+// the anti-aliasing modes that can be selected
+enum ANTI_ALIASING_MODE
+{
+	AA_OFF,
+	AA_MSAA_2X,
+	AA_MSAA_4X,
+	AA_MSAA_8X,
+	// temporal anti-aliasing, which blends jittered frames
+	AA_TAA,
+	AA_MODE_COUNT
+};
+
+/***********************************************************
+ *  RENDER_SETTINGS
+ *
+ *  This structure contains the options that control how
+ *  the 3D scene is submitted for rendering.  A single
+ *  instance is owned by the main code and shared with the
+ *  view manager and scene manager.  The options are
+ *  written by the main thread and read by the render
+ *  thread, so each one is atomic.
+ ***********************************************************/
+struct RENDER_SETTINGS
+{
+	// lay down the scene depth with a position-only pass before
+	// the shaded pass, so each visible pixel is only shaded once
+	std::atomic<bool> bDepthPrepass{ false };
+	// use GL_EQUAL for the shaded pass after a depth pre-pass -
+	// GL_LEQUAL can be used if the driver does not produce
+	// identical depth values for the two shader programs
+	std::atomic<bool> bDepthEqualTest{ true };
+	// draw the number of shaded fragments per pixel instead
+	// of the lit scene colors
+	std::atomic<bool> bShowOverdraw{ false };
+	// only draw a frame when the view or the scene has changed,
+	// leaving the last presented frame on the display otherwise
+	std::atomic<bool> bRenderOnChange{ true };
+	// split the window into the camera view and top, front
+	// and side views of the scene
+	std::atomic<bool> bMultiViewport{ false };
+	// screen effects applied after the scene is drawn - with
+	// all of them off, the scene is drawn straight to the window
+	std::atomic<bool> bToneMapping{ false };
+	std::atomic<bool> bBloom{ false };
+	std::atomic<bool> bFXAA{ false };
+	// anti-aliasing mode of the scene, from ANTI_ALIASING_MODE
+	std::atomic<int> antiAliasingMode{ AA_OFF };
+	// size the scene is drawn at as a fraction of the window
+	// size - it is scaled to the window after the effects
+	std::atomic<float> renderScale{ 1.0f };
+	// pick objects from the object IDs drawn on the GPU, or by
+	// casting a ray through the object bounds on the CPU
+	std::atomic<bool> bGPUPicking{ true };
+	// cull the objects and pick their level of detail in a compute
+	// shader, or cull them on the CPU
+	std::atomic<bool> bGPUCulling{ false };
+	// also cull the objects culled on the GPU that are hidden
+	// behind the depth of the previous frame
+	std::atomic<bool> bOcclusionCulling{ false };
+	// draw the static objects merged into batches by texture and
+	// material, or each with its own draw
+	std::atomic<bool> bStaticBatching{ true };
+	// draw the static batches with ambient occlusion and diffuse
+	// lighting baked into their vertices, or shade them per pixel
+	std::atomic<bool> bBakedLighting{ true };
+	// draw the scene on the CPU with the software rasterizer, or
+	// with OpenGL
+	std::atomic<bool> bSoftwareRasterizer{ false };
+	// draw the scene with the Vulkan renderer instead, falling back
+	// to the software rasterizer when Vulkan cannot start
+	std::atomic<bool> bVulkanBackend{ false };
+	// draw the opaque objects into a G-buffer and light each pixel
+	// once with the lights of its screen tile, or shade them as
+	// they are drawn
+	std::atomic<bool> bDeferredShading{ false };
+	// blend the reflections of the cached reflection probes over
+	// the glossy objects
+	std::atomic<bool> bReflectionProbes{ true };
+	// draw the heads-up display of the frame rate and the camera
+	// over the finished frame
+	std::atomic<bool> bShowHud{ true };
+	// play the clips of the animated objects, or hold them in the
+	// pose they were in
+	std::atomic<bool> bAnimation{ true };
+
+	// the following options are set before rendering starts
+
+	// number of vertical blanks that each swap waits for
+	int swapInterval = 1;
+	// most frames drawn per second, or 0 for no limit
+	// beyond the swap interval
+	double maxFrameRate = 0.0;
+	// GPU time per frame in seconds that the render scale is
+	// lowered to keep to, or 0 for a fixed render scale
+	double targetFrameTime = 0.0;
+	// megabytes of texture levels that are kept on the GPU, or
+	// 0 for no limit - the coarse levels are always kept
+	int textureBudgetMB = 256;
+	// threads of the worker pool that the software rasterizer,
+	// the Vulkan renderer's recording and the animation updates
+	// share, or 0 for one for each hardware thread
+	int softwareThreadCount = 0;
+	// frames to time the software rasterizer and OpenGL for once
+	// the scene is ready, or 0 for no timing
+	int softwareBenchmarkFrames = 0;
+	// image file that the first software frame is saved to, or
+	// NULL for none
+	const char* softwareImagePath = NULL;
+	// frames to time forward and deferred shading for at each
+	// step of added lights, or 0 for no timing
+	int deferredBenchmarkFrames = 0;
+	// updates to time the animations for at each step of added
+	// animated entities, or 0 for no timing
+	int animationBenchmarkUpdates = 0;
+};
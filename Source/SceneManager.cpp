@@ -8,6 +8,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "GPUResources.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,15 +16,456 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// the uniform names are kept as strings so that setting
+	// them through the shader manager does not allocate
+	const std::string g_ModelName = "model";
+	const std::string g_ViewName = "view";
+	const std::string g_ProjectionName = "projection";
+	const std::string g_ViewPositionName = "viewPosition";
+	const std::string g_ColorValueName = "objectColor";
+	const std::string g_TextureValueName = "objectTexture";
+	const std::string g_UseTextureName = "bUseTexture";
+	const std::string g_UseLightingName = "bUseLighting";
+	const std::string g_UVScaleName = "UVscale";
+	const std::string g_MaterialAmbientColorName = "material.ambientColor";
+	const std::string g_MaterialAmbientStrengthName = "material.ambientStrength";
+	const std::string g_MaterialDiffuseColorName = "material.diffuseColor";
+	const std::string g_MaterialSpecularColorName = "material.specularColor";
+	const std::string g_MaterialShininessName = "material.shininess";
+
+	// number of light sources defined in the shader code
+	const int LIGHT_SOURCE_COUNT = 4;
+
+	// uniform names of the values for one light source
+	struct LIGHT_UNIFORM_NAMES
+	{
+		std::string position;
+		std::string ambientColor;
+		std::string diffuseColor;
+		std::string specularColor;
+		std::string focalStrength;
+		std::string specularIntensity;
+	};
+
+	/***********************************************************
+	 *  MakeLightUniformNames()
+	 *
+	 *  This function is used for building the uniform names
+	 *  of the values for the passed in light source.
+	 ***********************************************************/
+	LIGHT_UNIFORM_NAMES MakeLightUniformNames(int light)
+	{
+		LIGHT_UNIFORM_NAMES names;
+		std::string base = "lightSources[" + std::to_string(light) + "]";
+
+		names.position = base + ".position";
+		names.ambientColor = base + ".ambientColor";
+		names.diffuseColor = base + ".diffuseColor";
+		names.specularColor = base + ".specularColor";
+		names.focalStrength = base + ".focalStrength";
+		names.specularIntensity = base + ".specularIntensity";
+
+		return names;
+	}
+
+	// the light source uniform names are built once at startup
+	const LIGHT_UNIFORM_NAMES g_LightUniformNames[LIGHT_SOURCE_COUNT] =
+	{
+		MakeLightUniformNames(0),
+		MakeLightUniformNames(1),
+		MakeLightUniformNames(2),
+		MakeLightUniformNames(3)
+	};
+
+	// starting size of the memory used for each frame
+	const size_t FRAME_ARENA_CAPACITY = 64 * 1024;
+
+	// number of frames between reports of the shaded fragments
+	const int SHADED_FRAGMENTS_REPORT_FRAMES = 120;
+
+	// the view block after those of the viewports holds the view
+	// values of the pixel that object IDs are drawn for
+	const int PICK_VIEW_BLOCK = MAX_SCENE_VIEWS;
+	// and the one after it holds the view values of the probe face
+	// being captured
+	const int PROBE_VIEW_BLOCK = PICK_VIEW_BLOCK + 1;
+
+	// static objects whose bounds come within this distance of a
+	// reflection probe are captured into it again when they change
+	const float PROBE_RADIUS = 8.0f;
+
+	// longest time in seconds that the animations move on by in a
+	// frame, so a stalled frame does not make them jump
+	const double MAX_ANIMATION_STEP = 0.1;
+
+	// vertex shader shared by the depth pre-pass and the overdraw
+	// view - only the vertex position attribute is read
+	const char* g_PositionOnlyVertexShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"uniform mat4 model;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);\n"
+		"}\n";
+
+	// vertex shader for the objects drawn with the culling commands,
+	// which reads the model matrix of the object selected by the
+	// base instance of its command - follows the GLSL declaration
+	// of the object buffer
+	const char* g_IndirectPositionVertexShader =
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = projection * view * objects[gl_BaseInstance].model * vec4(inVertexPosition, 1.0f);\n"
+		"}\n";
+
+	// fragment shader for the depth pre-pass - color writes are
+	// masked off so nothing needs to be output
+	const char* g_DepthOnlyFragmentShader =
+		"#version 330 core\n"
+		"void main()\n"
+		"{\n"
+		"}\n";
+
+	// fragment shader for the overdraw view - each shaded fragment
+	// adds a small amount of color, so brighter pixels were shaded
+	// more times
+	const char* g_OverdrawFragmentShader =
+		"#version 330 core\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentColor = vec4(0.25f, 0.1f, 0.04f, 1.0f);\n"
+		"}\n";
+
+	// fragment shader for picking - writes the ID of the object,
+	// which is its index plus one so that 0 means no object
+	const char* g_ObjectIDFragmentShader =
+		"#version 330 core\n"
+		"uniform uint objectID;\n"
+		"out uint fragmentID;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentID = objectID;\n"
+		"}\n";
+
+	// directory that baked lighting is cached in, keyed by the
+	// hash of the scene
+	const char* g_BakeCacheDirectory = "BakeCache";
+	// longest edge of the static batches when their lighting is
+	// baked into the vertices, and the most vertices a batch is
+	// split into
+	const float BAKE_MAX_EDGE_LENGTH = 0.5f;
+	const size_t BAKE_MAX_BATCH_VERTICES = 262144;
+
+	// vertex shader for the static batches with baked lighting,
+	// which passes the baked color of each vertex along
+	const char* g_BakedLightingVertexShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (location = 1) in vec3 inVertexNormal;\n"
+		"layout (location = 2) in vec2 inTextureCoordinate;\n"
+		"layout (location = 3) in vec3 inBakedLighting;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"out vec3 fragmentPosition;\n"
+		"out vec3 fragmentNormal;\n"
+		"out vec2 fragmentTextureCoordinate;\n"
+		"out vec3 fragmentLighting;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentPosition = inVertexPosition;\n"
+		"	fragmentNormal = inVertexNormal;\n"
+		"	fragmentTextureCoordinate = inTextureCoordinate;\n"
+		"	fragmentLighting = inBakedLighting;\n"
+		"	gl_Position = projection * view * vec4(inVertexPosition, 1.0f);\n"
+		"}\n";
+
+	// fragment shader for the static batches with baked lighting -
+	// the ambient and diffuse terms come from the vertices, and only
+	// the specular term, which depends on the view, is worked out
+	// here for the lights that have one
+	const char* g_BakedLightingFragmentShader =
+		"#version 330 core\n"
+		"in vec3 fragmentPosition;\n"
+		"in vec3 fragmentNormal;\n"
+		"in vec2 fragmentTextureCoordinate;\n"
+		"in vec3 fragmentLighting;\n"
+		"layout (std140) uniform ViewBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec3 viewPosition;\n"
+		"};\n"
+		"uniform sampler2D objectTexture;\n"
+		"uniform int lightCount;\n"
+		"uniform vec3 lightPositions[4];\n"
+		"uniform vec3 lightSpecularColors[4];\n"
+		"uniform float lightFocalStrengths[4];\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 normal = normalize(fragmentNormal);\n"
+		"	vec3 viewDirection = normalize(viewPosition - fragmentPosition);\n"
+		"	vec3 lighting = fragmentLighting;\n"
+		"	for (int i = 0; i < lightCount; i++)\n"
+		"	{\n"
+		"		vec3 lightDirection = normalize(lightPositions[i] - fragmentPosition);\n"
+		"		vec3 reflectDirection = reflect(-lightDirection, normal);\n"
+		"		float specular = pow(max(dot(viewDirection, reflectDirection), 0.0f), lightFocalStrengths[i]);\n"
+		"		lighting += specular * lightSpecularColors[i];\n"
+		"	}\n"
+		"	vec4 textureColor = texture(objectTexture, fragmentTextureCoordinate);\n"
+		"	fragmentColor = vec4(lighting * textureColor.rgb, 1.0f);\n"
+		"}\n";
+
+	// local corners of the bounding box for each basic shape mesh,
+	// in the same order as the MESH_TYPE values
+	const glm::vec3 g_MeshBoundsMin[] =
+	{
+		glm::vec3(-1.0f, 0.0f, -1.0f),		// plane
+		glm::vec3(-0.5f, -0.5f, -0.5f),		// box
+		glm::vec3(-1.0f, -1.0f, -1.0f),		// sphere
+		glm::vec3(-1.0f, 0.0f, -1.0f),		// cylinder
+		glm::vec3(-1.0f, 0.0f, -1.0f)		// cone
+	};
+	const glm::vec3 g_MeshBoundsMax[] =
+	{
+		glm::vec3(1.0f, 0.0f, 1.0f),		// plane
+		glm::vec3(0.5f, 0.5f, 0.5f),		// box
+		glm::vec3(1.0f, 1.0f, 1.0f),		// sphere
+		glm::vec3(1.0f, 1.0f, 1.0f),		// cylinder
+		glm::vec3(1.0f, 1.0f, 1.0f)			// cone
+	};
+
+	/***********************************************************
+	 *  AddMeshFace()
+	 *
+	 *  This function is used for adding a quad with a normal
+	 *  and texture coordinates from 0 to 1 to mesh data, from
+	 *  its corners in counter-clockwise order.
+	 ***********************************************************/
+	void AddMeshFace(MeshGenerator::MESH_DATA& meshData, const glm::vec3 corners[4], const glm::vec3& normal)
+	{
+		const glm::vec2 uvs[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+		GLuint firstVertex = (GLuint)(meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX);
+
+		for (int i = 0; i < 4; i++)
+		{
+			meshData.vertices.insert(meshData.vertices.end(), {
+				corners[i].x, corners[i].y, corners[i].z,
+				normal.x, normal.y, normal.z,
+				uvs[i].x, uvs[i].y });
+		}
+		meshData.indices.insert(meshData.indices.end(), {
+			firstVertex, firstVertex + 1, firstVertex + 2,
+			firstVertex, firstVertex + 2, firstVertex + 3 });
+	}
+
+	/***********************************************************
+	 *  BuildBasicMeshData()
+	 *
+	 *  This function is used for building the vertex and index
+	 *  data of the plane and box basic shape meshes, with the
+	 *  same extents, normals and texture coordinates, since
+	 *  the basic shape meshes do not keep their data.  The
+	 *  curved basic shapes are not built.
+	 ***********************************************************/
+	bool BuildBasicMeshData(int mesh, MeshGenerator::MESH_DATA& meshData)
+	{
+		const glm::vec3& boundsMin = g_MeshBoundsMin[mesh];
+		const glm::vec3& boundsMax = g_MeshBoundsMax[mesh];
+
+		if (mesh == SceneManager::MESH_PLANE)
+		{
+			// the plane faces up along the Y axis
+			const glm::vec3 corners[4] =
+			{
+				glm::vec3(boundsMin.x, 0.0f, boundsMax.z),
+				glm::vec3(boundsMax.x, 0.0f, boundsMax.z),
+				glm::vec3(boundsMax.x, 0.0f, boundsMin.z),
+				glm::vec3(boundsMin.x, 0.0f, boundsMin.z)
+			};
+			AddMeshFace(meshData, corners, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+		else if (mesh == SceneManager::MESH_BOX)
+		{
+			// each face of the box is a quad seen from outside, with
+			// the first two corners along the bottom of the face
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (int side = 0; side < 2; side++)
+				{
+					glm::vec3 normal(0.0f);
+					normal[axis] = (side == 0) ? -1.0f : 1.0f;
+					int u = (axis + 1) % 3;
+					int v = (axis + 2) % 3;
+					glm::vec3 corners[4];
+					for (int i = 0; i < 4; i++)
+					{
+						bool bHighU = (i == 1) || (i == 2);
+						bool bHighV = (i >= 2);
+						// flip the order on the negative side so the
+						// corners stay counter-clockwise from outside
+						if (side == 0)
+						{
+							std::swap(bHighU, bHighV);
+						}
+						corners[i][axis] = (side == 0) ? boundsMin[axis] : boundsMax[axis];
+						corners[i][u] = bHighU ? boundsMax[u] : boundsMin[u];
+						corners[i][v] = bHighV ? boundsMax[v] : boundsMin[v];
+					}
+					AddMeshFace(meshData, corners, normal);
+				}
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		meshData.boundsMin = boundsMin;
+		meshData.boundsMax = boundsMax;
+
+		return true;
+	}
+
+	/***********************************************************
+	 *  BuildCurvedMeshData()
+	 *
+	 *  This function is used for building stand-ins for the
+	 *  sphere, cylinder and cone basic shape meshes, with the
+	 *  same extents, for drawing them where only their vertex
+	 *  and index data can be used.
+	 ***********************************************************/
+	bool BuildCurvedMeshData(int mesh, MeshGenerator::MESH_DATA& meshData)
+	{
+		const int segments = 32;
+		const int rings = 16;
+
+		if (mesh == SceneManager::MESH_SPHERE)
+		{
+			// a sphere of rings from the top to the bottom, with a
+			// seam of repeated vertices for the texture coordinates
+			for (int ring = 0; ring <= rings; ring++)
+			{
+				float polar = glm::radians(180.0f * (float)ring / (float)rings);
+				for (int segment = 0; segment <= segments; segment++)
+				{
+					float azimuth = glm::radians(360.0f * (float)segment / (float)segments);
+					glm::vec3 normal(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth));
+					meshData.vertices.insert(meshData.vertices.end(), {
+						normal.x, normal.y, normal.z,
+						normal.x, normal.y, normal.z,
+						(float)segment / (float)segments, 1.0f - (float)ring / (float)rings });
+				}
+			}
+			for (int ring = 0; ring < rings; ring++)
+			{
+				for (int segment = 0; segment < segments; segment++)
+				{
+					GLuint a = (GLuint)(ring * (segments + 1) + segment);
+					GLuint b = a + 1;
+					GLuint c = a + segments + 1;
+					GLuint d = c + 1;
+					meshData.indices.insert(meshData.indices.end(), { a, b, c, b, d, c });
+				}
+			}
+			meshData.boundsMin = g_MeshBoundsMin[mesh];
+			meshData.boundsMax = g_MeshBoundsMax[mesh];
+			return true;
+		}
+		else if (mesh == SceneManager::MESH_CYLINDER)
+		{
+			return MeshGenerator::GenerateMeshData(MeshGenerator::Cylinder(segments, 1.0f, 1.0f, 1.0f), meshData);
+		}
+		else if (mesh == SceneManager::MESH_CONE)
+		{
+			return MeshGenerator::GenerateMeshData(MeshGenerator::Cylinder(segments, 1.0f, 0.0f, 1.0f, 0.0f, false, true), meshData);
+		}
+
+		return false;
+	}
+
+	/***********************************************************
+	 *  ExtractFrustumPlanes()
+	 *
+	 *  This function is used for getting the six clipping
+	 *  planes of a view and projection, with the normals
+	 *  pointing into the visible volume.
+	 ***********************************************************/
+	void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int side = 0; side < 2; side++)
+			{
+				float sign = (side == 0) ? 1.0f : -1.0f;
+				glm::vec4 plane;
+				for (int i = 0; i < 4; i++)
+				{
+					plane[i] = viewProjection[i][3] + sign * viewProjection[i][axis];
+				}
+				planes[axis * 2 + side] = plane;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  IsBoxInFrustum()
+	 *
+	 *  This function is used for checking whether a bounding
+	 *  box is at least partly inside the clipping planes.  The
+	 *  corner furthest along each plane normal is tested, so
+	 *  a box is only rejected when it is fully outside.
+	 ***********************************************************/
+	bool IsBoxInFrustum(const glm::vec4 planes[6], const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			glm::vec3 corner(
+				(planes[i].x >= 0.0f) ? boundsMax.x : boundsMin.x,
+				(planes[i].y >= 0.0f) ? boundsMax.y : boundsMin.y,
+				(planes[i].z >= 0.0f) ? boundsMax.z : boundsMin.z);
+			if (planes[i].x * corner.x + planes[i].y * corner.y + planes[i].z * corner.z + planes[i].w < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
 }
 
 /***********************************************************
@@ -31,10 +473,88 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(ShaderManager *pShaderManager) :
+	m_frameArena(FRAME_ARENA_CAPACITY)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_loadedTextures = 0;
+	m_bSceneChanged = true;
+	m_pRenderSettings = NULL;
+	m_sceneViewCount = 0;
+	m_viewBlockBufferID = 0;
+	m_viewBlockStride = 0;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_viewPixelScale = 0.0f;
+	m_bOrthographicView = false;
+	m_depthProgramID = 0;
+	m_overdrawProgramID = 0;
+	m_pickProgramID = 0;
+	m_bGPUCullerDirty = true;
+	m_bGPUCulling = false;
+	m_bOcclusionCulling = false;
+	m_cullTotals = {};
+	m_cullFrameCount = 0;
+	m_currentView = 0;
+	m_indirectDepthProgramID = 0;
+	m_indirectOverdrawProgramID = 0;
+	m_bPickHierarchyDirty = true;
+	m_bPickPending = false;
+	m_pickView = 0;
+	m_pickPixel = glm::vec2(0.0f);
+	m_selectedObject = -1;
+	m_currentGroup = -1;
+	m_samplesQueryID = 0;
+	m_bSamplesQueryActive = false;
+	m_shadedFragments = 0;
+	m_shadedFrameCount = 0;
+	m_pShaderCache = NULL;
+	m_shaderGeneration = 0;
+	m_boundPermutation = -1;
+	m_frameIndex = 0;
+	m_opaqueQueue.pPackets = NULL;
+	m_opaqueQueue.count = 0;
+	m_blendedQueue.pPackets = NULL;
+	m_blendedQueue.count = 0;
+	m_batchQueue.pPackets = NULL;
+	m_batchQueue.count = 0;
+	m_bStaticBatchesDirty = true;
+	m_bStaticBatching = false;
+	m_bGPUCullerBatched = false;
+	m_bAddStaticObjects = true;
+	m_pSceneBackend = NULL;
+	m_bBackendSceneDirty = true;
+	m_bSoftwareThreadsStarted = false;
+	m_bVulkanStarted = false;
+	m_bVulkanFailed = false;
+	m_addAnimationClip = -1;
+	m_addAnimationPivot = glm::vec3(0.0f);
+	m_animationTime = 0.0;
+	m_bAnimationClockRunning = false;
+	m_bAnimationsMoving = false;
+	m_animationSystem.SetWorkerPool(&m_workerPool);
+	for (int i = 0; i < RenderBackend::MAX_LIGHTS; i++)
+	{
+		m_lightSources[i] = {};
+	}
+	m_plainMaterial.ambientStrength = 0.1f;
+	m_plainMaterial.ambientColor = glm::vec3(1.0f);
+	m_plainMaterial.diffuseColor = glm::vec3(1.0f);
+	m_plainMaterial.specularColor = glm::vec3(0.5f);
+	m_plainMaterial.shininess = 1.0f;
+	m_plainMaterial.reflectivity = 0.0f;
+	m_bReflectionProbes = false;
+	m_bakedProgramID = 0;
+	m_bBakedLighting = false;
+	m_bStaticBatchesBaked = false;
+	m_shadingPath = SHADING_FORWARD;
+	for (int i = 0; i < ShaderCache::PERMUTATION_COUNT; i++)
+	{
+		m_permutationFrame[i] = -1;
+		m_bPermutationLightsSet[i] = false;
+	}
 }
 
 /***********************************************************
@@ -45,82 +565,125 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	m_pRenderSettings = NULL;
+	m_pShaderCache = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+
+	// free the programs and query used by the extra render passes
+	DeleteTrackedProgram(m_depthProgramID);
+	DeleteTrackedProgram(m_overdrawProgramID);
+	DeleteTrackedProgram(m_pickProgramID);
+	DeleteTrackedProgram(m_bakedProgramID);
+	DeleteTrackedProgram(m_indirectDepthProgramID);
+	DeleteTrackedProgram(m_indirectOverdrawProgramID);
+	if (0 != m_samplesQueryID)
+	{
+		glDeleteQueries(1, &m_samplesQueryID);
+		m_samplesQueryID = 0;
+	}
+	DeleteTrackedBuffer(m_viewBlockBufferID);
+
+	// free the loaded scene textures
+	DestroyGLTextures();
 }
 
 /***********************************************************
- *  CreateGLTexture()
+ *  SetRenderSettings()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for setting the options that control
+ *  how the 3D scene is rendered.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+void SceneManager::SetRenderSettings(RENDER_SETTINGS* pRenderSettings)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
+	m_pRenderSettings = pRenderSettings;
+
+	// the worker threads are started once, before anything is
+	// split over them
+	m_workerPool.Start((NULL != pRenderSettings) ? pRenderSettings->softwareThreadCount : 0);
+}
+
+/***********************************************************
+ *  SetShaderCache()
+ *
+ *  This method is used for setting the cache that provides
+ *  the specialized shader programs.  Without a cache, the
+ *  single program loaded by the shader manager is used.
+ ***********************************************************/
+void SceneManager::SetShaderCache(ShaderCache* pShaderCache)
+{
+	m_pShaderCache = pShaderCache;
+}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+/***********************************************************
+ *  SetSceneViews()
+ *
+ *  This method is used for setting the viewports that the
+ *  current frame is drawn into, with the view values that
+ *  each one is sorted, culled and shaded with.
+ ***********************************************************/
+void SceneManager::SetSceneViews(const SCENE_VIEW* pSceneViews, int sceneViewCount)
+{
+	m_sceneViewCount = std::min(sceneViewCount, MAX_SCENE_VIEWS);
+	for (int i = 0; i < m_sceneViewCount; i++)
+	{
+		m_sceneViews[i] = pSceneViews[i];
+	}
+}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+/***********************************************************
+ *  HasSceneChanged()
+ *
+ *  This method is used for checking whether the scene needs
+ *  to be drawn again for an unchanged view, because scene
+ *  objects were changed or the shader programs were rebuilt.
+ *  A picked object ID that has not been read back also
+ *  needs another frame, which is where it is collected, and
+ *  so do textures that are still streaming in finer levels
+ *  and reflection probes that are still to be captured, and
+ *  animations whose clips are still moving.
+ ***********************************************************/
+bool SceneManager::HasSceneChanged() const
+{
+	if (m_bSceneChanged || m_objectPicker.IsReadbackPending() || m_textureStreamer.IsStreaming())
+	{
+		return(true);
+	}
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bReflectionProbes && (m_reflectionProbes.FindDirtyProbe() >= 0))
+	{
+		return(true);
+	}
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bAnimation && m_bAnimationsMoving)
+	{
+		return(true);
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	return((NULL != m_pShaderCache) && (m_pShaderCache->GetGeneration() != m_shaderGeneration));
+}
 
-		return true;
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for loading textures from image files
+ *  into the next available texture slot in memory.  Only the
+ *  coarse mipmaps are uploaded here, and the finer ones are
+ *  streamed in once objects are drawn large enough to need
+ *  them.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+{
+	int textureIndex = m_textureStreamer.LoadTexture(filename);
+	if (textureIndex < 0)
+	{
+		return false;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the loaded texture and associate it with the special tag string
+	m_textureIDs[m_loadedTextures].ID = m_textureStreamer.GetTextureID(textureIndex);
+	m_textureIDs[m_loadedTextures].tag = tag;
+	m_loadedTextures++;
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
@@ -147,10 +710,12 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
+	m_textureStreamer.DeleteTextures();
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].ID = 0;
 	}
+	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -159,7 +724,7 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(std::string_view tag)
 {
 	int textureID = -1;
 	int index = 0;
@@ -185,7 +750,7 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(std::string_view tag)
 {
 	int textureSlot = -1;
 	int index = 0;
@@ -206,30 +771,22 @@ int SceneManager::FindTextureSlot(std::string tag)
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  FindMaterialIndex()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for getting the index in the defined
+ *  materials list of the material associated with the
+ *  passed in tag, or -1 if there is no such material.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+int SceneManager::FindMaterialIndex(std::string_view tag)
 {
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
 	int index = 0;
 	bool bFound = false;
+
 	while ((index < m_objectMaterials.size()) && (bFound == false))
 	{
 		if (m_objectMaterials[index].tag.compare(tag) == 0)
 		{
 			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
 		}
 		else
 		{
@@ -237,6 +794,36 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 		}
 	}
 
+	if (bFound == false)
+	{
+		return(-1);
+	}
+
+	return(index);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting a material from the previously
+ *  defined materials list that is associated with the passed in tag.
+ ***********************************************************/
+bool SceneManager::FindMaterial(std::string_view tag, OBJECT_MATERIAL& material)
+{
+	int index = FindMaterialIndex(tag);
+
+	if (index < 0)
+	{
+		return(false);
+	}
+
+	material.ambientColor = m_objectMaterials[index].ambientColor;
+	material.ambientStrength = m_objectMaterials[index].ambientStrength;
+	material.diffuseColor = m_objectMaterials[index].diffuseColor;
+	material.specularColor = m_objectMaterials[index].specularColor;
+	material.shininess = m_objectMaterials[index].shininess;
+	material.reflectivity = m_objectMaterials[index].reflectivity;
+
 	return(true);
 }
 
@@ -255,6 +842,34 @@ void SceneManager::SetTransformations(
 {
 	// variables for this method
 	glm::mat4 modelView;
+
+	modelView = CalculateModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+	}
+}
+
+/***********************************************************
+ *  CalculateModelMatrix()
+ *
+ *  This method is used for calculating the model matrix
+ *  from the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::CalculateModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
 	glm::mat4 scale;
 	glm::mat4 rotationX;
 	glm::mat4 rotationY;
@@ -270,12 +885,7 @@ void SceneManager::SetTransformations(
 	// set the translation value in the transform buffer
 	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	return(translation * rotationX * rotationY * rotationZ * scale);
 }
 
 /***********************************************************
@@ -309,18 +919,27 @@ void SceneManager::SetShaderColor(
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in tag into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	std::string_view textureTag)
+{
+	SetShaderTextureSlot(FindTextureSlot(textureTag));
+}
+
+/***********************************************************
+ *  SetShaderTextureSlot()
+ *
+ *  This method is used for setting the texture data in the
+ *  passed in texture slot into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTextureSlot(
+	int textureSlot)
 {
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot);
 	}
 }
 
@@ -334,7 +953,7 @@ void SceneManager::SetTextureUVScale(float u, float v)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pShaderManager->setVec2Value(g_UVScaleName, glm::vec2(u, v));
 	}
 }
 
@@ -342,321 +961,2823 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  SetShaderMaterial()
  *
  *  This method is used for passing the material values
- *  into the shader.
+ *  associated with the passed in tag into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
- /***********************************************************
-  *  DefineObjectMaterials() -MK
-  *
-  *  This method is used for configuring the various material
-  *  settings for all of the objects within the 3D scene.
-  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+	std::string_view materialTag)
 {
-	// Define materials for the objects in the scene -MK
-	OBJECT_MATERIAL lampShadeMaterial;
-	lampShadeMaterial.ambientColor = glm::vec3(0.6f, 0.6f, 0.4f);
-	lampShadeMaterial.ambientStrength = 0.4f;
-	lampShadeMaterial.diffuseColor = glm::vec3(0.9f, 0.9f, 0.7f);
-	lampShadeMaterial.specularColor = glm::vec3(1.0f, 1.0f, 0.9f);
-	lampShadeMaterial.shininess = 40.0;
-	lampShadeMaterial.tag = "lampShade";
-	m_objectMaterials.push_back(lampShadeMaterial);
+	SetShaderMaterialIndex(FindMaterialIndex(materialTag));
 }
 
 /***********************************************************
- *  SetupSceneLights() -MK
+ *  SetShaderMaterialIndex()
  *
- *  This method is used for setting up the scene lights
- *  in the shader.  The light sources are defined in the
- *  shader code.
+ *  This method is used for passing the values of the
+ *  material at the passed in index into the shader.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+void SceneManager::SetShaderMaterialIndex(
+	int materialIndex)
 {
-	// Light from above -MK
-	m_pShaderManager->setVec3Value("lightSources[0].position", 0.0f, 10.0f, -10.0f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", -1.05f, -1.05f, -1.02f); // subtle ambient light -MK
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.25f, 0.25f, 0.12f); // yellowish diffuse light -MK
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.9f, 0.9f, 0.8f);
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 25.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 3.0f);
-
-	// Second Light -MK
-	m_pShaderManager->setVec3Value("lightSources[1].position", 0.0f, 5.0f, -10.0f);
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.02f, 0.02f, 0.08f);   // subtle blue ambient -MK
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.2f, 0.2f, 0.9f);      // blue light -MK
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.6f, 0.6f, 1.0f);     // bluish highlights -MK
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 15.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 2.5f);
-
-	// Prevents unused light sources from affecting the scene -MK
-	// Was not able to move the light position without this, so this is a workaround -MK
-	for (int i = 2; i < 4; ++i) {
-		std::string base = "lightSources[" + std::to_string(i) + "]";
-		m_pShaderManager->setVec3Value((base + ".position").c_str(), 0.0f, 7.0f, -7.0f);
-		m_pShaderManager->setVec3Value((base + ".ambientColor").c_str(), 0.0f, 0.0f, 0.0f);
-		m_pShaderManager->setVec3Value((base + ".diffuseColor").c_str(), 0.0f, 0.0f, 0.0f);
-		m_pShaderManager->setVec3Value((base + ".specularColor").c_str(), 0.0f, 0.0f, 0.0f);
-		m_pShaderManager->setFloatValue((base + ".focalStrength").c_str(), 0.0f);
-		m_pShaderManager->setFloatValue((base + ".specularIntensity").c_str(), 0.0f);
+	if ((NULL == m_pShaderManager) ||
+		(materialIndex < 0) ||
+		(materialIndex >= (int)m_objectMaterials.size()))
+	{
+		return;
 	}
-	
-	// Enable lighting system -MK
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+
+	const OBJECT_MATERIAL& material = m_objectMaterials[materialIndex];
+	m_pShaderManager->setVec3Value(g_MaterialAmbientColorName, material.ambientColor);
+	m_pShaderManager->setFloatValue(g_MaterialAmbientStrengthName, material.ambientStrength);
+	m_pShaderManager->setVec3Value(g_MaterialDiffuseColorName, material.diffuseColor);
+	m_pShaderManager->setVec3Value(g_MaterialSpecularColorName, material.specularColor);
+	m_pShaderManager->setFloatValue(g_MaterialShininessName, material.shininess);
 }
 
 /***********************************************************
- *  PrepareScene()
+ *  SetLightSource()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for passing the values of one of the
+ *  light sources defined in the shader code into the shader.
  ***********************************************************/
-void SceneManager::PrepareScene()
+void SceneManager::SetLightSource(
+	int light,
+	glm::vec3 position,
+	glm::vec3 ambientColor,
+	glm::vec3 diffuseColor,
+	glm::vec3 specularColor,
+	float focalStrength,
+	float specularIntensity)
 {
+	if ((light < 0) || (light >= LIGHT_SOURCE_COUNT))
+	{
+		return;
+	}
 
-	// define the materials for objects in the scene -MK
-	DefineObjectMaterials();
-	// add and define the light sources for the scene -MK
-	SetupSceneLights();
-
-	// Load scene geometry
-	m_basicMeshes->LoadPlaneMesh();
-	CreateGLTexture("Green_Mouse_Texture.jpg", "mouse");
-	BindGLTextures();
-
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
-	m_basicMeshes->LoadPlaneMesh();
-
-	// Load texture images and tag -MK
-	CreateGLTexture("Green_Mouse_Texture.jpg", "mouse");
-
-	// Load texture for lamp -MK
-	CreateGLTexture("metal_Texture.jpg", "lamp");
-
-	// Load textures for the desk -MK
-	CreateGLTexture("wood.jpg", "desk");
+	// the baked lighting has to be baked again when a term that
+	// it holds changes, and the probes captured with the light
+	// when anything about it changes
+	RenderBackend::LIGHT& lightSource = m_lightSources[light];
+	if (m_bStaticBatchesBaked &&
+		((lightSource.position != position) ||
+		(lightSource.ambientColor != ambientColor) ||
+		(lightSource.diffuseColor != diffuseColor)))
+	{
+		m_bStaticBatchesDirty = true;
+	}
+	if ((lightSource.position != position) ||
+		(lightSource.ambientColor != ambientColor) ||
+		(lightSource.diffuseColor != diffuseColor) ||
+		(lightSource.specularColor != specularColor) ||
+		(lightSource.focalStrength != focalStrength) ||
+		(lightSource.specularIntensity != specularIntensity))
+	{
+		m_reflectionProbes.InvalidateAll();
+	}
+	lightSource.position = position;
+	lightSource.ambientColor = ambientColor;
+	lightSource.diffuseColor = diffuseColor;
+	lightSource.specularColor = specularColor;
+	lightSource.focalStrength = focalStrength;
+	lightSource.specularIntensity = specularIntensity;
+
+	// the renderers outside of the OpenGL context shade with the
+	// same lights
+	m_softwareRasterizer.SetLight(light, lightSource);
+	m_vulkanRenderer.SetLight(light, lightSource);
+
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
 
-	// Bind the loaded textures to OpenGL texture slots -MK
-	BindGLTextures();
+	const LIGHT_UNIFORM_NAMES& names = g_LightUniformNames[light];
+	m_pShaderManager->setVec3Value(names.position, position);
+	m_pShaderManager->setVec3Value(names.ambientColor, ambientColor);
+	m_pShaderManager->setVec3Value(names.diffuseColor, diffuseColor);
+	m_pShaderManager->setVec3Value(names.specularColor, specularColor);
+	m_pShaderManager->setFloatValue(names.focalStrength, focalStrength);
+	m_pShaderManager->setFloatValue(names.specularIntensity, specularIntensity);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  AddSceneObject()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for adding an object to the list of
+ *  objects that are drawn in the 3D scene.  An empty texture
+ *  tag draws the object with the passed in color.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::AddSceneObject(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	std::string_view textureTag,
+	std::string_view materialTag,
+	int meshIndex)
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(16.0f, 5.0f, 7.0f); // Adjust the scale for 3D desk -MK
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(.0f, 0.0f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
+	SCENE_OBJECT object;
+	glm::vec3 localBoundsMin;
+	glm::vec3 localBoundsMax;
+
+	// generated and imported meshes keep their own bounding box
+	if ((mesh == MESH_GENERATED) || (mesh == MESH_IMPORTED))
+	{
+		if (meshIndex < 0)
+		{
+			return;
+		}
+		const MeshGenerator::MESH_BUFFERS& buffers = (mesh == MESH_GENERATED) ?
+			m_meshGenerator.GetMesh(meshIndex).buffers :
+			m_meshImporter.GetMesh(meshIndex);
+		localBoundsMin = buffers.boundsMin;
+		localBoundsMax = buffers.boundsMax;
+	}
+	else
+	{
+		localBoundsMin = g_MeshBoundsMin[mesh];
+		localBoundsMax = g_MeshBoundsMax[mesh];
+	}
+
+	object.mesh = mesh;
+	object.meshIndex = meshIndex;
+	object.modelMatrix = CalculateModelMatrix(
 		scaleXYZ,
 		XrotationDegrees,
 		YrotationDegrees,
 		ZrotationDegrees,
 		positionXYZ);
+	object.color = color;
+	object.textureSlot = textureTag.empty() ? -1 : FindTextureSlot(textureTag);
+	object.materialIndex = materialTag.empty() ? -1 : FindMaterialIndex(materialTag);
+	object.bBlended = (color.a < 1.0f);
+	object.groupIndex = m_currentGroup;
+	object.cullIndex = -1;
+	// an animated object would be frozen in the pose it was merged
+	// in, so it keeps its own draws
+	object.bStatic = m_bAddStaticObjects && (m_addAnimationClip < 0);
+	object.batchIndex = -1;
+
+	// transform the mesh bounding box into world space
+	EntityRegistry::TransformBounds(object.modelMatrix, localBoundsMin, localBoundsMax, object.boundsMin, object.boundsMax);
+
+	// the entity of the object keeps its transform and bounds,
+	// which its clip moves when it has one
+	object.entity = m_entityRegistry.CreateEntity();
+	m_entityRegistry.GetTransforms().Add(object.entity, EntityRegistry::RestTransform(object.modelMatrix, m_addAnimationPivot));
+	RENDERABLE_COMPONENT renderable;
+	renderable.objectIndex = (int)m_sceneObjects.size();
+	renderable.localBoundsMin = localBoundsMin;
+	renderable.localBoundsMax = localBoundsMax;
+	renderable.boundsMin = object.boundsMin;
+	renderable.boundsMax = object.boundsMax;
+	m_entityRegistry.GetRenderables().Add(object.entity, renderable);
+	if (m_addAnimationClip >= 0)
+	{
+		ANIMATION_COMPONENT animation;
+		animation.clip = m_addAnimationClip;
+		animation.speed = 1.0f;
+		animation.timeOffset = 0.0f;
+		animation.clipTime = -1.0f;
+		m_entityRegistry.GetAnimations().Add(object.entity, animation);
+	}
 
-	SetShaderColor(1, 1, 1, 1);
+	// the object only moves between the opaque and blended
+	// passes when it is changed, so the lists are kept
+	if (object.bBlended)
+	{
+		m_blendedObjects.push_back((int)m_sceneObjects.size());
+	}
+	else
+	{
+		m_opaqueObjects.push_back((int)m_sceneObjects.size());
+	}
 
-	SetShaderTexture("desk"); // Apply wood texture -MK
+	// the probes near a static object show it in their capture,
+	// and a reflective object reads from the nearest probe
+	if (object.bStatic)
+	{
+		m_reflectionProbes.InvalidateBounds(object.boundsMin, object.boundsMax);
+	}
+	if ((false == object.bBlended) && (GetObjectMaterial(object.materialIndex).reflectivity > 0.0f))
+	{
+		glm::vec3 center = (object.boundsMin + object.boundsMax) * 0.5f;
+		m_reflectiveObjects.push_back({ (int)m_sceneObjects.size(), m_reflectionProbes.FindNearestProbe(center) });
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	
-	// ***START OF LAPTOP***
+	m_sceneObjects.push_back(object);
+	m_bSceneChanged = true;
+	m_bPickHierarchyDirty = true;
+	m_bGPUCullerDirty = true;
+	m_bStaticBatchesDirty = true;
+	m_bBackendSceneDirty = true;
+}
 
-	// Load the box mesh for the laptop -MK
-	m_basicMeshes->LoadBoxMesh(); 
+/***********************************************************
+ *  BeginObjectGroup()
+ *
+ *  This method is used for naming the group that the objects
+ *  added after it belong to, so that picking any part of a
+ *  model reports the whole model.
+ ***********************************************************/
+void SceneManager::BeginObjectGroup(const char* name)
+{
+	m_currentGroup = (int)m_objectGroups.size();
+	m_objectGroups.push_back(name);
+}
 
-	 // Laptop Base -MK
-	glm::vec3 baseScale = glm::vec3(9.0f, 0.4f, 6.0f); // Adjust size -MK
-	glm::vec3 basePosition = glm::vec3(0.0f, 0.2f, 0.0f); //Adjust position -MK
+/***********************************************************
+ *  SetObjectsStatic()
+ *
+ *  This method is used for marking the objects added after
+ *  it as static, so that they can be merged into batches,
+ *  or as dynamic, so that they keep their own draws.
+ ***********************************************************/
+void SceneManager::SetObjectsStatic(bool bStatic)
+{
+	m_bAddStaticObjects = bStatic;
+}
 
-	SetTransformations(baseScale, 0.0f, 0.0f, 0.0f, basePosition);
-	SetShaderColor(0.2f, 0.3f, 0.2f, 1.0f); // Dark green color -MK
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  SetObjectAnimation()
+ *
+ *  This method is used for playing a clip of the animation
+ *  system on the objects added after it, which turn and
+ *  scale about a pivot in world space.  The objects move
+ *  every frame, so they are kept out of the static batches.
+ ***********************************************************/
+void SceneManager::SetObjectAnimation(int clip, glm::vec3 pivot)
+{
+	m_addAnimationClip = ((clip >= 0) && (clip < m_animationSystem.GetClipCount())) ? clip : -1;
+	m_addAnimationPivot = pivot;
+}
 
-	// Laptop Screen -MK
-	glm::vec3 screenScale = glm::vec3(9.0f, 6.0f, 0.2f); //Adjust size -MK
-	glm::vec3 screenPosition = glm::vec3(0.0f, 3.2f, -2.6f); //Adjust position -MK
+/***********************************************************
+ *  AddGeneratedObject()
+ *
+ *  This method is used for adding an object that is drawn
+ *  with a generated shape mesh.  Objects with the same
+ *  shape parameters share one cached mesh.
+ ***********************************************************/
+void SceneManager::AddGeneratedObject(
+	const MeshGenerator::SHAPE_PARAMETERS& shape,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	std::string_view textureTag,
+	std::string_view materialTag)
+{
+	AddSceneObject(MESH_GENERATED,
+		scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ,
+		color, textureTag, materialTag,
+		m_meshGenerator.FindOrCreateMesh(shape));
+}
 
-	SetTransformations(screenScale, -15.0f, 0.0f, 0.0f, screenPosition);
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black screen frame -MK
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  AddImportedObject()
+ *
+ *  This method is used for adding an object that is drawn
+ *  with a mesh from a model file.  If the model file is
+ *  missing or cannot be imported, the object is drawn with
+ *  the fallback basic shape mesh instead.
+ ***********************************************************/
+void SceneManager::AddImportedObject(
+	const char* modelPath,
+	MESH_TYPE fallbackMesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	std::string_view textureTag,
+	std::string_view materialTag)
+{
+	int meshIndex = m_meshImporter.LoadModel(modelPath);
 
-	// Laptop Screen Display -MK
-	glm::vec3 displayScale = glm::vec3(8.4f, 5.4f, 0.1f); // Adjust size -MK
-	glm::vec3 displayPosition = glm::vec3(0.0f, 3.2f, -2.64f); // Adjust position -MK
+	AddSceneObject((meshIndex >= 0) ? MESH_IMPORTED : fallbackMesh,
+		scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ,
+		color, textureTag, materialTag,
+		meshIndex);
+}
 
-	SetTransformations(displayScale, -15.0f, 0.0f, 0.0f, displayPosition);
-	SetShaderColor(0.1f, 0.3f, 0.8f, 1.0f); // Blue screen color -MK
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  CreatePassPrograms()
+ *
+ *  This method is used for compiling the shader programs
+ *  used by the depth pre-pass, the overdraw view and the
+ *  object ID picking.  Without the ID program or target,
+ *  objects are picked on the CPU instead.
+ ***********************************************************/
+bool SceneManager::CreatePassPrograms()
+{
+	m_depthProgramID = ShaderCache::CompileProgram(
+		g_PositionOnlyVertexShader,
+		g_DepthOnlyFragmentShader);
+	m_overdrawProgramID = ShaderCache::CompileProgram(
+		g_PositionOnlyVertexShader,
+		g_OverdrawFragmentShader);
+	m_pickProgramID = ShaderCache::CompileProgram(
+		g_PositionOnlyVertexShader,
+		g_ObjectIDFragmentShader);
+	if ((0 != m_pickProgramID) && (false == m_objectPicker.Initialize()))
+	{
+		DeleteTrackedProgram(m_pickProgramID);
+	}
+	m_bakedProgramID = ShaderCache::CompileProgram(
+		g_BakedLightingVertexShader,
+		g_BakedLightingFragmentShader);
+	glGenQueries(1, &m_samplesQueryID);
+
+	// the objects are culled on the CPU when the culling program
+	// or the programs that draw with its commands are missing
+	if (m_gpuCuller.Initialize())
+	{
+		std::string indirectVertexShader = std::string("#version 460 core\n") +
+			GPUCuller::OBJECT_BUFFER_SOURCE + g_IndirectPositionVertexShader;
+		m_indirectDepthProgramID = ShaderCache::CompileProgram(
+			indirectVertexShader.c_str(),
+			g_DepthOnlyFragmentShader);
+		m_indirectOverdrawProgramID = ShaderCache::CompileProgram(
+			indirectVertexShader.c_str(),
+			g_OverdrawFragmentShader);
+		m_depthPyramid.Initialize();
+	}
 
-	// Small Touchpad -MK
-	glm::vec3 touchpadScale = glm::vec3(1.6f, 0.1f, 1.2f); // Adjust size -MK
-	glm::vec3 touchpadPosition = glm::vec3(0.0f, 0.44f, 1.6f); // Adjust position -MK
+	// the opaque objects are shaded forward when the G-buffer
+	// programs are missing, and the reflective objects are drawn
+	// without reflections when the probe programs are
+	m_deferredRenderer.Initialize();
+	m_reflectionProbes.Initialize();
 
-	SetTransformations(touchpadScale, 0.0f, 0.0f, 0.0f, touchpadPosition);
-	SetShaderColor(0.3f, 0.3f, 0.3f, 1.0f); // Gray touchpad color -MK
-	m_basicMeshes->DrawBoxMesh();
+	return((0 != m_depthProgramID) && (0 != m_overdrawProgramID));
+}
 
-	// Keyboard -MK
-	glm::vec3 keyboardScale = glm::vec3(7.0f, 0.1f, 2.4f); // Adjust size -MK
-	glm::vec3 keyboardPosition = glm::vec3(0.0f, 0.44f, -1.0f); // Adjust position -MK
+/***********************************************************
+ *  CreateViewBlockBuffer()
+ *
+ *  This method is used for creating the uniform buffer that
+ *  holds the view block of every viewport, and one more
+ *  each for picking and for capturing reflection probes.
+ *  Each block starts on the offset alignment of the
+ *  driver, so that a viewport can bind its own range of
+ *  the buffer.
+ ***********************************************************/
+void SceneManager::CreateViewBlockBuffer()
+{
+	GLint offsetAlignment = 0;
 
-	SetTransformations(keyboardScale, 0.0f, 0.0f, 0.0f, keyboardPosition);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark colored keyboard -MK
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	offsetAlignment = std::max(offsetAlignment, 1);
+	m_viewBlockStride = (((GLint)sizeof(VIEW_BLOCK) + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
 
-	m_basicMeshes->DrawBoxMesh();
+	m_viewBlockBufferID = GenTrackedBuffer("view blocks");
+	glBindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, m_viewBlockStride * (PROBE_VIEW_BLOCK + 1), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	SetTrackedResourceSize(GPU_RESOURCE_BUFFER, m_viewBlockBufferID, m_viewBlockStride * (PROBE_VIEW_BLOCK + 1));
+}
 
-	// ***END OF LAPTOP***
+/***********************************************************
+ *  UploadViewBlocks()
+ *
+ *  This method is used for copying the view values of all
+ *  of the viewports into the view block buffer with a
+ *  single update for the frame.
+ ***********************************************************/
+void SceneManager::UploadViewBlocks()
+{
+	if ((0 == m_viewBlockBufferID) || (0 == m_sceneViewCount))
+	{
+		return;
+	}
 
+	// the blocks are laid out in the frame arena and copied at once
+	unsigned char* pBlocks = static_cast<unsigned char*>(
+		m_frameArena.Allocate((size_t)m_viewBlockStride * m_sceneViewCount, alignof(VIEW_BLOCK)));
+	for (int i = 0; i < m_sceneViewCount; i++)
+	{
+		VIEW_BLOCK* pBlock = (VIEW_BLOCK*)(pBlocks + (size_t)m_viewBlockStride * i);
+		pBlock->view = m_sceneViews[i].view;
+		pBlock->projection = m_sceneViews[i].projection;
+		pBlock->viewPosition = glm::vec4(m_sceneViews[i].viewPosition, 1.0f);
+	}
 
-	// ***START OF MOUSE***
+	glBindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)m_viewBlockStride * m_sceneViewCount, pBlocks);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-	// Load a sphere for the mouse shape -MK
-	m_basicMeshes->LoadSphereMesh();
+/***********************************************************
+ *  SortRenderQueues()
+ *
+ *  This method is used for sorting the scene objects that
+ *  are visible in the viewport being drawn into the draw
+ *  queues.  Opaque objects are drawn front-to-back so that
+ *  hidden fragments fail the early depth test, and blended
+ *  objects are drawn back-to-front so that they composite
+ *  correctly.  The opaque and blended object lists and the
+ *  world bounds are shared by every viewport, so only the
+ *  culling and sort keys are worked out for each one.
+ ***********************************************************/
+void SceneManager::SortRenderQueues(int scenePasses)
+{
+	// the packets only live for this frame, so they come from the
+	// frame arena rather than the heap
+	m_opaqueQueue.pPackets = m_frameArena.AllocateArray<RENDER_PACKET>(m_opaqueObjects.size());
+	m_opaqueQueue.count = 0;
+	m_blendedQueue.pPackets = m_frameArena.AllocateArray<RENDER_PACKET>(m_blendedObjects.size());
+	m_blendedQueue.count = 0;
+	m_batchQueue.pPackets = NULL;
+	m_batchQueue.count = 0;
+
+	// the static batches are opaque, and are culled and sorted by
+	// the bounds of everything merged into them
+	if (m_bStaticBatching && (0 != (scenePasses & SCENE_PASS_OPAQUE)))
+	{
+		m_batchQueue.pPackets = m_frameArena.AllocateArray<RENDER_PACKET>(m_staticBatcher.GetBatchCount());
+		for (int i = 0; i < m_staticBatcher.GetBatchCount(); i++)
+		{
+			const StaticBatcher::STATIC_BATCH& batch = m_staticBatcher.GetBatch(i);
+			if (false == IsBoxInFrustum(m_frustumPlanes, batch.buffers.boundsMin, batch.buffers.boundsMax))
+			{
+				continue;
+			}
+
+			glm::vec3 center = (batch.buffers.boundsMin + batch.buffers.boundsMax) * 0.5f;
+			RENDER_PACKET& packet = m_batchQueue.pPackets[m_batchQueue.count++];
+			packet.objectIndex = i;
+			packet.viewDepth = -(m_viewMatrix * glm::vec4(center, 1.0f)).z;
+
+			if (batch.textureSlot >= 0)
+			{
+				RequestTextureLevel(batch.textureSlot, batch.buffers.boundsMin, batch.buffers.boundsMax, packet.viewDepth);
+			}
+		}
+	}
 
-	// Mouse body -MK
-	glm::vec3 mouseScale = glm::vec3(1.2f, 0.6f, 2.0f);  // Adjust size -MK
-	glm::vec3 mousePosition = glm::vec3(7.0f, 0.35f, 2.0f); // Adjust position -MK
+	RENDER_QUEUE* queues[2] = { &m_opaqueQueue, &m_blendedQueue };
+	const std::vector<int>* objectLists[2] = { &m_opaqueObjects, &m_blendedObjects };
+	const int listPasses[2] = { SCENE_PASS_OPAQUE, SCENE_PASS_BLENDED };
+	for (int list = 0; list < 2; list++)
+	{
+		if (0 == (scenePasses & listPasses[list]))
+		{
+			continue;
+		}
 
-	SetTransformations(mouseScale, 0.0f, 0.0f, 0.0f, mousePosition);
-	SetShaderTexture("mouse"); // Apply green texture -MK
-	m_basicMeshes->DrawSphereMesh();
+		RENDER_QUEUE& queue = *queues[list];
+		const std::vector<int>& objects = *objectLists[list];
+		for (size_t i = 0; i < objects.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[objects[i]];
+
+			// the objects merged into the batches are drawn with them
+			if (m_bStaticBatching && (object.batchIndex >= 0))
+			{
+				continue;
+			}
+
+			// the objects culled on the GPU only ask for their
+			// texture level, without a frustum test
+			if (m_bGPUCulling && (object.cullIndex >= 0))
+			{
+				if (object.textureSlot >= 0)
+				{
+					glm::vec3 center = (object.boundsMin + object.boundsMax) * 0.5f;
+					RequestTextureLevel(object.textureSlot, object.boundsMin, object.boundsMax, -(m_viewMatrix * glm::vec4(center, 1.0f)).z);
+				}
+				continue;
+			}
+
+			if (false == IsBoxInFrustum(m_frustumPlanes, object.boundsMin, object.boundsMax))
+			{
+				continue;
+			}
+
+			// the view space Z axis points toward the viewer
+			glm::vec3 center = (object.boundsMin + object.boundsMax) * 0.5f;
+			RENDER_PACKET& packet = queue.pPackets[queue.count++];
+			packet.objectIndex = objects[i];
+			packet.viewDepth = -(m_viewMatrix * glm::vec4(center, 1.0f)).z;
+
+			if (object.textureSlot >= 0)
+			{
+				RequestTextureLevel(object.textureSlot, object.boundsMin, object.boundsMax, packet.viewDepth);
+			}
+		}
+	}
 
-	// ***END OF MOUSE***
+	std::sort(m_batchQueue.pPackets, m_batchQueue.pPackets + m_batchQueue.count,
+		[](const RENDER_PACKET& a, const RENDER_PACKET& b) { return a.viewDepth < b.viewDepth; });
+	std::sort(m_opaqueQueue.pPackets, m_opaqueQueue.pPackets + m_opaqueQueue.count,
+		[](const RENDER_PACKET& a, const RENDER_PACKET& b) { return a.viewDepth < b.viewDepth; });
+	std::sort(m_blendedQueue.pPackets, m_blendedQueue.pPackets + m_blendedQueue.count,
+		[](const RENDER_PACKET& a, const RENDER_PACKET& b) { return a.viewDepth > b.viewDepth; });
+}
 
-	// *** START OF LAMP***
-	
-	// preload -MK
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadConeMesh();
+/***********************************************************
+ *  RequestTextureLevel()
+ *
+ *  This method is used for requesting the texture level that
+ *  a drawn object or batch needs.  The texture is taken to
+ *  cover the bounds once, so the level follows the size of
+ *  the bounding sphere in the viewport being drawn.
+ ***********************************************************/
+void SceneManager::RequestTextureLevel(int textureSlot, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float viewDepth)
+{
+	float radius = glm::length(boundsMax - boundsMin) * 0.5f;
+	float screenSize = 2.0f * radius * m_viewPixelScale;
 
-	// Lamp BASE -MK
+	// a view inside the bounding sphere needs the finest level
+	if (false == m_bOrthographicView)
+	{
+		screenSize = (viewDepth > radius) ? screenSize / viewDepth : FLT_MAX;
+	}
 
-	glm::vec3 lampBaseScale = glm::vec3(2.0f, 0.2f, 2.0f);         
-	glm::vec3 lampBasePosition = glm::vec3(-12.0f, 0.1f, 0.0f);    
-	SetTransformations(lampBaseScale, 0.0f, 0.0f, 0.0f, lampBasePosition);
-	SetShaderColor(0.25f, 0.25f, 0.25f, 1.0f); // gray color -MK
-	m_basicMeshes->DrawCylinderMesh();
+	m_textureStreamer.RequestTexture(textureSlot, screenSize);
+}
 
-	// Lamp Stand -MK
+/***********************************************************
+ *  BuildGPUCuller()
+ *
+ *  This method is used for adding the opaque objects drawn
+ *  with generated or imported meshes to the GPU culler.  A
+ *  generated mesh gets two coarser levels of detail with
+ *  fewer divisions, and an imported mesh is drawn with the
+ *  one level it was loaded with.  The basic shape meshes
+ *  keep their own buffers, so their objects are culled on
+ *  the CPU.
+ ***********************************************************/
+void SceneManager::BuildGPUCuller()
+{
+	MeshGenerator::MESH_BUFFERS levels[GPUCuller::MAX_MESH_LEVELS];
+	std::unordered_map<int, int> generatedMeshes;
+	std::unordered_map<int, int> importedMeshes;
 
-	glm::vec3 lampStandScale = glm::vec3(0.25f, 6.0f, 0.25f); 
-	glm::vec3 lampStandPosition = glm::vec3(-12.0f, 0.7, 0.0f);
-	SetTransformations(lampStandScale, 0.0f, 0.0f, 0.0f, lampStandPosition);
-	SetShaderColor(0.30f, 0.30f, 0.30f, 1.0f); // slightly lighter gray -MK
+	m_gpuCuller.Reset();
+	m_culledObjects.clear();
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		m_sceneObjects[i].cullIndex = -1;
+	}
 
-	SetShaderTexture("lamp"); // Apply metal texture -MK
-	m_basicMeshes->DrawCylinderMesh();
+	for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[m_opaqueObjects[i]];
+		int cullMesh = -1;
+		if (m_bStaticBatching && (object.batchIndex >= 0))
+		{
+			continue;
+		}
+		if (object.mesh == MESH_GENERATED)
+		{
+			auto found = generatedMeshes.find(object.meshIndex);
+			if (found == generatedMeshes.end())
+			{
+				// stop at the first level that the shape cannot be
+				// made any coarser for
+				MeshGenerator::SHAPE_PARAMETERS parameters = m_meshGenerator.GetMesh(object.meshIndex).parameters;
+				int levelMeshes[GPUCuller::MAX_MESH_LEVELS];
+				int levelCount = 0;
+				levelMeshes[levelCount] = object.meshIndex;
+				levels[levelCount++] = m_meshGenerator.GetMesh(object.meshIndex).buffers;
+				for (int level = 1; level < GPUCuller::MAX_MESH_LEVELS; level++)
+				{
+					int meshIndex = m_meshGenerator.FindOrCreateMesh(MeshGenerator::ReduceDetail(parameters, level));
+					if ((meshIndex < 0) || (meshIndex == levelMeshes[levelCount - 1]))
+					{
+						break;
+					}
+					levelMeshes[levelCount] = meshIndex;
+					levels[levelCount++] = m_meshGenerator.GetMesh(meshIndex).buffers;
+				}
+				found = generatedMeshes.emplace(object.meshIndex, m_gpuCuller.AddMesh(levels, levelCount)).first;
+			}
+			cullMesh = found->second;
+		}
+		else if (object.mesh == MESH_IMPORTED)
+		{
+			auto found = importedMeshes.find(object.meshIndex);
+			if (found == importedMeshes.end())
+			{
+				levels[0] = m_meshImporter.GetMesh(object.meshIndex);
+				found = importedMeshes.emplace(object.meshIndex, m_gpuCuller.AddMesh(levels, 1)).first;
+			}
+			cullMesh = found->second;
+		}
 
-	// Lamp Shade -MK
+		if (cullMesh >= 0)
+		{
+			object.cullIndex = m_gpuCuller.AddObject(cullMesh, object.modelMatrix, object.boundsMin, object.boundsMax);
+			m_culledObjects.push_back(m_opaqueObjects[i]);
+		}
+	}
 
-	glm::vec3 lampShadeScale = glm::vec3(2.0, 1.5, 3.0);
-	glm::vec3 lampShadePosition = glm::vec3(-12.0, 7.9, 0.0);
-	SetTransformations(lampShadeScale, 10.0, 0.0, 125.0, lampShadePosition);
-	SetShaderColor(0.85, 0.85, 0.7, 1.0); // light cream color -MK
+	m_gpuCuller.Build();
+	m_bGPUCullerDirty = false;
+	m_bGPUCullerBatched = m_bStaticBatching;
+}
 
-	SetShaderMaterial("lampShade"); // Use defined material for lamp shade -MK
-	m_basicMeshes->DrawConeMesh();
-	
-	m_basicMeshes->DrawConeMesh();
-	m_basicMeshes->DrawSphereMesh();
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for merging the static opaque objects
+ *  into batches by texture and material.  Objects drawn with
+ *  the curved basic shape meshes keep their own draws, since
+ *  the data of those meshes is not available.  With baked
+ *  lighting on, the batches are lit before they are loaded.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	int batchedObjects = 0;
 
-	// *** END OF LAMP ***
+	m_staticBatcher.Reset();
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		m_sceneObjects[i].batchIndex = -1;
+	}
 
-	// *** START OF BOOK STACK *** -MK
-	m_basicMeshes->LoadBoxMesh();
+	for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[m_opaqueObjects[i]];
+		MeshGenerator::MESH_DATA meshData;
+		if ((false == object.bStatic) || (false == GetObjectMeshData(object, meshData)))
+		{
+			continue;
+		}
+
+		object.batchIndex = m_staticBatcher.AddObject(meshData, object.modelMatrix,
+			object.color, object.textureSlot, object.materialIndex);
+		batchedObjects++;
+	}
+
+	if (m_bBakedLighting)
+	{
+		BakeStaticLighting();
+	}
+	m_bStaticBatchesBaked = m_bBakedLighting;
 
-	// Bottom book -MK
-	glm::vec3 book1Scale = glm::vec3(3.5f, 0.6f, 2.5f);
-	glm::vec3 book1Position = glm::vec3(8.0f, 0.3f, -3.2f);
+	if (false == m_staticBatcher.Build())
+	{
+		std::cout << "ERROR: Static batches could not be loaded" << std::endl;
+	}
+	std::cout << "INFO: Merged " << batchedObjects << " static objects into "
+		<< m_staticBatcher.GetBatchCount() << " batches" << std::endl;
+	m_bStaticBatchesDirty = false;
+}
 
-	SetTransformations(book1Scale, 0.0f, 5.0f, 0.0f, book1Position);
-	SetShaderColor(0.0f, 0.5f, 0.0f, 1.0f); // green color -MK
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  BakeStaticLighting()
+ *
+ *  This method is used for baking the ambient occlusion and
+ *  the shadowed diffuse lighting of the merged static
+ *  batches into their vertices, before they are loaded.
+ *  The batches are split first so the vertices are close
+ *  enough together to hold the shadows.  The lights are
+ *  passed as the scene shader has them, so an open surface
+ *  bakes to the color the forward path draws it with.
+ ***********************************************************/
+bool SceneManager::BakeStaticLighting()
+{
+	int batchCount = m_staticBatcher.GetMergedCount();
+	if (batchCount == 0)
+	{
+		return false;
+	}
 
-	// Top book -MK
-	glm::vec3 book2Scale = glm::vec3(3.5f, 0.6f, 2.5f);
-	glm::vec3 book2Position = glm::vec3(8.0f, 0.9f, -3.2f);
+	LightBaker baker;
+	for (int i = 0; i < LightBaker::MAX_LIGHTS; i++)
+	{
+		LightBaker::BAKE_LIGHT light;
+		light.position = m_lightSources[i].position;
+		light.ambientColor = m_lightSources[i].ambientColor;
+		light.diffuseColor = m_lightSources[i].diffuseColor;
+		baker.SetLight(i, light);
+	}
 
-	SetTransformations(book2Scale, 0.0f, -5.0f, 0.0f, book2Position);
-	SetShaderColor(0.1f, 0.1f, 0.6f, 1.0f); // blue color -MK
-	m_basicMeshes->DrawBoxMesh();
+	for (int i = 0; i < batchCount; i++)
+	{
+		MeshGenerator::MESH_DATA& meshData = m_staticBatcher.GetMergedMesh(i);
+		MeshGenerator::SubdivideMeshData(meshData, BAKE_MAX_EDGE_LENGTH, BAKE_MAX_BATCH_VERTICES);
+
+		const OBJECT_MATERIAL& objectMaterial = GetObjectMaterial(m_staticBatcher.GetMergedMaterial(i));
+		LightBaker::BAKE_MATERIAL material;
+		material.ambientStrength = objectMaterial.ambientStrength;
+		material.ambientColor = objectMaterial.ambientColor;
+		material.diffuseColor = objectMaterial.diffuseColor;
+		baker.AddMesh(meshData, material);
+	}
 
-	// *** END OF BOOK STACK ***
+	if (false == baker.Bake(0, g_BakeCacheDirectory))
+	{
+		std::cout << "ERROR: Lighting of the static batches could not be baked" << std::endl;
+		return false;
+	}
 
-	// *** START OF COFFEE MUG *** - MK
-	m_basicMeshes->LoadCylinderMesh();
+	for (int i = 0; i < batchCount; i++)
+	{
+		m_staticBatcher.SetMergedLighting(i, baker.GetVertexLighting(i));
+	}
+	return true;
+}
 
-	// Mug body -MK
-	glm::vec3 mugScale = glm::vec3(0.8f, 1.2f, 0.8f);
-	glm::vec3 mugPosition = glm::vec3(-7.5f, 0.6f, 2.5f); // Front left of desk -MK
+/***********************************************************
+ *  GetObjectMaterial()
+ *
+ *  This method is used for getting a material by its index,
+ *  or the plain material for objects that have none.
+ ***********************************************************/
+const SceneManager::OBJECT_MATERIAL& SceneManager::GetObjectMaterial(int materialIndex) const
+{
+	if ((materialIndex >= 0) && (materialIndex < (int)m_objectMaterials.size()))
+	{
+		return m_objectMaterials[materialIndex];
+	}
+	return m_plainMaterial;
+}
 
-	SetTransformations(mugScale, 0.0f, 0.0f, 0.0f, mugPosition);
-	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f); // White mug -MK
-	m_basicMeshes->DrawCylinderMesh();
+/***********************************************************
+ *  GetObjectMeshData()
+ *
+ *  This method is used for getting the vertex and index
+ *  data of the mesh of a scene object.  Generated meshes
+ *  are built again from their parameters, imported meshes
+ *  are read back from their buffers, and the plane and box
+ *  basic shapes are built with the same layout.  The other
+ *  basic shapes are only built as stand-ins when they are
+ *  asked for.
+ ***********************************************************/
+bool SceneManager::GetObjectMeshData(const SCENE_OBJECT& object, MeshGenerator::MESH_DATA& meshData, bool bApproximateCurved)
+{
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+	case MESH_BOX:
+		return BuildBasicMeshData(object.mesh, meshData);
+	case MESH_SPHERE:
+	case MESH_CYLINDER:
+	case MESH_CONE:
+		return bApproximateCurved && BuildCurvedMeshData(object.mesh, meshData);
+	case MESH_GENERATED:
+		return MeshGenerator::GenerateMeshData(m_meshGenerator.GetMesh(object.meshIndex).parameters, meshData);
+	case MESH_IMPORTED:
+		return MeshGenerator::ReadMeshData(m_meshImporter.GetMesh(object.meshIndex), meshData);
+	default:
+		return false;
+	}
+}
 
-	// Mug top -MK
-	glm::vec3 mugTopScale = glm::vec3(0.78f, 0.05f, 0.78f);
-	glm::vec3 mugTopPosition = glm::vec3(-7.5f, 1.2f, 2.5f); // Top of mug -MK
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the basic shape mesh
+ *  or generated mesh that is used by a scene object.
+ ***********************************************************/
+void SceneManager::DrawMesh(const SCENE_OBJECT& object)
+{
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh();
+		break;
+	case MESH_GENERATED:
+		m_meshGenerator.DrawMesh(object.meshIndex);
+		break;
+	case MESH_IMPORTED:
+		m_meshImporter.DrawMesh(object.meshIndex);
+		break;
+	}
+}
 
-	SetTransformations(mugTopScale, 0.0f, 0.0f, 0.0f, mugTopPosition);
-	SetShaderColor(0.2f, 0.2f, 0.2f, 1.0f); // Dark gray top -MK
-	m_basicMeshes->DrawCylinderMesh();
+/***********************************************************
+ *  BindShaderPermutation()
+ *
+ *  This method is used for making the shader permutation
+ *  for textured or untextured drawing the active program.  The
+ *  lights are set into each program the first time it is
+ *  used, since every permutation keeps its own copy of the
+ *  uniform values.  Shaders that do not read the view block
+ *  also get the view values of each viewport this way.
+ ***********************************************************/
+void SceneManager::BindShaderPermutation(bool bTextured)
+{
+	if ((NULL == m_pShaderCache) || (false == m_pShaderCache->IsLoaded()))
+	{
+		return;
+	}
 
-	// *** END OF COFFEE MUG ***
+	int permutation = ShaderCache::PERMUTATION_LIGHTING;
+	if (bTextured)
+	{
+		permutation |= ShaderCache::PERMUTATION_TEXTURE;
+	}
+
+	if (permutation != m_boundPermutation)
+	{
+		m_pShaderCache->Bind(permutation);
+		m_boundPermutation = permutation;
+	}
+
+	if (false == m_bPermutationLightsSet[permutation])
+	{
+		SetupSceneLights();
+		m_bPermutationLightsSet[permutation] = true;
+	}
+	if ((false == m_pShaderCache->UsesViewBlock()) && (m_permutationFrame[permutation] != m_frameIndex))
+	{
+		m_pShaderManager->setMat4Value(g_ViewName, m_viewMatrix);
+		m_pShaderManager->setMat4Value(g_ProjectionName, m_projectionMatrix);
+		m_pShaderManager->setVec3Value(g_ViewPositionName, m_viewPosition);
+		m_permutationFrame[permutation] = m_frameIndex;
+	}
+}
+
+/***********************************************************
+ *  RenderDepthPrepass()
+ *
+ *  This method is used for drawing the opaque objects into
+ *  the depth buffer only, using a program that reads just
+ *  the vertex positions and does no fragment shading.
+ ***********************************************************/
+void SceneManager::RenderDepthPrepass()
+{
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+
+	// the view values come from the view block of the viewport
+	glUseProgram(m_depthProgramID);
+	GLint modelLocation = glGetUniformLocation(m_depthProgramID, g_ModelName.c_str());
+
+	// the batches are already in world space
+	const glm::mat4 identity(1.0f);
+	glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(identity));
+	for (int i = 0; i < m_batchQueue.count; i++)
+	{
+		m_staticBatcher.DrawBatch(m_batchQueue.pPackets[i].objectIndex);
+	}
+
+	for (int i = 0; i < m_opaqueQueue.count; i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_opaqueQueue.pPackets[i].objectIndex];
+		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(object.modelMatrix));
+		DrawMesh(object);
+	}
+
+	// the objects culled on the GPU are all opaque, and are drawn
+	// with one call for the viewport
+	if (m_bGPUCulling)
+	{
+		glUseProgram(m_indirectDepthProgramID);
+		m_gpuCuller.DrawObjects(m_currentView, 0, m_gpuCuller.GetObjectCount());
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  SetObjectShaderValues()
+ *
+ *  This method is used for making the permutation for a
+ *  scene object active and setting its transform, color,
+ *  texture and material into it.
+ ***********************************************************/
+void SceneManager::SetObjectShaderValues(const SCENE_OBJECT& object)
+{
+	BindShaderPermutation(object.textureSlot >= 0);
+	m_pShaderManager->setMat4Value(g_ModelName, object.modelMatrix);
+	SetShaderColor(object.color.r, object.color.g, object.color.b, object.color.a);
+	if (object.textureSlot >= 0)
+	{
+		SetShaderTextureSlot(object.textureSlot);
+	}
+	if (object.materialIndex >= 0)
+	{
+		SetShaderMaterialIndex(object.materialIndex);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  This method is used for drawing the objects in the passed
+ *  in draw queue with the scene shader.
+ ***********************************************************/
+void SceneManager::RenderQueue(const RENDER_QUEUE& queue)
+{
+	for (int i = 0; i < queue.count; i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[queue.pPackets[i].objectIndex];
+
+		SetObjectShaderValues(object);
+		DrawMesh(object);
+	}
+}
+
+/***********************************************************
+ *  RenderBatchQueue()
+ *
+ *  This method is used for drawing the static batches that
+ *  are visible in the viewport being drawn.  The batches
+ *  are in world space, so they are drawn with an identity
+ *  model matrix.  Untextured batches read their colors from
+ *  the palette, with a UV scale of one so the texture
+ *  coordinates land on the palette texels.
+ ***********************************************************/
+void SceneManager::RenderBatchQueue(bool bShowOverdraw)
+{
+	const glm::mat4 identity(1.0f);
+
+	if (bShowOverdraw)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glUseProgram(m_overdrawProgramID);
+		glUniformMatrix4fv(glGetUniformLocation(m_overdrawProgramID, g_ModelName.c_str()), 1, GL_FALSE, glm::value_ptr(identity));
+		for (int i = 0; i < m_batchQueue.count; i++)
+		{
+			m_staticBatcher.DrawBatch(m_batchQueue.pPackets[i].objectIndex);
+		}
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_BLEND);
+		m_pShaderManager->use();
+		return;
+	}
+
+	if (m_batchQueue.count > 0)
+	{
+		m_staticBatcher.BindPalette();
+	}
+	bool bBakedBatches = false;
+	for (int i = 0; i < m_batchQueue.count; i++)
+	{
+		const StaticBatcher::STATIC_BATCH& batch = m_staticBatcher.GetBatch(m_batchQueue.pPackets[i].objectIndex);
+		if (m_bBakedLighting && (0 != batch.lightingVBO))
+		{
+			bBakedBatches = true;
+			continue;
+		}
+
+		BindShaderPermutation(true);
+		m_pShaderManager->setMat4Value(g_ModelName, identity);
+		SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
+		SetShaderTextureSlot((batch.textureSlot >= 0) ? batch.textureSlot : StaticBatcher::PALETTE_TEXTURE_UNIT);
+		SetTextureUVScale(1.0f, 1.0f);
+		if (batch.materialIndex >= 0)
+		{
+			SetShaderMaterialIndex(batch.materialIndex);
+		}
+
+		m_staticBatcher.DrawBatch(m_batchQueue.pPackets[i].objectIndex);
+	}
+
+	if (bBakedBatches)
+	{
+		RenderBakedBatches();
+	}
+}
+
+/***********************************************************
+ *  RenderBakedBatches()
+ *
+ *  This method is used for drawing the visible static
+ *  batches that hold baked lighting.  Only the specular
+ *  term of each light is shaded per fragment, and lights
+ *  without one are left out of the program.
+ ***********************************************************/
+void SceneManager::RenderBakedBatches()
+{
+	glUseProgram(m_bakedProgramID);
+	GLint textureLocation = glGetUniformLocation(m_bakedProgramID, g_TextureValueName.c_str());
+	GLint lightCountLocation = glGetUniformLocation(m_bakedProgramID, "lightCount");
+	GLint positionsLocation = glGetUniformLocation(m_bakedProgramID, "lightPositions");
+	GLint specularColorsLocation = glGetUniformLocation(m_bakedProgramID, "lightSpecularColors");
+	GLint focalStrengthsLocation = glGetUniformLocation(m_bakedProgramID, "lightFocalStrengths");
+
+	int specularLights[LightBaker::MAX_LIGHTS];
+	glm::vec3 positions[LightBaker::MAX_LIGHTS];
+	GLfloat focalStrengths[LightBaker::MAX_LIGHTS];
+	int lightCount = 0;
+	for (int i = 0; i < LightBaker::MAX_LIGHTS; i++)
+	{
+		const RenderBackend::LIGHT& light = m_lightSources[i];
+		if ((light.specularIntensity != 0.0f) && (light.specularColor != glm::vec3(0.0f)))
+		{
+			specularLights[lightCount] = i;
+			positions[lightCount] = light.position;
+			focalStrengths[lightCount] = light.focalStrength;
+			lightCount++;
+		}
+	}
+	glUniform1i(lightCountLocation, lightCount);
+	if (lightCount > 0)
+	{
+		glUniform3fv(positionsLocation, lightCount, glm::value_ptr(positions[0]));
+		glUniform1fv(focalStrengthsLocation, lightCount, focalStrengths);
+	}
+
+	for (int i = 0; i < m_batchQueue.count; i++)
+	{
+		int batchIndex = m_batchQueue.pPackets[i].objectIndex;
+		const StaticBatcher::STATIC_BATCH& batch = m_staticBatcher.GetBatch(batchIndex);
+		if (0 == batch.lightingVBO)
+		{
+			continue;
+		}
+
+		// the specular colors take in the material of the batch
+		const OBJECT_MATERIAL& material = GetObjectMaterial(batch.materialIndex);
+		glm::vec3 specularColors[LightBaker::MAX_LIGHTS];
+		for (int j = 0; j < lightCount; j++)
+		{
+			const RenderBackend::LIGHT& light = m_lightSources[specularLights[j]];
+			specularColors[j] = light.specularColor * light.specularIntensity * material.shininess * material.specularColor;
+		}
+		if (lightCount > 0)
+		{
+			glUniform3fv(specularColorsLocation, lightCount, glm::value_ptr(specularColors[0]));
+		}
+		glUniform1i(textureLocation, (batch.textureSlot >= 0) ? batch.textureSlot : StaticBatcher::PALETTE_TEXTURE_UNIT);
+
+		m_staticBatcher.DrawBatch(batchIndex);
+	}
+
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  RenderCulledObjects()
+ *
+ *  This method is used for drawing the objects culled on the
+ *  GPU in the viewport being drawn.  The overdraw shader
+ *  reads the transforms from the object buffer, so all of
+ *  the objects are drawn with one call.  The scene shader
+ *  takes the values of each object as uniforms, so each
+ *  object is drawn with its own command, which holds the
+ *  same level of detail as the depth pre-pass and draws
+ *  nothing when the object was culled.
+ ***********************************************************/
+void SceneManager::RenderCulledObjects(bool bShowOverdraw, GPUCuller::COMMAND_SET commandSet)
+{
+	if (bShowOverdraw)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glUseProgram(m_indirectOverdrawProgramID);
+		m_gpuCuller.DrawObjects(m_currentView, 0, m_gpuCuller.GetObjectCount(), commandSet);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_BLEND);
+		m_pShaderManager->use();
+		return;
+	}
+
+	for (size_t i = 0; i < m_culledObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_culledObjects[i]];
+
+		SetObjectShaderValues(object);
+		m_gpuCuller.DrawObject(m_currentView, object.cullIndex, commandSet);
+	}
+}
+
+/***********************************************************
+ *  GetSceneViewExtent()
+ *
+ *  This method is used for getting the size of the area of
+ *  the target from its origin that holds every viewport.
+ ***********************************************************/
+void SceneManager::GetSceneViewExtent(int& width, int& height) const
+{
+	width = 0;
+	height = 0;
+	for (int i = 0; i < m_sceneViewCount; i++)
+	{
+		width = std::max(width, m_sceneViews[i].x + m_sceneViews[i].width);
+		height = std::max(height, m_sceneViews[i].y + m_sceneViews[i].height);
+	}
+}
+
+/***********************************************************
+ *  RetestOccludedObjects()
+ *
+ *  This method is used for building the depth pyramid from
+ *  the opaque objects drawn into every viewport so far, and
+ *  testing the objects that the pyramid of the previous
+ *  frame hid against it.  An object that was behind another
+ *  one from where the camera was is drawn in this frame if
+ *  it has come into view, rather than appearing a frame
+ *  late.
+ ***********************************************************/
+void SceneManager::RetestOccludedObjects()
+{
+	int width = 0;
+	int height = 0;
+
+	// the pyramid covers the area of the target that holds the
+	// viewports
+	GetSceneViewExtent(width, height);
+	m_depthPyramid.Build(width, height);
+	m_gpuCuller.RetestOccluded(m_depthPyramid);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  SetDeferredLights()
+ *
+ *  This method is used for giving the light sources that
+ *  light anything, the ambient light summed over all of
+ *  them, and the material table to the deferred renderer.
+ *  The first entry of the table is the plain material, so
+ *  the material of an object is found one entry on.
+ ***********************************************************/
+void SceneManager::SetDeferredLights(const DeferredRenderer::LIGHT* pExtraLights, int extraLightCount)
+{
+	DeferredRenderer::LIGHT* pLights = m_frameArena.AllocateArray<DeferredRenderer::LIGHT>(
+		(size_t)RenderBackend::MAX_LIGHTS + extraLightCount);
+	glm::vec3 ambientLight(0.0f);
+	int lightCount = 0;
+	for (int i = 0; i < RenderBackend::MAX_LIGHTS; i++)
+	{
+		const RenderBackend::LIGHT& source = m_lightSources[i];
+		glm::vec3 specularColor = source.specularColor * source.specularIntensity;
+
+		ambientLight += source.ambientColor;
+		if ((source.diffuseColor == glm::vec3(0.0f)) && (specularColor == glm::vec3(0.0f)))
+		{
+			continue;
+		}
+
+		// the light sources reach every pixel
+		DeferredRenderer::LIGHT& light = pLights[lightCount++];
+		light.position = source.position;
+		light.radius = 0.0f;
+		light.diffuseColor = source.diffuseColor;
+		light.specularColor = specularColor;
+		light.focalStrength = source.focalStrength;
+	}
+	for (int i = 0; i < extraLightCount; i++)
+	{
+		pLights[lightCount++] = pExtraLights[i];
+	}
+	m_deferredRenderer.SetLights(pLights, lightCount, ambientLight);
+
+	int materialCount = std::min((int)m_objectMaterials.size() + 1, DeferredRenderer::MAX_MATERIALS);
+	DeferredRenderer::MATERIAL* pMaterials = m_frameArena.AllocateArray<DeferredRenderer::MATERIAL>(materialCount);
+	for (int i = 0; i < materialCount; i++)
+	{
+		const OBJECT_MATERIAL& material = GetObjectMaterial(i - 1);
+		pMaterials[i].ambientColor = material.ambientStrength * material.ambientColor;
+		pMaterials[i].diffuseColor = material.diffuseColor;
+		pMaterials[i].specularColor = material.shininess * material.specularColor;
+	}
+	m_deferredRenderer.SetMaterials(pMaterials, materialCount);
+}
+
+/***********************************************************
+ *  RenderDeferredSurfaces()
+ *
+ *  This method is used for drawing the static batches, the
+ *  opaque objects and the objects culled on the GPU in the
+ *  viewport being drawn, with the geometry program or the
+ *  forward program of the deferred renderer.  The baked
+ *  lighting of the batches is not used, since the lights
+ *  are added per pixel.
+ ***********************************************************/
+void SceneManager::RenderDeferredSurfaces()
+{
+	const glm::mat4 identity(1.0f);
+	const glm::vec4 white(1.0f);
+
+	// untextured batches read their colors from the palette
+	if (m_batchQueue.count > 0)
+	{
+		m_staticBatcher.BindPalette();
+	}
+	for (int i = 0; i < m_batchQueue.count; i++)
+	{
+		const StaticBatcher::STATIC_BATCH& batch = m_staticBatcher.GetBatch(m_batchQueue.pPackets[i].objectIndex);
+		m_deferredRenderer.SetSurfaceValues(identity, white,
+			(batch.textureSlot >= 0) ? batch.textureSlot : StaticBatcher::PALETTE_TEXTURE_UNIT, batch.materialIndex + 1);
+		m_staticBatcher.DrawBatch(m_batchQueue.pPackets[i].objectIndex);
+	}
+
+	for (int i = 0; i < m_opaqueQueue.count; i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_opaqueQueue.pPackets[i].objectIndex];
+		m_deferredRenderer.SetSurfaceValues(object.modelMatrix, object.color, object.textureSlot, object.materialIndex + 1);
+		DrawMesh(object);
+	}
+
+	if (m_bGPUCulling)
+	{
+		for (size_t i = 0; i < m_culledObjects.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[m_culledObjects[i]];
+			m_deferredRenderer.SetSurfaceValues(object.modelMatrix, object.color, object.textureSlot, object.materialIndex + 1);
+			m_gpuCuller.DrawObject(m_currentView, object.cullIndex, GPUCuller::COMMANDS_VISIBLE);
+		}
+	}
+}
+
+/***********************************************************
+ *  PlaceReflectionProbes()
+ *
+ *  This method is used for placing a reflection probe at the
+ *  middle of the reflective objects of each object group,
+ *  and pointing every reflective object at the probe that
+ *  is nearest to it.  The reflections of every probe are
+ *  projected onto the bounds of the whole scene.
+ ***********************************************************/
+void SceneManager::PlaceReflectionProbes()
+{
+	m_reflectionProbes.Reset();
+	if ((false == m_reflectionProbes.IsAvailable()) || m_reflectiveObjects.empty())
+	{
+		return;
+	}
+
+	glm::vec3 sceneBoundsMin(FLT_MAX);
+	glm::vec3 sceneBoundsMax(-FLT_MAX);
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		sceneBoundsMin = glm::min(sceneBoundsMin, m_sceneObjects[i].boundsMin);
+		sceneBoundsMax = glm::max(sceneBoundsMax, m_sceneObjects[i].boundsMax);
+	}
+
+	// the objects outside of a group share a probe as well
+	for (int group = -1; group < (int)m_objectGroups.size(); group++)
+	{
+		glm::vec3 boundsMin(FLT_MAX);
+		glm::vec3 boundsMax(-FLT_MAX);
+		for (size_t i = 0; i < m_reflectiveObjects.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[m_reflectiveObjects[i].objectIndex];
+			if (object.groupIndex == group)
+			{
+				boundsMin = glm::min(boundsMin, object.boundsMin);
+				boundsMax = glm::max(boundsMax, object.boundsMax);
+			}
+		}
+		if (boundsMin.x <= boundsMax.x)
+		{
+			m_reflectionProbes.AddProbe((boundsMin + boundsMax) * 0.5f, PROBE_RADIUS, sceneBoundsMin, sceneBoundsMax);
+		}
+	}
+
+	for (size_t i = 0; i < m_reflectiveObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_reflectiveObjects[i].objectIndex];
+		m_reflectiveObjects[i].probe = m_reflectionProbes.FindNearestProbe((object.boundsMin + object.boundsMax) * 0.5f);
+	}
+
+	std::cout << "INFO: Placed " << m_reflectionProbes.GetProbeCount() << " reflection probes for "
+		<< m_reflectiveObjects.size() << " reflective objects" << std::endl;
+}
+
+/***********************************************************
+ *  CaptureReflectionProbe()
+ *
+ *  This method is used for drawing the static opaque
+ *  objects around a probe into the six faces of its
+ *  cubemap, with the forward program of the deferred
+ *  renderer, which lights them the way the scene shader
+ *  does.  The objects that move are left out, since the
+ *  probe is not captured again when they do, and so are
+ *  the objects that the probe is inside of, which would
+ *  hide everything else.
+ ***********************************************************/
+void SceneManager::CaptureReflectionProbe(int probe)
+{
+	const ReflectionProbes::PROBE& values = m_reflectionProbes.GetProbe(probe);
+
+	SetDeferredLights(NULL, 0);
+	glDisable(GL_BLEND);
+	m_reflectionProbes.BeginCapture();
+	for (int face = 0; face < 6; face++)
+	{
+		VIEW_BLOCK faceBlock;
+		m_reflectionProbes.GetFaceView(probe, face, faceBlock.view, faceBlock.projection);
+		faceBlock.viewPosition = glm::vec4(values.position, 1.0f);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)m_viewBlockStride * PROBE_VIEW_BLOCK, sizeof(VIEW_BLOCK), &faceBlock);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, m_viewBlockBufferID,
+			(GLintptr)m_viewBlockStride * PROBE_VIEW_BLOCK, sizeof(VIEW_BLOCK));
+
+		glm::vec4 facePlanes[6];
+		ExtractFrustumPlanes(faceBlock.projection * faceBlock.view, facePlanes);
+
+		m_reflectionProbes.BeginFace(face);
+		m_deferredRenderer.BeginForwardPass();
+		for (size_t i = 0; i < m_opaqueObjects.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[m_opaqueObjects[i]];
+			if ((false == object.bStatic) ||
+				(glm::clamp(values.position, object.boundsMin, object.boundsMax) == values.position) ||
+				(false == IsBoxInFrustum(facePlanes, object.boundsMin, object.boundsMax)))
+			{
+				continue;
+			}
+
+			m_deferredRenderer.SetSurfaceValues(object.modelMatrix, object.color, object.textureSlot, object.materialIndex + 1);
+			DrawMesh(object);
+		}
+	}
+	m_reflectionProbes.EndCapture(probe);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  RenderReflections()
+ *
+ *  This method is used for blending the reflections of the
+ *  reflective objects in the viewport being drawn over
+ *  their lit surfaces.  Each object reads the probe level
+ *  for the roughness of its material, so the reflections
+ *  cost one lookup for each pixel of the objects.
+ ***********************************************************/
+void SceneManager::RenderReflections()
+{
+	m_reflectionProbes.BeginReflectionPass();
+	for (size_t i = 0; i < m_reflectiveObjects.size(); i++)
+	{
+		const REFLECTIVE_OBJECT& reflective = m_reflectiveObjects[i];
+		const SCENE_OBJECT& object = m_sceneObjects[reflective.objectIndex];
+		if ((reflective.probe < 0) || (false == IsBoxInFrustum(m_frustumPlanes, object.boundsMin, object.boundsMax)))
+		{
+			continue;
+		}
+
+		const OBJECT_MATERIAL& material = GetObjectMaterial(object.materialIndex);
+		m_reflectionProbes.SetSurfaceValues(object.modelMatrix, reflective.probe,
+			material.reflectivity, ReflectionProbes::GetRoughness(material.shininess));
+		DrawMesh(object);
+	}
+	m_reflectionProbes.EndReflectionPass();
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  ReportCullStatistics()
+ *
+ *  This method is used for collecting the culling counts
+ *  read back from the GPU, and reporting the draws per
+ *  frame left by frustum culling alone and by occlusion
+ *  culling.  The fragments saved show in the report of the
+ *  overdraw view when occlusion culling is switched.
+ ***********************************************************/
+void SceneManager::ReportCullStatistics()
+{
+	GPUCuller::CULL_STATISTICS statistics;
+
+	if (false == m_gpuCuller.ReadStatistics(statistics))
+	{
+		return;
+	}
+
+	m_cullTotals.frustumVisible += statistics.frustumVisible;
+	m_cullTotals.occluded += statistics.occluded;
+	m_cullTotals.retestedVisible += statistics.retestedVisible;
+	m_cullFrameCount++;
+	if (m_cullFrameCount >= SHADED_FRAGMENTS_REPORT_FRAMES)
+	{
+		GLuint drawn = m_cullTotals.frustumVisible - m_cullTotals.occluded + m_cullTotals.retestedVisible;
+		std::cout << "INFO: Culled object draws per frame: " << (m_cullTotals.frustumVisible / m_cullFrameCount)
+			<< " after frustum culling, " << (drawn / m_cullFrameCount) << " after occlusion culling ("
+			<< (m_cullTotals.retestedVisible / m_cullFrameCount) << " drawn after the re-test)" << std::endl;
+		m_cullTotals = {};
+		m_cullFrameCount = 0;
+	}
+}
+
+/***********************************************************
+ *  RenderOverdrawQueue()
+ *
+ *  This method is used for drawing the objects in the passed
+ *  in draw queue with the overdraw shader.  Every fragment
+ *  that passes the depth test adds to the pixel color, so
+ *  the image shows how many times each pixel was shaded.
+ ***********************************************************/
+void SceneManager::RenderOverdrawQueue(const RENDER_QUEUE& queue)
+{
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	// the view values come from the view block of the viewport
+	glUseProgram(m_overdrawProgramID);
+	GLint modelLocation = glGetUniformLocation(m_overdrawProgramID, g_ModelName.c_str());
+
+	for (int i = 0; i < queue.count; i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[queue.pPackets[i].objectIndex];
+		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(object.modelMatrix));
+		DrawMesh(object);
+	}
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  ReportShadedFragments()
+ *
+ *  This method is used for collecting the number of shaded
+ *  fragments counted by the samples query.  The result is
+ *  only read once it is available so the GPU is not stalled.
+ ***********************************************************/
+void SceneManager::ReportShadedFragments()
+{
+	GLint bAvailable = GL_FALSE;
+
+	if (false == m_bSamplesQueryActive)
+	{
+		return;
+	}
+
+	glGetQueryObjectiv(m_samplesQueryID, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (GL_FALSE == bAvailable)
+	{
+		return;
+	}
+
+	GLuint64 samplesPassed = 0;
+	glGetQueryObjectui64v(m_samplesQueryID, GL_QUERY_RESULT, &samplesPassed);
+	m_bSamplesQueryActive = false;
+
+	m_shadedFragments += samplesPassed;
+	m_shadedFrameCount++;
+	if (m_shadedFrameCount >= SHADED_FRAGMENTS_REPORT_FRAMES)
+	{
+		bool bDepthPrepass = (NULL != m_pRenderSettings) && m_pRenderSettings->bDepthPrepass;
+		std::cout << "INFO: Fragments shaded per frame: " << (m_shadedFragments / m_shadedFrameCount)
+			<< " (depth pre-pass " << (bDepthPrepass ? "on" : "off")
+			<< ", occlusion culling " << (m_bOcclusionCulling ? "on" : "off") << ")" << std::endl;
+		m_shadedFragments = 0;
+		m_shadedFrameCount = 0;
+	}
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the object under a pixel
+ *  of the scene target.  With GPU picking, the object IDs
+ *  for the pixel are drawn with this frame and read back by
+ *  a later one.  Otherwise a ray from the camera of the
+ *  viewport under the pixel is cast through the object
+ *  bounds, and the object is reported right away.
+ ***********************************************************/
+void SceneManager::PickObject(glm::vec2 pixel)
+{
+	int viewIndex = -1;
+	for (int i = 0; (i < m_sceneViewCount) && (viewIndex < 0); i++)
+	{
+		const SCENE_VIEW& sceneView = m_sceneViews[i];
+		if ((pixel.x >= sceneView.x) && (pixel.x < sceneView.x + sceneView.width) &&
+			(pixel.y >= sceneView.y) && (pixel.y < sceneView.y + sceneView.height))
+		{
+			viewIndex = i;
+		}
+	}
+	if (viewIndex < 0)
+	{
+		return;
+	}
+
+	bool bGPUPicking = ((NULL == m_pRenderSettings) || m_pRenderSettings->bGPUPicking) && (0 != m_pickProgramID);
+	if (bGPUPicking)
+	{
+		m_bPickPending = true;
+		m_pickView = viewIndex;
+		m_pickPixel = pixel;
+		return;
+	}
+
+	// the hierarchy only changes when objects are added
+	if (m_bPickHierarchyDirty)
+	{
+		std::vector<ObjectPicker::PICK_BOUNDS> bounds(m_sceneObjects.size());
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			bounds[i].boundsMin = m_sceneObjects[i].boundsMin;
+			bounds[i].boundsMax = m_sceneObjects[i].boundsMax;
+		}
+		m_objectPicker.BuildHierarchy(bounds);
+		m_bPickHierarchyDirty = false;
+	}
+
+	// unproject the pixel onto the near and far planes
+	const SCENE_VIEW& sceneView = m_sceneViews[viewIndex];
+	glm::vec2 clipPoint(
+		(pixel.x - sceneView.x) / sceneView.width * 2.0f - 1.0f,
+		(pixel.y - sceneView.y) / sceneView.height * 2.0f - 1.0f);
+	glm::mat4 inverseViewProjection = glm::inverse(sceneView.projection * sceneView.view);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(clipPoint, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(clipPoint, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+	ReportPick(m_objectPicker.CastRay(origin, direction), "CPU ray");
+}
+
+/***********************************************************
+ *  RenderObjectIDs()
+ *
+ *  This method is used for drawing the ID of each object
+ *  into the one pixel picking target.  A pick matrix makes
+ *  the picked pixel of the viewport fill the target, so
+ *  only the objects whose bounds cover that pixel are
+ *  drawn, and the nearest one is kept by the depth test.
+ ***********************************************************/
+void SceneManager::RenderObjectIDs()
+{
+	const SCENE_VIEW& sceneView = m_sceneViews[m_pickView];
+	m_bPickPending = false;
+
+	glm::vec2 pixelCenter = glm::floor(m_pickPixel) + glm::vec2(0.5f);
+	glm::mat4 pickMatrix(1.0f);
+	pickMatrix[0][0] = (float)sceneView.width;
+	pickMatrix[1][1] = (float)sceneView.height;
+	pickMatrix[3][0] = (float)sceneView.width - 2.0f * (pixelCenter.x - (float)sceneView.x);
+	pickMatrix[3][1] = (float)sceneView.height - 2.0f * (pixelCenter.y - (float)sceneView.y);
+
+	VIEW_BLOCK pickBlock;
+	pickBlock.view = sceneView.view;
+	pickBlock.projection = pickMatrix * sceneView.projection;
+	pickBlock.viewPosition = glm::vec4(sceneView.viewPosition, 1.0f);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_viewBlockBufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)m_viewBlockStride * PICK_VIEW_BLOCK, sizeof(VIEW_BLOCK), &pickBlock);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, m_viewBlockBufferID,
+		(GLintptr)m_viewBlockStride * PICK_VIEW_BLOCK, sizeof(VIEW_BLOCK));
+
+	glm::vec4 pickPlanes[6];
+	ExtractFrustumPlanes(pickBlock.projection * pickBlock.view, pickPlanes);
+
+	m_objectPicker.BeginGPUPick();
+	glUseProgram(m_pickProgramID);
+	GLint modelLocation = glGetUniformLocation(m_pickProgramID, g_ModelName.c_str());
+	GLint objectIDLocation = glGetUniformLocation(m_pickProgramID, "objectID");
+
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		if (IsBoxInFrustum(pickPlanes, object.boundsMin, object.boundsMax))
+		{
+			glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(object.modelMatrix));
+			glUniform1ui(objectIDLocation, (GLuint)i + 1);
+			DrawMesh(object);
+		}
+	}
+
+	m_objectPicker.EndGPUPick();
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  ReportPick()
+ *
+ *  This method is used for selecting a picked object and
+ *  reporting the group it belongs to.
+ ***********************************************************/
+void SceneManager::ReportPick(int objectIndex, const char* method)
+{
+	m_selectedObject = objectIndex;
+
+	if (objectIndex < 0)
+	{
+		std::cout << "INFO: Picked no object with the " << method << std::endl;
+		return;
+	}
+
+	int groupIndex = m_sceneObjects[objectIndex].groupIndex;
+	std::cout << "INFO: Picked " << ((groupIndex >= 0) ? m_objectGroups[groupIndex] : std::string("object"))
+		<< " (object " << objectIndex << ") with the " << method << std::endl;
+}
+
+/***********************************************************
+ *  GetSceneBackend()
+ *
+ *  This method is used for getting the renderer that draws
+ *  the scene outside of the OpenGL context, starting it the
+ *  first time.  The Vulkan renderer is used when it is
+ *  turned on and could start, and the software rasterizer
+ *  otherwise, which always can.
+ ***********************************************************/
+RenderBackend* SceneManager::GetSceneBackend()
+{
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bVulkanBackend && (false == m_bVulkanFailed))
+	{
+		if (false == m_bVulkanStarted)
+		{
+			m_bVulkanStarted = m_vulkanRenderer.Initialize(&m_workerPool);
+			m_bVulkanFailed = (false == m_bVulkanStarted);
+		}
+		if (m_bVulkanStarted)
+		{
+			return &m_vulkanRenderer;
+		}
+		std::cout << "INFO: Drawing with the software rasterizer instead of Vulkan" << std::endl;
+	}
+
+	if (false == m_bSoftwareThreadsStarted)
+	{
+		m_softwareRasterizer.Initialize(&m_workerPool);
+		m_bSoftwareThreadsStarted = true;
+	}
+	return &m_softwareRasterizer;
+}
+
+/***********************************************************
+ *  BuildBackendScene()
+ *
+ *  This method is used for copying the meshes and textures
+ *  of the scene into a renderer that draws outside of the
+ *  OpenGL context, when it does not hold the current scene.
+ *  Every level of the textures is copied, since they all
+ *  stay in system memory for streaming anyway, and the
+ *  objects that share a mesh share one copy of it.
+ ***********************************************************/
+void SceneManager::BuildBackendScene(RenderBackend* pBackend)
+{
+	if ((pBackend == m_pSceneBackend) && (false == m_bBackendSceneDirty))
+	{
+		return;
+	}
+
+	// the renderer that held the scene before lets it go, and the
+	// lights are set again since it may have started since
+	if ((NULL != m_pSceneBackend) && (pBackend != m_pSceneBackend))
+	{
+		m_pSceneBackend->Reset();
+	}
+	m_pSceneBackend = pBackend;
+	m_bBackendSceneDirty = false;
+	pBackend->Reset();
+	for (int i = 0; i < RenderBackend::MAX_LIGHTS; i++)
+	{
+		pBackend->SetLight(i, m_lightSources[i]);
+	}
+	m_backendMeshes.assign(m_sceneObjects.size(), -1);
+
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		for (int level = 0; level < m_textureStreamer.GetLevelCount(slot); level++)
+		{
+			int width = 0;
+			int height = 0;
+			int colorChannels = 0;
+			const unsigned char* pPixels = NULL;
+			if (m_textureStreamer.GetLevelPixels(slot, level, width, height, colorChannels, pPixels))
+			{
+				pBackend->AddTextureLevel(slot, width, height, colorChannels, pPixels);
+			}
+		}
+	}
+
+	std::map<std::pair<int, int>, int> meshes;
+	int meshCount = 0;
+	int skippedObjects = 0;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		std::pair<int, int> key((int)object.mesh, object.meshIndex);
+		std::map<std::pair<int, int>, int>::const_iterator found = meshes.find(key);
+		if (found == meshes.end())
+		{
+			int mesh = -1;
+			MeshGenerator::MESH_DATA meshData;
+			if (GetObjectMeshData(object, meshData, true))
+			{
+				mesh = pBackend->AddMesh(meshData);
+				meshCount++;
+			}
+			found = meshes.insert(std::make_pair(key, mesh)).first;
+		}
+
+		m_backendMeshes[i] = found->second;
+		if (found->second < 0)
+		{
+			skippedObjects++;
+		}
+	}
+
+	std::cout << "INFO: " << pBackend->GetName() << " has " << meshCount << " meshes for " << m_sceneObjects.size()
+		<< " objects on " << pBackend->GetThreadCount() << " threads";
+	if (skippedObjects > 0)
+	{
+		std::cout << ", skipping " << skippedObjects << " objects without mesh data";
+	}
+	std::cout << std::endl;
+}
+
+/***********************************************************
+ *  RenderSceneBackend()
+ *
+ *  This method is used for drawing every viewport with a
+ *  renderer outside of the OpenGL context and copying the
+ *  frames into the scene target, which was already cleared.
+ *  The first frame of the first viewport can be saved to an
+ *  image.  Object IDs for picking are still drawn with
+ *  OpenGL.
+ ***********************************************************/
+void SceneManager::RenderSceneBackend(RenderBackend* pBackend)
+{
+	BuildBackendScene(pBackend);
+
+	glm::vec4 clearColor;
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, &clearColor.r);
+
+	for (int i = 0; i < m_sceneViewCount; i++)
+	{
+		RenderBackendView(i, clearColor);
+		pBackend->Present(m_sceneViews[i].x, m_sceneViews[i].y);
+
+		if ((0 == i) && (NULL != m_pRenderSettings->softwareImagePath))
+		{
+			if (pBackend->SaveImage(m_pRenderSettings->softwareImagePath))
+			{
+				std::cout << "INFO: Saved the first viewport to " << m_pRenderSettings->softwareImagePath << std::endl;
+			}
+			m_pRenderSettings->softwareImagePath = NULL;
+		}
+	}
+
+	if (m_bPickPending)
+	{
+		RenderObjectIDs();
+	}
+	m_pShaderManager->use();
+
+	StreamTextureLevels();
+}
+
+/***********************************************************
+ *  RenderBackendView()
+ *
+ *  This method is used for drawing one viewport with the
+ *  renderer that holds the scene.  The objects are culled
+ *  and sorted as for OpenGL, but each one is drawn on its
+ *  own, since the static batches and the GPU culling only
+ *  live in the OpenGL context.
+ ***********************************************************/
+void SceneManager::RenderBackendView(int viewIndex, glm::vec4 clearColor)
+{
+	const SCENE_VIEW& sceneView = m_sceneViews[viewIndex];
+
+	m_currentView = viewIndex;
+	SetViewValues(sceneView);
+
+	bool bStaticBatching = m_bStaticBatching;
+	bool bGPUCulling = m_bGPUCulling;
+	m_bStaticBatching = false;
+	m_bGPUCulling = false;
+	SortRenderQueues(SCENE_PASS_ALL);
+	m_bStaticBatching = bStaticBatching;
+	m_bGPUCulling = bGPUCulling;
+
+	m_pSceneBackend->BeginFrame(
+		sceneView.width,
+		sceneView.height,
+		clearColor,
+		sceneView.view,
+		sceneView.projection,
+		sceneView.viewPosition);
+	SubmitBackendQueue(m_opaqueQueue, false);
+	SubmitBackendQueue(m_blendedQueue, true);
+	m_pSceneBackend->EndFrame();
+}
+
+/***********************************************************
+ *  SubmitBackendQueue()
+ *
+ *  This method is used for submitting the objects in a draw
+ *  queue to the renderer that holds the scene with their
+ *  materials.
+ *  Objects without a material get a plain one, rather than
+ *  the material left in the shader by an earlier object.
+ ***********************************************************/
+void SceneManager::SubmitBackendQueue(const RENDER_QUEUE& queue, bool bBlended)
+{
+	for (int i = 0; i < queue.count; i++)
+	{
+		int objectIndex = queue.pPackets[i].objectIndex;
+		int mesh = m_backendMeshes[objectIndex];
+		if (mesh < 0)
+		{
+			continue;
+		}
+
+		const SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+		const OBJECT_MATERIAL& objectMaterial = GetObjectMaterial(object.materialIndex);
+		RenderBackend::MATERIAL material;
+		material.ambientStrength = objectMaterial.ambientStrength;
+		material.ambientColor = objectMaterial.ambientColor;
+		material.diffuseColor = objectMaterial.diffuseColor;
+		material.specularColor = objectMaterial.specularColor;
+		material.shininess = objectMaterial.shininess;
+
+		m_pSceneBackend->DrawMesh(mesh, object.modelMatrix, object.color, object.textureSlot, material, bBlended);
+	}
+}
+
+/***********************************************************
+ *  BenchmarkRasterizers()
+ *
+ *  This method is used for timing the first viewport drawn
+ *  with the software rasterizer, or the Vulkan renderer when
+ *  it is turned on, and with OpenGL, waiting for OpenGL to
+ *  finish each frame.  Running it with the Mesa software
+ *  drivers compares the rasterizer against llvmpipe, and
+ *  lavapipe against llvmpipe.  The frame is drawn again
+ *  afterwards.
+ ***********************************************************/
+void SceneManager::BenchmarkRasterizers(int frameCount)
+{
+	if ((frameCount <= 0) || (m_sceneViewCount <= 0))
+	{
+		return;
+	}
+
+	RenderBackend* pBackend = GetSceneBackend();
+	BuildBackendScene(pBackend);
+
+	glm::vec4 clearColor;
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, &clearColor.r);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t triangleCount = 0;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		m_frameArena.Reset();
+		RenderBackendView(0, clearColor);
+		triangleCount += pBackend->GetTriangleCount();
+	}
+	double softwareSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	glFinish();
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		m_frameArena.Reset();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		RenderSceneView(0, SCENE_PASS_ALL, false, true, false);
+		glFinish();
+	}
+	double glSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_frameArena.Reset();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	const GLubyte* pRenderer = glGetString(GL_RENDERER);
+	std::cout << "INFO: " << pBackend->GetName() << " took " << (softwareSeconds * 1000.0 / frameCount) << " ms per frame, "
+		<< (triangleCount / softwareSeconds / 1000000.0) << " million triangles per second on "
+		<< pBackend->GetThreadCount() << " threads" << std::endl;
+	std::cout << "INFO: OpenGL on " << ((NULL != pRenderer) ? (const char*)pRenderer : "an unknown renderer")
+		<< " took " << (glSeconds * 1000.0 / frameCount) << " ms per frame" << std::endl;
+}
+
+/***********************************************************
+ *  BenchmarkShading()
+ *
+ *  This method is used for timing the first viewport with
+ *  every light evaluated for every shaded fragment, and
+ *  with the deferred renderer, as lights are added to the
+ *  light sources.  The added lights are spread through the
+ *  bounds of the scene from a fixed seed, so the runs can
+ *  be compared.
+ ***********************************************************/
+void SceneManager::BenchmarkShading(int frameCount)
+{
+	const int lightCounts[] = { 4, 16, 64, 256, 1024 };
+	const int lightCountSteps = sizeof(lightCounts) / sizeof(lightCounts[0]);
+
+	if ((frameCount <= 0) || (m_sceneViewCount <= 0) || m_sceneObjects.empty() ||
+		(false == m_deferredRenderer.IsAvailable()))
+	{
+		return;
+	}
+
+	glm::vec3 sceneMin(FLT_MAX);
+	glm::vec3 sceneMax(-FLT_MAX);
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		sceneMin = glm::min(sceneMin, m_sceneObjects[i].boundsMin);
+		sceneMax = glm::max(sceneMax, m_sceneObjects[i].boundsMax);
+	}
+
+	// each light reaches a fifth of the way across the scene
+	std::vector<DeferredRenderer::LIGHT> lights(lightCounts[lightCountSteps - 1]);
+	uint32_t seed = 12345;
+	auto random = [&seed]()
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / 16777216.0f;
+	};
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		glm::vec3 color(random(), random(), random());
+		lights[i].position = sceneMin + (sceneMax - sceneMin) * glm::vec3(random(), random(), random());
+		lights[i].radius = 0.2f * glm::length(sceneMax - sceneMin);
+		lights[i].diffuseColor = 0.5f * color;
+		lights[i].specularColor = 0.25f * color;
+		lights[i].focalStrength = 16.0f;
+	}
+
+	int width = 0;
+	int height = 0;
+	GetSceneViewExtent(width, height);
+	SHADING_PATH shadingPath = m_shadingPath;
+	const SHADING_PATH paths[2] = { SHADING_FORWARD_LIGHT_LIST, SHADING_DEFERRED };
+	for (int step = 0; step < lightCountSteps; step++)
+	{
+		double seconds[2];
+
+		m_frameArena.Reset();
+		SetDeferredLights(lights.data(), lightCounts[step]);
+		for (int path = 0; path < 2; path++)
+		{
+			m_shadingPath = paths[path];
+			glFinish();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int frame = 0; frame < frameCount; frame++)
+			{
+				m_frameArena.Reset();
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				if (SHADING_DEFERRED == m_shadingPath)
+				{
+					m_deferredRenderer.BeginFrame(width, height);
+				}
+				RenderSceneView(0, SCENE_PASS_ALL, false, true, false);
+				glFinish();
+			}
+			seconds[path] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		std::cout << "INFO: With " << lightCounts[step] << " added lights, forward shading took "
+			<< (seconds[0] * 1000.0 / frameCount) << " ms per frame and deferred shading took "
+			<< (seconds[1] * 1000.0 / frameCount) << " ms per frame" << std::endl;
+	}
+	m_shadingPath = shadingPath;
+	m_frameArena.Reset();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  UpdateAnimations()
+ *
+ *  This method is used for moving the animation clock on by
+ *  the time since the last frame and playing the clips of
+ *  the animated entities at it.  The world transforms and
+ *  bounds the update wrote are copied into the objects the
+ *  entities place, and into the GPU culler, which uploads
+ *  the moved objects with the next cull.  The clock stops
+ *  while the animations are paused, so they carry on from
+ *  the same pose.  Once no clip moves, such as when every
+ *  clip played once has finished, nothing is copied and the
+ *  scene is left unchanged, so the frames can stop.
+ ***********************************************************/
+void SceneManager::UpdateAnimations()
+{
+	ComponentStore<ANIMATION_COMPONENT>& animations = m_entityRegistry.GetAnimations();
+	if ((NULL == m_pRenderSettings) || (false == m_pRenderSettings->bAnimation) || (animations.GetCount() == 0))
+	{
+		m_bAnimationClockRunning = false;
+		m_bAnimationsMoving = false;
+		return;
+	}
+
+	// the clock does not move on the frame it is started, so that
+	// frame asks for the next one, which sees whether the clips move
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	bool bClockStarted = (false == m_bAnimationClockRunning);
+	if (m_bAnimationClockRunning)
+	{
+		double step = std::chrono::duration<double>(now - m_lastAnimationTick).count();
+		m_animationTime += std::min(step, MAX_ANIMATION_STEP);
+	}
+	m_lastAnimationTick = now;
+	m_bAnimationClockRunning = true;
+
+	bool bClipsMoved = m_animationSystem.Update(m_entityRegistry, m_animationTime);
+	m_bAnimationsMoving = bClipsMoved || bClockStarted;
+	if (false == bClipsMoved)
+	{
+		return;
+	}
+
+	ComponentStore<TRANSFORM_COMPONENT>& transforms = m_entityRegistry.GetTransforms();
+	ComponentStore<RENDERABLE_COMPONENT>& renderables = m_entityRegistry.GetRenderables();
+	for (int i = 0; i < animations.GetCount(); i++)
+	{
+		ENTITY entity = animations.GetEntity(i);
+		int renderableIndex = renderables.GetIndex(entity);
+		if ((renderableIndex < 0) || (renderables.GetAt(renderableIndex).objectIndex < 0) || (false == transforms.Has(entity)))
+		{
+			continue;
+		}
+
+		const RENDERABLE_COMPONENT& renderable = renderables.GetAt(renderableIndex);
+		SCENE_OBJECT& object = m_sceneObjects[renderable.objectIndex];
+		object.modelMatrix = transforms.Get(entity).worldMatrix;
+		object.boundsMin = renderable.boundsMin;
+		object.boundsMax = renderable.boundsMax;
+		if (object.cullIndex >= 0)
+		{
+			m_gpuCuller.SetObjectTransform(object.cullIndex, object.modelMatrix, object.boundsMin, object.boundsMax);
+		}
+	}
+
+	// the moved bounds are picked from once the hierarchy is built
+	// again, which is only done when a pick asks for it
+	m_bPickHierarchyDirty = true;
+}
+
+/***********************************************************
+ *  BenchmarkAnimation()
+ *
+ *  This method is used for timing the animation updates as
+ *  animated entities are added, each playing one of the
+ *  scene's clips from its own start time, on one thread and
+ *  then on every thread of the worker pool.  The added entities are
+ *  removed afterwards, leaving those of the scene.
+ ***********************************************************/
+void SceneManager::BenchmarkAnimation(int updateCount)
+{
+	const int entityCounts[] = { 1024, 4096, 16384, 65536 };
+	const int entityCountSteps = sizeof(entityCounts) / sizeof(entityCounts[0]);
+	const double UPDATE_STEP = 1.0 / 60.0;
+
+	int clipCount = m_animationSystem.GetClipCount();
+	if ((updateCount <= 0) || (clipCount <= 0))
+	{
+		return;
+	}
+
+	int poolThreads = m_workerPool.GetThreadCount();
+	std::vector<ENTITY> entities;
+	entities.reserve(entityCounts[entityCountSteps - 1]);
+	int reserveCount = m_entityRegistry.GetEntityCount() + entityCounts[entityCountSteps - 1];
+	m_entityRegistry.GetTransforms().Reserve(reserveCount);
+	m_entityRegistry.GetRenderables().Reserve(reserveCount);
+	m_entityRegistry.GetAnimations().Reserve(reserveCount);
+	for (int step = 0; step < entityCountSteps; step++)
+	{
+		// the entities are spread over a grid, with bounds to update
+		// as they would be for drawn objects
+		while ((int)entities.size() < entityCounts[step])
+		{
+			int index = (int)entities.size();
+			glm::vec3 position((float)(index % 256), 0.0f, (float)(index / 256));
+			ENTITY entity = m_entityRegistry.CreateEntity();
+			m_entityRegistry.GetTransforms().Add(entity,
+				EntityRegistry::RestTransform(CalculateModelMatrix(glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, position), position));
+
+			RENDERABLE_COMPONENT renderable;
+			renderable.objectIndex = -1;
+			renderable.localBoundsMin = glm::vec3(-0.5f);
+			renderable.localBoundsMax = glm::vec3(0.5f);
+			renderable.boundsMin = position + renderable.localBoundsMin;
+			renderable.boundsMax = position + renderable.localBoundsMax;
+			m_entityRegistry.GetRenderables().Add(entity, renderable);
+
+			ANIMATION_COMPONENT animation;
+			animation.clip = index % clipCount;
+			animation.speed = 1.0f;
+			animation.timeOffset = (float)index * 0.001f;
+			animation.clipTime = -1.0f;
+			m_entityRegistry.GetAnimations().Add(entity, animation);
+			entities.push_back(entity);
+		}
+
+		double seconds[2];
+		const int threadCounts[2] = { 1, poolThreads };
+		for (int run = 0; run < 2; run++)
+		{
+			// the first update warms the caches, and is not timed
+			m_animationSystem.SetThreadCount(threadCounts[run]);
+			m_animationSystem.Update(m_entityRegistry, m_animationTime);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int update = 0; update < updateCount; update++)
+			{
+				m_animationSystem.Update(m_entityRegistry, m_animationTime + update * UPDATE_STEP);
+			}
+			seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		int animationCount = m_entityRegistry.GetAnimations().GetCount();
+		std::cout << "INFO: With " << animationCount << " animated entities, updating them took "
+			<< (seconds[0] * 1000.0 / updateCount) << " ms on one thread and "
+			<< (seconds[1] * 1000.0 / updateCount) << " ms on " << poolThreads << " threads, "
+			<< (seconds[1] * 1.0e9 / ((double)updateCount * animationCount)) << " ns per entity" << std::endl;
+	}
+
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		m_entityRegistry.DestroyEntity(entities[i]);
+	}
+	m_animationSystem.SetThreadCount(0);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+ /***********************************************************
+  *  DefineObjectMaterials() -MK
+  *
+  *  This method is used for configuring the various material
+  *  settings for all of the objects within the 3D scene.
+  ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	// Define materials for the objects in the scene -MK
+	OBJECT_MATERIAL lampShadeMaterial;
+	lampShadeMaterial.ambientColor = glm::vec3(0.6f, 0.6f, 0.4f);
+	lampShadeMaterial.ambientStrength = 0.4f;
+	lampShadeMaterial.diffuseColor = glm::vec3(0.9f, 0.9f, 0.7f);
+	lampShadeMaterial.specularColor = glm::vec3(1.0f, 1.0f, 0.9f);
+	lampShadeMaterial.shininess = 40.0;
+	lampShadeMaterial.reflectivity = 0.0f;
+	lampShadeMaterial.tag = "lampShade";
+	m_objectMaterials.push_back(lampShadeMaterial);
+
+	// the glossy materials reflect the reflection probes, with a
+	// roughness that follows their shininess - the scene shader
+	// scales the specular color by the shininess, so the specular
+	// color is scaled down to keep the highlights of the lamp
+	// shade material that these objects were lit with before
+	OBJECT_MATERIAL screenGlassMaterial = lampShadeMaterial;
+	screenGlassMaterial.shininess = 400.0f;
+	screenGlassMaterial.specularColor = lampShadeMaterial.specularColor * (40.0f / 400.0f);
+	screenGlassMaterial.reflectivity = 0.06f;
+	screenGlassMaterial.tag = "screenGlass";
+	m_objectMaterials.push_back(screenGlassMaterial);
+
+	OBJECT_MATERIAL mugCeramicMaterial = lampShadeMaterial;
+	mugCeramicMaterial.shininess = 60.0f;
+	mugCeramicMaterial.specularColor = lampShadeMaterial.specularColor * (40.0f / 60.0f);
+	mugCeramicMaterial.reflectivity = 0.05f;
+	mugCeramicMaterial.tag = "mugCeramic";
+	m_objectMaterials.push_back(mugCeramicMaterial);
+
+	OBJECT_MATERIAL brushedMetalMaterial = lampShadeMaterial;
+	brushedMetalMaterial.shininess = 20.0f;
+	brushedMetalMaterial.specularColor = lampShadeMaterial.specularColor * (40.0f / 20.0f);
+	brushedMetalMaterial.reflectivity = 0.5f;
+	brushedMetalMaterial.tag = "brushedMetal";
+	m_objectMaterials.push_back(brushedMetalMaterial);
+}
+
+/***********************************************************
+ *  SetupSceneLights() -MK
+ *
+ *  This method is used for setting up the scene lights
+ *  in the shader.  The light sources are defined in the
+ *  shader code.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	// Light from above -MK
+	SetLightSource(0,
+		glm::vec3(0.0f, 10.0f, -10.0f),
+		glm::vec3(-1.05f, -1.05f, -1.02f),	// subtle ambient light -MK
+		glm::vec3(0.25f, 0.25f, 0.12f),		// yellowish diffuse light -MK
+		glm::vec3(0.9f, 0.9f, 0.8f),
+		25.0f,
+		3.0f);
+
+	// Second Light -MK
+	SetLightSource(1,
+		glm::vec3(0.0f, 5.0f, -10.0f),
+		glm::vec3(0.02f, 0.02f, 0.08f),		// subtle blue ambient -MK
+		glm::vec3(0.2f, 0.2f, 0.9f),		// blue light -MK
+		glm::vec3(0.6f, 0.6f, 1.0f),		// bluish highlights -MK
+		15.0f,
+		2.5f);
+
+	// Prevents unused light sources from affecting the scene -MK
+	// Was not able to move the light position without this, so this is a workaround -MK
+	for (int i = 2; i < LIGHT_SOURCE_COUNT; ++i) {
+		SetLightSource(i,
+			glm::vec3(0.0f, 7.0f, -7.0f),
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			0.0f,
+			0.0f);
+	}
+	
+	// Enable lighting system -MK
+	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+
+	// define the materials for objects in the scene -MK
+	DefineObjectMaterials();
+	// add and define the light sources for the scene -MK
+	SetupSceneLights();
+
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadBoxMesh();
+	m_basicMeshes->LoadSphereMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadConeMesh();
+
+	// Load texture images and tag -MK
+	CreateGLTexture("Green_Mouse_Texture.jpg", "mouse");
+
+	// Load texture for lamp -MK
+	CreateGLTexture("metal_Texture.jpg", "lamp");
+
+	// Load textures for the desk -MK
+	CreateGLTexture("wood.jpg", "desk");
+
+	// Bind the loaded textures to OpenGL texture slots -MK
+	BindGLTextures();
+
+	// define the objects that are drawn in the scene
+	DefineSceneObjects();
+
+	// compile the programs for the depth pre-pass and overdraw view
+	CreatePassPrograms();
+	// create the buffer for the view values of each viewport
+	CreateViewBlockBuffer();
+	// place the probes that the reflective objects read from
+	PlaceReflectionProbes();
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the objects that make
+ *  up the 3D scene, using the basic 3D shapes with their
+ *  transformations, colors, textures and materials.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	// the lamp shade material stays set in the shader for every
+	// draw after it, so it is used for all of the scene objects
+	// other than the glossy ones, whose materials light them the
+	// same way and also reflect the reflection probes
+	const char* sceneMaterial = "lampShade";
+
+	// Desk with wood texture -MK
+	BeginObjectGroup("Desk");
+	AddSceneObject(MESH_PLANE,
+		glm::vec3(16.0f, 5.0f, 7.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), "desk", sceneMaterial);
+
+	// ***START OF LAPTOP***
+	BeginObjectGroup("Laptop");
+
+	// Laptop Base - dark green color -MK
+	// the edges are rounded at full size, so the scale stays at 1
+	AddGeneratedObject(MeshGenerator::RoundedBox(glm::vec3(9.0f, 0.4f, 6.0f), 0.15f, 4),
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.2f, 0.0f),
+		glm::vec4(0.2f, 0.3f, 0.2f, 1.0f), "", sceneMaterial);
+
+	// the lid of the screen closes part of the way about its hinge
+	// and opens again, easing in and out of each rest
+	const AnimationSystem::KEYFRAME lidKeyframes[] =
+	{
+		{ 0.0f, glm::vec3(0.0f) },
+		{ 1.5f, glm::vec3(0.0f) },
+		{ 3.5f, glm::vec3(70.0f, 0.0f, 0.0f) },
+		{ 5.0f, glm::vec3(70.0f, 0.0f, 0.0f) },
+		{ 7.0f, glm::vec3(0.0f) }
+	};
+	int lidTrack = m_animationSystem.AddTrack(AnimationSystem::INTERPOLATE_SPLINE, lidKeyframes, 5);
+	SetObjectAnimation(m_animationSystem.AddClip(AnimationSystem::PLAYBACK_LOOP, -1, lidTrack, -1),
+		glm::vec3(0.0f, 0.3f, -1.82f));
+
+	// Laptop Screen - black screen frame -MK
+	AddSceneObject(MESH_BOX,
+		glm::vec3(9.0f, 6.0f, 0.2f), -15.0f, 0.0f, 0.0f, glm::vec3(0.0f, 3.2f, -2.6f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), "", sceneMaterial);
+
+	// Laptop Screen Display - blue screen color -MK
+	AddSceneObject(MESH_BOX,
+		glm::vec3(8.4f, 5.4f, 0.1f), -15.0f, 0.0f, 0.0f, glm::vec3(0.0f, 3.2f, -2.64f),
+		glm::vec4(0.1f, 0.3f, 0.8f, 1.0f), "", "screenGlass");
+
+	SetObjectAnimation(-1, glm::vec3(0.0f));
+
+	// Small Touchpad - gray touchpad color -MK
+	AddSceneObject(MESH_BOX,
+		glm::vec3(1.6f, 0.1f, 1.2f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.44f, 1.6f),
+		glm::vec4(0.3f, 0.3f, 0.3f, 1.0f), "", sceneMaterial);
+
+	// Keyboard - dark colored keyboard -MK
+	AddSceneObject(MESH_BOX,
+		glm::vec3(7.0f, 0.1f, 2.4f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.44f, -1.0f),
+		glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), "", sceneMaterial);
+
+	// ***END OF LAPTOP***
+
+	// ***START OF MOUSE***
+	BeginObjectGroup("Mouse");
+
+	// the mouse can be moved around the desk, so it keeps its own
+	// draw rather than being merged with the rest of the desk
+	SetObjectsStatic(false);
+
+	// Mouse body with green texture, from a model scaled to fit the
+	// unit sphere when one is provided -MK
+	AddImportedObject("Models/mouse.obj", MESH_SPHERE,
+		glm::vec3(1.2f, 0.6f, 2.0f), 0.0f, 0.0f, 0.0f, glm::vec3(7.0f, 0.35f, 2.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), "mouse", sceneMaterial);
+
+	SetObjectsStatic(true);
+
+	// ***END OF MOUSE***
+
+	// *** START OF LAMP***
+	BeginObjectGroup("Lamp");
+
+	// Lamp BASE - gray color -MK
+	AddSceneObject(MESH_CYLINDER,
+		glm::vec3(2.0f, 0.2f, 2.0f), 0.0f, 0.0f, 0.0f, glm::vec3(-12.0f, 0.1f, 0.0f),
+		glm::vec4(0.25f, 0.25f, 0.25f, 1.0f), "", sceneMaterial);
+
+	// Lamp Stand with metal texture -MK
+	AddSceneObject(MESH_CYLINDER,
+		glm::vec3(0.25f, 6.0f, 0.25f), 0.0f, 0.0f, 0.0f, glm::vec3(-12.0f, 0.7f, 0.0f),
+		glm::vec4(0.30f, 0.30f, 0.30f, 1.0f), "lamp", "brushedMetal");
+
+	// the shade swings from side to side about the stand and
+	// back again
+	const AnimationSystem::KEYFRAME shadeKeyframes[] =
+	{
+		{ 0.0f, glm::vec3(0.0f, -25.0f, 0.0f) },
+		{ 2.5f, glm::vec3(0.0f, 25.0f, 0.0f) }
+	};
+	int shadeTrack = m_animationSystem.AddTrack(AnimationSystem::INTERPOLATE_SPLINE, shadeKeyframes, 2);
+	SetObjectAnimation(m_animationSystem.AddClip(AnimationSystem::PLAYBACK_PING_PONG, -1, shadeTrack, -1),
+		glm::vec3(-12.0f, 6.7f, 0.0f));
+
+	// Lamp Shade - light cream color, an open tapered shade in
+	// place of the solid cone -MK
+	AddGeneratedObject(MeshGenerator::Cylinder(32, 1.0f, 0.4f, 1.0f, 0.96f, false, false),
+		glm::vec3(2.0f, 1.5f, 3.0f), 10.0f, 0.0f, 125.0f, glm::vec3(-12.0f, 7.9f, 0.0f),
+		glm::vec4(0.85f, 0.85f, 0.7f, 1.0f), "", "lampShade");
+	AddSceneObject(MESH_SPHERE,
+		glm::vec3(2.0f, 1.5f, 3.0f), 10.0f, 0.0f, 125.0f, glm::vec3(-12.0f, 7.9f, 0.0f),
+		glm::vec4(0.85f, 0.85f, 0.7f, 1.0f), "", "lampShade");
+
+	SetObjectAnimation(-1, glm::vec3(0.0f));
+
+	// *** END OF LAMP ***
+
+	// *** START OF BOOK STACK *** -MK
+	BeginObjectGroup("Book stack");
+
+	// Bottom book - green color -MK
+	AddGeneratedObject(MeshGenerator::RoundedBox(glm::vec3(3.5f, 0.6f, 2.5f), 0.04f, 2),
+		glm::vec3(1.0f), 0.0f, 5.0f, 0.0f, glm::vec3(8.0f, 0.3f, -3.2f),
+		glm::vec4(0.0f, 0.5f, 0.0f, 1.0f), "", sceneMaterial);
+
+	// Top book - blue color -MK
+	AddGeneratedObject(MeshGenerator::RoundedBox(glm::vec3(3.5f, 0.6f, 2.5f), 0.04f, 2),
+		glm::vec3(1.0f), 0.0f, -5.0f, 0.0f, glm::vec3(8.0f, 0.9f, -3.2f),
+		glm::vec4(0.1f, 0.1f, 0.6f, 1.0f), "", sceneMaterial);
+
+	// *** END OF BOOK STACK ***
+
+	// *** START OF COFFEE MUG *** - MK
+	BeginObjectGroup("Coffee mug");
+
+	// Mug body - white hollow mug with a closed bottom, front left of desk -MK
+	AddGeneratedObject(MeshGenerator::Cylinder(32, 0.8f, 0.8f, 1.2f, 0.9f, false, true),
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(-7.5f, 0.6f, 2.5f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), "", "mugCeramic");
+
+	// Mug top - dark gray coffee inside the mug -MK
+	AddGeneratedObject(MeshGenerator::Cylinder(32, 0.72f, 0.72f, 0.05f),
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(-7.5f, 1.55f, 2.5f),
+		glm::vec4(0.2f, 0.2f, 0.2f, 1.0f), "", sceneMaterial);
+
+	// Mug handle - half of a torus on the side of the mug -MK
+	AddGeneratedObject(MeshGenerator::Torus(24, 12, 0.35f, 0.07f, 180.0f),
+		glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(-6.7f, 1.2f, 2.5f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), "", "mugCeramic");
+
+	// *** END OF COFFEE MUG ***
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the scene objects into each viewport.  The work
+ *  that does not depend on the view is done once for the
+ *  frame, and the view values of every viewport are
+ *  uploaded together before any of them are drawn.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	bool bDepthPrepass = false;
+	bool bDepthEqualTest = true;
+	bool bShowOverdraw = false;
+
+	if (NULL != m_pRenderSettings)
+	{
+		bDepthPrepass = m_pRenderSettings->bDepthPrepass && (0 != m_depthProgramID);
+		bDepthEqualTest = m_pRenderSettings->bDepthEqualTest;
+		bShowOverdraw = m_pRenderSettings->bShowOverdraw && (0 != m_overdrawProgramID);
+	}
+
+	// the memory used by the previous frame can be reused
+	m_frameArena.Reset();
+	m_bSceneChanged = false;
+	m_textureStreamer.BeginFrame();
+
+	// move the animated objects before anything is drawn, with
+	// the timing asked for once, before the first frame
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->animationBenchmarkUpdates > 0))
+	{
+		BenchmarkAnimation(m_pRenderSettings->animationBenchmarkUpdates);
+		m_pRenderSettings->animationBenchmarkUpdates = 0;
+	}
+	UpdateAnimations();
+
+	// collect an object ID picked by an earlier frame, once the
+	// GPU has finished copying it
+	int pickedObject = -1;
+	if (m_objectPicker.ReadGPUPick(pickedObject))
+	{
+		ReportPick(pickedObject, "GPU ID buffer");
+	}
+
+	// the software rasterizer or the Vulkan renderer draws the
+	// whole frame on its own, unless it is about to be timed
+	// against OpenGL
+	if ((NULL != m_pRenderSettings) &&
+		(m_pRenderSettings->bSoftwareRasterizer || m_pRenderSettings->bVulkanBackend) &&
+		(m_pRenderSettings->softwareBenchmarkFrames <= 0))
+	{
+		RenderSceneBackend(GetSceneBackend());
+		return;
+	}
+
+	// merge the static objects again after scene changes
+	m_bStaticBatching = (NULL != m_pRenderSettings) && m_pRenderSettings->bStaticBatching;
+	m_bBakedLighting = m_bStaticBatching && m_pRenderSettings->bBakedLighting && (0 != m_bakedProgramID);
+	if (m_bBakedLighting && (false == m_bStaticBatchesBaked))
+	{
+		m_bStaticBatchesDirty = true;
+	}
+	if (m_bStaticBatching && m_bStaticBatchesDirty)
+	{
+		BuildStaticBatches();
+		m_bGPUCullerDirty = true;
+	}
+	if (m_bStaticBatching != m_bGPUCullerBatched)
+	{
+		m_bGPUCullerDirty = true;
+	}
+
+	// write the draw commands of the objects culled on the GPU for
+	// every viewport at once, rebuilding them after scene changes
+	m_bGPUCulling = false;
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bGPUCulling &&
+		m_gpuCuller.IsAvailable() && (0 != m_indirectDepthProgramID) && (0 != m_indirectOverdrawProgramID))
+	{
+		if (m_bGPUCullerDirty)
+		{
+			BuildGPUCuller();
+		}
+		m_bGPUCulling = m_gpuCuller.IsBuilt();
+	}
+	m_bOcclusionCulling = m_bGPUCulling && m_pRenderSettings->bOcclusionCulling && m_depthPyramid.IsAvailable();
+	if (m_bGPUCulling)
+	{
+		m_gpuCuller.Cull(m_sceneViews, m_sceneViewCount, m_bOcclusionCulling ? &m_depthPyramid : NULL);
+		ReportCullStatistics();
+	}
+
+	// the other passes of the frame use their own programs
+	m_pShaderManager->use();
+
+	// reloaded programs need the lights set again
+	if ((NULL != m_pShaderCache) && (m_pShaderCache->GetGeneration() != m_shaderGeneration))
+	{
+		m_shaderGeneration = m_pShaderCache->GetGeneration();
+		m_boundPermutation = -1;
+		for (int i = 0; i < ShaderCache::PERMUTATION_COUNT; i++)
+		{
+			m_bPermutationLightsSet[i] = false;
+		}
+	}
+
+	// the opaque objects are drawn into the G-buffer and lit once
+	// per pixel, unless the overdraw of the forward passes is shown
+	m_shadingPath = SHADING_FORWARD;
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bDeferredShading &&
+		m_deferredRenderer.IsAvailable() && (false == bShowOverdraw))
+	{
+		m_shadingPath = SHADING_DEFERRED;
+		bDepthPrepass = false;
+	}
+
+	// one out of date reflection probe is captured each frame, so
+	// a change to the scene does not stall a single frame
+	m_bReflectionProbes = (NULL != m_pRenderSettings) && m_pRenderSettings->bReflectionProbes &&
+		(m_reflectionProbes.GetProbeCount() > 0) && (false == bShowOverdraw);
+	if (m_bReflectionProbes)
+	{
+		int dirtyProbe = m_reflectionProbes.FindDirtyProbe();
+		if (dirtyProbe >= 0)
+		{
+			CaptureReflectionProbe(dirtyProbe);
+		}
+	}
+
+	UploadViewBlocks();
+
+	// the timing is asked for once, before the first frame
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->softwareBenchmarkFrames > 0))
+	{
+		BenchmarkRasterizers(m_pRenderSettings->softwareBenchmarkFrames);
+		m_pRenderSettings->softwareBenchmarkFrames = 0;
+	}
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->deferredBenchmarkFrames > 0))
+	{
+		BenchmarkShading(m_pRenderSettings->deferredBenchmarkFrames);
+		m_pRenderSettings->deferredBenchmarkFrames = 0;
+	}
+
+	// the G-buffer covers every viewport, and is cleared before
+	// the scissor test is turned on
+	if (SHADING_DEFERRED == m_shadingPath)
+	{
+		int width = 0;
+		int height = 0;
+		GetSceneViewExtent(width, height);
+		SetDeferredLights(NULL, 0);
+		if (false == m_deferredRenderer.BeginFrame(width, height))
+		{
+			m_shadingPath = SHADING_FORWARD;
+		}
+	}
+
+	if (bShowOverdraw)
+	{
+		// the overdraw colors accumulate over a black background
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		// count the fragments shaded by the opaque and blended passes
+		ReportShadedFragments();
+		if (false == m_bSamplesQueryActive)
+		{
+			glBeginQuery(GL_SAMPLES_PASSED, m_samplesQueryID);
+		}
+	}
+
+	// the viewports do not overlap, so the frame was already
+	// cleared for all of them - the scissor test only keeps
+	// wide lines and points inside their own viewport
+	if (m_sceneViewCount > 1)
+	{
+		glEnable(GL_SCISSOR_TEST);
+	}
+	if (m_bOcclusionCulling)
+	{
+		// the objects hidden by the previous frame are tested again
+		// once the opaque objects of every viewport are drawn, and
+		// the ones in view are drawn before the blended objects
+		for (int i = 0; i < m_sceneViewCount; i++)
+		{
+			RenderSceneView(i, SCENE_PASS_OPAQUE, bDepthPrepass, bDepthEqualTest, bShowOverdraw);
+		}
+		glDisable(GL_SCISSOR_TEST);
+		RetestOccludedObjects();
+		if (m_sceneViewCount > 1)
+		{
+			glEnable(GL_SCISSOR_TEST);
+		}
+		for (int i = 0; i < m_sceneViewCount; i++)
+		{
+			RenderSceneView(i, SCENE_PASS_BLENDED, bDepthPrepass, bDepthEqualTest, bShowOverdraw);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < m_sceneViewCount; i++)
+		{
+			RenderSceneView(i, SCENE_PASS_ALL, bDepthPrepass, bDepthEqualTest, bShowOverdraw);
+		}
+	}
+	if (m_sceneViewCount > 1)
+	{
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	if (bShowOverdraw && (false == m_bSamplesQueryActive))
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		m_bSamplesQueryActive = true;
+	}
+
+	// the object IDs for a pick are drawn after the frame
+	if (m_bPickPending)
+	{
+		RenderObjectIDs();
+	}
+
+	StreamTextureLevels();
+}
+
+/***********************************************************
+ *  StreamTextureLevels()
+ *
+ *  This method is used for streaming in the texture levels
+ *  that the drawn objects asked for, which the next frame
+ *  samples from, within the texture budget.
+ ***********************************************************/
+void SceneManager::StreamTextureLevels()
+{
+	size_t textureBudget = SIZE_MAX;
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->textureBudgetMB > 0))
+	{
+		textureBudget = (size_t)m_pRenderSettings->textureBudgetMB * 1024 * 1024;
+	}
+	m_textureStreamer.Update(textureBudget);
+}
+
+/***********************************************************
+ *  SetViewValues()
+ *
+ *  This method is used for setting the view values of the
+ *  viewport being drawn, with the frustum planes and pixel
+ *  scale that its objects are culled and streamed with.
+ ***********************************************************/
+void SceneManager::SetViewValues(const SCENE_VIEW& sceneView)
+{
+	m_viewMatrix = sceneView.view;
+	m_projectionMatrix = sceneView.projection;
+	m_viewPosition = sceneView.viewPosition;
+	ExtractFrustumPlanes(m_projectionMatrix * m_viewMatrix, m_frustumPlanes);
+	m_bOrthographicView = (m_projectionMatrix[3][3] == 1.0f);
+	m_viewPixelScale = m_projectionMatrix[1][1] * (float)sceneView.height * 0.5f;
+}
+
+/***********************************************************
+ *  RenderSceneView()
+ *
+ *  This method is used for drawing the scene objects of the
+ *  passed in passes into one viewport.  Opaque objects are
+ *  drawn front-to-back, optionally after a depth pre-pass,
+ *  and blended objects are drawn back-to-front after them.
+ ***********************************************************/
+void SceneManager::RenderSceneView(int viewIndex, int scenePasses, bool bDepthPrepass, bool bDepthEqualTest, bool bShowOverdraw)
+{
+	const SCENE_VIEW& sceneView = m_sceneViews[viewIndex];
+
+	m_currentView = viewIndex;
+	glViewport(sceneView.x, sceneView.y, sceneView.width, sceneView.height);
+	glScissor(sceneView.x, sceneView.y, sceneView.width, sceneView.height);
+	if (0 != m_viewBlockBufferID)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BLOCK_BINDING, m_viewBlockBufferID,
+			(GLintptr)m_viewBlockStride * viewIndex, sizeof(VIEW_BLOCK));
+	}
+
+	SetViewValues(sceneView);
+
+	// permutations without the view block need the view values
+	// of this viewport, and so does the single program that is
+	// used when there are no permutations
+	m_frameIndex++;
+	if ((NULL == m_pShaderCache) || (false == m_pShaderCache->IsLoaded()))
+	{
+		m_pShaderManager->setMat4Value(g_ViewName, m_viewMatrix);
+		m_pShaderManager->setMat4Value(g_ProjectionName, m_projectionMatrix);
+		m_pShaderManager->setVec3Value(g_ViewPositionName, m_viewPosition);
+	}
+
+	// order the visible scene objects for this viewport
+	SortRenderQueues(scenePasses);
+
+	if ((0 != (scenePasses & SCENE_PASS_OPAQUE)) && (SHADING_FORWARD != m_shadingPath))
+	{
+		// the deferred renderer shades the opaque objects with its
+		// own programs, and lights each pixel of the G-buffer once,
+		// so there is no depth pre-pass
+		if (SHADING_DEFERRED == m_shadingPath)
+		{
+			m_deferredRenderer.BeginGeometryPass();
+			RenderDeferredSurfaces();
+			m_deferredRenderer.RenderLighting(sceneView, m_frameArena);
+		}
+		else
+		{
+			glDisable(GL_BLEND);
+			m_deferredRenderer.BeginForwardPass();
+			RenderDeferredSurfaces();
+		}
+		m_pShaderManager->use();
+	}
+	else if (0 != (scenePasses & SCENE_PASS_OPAQUE))
+	{
+		if (bDepthPrepass)
+		{
+			RenderDepthPrepass();
+
+			// the depth buffer already holds the nearest surfaces, so
+			// only the fragments that match it need to be shaded
+			glDepthMask(GL_FALSE);
+			glDepthFunc(bDepthEqualTest ? GL_EQUAL : GL_LEQUAL);
+		}
+
+		// opaque objects do not need blending, and the static batches
+		// hold the largest surfaces, so they are drawn first
+		glDisable(GL_BLEND);
+		RenderBatchQueue(bShowOverdraw);
+		if (bShowOverdraw)
+		{
+			RenderOverdrawQueue(m_opaqueQueue);
+		}
+		else
+		{
+			RenderQueue(m_opaqueQueue);
+		}
+		if (m_bGPUCulling)
+		{
+			RenderCulledObjects(bShowOverdraw, GPUCuller::COMMANDS_VISIBLE);
+		}
+	}
+
+	if (0 != (scenePasses & SCENE_PASS_BLENDED))
+	{
+		// the objects that came into view since the previous frame
+		// are opaque, and are drawn before the blended objects that
+		// may cover them
+		if (m_bOcclusionCulling)
+		{
+			glDisable(GL_BLEND);
+			glDepthMask(GL_TRUE);
+			glDepthFunc(GL_LESS);
+			RenderCulledObjects(bShowOverdraw, GPUCuller::COMMANDS_RETESTED);
+		}
+
+		// the reflections go over every opaque surface that they
+		// belong to, and under the blended objects
+		if (m_bReflectionProbes)
+		{
+			RenderReflections();
+		}
+
+		// blended objects are drawn over the opaque objects without
+		// writing depth, so the objects behind them still show
+		glEnable(GL_BLEND);
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LESS);
+		if (bShowOverdraw)
+		{
+			RenderOverdrawQueue(m_blendedQueue);
+		}
+		else
+		{
+			RenderQueue(m_blendedQueue);
+		}
+	}
+
+	// restore the default depth state for the next viewport
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
 }
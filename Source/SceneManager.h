@@ -10,9 +10,29 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderCache.h"
 #include "ShapeMeshes.h"
+#include "MeshGenerator.h"
+#include "MeshImporter.h"
+#include "RenderSettings.h"
+#include "FrameAllocator.h"
+#include "SceneView.h"
+#include "ObjectPicker.h"
+#include "TextureStreamer.h"
+#include "GPUCuller.h"
+#include "StaticBatcher.h"
+#include "SoftwareRasterizer.h"
+#include "VulkanRenderer.h"
+#include "LightBaker.h"
+#include "DeferredRenderer.h"
+#include "ReflectionProbes.h"
+#include "EntityRegistry.h"
+#include "AnimationSystem.h"
+#include "WorkerPool.h"
 
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /***********************************************************
@@ -45,20 +65,276 @@ public:
 		glm::vec3 diffuseColor;
 		glm::vec3 specularColor;
 		float shininess;
+		// the share of the light that a surface facing the viewer
+		// reflects from the reflection probes, or 0 for none
+		float reflectivity;
 		std::string tag;
 	};
 
+	// the basic shape meshes that scene objects can be drawn with
+	enum MESH_TYPE
+	{
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_SPHERE,
+		MESH_CYLINDER,
+		MESH_CONE,
+		// a mesh built by the mesh generator
+		MESH_GENERATED,
+		// a mesh loaded from a model file
+		MESH_IMPORTED
+	};
+
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		// index of the mesh in the mesh generator or mesh
+		// importer, or -1 for the basic shape meshes
+		int meshIndex;
+		glm::mat4 modelMatrix;
+		glm::vec4 color;
+		// texture slot and material index, or -1 if not used
+		int textureSlot;
+		int materialIndex;
+		// world space bounding box of the transformed mesh
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// drawn in the back-to-front transparent pass
+		bool bBlended;
+		// the named group the object belongs to, or -1
+		int groupIndex;
+		// index of the object in the GPU culler, or -1 when it is
+		// culled on the CPU
+		int cullIndex;
+		// the object never moves, so it can be merged into a static
+		// batch, and the batch it is merged into or -1
+		bool bStatic;
+		int batchIndex;
+		// the entity that places the object, and plays its clip
+		// when it is animated
+		ENTITY entity;
+	};
+
+	// an object to draw in a render pass, with its sort key
+	struct RENDER_PACKET
+	{
+		int objectIndex;
+		float viewDepth;
+	};
+
+	// the packets to draw in a render pass for the frame
+	struct RENDER_QUEUE
+	{
+		RENDER_PACKET* pPackets;
+		int count;
+	};
+
+	// set the options used for rendering the scene
+	void SetRenderSettings(RENDER_SETTINGS* pRenderSettings);
+	// set the cache of specialized shader programs
+	void SetShaderCache(ShaderCache* pShaderCache);
+	// set the viewports that the scene is drawn into
+	void SetSceneViews(const SCENE_VIEW* pSceneViews, int sceneViewCount);
+	// check whether the scene has changed since the last frame
+	bool HasSceneChanged() const;
+	// pick the object under a pixel of the scene target
+	void PickObject(glm::vec2 pixel);
+	// get the index of the last picked object, or -1 if none
+	int GetSelectedObject() const { return m_selectedObject; }
+	// check whether the Vulkan renderer was asked for but could not
+	// start, so the software rasterizer drew the frames instead
+	bool HasVulkanFailed() const { return m_bVulkanFailed; }
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// cache of the generated shape meshes
+	MeshGenerator m_meshGenerator;
+	// meshes loaded from model files
+	MeshImporter m_meshImporter;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
+	// uploads the mip levels of the textures that the drawn
+	// objects need, with the texture index matching the slot
+	TextureStreamer m_textureStreamer;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// objects that make up the 3D scene
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// names of the groups of objects that are picked together,
+	// and the group that added objects are put in
+	std::vector<std::string> m_objectGroups;
+	int m_currentGroup;
+	// the opaque and blended scene objects, which are the same
+	// for every frame and viewport
+	std::vector<int> m_opaqueObjects;
+	std::vector<int> m_blendedObjects;
+	// true when the scene objects changed since the last frame
+	bool m_bSceneChanged;
+	// memory for the transient data of the current frame
+	FrameArena m_frameArena;
+	// draw order of the opaque and blended objects for the frame,
+	// and of the static batches, whose packets hold batch indices
+	RENDER_QUEUE m_opaqueQueue;
+	RENDER_QUEUE m_blendedQueue;
+	RENDER_QUEUE m_batchQueue;
+	// the static opaque objects merged into a few meshes
+	StaticBatcher m_staticBatcher;
+	// true when the batches are older than the scene objects
+	bool m_bStaticBatchesDirty;
+	// the static objects are drawn in their batches this frame,
+	// and were when the GPU culler was built
+	bool m_bStaticBatching;
+	bool m_bGPUCullerBatched;
+	// the objects added from now on are static
+	bool m_bAddStaticObjects;
+	// the clip played on the objects added from now on, or -1 for
+	// none, and the point it turns them about
+	int m_addAnimationClip;
+	glm::vec3 m_addAnimationPivot;
+	// the threads that the animation updates and the renderers
+	// outside of the OpenGL context split their work over, which
+	// outlive all of them
+	WorkerPool m_workerPool;
+	// the entities that place the scene objects, and the clips
+	// played on the animated ones, with the time they are played
+	// at and when it was last moved on
+	EntityRegistry m_entityRegistry;
+	AnimationSystem m_animationSystem;
+	double m_animationTime;
+	std::chrono::steady_clock::time_point m_lastAnimationTick;
+	bool m_bAnimationClockRunning;
+	// true while the last update moved a clip on, or the clock was
+	// just started, so another frame is needed to play them
+	bool m_bAnimationsMoving;
+	// the renderers that draw the scene outside of the OpenGL
+	// context when one is turned on, the one that holds the scene
+	// now, and the mesh it holds for each scene object or -1
+	SoftwareRasterizer m_softwareRasterizer;
+	VulkanRenderer m_vulkanRenderer;
+	RenderBackend* m_pSceneBackend;
+	std::vector<int> m_backendMeshes;
+	// true when the meshes of the renderer are older than the
+	// scene objects
+	bool m_bBackendSceneDirty;
+	// whether the renderers were started, and whether starting the
+	// Vulkan renderer failed
+	bool m_bSoftwareThreadsStarted;
+	bool m_bVulkanStarted;
+	bool m_bVulkanFailed;
+	// the values of each light source, for the passes that do
+	// not read them from the scene shader
+	RenderBackend::LIGHT m_lightSources[RenderBackend::MAX_LIGHTS];
+	// the material of the objects that have none
+	OBJECT_MATERIAL m_plainMaterial;
+	// program that draws the static batches with their baked
+	// lighting, whether they are drawn with it this frame, and
+	// whether it was turned on when they were merged
+	GLuint m_bakedProgramID;
+	bool m_bBakedLighting;
+	bool m_bStaticBatchesBaked;
+	// how the opaque objects are shaded - with the scene shader,
+	// into the G-buffer and lit once per pixel afterwards, or with
+	// every light of the deferred renderer for every fragment
+	enum SHADING_PATH
+	{
+		SHADING_FORWARD,
+		SHADING_DEFERRED,
+		SHADING_FORWARD_LIGHT_LIST
+	};
+	// draws the opaque objects into a G-buffer and lights them in
+	// screen tiles, and the path the frame is shaded with
+	DeferredRenderer m_deferredRenderer;
+	SHADING_PATH m_shadingPath;
+	// an opaque object whose material reflects, with the probe
+	// that it reads its reflections from, or -1 for none
+	struct REFLECTIVE_OBJECT
+	{
+		int objectIndex;
+		int probe;
+	};
+	// cubemaps of the static objects around the reflective
+	// objects, the objects that read from them, and whether the
+	// reflections are drawn this frame
+	ReflectionProbes m_reflectionProbes;
+	std::vector<REFLECTIVE_OBJECT> m_reflectiveObjects;
+	bool m_bReflectionProbes;
+	// options for rendering the scene
+	RENDER_SETTINGS* m_pRenderSettings;
+	// viewports that the frame is drawn into
+	SCENE_VIEW m_sceneViews[MAX_SCENE_VIEWS];
+	int m_sceneViewCount;
+	// buffer holding the view block of every viewport, and the
+	// distance between the blocks in bytes
+	GLuint m_viewBlockBufferID;
+	GLint m_viewBlockStride;
+	// view values and frustum planes of the viewport being drawn
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	glm::vec4 m_frustumPlanes[6];
+	// pixels covered by one unit of size at a view distance of
+	// one, or at any distance in an orthographic viewport
+	float m_viewPixelScale;
+	bool m_bOrthographicView;
+	// shader programs for the depth pre-pass, overdraw view and
+	// object IDs
+	GLuint m_depthProgramID;
+	GLuint m_overdrawProgramID;
+	GLuint m_pickProgramID;
+	// culls the opaque generated and imported objects and picks
+	// their level of detail on the GPU
+	GPUCuller m_gpuCuller;
+	// true when the culled objects are older than the scene
+	bool m_bGPUCullerDirty;
+	// the objects are culled on the GPU this frame
+	bool m_bGPUCulling;
+	// the farthest depths of the frame, which the objects culled
+	// on the GPU are tested against when occlusion culling is on
+	DepthPyramid m_depthPyramid;
+	bool m_bOcclusionCulling;
+	// culling counts read back from the GPU since the last report
+	GPUCuller::CULL_STATISTICS m_cullTotals;
+	int m_cullFrameCount;
+	// the scene objects added to the GPU culler, in the order of
+	// their cull index
+	std::vector<int> m_culledObjects;
+	// the viewport being drawn, which selects its draw commands
+	int m_currentView;
+	// shader programs for the depth pre-pass and overdraw view of
+	// the objects drawn with the culling commands
+	GLuint m_indirectDepthProgramID;
+	GLuint m_indirectOverdrawProgramID;
+	// finds the object under the cursor
+	ObjectPicker m_objectPicker;
+	// true when the picking hierarchy is older than the objects
+	bool m_bPickHierarchyDirty;
+	// object IDs are drawn this frame for a pixel of a viewport
+	bool m_bPickPending;
+	int m_pickView;
+	glm::vec2 m_pickPixel;
+	// the last picked object, or -1 if none
+	int m_selectedObject;
+	// query for counting the fragments shaded by the scene
+	GLuint m_samplesQueryID;
+	bool m_bSamplesQueryActive;
+	GLuint64 m_shadedFragments;
+	int m_shadedFrameCount;
+	// cache of specialized shader programs
+	ShaderCache* m_pShaderCache;
+	// build of the cached programs that the lights were set for
+	unsigned int m_shaderGeneration;
+	// currently active permutation, or -1 if unknown
+	int m_boundPermutation;
+	// the viewport index that the view values were set in each
+	// permutation, and whether the lights were set in it
+	int m_frameIndex;
+	int m_permutationFrame[ShaderCache::PERMUTATION_COUNT];
+	bool m_bPermutationLightsSet[ShaderCache::PERMUTATION_COUNT];
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -67,10 +343,11 @@ private:
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(std::string_view tag);
+	int FindTextureSlot(std::string_view tag);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string_view tag);
+	bool FindMaterial(std::string_view tag, OBJECT_MATERIAL& material);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -90,7 +367,9 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		std::string_view textureTag);
+	void SetShaderTextureSlot(
+		int textureSlot);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -98,7 +377,191 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		std::string_view materialTag);
+	void SetShaderMaterialIndex(
+		int materialIndex);
+
+	// set the values of a light source into the shader
+	void SetLightSource(
+		int light,
+		glm::vec3 position,
+		glm::vec3 ambientColor,
+		glm::vec3 diffuseColor,
+		glm::vec3 specularColor,
+		float focalStrength,
+		float specularIntensity);
+
+	// calculate the model matrix from the transformation values
+	glm::mat4 CalculateModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// add an object to the list of scene objects
+	void AddSceneObject(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		std::string_view textureTag,
+		std::string_view materialTag,
+		int meshIndex = -1);
+	// add an object drawn with a generated mesh
+	void AddGeneratedObject(
+		const MeshGenerator::SHAPE_PARAMETERS& shape,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		std::string_view textureTag,
+		std::string_view materialTag);
+	// add an object drawn with a mesh from a model file, or with a
+	// basic shape mesh if the model file cannot be loaded
+	void AddImportedObject(
+		const char* modelPath,
+		MESH_TYPE fallbackMesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		std::string_view textureTag,
+		std::string_view materialTag);
+	// put the objects added after this in a named group
+	void BeginObjectGroup(const char* name);
+	// mark the objects added after this as static, so they can be
+	// merged into batches, or as dynamic
+	void SetObjectsStatic(bool bStatic);
+	// play a clip on the objects added after this, turning them
+	// about a pivot, or -1 to add still objects - animated objects
+	// are always dynamic
+	void SetObjectAnimation(int clip, glm::vec3 pivot);
+	// define the objects that make up the 3D scene
+	void DefineSceneObjects();
+
+	// compile the shader programs used by the extra render passes
+	bool CreatePassPrograms();
+	// create the buffer that holds the view block of each viewport
+	void CreateViewBlockBuffer();
+	// copy the view values of every viewport into the view blocks
+	void UploadViewBlocks();
+	// the parts of the scene drawn into a viewport at once
+	enum SCENE_PASS
+	{
+		SCENE_PASS_OPAQUE = 1,
+		SCENE_PASS_BLENDED = 2,
+		SCENE_PASS_ALL = SCENE_PASS_OPAQUE | SCENE_PASS_BLENDED
+	};
+
+	// set the view values and frustum of the viewport being drawn
+	void SetViewValues(const SCENE_VIEW& sceneView);
+	// draw the scene into one of the viewports
+	void RenderSceneView(int viewIndex, int scenePasses, bool bDepthPrepass, bool bDepthEqualTest, bool bShowOverdraw);
+	// sort the visible scene objects of the passes into the draw
+	// queues for the viewport being drawn
+	void SortRenderQueues(int scenePasses);
+	// request the texture level that a drawn object or batch needs
+	// for the size of its bounds in the viewport being drawn
+	void RequestTextureLevel(int textureSlot, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float viewDepth);
+	// add the opaque objects with generated or imported meshes
+	// to the GPU culler
+	void BuildGPUCuller();
+	// merge the static opaque objects into batches
+	void BuildStaticBatches();
+	// split the merged static batches into smaller triangles and
+	// bake their lighting - returns false if nothing was baked
+	bool BakeStaticLighting();
+	// get the material of an object, or the plain material for
+	// an object without one
+	const OBJECT_MATERIAL& GetObjectMaterial(int materialIndex) const;
+	// get the vertex and index data of the mesh of an object, for
+	// the meshes whose data can be built or read back, optionally
+	// with stand-ins for the curved basic shapes
+	bool GetObjectMeshData(const SCENE_OBJECT& object, MeshGenerator::MESH_DATA& meshData, bool bApproximateCurved = false);
+	// draw the mesh used by a scene object
+	void DrawMesh(const SCENE_OBJECT& object);
+	// make the shader permutation for textured or untextured
+	// drawing active
+	void BindShaderPermutation(bool bTextured);
+	// draw the opaque objects into the depth buffer only
+	void RenderDepthPrepass();
+	// set the values of a scene object into the scene shader
+	void SetObjectShaderValues(const SCENE_OBJECT& object);
+	// draw the objects in a queue with the scene shader
+	void RenderQueue(const RENDER_QUEUE& queue);
+	// draw the static batches in the batch queue with the scene
+	// shader or the overdraw shader
+	void RenderBatchQueue(bool bShowOverdraw);
+	// draw the static batches in the batch queue that have baked
+	// lighting with the baked lighting program
+	void RenderBakedBatches();
+	// draw the objects culled on the GPU with the scene shader or
+	// the overdraw shader
+	void RenderCulledObjects(bool bShowOverdraw, GPUCuller::COMMAND_SET commandSet);
+	// get the area of the target that holds the viewports
+	void GetSceneViewExtent(int& width, int& height) const;
+	// test the objects hidden by the previous frame again against
+	// the depth drawn so far in this frame
+	void RetestOccludedObjects();
+	// give the light sources and the materials to the deferred
+	// renderer, with extra lights that reach as far as their radius
+	void SetDeferredLights(const DeferredRenderer::LIGHT* pExtraLights, int extraLightCount);
+	// draw the opaque objects of the viewport being drawn with the
+	// active program of the deferred renderer
+	void RenderDeferredSurfaces();
+	// place a reflection probe at each group of reflective objects
+	void PlaceReflectionProbes();
+	// capture the static objects around a probe into its cubemap
+	void CaptureReflectionProbe(int probe);
+	// draw the reflections of the reflective objects in the
+	// viewport being drawn over their lit surfaces
+	void RenderReflections();
+	// report the draws saved by occlusion culling
+	void ReportCullStatistics();
+	// draw the objects in a queue with the overdraw shader
+	void RenderOverdrawQueue(const RENDER_QUEUE& queue);
+	// report the fragments shaded by the previous frames
+	void ReportShadedFragments();
+	// draw the object IDs under the picked pixel
+	void RenderObjectIDs();
+	// report and select a picked object
+	void ReportPick(int objectIndex, const char* method);
+	// get the renderer that draws outside of the OpenGL context,
+	// starting it the first time
+	RenderBackend* GetSceneBackend();
+	// give the meshes and textures of the scene to a renderer when
+	// it does not hold them yet
+	void BuildBackendScene(RenderBackend* pBackend);
+	// draw every viewport with a renderer and copy the frames into
+	// the scene target
+	void RenderSceneBackend(RenderBackend* pBackend);
+	// draw one viewport with the renderer that holds the scene
+	void RenderBackendView(int viewIndex, glm::vec4 clearColor);
+	// submit the objects in a queue to the renderer that holds the
+	// scene
+	void SubmitBackendQueue(const RENDER_QUEUE& queue, bool bBlended);
+	// time the first viewport with the renderer outside of the
+	// OpenGL context and with OpenGL
+	void BenchmarkRasterizers(int frameCount);
+	// time the first viewport with forward and deferred shading as
+	// the number of lights grows
+	void BenchmarkShading(int frameCount);
+	// play the clips of the animated entities for the frame and
+	// move the objects they place
+	void UpdateAnimations();
+	// time the updates of the animations on one thread and on all
+	// of them as animated entities are added
+	void BenchmarkAnimation(int updateCount);
+	// stream in the texture levels asked for by the frame
+	void StreamTextureLevels();
 
 public:
 
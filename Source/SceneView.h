@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneview.h
+// ============
+// the view values and window area of each viewport that the
+// scene is rendered into
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+// the most viewports that the scene is rendered into at once
+const int MAX_SCENE_VIEWS = 4;
+
+// one viewport of the scene, with its camera and the area of
+// the window that it covers in pixels
+struct SCENE_VIEW
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 viewPosition;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+// name and binding point of the uniform block that holds the
+// view values of the viewport being drawn
+const char* const VIEW_BLOCK_NAME = "ViewBlock";
+const unsigned int VIEW_BLOCK_BINDING = 0;
+
+// GLSL declaration of the view block, which replaces the view,
+// projection and viewPosition uniforms in the scene shaders
+const char* const VIEW_BLOCK_SOURCE =
+	"layout (std140) uniform ViewBlock\n"
+	"{\n"
+	"	mat4 view;\n"
+	"	mat4 projection;\n"
+	"	vec3 viewPosition;\n"
+	"};\n";
+
+// contents of the view block with the std140 layout, where
+// the view position is padded out to a vec4
+struct VIEW_BLOCK
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPosition;
+};
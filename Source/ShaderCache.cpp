@@ -0,0 +1,648 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.cpp
+// ============
+// manage the specialized shader program permutations, their
+// linked program binaries on disk, and reloading edited shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderCache.h"
+#include "SceneView.h"
+#include "GPUResources.h"
+
+#include <algorithm>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// directory where the linked program binaries are stored
+	const char* g_CacheDirectory = "ShaderCache";
+	// identifies a program binary file written by this class
+	const uint32_t CACHE_FILE_MAGIC = 0x43505353;
+	// bumped whenever the way the permutations are built changes
+	const uint32_t CACHE_FILE_VERSION = 2;
+	// time between checks for edited shader files
+	const std::chrono::milliseconds RELOAD_CHECK_INTERVAL(500);
+
+	// the shader switches that are turned into constants
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_UseLightingName = "bUseLighting";
+	// the view uniforms that are moved into the view block
+	const char* g_ViewUniformPatterns[] =
+	{
+		"uniform\\s+mat4\\s+view\\s*;",
+		"uniform\\s+mat4\\s+projection\\s*;",
+		"uniform\\s+vec3\\s+viewPosition\\s*;"
+	};
+
+	// header at the start of each program binary file
+	struct CACHE_FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	/***********************************************************
+	 *  HashString()
+	 *
+	 *  This function is used for adding the characters of a
+	 *  string into a 64-bit FNV-1a hash value.
+	 ***********************************************************/
+	uint64_t HashString(const std::string& text, uint64_t hash = 14695981039346656037ULL)
+	{
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+
+	/***********************************************************
+	 *  BindViewBlock()
+	 *
+	 *  This function is used for connecting the view block of
+	 *  a linked program to the binding point that the scene
+	 *  manager fills for each viewport.
+	 ***********************************************************/
+	bool BindViewBlock(GLuint programID)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(programID, VIEW_BLOCK_NAME);
+		if (GL_INVALID_INDEX == blockIndex)
+		{
+			return false;
+		}
+
+		glUniformBlockBinding(programID, blockIndex, VIEW_BLOCK_BINDING);
+		return true;
+	}
+
+	/***********************************************************
+	 *  ReadTextFile()
+	 *
+	 *  This function is used for reading the whole contents
+	 *  of a text file into a string.
+	 ***********************************************************/
+	bool ReadTextFile(const std::filesystem::path& filePath, std::string& text)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_READ: " << filePath.string() << std::endl;
+			return false;
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		text = stream.str();
+
+		return true;
+	}
+
+	/***********************************************************
+	 *  GetWriteTime()
+	 *
+	 *  This function is used for getting the last modified
+	 *  time of a file, without throwing if it is missing.
+	 ***********************************************************/
+	std::filesystem::file_time_type GetWriteTime(const std::filesystem::path& filePath)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, error);
+
+		if (error)
+		{
+			return std::filesystem::file_time_type::min();
+		}
+
+		return writeTime;
+	}
+
+	/***********************************************************
+	 *  CompileShader()
+	 *
+	 *  This function is used for compiling a single shader
+	 *  stage from the passed in source code.
+	 ***********************************************************/
+	GLuint CompileShader(GLenum shaderType, const char* shaderSource)
+	{
+		GLint success = 0;
+		GLuint shaderID = glCreateShader(shaderType);
+
+		glShaderSource(shaderID, 1, &shaderSource, NULL);
+		glCompileShader(shaderID);
+		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shaderID, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+			glDeleteShader(shaderID);
+			return 0;
+		}
+
+		return shaderID;
+	}
+}
+
+/***********************************************************
+ *  ShaderCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderCache::ShaderCache(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		m_programIDs[i] = 0;
+	}
+	m_vertexWriteTime = std::filesystem::file_time_type::min();
+	m_fragmentWriteTime = std::filesystem::file_time_type::min();
+	m_lastCheckTime = std::chrono::steady_clock::now();
+	m_bBinarySupported = false;
+	m_bLoaded = false;
+	m_bViewBlock = false;
+	m_generation = 0;
+}
+
+/***********************************************************
+ *  ~ShaderCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderCache::~ShaderCache()
+{
+	DeletePrograms(m_programIDs);
+
+	// the shader manager no longer has a valid program
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->m_programID = 0;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  CompileProgram()
+ *
+ *  This method is used for compiling and linking a shader
+ *  program from the passed in vertex and fragment source.
+ *  A retrievable program can be saved as a program binary.
+ ***********************************************************/
+GLuint ShaderCache::CompileProgram(
+	const char* vertexSource,
+	const char* fragmentSource,
+	bool bRetrievable)
+{
+	GLint success = 0;
+	GLuint vertexID = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentID = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+	if ((0 == vertexID) || (0 == fragmentID))
+	{
+		glDeleteShader(vertexID);
+		glDeleteShader(fragmentID);
+		return 0;
+	}
+
+	GLuint programID = CreateTrackedProgram("compiled program");
+	if (bRetrievable)
+	{
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glAttachShader(programID, vertexID);
+	glAttachShader(programID, fragmentID);
+	glLinkProgram(programID);
+
+	// the shaders are no longer needed once linked
+	glDeleteShader(vertexID);
+	glDeleteShader(fragmentID);
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(programID, 1024, NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		DeleteTrackedProgram(programID);
+		return 0;
+	}
+
+	// the size of the program binary stands in for the memory
+	// that the linked program holds
+	GLint binaryLength = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	SetTrackedResourceSize(GPU_RESOURCE_PROGRAM, programID, (size_t)std::max(binaryLength, 0));
+
+	BindViewBlock(programID);
+
+	return programID;
+}
+
+/***********************************************************
+ *  CompileComputeProgram()
+ *
+ *  This method is used for compiling and linking a compute
+ *  program from the passed in source.
+ ***********************************************************/
+GLuint ShaderCache::CompileComputeProgram(const char* computeSource)
+{
+	GLint success = 0;
+	GLuint computeID = CompileShader(GL_COMPUTE_SHADER, computeSource);
+
+	if (0 == computeID)
+	{
+		return 0;
+	}
+
+	GLuint programID = CreateTrackedProgram("compute program");
+	glAttachShader(programID, computeID);
+	glLinkProgram(programID);
+	glDeleteShader(computeID);
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(programID, 1024, NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		DeleteTrackedProgram(programID);
+		return 0;
+	}
+
+	return programID;
+}
+
+/***********************************************************
+ *  LoadShaders()
+ *
+ *  This method is used for loading the vertex and fragment
+ *  shader files and building all of the permutations, from
+ *  the cached program binaries where possible.
+ ***********************************************************/
+bool ShaderCache::LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	GLint binaryFormats = 0;
+
+	m_vertexShaderPath = vertexShaderPath;
+	m_fragmentShaderPath = fragmentShaderPath;
+
+	// the program binaries are only valid for the same driver
+	m_driverName = std::string((const char*)glGetString(GL_VENDOR)) + "|" +
+		(const char*)glGetString(GL_RENDERER) + "|" +
+		(const char*)glGetString(GL_VERSION);
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+	m_bBinarySupported = (binaryFormats > 0);
+	if (m_bBinarySupported)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(g_CacheDirectory, error);
+	}
+
+	m_vertexWriteTime = GetWriteTime(m_vertexShaderPath);
+	m_fragmentWriteTime = GetWriteTime(m_fragmentShaderPath);
+
+	m_bLoaded = BuildPermutations(m_programIDs);
+	if (m_bLoaded)
+	{
+		m_bViewBlock = BindViewBlock(m_programIDs[0]);
+		m_generation++;
+		Bind(PERMUTATION_TEXTURE | PERMUTATION_LIGHTING);
+	}
+
+	return m_bLoaded;
+}
+
+/***********************************************************
+ *  ReloadIfChanged()
+ *
+ *  This method is used for rebuilding the permutations when
+ *  either shader file has been edited.  If the edited code
+ *  fails to build, the previous programs are kept.
+ ***********************************************************/
+bool ShaderCache::ReloadIfChanged()
+{
+	if (false == m_bLoaded)
+	{
+		return false;
+	}
+
+	// only check the files a couple of times each second
+	std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+	if (currentTime - m_lastCheckTime < RELOAD_CHECK_INTERVAL)
+	{
+		return false;
+	}
+	m_lastCheckTime = currentTime;
+
+	std::filesystem::file_time_type vertexWriteTime = GetWriteTime(m_vertexShaderPath);
+	std::filesystem::file_time_type fragmentWriteTime = GetWriteTime(m_fragmentShaderPath);
+	if ((vertexWriteTime == m_vertexWriteTime) && (fragmentWriteTime == m_fragmentWriteTime))
+	{
+		return false;
+	}
+	m_vertexWriteTime = vertexWriteTime;
+	m_fragmentWriteTime = fragmentWriteTime;
+
+	GLuint programIDs[PERMUTATION_COUNT];
+	if (false == BuildPermutations(programIDs))
+	{
+		std::cout << "ERROR: Edited shaders failed to build, keeping the previous programs" << std::endl;
+		return false;
+	}
+
+	DeletePrograms(m_programIDs);
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		m_programIDs[i] = programIDs[i];
+	}
+	m_bViewBlock = BindViewBlock(m_programIDs[0]);
+	m_generation++;
+	Bind(PERMUTATION_TEXTURE | PERMUTATION_LIGHTING);
+
+	std::cout << "INFO: Reloaded shaders " << m_vertexShaderPath.string() << ", " << m_fragmentShaderPath.string() << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for making a permutation the active
+ *  program, so that the shader manager sets its values into
+ *  that program.
+ ***********************************************************/
+void ShaderCache::Bind(int permutation)
+{
+	if ((false == m_bLoaded) || (NULL == m_pShaderManager))
+	{
+		return;
+	}
+
+	m_pShaderManager->m_programID = m_programIDs[permutation];
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  BuildPermutations()
+ *
+ *  This method is used for building every permutation from
+ *  the current contents of the shader files.
+ ***********************************************************/
+bool ShaderCache::BuildPermutations(GLuint programIDs[PERMUTATION_COUNT])
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		programIDs[i] = 0;
+	}
+
+	if ((false == ReadTextFile(m_vertexShaderPath, vertexSource)) ||
+		(false == ReadTextFile(m_fragmentShaderPath, fragmentSource)))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		programIDs[i] = BuildPermutation(i, vertexSource, fragmentSource);
+		if (0 == programIDs[i])
+		{
+			DeletePrograms(programIDs);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  BuildPermutation()
+ *
+ *  This method is used for building one permutation of the
+ *  shader program.  The cached program binary is used if
+ *  the driver accepts it, otherwise the specialized source
+ *  is compiled and the resulting binary is cached.
+ ***********************************************************/
+GLuint ShaderCache::BuildPermutation(
+	int permutation,
+	const std::string& vertexSource,
+	const std::string& fragmentSource)
+{
+	std::string specializedVertex = SpecializeSource(vertexSource, permutation);
+	std::string specializedFragment = SpecializeSource(fragmentSource, permutation);
+
+	// the key covers everything that changes the linked program
+	uint64_t key = HashString(m_driverName);
+	key = HashString(specializedVertex, key);
+	key = HashString(specializedFragment, key);
+
+	GLuint programID = 0;
+	if (m_bBinarySupported)
+	{
+		programID = LoadProgramBinary(key);
+		if (0 != programID)
+		{
+			// the block binding is not part of the program binary
+			BindViewBlock(programID);
+			return programID;
+		}
+	}
+
+	programID = CompileProgram(
+		specializedVertex.c_str(),
+		specializedFragment.c_str(),
+		m_bBinarySupported);
+	if ((0 != programID) && m_bBinarySupported)
+	{
+		SaveProgramBinary(key, programID);
+	}
+
+	return programID;
+}
+
+/***********************************************************
+ *  SpecializeSource()
+ *
+ *  This method is used for specializing the shader source
+ *  for a permutation.  The permutation defines are inserted
+ *  after the version line, and the texture and lighting
+ *  switch uniforms become constants so that the compiler
+ *  removes the branches that are never taken.  The view
+ *  uniforms are replaced by the view block, which is set
+ *  once per viewport for every program instead of once in
+ *  each program.
+ ***********************************************************/
+std::string ShaderCache::SpecializeSource(const std::string& source, int permutation)
+{
+	bool bUseTexture = (0 != (permutation & PERMUTATION_TEXTURE));
+	bool bUseLighting = (0 != (permutation & PERMUTATION_LIGHTING));
+
+	std::string defines;
+	defines += std::string("#define USE_TEXTURE ") + (bUseTexture ? "1" : "0") + "\n";
+	defines += std::string("#define USE_LIGHTING ") + (bUseLighting ? "1" : "0") + "\n";
+
+	// the view uniforms are declared by the view block instead
+	std::string specialized = source;
+	bool bViewUniforms = false;
+	for (const char* pattern : g_ViewUniformPatterns)
+	{
+		std::regex viewUniform(pattern);
+		if (std::regex_search(specialized, viewUniform))
+		{
+			specialized = std::regex_replace(specialized, viewUniform, "");
+			bViewUniforms = true;
+		}
+	}
+	if (bViewUniforms)
+	{
+		defines += VIEW_BLOCK_SOURCE;
+	}
+
+	// the defines must come after the version line
+	size_t versionPosition = specialized.find("#version");
+	if (versionPosition != std::string::npos)
+	{
+		size_t lineEnd = specialized.find('\n', versionPosition);
+		if (lineEnd == std::string::npos)
+		{
+			specialized += "\n";
+			lineEnd = specialized.size() - 1;
+		}
+		specialized.insert(lineEnd + 1, defines);
+	}
+	else
+	{
+		specialized.insert(0, defines);
+	}
+
+	std::regex textureUniform(std::string("uniform\\s+bool\\s+") + g_UseTextureName + "\\s*(=[^;]*)?;");
+	std::regex lightingUniform(std::string("uniform\\s+bool\\s+") + g_UseLightingName + "\\s*(=[^;]*)?;");
+	specialized = std::regex_replace(specialized, textureUniform,
+		std::string("const bool ") + g_UseTextureName + (bUseTexture ? " = true;" : " = false;"));
+	specialized = std::regex_replace(specialized, lightingUniform,
+		std::string("const bool ") + g_UseLightingName + (bUseLighting ? " = true;" : " = false;"));
+
+	return specialized;
+}
+
+/***********************************************************
+ *  LoadProgramBinary()
+ *
+ *  This method is used for creating a program from a cached
+ *  program binary.  Zero is returned if there is no cached
+ *  binary or the driver no longer accepts it.
+ ***********************************************************/
+GLuint ShaderCache::LoadProgramBinary(uint64_t key)
+{
+	std::ifstream file(GetCacheFilePath(key), std::ios::binary);
+	if (!file.is_open())
+	{
+		return 0;
+	}
+
+	CACHE_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != CACHE_FILE_MAGIC) ||
+		(header.version != CACHE_FILE_VERSION) ||
+		(header.key != key))
+	{
+		return 0;
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	file.read(binary.data(), header.binaryLength);
+	if (!file)
+	{
+		return 0;
+	}
+
+	GLint success = 0;
+	GLuint programID = CreateTrackedProgram("cached program");
+	glProgramBinary(programID, header.binaryFormat, binary.data(), header.binaryLength);
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		// the binary is stale, so it will be rebuilt from the source
+		DeleteTrackedProgram(programID);
+		return 0;
+	}
+	SetTrackedResourceSize(GPU_RESOURCE_PROGRAM, programID, header.binaryLength);
+
+	return programID;
+}
+
+/***********************************************************
+ *  SaveProgramBinary()
+ *
+ *  This method is used for saving the binary of a linked
+ *  program into the cache directory.
+ ***********************************************************/
+void ShaderCache::SaveProgramBinary(uint64_t key, GLuint programID)
+{
+	GLint binaryLength = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(programID, binaryLength, NULL, &binaryFormat, binary.data());
+
+	CACHE_FILE_HEADER header;
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.key = key;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = (uint32_t)binaryLength;
+
+	std::ofstream file(GetCacheFilePath(key), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write shader cache file:" << GetCacheFilePath(key) << std::endl;
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), binaryLength);
+}
+
+/***********************************************************
+ *  GetCacheFilePath()
+ *
+ *  This method is used for getting the path of the program
+ *  binary file that is stored for a key.
+ ***********************************************************/
+std::string ShaderCache::GetCacheFilePath(uint64_t key)
+{
+	std::stringstream path;
+	path << g_CacheDirectory << "/" << std::hex << key << ".bin";
+
+	return path.str();
+}
+
+/***********************************************************
+ *  DeletePrograms()
+ *
+ *  This method is used for freeing the linked programs.
+ ***********************************************************/
+void ShaderCache::DeletePrograms(GLuint programIDs[PERMUTATION_COUNT])
+{
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		DeleteTrackedProgram(programIDs[i]);
+	}
+}
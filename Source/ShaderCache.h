@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.h
+// ============
+// manage the specialized shader program permutations, their
+// linked program binaries on disk, and reloading edited shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/***********************************************************
+ *  ShaderCache
+ *
+ *  This class compiles the scene shader files into one
+ *  program per permutation, with the texture and lighting
+ *  switches turned into compile time constants.  Linked
+ *  program binaries are stored on disk keyed by the source
+ *  hash and the driver, so later launches skip compiling,
+ *  and the shader files are watched for changes while the
+ *  application is running.
+ ***********************************************************/
+class ShaderCache
+{
+public:
+	// the switches that are specialized in each permutation
+	enum PERMUTATION_FLAGS
+	{
+		PERMUTATION_TEXTURE = 1,
+		PERMUTATION_LIGHTING = 2,
+		PERMUTATION_COUNT = 4
+	};
+
+	// constructor
+	ShaderCache(ShaderManager* pShaderManager);
+	// destructor
+	~ShaderCache();
+
+	// load the shader files and build all of the permutations
+	bool LoadShaders(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// rebuild the permutations if the shader files were edited
+	bool ReloadIfChanged();
+	// make a permutation the active program of the shader manager
+	void Bind(int permutation);
+
+	// check whether the permutations were successfully built
+	bool IsLoaded() const { return m_bLoaded; }
+	// check whether the permutations read the view values from
+	// the view block rather than from their own uniforms
+	bool UsesViewBlock() const { return m_bViewBlock; }
+	// get the number of times the permutations have been built
+	unsigned int GetGeneration() const { return m_generation; }
+
+	// compile and link a program from vertex and fragment source
+	static GLuint CompileProgram(
+		const char* vertexSource,
+		const char* fragmentSource,
+		bool bRetrievable = false);
+	// compile and link a program from compute shader source
+	static GLuint CompileComputeProgram(const char* computeSource);
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// linked program for each permutation
+	GLuint m_programIDs[PERMUTATION_COUNT];
+	// paths of the watched shader files - kept as paths so that
+	// checking them for changes does not need any allocations
+	std::filesystem::path m_vertexShaderPath;
+	std::filesystem::path m_fragmentShaderPath;
+	// last modified times of the watched shader files
+	std::filesystem::file_time_type m_vertexWriteTime;
+	std::filesystem::file_time_type m_fragmentWriteTime;
+	// time of the last check for edited shader files
+	std::chrono::steady_clock::time_point m_lastCheckTime;
+	// identifies the driver that the program binaries are for
+	std::string m_driverName;
+	// true when the driver can save and load program binaries
+	bool m_bBinarySupported;
+	bool m_bLoaded;
+	// true when the shader files declare view uniforms, which
+	// were replaced by the view block
+	bool m_bViewBlock;
+	unsigned int m_generation;
+
+	// build every permutation from the shader files
+	bool BuildPermutations(GLuint programIDs[PERMUTATION_COUNT]);
+	// build a single permutation from the loaded cache or the source
+	GLuint BuildPermutation(
+		int permutation,
+		const std::string& vertexSource,
+		const std::string& fragmentSource);
+	// insert the permutation defines into the shader source
+	std::string SpecializeSource(const std::string& source, int permutation);
+	// load a linked program binary from the cache directory
+	GLuint LoadProgramBinary(uint64_t key);
+	// save a linked program binary into the cache directory
+	void SaveProgramBinary(uint64_t key, GLuint programID);
+	// get the path of the cache file for a key
+	std::string GetCacheFilePath(uint64_t key);
+	// free the linked programs
+	void DeletePrograms(GLuint programIDs[PERMUTATION_COUNT]);
+};
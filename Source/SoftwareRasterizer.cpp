@@ -0,0 +1,948 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// draw the scene on the CPU with a tiled, binned and multithreaded
+// rasterizer, for machines that have no GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// number of pixels that are tested and shaded at once
+	const int LANES = 8;
+	// vertex positions are snapped to this fraction of a pixel,
+	// so that the edges shared by triangles match exactly
+	const float SUBPIXEL_STEPS = 256.0f;
+
+#if defined(__AVX2__)
+	// the values of 8 pixels in the lanes of AVX2 registers, and
+	// masks with every bit of a lane set where they are true
+	struct FLOAT8 { __m256 v; };
+	struct INT8 { __m256i v; };
+	struct MASK8 { __m256 v; };
+
+	inline FLOAT8 Splat(float value) { return { _mm256_set1_ps(value) }; }
+	inline FLOAT8 LaneOffsets() { return { _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f) }; }
+	inline FLOAT8 LoadFloats(const float* pValues) { return { _mm256_loadu_ps(pValues) }; }
+	inline void StoreFloats(float* pValues, FLOAT8 a, MASK8 mask) { _mm256_maskstore_ps(pValues, _mm256_castps_si256(mask.v), a.v); }
+	inline FLOAT8 operator+(FLOAT8 a, FLOAT8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline FLOAT8 operator-(FLOAT8 a, FLOAT8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline FLOAT8 operator*(FLOAT8 a, FLOAT8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline FLOAT8 operator/(FLOAT8 a, FLOAT8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+	inline FLOAT8 Min(FLOAT8 a, FLOAT8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline FLOAT8 Max(FLOAT8 a, FLOAT8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+	inline FLOAT8 Sqrt(FLOAT8 a) { return { _mm256_sqrt_ps(a.v) }; }
+	inline FLOAT8 Floor(FLOAT8 a) { return { _mm256_floor_ps(a.v) }; }
+	inline FLOAT8 Select(MASK8 mask, FLOAT8 a, FLOAT8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+	inline MASK8 operator<(FLOAT8 a, FLOAT8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+	inline MASK8 operator>(FLOAT8 a, FLOAT8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+	inline MASK8 operator==(FLOAT8 a, FLOAT8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+	inline MASK8 operator&(MASK8 a, MASK8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+	inline MASK8 operator|(MASK8 a, MASK8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+	inline MASK8 SplatMask(bool bValue) { return { _mm256_castsi256_ps(_mm256_set1_epi32(bValue ? -1 : 0)) }; }
+	inline int MaskBits(MASK8 mask) { return _mm256_movemask_ps(mask.v); }
+
+	inline INT8 SplatInt(int value) { return { _mm256_set1_epi32(value) }; }
+	inline INT8 LoadInts(const uint32_t* pValues) { return { _mm256_loadu_si256((const __m256i*)pValues) }; }
+	inline void StoreInts(uint32_t* pValues, INT8 a, MASK8 mask) { _mm256_maskstore_epi32((int*)pValues, _mm256_castps_si256(mask.v), a.v); }
+	inline INT8 operator+(INT8 a, INT8 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+	inline INT8 operator*(INT8 a, INT8 b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+	inline INT8 operator&(INT8 a, INT8 b) { return { _mm256_and_si256(a.v, b.v) }; }
+	inline INT8 operator|(INT8 a, INT8 b) { return { _mm256_or_si256(a.v, b.v) }; }
+	inline INT8 ShiftLeft(INT8 a, int bits) { return { _mm256_sllv_epi32(a.v, _mm256_set1_epi32(bits)) }; }
+	inline INT8 ShiftRight(INT8 a, int bits) { return { _mm256_srlv_epi32(a.v, _mm256_set1_epi32(bits)) }; }
+	inline INT8 MinInt(INT8 a, INT8 b) { return { _mm256_min_epi32(a.v, b.v) }; }
+	inline INT8 TruncateToInt(FLOAT8 a) { return { _mm256_cvttps_epi32(a.v) }; }
+	inline INT8 RoundToInt(FLOAT8 a) { return { _mm256_cvtps_epi32(a.v) }; }
+	inline FLOAT8 ToFloat(INT8 a) { return { _mm256_cvtepi32_ps(a.v) }; }
+	inline INT8 Gather(const uint32_t* pBase, INT8 indices, MASK8 mask)
+	{
+		return { _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)pBase, indices.v, _mm256_castps_si256(mask.v), 4) };
+	}
+
+	// raise to a power as 2 to the power of the exponent times the
+	// log 2 of the base, with approximations that are close enough
+	// for specular highlights
+	inline FLOAT8 Pow(FLOAT8 base, float exponent)
+	{
+		__m256i bits = _mm256_castps_si256(_mm256_max_ps(base.v, _mm256_set1_ps(1e-30f)));
+		__m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+		__m256 log2 = _mm256_sub_ps(
+			_mm256_sub_ps(
+				_mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.1920928955078125e-7f)), _mm256_set1_ps(124.22551499f)),
+				_mm256_mul_ps(_mm256_set1_ps(1.498030302f), mantissa)),
+			_mm256_div_ps(_mm256_set1_ps(1.72587999f), _mm256_add_ps(_mm256_set1_ps(0.3520887068f), mantissa)));
+
+		__m256 power = _mm256_max_ps(_mm256_mul_ps(log2, _mm256_set1_ps(exponent)), _mm256_set1_ps(-126.0f));
+		__m256 fraction = _mm256_sub_ps(power, _mm256_floor_ps(power));
+		__m256 scaled = _mm256_mul_ps(_mm256_set1_ps(8388608.0f), _mm256_sub_ps(
+			_mm256_add_ps(
+				_mm256_add_ps(power, _mm256_set1_ps(121.2740575f)),
+				_mm256_div_ps(_mm256_set1_ps(27.7280233f), _mm256_sub_ps(_mm256_set1_ps(4.84252568f), fraction))),
+			_mm256_mul_ps(_mm256_set1_ps(1.49012907f), fraction)));
+		return { _mm256_castsi256_ps(_mm256_cvttps_epi32(scaled)) };
+	}
+#else
+	// the values of 8 pixels in arrays, for compilers that do not
+	// target AVX2, and masks with every bit of a lane set where
+	// they are true
+	struct FLOAT8 { float v[LANES]; };
+	struct INT8 { int32_t v[LANES]; };
+	struct MASK8 { int32_t v[LANES]; };
+
+	inline FLOAT8 Splat(float value) { FLOAT8 r; for (int i = 0; i < LANES; i++) r.v[i] = value; return r; }
+	inline FLOAT8 LaneOffsets() { FLOAT8 r; for (int i = 0; i < LANES; i++) r.v[i] = (float)i; return r; }
+	inline FLOAT8 LoadFloats(const float* pValues) { FLOAT8 r; for (int i = 0; i < LANES; i++) r.v[i] = pValues[i]; return r; }
+	inline void StoreFloats(float* pValues, FLOAT8 a, MASK8 mask) { for (int i = 0; i < LANES; i++) if (mask.v[i]) pValues[i] = a.v[i]; }
+	inline FLOAT8 operator+(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] += b.v[i]; return a; }
+	inline FLOAT8 operator-(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] -= b.v[i]; return a; }
+	inline FLOAT8 operator*(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] *= b.v[i]; return a; }
+	inline FLOAT8 operator/(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] /= b.v[i]; return a; }
+	inline FLOAT8 Min(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] = std::min(a.v[i], b.v[i]); return a; }
+	inline FLOAT8 Max(FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) a.v[i] = std::max(a.v[i], b.v[i]); return a; }
+	inline FLOAT8 Sqrt(FLOAT8 a) { for (int i = 0; i < LANES; i++) a.v[i] = std::sqrt(a.v[i]); return a; }
+	inline FLOAT8 Floor(FLOAT8 a) { for (int i = 0; i < LANES; i++) a.v[i] = std::floor(a.v[i]); return a; }
+	inline FLOAT8 Select(MASK8 mask, FLOAT8 a, FLOAT8 b) { for (int i = 0; i < LANES; i++) if (!mask.v[i]) a.v[i] = b.v[i]; return a; }
+	inline MASK8 operator<(FLOAT8 a, FLOAT8 b) { MASK8 r; for (int i = 0; i < LANES; i++) r.v[i] = (a.v[i] < b.v[i]) ? -1 : 0; return r; }
+	inline MASK8 operator>(FLOAT8 a, FLOAT8 b) { MASK8 r; for (int i = 0; i < LANES; i++) r.v[i] = (a.v[i] > b.v[i]) ? -1 : 0; return r; }
+	inline MASK8 operator==(FLOAT8 a, FLOAT8 b) { MASK8 r; for (int i = 0; i < LANES; i++) r.v[i] = (a.v[i] == b.v[i]) ? -1 : 0; return r; }
+	inline MASK8 operator&(MASK8 a, MASK8 b) { for (int i = 0; i < LANES; i++) a.v[i] &= b.v[i]; return a; }
+	inline MASK8 operator|(MASK8 a, MASK8 b) { for (int i = 0; i < LANES; i++) a.v[i] |= b.v[i]; return a; }
+	inline MASK8 SplatMask(bool bValue) { MASK8 r; for (int i = 0; i < LANES; i++) r.v[i] = bValue ? -1 : 0; return r; }
+	inline int MaskBits(MASK8 mask) { int bits = 0; for (int i = 0; i < LANES; i++) if (mask.v[i]) bits |= (1 << i); return bits; }
+
+	inline INT8 SplatInt(int value) { INT8 r; for (int i = 0; i < LANES; i++) r.v[i] = value; return r; }
+	inline INT8 LoadInts(const uint32_t* pValues) { INT8 r; for (int i = 0; i < LANES; i++) r.v[i] = (int32_t)pValues[i]; return r; }
+	inline void StoreInts(uint32_t* pValues, INT8 a, MASK8 mask) { for (int i = 0; i < LANES; i++) if (mask.v[i]) pValues[i] = (uint32_t)a.v[i]; }
+	inline INT8 operator+(INT8 a, INT8 b) { for (int i = 0; i < LANES; i++) a.v[i] += b.v[i]; return a; }
+	inline INT8 operator*(INT8 a, INT8 b) { for (int i = 0; i < LANES; i++) a.v[i] *= b.v[i]; return a; }
+	inline INT8 operator&(INT8 a, INT8 b) { for (int i = 0; i < LANES; i++) a.v[i] &= b.v[i]; return a; }
+	inline INT8 operator|(INT8 a, INT8 b) { for (int i = 0; i < LANES; i++) a.v[i] |= b.v[i]; return a; }
+	inline INT8 ShiftLeft(INT8 a, int bits) { for (int i = 0; i < LANES; i++) a.v[i] = (int32_t)((uint32_t)a.v[i] << bits); return a; }
+	inline INT8 ShiftRight(INT8 a, int bits) { for (int i = 0; i < LANES; i++) a.v[i] = (int32_t)((uint32_t)a.v[i] >> bits); return a; }
+	inline INT8 MinInt(INT8 a, INT8 b) { for (int i = 0; i < LANES; i++) a.v[i] = std::min(a.v[i], b.v[i]); return a; }
+	inline INT8 TruncateToInt(FLOAT8 a) { INT8 r; for (int i = 0; i < LANES; i++) r.v[i] = (int32_t)a.v[i]; return r; }
+	inline INT8 RoundToInt(FLOAT8 a) { INT8 r; for (int i = 0; i < LANES; i++) r.v[i] = (int32_t)std::lround(a.v[i]); return r; }
+	inline FLOAT8 ToFloat(INT8 a) { FLOAT8 r; for (int i = 0; i < LANES; i++) r.v[i] = (float)a.v[i]; return r; }
+	inline INT8 Gather(const uint32_t* pBase, INT8 indices, MASK8 mask)
+	{
+		INT8 r;
+		for (int i = 0; i < LANES; i++)
+		{
+			r.v[i] = mask.v[i] ? (int32_t)pBase[indices.v[i]] : 0;
+		}
+		return r;
+	}
+	inline FLOAT8 Pow(FLOAT8 base, float exponent) { for (int i = 0; i < LANES; i++) base.v[i] = std::pow(base.v[i], exponent); return base; }
+#endif
+
+	inline FLOAT8 Clamp01(FLOAT8 a)
+	{
+		return Min(Max(a, Splat(0.0f)), Splat(1.0f));
+	}
+
+	// the lanes of three vectors, for the lighting
+	struct VEC3X8
+	{
+		FLOAT8 x;
+		FLOAT8 y;
+		FLOAT8 z;
+	};
+
+	inline FLOAT8 Dot(const VEC3X8& a, const VEC3X8& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline VEC3X8 Normalize(const VEC3X8& a)
+	{
+		FLOAT8 inverseLength = Splat(1.0f) / Sqrt(Max(Dot(a, a), Splat(1e-20f)));
+		return { a.x * inverseLength, a.y * inverseLength, a.z * inverseLength };
+	}
+
+	/***********************************************************
+	 *  PackColor()
+	 *
+	 *  This function is used for packing a color into the bytes
+	 *  of an RGBA texel, with red in the lowest byte.
+	 ***********************************************************/
+	uint32_t PackColor(glm::vec4 color)
+	{
+		uint32_t packed = 0;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			packed |= (uint32_t)(glm::clamp(color[channel], 0.0f, 1.0f) * 255.0f + 0.5f) << (channel * 8);
+		}
+		return packed;
+	}
+
+	/***********************************************************
+	 *  LerpVertex()
+	 *
+	 *  This function is used for finding the point along the
+	 *  edge between two vertices being clipped, with all of
+	 *  their attributes.
+	 ***********************************************************/
+	template <typename VERTEX>
+	VERTEX LerpVertex(const VERTEX& a, const VERTEX& b, float t)
+	{
+		VERTEX result;
+		result.clipPosition = glm::mix(a.clipPosition, b.clipPosition, t);
+		result.position = glm::mix(a.position, b.position, t);
+		result.normal = glm::mix(a.normal, b.normal, t);
+		result.uv = glm::mix(a.uv, b.uv, t);
+		return result;
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer()
+{
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_clearColor = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_nextTile = 0;
+
+	// draw on the calling thread until a worker pool is given
+	m_workers.resize(1);
+}
+
+/***********************************************************
+ *  ~SoftwareRasterizer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+/***********************************************************
+ *  GetName()
+ *
+ *  This method is used for getting the name of the renderer
+ *  for messages, which says whether the pixels are shaded
+ *  with AVX2 or with the plain loops.
+ ***********************************************************/
+const char* SoftwareRasterizer::GetName() const
+{
+#if defined(__AVX2__)
+	return "Software rasterizer (AVX2)";
+#else
+	return "Software rasterizer (scalar)";
+#endif
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for setting the threads that draw
+ *  the frames, each with its own triangles and bins.  It
+ *  always succeeds, as the rasterizer needs no device.
+ ***********************************************************/
+bool SoftwareRasterizer::Initialize(WorkerPool* pWorkerPool)
+{
+	SetWorkerPool(pWorkerPool);
+
+	m_workers.clear();
+	m_workers.resize(GetThreadCount());
+
+	return true;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for freeing the meshes and textures,
+ *  before the ones of a changed scene are added.
+ ***********************************************************/
+void SoftwareRasterizer::Reset()
+{
+	m_meshes.clear();
+	m_textures.clear();
+	m_draws.clear();
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for keeping a copy of the vertex and
+ *  index data of a mesh, with the vertex layout of the shape
+ *  meshes.
+ ***********************************************************/
+int SoftwareRasterizer::AddMesh(const MeshGenerator::MESH_DATA& meshData)
+{
+	SOFTWARE_MESH mesh;
+	mesh.vertices = meshData.vertices;
+	mesh.indices = meshData.indices;
+	m_meshes.push_back(std::move(mesh));
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  AddTextureLevel()
+ *
+ *  This method is used for adding the next level of the mip
+ *  chain of a texture slot, starting from the finest.  The
+ *  pixels are packed into one RGBA value per texel, so that
+ *  a texel is read with one gather.
+ ***********************************************************/
+bool SoftwareRasterizer::AddTextureLevel(int textureSlot, int width, int height, int colorChannels, const unsigned char* pPixels)
+{
+	if ((textureSlot < 0) || (width <= 0) || (height <= 0) || (NULL == pPixels) ||
+		((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return false;
+	}
+
+	if (textureSlot >= (int)m_textures.size())
+	{
+		m_textures.resize(textureSlot + 1);
+	}
+
+	TEXTURE_LEVEL level;
+	level.width = width;
+	level.height = height;
+	level.texels.resize((size_t)width * height);
+	for (size_t i = 0; i < level.texels.size(); i++)
+	{
+		const unsigned char* pTexel = pPixels + i * colorChannels;
+		uint32_t alpha = (colorChannels == 4) ? pTexel[3] : 255;
+		level.texels[i] = (uint32_t)pTexel[0] | ((uint32_t)pTexel[1] << 8) | ((uint32_t)pTexel[2] << 16) | (alpha << 24);
+	}
+	m_textures[textureSlot].push_back(std::move(level));
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  The buffers
+ *  and bins only grow when the frame gets larger, so frames
+ *  of the same size do not allocate.
+ ***********************************************************/
+void SoftwareRasterizer::BeginFrame(
+	int width,
+	int height,
+	glm::vec4 clearColor,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec3 viewPosition)
+{
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	// the rows are padded so every group of pixels can be loaded
+	m_stride = (m_width + LANES - 1) / LANES * LANES;
+	m_tilesX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+	m_clearColor = PackColor(clearColor);
+	m_viewProjection = projection * view;
+	m_viewPosition = viewPosition;
+
+	size_t pixelCount = (size_t)m_stride * m_height;
+	if (m_colorBuffer.size() < pixelCount)
+	{
+		m_colorBuffer.resize(pixelCount);
+		m_depthBuffer.resize(pixelCount);
+	}
+
+	size_t tileCount = (size_t)m_tilesX * m_tilesY;
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		if (m_workers[i].bins.size() < tileCount)
+		{
+			m_workers[i].bins.resize(tileCount);
+		}
+	}
+
+	m_draws.clear();
+	m_triangleCount = 0;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for submitting a mesh to draw in the
+ *  frame.  Nothing is drawn until the frame ends.
+ ***********************************************************/
+void SoftwareRasterizer::DrawMesh(
+	int mesh,
+	const glm::mat4& modelMatrix,
+	glm::vec4 color,
+	int textureSlot,
+	const MATERIAL& material,
+	bool bBlended)
+{
+	if ((mesh < 0) || (mesh >= (int)m_meshes.size()))
+	{
+		return;
+	}
+
+	DRAW draw;
+	draw.mesh = mesh;
+	draw.modelMatrix = modelMatrix;
+	draw.normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+	draw.color = color;
+	draw.textureSlot = ((textureSlot >= 0) && (textureSlot < (int)m_textures.size()) &&
+		(false == m_textures[textureSlot].empty())) ? textureSlot : -1;
+	draw.material = material;
+	draw.bBlended = bBlended;
+	draw.firstTriangle = m_triangleCount;
+	m_draws.push_back(draw);
+
+	m_triangleCount += m_meshes[mesh].indices.size() / 3;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for drawing the submitted meshes.
+ *  Every thread sets up and bins its share of the triangles,
+ *  and then the threads draw the tiles.
+ ***********************************************************/
+void SoftwareRasterizer::EndFrame()
+{
+	if ((m_width <= 0) || (m_height <= 0))
+	{
+		return;
+	}
+
+	RunJob(JOB_GEOMETRY);
+	m_nextTile = 0;
+	RunJob(JOB_RASTER);
+}
+
+/***********************************************************
+ *  ExecuteJob()
+ *
+ *  This method is used for running one thread's share of a
+ *  step.  The triangles are split evenly by count, and the
+ *  tiles are taken one at a time until none are left.
+ ***********************************************************/
+void SoftwareRasterizer::ExecuteJob(int job, int workerIndex)
+{
+	if (job == JOB_GEOMETRY)
+	{
+		ProcessGeometry(workerIndex);
+	}
+	else if (job == JOB_RASTER)
+	{
+		int tileCount = m_tilesX * m_tilesY;
+		for (int tile = m_nextTile++; tile < tileCount; tile = m_nextTile++)
+		{
+			RasterizeTile(tile);
+		}
+	}
+}
+
+/***********************************************************
+ *  ProcessGeometry()
+ *
+ *  This method is used for transforming, clipping and binning
+ *  one thread's share of the submitted triangles.  Each
+ *  thread takes a contiguous range, so the triangles in the
+ *  bins of the threads stay in submission order when the
+ *  bins are read in thread order.
+ ***********************************************************/
+void SoftwareRasterizer::ProcessGeometry(int workerIndex)
+{
+	WORKER& worker = m_workers[workerIndex];
+	size_t tileCount = (size_t)m_tilesX * m_tilesY;
+
+	worker.triangles.clear();
+	for (size_t i = 0; i < tileCount; i++)
+	{
+		worker.bins[i].clear();
+	}
+
+	size_t workerCount = m_workers.size();
+	size_t firstTriangle = m_triangleCount * workerIndex / workerCount;
+	size_t lastTriangle = m_triangleCount * (workerIndex + 1) / workerCount;
+	if (firstTriangle >= lastTriangle)
+	{
+		return;
+	}
+
+	// find the draw that holds the first triangle
+	size_t drawIndex = std::upper_bound(m_draws.begin(), m_draws.end(), firstTriangle,
+		[](size_t triangle, const DRAW& draw) { return triangle < draw.firstTriangle; }) - m_draws.begin() - 1;
+
+	const int stride = MeshGenerator::FLOATS_PER_VERTEX;
+	for (size_t triangle = firstTriangle; triangle < lastTriangle; triangle++)
+	{
+		while ((drawIndex + 1 < m_draws.size()) && (triangle >= m_draws[drawIndex + 1].firstTriangle))
+		{
+			drawIndex++;
+		}
+
+		const DRAW& draw = m_draws[drawIndex];
+		const SOFTWARE_MESH& mesh = m_meshes[draw.mesh];
+		size_t firstIndex = (triangle - draw.firstTriangle) * 3;
+
+		CLIP_VERTEX vertices[3];
+		for (int i = 0; i < 3; i++)
+		{
+			const GLfloat* pVertex = &mesh.vertices[(size_t)mesh.indices[firstIndex + i] * stride];
+			glm::vec4 position = draw.modelMatrix * glm::vec4(pVertex[0], pVertex[1], pVertex[2], 1.0f);
+			vertices[i].position = glm::vec3(position);
+			vertices[i].clipPosition = m_viewProjection * position;
+			vertices[i].normal = draw.normalMatrix * glm::vec3(pVertex[3], pVertex[4], pVertex[5]);
+			vertices[i].uv = glm::vec2(pVertex[6], pVertex[7]);
+		}
+
+		ClipTriangle(vertices, (int)drawIndex, worker);
+	}
+}
+
+/***********************************************************
+ *  ClipTriangle()
+ *
+ *  This method is used for dropping the triangles that are
+ *  entirely outside one of the frustum planes, and clipping
+ *  the rest against the near plane only.  The other planes
+ *  are handled by the screen bounds of each triangle.
+ ***********************************************************/
+void SoftwareRasterizer::ClipTriangle(const CLIP_VERTEX vertices[3], int drawIndex, WORKER& worker)
+{
+	// the outcodes of the six planes of each vertex
+	int outsideAll = 0x3F;
+	int outsideNear = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& clip = vertices[i].clipPosition;
+		int outcode =
+			((clip.x < -clip.w) ? 0x01 : 0) | ((clip.x > clip.w) ? 0x02 : 0) |
+			((clip.y < -clip.w) ? 0x04 : 0) | ((clip.y > clip.w) ? 0x08 : 0) |
+			((clip.z < -clip.w) ? 0x10 : 0) | ((clip.z > clip.w) ? 0x20 : 0);
+		outsideAll &= outcode;
+		outsideNear |= (outcode & 0x10);
+	}
+	if (0 != outsideAll)
+	{
+		return;
+	}
+	if (0 == outsideNear)
+	{
+		SetupTriangle(vertices[0], vertices[1], vertices[2], drawIndex, worker);
+		return;
+	}
+
+	// keep the part in front of the near plane, which has up to
+	// four corners
+	CLIP_VERTEX clipped[4];
+	int clippedCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const CLIP_VERTEX& a = vertices[i];
+		const CLIP_VERTEX& b = vertices[(i + 1) % 3];
+		float distanceA = a.clipPosition.z + a.clipPosition.w;
+		float distanceB = b.clipPosition.z + b.clipPosition.w;
+		if (distanceA >= 0.0f)
+		{
+			clipped[clippedCount++] = a;
+		}
+		if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+		{
+			clipped[clippedCount++] = LerpVertex(a, b, distanceA / (distanceA - distanceB));
+		}
+	}
+
+	for (int i = 2; i < clippedCount; i++)
+	{
+		SetupTriangle(clipped[0], clipped[i - 1], clipped[i], drawIndex, worker);
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used for projecting a triangle onto the
+ *  screen and calculating the edge functions and the other
+ *  values used for drawing it, and adding it to the bins of
+ *  the tiles that its bounding box touches.  Triangles are
+ *  drawn from both sides, as in the OpenGL path.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangle(const CLIP_VERTEX& v0, const CLIP_VERTEX& v1, const CLIP_VERTEX& v2, int drawIndex, WORKER& worker)
+{
+	const CLIP_VERTEX* pVertices[3] = { &v0, &v1, &v2 };
+	glm::vec2 screen[3];
+	float depth[3];
+	float inverseW[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& clip = pVertices[i]->clipPosition;
+		inverseW[i] = 1.0f / clip.w;
+		glm::vec3 ndc = glm::vec3(clip) * inverseW[i];
+		screen[i].x = std::round((ndc.x * 0.5f + 0.5f) * (float)m_width * SUBPIXEL_STEPS) / SUBPIXEL_STEPS;
+		screen[i].y = std::round((ndc.y * 0.5f + 0.5f) * (float)m_height * SUBPIXEL_STEPS) / SUBPIXEL_STEPS;
+		depth[i] = ndc.z * 0.5f + 0.5f;
+	}
+
+	// make the vertices counter-clockwise, dropping triangles with
+	// no area
+	double doubleArea =
+		(double)(screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+		(double)(screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+	if (!(doubleArea != 0.0) || !std::isfinite(doubleArea))
+	{
+		return;
+	}
+	int order[3] = { 0, 1, 2 };
+	if (doubleArea < 0.0)
+	{
+		std::swap(order[1], order[2]);
+		doubleArea = -doubleArea;
+	}
+
+	TRIANGLE triangle;
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	for (int i = 0; i < 3; i++)
+	{
+		const CLIP_VERTEX& vertex = *pVertices[order[i]];
+		triangle.depth[i] = depth[order[i]];
+		triangle.inverseW[i] = inverseW[order[i]];
+		triangle.position[i] = vertex.position;
+		triangle.normal[i] = vertex.normal;
+		triangle.uv[i] = vertex.uv;
+		minX = std::min(minX, screen[order[i]].x);
+		minY = std::min(minY, screen[order[i]].y);
+		maxX = std::max(maxX, screen[order[i]].x);
+		maxY = std::max(maxY, screen[order[i]].y);
+	}
+
+	// each edge function is positive inside the triangle and
+	// equals twice the area at the opposite vertex - the constant
+	// is taken from the same end of a shared edge in both of its
+	// triangles, so the two edge functions are exact negatives
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec2 a = screen[order[(i + 1) % 3]];
+		glm::vec2 b = screen[order[(i + 2) % 3]];
+		glm::vec2 base = ((a.x < b.x) || ((a.x == b.x) && (a.y < b.y))) ? a : b;
+		triangle.edgeA[i] = a.y - b.y;
+		triangle.edgeB[i] = b.x - a.x;
+		triangle.edgeC[i] = -((double)triangle.edgeA[i] * base.x + (double)triangle.edgeB[i] * base.y);
+		// pixels exactly on an edge belong to the triangle whose
+		// left or top edge it is
+		triangle.bTopLeft[i] = (b.y < a.y) || ((b.y == a.y) && (b.x < a.x));
+	}
+	triangle.inverseArea = (float)(1.0 / doubleArea);
+
+	triangle.minX = std::max(0, (int)std::floor(minX));
+	triangle.minY = std::max(0, (int)std::floor(minY));
+	triangle.maxX = std::min(m_width - 1, (int)std::ceil(maxX));
+	triangle.maxY = std::min(m_height - 1, (int)std::ceil(maxY));
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+	triangle.drawIndex = drawIndex;
+
+	// pick the texture level whose texels are about the size of a
+	// pixel, from the area of the triangle in texels and pixels
+	triangle.textureLevel = 0;
+	const DRAW& draw = m_draws[drawIndex];
+	if (draw.textureSlot >= 0)
+	{
+		const std::vector<TEXTURE_LEVEL>& levels = m_textures[draw.textureSlot];
+		glm::vec2 uvEdge1 = triangle.uv[1] - triangle.uv[0];
+		glm::vec2 uvEdge2 = triangle.uv[2] - triangle.uv[0];
+		double texelArea = std::abs((double)uvEdge1.x * uvEdge2.y - (double)uvEdge2.x * uvEdge1.y) *
+			levels[0].width * levels[0].height;
+		if (texelArea > doubleArea)
+		{
+			int level = (int)std::lround(0.5 * std::log2(texelArea / doubleArea));
+			triangle.textureLevel = std::min(level, (int)levels.size() - 1);
+		}
+	}
+
+	uint32_t triangleIndex = (uint32_t)worker.triangles.size();
+	worker.triangles.push_back(triangle);
+
+	int firstTileX = triangle.minX / TILE_SIZE;
+	int firstTileY = triangle.minY / TILE_SIZE;
+	int lastTileX = triangle.maxX / TILE_SIZE;
+	int lastTileY = triangle.maxY / TILE_SIZE;
+	for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			worker.bins[(size_t)tileY * m_tilesX + tileX].push_back(triangleIndex);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used for clearing one tile and drawing the
+ *  triangles of every thread's bin for it, in the order
+ *  they were submitted.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTile(int tile)
+{
+	int tileX = (tile % m_tilesX) * TILE_SIZE;
+	int tileY = (tile / m_tilesX) * TILE_SIZE;
+	int endX = std::min(tileX + TILE_SIZE, m_stride);
+	int endY = std::min(tileY + TILE_SIZE, m_height);
+
+	for (int y = tileY; y < endY; y++)
+	{
+		size_t row = (size_t)y * m_stride;
+		std::fill(m_colorBuffer.begin() + row + tileX, m_colorBuffer.begin() + row + endX, m_clearColor);
+		std::fill(m_depthBuffer.begin() + row + tileX, m_depthBuffer.begin() + row + endX, 1.0f);
+	}
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		const WORKER& worker = m_workers[i];
+		const std::vector<uint32_t>& bin = worker.bins[tile];
+		for (size_t j = 0; j < bin.size(); j++)
+		{
+			RasterizeTriangle(worker.triangles[bin[j]], tileX, tileY);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for drawing the part of a triangle
+ *  inside a tile, 8 pixels at a time.  The pixels inside all
+ *  three edges are depth tested before they are shaded, and
+ *  the attributes are interpolated with perspective correct
+ *  weights.  The lighting adds the ambient, diffuse and
+ *  specular terms of each light, scaled by the material, as
+ *  the scene shader does.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTriangle(const TRIANGLE& triangle, int tileX, int tileY)
+{
+	const DRAW& draw = m_draws[triangle.drawIndex];
+	const MATERIAL& material = draw.material;
+
+	int minX = std::max(triangle.minX, tileX) / LANES * LANES;
+	int minY = std::max(triangle.minY, tileY);
+	int maxX = std::min(triangle.maxX, tileX + TILE_SIZE - 1);
+	int maxY = std::min(triangle.maxY, tileY + TILE_SIZE - 1);
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	// the edge functions at the center of the first pixel of the
+	// tile, which keeps the values small enough for floats
+	FLOAT8 edgeA[3];
+	float edgeB[3];
+	float tileEdge[3];
+	MASK8 topLeft[3];
+	for (int i = 0; i < 3; i++)
+	{
+		edgeA[i] = Splat(triangle.edgeA[i]);
+		edgeB[i] = triangle.edgeB[i];
+		tileEdge[i] = (float)(triangle.edgeA[i] * (tileX + 0.5) + triangle.edgeB[i] * (tileY + 0.5) + triangle.edgeC[i]);
+		topLeft[i] = SplatMask(triangle.bTopLeft[i]);
+	}
+
+	// the lighting terms that are the same for every pixel - the
+	// lights without diffuse or specular color only add ambient
+	glm::vec3 ambient(0.0f);
+	glm::vec3 diffuse[MAX_LIGHTS];
+	glm::vec3 specular[MAX_LIGHTS];
+	int litCount = 0;
+	int litLights[MAX_LIGHTS];
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		const LIGHT& light = m_lights[i];
+		ambient += light.ambientColor * material.ambientStrength * material.ambientColor;
+		diffuse[i] = light.diffuseColor * material.diffuseColor;
+		specular[i] = light.specularColor * light.specularIntensity * material.shininess * material.specularColor;
+		if ((diffuse[i] != glm::vec3(0.0f)) || (specular[i] != glm::vec3(0.0f)))
+		{
+			litLights[litCount++] = i;
+		}
+	}
+
+	const TEXTURE_LEVEL* pTexture = NULL;
+	if (draw.textureSlot >= 0)
+	{
+		pTexture = &m_textures[draw.textureSlot][triangle.textureLevel];
+	}
+
+	const FLOAT8 zero = Splat(0.0f);
+	const FLOAT8 one = Splat(1.0f);
+	const FLOAT8 laneOffsets = LaneOffsets();
+	const FLOAT8 inverseArea = Splat(triangle.inverseArea);
+	const FLOAT8 depth0 = Splat(triangle.depth[0]);
+	const FLOAT8 depthStep1 = Splat(triangle.depth[1] - triangle.depth[0]);
+	const FLOAT8 depthStep2 = Splat(triangle.depth[2] - triangle.depth[0]);
+	const FLOAT8 width = Splat((float)(m_width - tileX));
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		float localY = (float)(y - tileY);
+		FLOAT8 rowEdge[3];
+		for (int i = 0; i < 3; i++)
+		{
+			rowEdge[i] = Splat(edgeB[i] * localY + tileEdge[i]);
+		}
+
+		for (int x = minX; x <= maxX; x += LANES)
+		{
+			FLOAT8 localX = Splat((float)(x - tileX)) + laneOffsets;
+
+			MASK8 covered = (localX < width);
+			FLOAT8 edge[3];
+			for (int i = 0; i < 3; i++)
+			{
+				edge[i] = edgeA[i] * localX + rowEdge[i];
+				covered = covered & ((edge[i] > zero) | ((edge[i] == zero) & topLeft[i]));
+			}
+			if (0 == MaskBits(covered))
+			{
+				continue;
+			}
+
+			// weights of the second and third vertex on screen, and
+			// the depth test against the frame
+			FLOAT8 weight1 = edge[1] * inverseArea;
+			FLOAT8 weight2 = edge[2] * inverseArea;
+			FLOAT8 depth = depth0 + weight1 * depthStep1 + weight2 * depthStep2;
+			size_t pixel = (size_t)y * m_stride + x;
+			covered = covered & (depth < LoadFloats(&m_depthBuffer[pixel]));
+			if (0 == MaskBits(covered))
+			{
+				continue;
+			}
+			if (false == draw.bBlended)
+			{
+				StoreFloats(&m_depthBuffer[pixel], depth, covered);
+			}
+
+			// perspective correct weights for the attributes
+			FLOAT8 inverseW = Splat(triangle.inverseW[0]) +
+				weight1 * Splat(triangle.inverseW[1] - triangle.inverseW[0]) +
+				weight2 * Splat(triangle.inverseW[2] - triangle.inverseW[0]);
+			FLOAT8 w = one / inverseW;
+			FLOAT8 perspective1 = weight1 * Splat(triangle.inverseW[1]) * w;
+			FLOAT8 perspective2 = weight2 * Splat(triangle.inverseW[2]) * w;
+			auto interpolate = [&](float a0, float a1, float a2)
+			{
+				return Splat(a0) + perspective1 * Splat(a1 - a0) + perspective2 * Splat(a2 - a0);
+			};
+
+			VEC3X8 position = {
+				interpolate(triangle.position[0].x, triangle.position[1].x, triangle.position[2].x),
+				interpolate(triangle.position[0].y, triangle.position[1].y, triangle.position[2].y),
+				interpolate(triangle.position[0].z, triangle.position[1].z, triangle.position[2].z) };
+			VEC3X8 normal = Normalize({
+				interpolate(triangle.normal[0].x, triangle.normal[1].x, triangle.normal[2].x),
+				interpolate(triangle.normal[0].y, triangle.normal[1].y, triangle.normal[2].y),
+				interpolate(triangle.normal[0].z, triangle.normal[1].z, triangle.normal[2].z) });
+			VEC3X8 viewDirection = Normalize({
+				Splat(m_viewPosition.x) - position.x,
+				Splat(m_viewPosition.y) - position.y,
+				Splat(m_viewPosition.z) - position.z });
+
+			FLOAT8 red = Splat(ambient.r);
+			FLOAT8 green = Splat(ambient.g);
+			FLOAT8 blue = Splat(ambient.b);
+			for (int i = 0; i < litCount; i++)
+			{
+				const LIGHT& light = m_lights[litLights[i]];
+				VEC3X8 lightDirection = Normalize({
+					Splat(light.position.x) - position.x,
+					Splat(light.position.y) - position.y,
+					Splat(light.position.z) - position.z });
+				FLOAT8 normalDotLight = Dot(normal, lightDirection);
+				FLOAT8 impact = Max(normalDotLight, zero);
+
+				// the light direction reflected about the normal
+				FLOAT8 twiceDot = normalDotLight + normalDotLight;
+				VEC3X8 reflection = {
+					twiceDot * normal.x - lightDirection.x,
+					twiceDot * normal.y - lightDirection.y,
+					twiceDot * normal.z - lightDirection.z };
+				FLOAT8 highlight = Pow(Max(Dot(viewDirection, reflection), zero), light.focalStrength);
+
+				const glm::vec3& lightDiffuse = diffuse[litLights[i]];
+				const glm::vec3& lightSpecular = specular[litLights[i]];
+				red = red + impact * Splat(lightDiffuse.r) + highlight * Splat(lightSpecular.r);
+				green = green + impact * Splat(lightDiffuse.g) + highlight * Splat(lightSpecular.g);
+				blue = blue + impact * Splat(lightDiffuse.b) + highlight * Splat(lightSpecular.b);
+			}
+
+			// textured objects are opaque, and the others take their
+			// color and alpha from the object color
+			FLOAT8 alpha;
+			if (NULL != pTexture)
+			{
+				FLOAT8 u = interpolate(triangle.uv[0].x, triangle.uv[1].x, triangle.uv[2].x);
+				FLOAT8 v = interpolate(triangle.uv[0].y, triangle.uv[1].y, triangle.uv[2].y);
+				INT8 texelX = MinInt(TruncateToInt((u - Floor(u)) * Splat((float)pTexture->width)), SplatInt(pTexture->width - 1));
+				INT8 texelY = MinInt(TruncateToInt((v - Floor(v)) * Splat((float)pTexture->height)), SplatInt(pTexture->height - 1));
+				INT8 texel = Gather(pTexture->texels.data(), texelY * SplatInt(pTexture->width) + texelX, covered);
+				const FLOAT8 byteScale = Splat(1.0f / 255.0f);
+				const INT8 byteMask = SplatInt(0xFF);
+				red = red * ToFloat(texel & byteMask) * byteScale;
+				green = green * ToFloat(ShiftRight(texel, 8) & byteMask) * byteScale;
+				blue = blue * ToFloat(ShiftRight(texel, 16) & byteMask) * byteScale;
+				alpha = one;
+			}
+			else
+			{
+				red = red * Splat(draw.color.r);
+				green = green * Splat(draw.color.g);
+				blue = blue * Splat(draw.color.b);
+				alpha = Splat(draw.color.a);
+			}
+			red = Clamp01(red);
+			green = Clamp01(green);
+			blue = Clamp01(blue);
+			alpha = Clamp01(alpha);
+
+			uint32_t* pColor = &m_colorBuffer[pixel];
+			if (draw.bBlended)
+			{
+				// blend over the frame as OpenGL does with the source
+				// alpha and one minus the source alpha
+				INT8 destination = LoadInts(pColor);
+				const FLOAT8 byteScale = Splat(1.0f / 255.0f);
+				const INT8 byteMask = SplatInt(0xFF);
+				FLOAT8 inverseAlpha = one - alpha;
+				red = red * alpha + ToFloat(destination & byteMask) * byteScale * inverseAlpha;
+				green = green * alpha + ToFloat(ShiftRight(destination, 8) & byteMask) * byteScale * inverseAlpha;
+				blue = blue * alpha + ToFloat(ShiftRight(destination, 16) & byteMask) * byteScale * inverseAlpha;
+				alpha = alpha * alpha + ToFloat(ShiftRight(destination, 24) & byteMask) * byteScale * inverseAlpha;
+			}
+
+			const FLOAT8 byteRange = Splat(255.0f);
+			INT8 packed =
+				RoundToInt(red * byteRange) |
+				ShiftLeft(RoundToInt(green * byteRange), 8) |
+				ShiftLeft(RoundToInt(blue * byteRange), 16) |
+				ShiftLeft(RoundToInt(alpha * byteRange), 24);
+			StoreInts(pColor, packed, covered);
+		}
+	}
+}
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// draw the scene on the CPU with a tiled, binned and multithreaded
+// rasterizer, for machines that have no GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderBackend.h"
+
+#include <atomic>
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class draws meshes into a color and depth buffer in
+ *  system memory.  Each frame runs in two parallel steps.
+ *  First, the submitted triangles are split evenly between
+ *  the threads, which transform and clip them and sort them
+ *  into bins for the screen tiles they touch.  Then each
+ *  thread takes whole tiles and draws the triangles of every
+ *  bin for the tile in submission order, testing the edge
+ *  functions and shading 8 pixels at a time, with AVX2 when
+ *  the compiler targets it.  The lighting follows the light
+ *  and material model of the scene shader.
+ ***********************************************************/
+class SoftwareRasterizer : public RenderBackend
+{
+public:
+	// size in pixels of the square tiles that the triangles are
+	// sorted into, which is a multiple of the pixels shaded at once
+	static const int TILE_SIZE = 64;
+
+	// constructor
+	SoftwareRasterizer();
+	// destructor
+	~SoftwareRasterizer();
+
+	// get the name with the pixel path the file was compiled for, so
+	// a build without AVX2 shows in the messages
+	const char* GetName() const override;
+	// start the threads that draw the frames
+	bool Initialize(WorkerPool* pWorkerPool) override;
+
+	void Reset() override;
+	int AddMesh(const MeshGenerator::MESH_DATA& meshData) override;
+	bool AddTextureLevel(int textureSlot, int width, int height, int colorChannels, const unsigned char* pPixels) override;
+
+	void BeginFrame(
+		int width,
+		int height,
+		glm::vec4 clearColor,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec3 viewPosition) override;
+	void DrawMesh(
+		int mesh,
+		const glm::mat4& modelMatrix,
+		glm::vec4 color,
+		int textureSlot,
+		const MATERIAL& material,
+		bool bBlended) override;
+	void EndFrame() override;
+
+protected:
+	// run a thread's part of the geometry or raster step
+	void ExecuteJob(int job, int workerIndex) override;
+
+private:
+	// a mesh in system memory
+	struct SOFTWARE_MESH
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	// one level of a texture, with a packed RGBA color per texel
+	struct TEXTURE_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<uint32_t> texels;
+	};
+
+	// a submitted mesh with its transforms and shading values, and
+	// the first of its triangles in the frame
+	struct DRAW
+	{
+		int mesh;
+		glm::mat4 modelMatrix;
+		glm::mat3 normalMatrix;
+		glm::vec4 color;
+		int textureSlot;
+		MATERIAL material;
+		bool bBlended;
+		size_t firstTriangle;
+	};
+
+	// a triangle that is set up for drawing, with its vertices in
+	// counter-clockwise order on screen
+	struct TRIANGLE
+	{
+		// coefficients of the edge functions of the edges opposite
+		// each vertex, and whether pixels on the edge are covered
+		float edgeA[3];
+		float edgeB[3];
+		double edgeC[3];
+		bool bTopLeft[3];
+		// one over twice the area, for the vertex weights
+		float inverseArea;
+		// window depth and one over the clip w of each vertex
+		float depth[3];
+		float inverseW[3];
+		// world position, normal and texture coordinates of each
+		// vertex
+		glm::vec3 position[3];
+		glm::vec3 normal[3];
+		glm::vec2 uv[3];
+		// pixels covered by the bounding box
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		int drawIndex;
+		// texture level that matches the texel size on screen
+		int textureLevel;
+	};
+
+	// a vertex being clipped, with its attributes
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clipPosition;
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// the triangles that a thread set up, and the triangles of
+	// each tile in the order they were submitted
+	struct WORKER
+	{
+		std::vector<TRIANGLE> triangles;
+		std::vector<std::vector<uint32_t>> bins;
+	};
+
+	// the steps that the threads run together
+	enum JOB
+	{
+		JOB_GEOMETRY = 1,
+		JOB_RASTER
+	};
+
+	std::vector<SOFTWARE_MESH> m_meshes;
+	std::vector<std::vector<TEXTURE_LEVEL>> m_textures;
+
+	// the frame being drawn
+	int m_tilesX;
+	int m_tilesY;
+	uint32_t m_clearColor;
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_viewPosition;
+	std::vector<DRAW> m_draws;
+
+	// the triangles and bins of the threads, where the first
+	// worker is the calling thread
+	std::vector<WORKER> m_workers;
+	// next tile to draw in the raster step
+	std::atomic<int> m_nextTile;
+
+	// transform, clip and bin a thread's share of the triangles
+	void ProcessGeometry(int workerIndex);
+	// clip a triangle against the near plane and set up the parts
+	// in view
+	void ClipTriangle(const CLIP_VERTEX vertices[3], int drawIndex, WORKER& worker);
+	// set up a triangle in view and add it to the bins of its tiles
+	void SetupTriangle(const CLIP_VERTEX& v0, const CLIP_VERTEX& v1, const CLIP_VERTEX& v2, int drawIndex, WORKER& worker);
+	// clear a tile and draw the triangles binned for it
+	void RasterizeTile(int tile);
+	// draw the part of a triangle inside a tile
+	void RasterizeTriangle(const TRIANGLE& triangle, int tileX, int tileY);
+};
@@ -0,0 +1,294 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.cpp
+// ============
+// merge the objects that never move into a few large meshes that
+// are already transformed into world space
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatcher.h"
+#include "GPUResources.h"
+
+#include <cfloat>
+
+/***********************************************************
+ *  StaticBatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatcher::StaticBatcher()
+{
+	m_paletteTextureID = 0;
+}
+
+/***********************************************************
+ *  ~StaticBatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatcher::~StaticBatcher()
+{
+	Reset();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for freeing the merged meshes and
+ *  the palette, before merging the objects of a changed
+ *  scene.
+ ***********************************************************/
+void StaticBatcher::Reset()
+{
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		MeshGenerator::DeleteMeshBuffers(m_batches[i].buffers);
+		DeleteTrackedBuffer(m_batches[i].lightingVBO);
+	}
+	m_batches.clear();
+	m_batchData.clear();
+	m_paletteColors.clear();
+	DeleteTrackedTexture(m_paletteTextureID);
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for appending the triangles of a mesh
+ *  to the batch for its texture and material.  Positions
+ *  are transformed by the model matrix and normals by its
+ *  inverse transpose.  Untextured vertices get the texel
+ *  of their color in place of their texture coordinates,
+ *  which are mapped into the palette once its size is
+ *  known.
+ ***********************************************************/
+int StaticBatcher::AddObject(
+	const MeshGenerator::MESH_DATA& meshData,
+	const glm::mat4& modelMatrix,
+	glm::vec4 color,
+	int textureSlot,
+	int materialIndex)
+{
+	const int stride = MeshGenerator::FLOATS_PER_VERTEX;
+
+	// objects with the same texture and material share a batch
+	int batchIndex = -1;
+	for (size_t i = 0; (i < m_batchData.size()) && (batchIndex < 0); i++)
+	{
+		if ((m_batchData[i].textureSlot == textureSlot) && (m_batchData[i].materialIndex == materialIndex))
+		{
+			batchIndex = (int)i;
+		}
+	}
+	if (batchIndex < 0)
+	{
+		BATCH_DATA batchData;
+		batchData.textureSlot = textureSlot;
+		batchData.materialIndex = materialIndex;
+		batchData.objectCount = 0;
+		batchData.meshData.boundsMin = glm::vec3(FLT_MAX);
+		batchData.meshData.boundsMax = glm::vec3(-FLT_MAX);
+		m_batchData.push_back(batchData);
+		batchIndex = (int)m_batchData.size() - 1;
+	}
+
+	BATCH_DATA& batchData = m_batchData[batchIndex];
+	MeshGenerator::MESH_DATA& batchMesh = batchData.meshData;
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+	int paletteTexel = (textureSlot < 0) ? FindPaletteColor(color) : -1;
+	GLuint firstVertex = (GLuint)(batchMesh.vertices.size() / stride);
+	size_t vertexCount = meshData.vertices.size() / stride;
+
+	batchMesh.vertices.reserve(batchMesh.vertices.size() + vertexCount * stride);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const GLfloat* pVertex = &meshData.vertices[i * stride];
+		glm::vec3 position = glm::vec3(modelMatrix * glm::vec4(pVertex[0], pVertex[1], pVertex[2], 1.0f));
+		glm::vec3 normal = normalMatrix * glm::vec3(pVertex[3], pVertex[4], pVertex[5]);
+		float normalLength = glm::length(normal);
+		if (normalLength > 0.0f)
+		{
+			normal /= normalLength;
+		}
+
+		batchMesh.vertices.push_back(position.x);
+		batchMesh.vertices.push_back(position.y);
+		batchMesh.vertices.push_back(position.z);
+		batchMesh.vertices.push_back(normal.x);
+		batchMesh.vertices.push_back(normal.y);
+		batchMesh.vertices.push_back(normal.z);
+		batchMesh.vertices.push_back((paletteTexel >= 0) ? (GLfloat)paletteTexel : pVertex[6]);
+		batchMesh.vertices.push_back((paletteTexel >= 0) ? 0.5f : pVertex[7]);
+
+		batchMesh.boundsMin = glm::min(batchMesh.boundsMin, position);
+		batchMesh.boundsMax = glm::max(batchMesh.boundsMax, position);
+	}
+
+	batchMesh.indices.reserve(batchMesh.indices.size() + meshData.indices.size());
+	for (size_t i = 0; i < meshData.indices.size(); i++)
+	{
+		batchMesh.indices.push_back(firstVertex + meshData.indices[i]);
+	}
+	batchData.objectCount++;
+
+	return batchIndex;
+}
+
+/***********************************************************
+ *  SetMergedLighting()
+ *
+ *  This method is used for keeping the baked color of each
+ *  vertex of a merged mesh until it is built.  Colors that
+ *  do not match the vertices are ignored.
+ ***********************************************************/
+void StaticBatcher::SetMergedLighting(int index, const std::vector<GLfloat>& lighting)
+{
+	if ((index < 0) || (index >= (int)m_batchData.size()))
+	{
+		return;
+	}
+
+	BATCH_DATA& batchData = m_batchData[index];
+	if (lighting.size() / 3 == batchData.meshData.vertices.size() / MeshGenerator::FLOATS_PER_VERTEX)
+	{
+		batchData.lighting = lighting;
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for loading the merged meshes into
+ *  OpenGL buffers, and the palette colors into a texture
+ *  that is sampled at the center of each texel.  Baked
+ *  lighting goes into its own buffer, which is added to the
+ *  vertex array of the mesh.  The merged data is freed once
+ *  it is loaded.
+ ***********************************************************/
+bool StaticBatcher::Build()
+{
+	const int stride = MeshGenerator::FLOATS_PER_VERTEX;
+
+	if (false == m_paletteColors.empty())
+	{
+		int paletteWidth = (int)m_paletteColors.size();
+		std::vector<unsigned char> texels(m_paletteColors.size() * 4);
+		for (size_t i = 0; i < m_paletteColors.size(); i++)
+		{
+			for (int channel = 0; channel < 4; channel++)
+			{
+				texels[i * 4 + channel] = (unsigned char)(glm::clamp(m_paletteColors[i][channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+
+		m_paletteTextureID = GenTrackedTexture("static batch palette");
+		glBindTexture(GL_TEXTURE_2D, m_paletteTextureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, paletteWidth, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, m_paletteTextureID, GetTextureStorageSize(GL_RGBA8, paletteWidth, 1));
+
+		// move the texel numbers to the texel centers
+		for (size_t i = 0; i < m_batchData.size(); i++)
+		{
+			if (m_batchData[i].textureSlot >= 0)
+			{
+				continue;
+			}
+			std::vector<GLfloat>& vertices = m_batchData[i].meshData.vertices;
+			for (size_t vertex = 6; vertex < vertices.size(); vertex += stride)
+			{
+				vertices[vertex] = (vertices[vertex] + 0.5f) / (float)paletteWidth;
+			}
+		}
+	}
+
+	bool bBuilt = true;
+	for (size_t i = 0; i < m_batchData.size(); i++)
+	{
+		const BATCH_DATA& batchData = m_batchData[i];
+		STATIC_BATCH batch = {};
+		batch.textureSlot = batchData.textureSlot;
+		batch.materialIndex = batchData.materialIndex;
+		batch.objectCount = batchData.objectCount;
+		if (false == MeshGenerator::UploadMeshBuffers(
+			batchData.meshData.vertices.data(),
+			batchData.meshData.vertices.size() / stride,
+			batchData.meshData.indices.data(),
+			batchData.meshData.indices.size(),
+			batchData.meshData.boundsMin,
+			batchData.meshData.boundsMax,
+			batch.buffers))
+		{
+			bBuilt = false;
+		}
+		if ((0 != batch.buffers.vao) && (false == batchData.lighting.empty()))
+		{
+			size_t lightingBytes = batchData.lighting.size() * sizeof(GLfloat);
+			batch.lightingVBO = GenTrackedBuffer("static batch lighting");
+			glBindVertexArray(batch.buffers.vao);
+			glBindBuffer(GL_ARRAY_BUFFER, batch.lightingVBO);
+			glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)lightingBytes, batchData.lighting.data(), GL_STATIC_DRAW);
+			glVertexAttribPointer(LIGHTING_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+			glEnableVertexAttribArray(LIGHTING_ATTRIBUTE);
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			SetTrackedResourceSize(GPU_RESOURCE_BUFFER, batch.lightingVBO, lightingBytes);
+		}
+		m_batches.push_back(batch);
+	}
+	m_batchData.clear();
+
+	return bBuilt;
+}
+
+/***********************************************************
+ *  BindPalette()
+ *
+ *  This method is used for binding the palette to its
+ *  texture unit before the untextured batches are drawn.
+ ***********************************************************/
+void StaticBatcher::BindPalette() const
+{
+	glActiveTexture(GL_TEXTURE0 + PALETTE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_paletteTextureID);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DrawBatch()
+ *
+ *  This method is used for drawing the merged mesh of a
+ *  batch with the currently active shader program.
+ ***********************************************************/
+void StaticBatcher::DrawBatch(int index) const
+{
+	if ((index < 0) || (index >= (int)m_batches.size()))
+	{
+		return;
+	}
+
+	MeshGenerator::DrawMeshBuffers(m_batches[index].buffers);
+}
+
+/***********************************************************
+ *  FindPaletteColor()
+ *
+ *  This method is used for finding the texel of a color in
+ *  the palette, adding the color the first time it is used.
+ ***********************************************************/
+int StaticBatcher::FindPaletteColor(glm::vec4 color)
+{
+	for (size_t i = 0; i < m_paletteColors.size(); i++)
+	{
+		if (m_paletteColors[i] == color)
+		{
+			return (int)i;
+		}
+	}
+
+	m_paletteColors.push_back(color);
+	return (int)m_paletteColors.size() - 1;
+}
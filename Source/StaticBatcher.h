@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatcher.h
+// ============
+// merge the objects that never move into a few large meshes that
+// are already transformed into world space
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  StaticBatcher
+ *
+ *  This class transforms the vertices of static objects
+ *  into world space and appends them to one mesh for each
+ *  texture and material, so the objects that share them are
+ *  drawn together with an identity model matrix.  The
+ *  scene shader takes the object color as a uniform, so the
+ *  colors of untextured objects are baked into the texture
+ *  coordinates of their vertices instead, which pick the
+ *  color from a palette texture with one texel per color.
+ *  Before they are built, the merged meshes can be changed
+ *  and given baked lighting for each vertex, which is read
+ *  as an extra vertex attribute.
+ ***********************************************************/
+class StaticBatcher
+{
+public:
+	// texture unit the palette is bound to, which is not used by
+	// the scene textures or the frame graph inputs
+	static const int PALETTE_TEXTURE_UNIT = 29;
+	// vertex attribute that the baked lighting is read from
+	static const int LIGHTING_ATTRIBUTE = 3;
+
+	// a merged mesh with the texture and material of its objects
+	struct STATIC_BATCH
+	{
+		MeshGenerator::MESH_BUFFERS buffers;
+		// texture slot, or -1 for the palette, and material index
+		int textureSlot;
+		int materialIndex;
+		// number of objects merged into the mesh
+		int objectCount;
+		// baked color of each vertex, or 0 when it is not baked
+		GLuint lightingVBO;
+	};
+
+	// constructor
+	StaticBatcher();
+	// destructor
+	~StaticBatcher();
+
+	// free the batches and the palette
+	void Reset();
+	// add the triangles of a mesh at a world transform - returns
+	// the batch the object is merged into
+	int AddObject(
+		const MeshGenerator::MESH_DATA& meshData,
+		const glm::mat4& modelMatrix,
+		glm::vec4 color,
+		int textureSlot,
+		int materialIndex);
+	// get the merged meshes before they are built
+	int GetMergedCount() const { return (int)m_batchData.size(); }
+	MeshGenerator::MESH_DATA& GetMergedMesh(int index) { return m_batchData[index].meshData; }
+	int GetMergedMaterial(int index) const { return m_batchData[index].materialIndex; }
+	// set the baked color of each vertex of a merged mesh, with
+	// three values per vertex
+	void SetMergedLighting(int index, const std::vector<GLfloat>& lighting);
+	// load the merged meshes and the palette into OpenGL
+	bool Build();
+
+	// get the built batches
+	int GetBatchCount() const { return (int)m_batches.size(); }
+	const STATIC_BATCH& GetBatch(int index) const { return m_batches[index]; }
+	// bind the palette to its texture unit
+	void BindPalette() const;
+	// draw the merged mesh of a batch
+	void DrawBatch(int index) const;
+
+private:
+	// the merged data of a batch until it is built
+	struct BATCH_DATA
+	{
+		int textureSlot;
+		int materialIndex;
+		int objectCount;
+		MeshGenerator::MESH_DATA meshData;
+		std::vector<GLfloat> lighting;
+	};
+
+	std::vector<BATCH_DATA> m_batchData;
+	std::vector<STATIC_BATCH> m_batches;
+	// colors of the untextured objects, and the texture they are
+	// read from
+	std::vector<glm::vec4> m_paletteColors;
+	GLuint m_paletteTextureID;
+
+	// find or add a palette color - returns its texel
+	int FindPaletteColor(glm::vec4 color);
+};
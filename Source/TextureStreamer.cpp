@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// keep only the mip levels of the scene textures that the visible
+// objects need resident on the GPU, within a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+#include "GPUResources.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer()
+{
+	m_frame = 0;
+	m_residentBytes = 0;
+	m_bStreaming = false;
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	DeleteTextures();
+}
+
+/***********************************************************
+ *  LoadTexture()
+ *
+ *  This method is used for loading an image file, building
+ *  its mip chain in system memory, and uploading the levels
+ *  that are no larger than the resident size.  The image
+ *  stays in system memory, which stands in for reading the
+ *  finer levels from disk when they are requested.
+ ***********************************************************/
+int TextureStreamer::LoadTexture(const char* filename)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// indicate to always flip images vertically when loaded
+	stbi_set_flip_vertically_on_load(true);
+
+	// try to parse the image data from the specified image file
+	unsigned char* image = stbi_load(
+		filename,
+		&width,
+		&height,
+		&colorChannels,
+		0);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return -1;
+	}
+
+	std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+
+	// only RGB and RGBA images - with transparency - are handled
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		stbi_image_free(image);
+		return -1;
+	}
+
+	STREAMED_TEXTURE texture;
+	texture.internalFormat = (colorChannels == 4) ? GL_RGBA8 : GL_RGB8;
+	texture.pixelFormat = (colorChannels == 4) ? GL_RGBA : GL_RGB;
+
+	MIP_LEVEL baseLevel;
+	baseLevel.width = width;
+	baseLevel.height = height;
+	baseLevel.pixels.assign(image, image + (size_t)width * height * colorChannels);
+	texture.levels.push_back(std::move(baseLevel));
+	stbi_image_free(image);
+
+	// each level averages the 2x2 texels under it in the level
+	// above, repeating the edge texels of odd sizes
+	while ((texture.levels.back().width > 1) || (texture.levels.back().height > 1))
+	{
+		const MIP_LEVEL& source = texture.levels.back();
+		MIP_LEVEL level;
+		level.width = std::max(1, source.width / 2);
+		level.height = std::max(1, source.height / 2);
+		level.pixels.resize((size_t)level.width * level.height * colorChannels);
+		for (int y = 0; y < level.height; y++)
+		{
+			int y0 = std::min(y * 2, source.height - 1);
+			int y1 = std::min(y * 2 + 1, source.height - 1);
+			for (int x = 0; x < level.width; x++)
+			{
+				int x0 = std::min(x * 2, source.width - 1);
+				int x1 = std::min(x * 2 + 1, source.width - 1);
+				for (int c = 0; c < colorChannels; c++)
+				{
+					int sum =
+						source.pixels[((size_t)y0 * source.width + x0) * colorChannels + c] +
+						source.pixels[((size_t)y0 * source.width + x1) * colorChannels + c] +
+						source.pixels[((size_t)y1 * source.width + x0) * colorChannels + c] +
+						source.pixels[((size_t)y1 * source.width + x1) * colorChannels + c];
+					level.pixels[((size_t)y * level.width + x) * colorChannels + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		texture.levels.push_back(std::move(level));
+	}
+
+	// the coarse levels are the ones that always stay uploaded
+	int lastLevel = (int)texture.levels.size() - 1;
+	texture.coarseLevel = 0;
+	while ((texture.coarseLevel < lastLevel) &&
+		(std::max(texture.levels[texture.coarseLevel].width, texture.levels[texture.coarseLevel].height) > RESIDENT_MIP_SIZE))
+	{
+		texture.coarseLevel++;
+	}
+	texture.residentLevel = texture.coarseLevel;
+	texture.requestedLevel = texture.coarseLevel;
+	texture.residentBytes = 0;
+	texture.lastUsedFrame = m_frame;
+
+	texture.textureID = GenTrackedTexture("streamed texture");
+	glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, texture.textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters, sampling only between
+	// the uploaded levels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.residentLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i = texture.coarseLevel; i <= lastLevel; i++)
+	{
+		const MIP_LEVEL& level = texture.levels[i];
+		glTexImage2D(GL_TEXTURE_2D, i, texture.internalFormat, level.width, level.height, 0, texture.pixelFormat, GL_UNSIGNED_BYTE, level.pixels.data());
+		texture.residentBytes += GetLevelBytes(texture, i);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, texture.textureID, texture.residentBytes);
+	m_residentBytes += texture.residentBytes;
+	m_textures.push_back(std::move(texture));
+
+	return (int)m_textures.size() - 1;
+}
+
+/***********************************************************
+ *  DeleteTextures()
+ *
+ *  This method is used for freeing the loaded textures and
+ *  the images kept for them.
+ ***********************************************************/
+void TextureStreamer::DeleteTextures()
+{
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		DeleteTrackedTexture(m_textures[i].textureID);
+	}
+	m_textures.clear();
+	m_residentBytes = 0;
+	m_bStreaming = false;
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the OpenGL texture of a
+ *  loaded texture, which stays the same while its levels
+ *  are uploaded and evicted.
+ ***********************************************************/
+GLuint TextureStreamer::GetTextureID(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return 0;
+	}
+
+	return m_textures[textureIndex].textureID;
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting the number of levels in
+ *  the mip chain of a loaded texture, or 0 if the texture
+ *  is unknown.
+ ***********************************************************/
+int TextureStreamer::GetLevelCount(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return 0;
+	}
+
+	return (int)m_textures[textureIndex].levels.size();
+}
+
+/***********************************************************
+ *  GetLevelPixels()
+ *
+ *  This method is used for getting the pixels of one level
+ *  of a loaded texture from system memory, whether or not
+ *  the level is uploaded.  The rows start at the bottom of
+ *  the image, as they are uploaded to OpenGL.
+ ***********************************************************/
+bool TextureStreamer::GetLevelPixels(
+	int textureIndex,
+	int level,
+	int& width,
+	int& height,
+	int& colorChannels,
+	const unsigned char*& pPixels) const
+{
+	if ((level < 0) || (level >= GetLevelCount(textureIndex)))
+	{
+		return false;
+	}
+
+	const STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	width = texture.levels[level].width;
+	height = texture.levels[level].height;
+	colorChannels = (texture.pixelFormat == GL_RGBA) ? 4 : 3;
+	pPixels = texture.levels[level].pixels.data();
+
+	return true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the requests of the
+ *  previous frame, so that the textures only ask for the
+ *  levels that this frame needs.
+ ***********************************************************/
+void TextureStreamer::BeginFrame()
+{
+	m_frame++;
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		m_textures[i].requestedLevel = m_textures[i].coarseLevel;
+	}
+}
+
+/***********************************************************
+ *  RequestTexture()
+ *
+ *  This method is used for requesting the level of a texture
+ *  that has about one texel for each pixel, when the whole
+ *  texture is spread over an area of the given size on
+ *  screen.  The finest level requested in the frame wins.
+ ***********************************************************/
+void TextureStreamer::RequestTexture(int textureIndex, float screenSize)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	texture.lastUsedFrame = m_frame;
+
+	int level = texture.coarseLevel;
+	if (screenSize > 0.0f)
+	{
+		float texels = (float)std::max(texture.levels[0].width, texture.levels[0].height);
+		level = (int)std::floor(std::log2(texels / screenSize));
+	}
+	level = std::max(0, std::min(level, texture.coarseLevel));
+	texture.requestedLevel = std::min(texture.requestedLevel, level);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the next finer level of
+ *  every texture that was requested at a finer level than
+ *  it has, and evicting the finest levels of the least
+ *  recently used textures to stay within the budget.  A
+ *  level that does not fit after evicting everything that
+ *  is not needed this frame waits, rather than evicting a
+ *  level that is in use.
+ ***********************************************************/
+bool TextureStreamer::Update(size_t budgetBytes)
+{
+	bool bChanged = false;
+
+	// a lowered budget is met by evicting the unneeded levels
+	while (m_residentBytes > budgetBytes)
+	{
+		int candidate = FindEvictionCandidate(-1);
+		if (candidate < 0)
+		{
+			break;
+		}
+		EvictLevel(candidate);
+		bChanged = true;
+	}
+
+	m_bStreaming = false;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		if (texture.requestedLevel >= texture.residentLevel)
+		{
+			continue;
+		}
+
+		size_t levelBytes = GetLevelBytes(texture, texture.residentLevel - 1);
+		while (m_residentBytes + levelBytes > budgetBytes)
+		{
+			int candidate = FindEvictionCandidate(i);
+			if (candidate < 0)
+			{
+				break;
+			}
+			EvictLevel(candidate);
+			bChanged = true;
+		}
+		if (m_residentBytes + levelBytes > budgetBytes)
+		{
+			continue;
+		}
+
+		UploadNextLevel(i);
+		bChanged = true;
+		m_bStreaming = true;
+	}
+
+	if (bChanged)
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	return m_bStreaming;
+}
+
+/***********************************************************
+ *  UploadNextLevel()
+ *
+ *  This method is used for uploading the level below the
+ *  finest uploaded level of a texture, and letting the
+ *  texture sample from it.
+ ***********************************************************/
+void TextureStreamer::UploadNextLevel(int textureIndex)
+{
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	int levelIndex = texture.residentLevel - 1;
+	const MIP_LEVEL& level = texture.levels[levelIndex];
+
+	glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, texture.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, levelIndex, texture.internalFormat, level.width, level.height, 0, texture.pixelFormat, GL_UNSIGNED_BYTE, level.pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelIndex);
+
+	size_t levelBytes = GetLevelBytes(texture, levelIndex);
+	texture.residentLevel = levelIndex;
+	texture.residentBytes += levelBytes;
+	m_residentBytes += levelBytes;
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, texture.textureID, texture.residentBytes);
+}
+
+/***********************************************************
+ *  EvictLevel()
+ *
+ *  This method is used for freeing the finest uploaded level
+ *  of a texture.  The texture stops sampling from the level
+ *  first, and the level is then given an empty size, which
+ *  releases its storage.
+ ***********************************************************/
+void TextureStreamer::EvictLevel(int textureIndex)
+{
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	int levelIndex = texture.residentLevel;
+
+	glActiveTexture(GL_TEXTURE0 + UPLOAD_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, texture.textureID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelIndex + 1);
+	glTexImage2D(GL_TEXTURE_2D, levelIndex, texture.internalFormat, 0, 0, 0, texture.pixelFormat, GL_UNSIGNED_BYTE, NULL);
+
+	size_t levelBytes = GetLevelBytes(texture, levelIndex);
+	texture.residentLevel = levelIndex + 1;
+	texture.residentBytes -= levelBytes;
+	m_residentBytes -= levelBytes;
+	SetTrackedResourceSize(GPU_RESOURCE_TEXTURE, texture.textureID, texture.residentBytes);
+}
+
+/***********************************************************
+ *  FindEvictionCandidate()
+ *
+ *  This method is used for finding the texture that gives
+ *  up its finest level first.  Levels finer than the coarse
+ *  levels can be evicted unless this frame needs them, and
+ *  the texture that was used longest ago goes first.
+ ***********************************************************/
+int TextureStreamer::FindEvictionCandidate(int excludedIndex) const
+{
+	int candidate = -1;
+
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		if ((i == excludedIndex) || (texture.residentLevel >= texture.coarseLevel))
+		{
+			continue;
+		}
+
+		// the finest level is still needed when it was requested
+		// by an object of this frame
+		if ((texture.lastUsedFrame == m_frame) && (texture.residentLevel >= texture.requestedLevel))
+		{
+			continue;
+		}
+
+		if ((candidate < 0) || (texture.lastUsedFrame < m_textures[candidate].lastUsedFrame))
+		{
+			candidate = i;
+		}
+	}
+
+	return candidate;
+}
+
+/***********************************************************
+ *  GetLevelBytes()
+ *
+ *  This method is used for getting the bytes that one level
+ *  of a texture takes on the GPU.
+ ***********************************************************/
+size_t TextureStreamer::GetLevelBytes(const STREAMED_TEXTURE& texture, int level) const
+{
+	return GetTextureStorageSize(texture.internalFormat, texture.levels[level].width, texture.levels[level].height);
+}
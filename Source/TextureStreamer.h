@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// keep only the mip levels of the scene textures that the visible
+// objects need resident on the GPU, within a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class loads texture images with their whole mip
+ *  chain in system memory, but only uploads the coarse
+ *  levels at first.  Each frame, the objects that are drawn
+ *  request the level that matches their size on screen, and
+ *  the finer levels are uploaded one step per frame.  When
+ *  the uploaded levels would go over the budget, the finest
+ *  levels of the least recently used textures are evicted
+ *  first.  The coarse levels stay resident, so a texture
+ *  can always be sampled.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// the levels no larger than this size are uploaded when a
+	// texture is loaded, and are never evicted
+	static const int RESIDENT_MIP_SIZE = 64;
+	// texture unit used for uploading, which is not used by the
+	// scene textures or the frame graph inputs
+	static const int UPLOAD_TEXTURE_UNIT = 31;
+
+	// constructor
+	TextureStreamer();
+	// destructor
+	~TextureStreamer();
+
+	// load an image file and upload its coarse levels - returns
+	// the texture index, or -1 if the image cannot be used
+	int LoadTexture(const char* filename);
+	// free the textures and their images
+	void DeleteTextures();
+	// get the OpenGL texture of a loaded texture
+	GLuint GetTextureID(int textureIndex) const;
+	// get the number of levels of a loaded texture, and the
+	// pixels of a level in system memory - returns false for an
+	// unknown texture or level
+	int GetLevelCount(int textureIndex) const;
+	bool GetLevelPixels(
+		int textureIndex,
+		int level,
+		int& width,
+		int& height,
+		int& colorChannels,
+		const unsigned char*& pPixels) const;
+
+	// start collecting the levels requested for a frame
+	void BeginFrame();
+	// request the level of a texture that covers an area of the
+	// given size in pixels on screen
+	void RequestTexture(int textureIndex, float screenSize);
+	// upload and evict levels for the requests of the frame within
+	// a budget in bytes - returns true when any level was uploaded
+	bool Update(size_t budgetBytes);
+	// check whether the last update uploaded levels, so that more
+	// frames are needed until the requests are met
+	bool IsStreaming() const { return m_bStreaming; }
+
+	// get the bytes of the uploaded levels of all the textures
+	size_t GetResidentBytes() const { return m_residentBytes; }
+
+private:
+	// one level of the mip chain, kept in system memory
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	// a texture with the range of its levels that are uploaded
+	struct STREAMED_TEXTURE
+	{
+		GLuint textureID;
+		GLenum internalFormat;
+		GLenum pixelFormat;
+		std::vector<MIP_LEVEL> levels;
+		// finest uploaded level, and the finest level that stays
+		// uploaded for as long as the texture is loaded
+		int residentLevel;
+		int coarseLevel;
+		// bytes of the uploaded levels
+		size_t residentBytes;
+		// finest level requested this frame
+		int requestedLevel;
+		// frame in which an object last requested the texture
+		unsigned int lastUsedFrame;
+	};
+
+	std::vector<STREAMED_TEXTURE> m_textures;
+	// number of the frame being collected
+	unsigned int m_frame;
+	// bytes of all of the uploaded levels
+	size_t m_residentBytes;
+	// true when the last update uploaded levels
+	bool m_bStreaming;
+
+	// upload the level below the finest uploaded level
+	void UploadNextLevel(int textureIndex);
+	// free the finest uploaded level
+	void EvictLevel(int textureIndex);
+	// find the texture whose finest level should be evicted first,
+	// or -1 if every uploaded level is still needed
+	int FindEvictionCandidate(int excludedIndex) const;
+	// get the bytes that one level takes on the GPU
+	size_t GetLevelBytes(const STREAMED_TEXTURE& texture, int level) const;
+};
@@ -8,20 +8,38 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "GLCapture.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 // declaration of the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+
+	// the camera is simulated in fixed steps of this length,
+	// independent of how long each frame takes to render
+	const double SIMULATION_TICK = 1.0 / 120.0;
+	// longest time the simulation catches up on after being idle
+	const double MAX_SIMULATION_CATCHUP = 0.25;
+	// time the event loop waits when the camera is not moving
+	const double IDLE_WAIT_TIME = 0.25;
+	// time between reports of the input-to-photon latency
+	const double LATENCY_REPORT_INTERVAL = 5.0;
+	// the editor views look at this point from this distance, and
+	// show this much of the scene above and below their centers
+	const glm::vec3 EDITOR_VIEW_TARGET(0.0f, 2.0f, 0.0f);
+	const float EDITOR_VIEW_DISTANCE = 40.0f;
+	const float EDITOR_VIEW_EXTENT = 12.0f;
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -32,13 +50,50 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
-
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// input events queued by the GLFW callbacks - the callbacks run
+	// on the main thread, which is also the thread that processes
+	// the queue, so no locking is needed
+	std::vector<ViewManager::INPUT_EVENT> gInputEvents;
+	// initial capacity of the input event queue
+	const size_t INPUT_EVENT_CAPACITY = 256;
+
+	/***********************************************************
+	 *  JitterProjection()
+	 *
+	 *  This function is used for moving a projection by a
+	 *  fraction of a pixel of the viewport it is drawn into.
+	 ***********************************************************/
+	glm::mat4 JitterProjection(const glm::mat4& projection, glm::vec2 jitter, int width, int height)
+	{
+		glm::mat4 offset(1.0f);
+		offset[3][0] = jitter.x * 2.0f / (float)width;
+		offset[3][1] = jitter.y * 2.0f / (float)height;
+
+		return offset * projection;
+	}
+
+	/***********************************************************
+	 *  QueueInputEvent()
+	 *
+	 *  This function is used for adding an input event with
+	 *  the current time to the input event queue.
+	 ***********************************************************/
+	void QueueInputEvent(ViewManager::INPUT_EVENT_TYPE type, int key, int action, double x, double y)
+	{
+		ViewManager::INPUT_EVENT inputEvent;
+
+		inputEvent.type = type;
+		inputEvent.key = key;
+		inputEvent.action = action;
+		inputEvent.x = x;
+		inputEvent.y = y;
+		inputEvent.time = glfwGetTime();
+		gInputEvents.push_back(inputEvent);
+	}
 }
 
 /***********************************************************
@@ -52,12 +107,50 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pRenderSettings = NULL;
+	m_framebufferWidth = WINDOW_WIDTH;
+	m_framebufferHeight = WINDOW_HEIGHT;
+	m_bPickRequested = false;
+	m_pickPoint = glm::vec2(0.0f);
+	m_sceneViewCount = 1;
+	for (int i = 0; i < MAX_SCENE_VIEWS; i++)
+	{
+		m_sceneViews[i].view = glm::mat4(1.0f);
+		m_sceneViews[i].projection = glm::mat4(1.0f);
+		m_sceneViews[i].viewPosition = glm::vec3(0.0f);
+		m_sceneViews[i].x = 0;
+		m_sceneViews[i].y = 0;
+		m_sceneViews[i].width = WINDOW_WIDTH;
+		m_sceneViews[i].height = WINDOW_HEIGHT;
+	}
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
+
+	// initialize the simulation and the published camera values
+	m_simulationTime = 0.0;
+	for (int i = 0; i <= GLFW_KEY_LAST; i++)
+	{
+		m_bKeyHeld[i] = false;
+	}
+	m_unpublishedInputTime = 0.0;
+	m_pendingInputTime = 0.0;
+	m_changeVersion = 1;
+	m_renderedVersion = 0;
+	m_bFixedCamera = false;
+	m_bInterpolating = false;
+	m_frameInputTime = 0.0;
+	m_latencyTotal = 0.0;
+	m_latencyMax = 0.0;
+	m_latencyCount = 0;
+	m_lastLatencyReportTime = 0.0;
+	gInputEvents.reserve(INPUT_EVENT_CAPACITY);
+	PublishCameraState();
+	m_previousState = m_currentState;
+	m_renderState = m_currentState;
 }
 
 /***********************************************************
@@ -70,6 +163,7 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	m_pRenderSettings = NULL;
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -106,6 +200,21 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
+	// this callback is used to receive key press and release events
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+
+	// this callback is used to receive clicks for picking objects
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+
+	// this callback is used to redraw the window after it was
+	// uncovered or resized while the view was not changing
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
+	// this callback is used to follow the size of the window, which
+	// can differ from the requested size on high DPI displays
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+	glfwGetFramebufferSize(window, &m_framebufferWidth, &m_framebufferHeight);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -124,110 +233,616 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  *
  *  This method is automatically called from GLFW whenever
  *  the mouse is moved within the active GLFW display window.
+ *  The event is queued for the next simulation update.
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
-// when the first mouse move event is received, this needs to be recorded so that
-// all subsequent mouse moves can correctly calculate the X position offset and Y
-// position offset for proper operation -MK
-	if (gFirstMouse)
+	QueueInputEvent(INPUT_MOUSE_POSITION, 0, 0, xMousePos, yMousePos);
+}
+
+/***********************************************************
+ *  Mouse_Scroll_Callback() -MK
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the mouse wheel is scrolled up or down within the active
+ *  GLFW display window.  The event is queued for the next
+ *  simulation update.
+ ***********************************************************/
+void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset)
+{
+	QueueInputEvent(INPUT_MOUSE_SCROLL, 0, 0, xOffset, yOffset);
+}
+
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  a mouse button is pressed or released.  The event is
+ *  queued with the cursor position at the time of the click.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	double xMousePos = 0.0;
+	double yMousePos = 0.0;
+
+	glfwGetCursorPos(window, &xMousePos, &yMousePos);
+	QueueInputEvent(INPUT_MOUSE_BUTTON, button, action, xMousePos, yMousePos);
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  a key is pressed, repeated or released within the active
+ *  GLFW display window.  The event is queued for the next
+ *  simulation update.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	// key repeats do not change the held state of the key
+	if ((key < 0) || (key > GLFW_KEY_LAST) || (action == GLFW_REPEAT))
 	{
-		gLastX = xMousePos;
-		gLastY = yMousePos;
-		gFirstMouse = false;
+		return;
 	}
 
-	// calculate the X offset and Y offset values for moving the 3D camera accordingly -MK
-	float xOffset = xMousePos - gLastX;
-	float yOffset = gLastY - yMousePos; // reversed since y-coordinates go from bottom to top -MK
-
-	// set the current positions into the last position variables -MK
-	gLastX = xMousePos;
-	gLastY = yMousePos;
+	QueueInputEvent(INPUT_KEY, key, action, 0.0, 0.0);
+}
 
-	// move the 3D camera according to the calculated offsets -MK
-	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the window need to be drawn again.  The
+ *  event is queued for the next simulation update.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	QueueInputEvent(INPUT_WINDOW_REFRESH, 0, 0, 0.0, 0.0);
 }
 
 /***********************************************************
- *  Mouse_Scroll_Callback() -MK
+ *  Framebuffer_Size_Callback()
  *
  *  This method is automatically called from GLFW whenever
- *  the mouse wheel is scrolled up or down within the active
- *  GLFW display window.
+ *  the window framebuffer is resized.  The event is queued
+ *  for the next simulation update.
  ***********************************************************/
-void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset)
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
 {
-	// movement speed dynamically -MK
-	g_pCamera->MovementSpeed += yOffset * 0.5f; // Scroll up speeds up, scroll down slows down -MK
+	QueueInputEvent(INPUT_FRAMEBUFFER_SIZE, 0, 0, (double)width, (double)height);
+}
 
-	// speed to reasonable limits -MK
-	if (g_pCamera->MovementSpeed < 1.0f) g_pCamera->MovementSpeed = 1.0f;
-	if (g_pCamera->MovementSpeed > 10.0f) g_pCamera->MovementSpeed = 10.0f;
+/***********************************************************
+ *  SetRenderSettings()
+ *
+ *  This method is used for setting the rendering options
+ *  that can be toggled from the keyboard.
+ ***********************************************************/
+void ViewManager::SetRenderSettings(RENDER_SETTINGS* pRenderSettings)
+{
+	m_pRenderSettings = pRenderSettings;
+}
 
-	if (!g_pCamera) return;
+/***********************************************************
+ *  ProcessInputEvents()
+ *
+ *  This method is called to process the input events that
+ *  were queued by the GLFW callbacks since the last update.
+ ***********************************************************/
+void ViewManager::ProcessInputEvents()
+{
+	// if the camera object is null, then exit this method -MK
+	if (NULL == g_pCamera)
+	{
+		gInputEvents.clear();
+		return;
+	}
+
+	for (size_t i = 0; i < gInputEvents.size(); i++)
+	{
+		const INPUT_EVENT& inputEvent = gInputEvents[i];
+
+		// remember when the first input since the last step arrived
+		if (m_unpublishedInputTime == 0.0)
+		{
+			m_unpublishedInputTime = inputEvent.time;
+		}
+
+		if (inputEvent.type == INPUT_KEY)
+		{
+			ProcessKeyEvent(inputEvent.key, inputEvent.action);
+		}
+		else if (inputEvent.type == INPUT_MOUSE_POSITION)
+		{
+			double xMousePos = inputEvent.x;
+			double yMousePos = inputEvent.y;
+
+			// when the first mouse move event is received, this needs to be recorded so that
+			// all subsequent mouse moves can correctly calculate the X position offset and Y
+			// position offset for proper operation -MK
+			if (gFirstMouse)
+			{
+				gLastX = xMousePos;
+				gLastY = yMousePos;
+				gFirstMouse = false;
+			}
+
+			// calculate the X offset and Y offset values for moving the 3D camera accordingly -MK
+			float xOffset = xMousePos - gLastX;
+			float yOffset = gLastY - yMousePos; // reversed since y-coordinates go from bottom to top -MK
+
+			// set the current positions into the last position variables -MK
+			gLastX = xMousePos;
+			gLastY = yMousePos;
+
+			// move the 3D camera according to the calculated offsets -MK
+			g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+		}
+		else if (inputEvent.type == INPUT_MOUSE_SCROLL)
+		{
+			// movement speed dynamically -MK
+			g_pCamera->MovementSpeed += inputEvent.y * 0.5f; // Scroll up speeds up, scroll down slows down -MK
+
+			// speed to reasonable limits -MK
+			if (g_pCamera->MovementSpeed < 1.0f) g_pCamera->MovementSpeed = 1.0f;
+			if (g_pCamera->MovementSpeed > 10.0f) g_pCamera->MovementSpeed = 10.0f;
+		}
+		else if (inputEvent.type == INPUT_MOUSE_BUTTON)
+		{
+			// a left click picks the object under the cursor, with the
+			// point kept relative to the window size
+			int windowWidth = 0;
+			int windowHeight = 0;
+			glfwGetWindowSize(m_pWindow, &windowWidth, &windowHeight);
+			if ((inputEvent.key == GLFW_MOUSE_BUTTON_LEFT) && (inputEvent.action == GLFW_PRESS) &&
+				(windowWidth > 0) && (windowHeight > 0))
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_stateMutex);
+					m_bPickRequested = true;
+					m_pickPoint = glm::vec2(
+						inputEvent.x / windowWidth,
+						1.0 - inputEvent.y / windowHeight);
+				}
+				MarkViewChanged();
+			}
+		}
+		else if (inputEvent.type == INPUT_WINDOW_REFRESH)
+		{
+			MarkViewChanged();
+		}
+		else if (inputEvent.type == INPUT_FRAMEBUFFER_SIZE)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				m_framebufferWidth = (int)inputEvent.x;
+				m_framebufferHeight = (int)inputEvent.y;
+			}
+			MarkViewChanged();
+		}
+	}
+
+	// the queue keeps its capacity for the next events
+	gInputEvents.clear();
 }
 
 /***********************************************************
- *  ProcessKeyboardEvents()
+ *  ProcessKeyEvent()
  *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  This method is called to process a key being pressed or
+ *  released.  Movement keys are applied by each simulation
+ *  step while they are held, and the other keys act once
+ *  when they are pressed.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::ProcessKeyEvent(int key, int action)
 {
+	m_bKeyHeld[key] = (action == GLFW_PRESS);
+	if (action != GLFW_PRESS)
+	{
+		return;
+	}
+
 	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if (key == GLFW_KEY_ESCAPE)
 	{
 		glfwSetWindowShouldClose(m_pWindow, true);
 	}
 
-	// if the camera object is null, then exit this method -MK
-	if (NULL == g_pCamera)
+	// allow user to change view using P and O keys -MK
+	// press P for Perspective view
+	if (key == GLFW_KEY_P)
+	{
+		bOrthographicProjection = false;
+	}
+	// press O for Orthographic view
+	if (key == GLFW_KEY_O)
+	{
+		bOrthographicProjection = true;
+	}
+
+	// the remaining keys toggle the rendering options
+	if (NULL == m_pRenderSettings)
 	{
 		return;
 	}
 
+	// press Z to toggle the depth pre-pass
+	if (key == GLFW_KEY_Z)
+	{
+		m_pRenderSettings->bDepthPrepass = !m_pRenderSettings->bDepthPrepass;
+		std::cout << "INFO: Depth pre-pass " << (m_pRenderSettings->bDepthPrepass ? "on" : "off") << std::endl;
+	}
+	// press X to toggle the overdraw view
+	if (key == GLFW_KEY_X)
+	{
+		m_pRenderSettings->bShowOverdraw = !m_pRenderSettings->bShowOverdraw;
+		std::cout << "INFO: Overdraw view " << (m_pRenderSettings->bShowOverdraw ? "on" : "off") << std::endl;
+	}
+	// press V to switch between the camera view and the editor views
+	if (key == GLFW_KEY_V)
+	{
+		m_pRenderSettings->bMultiViewport = !m_pRenderSettings->bMultiViewport;
+		std::cout << "INFO: Editor views " << (m_pRenderSettings->bMultiViewport ? "on" : "off") << std::endl;
+	}
+	// press T, B and F to toggle tone mapping, bloom and FXAA
+	if (key == GLFW_KEY_T)
+	{
+		m_pRenderSettings->bToneMapping = !m_pRenderSettings->bToneMapping;
+		std::cout << "INFO: Tone mapping " << (m_pRenderSettings->bToneMapping ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_B)
+	{
+		m_pRenderSettings->bBloom = !m_pRenderSettings->bBloom;
+		std::cout << "INFO: Bloom " << (m_pRenderSettings->bBloom ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F)
+	{
+		m_pRenderSettings->bFXAA = !m_pRenderSettings->bFXAA;
+		std::cout << "INFO: FXAA " << (m_pRenderSettings->bFXAA ? "on" : "off") << std::endl;
+	}
+	// press M to step through the anti-aliasing modes
+	if (key == GLFW_KEY_M)
+	{
+		static const char* const modeNames[AA_MODE_COUNT] = { "off", "MSAA 2x", "MSAA 4x", "MSAA 8x", "TAA" };
+		m_pRenderSettings->antiAliasingMode = (m_pRenderSettings->antiAliasingMode + 1) % AA_MODE_COUNT;
+		std::cout << "INFO: Anti-aliasing " << modeNames[m_pRenderSettings->antiAliasingMode] << std::endl;
+	}
+	// press [ and ] to lower and raise the render scale
+	if ((key == GLFW_KEY_LEFT_BRACKET) || (key == GLFW_KEY_RIGHT_BRACKET))
+	{
+		float step = (key == GLFW_KEY_LEFT_BRACKET) ? -RENDER_SCALE_STEP : RENDER_SCALE_STEP;
+		m_pRenderSettings->renderScale = glm::clamp(m_pRenderSettings->renderScale + step, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+		std::cout << "INFO: Render scale " << (int)(m_pRenderSettings->renderScale * 100.0f + 0.5f) << "%" << std::endl;
+	}
+	// press G to switch between GPU and CPU object picking
+	if (key == GLFW_KEY_G)
+	{
+		m_pRenderSettings->bGPUPicking = !m_pRenderSettings->bGPUPicking;
+		std::cout << "INFO: Object picking on the " << (m_pRenderSettings->bGPUPicking ? "GPU" : "CPU") << std::endl;
+	}
+	// press C to switch between GPU and CPU culling
+	if (key == GLFW_KEY_C)
+	{
+		m_pRenderSettings->bGPUCulling = !m_pRenderSettings->bGPUCulling;
+		std::cout << "INFO: Culling on the " << (m_pRenderSettings->bGPUCulling ? "GPU" : "CPU") << std::endl;
+	}
+	// press H to toggle occlusion culling against the depth of
+	// the previous frame, which needs GPU culling
+	if (key == GLFW_KEY_H)
+	{
+		m_pRenderSettings->bOcclusionCulling = !m_pRenderSettings->bOcclusionCulling;
+		std::cout << "INFO: Occlusion culling " << (m_pRenderSettings->bOcclusionCulling ? "on" : "off") << std::endl;
+	}
+	// press K to toggle drawing the static objects in batches
+	if (key == GLFW_KEY_K)
+	{
+		m_pRenderSettings->bStaticBatching = !m_pRenderSettings->bStaticBatching;
+		std::cout << "INFO: Static batching " << (m_pRenderSettings->bStaticBatching ? "on" : "off") << std::endl;
+	}
+	// press L to toggle the baked lighting of the static batches
+	if (key == GLFW_KEY_L)
+	{
+		m_pRenderSettings->bBakedLighting = !m_pRenderSettings->bBakedLighting;
+		std::cout << "INFO: Baked lighting " << (m_pRenderSettings->bBakedLighting ? "on" : "off") << std::endl;
+	}
+	// press U to switch between the software rasterizer and OpenGL
+	if (key == GLFW_KEY_U)
+	{
+		m_pRenderSettings->bSoftwareRasterizer = !m_pRenderSettings->bSoftwareRasterizer;
+		std::cout << "INFO: Software rasterizer " << (m_pRenderSettings->bSoftwareRasterizer ? "on" : "off") << std::endl;
+	}
+	// press J to switch between the Vulkan renderer and OpenGL
+	if (key == GLFW_KEY_J)
+	{
+		m_pRenderSettings->bVulkanBackend = !m_pRenderSettings->bVulkanBackend;
+		std::cout << "INFO: Vulkan renderer " << (m_pRenderSettings->bVulkanBackend ? "on" : "off") << std::endl;
+	}
+	// press N to switch between deferred and forward shading
+	if (key == GLFW_KEY_N)
+	{
+		m_pRenderSettings->bDeferredShading = !m_pRenderSettings->bDeferredShading;
+		std::cout << "INFO: Deferred shading " << (m_pRenderSettings->bDeferredShading ? "on" : "off") << std::endl;
+	}
+	// press I to switch the reflections of the glossy objects
+	if (key == GLFW_KEY_I)
+	{
+		m_pRenderSettings->bReflectionProbes = !m_pRenderSettings->bReflectionProbes;
+		std::cout << "INFO: Reflection probes " << (m_pRenderSettings->bReflectionProbes ? "on" : "off") << std::endl;
+	}
+	// press Y to show or hide the heads-up display
+	if (key == GLFW_KEY_Y)
+	{
+		m_pRenderSettings->bShowHud = !m_pRenderSettings->bShowHud;
+		std::cout << "INFO: Heads-up display " << (m_pRenderSettings->bShowHud ? "on" : "off") << std::endl;
+	}
+	// press SPACE to pause or play the animations
+	if (key == GLFW_KEY_SPACE)
+	{
+		m_pRenderSettings->bAnimation = !m_pRenderSettings->bAnimation;
+		std::cout << "INFO: Animation " << (m_pRenderSettings->bAnimation ? "on" : "off") << std::endl;
+	}
+	// press R to switch between drawing on change and every frame
+	if (key == GLFW_KEY_R)
+	{
+		m_pRenderSettings->bRenderOnChange = !m_pRenderSettings->bRenderOnChange;
+		std::cout << "INFO: Render on change " << (m_pRenderSettings->bRenderOnChange ? "on" : "off") << std::endl;
+	}
+
+	// the frame shows the new options once it is drawn again
+	if ((key == GLFW_KEY_Z) || (key == GLFW_KEY_X) || (key == GLFW_KEY_R) || (key == GLFW_KEY_V) ||
+		(key == GLFW_KEY_T) || (key == GLFW_KEY_B) || (key == GLFW_KEY_F) || (key == GLFW_KEY_M) ||
+		(key == GLFW_KEY_LEFT_BRACKET) || (key == GLFW_KEY_RIGHT_BRACKET) || (key == GLFW_KEY_C) ||
+		(key == GLFW_KEY_H) || (key == GLFW_KEY_K) || (key == GLFW_KEY_U) || (key == GLFW_KEY_L) ||
+		(key == GLFW_KEY_N) || (key == GLFW_KEY_I) || (key == GLFW_KEY_Y) || (key == GLFW_KEY_SPACE))
+	{
+		MarkViewChanged();
+	}
+}
+
+/***********************************************************
+ *  StepCamera()
+ *
+ *  This method is called to move the camera by one fixed
+ *  simulation step for each movement key that is held.
+ ***********************************************************/
+void ViewManager::StepCamera(float deltaTime)
+{
 	// process camera zooming in and out -MK
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_W])
 	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(FORWARD, deltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_S])
 	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(BACKWARD, deltaTime);
 	}
 
 	// process camera panning left and right -MK
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_A])
 	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(LEFT, deltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_D])
 	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(RIGHT, deltaTime);
 	}
 
 	// upward and downward movement using Q and E - MK
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_Q])
 	{
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+		g_pCamera->ProcessKeyboard(UP, deltaTime);
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	if (m_bKeyHeld[GLFW_KEY_E])
 	{
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+		g_pCamera->ProcessKeyboard(DOWN, deltaTime);
 	}
+}
+
+/***********************************************************
+ *  IsMovementKeyHeld()
+ *
+ *  This method is used for checking whether any of the
+ *  camera movement keys is held down.
+ ***********************************************************/
+bool ViewManager::IsMovementKeyHeld() const
+{
+	return(m_bKeyHeld[GLFW_KEY_W] || m_bKeyHeld[GLFW_KEY_S] ||
+		m_bKeyHeld[GLFW_KEY_A] || m_bKeyHeld[GLFW_KEY_D] ||
+		m_bKeyHeld[GLFW_KEY_Q] || m_bKeyHeld[GLFW_KEY_E]);
+}
+
+/***********************************************************
+ *  PublishCameraState()
+ *
+ *  This method is used for publishing the camera values of
+ *  the latest simulation step, so that the render thread
+ *  can interpolate between the last two steps.  The render
+ *  thread is woken when the step moved the camera.
+ ***********************************************************/
+void ViewManager::PublishCameraState()
+{
+	CAMERA_STATE state;
+	bool bChanged = false;
+
+	state.position = g_pCamera->Position;
+	state.front = g_pCamera->Front;
+	state.up = g_pCamera->Up;
+	state.zoom = g_pCamera->Zoom;
+	state.movementSpeed = g_pCamera->MovementSpeed;
+	state.bOrthographic = bOrthographicProjection;
+	state.tickTime = m_simulationTime;
 
-	// allow user to change view using P and O keys -MK
-	// press P for Perspective view
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
 	{
-		bOrthographicProjection = false;
+		std::lock_guard<std::mutex> lock(m_stateMutex);
+		bChanged = (state.position != m_currentState.position) ||
+			(state.front != m_currentState.front) ||
+			(state.up != m_currentState.up) ||
+			(state.zoom != m_currentState.zoom) ||
+			(state.bOrthographic != m_currentState.bOrthographic);
+		m_previousState = m_currentState;
+		m_currentState = state;
+		if ((m_unpublishedInputTime != 0.0) && (m_pendingInputTime == 0.0))
+		{
+			m_pendingInputTime = m_unpublishedInputTime;
+		}
+		m_unpublishedInputTime = 0.0;
+		if (bChanged)
+		{
+			m_changeVersion++;
+		}
 	}
-	// press O for Orthographic view
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+
+	if (bChanged)
 	{
-		bOrthographicProjection = true;
+		m_viewChanged.notify_one();
+	}
+}
+
+/***********************************************************
+ *  MarkViewChanged()
+ *
+ *  This method is used for recording that the view needs to
+ *  be drawn again even though the camera has not moved,
+ *  such as when a rendering option was toggled.
+ ***********************************************************/
+void ViewManager::MarkViewChanged()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_stateMutex);
+		m_changeVersion++;
+	}
+	m_viewChanged.notify_one();
+}
+
+/***********************************************************
+ *  HasViewChanged()
+ *
+ *  This method is used by the render thread for checking
+ *  whether the view has changed since the last frame, or
+ *  the last frame was still blending between two steps.
+ ***********************************************************/
+bool ViewManager::HasViewChanged()
+{
+	std::lock_guard<std::mutex> lock(m_stateMutex);
+
+	return((m_changeVersion != m_renderedVersion) || m_bInterpolating);
+}
+
+/***********************************************************
+ *  WaitForViewChange()
+ *
+ *  This method is used by the render thread for sleeping
+ *  until the view changes, or until the timeout in seconds
+ *  has passed.
+ ***********************************************************/
+void ViewManager::WaitForViewChange(double timeout)
+{
+	std::unique_lock<std::mutex> lock(m_stateMutex);
+
+	m_viewChanged.wait_for(
+		lock,
+		std::chrono::duration<double>(timeout),
+		[this]() { return(m_changeVersion != m_renderedVersion); });
+}
+
+/***********************************************************
+ *  WakeRenderThread()
+ *
+ *  This method is used for waking the render thread when it
+ *  is waiting for a view change, such as when the window
+ *  is being closed.
+ ***********************************************************/
+void ViewManager::WakeRenderThread()
+{
+	MarkViewChanged();
+}
+
+/***********************************************************
+ *  UpdateSimulation()
+ *
+ *  This method is called from the main thread after the
+ *  window events have been received.  The queued input is
+ *  applied and the camera is stepped in fixed increments
+ *  up to the current time.
+ ***********************************************************/
+void ViewManager::UpdateSimulation()
+{
+	double currentTime = glfwGetTime();
+
+	// process any input events that may be waiting in the
+	// event queue
+	ProcessInputEvents();
+
+	// after the camera has been idle, the idle time is not replayed
+	if (currentTime - m_simulationTime > MAX_SIMULATION_CATCHUP)
+	{
+		m_simulationTime = currentTime - SIMULATION_TICK;
+	}
+
+	while (m_simulationTime + SIMULATION_TICK <= currentTime)
+	{
+		StepCamera((float)SIMULATION_TICK);
+		m_simulationTime += SIMULATION_TICK;
+		PublishCameraState();
+	}
+}
+
+/***********************************************************
+ *  GetSimulationWaitTime()
+ *
+ *  This method is used for getting how long the main thread
+ *  can wait for window events before the simulation needs
+ *  to take its next step.
+ ***********************************************************/
+double ViewManager::GetSimulationWaitTime() const
+{
+	// nothing changes until the next input event arrives
+	if ((false == IsMovementKeyHeld()) && (m_unpublishedInputTime == 0.0))
+	{
+		return(IDLE_WAIT_TIME);
+	}
+
+	double waitTime = m_simulationTime + SIMULATION_TICK - glfwGetTime();
+	if (waitTime < 0.0)
+	{
+		waitTime = 0.0;
+	}
+
+	return(waitTime);
+}
+
+/***********************************************************
+ *  OnFramePresented()
+ *
+ *  This method is called from the render thread after the
+ *  frame has been swapped to the display.  The time from
+ *  the first input shown in the frame until the swap is
+ *  recorded as the input-to-photon latency.
+ ***********************************************************/
+void ViewManager::OnFramePresented()
+{
+	double currentTime = glfwGetTime();
+
+	if (m_frameInputTime != 0.0)
+	{
+		double latency = currentTime - m_frameInputTime;
+		m_latencyTotal += latency;
+		if (latency > m_latencyMax)
+		{
+			m_latencyMax = latency;
+		}
+		m_latencyCount++;
+		m_frameInputTime = 0.0;
+	}
+
+	if ((m_latencyCount > 0) && (currentTime - m_lastLatencyReportTime >= LATENCY_REPORT_INTERVAL))
+	{
+		std::cout << "INFO: Input-to-photon latency average " << (m_latencyTotal / m_latencyCount) * 1000.0
+			<< " ms, max " << m_latencyMax * 1000.0 << " ms over " << m_latencyCount << " frames" << std::endl;
+		m_latencyTotal = 0.0;
+		m_latencyMax = 0.0;
+		m_latencyCount = 0;
+		m_lastLatencyReportTime = currentTime;
 	}
 }
 
@@ -236,44 +851,191 @@ void ViewManager::ProcessKeyboardEvents()
  *
  *  This method is used for preparing the 3D scene by loading
  *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  rendering.  It is called from the render thread, and the
+ *  camera values are interpolated between the last two
+ *  simulation steps for the current time.  The viewports
+ *  are laid out in the target the scene is drawn into, and
+ *  the projections are moved by the jitter in pixels.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::PrepareSceneView(int targetWidth, int targetHeight, glm::vec2 jitter)
 {
 	glm::mat4 view;
 	glm::mat4 projection;
+	CAMERA_STATE previousState;
+	CAMERA_STATE currentState;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	// take the latest simulation steps and any input they show
+	{
+		std::lock_guard<std::mutex> lock(m_stateMutex);
+		previousState = m_previousState;
+		currentState = m_currentState;
+		m_renderedVersion = m_changeVersion;
+		if ((m_pendingInputTime != 0.0) && (m_frameInputTime == 0.0))
+		{
+			m_frameInputTime = m_pendingInputTime;
+		}
+		m_pendingInputTime = 0.0;
+	}
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	// a fixed camera replaces the simulation steps
+	if (m_bFixedCamera)
+	{
+		previousState = m_fixedState;
+		currentState = m_fixedState;
+	}
+
+	// blend from the previous step to the current step over the
+	// length of one step, which keeps the motion smooth when the
+	// frame rate and the simulation rate differ
+	float blend = (float)((glfwGetTime() - currentState.tickTime) / SIMULATION_TICK);
+	blend = glm::clamp(blend, 0.0f, 1.0f);
+	m_renderState = currentState;
+	m_renderState.position = glm::mix(previousState.position, currentState.position, blend);
+	m_renderState.front = glm::normalize(glm::mix(previousState.front, currentState.front, blend));
+	m_renderState.zoom = glm::mix(previousState.zoom, currentState.zoom, blend);
 
-	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	// the view keeps changing until the blend reaches the current step
+	bool bStepsDiffer = (previousState.position != currentState.position) ||
+		(previousState.front != currentState.front) ||
+		(previousState.zoom != currentState.zoom);
+	m_bInterpolating = bStepsDiffer && (blend < 1.0f);
+
+	// get the current view matrix from the camera values
+	view = glm::lookAt(
+		m_renderState.position,
+		m_renderState.position + m_renderState.front,
+		m_renderState.up);
+
+	// the camera view fills the window, or the top left quarter
+	// of it when the editor views are shown
+	bool bEditorViews = (NULL != m_pRenderSettings) && m_pRenderSettings->bMultiViewport;
+	int viewWidth = std::max(bEditorViews ? targetWidth / 2 : targetWidth, 1);
+	int viewHeight = std::max(bEditorViews ? targetHeight / 2 : targetHeight, 1);
+	float aspectRatio = (GLfloat)viewWidth / (GLfloat)viewHeight;
 
 	// set the view based on the current mode -MK
-	if (bOrthographicProjection)
+	if (m_renderState.bOrthographic)
 	{
 		// orthographic view of the 3D scene -MK
-		projection = glm::ortho(-15.0f, 15.0f, -15.0f, 15.0f, 0.1f, 100.0f); // set scale and position of view -MK
+		projection = glm::ortho(-15.0f * aspectRatio, 15.0f * aspectRatio, -15.0f, 15.0f, 0.1f, 100.0f); // set scale and position of view -MK
 	}
 	else {
 		// define the current projection matrix
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+		projection = glm::perspective(glm::radians(m_renderState.zoom), aspectRatio, 0.1f, 100.0f);
 	}
+	projection = JitterProjection(projection, jitter, viewWidth, viewHeight);
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// keep the view values for the scene manager render passes,
+	// which set them into the shaders for each viewport
+	m_sceneViews[0].view = view;
+	m_sceneViews[0].projection = projection;
+	m_sceneViews[0].viewPosition = m_renderState.position;
+	m_sceneViews[0].x = 0;
+	m_sceneViews[0].y = targetHeight - viewHeight;
+	m_sceneViews[0].width = viewWidth;
+	m_sceneViews[0].height = viewHeight;
+	m_sceneViewCount = 1;
+
+	if (bEditorViews)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		AddEditorViews(viewWidth, viewHeight, jitter);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the size of the window
+ *  framebuffer, as last reported to the main thread.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height)
+{
+	std::lock_guard<std::mutex> lock(m_stateMutex);
+	width = m_framebufferWidth;
+	height = m_framebufferHeight;
+}
+
+/***********************************************************
+ *  SetFixedCamera()
+ *
+ *  This method is used by the render thread for holding
+ *  the camera at fixed values, such as the poses that the
+ *  regression run is drawn from.  The simulation keeps
+ *  running, but its steps are not shown until the camera
+ *  is released with NULL.
+ ***********************************************************/
+void ViewManager::SetFixedCamera(const CAMERA_STATE* pState)
+{
+	m_bFixedCamera = (NULL != pState);
+	if (m_bFixedCamera)
+	{
+		m_fixedState = *pState;
+	}
+}
+
+/***********************************************************
+ *  TakePickRequest()
+ *
+ *  This method is used by the render thread for taking the
+ *  point of the last click, so that each click is picked
+ *  once.
+ ***********************************************************/
+bool ViewManager::TakePickRequest(glm::vec2& point)
+{
+	std::lock_guard<std::mutex> lock(m_stateMutex);
+
+	if (false == m_bPickRequested)
+	{
+		return(false);
+	}
+
+	point = m_pickPoint;
+	m_bPickRequested = false;
+	return(true);
+}
+
+/***********************************************************
+ *  AddEditorViews()
+ *
+ *  This method is used for adding the orthographic top,
+ *  front and side views of the scene after the camera view.
+ *  The top view is in the top right quarter of the window,
+ *  and the front and side views are below the camera view
+ *  and the top view.
+ ***********************************************************/
+void ViewManager::AddEditorViews(int viewWidth, int viewHeight, glm::vec2 jitter)
+{
+	// direction each view looks from, its up direction, and
+	// the corner of the window that it covers
+	const glm::vec3 directions[3] = {
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, 0.0f) };
+	const glm::vec3 upDirections[3] = {
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f) };
+	const int corners[3][2] = {
+		{ viewWidth, viewHeight },
+		{ 0, 0 },
+		{ viewWidth, 0 } };
+
+	// the views keep the shape of the scene when the quarters
+	// of the window are not square
+	float extentY = EDITOR_VIEW_EXTENT;
+	float extentX = EDITOR_VIEW_EXTENT * (float)viewWidth / (float)viewHeight;
+	glm::mat4 projection = glm::ortho(-extentX, extentX, -extentY, extentY, 0.1f, EDITOR_VIEW_DISTANCE * 2.0f);
+	projection = JitterProjection(projection, jitter, viewWidth, viewHeight);
+
+	for (int i = 0; i < 3; i++)
+	{
+		SCENE_VIEW& sceneView = m_sceneViews[m_sceneViewCount++];
+		sceneView.viewPosition = EDITOR_VIEW_TARGET + directions[i] * EDITOR_VIEW_DISTANCE;
+		sceneView.view = glm::lookAt(sceneView.viewPosition, EDITOR_VIEW_TARGET, upDirections[i]);
+		sceneView.projection = projection;
+		sceneView.x = corners[i][0];
+		sceneView.y = corners[i][1];
+		sceneView.width = viewWidth;
+		sceneView.height = viewHeight;
+	}
+}
@@ -10,10 +10,15 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "RenderSettings.h"
+#include "SceneView.h"
 #include "camera.h"
 
 // GLFW library
-#include "GLFW/glfw3.h" 
+#include "GLFW/glfw3.h"
+
+#include <condition_variable>
+#include <mutex>
 
 class ViewManager
 {
@@ -24,10 +29,54 @@ public:
 	// destructor
 	~ViewManager();
 
+	// the kinds of input events received from GLFW
+	enum INPUT_EVENT_TYPE
+	{
+		INPUT_KEY,
+		INPUT_MOUSE_POSITION,
+		INPUT_MOUSE_SCROLL,
+		INPUT_MOUSE_BUTTON,
+		INPUT_WINDOW_REFRESH,
+		INPUT_FRAMEBUFFER_SIZE
+	};
+
+	// an input event queued by the GLFW callbacks
+	struct INPUT_EVENT
+	{
+		INPUT_EVENT_TYPE type;
+		int key;
+		int action;
+		double x;
+		double y;
+		// time the event was received, for measuring latency
+		double time;
+	};
+
+	// the camera values published by each simulation step
+	struct CAMERA_STATE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float zoom;
+		float movementSpeed;
+		bool bOrthographic;
+		// simulation time of the step that produced the values
+		double tickTime;
+	};
+
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 	// declare scroll callback to adjust movement speed -MK
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
+	// mouse button callback for picking objects in the 3D scene
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+	// keyboard callback for interaction with the 3D scene
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	// window refresh callback for redrawing a damaged window
+	static void Window_Refresh_Callback(GLFWwindow* window);
+	// framebuffer size callback for following the window size
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 
 private:
@@ -35,14 +84,117 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// rendering options toggled from the keyboard
+	RENDER_SETTINGS* m_pRenderSettings;
+	// viewports drawn in the current frame, where the first
+	// one is always the camera view
+	SCENE_VIEW m_sceneViews[MAX_SCENE_VIEWS];
+	int m_sceneViewCount;
+
+	// the following members are only used by the simulation
+
+	// time that the simulation has been stepped up to
+	double m_simulationTime;
+	// the keys that are currently held down
+	bool m_bKeyHeld[GLFW_KEY_LAST + 1];
+	// time of the first input applied since the last published step
+	double m_unpublishedInputTime;
+
+	// the following members are shared with the render thread
+
+	// protects the published camera states
+	std::mutex m_stateMutex;
+	// signaled when the view needs to be drawn again
+	std::condition_variable m_viewChanged;
+	// counts the changes to the camera, projection and options
+	unsigned int m_changeVersion;
+	// the two most recent simulation steps, for interpolation
+	CAMERA_STATE m_previousState;
+	CAMERA_STATE m_currentState;
+	// time of the first input that has not been rendered yet
+	double m_pendingInputTime;
+	// size of the window framebuffer in pixels
+	int m_framebufferWidth;
+	int m_framebufferHeight;
+	// a click that has not been picked yet, as a point of the
+	// window from 0 to 1 with the origin at the bottom left
+	bool m_bPickRequested;
+	glm::vec2 m_pickPoint;
 
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
+	// the following members are only used by the render thread
+
+	// camera values used for the current frame
+	CAMERA_STATE m_renderState;
+	// camera values that replace the simulation steps when set
+	bool m_bFixedCamera;
+	CAMERA_STATE m_fixedState;
+	// the change count shown by the current frame
+	unsigned int m_renderedVersion;
+	// true while the frame is still blending between two steps
+	bool m_bInterpolating;
+	// time of the first input shown by the current frame
+	double m_frameInputTime;
+	// input-to-photon latency measurements since the last report
+	double m_latencyTotal;
+	double m_latencyMax;
+	int m_latencyCount;
+	double m_lastLatencyReportTime;
+
+	// process the queued input events for interaction with the 3D scene
+	void ProcessInputEvents();
+	// process a key being pressed or released
+	void ProcessKeyEvent(int key, int action);
+	// move the camera by one simulation step
+	void StepCamera(float deltaTime);
+	// publish the camera values for the render thread
+	void PublishCameraState();
+	// record that the view needs to be drawn again
+	void MarkViewChanged();
+	// check whether any camera movement key is held down
+	bool IsMovementKeyHeld() const;
+	// add the top, front and side views of the scene
+	void AddEditorViews(int viewWidth, int viewHeight, glm::vec2 jitter);
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
-};
\ No newline at end of file
+
+	// prepare the conversion from 3D object display to 2D scene
+	// display, for a target size and a sub-pixel jitter offset
+	void PrepareSceneView(int targetWidth, int targetHeight, glm::vec2 jitter);
+	// get the size of the window framebuffer in pixels
+	void GetFramebufferSize(int& width, int& height);
+	// hold the camera at fixed values instead of following the
+	// simulation, or follow it again for NULL
+	void SetFixedCamera(const CAMERA_STATE* pState);
+	// take the point of the last click to pick an object at -
+	// returns false if there has been no click since
+	bool TakePickRequest(glm::vec2& point);
+
+	// run the camera simulation up to the current time
+	void UpdateSimulation();
+	// get how long the event loop can wait before the next step
+	double GetSimulationWaitTime() const;
+	// record the latency of the input shown by the presented frame
+	void OnFramePresented();
+
+	// check whether the view has changed since the last frame
+	bool HasViewChanged();
+	// wait until the view changes or the timeout in seconds passes
+	void WaitForViewChange(double timeout);
+	// wake the render thread, such as when the window is closing
+	void WakeRenderThread();
+
+	// set the rendering options that can be toggled from the keyboard
+	void SetRenderSettings(RENDER_SETTINGS* pRenderSettings);
+
+	// get the view values of the camera for the current frame
+	glm::mat4 GetViewMatrix() const { return m_sceneViews[0].view; }
+	glm::mat4 GetProjectionMatrix() const { return m_sceneViews[0].projection; }
+	glm::vec3 GetViewPosition() const { return m_renderState.position; }
+	// get the camera values that the current frame is drawn with
+	const CAMERA_STATE& GetRenderState() const { return m_renderState; }
+	// get the viewports drawn in the current frame
+	const SCENE_VIEW* GetSceneViews() const { return m_sceneViews; }
+	int GetSceneViewCount() const { return m_sceneViewCount; }
+};
@@ -0,0 +1,1365 @@
+///////////////////////////////////////////////////////////////////////////////
+// vulkanrenderer.cpp
+// ============
+// draw the scene with Vulkan into an offscreen frame, recording the
+// draws on several threads at once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VulkanRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// the pipelines that are built when the renderer starts, for
+	// each combination of textured and blended surfaces
+	const int PIPELINE_BLENDED = 1;
+	const int PIPELINE_TEXTURED = 2;
+	const int PIPELINE_COUNT = 4;
+}
+
+#ifdef HAVE_VULKAN
+#include <shaderc/shaderc.h>
+#include <vulkan/vulkan.h>
+
+namespace
+{
+	// floats in each vertex, for its position, normal and texture
+	// coordinates
+	const int VERTEX_FLOATS = 8;
+	const VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+	const VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+	// vertex shader that transforms the mesh with the model matrix
+	// of the draw, and moves the depth from the OpenGL range into
+	// the Vulkan one - the rows are not flipped, so the frame comes
+	// out bottom row first as OpenGL has it
+	const char* g_VertexShader =
+		"#version 450\n"
+		"layout(location = 0) in vec3 position;\n"
+		"layout(location = 1) in vec3 normal;\n"
+		"layout(location = 2) in vec2 textureCoordinate;\n"
+		"layout(location = 0) out vec3 fragmentPosition;\n"
+		"layout(location = 1) out vec3 fragmentNormal;\n"
+		"layout(location = 2) out vec2 fragmentUV;\n"
+		"layout(set = 0, binding = 0) uniform FrameValues\n"
+		"{\n"
+		"	mat4 viewProjection;\n"
+		"	vec4 viewPosition;\n"
+		"	vec4 lightPosition[4];\n"
+		"	vec4 lightAmbient[4];\n"
+		"	vec4 lightDiffuse[4];\n"
+		"	vec4 lightSpecular[4];\n"
+		"} frame;\n"
+		"layout(push_constant) uniform DrawValues\n"
+		"{\n"
+		"	mat4 model;\n"
+		"	vec4 color;\n"
+		"	vec4 ambient;\n"
+		"	vec4 diffuse;\n"
+		"	vec4 specular;\n"
+		"} draw;\n"
+		"void main()\n"
+		"{\n"
+		"	vec4 worldPosition = draw.model * vec4(position, 1.0f);\n"
+		"	fragmentPosition = worldPosition.xyz;\n"
+		"	fragmentNormal = transpose(inverse(mat3(draw.model))) * normal;\n"
+		"	fragmentUV = textureCoordinate;\n"
+		"	gl_Position = frame.viewProjection * worldPosition;\n"
+		"	gl_Position.z = (gl_Position.z + gl_Position.w) * 0.5f;\n"
+		"}\n";
+
+	// fragment shader with the lighting of the scene shader, where
+	// the textured pipelines read the texture of the draw from the
+	// array of scene textures
+	const char* g_FragmentShader =
+		"#version 450\n"
+		"#extension GL_EXT_nonuniform_qualifier : require\n"
+		"layout(constant_id = 0) const bool bTextured = false;\n"
+		"layout(location = 0) in vec3 fragmentPosition;\n"
+		"layout(location = 1) in vec3 fragmentNormal;\n"
+		"layout(location = 2) in vec2 fragmentUV;\n"
+		"layout(location = 0) out vec4 outColor;\n"
+		"layout(set = 0, binding = 0) uniform FrameValues\n"
+		"{\n"
+		"	mat4 viewProjection;\n"
+		"	vec4 viewPosition;\n"
+		"	vec4 lightPosition[4];\n"
+		"	vec4 lightAmbient[4];\n"
+		"	vec4 lightDiffuse[4];\n"
+		"	vec4 lightSpecular[4];\n"
+		"} frame;\n"
+		"layout(set = 0, binding = 1) uniform sampler2D textures[16];\n"
+		"layout(push_constant) uniform DrawValues\n"
+		"{\n"
+		"	mat4 model;\n"
+		"	vec4 color;\n"
+		"	vec4 ambient;\n"
+		"	vec4 diffuse;\n"
+		"	vec4 specular;\n"
+		"} draw;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 normal = normalize(fragmentNormal);\n"
+		"	vec3 viewDirection = normalize(frame.viewPosition.xyz - fragmentPosition);\n"
+		"	vec3 lighting = vec3(0.0f);\n"
+		"	for (int i = 0; i < 4; i++)\n"
+		"	{\n"
+		"		lighting += frame.lightAmbient[i].rgb * draw.ambient.rgb;\n"
+		"		vec3 lightDirection = normalize(frame.lightPosition[i].xyz - fragmentPosition);\n"
+		"		float normalDotLight = dot(normal, lightDirection);\n"
+		"		vec3 reflection = 2.0f * normalDotLight * normal - lightDirection;\n"
+		"		float highlight = pow(max(dot(viewDirection, reflection), 0.0f), frame.lightSpecular[i].w);\n"
+		"		lighting += max(normalDotLight, 0.0f) * frame.lightDiffuse[i].rgb * draw.diffuse.rgb;\n"
+		"		lighting += highlight * frame.lightSpecular[i].rgb * draw.specular.rgb;\n"
+		"	}\n"
+		"	if (bTextured)\n"
+		"	{\n"
+		"		int slot = int(draw.diffuse.w);\n"
+		"		outColor = vec4(lighting * texture(textures[nonuniformEXT(slot)], fragmentUV).rgb, 1.0f);\n"
+		"	}\n"
+		"	else\n"
+		"	{\n"
+		"		outColor = vec4(lighting * draw.color.rgb, draw.color.a);\n"
+		"	}\n"
+		"	outColor = clamp(outColor, 0.0f, 1.0f);\n"
+		"}\n";
+
+	// the uniform buffer of a frame, in the layout of the shaders
+	struct FRAME_VALUES
+	{
+		glm::mat4 viewProjection;
+		glm::vec4 viewPosition;
+		glm::vec4 lightPosition[RenderBackend::MAX_LIGHTS];
+		glm::vec4 lightAmbient[RenderBackend::MAX_LIGHTS];
+		glm::vec4 lightDiffuse[RenderBackend::MAX_LIGHTS];
+		glm::vec4 lightSpecular[RenderBackend::MAX_LIGHTS];
+	};
+
+	// a buffer with its memory, mapped when the host writes or
+	// reads it
+	struct VULKAN_BUFFER
+	{
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		void* pMapped;
+	};
+
+	// an image with its memory and view
+	struct VULKAN_IMAGE
+	{
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+	};
+}
+
+/***********************************************************
+ *  VULKAN_DEVICE
+ *
+ *  The Vulkan objects of the renderer.  The frame buffer
+ *  objects are created again when the size of the frame
+ *  changes, and the meshes and textures when they are
+ *  uploaded after a reset.
+ ***********************************************************/
+struct VULKAN_DEVICE
+{
+	VkInstance instance;
+	VkPhysicalDevice physicalDevice;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDevice device;
+	uint32_t queueFamily;
+	VkQueue queue;
+
+	VkRenderPass renderPass;
+	VkDescriptorSetLayout setLayout;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipelines[PIPELINE_COUNT];
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSet descriptorSet;
+	VkSampler sampler;
+	VULKAN_BUFFER frameValues;
+
+	// the meshes in one vertex and one index buffer, and the
+	// textures of the slots
+	VULKAN_BUFFER vertexBuffer;
+	VULKAN_BUFFER indexBuffer;
+	VULKAN_IMAGE textures[VulkanRenderer::MAX_TEXTURES];
+
+	// the frame and the buffer it is copied back into
+	VULKAN_IMAGE colorImage;
+	VULKAN_IMAGE depthImage;
+	VkFramebuffer framebuffer;
+	VULKAN_BUFFER readbackBuffer;
+	int frameWidth;
+	int frameHeight;
+
+	// the command buffer of the calling thread, and the command
+	// pool and secondary command buffer of each thread
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+	VkFence fence;
+	std::vector<VkCommandPool> workerPools;
+	std::vector<VkCommandBuffer> workerBuffers;
+	std::vector<int> workerRecorded;
+};
+
+namespace
+{
+	/***********************************************************
+	 *  FindMemoryType()
+	 *
+	 *  This function is used for finding a memory type that
+	 *  a resource can use and that has the properties - it
+	 *  returns UINT32_MAX when there is none.
+	 ***********************************************************/
+	uint32_t FindMemoryType(const VULKAN_DEVICE& device, uint32_t typeBits, VkMemoryPropertyFlags properties)
+	{
+		for (uint32_t i = 0; i < device.memoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeBits & (1u << i)) &&
+				((device.memoryProperties.memoryTypes[i].propertyFlags & properties) == properties))
+			{
+				return i;
+			}
+		}
+		return UINT32_MAX;
+	}
+
+	/***********************************************************
+	 *  CreateBuffer()
+	 *
+	 *  This function is used for creating a buffer in memory
+	 *  that the host can map, which is kept mapped.  On the
+	 *  CPU devices this is the only kind of memory, and the
+	 *  meshes and frame values are small enough on the others.
+	 ***********************************************************/
+	bool CreateBuffer(const VULKAN_DEVICE& device, VkDeviceSize size, VkBufferUsageFlags usage, VULKAN_BUFFER& buffer)
+	{
+		buffer = VULKAN_BUFFER();
+
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = std::max<VkDeviceSize>(size, 4);
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (VK_SUCCESS != vkCreateBuffer(device.device, &bufferInfo, NULL, &buffer.buffer))
+		{
+			return false;
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device.device, buffer.buffer, &requirements);
+		VkMemoryAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocateInfo.allocationSize = requirements.size;
+		allocateInfo.memoryTypeIndex = FindMemoryType(device, requirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if ((UINT32_MAX == allocateInfo.memoryTypeIndex) ||
+			(VK_SUCCESS != vkAllocateMemory(device.device, &allocateInfo, NULL, &buffer.memory)) ||
+			(VK_SUCCESS != vkBindBufferMemory(device.device, buffer.buffer, buffer.memory, 0)) ||
+			(VK_SUCCESS != vkMapMemory(device.device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.pMapped)))
+		{
+			return false;
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  DestroyBuffer()
+	 *
+	 *  This function is used for freeing a buffer and its
+	 *  memory.
+	 ***********************************************************/
+	void DestroyBuffer(const VULKAN_DEVICE& device, VULKAN_BUFFER& buffer)
+	{
+		if (VK_NULL_HANDLE != buffer.buffer)
+		{
+			vkDestroyBuffer(device.device, buffer.buffer, NULL);
+		}
+		if (VK_NULL_HANDLE != buffer.memory)
+		{
+			vkFreeMemory(device.device, buffer.memory, NULL);
+		}
+		buffer = VULKAN_BUFFER();
+	}
+
+	/***********************************************************
+	 *  CreateImage()
+	 *
+	 *  This function is used for creating a 2D image in device
+	 *  memory with a view of all of its levels.
+	 ***********************************************************/
+	bool CreateImage(
+		const VULKAN_DEVICE& device,
+		VkFormat format,
+		int width,
+		int height,
+		uint32_t levelCount,
+		VkImageUsageFlags usage,
+		VkImageAspectFlags aspect,
+		VULKAN_IMAGE& image)
+	{
+		image = VULKAN_IMAGE();
+
+		VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = { (uint32_t)width, (uint32_t)height, 1 };
+		imageInfo.mipLevels = levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (VK_SUCCESS != vkCreateImage(device.device, &imageInfo, NULL, &image.image))
+		{
+			return false;
+		}
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(device.device, image.image, &requirements);
+		VkMemoryAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		allocateInfo.allocationSize = requirements.size;
+		allocateInfo.memoryTypeIndex = FindMemoryType(device, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (UINT32_MAX == allocateInfo.memoryTypeIndex)
+		{
+			allocateInfo.memoryTypeIndex = FindMemoryType(device, requirements.memoryTypeBits, 0);
+		}
+		if ((VK_SUCCESS != vkAllocateMemory(device.device, &allocateInfo, NULL, &image.memory)) ||
+			(VK_SUCCESS != vkBindImageMemory(device.device, image.image, image.memory, 0)))
+		{
+			return false;
+		}
+
+		VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = image.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = { aspect, 0, levelCount, 0, 1 };
+		return (VK_SUCCESS == vkCreateImageView(device.device, &viewInfo, NULL, &image.view));
+	}
+
+	/***********************************************************
+	 *  DestroyImage()
+	 *
+	 *  This function is used for freeing an image, its view
+	 *  and its memory.
+	 ***********************************************************/
+	void DestroyImage(const VULKAN_DEVICE& device, VULKAN_IMAGE& image)
+	{
+		if (VK_NULL_HANDLE != image.view)
+		{
+			vkDestroyImageView(device.device, image.view, NULL);
+		}
+		if (VK_NULL_HANDLE != image.image)
+		{
+			vkDestroyImage(device.device, image.image, NULL);
+		}
+		if (VK_NULL_HANDLE != image.memory)
+		{
+			vkFreeMemory(device.device, image.memory, NULL);
+		}
+		image = VULKAN_IMAGE();
+	}
+
+	/***********************************************************
+	 *  CompileShader()
+	 *
+	 *  This function is used for compiling GLSL source into a
+	 *  shader module - it returns a null handle and prints the
+	 *  log when the source does not compile.
+	 ***********************************************************/
+	VkShaderModule CompileShader(const VULKAN_DEVICE& device, const char* source, shaderc_shader_kind kind, const char* name)
+	{
+		shaderc_compiler_t compiler = shaderc_compiler_initialize();
+		shaderc_compile_options_t options = shaderc_compile_options_initialize();
+		shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance);
+		shaderc_compilation_result_t result = shaderc_compile_into_spv(
+			compiler, source, strlen(source), kind, name, "main", options);
+
+		VkShaderModule module = VK_NULL_HANDLE;
+		if (shaderc_compilation_status_success == shaderc_result_get_compilation_status(result))
+		{
+			VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+			moduleInfo.codeSize = shaderc_result_get_length(result);
+			moduleInfo.pCode = (const uint32_t*)shaderc_result_get_bytes(result);
+			vkCreateShaderModule(device.device, &moduleInfo, NULL, &module);
+		}
+		else
+		{
+			std::cout << "ERROR: Vulkan shader " << name << " failed to compile:\n"
+				<< shaderc_result_get_error_message(result) << std::endl;
+		}
+
+		shaderc_result_release(result);
+		shaderc_compile_options_release(options);
+		shaderc_compiler_release(compiler);
+		return module;
+	}
+
+	/***********************************************************
+	 *  SelectPhysicalDevice()
+	 *
+	 *  This function is used for picking the device to draw
+	 *  with.  The devices must support version 1.2 and index
+	 *  arrays of textures, and GPUs are preferred over CPU
+	 *  devices, which are still used when nothing else is
+	 *  there.
+	 ***********************************************************/
+	VkPhysicalDevice SelectPhysicalDevice(VkInstance instance, uint32_t& queueFamily)
+	{
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance, &deviceCount, NULL);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+		VkPhysicalDevice bestDevice = VK_NULL_HANDLE;
+		int bestRank = -1;
+		for (uint32_t i = 0; i < deviceCount; i++)
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(devices[i], &properties);
+			VkPhysicalDeviceVulkan12Features features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+			VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+			features.pNext = &features12;
+			if (properties.apiVersion < VK_API_VERSION_1_2)
+			{
+				continue;
+			}
+			vkGetPhysicalDeviceFeatures2(devices[i], &features);
+			if ((VK_FALSE == features.features.shaderSampledImageArrayDynamicIndexing) ||
+				(VK_FALSE == features12.shaderSampledImageArrayNonUniformIndexing) ||
+				(VK_FALSE == features12.descriptorBindingPartiallyBound))
+			{
+				continue;
+			}
+
+			uint32_t familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, NULL);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, families.data());
+			uint32_t graphicsFamily = UINT32_MAX;
+			for (uint32_t j = 0; j < familyCount; j++)
+			{
+				if (families[j].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				{
+					graphicsFamily = j;
+					break;
+				}
+			}
+			if (UINT32_MAX == graphicsFamily)
+			{
+				continue;
+			}
+
+			int rank = 0;
+			switch (properties.deviceType)
+			{
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: rank = 3; break;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: rank = 2; break;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: rank = 1; break;
+			default: rank = 0; break;
+			}
+			if (rank > bestRank)
+			{
+				bestRank = rank;
+				bestDevice = devices[i];
+				queueFamily = graphicsFamily;
+			}
+		}
+		return bestDevice;
+	}
+}
+#endif
+
+/***********************************************************
+ *  VulkanRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+VulkanRenderer::VulkanRenderer()
+{
+	m_bResourcesDirty = false;
+	m_clearColor = glm::vec4(0.0f);
+	m_pDevice = NULL;
+}
+
+/***********************************************************
+ *  ~VulkanRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+VulkanRenderer::~VulkanRenderer()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for freeing the meshes and textures,
+ *  before the ones of a changed scene are added.  The device
+ *  copies are replaced when the next frame ends.
+ ***********************************************************/
+void VulkanRenderer::Reset()
+{
+	m_meshes.clear();
+	m_textures.clear();
+	m_draws.clear();
+	m_bResourcesDirty = true;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for keeping a copy of the vertex and
+ *  index data of a mesh until it is uploaded.
+ ***********************************************************/
+int VulkanRenderer::AddMesh(const MeshGenerator::MESH_DATA& meshData)
+{
+	VULKAN_MESH mesh;
+	mesh.vertices = meshData.vertices;
+	mesh.indices = meshData.indices;
+	mesh.vertexOffset = 0;
+	mesh.firstIndex = 0;
+	mesh.indexCount = (uint32_t)meshData.indices.size();
+	m_meshes.push_back(std::move(mesh));
+	m_bResourcesDirty = true;
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  AddTextureLevel()
+ *
+ *  This method is used for adding the next level of the mip
+ *  chain of a texture slot, starting from the finest.  The
+ *  pixels are widened to four bytes, the format every device
+ *  samples.
+ ***********************************************************/
+bool VulkanRenderer::AddTextureLevel(int textureSlot, int width, int height, int colorChannels, const unsigned char* pPixels)
+{
+	if ((textureSlot < 0) || (textureSlot >= MAX_TEXTURES) || (width <= 0) || (height <= 0) ||
+		(NULL == pPixels) || ((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return false;
+	}
+
+	if (textureSlot >= (int)m_textures.size())
+	{
+		m_textures.resize(textureSlot + 1);
+	}
+
+	TEXTURE_LEVEL level;
+	level.width = width;
+	level.height = height;
+	level.texels.resize((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		const unsigned char* pTexel = pPixels + i * colorChannels;
+		level.texels[i * 4 + 0] = pTexel[0];
+		level.texels[i * 4 + 1] = pTexel[1];
+		level.texels[i * 4 + 2] = pTexel[2];
+		level.texels[i * 4 + 3] = (colorChannels == 4) ? pTexel[3] : 255;
+	}
+	m_textures[textureSlot].push_back(std::move(level));
+	m_bResourcesDirty = true;
+
+	return true;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for submitting a mesh to draw in the
+ *  frame, with the pipeline and push constants it is drawn
+ *  with.  Nothing is recorded until the frame ends.
+ ***********************************************************/
+void VulkanRenderer::DrawMesh(
+	int mesh,
+	const glm::mat4& modelMatrix,
+	glm::vec4 color,
+	int textureSlot,
+	const MATERIAL& material,
+	bool bBlended)
+{
+	if ((mesh < 0) || (mesh >= (int)m_meshes.size()))
+	{
+		return;
+	}
+
+	bool bTextured = ((textureSlot >= 0) && (textureSlot < (int)m_textures.size()) &&
+		(false == m_textures[textureSlot].empty()));
+
+	DRAW draw;
+	draw.mesh = mesh;
+	draw.pipeline = (bBlended ? PIPELINE_BLENDED : 0) | (bTextured ? PIPELINE_TEXTURED : 0);
+	draw.values.model = modelMatrix;
+	draw.values.color = color;
+	draw.values.ambient = glm::vec4(material.ambientStrength * material.ambientColor, 0.0f);
+	draw.values.diffuse = glm::vec4(material.diffuseColor, bTextured ? (float)textureSlot : -1.0f);
+	draw.values.specular = glm::vec4(material.shininess * material.specularColor, 0.0f);
+	m_draws.push_back(draw);
+
+	m_triangleCount += m_meshes[mesh].indexCount / 3;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the instance, device,
+ *  render pass and pipelines, and a command pool for each
+ *  of the threads.  Nothing is presented to a window, so no
+ *  surface extensions are needed.  Builds without the Vulkan
+ *  SDK report that the renderer is not available.
+ ***********************************************************/
+bool VulkanRenderer::Initialize(WorkerPool* pWorkerPool)
+{
+#ifndef HAVE_VULKAN
+	(void)pWorkerPool;
+	std::cout << "ERROR: Vulkan renderer is not available in this build (needs the Vulkan SDK)" << std::endl;
+	return false;
+#else
+	Shutdown();
+	m_pDevice = new VULKAN_DEVICE();
+	VULKAN_DEVICE& device = *m_pDevice;
+
+	VkApplicationInfo applicationInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+	applicationInfo.pApplicationName = "7-1_FinalProjectMilestones";
+	applicationInfo.apiVersion = VK_API_VERSION_1_2;
+	VkInstanceCreateInfo instanceInfo = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+	instanceInfo.pApplicationInfo = &applicationInfo;
+	if (VK_SUCCESS != vkCreateInstance(&instanceInfo, NULL, &device.instance))
+	{
+		std::cout << "ERROR: Could not create a Vulkan instance" << std::endl;
+		Shutdown();
+		return false;
+	}
+
+	device.physicalDevice = SelectPhysicalDevice(device.instance, device.queueFamily);
+	if (VK_NULL_HANDLE == device.physicalDevice)
+	{
+		std::cout << "ERROR: No Vulkan 1.2 device can index texture arrays" << std::endl;
+		Shutdown();
+		return false;
+	}
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.physicalDevice, &properties);
+	vkGetPhysicalDeviceMemoryProperties(device.physicalDevice, &device.memoryProperties);
+
+	float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+	queueInfo.queueFamilyIndex = device.queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+	VkPhysicalDeviceVulkan12Features features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+	features12.descriptorBindingPartiallyBound = VK_TRUE;
+	VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+	features.pNext = &features12;
+	features.features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+	deviceInfo.pNext = &features;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	if (VK_SUCCESS != vkCreateDevice(device.physicalDevice, &deviceInfo, NULL, &device.device))
+	{
+		std::cout << "ERROR: Could not create a Vulkan device on " << properties.deviceName << std::endl;
+		Shutdown();
+		return false;
+	}
+	vkGetDeviceQueue(device.device, device.queueFamily, 0, &device.queue);
+
+	// the frame is cleared when the pass starts, and left ready to
+	// be copied back when it ends
+	VkAttachmentDescription attachments[2] = {};
+	attachments[0].format = COLOR_FORMAT;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	attachments[1] = attachments[0];
+	attachments[1].format = DEPTH_FORMAT;
+	VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorReference;
+	subpass.pDepthStencilAttachment = &depthReference;
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	VkRenderPassCreateInfo renderPassInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 2;
+	renderPassInfo.pDependencies = dependencies;
+	vkCreateRenderPass(device.device, &renderPassInfo, NULL, &device.renderPass);
+
+	// the frame values, and the texture array where the slots that
+	// hold no texture are left unwritten
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].descriptorCount = MAX_TEXTURES;
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorBindingFlags bindingFlags[2] = { 0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT };
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	setLayoutInfo.pNext = &bindingFlagsInfo;
+	setLayoutInfo.bindingCount = 2;
+	setLayoutInfo.pBindings = bindings;
+	vkCreateDescriptorSetLayout(device.device, &setLayoutInfo, NULL, &device.setLayout);
+
+	VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DRAW_VALUES) };
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &device.setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	vkCreatePipelineLayout(device.device, &pipelineLayoutInfo, NULL, &device.pipelineLayout);
+
+	VkDescriptorPoolSize poolSizes[2] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, (uint32_t)MAX_TEXTURES } };
+	VkDescriptorPoolCreateInfo descriptorPoolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	descriptorPoolInfo.maxSets = 1;
+	descriptorPoolInfo.poolSizeCount = 2;
+	descriptorPoolInfo.pPoolSizes = poolSizes;
+	vkCreateDescriptorPool(device.device, &descriptorPoolInfo, NULL, &device.descriptorPool);
+	VkDescriptorSetAllocateInfo setAllocateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	setAllocateInfo.descriptorPool = device.descriptorPool;
+	setAllocateInfo.descriptorSetCount = 1;
+	setAllocateInfo.pSetLayouts = &device.setLayout;
+	vkAllocateDescriptorSets(device.device, &setAllocateInfo, &device.descriptorSet);
+
+	// the texels are read from the nearest level without filtering,
+	// as the software rasterizer reads them
+	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	vkCreateSampler(device.device, &samplerInfo, NULL, &device.sampler);
+
+	if (false == CreateBuffer(device, sizeof(FRAME_VALUES), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, device.frameValues))
+	{
+		std::cout << "ERROR: Could not create the Vulkan frame values" << std::endl;
+		Shutdown();
+		return false;
+	}
+	VkDescriptorBufferInfo frameBufferInfo = { device.frameValues.buffer, 0, sizeof(FRAME_VALUES) };
+	VkWriteDescriptorSet frameWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	frameWrite.dstSet = device.descriptorSet;
+	frameWrite.dstBinding = 0;
+	frameWrite.descriptorCount = 1;
+	frameWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	frameWrite.pBufferInfo = &frameBufferInfo;
+	vkUpdateDescriptorSets(device.device, 1, &frameWrite, 0, NULL);
+
+	// every pipeline the scene can draw with is built now
+	VkShaderModule vertexShader = CompileShader(device, g_VertexShader, shaderc_glsl_vertex_shader, "scene.vert");
+	VkShaderModule fragmentShader = CompileShader(device, g_FragmentShader, shaderc_glsl_fragment_shader, "scene.frag");
+	if ((VK_NULL_HANDLE == vertexShader) || (VK_NULL_HANDLE == fragmentShader))
+	{
+		vkDestroyShaderModule(device.device, vertexShader, NULL);
+		vkDestroyShaderModule(device.device, fragmentShader, NULL);
+		Shutdown();
+		return false;
+	}
+
+	VkVertexInputBindingDescription vertexBinding = { 0, VERTEX_FLOATS * sizeof(GLfloat), VK_VERTEX_INPUT_RATE_VERTEX };
+	VkVertexInputAttributeDescription vertexAttributes[3] = {
+		{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+		{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, 3 * sizeof(GLfloat) },
+		{ 2, 0, VK_FORMAT_R32G32_SFLOAT, 6 * sizeof(GLfloat) } };
+	VkPipelineVertexInputStateCreateInfo vertexInput = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+	vertexInput.vertexBindingDescriptionCount = 1;
+	vertexInput.pVertexBindingDescriptions = &vertexBinding;
+	vertexInput.vertexAttributeDescriptionCount = 3;
+	vertexInput.pVertexAttributeDescriptions = vertexAttributes;
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPipelineViewportStateCreateInfo viewportState = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+	VkPipelineRasterizationStateCreateInfo rasterization = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_NONE;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+	VkPipelineMultisampleStateCreateInfo multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	bool bPipelinesCreated = true;
+	for (int i = 0; i < PIPELINE_COUNT; i++)
+	{
+		bool bBlended = (0 != (i & PIPELINE_BLENDED));
+		VkBool32 bTextured = (0 != (i & PIPELINE_TEXTURED)) ? VK_TRUE : VK_FALSE;
+
+		VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(VkBool32) };
+		VkSpecializationInfo specialization = { 1, &specializationEntry, sizeof(VkBool32), &bTextured };
+		VkPipelineShaderStageCreateInfo stages[2] = {
+			{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO },
+			{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO } };
+		stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		stages[0].module = vertexShader;
+		stages[0].pName = "main";
+		stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		stages[1].module = fragmentShader;
+		stages[1].pName = "main";
+		stages[1].pSpecializationInfo = &specialization;
+
+		// blended surfaces are drawn over the frame without writing
+		// depth, with the blend factors of the OpenGL path
+		VkPipelineDepthStencilStateCreateInfo depthStencil = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+		depthStencil.depthTestEnable = VK_TRUE;
+		depthStencil.depthWriteEnable = bBlended ? VK_FALSE : VK_TRUE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+		VkPipelineColorBlendAttachmentState blendAttachment = {};
+		blendAttachment.blendEnable = bBlended ? VK_TRUE : VK_FALSE;
+		blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+			VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		VkPipelineColorBlendStateCreateInfo colorBlend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+		colorBlend.attachmentCount = 1;
+		colorBlend.pAttachments = &blendAttachment;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = stages;
+		pipelineInfo.pVertexInputState = &vertexInput;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterization;
+		pipelineInfo.pMultisampleState = &multisample;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlend;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = device.pipelineLayout;
+		pipelineInfo.renderPass = device.renderPass;
+		pipelineInfo.subpass = 0;
+		if (VK_SUCCESS != vkCreateGraphicsPipelines(device.device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &device.pipelines[i]))
+		{
+			bPipelinesCreated = false;
+		}
+	}
+	vkDestroyShaderModule(device.device, vertexShader, NULL);
+	vkDestroyShaderModule(device.device, fragmentShader, NULL);
+	if (false == bPipelinesCreated)
+	{
+		std::cout << "ERROR: Could not create the Vulkan pipelines" << std::endl;
+		Shutdown();
+		return false;
+	}
+
+	VkCommandPoolCreateInfo commandPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	commandPoolInfo.queueFamilyIndex = device.queueFamily;
+	vkCreateCommandPool(device.device, &commandPoolInfo, NULL, &device.commandPool);
+	VkCommandBufferAllocateInfo commandBufferInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	commandBufferInfo.commandPool = device.commandPool;
+	commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferInfo.commandBufferCount = 1;
+	vkAllocateCommandBuffers(device.device, &commandBufferInfo, &device.commandBuffer);
+	VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	vkCreateFence(device.device, &fenceInfo, NULL, &device.fence);
+
+	// command pools are only used by one thread at a time, so every
+	// thread records from a pool of its own
+	SetWorkerPool(pWorkerPool);
+	device.workerPools.assign(GetThreadCount(), VK_NULL_HANDLE);
+	device.workerBuffers.assign(GetThreadCount(), VK_NULL_HANDLE);
+	device.workerRecorded.assign(GetThreadCount(), 0);
+	for (int i = 0; i < GetThreadCount(); i++)
+	{
+		vkCreateCommandPool(device.device, &commandPoolInfo, NULL, &device.workerPools[i]);
+		commandBufferInfo.commandPool = device.workerPools[i];
+		commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		vkAllocateCommandBuffers(device.device, &commandBufferInfo, &device.workerBuffers[i]);
+	}
+
+	std::cout << "INFO: Vulkan renderer on " << properties.deviceName << " recording on "
+		<< GetThreadCount() << " threads" << std::endl;
+	m_bResourcesDirty = true;
+	return true;
+#endif
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for waiting for the device and then
+ *  freeing all of its objects.  It is safe to call on a
+ *  device that was only partly created.
+ ***********************************************************/
+void VulkanRenderer::Shutdown()
+{
+#ifdef HAVE_VULKAN
+	if (NULL == m_pDevice)
+	{
+		return;
+	}
+
+	VULKAN_DEVICE& device = *m_pDevice;
+	if (VK_NULL_HANDLE != device.device)
+	{
+		vkDeviceWaitIdle(device.device);
+
+		for (size_t i = 0; i < device.workerPools.size(); i++)
+		{
+			vkDestroyCommandPool(device.device, device.workerPools[i], NULL);
+		}
+		vkDestroyCommandPool(device.device, device.commandPool, NULL);
+		vkDestroyFence(device.device, device.fence, NULL);
+
+		vkDestroyFramebuffer(device.device, device.framebuffer, NULL);
+		DestroyImage(device, device.colorImage);
+		DestroyImage(device, device.depthImage);
+		DestroyBuffer(device, device.readbackBuffer);
+		for (int i = 0; i < MAX_TEXTURES; i++)
+		{
+			DestroyImage(device, device.textures[i]);
+		}
+		DestroyBuffer(device, device.vertexBuffer);
+		DestroyBuffer(device, device.indexBuffer);
+		DestroyBuffer(device, device.frameValues);
+
+		vkDestroySampler(device.device, device.sampler, NULL);
+		vkDestroyDescriptorPool(device.device, device.descriptorPool, NULL);
+		for (int i = 0; i < PIPELINE_COUNT; i++)
+		{
+			vkDestroyPipeline(device.device, device.pipelines[i], NULL);
+		}
+		vkDestroyPipelineLayout(device.device, device.pipelineLayout, NULL);
+		vkDestroyDescriptorSetLayout(device.device, device.setLayout, NULL);
+		vkDestroyRenderPass(device.device, device.renderPass, NULL);
+		vkDestroyDevice(device.device, NULL);
+	}
+	if (VK_NULL_HANDLE != device.instance)
+	{
+		vkDestroyInstance(device.instance, NULL);
+	}
+
+	delete m_pDevice;
+	m_pDevice = NULL;
+#endif
+}
+
+/***********************************************************
+ *  UploadResources()
+ *
+ *  This method is used for copying the meshes into one
+ *  vertex and one index buffer, and the texture levels into
+ *  images that are written into the texture array.  The
+ *  system memory copies are freed once they are uploaded.
+ ***********************************************************/
+bool VulkanRenderer::UploadResources()
+{
+#ifndef HAVE_VULKAN
+	return false;
+#else
+	VULKAN_DEVICE& device = *m_pDevice;
+	vkDeviceWaitIdle(device.device);
+
+	DestroyBuffer(device, device.vertexBuffer);
+	DestroyBuffer(device, device.indexBuffer);
+	size_t vertexFloats = 0;
+	size_t indexCount = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		m_meshes[i].vertexOffset = (int)(vertexFloats / VERTEX_FLOATS);
+		m_meshes[i].firstIndex = (uint32_t)indexCount;
+		vertexFloats += m_meshes[i].vertices.size();
+		indexCount += m_meshes[i].indices.size();
+	}
+	if ((false == CreateBuffer(device, vertexFloats * sizeof(GLfloat), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, device.vertexBuffer)) ||
+		(false == CreateBuffer(device, indexCount * sizeof(GLuint), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, device.indexBuffer)))
+	{
+		std::cout << "ERROR: Could not create the Vulkan mesh buffers" << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		VULKAN_MESH& mesh = m_meshes[i];
+		memcpy((GLfloat*)device.vertexBuffer.pMapped + (size_t)mesh.vertexOffset * VERTEX_FLOATS,
+			mesh.vertices.data(), mesh.vertices.size() * sizeof(GLfloat));
+		memcpy((GLuint*)device.indexBuffer.pMapped + mesh.firstIndex,
+			mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+		std::vector<GLfloat>().swap(mesh.vertices);
+		std::vector<GLuint>().swap(mesh.indices);
+	}
+
+	for (int slot = 0; slot < MAX_TEXTURES; slot++)
+	{
+		DestroyImage(device, device.textures[slot]);
+		if ((slot >= (int)m_textures.size()) || m_textures[slot].empty())
+		{
+			continue;
+		}
+
+		// only the levels that halve the one before form a chain
+		// that one image can hold
+		std::vector<TEXTURE_LEVEL>& levels = m_textures[slot];
+		uint32_t levelCount = 1;
+		VkDeviceSize stagingSize = levels[0].texels.size();
+		while ((levelCount < levels.size()) &&
+			(levels[levelCount].width == std::max(1, levels[levelCount - 1].width / 2)) &&
+			(levels[levelCount].height == std::max(1, levels[levelCount - 1].height / 2)))
+		{
+			stagingSize += levels[levelCount].texels.size();
+			levelCount++;
+		}
+
+		VULKAN_BUFFER staging = VULKAN_BUFFER();
+		if ((false == CreateImage(device, COLOR_FORMAT, levels[0].width, levels[0].height, levelCount,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT, device.textures[slot])) ||
+			(false == CreateBuffer(device, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, staging)))
+		{
+			std::cout << "ERROR: Could not create the Vulkan texture for slot " << slot << std::endl;
+			DestroyImage(device, device.textures[slot]);
+			DestroyBuffer(device, staging);
+			continue;
+		}
+
+		std::vector<VkBufferImageCopy> copies(levelCount);
+		VkDeviceSize offset = 0;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			memcpy((unsigned char*)staging.pMapped + offset, levels[level].texels.data(), levels[level].texels.size());
+			copies[level] = VkBufferImageCopy();
+			copies[level].bufferOffset = offset;
+			copies[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			copies[level].imageExtent = { (uint32_t)levels[level].width, (uint32_t)levels[level].height, 1 };
+			offset += levels[level].texels.size();
+		}
+
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkResetCommandPool(device.device, device.commandPool, 0);
+		vkBeginCommandBuffer(device.commandBuffer, &beginInfo);
+		VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = device.textures[slot].image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(device.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, NULL, 0, NULL, 1, &barrier);
+		vkCmdCopyBufferToImage(device.commandBuffer, staging.buffer, device.textures[slot].image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount, copies.data());
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(device.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 0, NULL, 0, NULL, 1, &barrier);
+		vkEndCommandBuffer(device.commandBuffer);
+
+		VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &device.commandBuffer;
+		vkQueueSubmit(device.queue, 1, &submitInfo, VK_NULL_HANDLE);
+		vkQueueWaitIdle(device.queue);
+		DestroyBuffer(device, staging);
+
+		VkDescriptorImageInfo imageInfo = { device.sampler, device.textures[slot].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkWriteDescriptorSet textureWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		textureWrite.dstSet = device.descriptorSet;
+		textureWrite.dstBinding = 1;
+		textureWrite.dstArrayElement = (uint32_t)slot;
+		textureWrite.descriptorCount = 1;
+		textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		textureWrite.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(device.device, 1, &textureWrite, 0, NULL);
+
+		// the draws only need to know that the slot has a texture
+		levels.resize(1);
+		std::vector<unsigned char>().swap(levels[0].texels);
+	}
+
+	return true;
+#endif
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  The images of
+ *  the frame and the buffer it is read back into are only
+ *  created again when the size changes.
+ ***********************************************************/
+void VulkanRenderer::BeginFrame(
+	int width,
+	int height,
+	glm::vec4 clearColor,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec3 viewPosition)
+{
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_stride = m_width;
+	m_clearColor = clearColor;
+	m_draws.clear();
+	m_triangleCount = 0;
+	if ((NULL == m_pDevice) || (m_width <= 0) || (m_height <= 0))
+	{
+		return;
+	}
+
+#ifdef HAVE_VULKAN
+	VULKAN_DEVICE& device = *m_pDevice;
+	if ((device.frameWidth != m_width) || (device.frameHeight != m_height))
+	{
+		vkDeviceWaitIdle(device.device);
+		vkDestroyFramebuffer(device.device, device.framebuffer, NULL);
+		device.framebuffer = VK_NULL_HANDLE;
+		DestroyImage(device, device.colorImage);
+		DestroyImage(device, device.depthImage);
+		DestroyBuffer(device, device.readbackBuffer);
+		device.frameWidth = 0;
+		device.frameHeight = 0;
+
+		size_t pixelCount = (size_t)m_width * m_height;
+		if ((false == CreateImage(device, COLOR_FORMAT, m_width, m_height, 1,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT, device.colorImage)) ||
+			(false == CreateImage(device, DEPTH_FORMAT, m_width, m_height, 1,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, device.depthImage)) ||
+			(false == CreateBuffer(device, pixelCount * (sizeof(uint32_t) + sizeof(float)), VK_BUFFER_USAGE_TRANSFER_DST_BIT, device.readbackBuffer)))
+		{
+			std::cout << "ERROR: Could not create a Vulkan frame of " << m_width << "x" << m_height << std::endl;
+			return;
+		}
+
+		VkImageView views[2] = { device.colorImage.view, device.depthImage.view };
+		VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+		framebufferInfo.renderPass = device.renderPass;
+		framebufferInfo.attachmentCount = 2;
+		framebufferInfo.pAttachments = views;
+		framebufferInfo.width = (uint32_t)m_width;
+		framebufferInfo.height = (uint32_t)m_height;
+		framebufferInfo.layers = 1;
+		if (VK_SUCCESS != vkCreateFramebuffer(device.device, &framebufferInfo, NULL, &device.framebuffer))
+		{
+			return;
+		}
+		device.frameWidth = m_width;
+		device.frameHeight = m_height;
+	}
+
+	// the frame before has finished, so the values can be written
+	FRAME_VALUES* pFrame = (FRAME_VALUES*)device.frameValues.pMapped;
+	pFrame->viewProjection = projection * view;
+	pFrame->viewPosition = glm::vec4(viewPosition, 1.0f);
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		const LIGHT& light = m_lights[i];
+		pFrame->lightPosition[i] = glm::vec4(light.position, 1.0f);
+		pFrame->lightAmbient[i] = glm::vec4(light.ambientColor, 0.0f);
+		pFrame->lightDiffuse[i] = glm::vec4(light.diffuseColor, 0.0f);
+		pFrame->lightSpecular[i] = glm::vec4(light.specularColor * light.specularIntensity, light.focalStrength);
+	}
+#else
+	(void)view;
+	(void)projection;
+	(void)viewPosition;
+#endif
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for drawing the submitted meshes.
+ *  The threads record their ranges of the draws, then the
+ *  calling thread runs them in one render pass, copies the
+ *  frame back and waits for it.
+ ***********************************************************/
+void VulkanRenderer::EndFrame()
+{
+#ifdef HAVE_VULKAN
+	if ((NULL == m_pDevice) || (m_width <= 0) || (m_height <= 0) ||
+		(m_pDevice->frameWidth != m_width) || (m_pDevice->frameHeight != m_height))
+	{
+		return;
+	}
+
+	VULKAN_DEVICE& device = *m_pDevice;
+	if (m_bResourcesDirty)
+	{
+		if (false == UploadResources())
+		{
+			return;
+		}
+		m_bResourcesDirty = false;
+	}
+
+	RunJob(JOB_RECORD);
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkResetCommandPool(device.device, device.commandPool, 0);
+	vkBeginCommandBuffer(device.commandBuffer, &beginInfo);
+
+	VkClearValue clearValues[2];
+	clearValues[0].color = { { m_clearColor.r, m_clearColor.g, m_clearColor.b, m_clearColor.a } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+	VkRenderPassBeginInfo renderPassInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+	renderPassInfo.renderPass = device.renderPass;
+	renderPassInfo.framebuffer = device.framebuffer;
+	renderPassInfo.renderArea.extent = { (uint32_t)m_width, (uint32_t)m_height };
+	renderPassInfo.clearValueCount = 2;
+	renderPassInfo.pClearValues = clearValues;
+	vkCmdBeginRenderPass(device.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	for (int i = 0; i < GetThreadCount(); i++)
+	{
+		if (0 != device.workerRecorded[i])
+		{
+			vkCmdExecuteCommands(device.commandBuffer, 1, &device.workerBuffers[i]);
+		}
+	}
+	vkCmdEndRenderPass(device.commandBuffer);
+
+	// the color is followed by the depth in the readback buffer
+	VkBufferImageCopy copy = {};
+	copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copy.imageExtent = { (uint32_t)m_width, (uint32_t)m_height, 1 };
+	vkCmdCopyImageToBuffer(device.commandBuffer, device.colorImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		device.readbackBuffer.buffer, 1, &copy);
+	copy.bufferOffset = (VkDeviceSize)m_width * m_height * sizeof(uint32_t);
+	copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	vkCmdCopyImageToBuffer(device.commandBuffer, device.depthImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		device.readbackBuffer.buffer, 1, &copy);
+	VkMemoryBarrier hostBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(device.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &hostBarrier, 0, NULL, 0, NULL);
+	vkEndCommandBuffer(device.commandBuffer);
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &device.commandBuffer;
+	vkQueueSubmit(device.queue, 1, &submitInfo, device.fence);
+	vkWaitForFences(device.device, 1, &device.fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(device.device, 1, &device.fence);
+
+	size_t pixelCount = (size_t)m_width * m_height;
+	if (m_colorBuffer.size() < pixelCount)
+	{
+		m_colorBuffer.resize(pixelCount);
+		m_depthBuffer.resize(pixelCount);
+	}
+	const unsigned char* pReadback = (const unsigned char*)device.readbackBuffer.pMapped;
+	memcpy(m_colorBuffer.data(), pReadback, pixelCount * sizeof(uint32_t));
+	memcpy(m_depthBuffer.data(), pReadback + pixelCount * sizeof(uint32_t), pixelCount * sizeof(float));
+#endif
+}
+
+/***********************************************************
+ *  ExecuteJob()
+ *
+ *  This method is used for recording one thread's range of
+ *  the draws into its secondary command buffer.  The ranges
+ *  are contiguous and run in thread order, so the draws are
+ *  made in the order they were submitted.  The pipeline is
+ *  only bound again when it changes within the range.
+ ***********************************************************/
+void VulkanRenderer::ExecuteJob(int job, int workerIndex)
+{
+#ifdef HAVE_VULKAN
+	if ((job != JOB_RECORD) || (NULL == m_pDevice))
+	{
+		return;
+	}
+
+	VULKAN_DEVICE& device = *m_pDevice;
+	size_t workerCount = (size_t)GetThreadCount();
+	size_t firstDraw = m_draws.size() * workerIndex / workerCount;
+	size_t lastDraw = m_draws.size() * (workerIndex + 1) / workerCount;
+	device.workerRecorded[workerIndex] = (firstDraw < lastDraw) ? 1 : 0;
+	if (firstDraw >= lastDraw)
+	{
+		return;
+	}
+
+	VkCommandBuffer commandBuffer = device.workerBuffers[workerIndex];
+	vkResetCommandPool(device.device, device.workerPools[workerIndex], 0);
+	VkCommandBufferInheritanceInfo inheritanceInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+	inheritanceInfo.renderPass = device.renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = device.framebuffer;
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	VkViewport viewport = { 0.0f, 0.0f, (float)m_width, (float)m_height, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, { (uint32_t)m_width, (uint32_t)m_height } };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelineLayout,
+		0, 1, &device.descriptorSet, 0, NULL);
+	VkDeviceSize vertexOffset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &device.vertexBuffer.buffer, &vertexOffset);
+	vkCmdBindIndexBuffer(commandBuffer, device.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+	int boundPipeline = -1;
+	for (size_t i = firstDraw; i < lastDraw; i++)
+	{
+		const DRAW& draw = m_draws[i];
+		const VULKAN_MESH& mesh = m_meshes[draw.mesh];
+		if (draw.pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelines[draw.pipeline]);
+			boundPipeline = draw.pipeline;
+		}
+		vkCmdPushConstants(commandBuffer, device.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0, sizeof(DRAW_VALUES), &draw.values);
+		vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, 0);
+	}
+
+	vkEndCommandBuffer(commandBuffer);
+#else
+	(void)job;
+	(void)workerIndex;
+#endif
+}
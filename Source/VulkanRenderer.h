@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// vulkanrenderer.h
+// ============
+// draw the scene with Vulkan into an offscreen frame, recording the
+// draws on several threads at once
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderBackend.h"
+
+// the Vulkan objects of the renderer, which are only known where the
+// Vulkan headers are included
+struct VULKAN_DEVICE;
+
+/***********************************************************
+ *  VulkanRenderer
+ *
+ *  This class draws the scene with Vulkan on any device
+ *  that supports version 1.2, including CPU devices such as
+ *  lavapipe, so it runs without a display.  The pipelines
+ *  for the textured and plain surfaces, opaque and blended,
+ *  are all built when the renderer starts, so no pipeline
+ *  is created while drawing.  The textures of the scene are
+ *  bound once in an array, which the fragment shader indexes
+ *  with the texture slot of the draw.  Each frame splits
+ *  the submitted draws into contiguous ranges, and every
+ *  thread records its range into a secondary command buffer
+ *  from its own command pool, which the calling thread then
+ *  runs in order inside one render pass, so blended draws
+ *  keep their order.  The frame is copied back into system
+ *  memory when it is done.  Without the Vulkan SDK at build
+ *  time, the renderer reports that it cannot start.
+ ***********************************************************/
+class VulkanRenderer : public RenderBackend
+{
+public:
+	// most texture slots that the fragment shader can index
+	static const int MAX_TEXTURES = 16;
+
+	// constructor
+	VulkanRenderer();
+	// destructor
+	~VulkanRenderer();
+
+	const char* GetName() const override { return "Vulkan renderer"; }
+	// create the device, the pipelines and the recording threads
+	bool Initialize(WorkerPool* pWorkerPool) override;
+
+	void Reset() override;
+	int AddMesh(const MeshGenerator::MESH_DATA& meshData) override;
+	bool AddTextureLevel(int textureSlot, int width, int height, int colorChannels, const unsigned char* pPixels) override;
+
+	void BeginFrame(
+		int width,
+		int height,
+		glm::vec4 clearColor,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec3 viewPosition) override;
+	void DrawMesh(
+		int mesh,
+		const glm::mat4& modelMatrix,
+		glm::vec4 color,
+		int textureSlot,
+		const MATERIAL& material,
+		bool bBlended) override;
+	void EndFrame() override;
+
+protected:
+	// record a thread's range of the draws
+	void ExecuteJob(int job, int workerIndex) override;
+
+private:
+	// a mesh until it is uploaded, and its place in the shared
+	// vertex and index buffers
+	struct VULKAN_MESH
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLuint> indices;
+		int vertexOffset;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	// the levels of a texture until it is uploaded, with four
+	// bytes for each texel
+	struct TEXTURE_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> texels;
+	};
+
+	// the push constants of a draw, in the layout of the shaders -
+	// the ambient and specular colors hold the strength and the
+	// shininess of the material, and the w of the diffuse color
+	// is the texture slot
+	struct DRAW_VALUES
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec4 specular;
+	};
+
+	// a submitted mesh with its push constants and pipeline
+	struct DRAW
+	{
+		int mesh;
+		int pipeline;
+		DRAW_VALUES values;
+	};
+
+	// the steps that the threads run together
+	enum JOB
+	{
+		JOB_RECORD = 1
+	};
+
+	std::vector<VULKAN_MESH> m_meshes;
+	std::vector<std::vector<TEXTURE_LEVEL>> m_textures;
+	// whether meshes or textures were added since the last upload
+	bool m_bResourcesDirty;
+
+	// the frame being drawn
+	glm::vec4 m_clearColor;
+	std::vector<DRAW> m_draws;
+
+	VULKAN_DEVICE* m_pDevice;
+
+	// upload the meshes and textures added since the last frame
+	bool UploadResources();
+	// free the objects of the device
+	void Shutdown();
+};
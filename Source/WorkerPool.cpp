@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+// workerpool.cpp
+// ============
+// run numbered jobs on a set of threads that wait between them, with the
+// calling thread doing its own share of each job
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  WorkerPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WorkerPool::WorkerPool()
+{
+	m_pJobs = NULL;
+	m_threadCount = 1;
+	m_job = 0;
+	m_jobGeneration = 0;
+	m_busyThreads = 0;
+	m_bShutdown = false;
+}
+
+/***********************************************************
+ *  ~WorkerPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+WorkerPool::~WorkerPool()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the threads that run
+ *  the jobs.  The calling thread does its share of each job,
+ *  so one fewer thread is started than are used.
+ ***********************************************************/
+void WorkerPool::Start(int threadCount)
+{
+	Stop();
+
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	m_threadCount = threadCount;
+	m_bShutdown = false;
+	for (int i = 1; i < threadCount; i++)
+	{
+		m_threads.emplace_back(&WorkerPool::WorkerMain, this, i, m_jobGeneration);
+	}
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the worker threads and
+ *  waiting for them to exit.
+ ***********************************************************/
+void WorkerPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_bShutdown = true;
+	}
+	m_jobStarted.notify_all();
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+	m_threadCount = 1;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running a job on every thread,
+ *  including the calling thread, and waiting until all of
+ *  them have finished it.  The jobs are only held while
+ *  they run.
+ ***********************************************************/
+void WorkerPool::Run(Jobs* pJobs, int job)
+{
+	if (NULL == pJobs)
+	{
+		return;
+	}
+	if (m_threads.empty())
+	{
+		pJobs->ExecuteJob(job, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_pJobs = pJobs;
+		m_job = job;
+		m_jobGeneration++;
+		m_busyThreads = (int)m_threads.size();
+	}
+	m_jobStarted.notify_all();
+
+	pJobs->ExecuteJob(job, 0);
+
+	std::unique_lock<std::mutex> lock(m_jobMutex);
+	m_jobFinished.wait(lock, [this] { return (m_busyThreads == 0); });
+	m_pJobs = NULL;
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method runs on each worker thread, waiting for the
+ *  next job and running its share of it, until the threads
+ *  are stopped.  The generation the thread was started at
+ *  is passed in, so a job started before the thread first
+ *  waits is not missed.
+ ***********************************************************/
+void WorkerPool::WorkerMain(int workerIndex, unsigned int startGeneration)
+{
+	unsigned int lastGeneration = startGeneration;
+
+	for (;;)
+	{
+		Jobs* pJobs = NULL;
+		int job = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobStarted.wait(lock, [this, lastGeneration] { return m_bShutdown || (m_jobGeneration != lastGeneration); });
+			if (m_bShutdown)
+			{
+				return;
+			}
+			lastGeneration = m_jobGeneration;
+			pJobs = m_pJobs;
+			job = m_job;
+		}
+
+		pJobs->ExecuteJob(job, workerIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_busyThreads--;
+		}
+		m_jobFinished.notify_one();
+	}
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// workerpool.h
+// ============
+// run numbered jobs on a set of threads that wait between them, with the
+// calling thread doing its own share of each job
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  WorkerPool
+ *
+ *  This class keeps a set of worker threads waiting for
+ *  jobs.  Running a job wakes every thread, each of which
+ *  runs its part of the job by its worker index, while the
+ *  calling thread runs the part of worker 0, and returns
+ *  once all of the parts are done.  The threads are kept
+ *  between jobs, so a job costs a wake up rather than
+ *  starting threads.  The jobs are handed over with each
+ *  run, so one pool serves every system that splits its
+ *  work over threads, one job at a time, rather than each
+ *  keeping threads of its own that compete for the cores.
+ ***********************************************************/
+class WorkerPool
+{
+public:
+	// the jobs that a pool runs, where each thread runs its part
+	// of a job
+	class Jobs
+	{
+	public:
+		virtual ~Jobs() {}
+		// run a thread's part of a job
+		virtual void ExecuteJob(int job, int workerIndex) = 0;
+	};
+
+	// constructor
+	WorkerPool();
+	// destructor
+	~WorkerPool();
+
+	// start the threads that run the jobs, with one for each
+	// hardware thread for a count of 0 or less, where the calling
+	// thread is the first
+	void Start(int threadCount);
+	// stop the worker threads and wait for them to exit
+	void Stop();
+	// get the number of threads, including the calling thread
+	int GetThreadCount() const { return m_threadCount; }
+
+	// run a job on every thread and wait for it to finish - the
+	// calling thread runs it alone when no threads were started
+	void Run(Jobs* pJobs, int job);
+
+private:
+	Jobs* m_pJobs;
+	int m_threadCount;
+	std::vector<std::thread> m_threads;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobStarted;
+	std::condition_variable m_jobFinished;
+	int m_job;
+	unsigned int m_jobGeneration;
+	int m_busyThreads;
+	bool m_bShutdown;
+
+	// wait for the jobs after a generation and run them on a
+	// worker thread
+	void WorkerMain(int workerIndex, unsigned int startGeneration);
+};